@@ -143,11 +143,192 @@ from the FreeRTOSIPConfig.h configuration header file. */
 		#define	ipconfigTCP_WIN_SEG_COUNT		( 256 )
 	#endif
 
+	/* The number of segment descriptors that a TCP window may hold before it
+	must borrow from the shared overflow pool.  Zero means that all sockets
+	share the complete pool without limits.  It can be changed per socket
+	with the FREERTOS_SO_TCP_SEG_QUOTA option.  A socket can always reach its
+	quota when the sum of all quota's plus ipconfigTCP_WIN_SEG_OVERFLOW does
+	not exceed ipconfigTCP_WIN_SEG_COUNT. */
+	#ifndef ipconfigTCP_WIN_SEG_QUOTA
+		#define ipconfigTCP_WIN_SEG_QUOTA		( 0 )
+	#endif
+
+	/* The number of segment descriptors that may be held beyond their quota,
+	by all sockets together. */
+	#ifndef ipconfigTCP_WIN_SEG_OVERFLOW
+		#define ipconfigTCP_WIN_SEG_OVERFLOW	( ipconfigTCP_WIN_SEG_COUNT / 4 )
+	#endif
+
+	/* When non-zero, the segment descriptors are not allocated all at once,
+	but in chunks of ipconfigTCP_WIN_SEG_CHUNK, as soon as they're needed. */
+	#ifndef ipconfigTCP_WIN_SEG_CHUNK
+		#define ipconfigTCP_WIN_SEG_CHUNK		( 0 )
+	#endif
+
+	/* When non-zero, a TCP socket can be put in zero-copy reception mode with
+	the FREERTOS_SO_TCP_ZERO_COPY_RX option.  Data that arrives in-order will
+	then be kept in its network buffer, in stead of being copied to the
+	socket's rxStream.  Only the protocol headers are copied to a new (small)
+	network buffer, which is used to send the reply.  The cases in which data
+	is still copied are listed with FREERTOS_SO_TCP_ZERO_COPY_RX. */
+	#ifndef ipconfigUSE_TCP_ZERO_COPY_RX
+		#define ipconfigUSE_TCP_ZERO_COPY_RX	( 0 )
+	#endif
+
+	/* The maximum number of network buffers that a socket may hold in
+	zero-copy reception mode.  When reached, data will be copied to rxStream
+	as usual. */
+	#ifndef ipconfigTCP_ZERO_COPY_RX_MAX_BUFFERS
+		#define ipconfigTCP_ZERO_COPY_RX_MAX_BUFFERS	( 8 )
+	#endif
+
+	/* When non-zero, FreeRTOS_send() accepts the FREERTOS_ZERO_COPY flag for
+	TCP sockets: the data will not be copied to txStream, only a reference to
+	it is stored.  The data is copied directly from the application's memory
+	(RAM or flash) into the outgoing packets.  The memory must stay valid until
+	FreeRTOS_tx_referenced() returns zero. */
+	#ifndef ipconfigUSE_TCP_ZERO_COPY_TX
+		#define ipconfigUSE_TCP_ZERO_COPY_TX	( 0 )
+	#endif
+
+	/* The maximum number of references that a TCP socket can hold at any
+	moment, at most 255.  Every call to FreeRTOS_send() with the
+	FREERTOS_ZERO_COPY flag needs one or more references. */
+	#ifndef ipconfigTCP_ZERO_COPY_TX_REFERENCES
+		#define ipconfigTCP_ZERO_COPY_TX_REFERENCES	( 4 )
+	#endif
+
 	#ifndef ipconfigIGNORE_UNKNOWN_PACKETS
 		/* When non-zero, TCP will not send RST packets in reply to
 		TCP packets which are unknown, or out-of-order. */
 		#define ipconfigIGNORE_UNKNOWN_PACKETS	( 0 )
 	#endif
+
+	/* When non-zero, the sliding window will limit the amount of outstanding
+	data with a congestion window (slow start, NewReno or CUBIC), in stead of
+	only looking at the peer's reception window. */
+	#ifndef ipconfigUSE_TCP_CONGESTION_CONTROL
+		#define ipconfigUSE_TCP_CONGESTION_CONTROL	( 0 )
+	#endif
+
+	/* The algorithm used by sockets that did not select one with the
+	FREERTOS_SO_TCP_CONGESTION option: 1 = NewReno, 2 = CUBIC. */
+	#ifndef ipconfigTCP_CONGESTION_CONTROL_DEFAULT
+		#define ipconfigTCP_CONGESTION_CONTROL_DEFAULT	( 1 )
+	#endif
+
+	/* When non-zero, new sockets will spread the transmission of new segments
+	over the RTT.  It can be changed per socket with FREERTOS_SO_TCP_PACING. */
+	#ifndef ipconfigTCP_PACING_DEFAULT
+		#define ipconfigTCP_PACING_DEFAULT			( 0 )
+	#endif
+
+	#if( ( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) && ( ipconfigUSE_TCP_WIN == 0 ) )
+		#error ipconfigUSE_TCP_CONGESTION_CONTROL requires ipconfigUSE_TCP_WIN
+	#endif
+
+	/* When non-zero, the TCP time-stamp option (RFC 7323) will be offered in
+	the SYN phase.  If the peer agrees, every segment carries a time-stamp and
+	the echoed values are used to measure the RTT.  Without time-stamps, the
+	RTT is measured on segments that were not retransmitted. */
+	#ifndef ipconfigUSE_TCP_TIMESTAMPS
+		#define ipconfigUSE_TCP_TIMESTAMPS		( 0 )
+	#endif
+
+	/* The lower and upper limits of the retransmission time-out in ms, which
+	is calculated as described in RFC 6298.  RFC 6298 recommends a minimum of
+	1 second, which is very long for a LAN, most stacks use 200 ms. */
+	#ifndef ipconfigTCP_RTO_MIN_MS
+		#define ipconfigTCP_RTO_MIN_MS			( 200 )
+	#endif
+
+	#ifndef ipconfigTCP_RTO_MAX_MS
+		#define ipconfigTCP_RTO_MAX_MS			( 60000 )
+	#endif
+
+	#if( ( ipconfigUSE_TCP_TIMESTAMPS != 0 ) && ( ipconfigUSE_TCP_WIN == 0 ) )
+		#error ipconfigUSE_TCP_TIMESTAMPS requires ipconfigUSE_TCP_WIN
+	#endif
+
+	/* When non-zero, the data segments that the sliding window releases are
+	sent in a single pass, sharing one header template, in stead of building
+	every segment through the generic send path.  See also
+	ipconfigDRIVER_SUPPORTS_TSO. */
+	#ifndef ipconfigTCP_TSO
+		#define ipconfigTCP_TSO					( 0 )
+	#endif
+
+	/* The maximum number of segments sent in one pass, which is also the
+	maximum number of segments in a packet passed to
+	xNetworkInterfaceOutputTSO(). */
+	#ifndef ipconfigTCP_TSO_MAX_SEGMENTS
+		#define ipconfigTCP_TSO_MAX_SEGMENTS	( 16 )
+	#endif
+
+	/* When non-zero, the IP-task looks ahead in a chain of received packets
+	(see ipconfigUSE_LINKED_RX_MESSAGES).  When a data segment is directly
+	followed by the next segment of the same connection, the ACK and window
+	update are left to that next segment, so that a burst gets acknowledged
+	once.  A socket with an OnReceive handler gets the data of the whole
+	burst in one call.  Other sockets are woken up once per burst already,
+	just before the IP-task goes to sleep. */
+	#ifndef ipconfigUSE_TCP_GRO
+		#define ipconfigUSE_TCP_GRO				( 0 )
+	#endif
+
+	#if( ( ipconfigUSE_TCP_GRO != 0 ) && ( ipconfigUSE_TCP_WIN == 0 ) )
+		#error ipconfigUSE_TCP_GRO requires ipconfigUSE_TCP_WIN
+	#endif
+
+	/* When larger than zero, a listening socket answers a SYN from a table
+	with this number of entries, in stead of creating a new socket for every
+	SYN.  The socket is only created when the ACK of the peer completes the
+	handshake.  This protects the heap and the network buffers against a
+	storm of connection requests. */
+	#ifndef ipconfigTCP_SYN_CACHE_SIZE
+		#define ipconfigTCP_SYN_CACHE_SIZE		( 0 )
+	#endif
+
+	/* The time after which an entry in the SYN cache may be re-used when the
+	handshake was not completed. */
+	#ifndef ipconfigTCP_SYN_CACHE_TIMEOUT_MS
+		#define ipconfigTCP_SYN_CACHE_TIMEOUT_MS	( 20000 )
+	#endif
+
+	/* When non-zero, a SYN that arrives while the SYN cache is full will be
+	answered with a SYN cookie: the initial sequence number encodes the
+	connection, so that no state has to be stored.  Such a connection can not
+	use window scaling or time-stamps.  When zero, the oldest entry in the SYN
+	cache will be replaced. */
+	#ifndef ipconfigTCP_SYN_COOKIES
+		#define ipconfigTCP_SYN_COOKIES			( 0 )
+	#endif
+
+	#if( ( ipconfigTCP_SYN_COOKIES != 0 ) && ( ipconfigTCP_SYN_CACHE_SIZE == 0 ) )
+		#error ipconfigTCP_SYN_COOKIES requires ipconfigTCP_SYN_CACHE_SIZE
+	#endif
+
+	/* When non-zero, client sockets may use TCP Fast Open (RFC 7413), see
+	FREERTOS_SO_TCP_FASTOPEN.  The first connection to a server asks for a
+	cookie, later connections to the same server send the cookie along with
+	the first data in the SYN packet. */
+	#ifndef ipconfigUSE_TCP_FAST_OPEN
+		#define ipconfigUSE_TCP_FAST_OPEN		( 0 )
+	#endif
+
+	/* The number of servers for which a Fast Open cookie is remembered.  When
+	the cache is full, the least recently used entry is replaced. */
+	#ifndef ipconfigTCP_FAST_OPEN_CACHE_ENTRIES
+		#define ipconfigTCP_FAST_OPEN_CACHE_ENTRIES	( 4 )
+	#endif
+
+	#if( ( ipconfigUSE_TCP_FAST_OPEN != 0 ) && ( ipconfigUSE_TCP_WIN == 0 ) )
+		#error ipconfigUSE_TCP_FAST_OPEN requires ipconfigUSE_TCP_WIN
+	#endif
+
+	#if( ( ipconfigUSE_TCP_FAST_OPEN != 0 ) && ( ipconfigTCP_FAST_OPEN_CACHE_ENTRIES < 1 ) )
+		#error ipconfigTCP_FAST_OPEN_CACHE_ENTRIES must be at least 1
+	#endif
 #endif
 
 /*
@@ -289,6 +470,27 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigMAX_ARP_AGE			150u
 #endif
 
+/* The number of hash buckets in the ARP cache, must be a power of two. */
+#ifndef ipconfigARP_CACHE_BUCKETS
+	#define ipconfigARP_CACHE_BUCKETS	8
+#endif
+
+#if( ( ipconfigARP_CACHE_BUCKETS & ( ipconfigARP_CACHE_BUCKETS - 1 ) ) != 0 )
+	#error ipconfigARP_CACHE_BUCKETS must be a power of two
+#endif
+
+#if( ipconfigARP_CACHE_ENTRIES > 65534 )
+	#error ipconfigARP_CACHE_ENTRIES is too large
+#endif
+
+/* An ARP cache entry that has been used to send packets will be refreshed
+when its age drops to ipconfigARP_REFRESH_AGE, so that it will not expire
+while traffic is flowing.  Unused entries are only refreshed just before they
+expire. */
+#ifndef ipconfigARP_REFRESH_AGE
+	#define ipconfigARP_REFRESH_AGE		( ipconfigMAX_ARP_AGE / 8u )
+#endif
+
 #ifndef ipconfigUSE_ARP_REVERSED_LOOKUP
 	#define ipconfigUSE_ARP_REVERSED_LOOKUP		0
 #endif
@@ -309,6 +511,58 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigEVENT_QUEUE_LENGTH		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
 #endif
 
+/* The maximum number of events, or received packets, that the IP-task will
+handle in a row.  Only after that, or when the event queue is empty, the timers
+will be checked again.  A chain of packets (see ipconfigUSE_LINKED_RX_MESSAGES)
+counts as one event for every packet, a longer chain will be handled in several
+rounds. */
+#ifndef ipconfigMAX_IP_TASK_BURST
+	#define ipconfigMAX_IP_TASK_BURST		( 16 )
+#endif
+
+#if ( ipconfigMAX_IP_TASK_BURST < 1 )
+	#error ipconfigMAX_IP_TASK_BURST must be at least 1
+#endif
+
+/* Allow the DSCP field of outgoing IP packets to be set per socket, with the
+socket option FREERTOS_SO_DSCP. */
+#ifndef ipconfigUSE_DSCP
+	#define ipconfigUSE_DSCP				0
+#endif
+
+/* Pass outgoing packets through a transmit scheduler before they are given to
+xNetworkInterfaceOutput().  The scheduler has four bands, chosen by the DSCP
+class of a packet: ARP, DHCP and network control are sent with strict priority,
+the interactive, best-effort and bulk bands share the link with deficit round
+robin, in a ratio of 4:2:1.  Every IP-task event may send up to
+ipconfigTX_SCHEDULER_BURST packets, the rest wait in the scheduler, so that the
+packets of a later event can overtake them. */
+#ifndef ipconfigUSE_TX_SCHEDULER
+	#define ipconfigUSE_TX_SCHEDULER		0
+#endif
+
+#if( ipconfigUSE_TX_SCHEDULER != 0 )
+	#ifndef ipconfigTX_SCHEDULER_BURST
+		#define ipconfigTX_SCHEDULER_BURST		( 4 )
+	#endif
+
+	/* The number of bytes the bulk band may send per round, the interactive
+	and best-effort bands get 4 and 2 times as much. */
+	#ifndef ipconfigTX_SCHEDULER_QUANTUM
+		#define ipconfigTX_SCHEDULER_QUANTUM	( ipconfigNETWORK_MTU + 14 )
+	#endif
+
+	/* Every waiting packet holds a network buffer.  When this many packets are
+	waiting, the oldest one of the most urgent band is sent first. */
+	#ifndef ipconfigTX_SCHEDULER_MAX_PACKETS
+		#define ipconfigTX_SCHEDULER_MAX_PACKETS	( 8 )
+	#endif
+
+	#if ( ipconfigTX_SCHEDULER_BURST < 1 )
+		#error ipconfigTX_SCHEDULER_BURST must be at least 1
+	#endif
+#endif /* ipconfigUSE_TX_SCHEDULER */
+
 #ifndef ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND
 	#define ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND 1
 #endif
@@ -329,6 +583,75 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigUDP_MAX_RX_PACKETS		0u
 #endif
 
+#ifndef ipconfigUDP_RX_COPYBREAK
+	/* When network buffers have a variable size (BufferAllocation_2.c or
+	 * BufferAllocation_3.c), received UDP packets of at most this number of
+	 * bytes are copied to a new buffer of the right size before they are queued
+	 * in a socket.  A small packet will then not occupy a full-size buffer
+	 * while it waits to be read.  Zero disables the copy.
+	 */
+	#define ipconfigUDP_RX_COPYBREAK		0u
+#endif
+
+#ifndef ipconfigUSE_IP_REASSEMBLY
+	/* When non-zero, received IPv4 fragments are collected and reassembled into
+	 * a single packet, otherwise fragments are dropped.  A reassembled packet
+	 * that is longer than the MTU can only be stored when network buffers have
+	 * a variable size (BufferAllocation_2.c).
+	 */
+	#define ipconfigUSE_IP_REASSEMBLY		0
+#endif
+
+#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+	/* The number of datagrams that can be reassembled at the same time. */
+	#ifndef ipconfigIP_REASSEMBLY_MAX_PACKETS
+		#define ipconfigIP_REASSEMBLY_MAX_PACKETS	2
+	#endif
+
+	/* The number of network buffers that may be held by fragments, for all
+	datagrams together.  When a new fragment would exceed this number, the
+	oldest incomplete datagram is dropped. */
+	#ifndef ipconfigIP_REASSEMBLY_MAX_BUFFERS
+		#define ipconfigIP_REASSEMBLY_MAX_BUFFERS	8
+	#endif
+
+	/* The largest IP payload, in bytes, that will be reassembled.  Fragments
+	of longer datagrams are dropped. */
+	#ifndef ipconfigIP_REASSEMBLY_MAX_SIZE
+		#define ipconfigIP_REASSEMBLY_MAX_SIZE		4096
+	#endif
+
+	/* The time, in milliseconds, after which an incomplete datagram is
+	dropped. */
+	#ifndef ipconfigIP_REASSEMBLY_TIMEOUT_MS
+		#define ipconfigIP_REASSEMBLY_TIMEOUT_MS	5000
+	#endif
+
+	#if( ipconfigIP_REASSEMBLY_MAX_SIZE > 65515 )
+		#error ipconfigIP_REASSEMBLY_MAX_SIZE must not exceed 65515
+	#endif
+#endif /* ipconfigUSE_IP_REASSEMBLY */
+
+#ifndef ipconfigUSE_IP_FRAGMENTATION
+	/* When non-zero, FreeRTOS_sendto() accepts UDP payloads that do not fit in
+	 * the MTU.  They are sent as a series of IPv4 fragments.  This needs network
+	 * buffers of a variable size (BufferAllocation_2.c); with fixed-size buffers
+	 * the limit stays at the MTU.
+	 */
+	#define ipconfigUSE_IP_FRAGMENTATION	0
+#endif
+
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/* The largest UDP payload, in bytes, that can be sent. */
+	#ifndef ipconfigIP_FRAGMENTATION_MAX_SIZE
+		#define ipconfigIP_FRAGMENTATION_MAX_SIZE	4096
+	#endif
+
+	#if( ipconfigIP_FRAGMENTATION_MAX_SIZE > 65507 )
+		#error ipconfigIP_FRAGMENTATION_MAX_SIZE must not exceed 65507
+	#endif
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 #ifndef ipconfigUSE_DHCP
 	#define ipconfigUSE_DHCP				1
 #endif
@@ -350,6 +673,18 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigARP_USE_CLASH_DETECTION		1
 #endif
 
+/* A cached DHCP lease is probed with ARP before it is used again. */
+#ifdef ipconfigDHCP_USE_LEASE_CACHE
+	#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+		#if defined( ipconfigARP_USE_CLASH_DETECTION ) && ( ipconfigARP_USE_CLASH_DETECTION == 0 )
+			#error ipconfigDHCP_USE_LEASE_CACHE requires ipconfigARP_USE_CLASH_DETECTION
+		#endif
+		#ifndef ipconfigARP_USE_CLASH_DETECTION
+			#define ipconfigARP_USE_CLASH_DETECTION		1
+		#endif
+	#endif
+#endif
+
 #ifndef ipconfigARP_USE_CLASH_DETECTION
 	#define ipconfigARP_USE_CLASH_DETECTION		0
 #endif
@@ -375,6 +710,15 @@ from the FreeRTOSIPConfig.h configuration header file. */
 #	define ipconfigTCP_TX_BUFFER_LENGTH			( 4u * ipconfigTCP_MSS )	/* defaults to 5840 bytes */
 #endif
 
+/* When defined as 1, the size of every stream buffer is a power of two, so
+ * that the indexes can be wrapped around with a mask in stead of a compare
+ * and subtract.  The TCP streams will be rounded up to the next power of two,
+ * which may cost up to twice the RAM.  Stream buffers that are created by
+ * other code must also have a LENGTH that is a power of two. */
+#ifndef ipconfigSTREAM_BUFFER_POWER_OF_TWO
+	#define ipconfigSTREAM_BUFFER_POWER_OF_TWO		0
+#endif
+
 #ifndef ipconfigMAXIMUM_DISCOVER_TX_PERIOD
 	#ifdef _WINDOWS_
 		#define ipconfigMAXIMUM_DISCOVER_TX_PERIOD		( pdMS_TO_TICKS( 999 ) )
@@ -411,14 +755,52 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#endif
 
 	#ifndef ipconfigDNS_CACHE_ENTRIES
-		#define ipconfigDNS_CACHE_ENTRIES			1
+		#define ipconfigDNS_CACHE_ENTRIES			4
+	#endif
+
+	#if( ipconfigDNS_CACHE_ENTRIES < 1 ) || ( ipconfigDNS_CACHE_ENTRIES > 65534 )
+		#error ipconfigDNS_CACHE_ENTRIES must be between 1 and 65534
+	#endif
+
+	/* The number of hash buckets in the DNS cache. */
+	#ifndef ipconfigDNS_CACHE_BUCKETS
+		#define ipconfigDNS_CACHE_BUCKETS			8
+	#endif
+
+	/* When a name does not exist, or when it has no IPv4 address, that fact
+	will be remembered during ipconfigDNS_CACHE_NEGATIVE_TTL seconds.  During
+	that time, a look-up of the name fails immediately.  Define it as zero to
+	disable negative caching. */
+	#ifndef ipconfigDNS_CACHE_NEGATIVE_TTL
+		#define ipconfigDNS_CACHE_NEGATIVE_TTL		30u
+	#endif
+
+	/* When a cached record is used that is about to expire, a new request will
+	be sent in the background, so that the next look-up is a hit. */
+	#ifndef ipconfigDNS_CACHE_PREFETCH
+		#define ipconfigDNS_CACHE_PREFETCH			1
 	#endif
 #endif /* ipconfigUSE_DNS_CACHE != 0 */
 
+/* The number of DNS requests that may be outstanding at the same time.  All
+requests share a single UDP socket.  Tasks looking up the same name will wait
+for the same reply. */
+#ifndef ipconfigDNS_MAX_PARALLEL_QUERIES
+	#define ipconfigDNS_MAX_PARALLEL_QUERIES	4
+#endif
+
 #ifndef ipconfigCHECK_IP_QUEUE_SPACE
 	#define ipconfigCHECK_IP_QUEUE_SPACE			0
 #endif
 
+/* Keep counters of received, sent and dropped packets, for the stack as a
+whole and for every socket.  They can be read with FreeRTOS_GetIPCounters()
+and FreeRTOS_GetSocketCounters().  The counters cost a few increments per
+packet and some 40 bytes of RAM per socket. */
+#ifndef ipconfigUSE_PERFORMANCE_COUNTERS
+	#define ipconfigUSE_PERFORMANCE_COUNTERS		0
+#endif
+
 #ifndef ipconfigUSE_LLMNR
 	/* Include support for LLMNR: Link-local Multicast Name Resolution (non-Microsoft) */
 	#define ipconfigUSE_LLMNR					( 0 )
@@ -496,10 +878,31 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigZERO_COPY_RX_DRIVER		( 0 )
 #endif
 
+/* When non-zero, the network interface may hand over received frames in
+memory of its own, e.g. the receive ring of the host, instead of copying them
+into the storage of a network buffer.  BufferAllocation_1.c calls
+vNetworkInterfaceReleaseRxBuffer() for every network buffer that is released,
+so that the driver can take its memory back and restore the storage of the
+buffer. */
+#ifndef ipconfigDRIVER_LENDS_RX_BUFFERS
+	#define ipconfigDRIVER_LENDS_RX_BUFFERS	( 0 )
+#endif
+
+#if( ( ipconfigDRIVER_LENDS_RX_BUFFERS != 0 ) && ( ipconfigZERO_COPY_RX_DRIVER == 0 ) )
+	#error ipconfigDRIVER_LENDS_RX_BUFFERS requires ipconfigZERO_COPY_RX_DRIVER
+#endif
+
 #ifndef ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM
 	#define ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM 0
 #endif
 
+/* When true, the driver implements xNetworkInterfaceOutputTSO(): it splits a
+large TCP packet into frames of a given segment size and calculates their
+checksums.  Only used when ipconfigTCP_TSO is defined. */
+#ifndef ipconfigDRIVER_SUPPORTS_TSO
+	#define ipconfigDRIVER_SUPPORTS_TSO 0
+#endif
+
 #ifndef ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM
 	#define ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM 0
 #endif
@@ -508,6 +911,21 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigDHCP_REGISTER_HOSTNAME 0
 #endif
 
+/* When true, the last DHCP lease is handed to vApplicationDHCPStoreLease().
+After a reset, the lease returned by xApplicationDHCPLoadLease() is asked for
+again with an INIT-REBOOT request, before falling back to a full discovery.
+The address is probed with ARP while the request is outstanding.  When another
+device answers, a full discovery is started right away. */
+#ifndef ipconfigDHCP_USE_LEASE_CACHE
+	#define ipconfigDHCP_USE_LEASE_CACHE 0
+#endif
+
+/* When true, a DHCP discover carries the rapid-commit option (RFC 4039).  A
+server that supports it will answer with an ACK, so no request is needed. */
+#ifndef ipconfigDHCP_RAPID_COMMIT
+	#define ipconfigDHCP_RAPID_COMMIT 0
+#endif
+
 #ifndef ipconfigSOCKET_HAS_USER_SEMAPHORE
 	#define ipconfigSOCKET_HAS_USER_SEMAPHORE 0
 #endif
@@ -520,6 +938,20 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigSUPPORT_SELECT_FUNCTION 0
 #endif
 
+/* When true, FreeRTOS_PollWait() and its friends are available.  Sockets in a
+poll set are put on a ready list by the IP-task as soon as they have an event,
+so the cost of waiting depends on the number of ready sockets only. */
+#ifndef ipconfigSUPPORT_POLL_FUNCTION
+	#define ipconfigSUPPORT_POLL_FUNCTION 0
+#endif
+
+/* When true, FreeRTOS_recvmmsg() and FreeRTOS_sendmmsg() are available.  They
+receive or send several UDP messages per call, and the messages that are sent
+are passed to the IP-task in a single event. */
+#ifndef ipconfigSUPPORT_MMSG_FUNCTIONS
+	#define ipconfigSUPPORT_MMSG_FUNCTIONS 0
+#endif
+
 #ifndef ipconfigTCP_KEEP_ALIVE
 	#define ipconfigTCP_KEEP_ALIVE 0
 #endif
@@ -45,8 +45,20 @@ typedef struct xARP_CACHE_TABLE_ROW
 	MACAddress_t xMACAddress;  /* The MAC address of an ARP cache entry. */
 	uint8_t ucAge;				/* A value that is periodically decremented but can also be refreshed by active communication.  The ARP cache entry is removed if the value reaches zero. */
     uint8_t ucValid;			/* pdTRUE: xMACAddress is valid, pdFALSE: waiting for ARP reply */
+	uint8_t ucUsed;				/* pdTRUE: the entry has been used to send a packet since it was last refreshed. */
+	uint16_t usNextInBucket;	/* The index plus one of the next row in the same hash bucket, or zero. */
+	TickType_t xLastUsedTime;	/* The time at which the entry was last used or refreshed, for LRU replacement. */
 } ARPCacheRow_t;
 
+/* Counters of the ARP cache, see FreeRTOS_GetARPStatistics(). */
+typedef struct xARP_CACHE_STATISTICS
+{
+	uint32_t ulHits;			/* Look-ups that found a valid entry. */
+	uint32_t ulMisses;			/* Look-ups that found no entry, or an entry still waiting for a reply. */
+	uint32_t ulEvictions;		/* Entries that were replaced by another IP address. */
+	uint32_t ulRefreshes;		/* ARP requests sent to refresh an entry before it expires. */
+} ARPCacheStatistics_t;
+
 typedef enum
 {
 	eARPCacheMiss = 0,			/* 0 An ARP table lookup did not find a valid entry. */
@@ -108,6 +120,11 @@ eARPLookupResult_t eARPGetCacheEntry( uint32_t *pulIPAddress, MACAddress_t * con
  */
 void vARPAgeCache( void );
 
+/*
+ * Copy the counters of the ARP cache.
+ */
+void FreeRTOS_GetARPStatistics( ARPCacheStatistics_t *pxStatistics );
+
 /*
  * Send out an ARP request for the IP address contained in pxNetworkBuffer, and
  * add an entry into the ARP table that indicates that an ARP reply is
@@ -121,6 +138,16 @@ void vARPGenerateRequestPacket( NetworkBufferDescriptor_t * const pxNetworkBuffe
  */
 void vARPSendGratuitous( void );
 
+#if( ipconfigARP_USE_CLASH_DETECTION != 0 )
+	/*
+	 * Probe ulIPAddress while the local IP address is still zero, and watch
+	 * the ARP traffic for other devices that use it.  xARPHadIPClash becomes
+	 * pdTRUE when one is seen.  It must be cleared by the caller before the
+	 * first probe.  Passing zero stops watching.
+	 */
+	void vARPProbeAddress( uint32_t ulIPAddress );
+#endif /* ipconfigARP_USE_CLASH_DETECTION */
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -52,6 +52,17 @@ typedef enum eDHCP_ANSWERS
 	eDHCPStopNoChanges,		/* Stop DHCP and continue with current settings. */
 } eDHCPCallbackAnswer_t;
 
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	/* The part of a DHCP lease that is kept by the application, e.g. in
+	non-volatile memory, when ipconfigDHCP_USE_LEASE_CACHE is set to 1.  The
+	addresses are stored in network byte order. */
+	typedef struct xDHCP_LEASE
+	{
+		uint32_t ulIPAddress;			/* The leased IP address. */
+		uint32_t ulDHCPServerAddress;	/* The server that granted the lease. */
+	} DHCPLease_t;
+#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+
 /*
  * NOT A PUBLIC API FUNCTION.
  */
@@ -67,6 +78,16 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Configuration.htm
 */
 eDHCPCallbackAnswer_t xApplicationDHCPHook( eDHCPCallbackPhase_t eDHCPPhase, uint32_t ulIPAddress );
 
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	/* Hooks that must be provided by the application if
+	ipconfigDHCP_USE_LEASE_CACHE is set to 1.  The load hook returns pdTRUE
+	when pxLease was filled with a lease from an earlier session.  The store
+	hook is called after every ACK, including renewals, so it may want to
+	skip writing when nothing has changed. */
+	BaseType_t xApplicationDHCPLoadLease( DHCPLease_t *pxLease );
+	void vApplicationDHCPStoreLease( const DHCPLease_t *pxLease );
+#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+
 #ifdef __cplusplus
 }	/* extern "C" */
 #endif
@@ -94,7 +94,10 @@ typedef struct xNETWORK_BUFFER
 	size_t xDataLength; 			/* Starts by holding the total Ethernet frame length, then the UDP/TCP payload length. */
 	uint16_t usPort;				/* Source or destination port, depending on usage scenario. */
 	uint16_t usBoundPort;			/* The port to which a transmitting socket is bound. */
-	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+		uint16_t usPayloadOffset;	/* For a buffer in a socket's xRxBufferList: the offset of the first unread byte. */
+	#endif
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 ) || ( ipconfigSUPPORT_MMSG_FUNCTIONS != 0 )
 		struct xNETWORK_BUFFER *pxNextBuffer; /* Possible optimisation for expert users - requires network driver support. */
 	#endif
 } NetworkBufferDescriptor_t;
@@ -251,6 +254,29 @@ BaseType_t FreeRTOS_IsNetworkUp( void );
 	UBaseType_t uxGetMinimumIPQueueSpace( void );
 #endif
 
+#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+	/* Stack-wide counters.  All received frames are counted in 'ulRxFrames',
+	the 'ulRxDrop...' members count the frames that were dropped, by reason. */
+	typedef struct xIP_COUNTERS
+	{
+		uint32_t ulRxFrames;			/* Frames passed to the IP-task by the network interface. */
+		uint32_t ulRxDropFiltered;		/* Rejected by eConsiderFrameForProcessing(): not for this MAC or an unwanted frame type. */
+		uint32_t ulRxDropMalformed;		/* Too short for its type, an unknown Ethernet type, or an invalid IP header. */
+		uint32_t ulRxDropFragment;		/* IP fragments, which can not be handled or reassembled. */
+		uint32_t ulRxDropNotForUs;		/* Addressed to another IP address. */
+		uint32_t ulRxDropChecksum;		/* The IP header or the protocol checksum was wrong. */
+		uint32_t ulRxReassembled;		/* Datagrams that were reassembled from IP fragments. */
+		uint32_t ulRxReassemblyFailed;	/* Incomplete datagrams that were dropped: timed out, inconsistent, or out of buffers. */
+		uint32_t ulRxDropNoSocket;		/* A UDP packet for a port that no socket is bound to. */
+		uint32_t ulRxDropSocketFull;	/* A UDP packet that did not fit in the socket's receive queue. */
+		uint32_t ulEventsLost;			/* Events that could not be posted to the IP-task. */
+		UBaseType_t uxEventQueueHighWater;	/* The highest number of messages seen in the IP-task's queue. */
+	} IPCounters_t;
+
+	/* Take a copy of the stack-wide counters. */
+	void FreeRTOS_GetIPCounters( IPCounters_t *pxCounters );
+#endif /* ipconfigUSE_PERFORMANCE_COUNTERS */
+
 /*
  * Defined in FreeRTOS_Sockets.c
  * //_RB_ Don't think this comment is correct.  If this is for internal use only it should appear after all the public API functions and not start with FreeRTOS_.
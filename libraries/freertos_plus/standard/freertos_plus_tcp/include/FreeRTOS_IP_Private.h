@@ -231,6 +231,11 @@ typedef union XPROT_PACKET
 /* The maximum UDP payload length. */
 #define ipMAX_UDP_PAYLOAD_LENGTH ( ( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER ) - ipSIZE_OF_UDP_HEADER )
 
+/* The fields of the IP header's usFragmentOffset, in host byte order.  The
+offset is expressed in units of 8 bytes. */
+#define ipFRAGMENT_FLAGS_MORE_FRAGMENTS		( ( uint16_t ) 0x2000u )
+#define ipFRAGMENT_OFFSET_MASK				( ( uint16_t ) 0x1fffu )
+
 typedef enum
 {
 	eReleaseBuffer = 0,		/* Processing the frame did not find anything to do - just release the buffer. */
@@ -255,6 +260,7 @@ typedef enum
 	eSocketCloseEvent,		/*10: Send a message to the IP-task to close a socket. */
 	eSocketSelectEvent,		/*11: Send a message to the IP-task for select(). */
 	eSocketSignalEvent,		/*12: A socket must be signalled. */
+	eStackTxBatchEvent,		/*13: FreeRTOS_sendmmsg() has queued a chain of packets to transmit. */
 } eIPEvent_t;
 
 typedef struct IP_TASK_COMMANDS
@@ -270,6 +276,9 @@ on the fragmentation status of the packet being sent.  The value is important,
 as it is past the location into which the destination address will get placed. */
 #define ipFRAGMENTATION_PARAMETERS_OFFSET		( 6 )
 #define ipSOCKET_OPTIONS_OFFSET					( 6 )
+/* The DSCP code point of a UDP packet being sent, stored in the byte that
+follows the socket options. */
+#define ipSOCKET_DSCP_OFFSET					( 7 )
 
 /* Only used when outgoing fragmentation is being used (FreeRTOSIPConfig.h
 setting. */
@@ -494,6 +503,21 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		} u;
 	} LastTCPPacket_t;
 
+	#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+		/* One slot of the circular list stays unused, to tell a full list
+		from an empty one. */
+		#define ipTCP_TX_REFERENCE_SLOTS	( ( ipconfigTCP_ZERO_COPY_TX_REFERENCES ) + 1 )
+
+		/* Transmission data that was passed to FreeRTOS_send() by reference.
+		The bytes occupy space in txStream, but they're not stored in it. */
+		typedef struct xTCP_TX_REFERENCE
+		{
+			const uint8_t *pucData;	/* The application's memory */
+			uint32_t ulFirst;		/* The number of bytes that were added to txStream before this data */
+			size_t uxLength;		/* The number of bytes referenced */
+		} TCPTxReference_t;
+	#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
+
 	/*
 	 * Note that the values of all short and long integers in these structs
 	 * are being stored in the native-endian way
@@ -532,6 +556,19 @@ BaseType_t xIPIsNetworkTaskReady( void );
 				bFinLast : 1,		/* The last ACK (after FIN and FIN+ACK) has been sent or will be sent by the peer */
 				bRxStopped : 1,		/* Application asked to temporarily stop reception */
 				bMallocError : 1,	/* There was an error allocating a stream */
+				#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+					bRxZeroCopy : 1,	/* In-order data is kept in network buffers, see xRxBufferList */
+				#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+				#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+					bTimeStamps : 1,	/* The TCP time-stamp option was offered and accepted in the SYN phase. */
+					bTSReceived : 1,	/* The packet being handled carries a time-stamp option. */
+				#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+				#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+					bFastOpen : 1,		/* Connect with TCP Fast Open, see FREERTOS_SO_TCP_FASTOPEN */
+				#endif /* ipconfigUSE_TCP_FAST_OPEN */
+				#if( ipconfigUSE_TCP_GRO != 0 )
+					bRxDeferred : 1,	/* The next segment of a burst follows, it will pass the data to the OnReceive handler */
+				#endif /* ipconfigUSE_TCP_GRO */
 				bWinScaling : 1;	/* A TCP-Window Scaling option was offered and accepted in the SYN phase. */
 		} bits;
 		uint32_t ulHighestRxAllowed;
@@ -561,7 +598,27 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		StreamBuffer_t *txStream;
 		#if( ipconfigUSE_TCP_WIN == 1 )
 			NetworkBufferDescriptor_t *pxAckMessage;
+			uint8_t ucUnackedSegments;	/* Full-size segments received since the last ACK was sent */
+			uint8_t ucQuickAckCount;	/* The number of segments that will be acknowledged without delay */
 		#endif /* ipconfigUSE_TCP_WIN */
+		#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+			/* Network buffers holding reception data.  For these buffers,
+			'usPayloadOffset' is the offset of the first unread byte in
+			'pucEthernetBuffer', and 'xDataLength' is the number of unread bytes.
+			The data in these buffers precedes the data in rxStream: the head of
+			rxStream has been advanced without copying any data. */
+			List_t xRxBufferList;
+			size_t uxRxQueuedBytes;	/* The total number of unread bytes in xRxBufferList */
+		#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+		#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+			/* A circular list of references, written by FreeRTOS_send() at
+			ucTxRefHead and released by the IP-task at ucTxRefTail. */
+			TCPTxReference_t xTxReferences[ ipTCP_TX_REFERENCE_SLOTS ];
+			uint32_t ulTxAdded;		/* The number of bytes added to txStream, only written by FreeRTOS_send() */
+			uint32_t ulTxAcked;		/* The number of bytes removed from txStream, only written by the IP-task */
+			uint8_t ucTxRefHead;
+			uint8_t ucTxRefTail;
+		#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
 		/* Buffer space to store the last TCP header received. */
 		LastTCPPacket_t xPacket;
 		uint8_t tcpflags;		/* TCP flags */
@@ -569,6 +626,14 @@ BaseType_t xIPIsNetworkTaskReady( void );
 			uint8_t ucMyWinScaleFactor;
 			uint8_t ucPeerWinScaleFactor;
 		#endif
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+			uint32_t ulTSRecent;	/* TS.Recent: the time-stamp to be echoed to the peer (RFC 7323) */
+			uint32_t ulTSValue;		/* TSval of the last time-stamp option received */
+			uint32_t ulTSEcho;		/* TSecr of the last time-stamp option received */
+		#endif
+		#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+			uint32_t ulFastOpenSent;	/* The number of data bytes sent along with the first SYN */
+		#endif
 		#if( ipconfigUSE_CALLBACKS == 1 )
 			FOnTCPReceive_t pxHandleReceive;	/*
 										 		 * In case of a TCP socket:
@@ -624,6 +689,9 @@ typedef struct xSOCKET
 	uint16_t usLocalPort;		/* Local port on this machine */
 	uint8_t ucSocketOptions;
 	uint8_t ucProtocol; /* choice of FREERTOS_IPPROTO_UDP/TCP */
+	#if( ipconfigUSE_DSCP != 0 )
+		uint8_t ucDSCP;	/* The DSCP code point of outgoing packets, see FREERTOS_SO_DSCP. */
+	#endif
 	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
 		SemaphoreHandle_t pxUserSemaphore;
 	#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
@@ -639,6 +707,16 @@ typedef struct xSOCKET
 		They are maintained by the IP-task */
 		EventBits_t xSocketBits;
 	#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
+	#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+		struct xPOLL_SET *pxPollSet;
+		ListItem_t xPollListItem;	/* Links the socket in the ready list of its poll set. */
+		EventBits_t xPollEvents;	/* The ePOLL_xxx events of interest, plus ePOLL_EDGE. */
+		EventBits_t xPollPending;	/* Events signalled by the IP-task, not reported yet. */
+		void *pvPollUserData;
+	#endif /* ipconfigSUPPORT_POLL_FUNCTION */
+	#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+		SocketCounters_t xCounters;	/* Only the counting members are kept up-to-date. */
+	#endif
 	/* TCP/UDP specific fields: */
 	/* Before accessing any member of this structure, it should be confirmed */
 	/* that the protocol corresponds with the type of structure */
@@ -797,6 +875,44 @@ extern void vSocketSelect( SocketSelect_t *pxSocketSelect );
 
 #endif /* ipconfigSUPPORT_SELECT_FUNCTION */
 
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+typedef struct xPOLL_SET
+{
+	EventGroupHandle_t xPollGroup;	/* The owner blocks on this group. */
+	List_t xReadyList;				/* Sockets that have events to report. */
+	UBaseType_t uxSocketCount;		/* Number of sockets in the set. */
+} PollSelect_t;
+
+/* Called by the IP-task: translate the eSOCKET_xxx bits to poll events and
+put the socket on the ready list of its poll set. */
+void vSocketPollSignal( FreeRTOS_Socket_t *pxSocket, EventBits_t xSocketEvents );
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION */
+
+#if( ipconfigUSE_TX_SCHEDULER != 0 )
+	/* Hand a packet to the transmit scheduler, which passes it on to
+	xNetworkInterfaceOutput() now or later, depending on its priority.  Only
+	the IP-task uses the scheduler, other tasks send directly. */
+	BaseType_t xTxSchedulerOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+
+	#define ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )	xTxSchedulerOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#else
+	#define ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )	xNetworkInterfaceOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#endif /* ipconfigUSE_TX_SCHEDULER */
+
+#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+	/* The stack-wide counters, only changed by the IP-task, except
+	'ulEventsLost'. */
+	extern IPCounters_t xIPCounters;
+
+	#define ipCOUNT_IP_EVENT( xMember )						( xIPCounters.xMember++ )
+	#define ipCOUNT_SOCKET_EVENT( pxSocket, xMember, xValue )	( ( pxSocket )->xCounters.xMember += ( uint32_t ) ( xValue ) )
+#else
+	#define ipCOUNT_IP_EVENT( xMember )
+	#define ipCOUNT_SOCKET_EVENT( pxSocket, xMember, xValue )
+#endif /* ipconfigUSE_PERFORMANCE_COUNTERS */
+
 void vIPSetDHCPTimerEnableState( BaseType_t xEnableState );
 void vIPReloadDHCPTimer( uint32_t ulLeaseTime );
 #if( ipconfigDNS_USE_CALLBACKS != 0 )
@@ -93,7 +93,9 @@ standard.  See the documentation of FreeRTOS_socket() for more information. */
 /* A bit value that can be passed into the FreeRTOS_sendto() function as part of
 the flags parameter.  Setting the FREERTOS_ZERO_COPY in the flags parameter
 indicates that the zero copy interface is being used.  See the documentation for
-FreeRTOS_sockets() for more information. */
+FreeRTOS_sockets() for more information.  When ipconfigUSE_TCP_ZERO_COPY_TX is
+defined, FreeRTOS_send() accepts the flag as well: the data will be sent by
+reference, see FreeRTOS_tx_referenced(). */
 #define FREERTOS_ZERO_COPY		( 1 )
 
 /* Values that can be passed in the option name parameter of calls to
@@ -132,9 +134,46 @@ FreeRTOS_setsockopt(). */
 
 #define FREERTOS_SO_SET_LOW_HIGH_WATER	( 18 )
 
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	#define FREERTOS_SO_TCP_CONGESTION	( 19 )		/* Select the congestion control algorithm, parameter is a pointer to a BaseType_t holding a FREERTOS_TCP_CC_xxx value */
+	#define FREERTOS_SO_TCP_PACING		( 20 )		/* Spread the transmission of segments over the RTT, parameter is a pointer to a BaseType_t */
+#endif
+
+#if( ipconfigUSE_TCP_WIN == 1 )
+	#define FREERTOS_SO_TCP_SEG_QUOTA	( 21 )		/* Number of segment descriptors the socket may hold before borrowing from the overflow pool, parameter is a pointer to a BaseType_t, 0 = no limit */
+#endif
+
+#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+	/* The option is a request, not a guarantee.  Data is still copied to
+	rxStream when it arrives out-of-order, when the socket already holds
+	ipconfigTCP_ZERO_COPY_RX_MAX_BUFFERS network buffers, when rxStream still
+	holds copied data, or when no buffer is available for the reply.  A
+	socket with an OnReceive handler passes the data straight to the handler.
+	Both FreeRTOS_recv() and FreeRTOS_ReleaseTCPPayloadBuffer() work the same
+	for either kind of data.  When ipconfigUSE_PERFORMANCE_COUNTERS is set,
+	'ulRxCopiedBytes' counts the bytes that were copied. */
+	#define FREERTOS_SO_TCP_ZERO_COPY_RX	( 22 )	/* Keep in-order data in the network buffers in which it was received, parameter is a pointer to a BaseType_t */
+#endif
+
+#if( ipconfigUSE_DSCP != 0 )
+	#define FREERTOS_SO_DSCP				( 23 )		/* Set the DSCP code point (0..63) of outgoing packets, parameter is a pointer to a BaseType_t */
+#endif
+
+#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+	/* Use TCP Fast Open (RFC 7413) when connecting, parameter is a pointer to a
+	BaseType_t.  The option must be set before FreeRTOS_connect() is called.
+	Data that is passed to FreeRTOS_send() before FreeRTOS_connect() will be
+	sent along with the SYN, as soon as a cookie of the server is known. */
+	#define FREERTOS_SO_TCP_FASTOPEN		( 24 )
+#endif
+
 #define FREERTOS_NOT_LAST_IN_FRAGMENTED_PACKET 	( 0x80 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 #define FREERTOS_FRAGMENTED_PACKET				( 0x40 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 
+/* Values for the FREERTOS_SO_TCP_CONGESTION option. */
+#define FREERTOS_TCP_CC_NEWRENO			( 1 )
+#define FREERTOS_TCP_CC_CUBIC			( 2 )
+
 /* Values for flag for FreeRTOS_shutdown(). */
 #define FREERTOS_SHUT_RD				( 0 )		/* Not really at this moment, just for compatibility of the interface */
 #define FREERTOS_SHUT_WR				( 1 )
@@ -221,6 +260,11 @@ Berkeley API. */
 struct xSOCKET_SET;
 typedef struct xSOCKET_SET *SocketSet_t;
 
+/* The PollSet_t type is the equivalent to an epoll instance: it keeps a list
+of sockets that have events ready, so waiting does not scan every socket. */
+struct xPOLL_SET;
+typedef struct xPOLL_SET *PollSet_t;
+
 /**
  * FULL, UP-TO-DATE AND MAINTAINED REFERENCE DOCUMENTATION FOR ALL THESE
  * FUNCTIONS IS AVAILABLE ON THE FOLLOWING URL:
@@ -242,6 +286,12 @@ BaseType_t xPortHasUDPSocket( uint16_t usPortNr );
 BaseType_t FreeRTOS_connect( Socket_t xClientSocket, struct freertos_sockaddr *pxAddress, socklen_t xAddressLength );
 BaseType_t FreeRTOS_listen( Socket_t xSocket, BaseType_t xBacklog );
 BaseType_t FreeRTOS_recv( Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags );
+/* Release 'xByteCount' bytes of reception data that were obtained by calling
+FreeRTOS_recv() with the FREERTOS_ZERO_COPY flag.  'pvBuffer' is the pointer
+that was returned.  Returns 'xByteCount', or -pdFREERTOS_ERRNO_EINVAL when
+'pvBuffer' is not the first unread byte, or when more bytes are released than
+were handed out. */
+BaseType_t FreeRTOS_ReleaseTCPPayloadBuffer( Socket_t xSocket, void const *pvBuffer, BaseType_t xByteCount );
 BaseType_t FreeRTOS_send( Socket_t xSocket, const void *pvBuffer, size_t uxDataLength, BaseType_t xFlags );
 Socket_t FreeRTOS_accept( Socket_t xServerSocket, struct freertos_sockaddr *pxAddress, socklen_t *pxAddressLength );
 BaseType_t FreeRTOS_shutdown (Socket_t xSocket, BaseType_t xHow);
@@ -264,6 +314,34 @@ BaseType_t FreeRTOS_issocketconnected( Socket_t xSocket );
 /* returns the actual size of MSS being used */
 BaseType_t FreeRTOS_mss( Socket_t xSocket );
 
+/* returns the number of TCP segments that were retransmitted */
+BaseType_t FreeRTOS_retransmit_count( Socket_t xSocket );
+
+#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+	/* Counters of a single socket.  The TCP members at the end are sampled
+	from the TCP window when the counters are read. */
+	typedef struct xSOCKET_COUNTERS
+	{
+		uint32_t ulRxBytes;				/* Payload bytes received. */
+		uint32_t ulTxBytes;				/* Payload bytes sent, TCP retransmissions included. */
+		uint32_t ulRxPackets;			/* UDP packets or TCP segments received. */
+		uint32_t ulTxPackets;			/* UDP packets or TCP data segments sent, pure ACKs are not counted. */
+		uint32_t ulRxDropped;			/* UDP packets dropped because the receive queue was full. */
+		uint32_t ulZeroWindowEvents;	/* TCP: the number of times the peer advertised a zero window. */
+		#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+			uint32_t ulRxCopiedBytes;	/* TCP: bytes copied to rxStream in zero-copy reception mode, see FREERTOS_SO_TCP_ZERO_COPY_RX. */
+		#endif
+		uint32_t ulRetransmits;			/* TCP: segments that were sent more than once. */
+		int32_t lSRTT;					/* TCP: the smoothed round-trip time in ms. */
+		uint32_t ulCWnd;				/* TCP: the congestion window, or the transmission window without congestion control. */
+		UBaseType_t uxOutOfOrderSegments;	/* TCP: segments waiting in the reception queue for missing data. */
+	} SocketCounters_t;
+
+	/* Take a copy of the counters of a socket.  Returns pdPASS, or
+	-pdFREERTOS_ERRNO_EINVAL for an invalid socket. */
+	BaseType_t FreeRTOS_GetSocketCounters( Socket_t xSocket, SocketCounters_t *pxCounters );
+#endif /* ipconfigUSE_PERFORMANCE_COUNTERS */
+
 /* for internal use only: return the connection status */
 BaseType_t FreeRTOS_connstatus( Socket_t xSocket );
 
@@ -296,6 +374,14 @@ FreeRTOS_rx_size(). */
  */
 uint8_t *FreeRTOS_get_tx_head( Socket_t xSocket, BaseType_t *pxLength );
 
+#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+	/* Returns the number of bytes that were passed to FreeRTOS_send() with the
+	FREERTOS_ZERO_COPY flag and that have not been acknowledged yet.  The
+	memory passed to FreeRTOS_send() must stay valid until this number drops
+	to zero, or at least below the number of bytes sent after it. */
+	BaseType_t FreeRTOS_tx_referenced( Socket_t xSocket );
+#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
+
 #endif /* ipconfigUSE_TCP */
 
 /*
@@ -382,6 +468,70 @@ void FreeRTOS_netstat( void );
 
 #endif /* ipconfigSUPPORT_SELECT_FUNCTION */
 
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+	/* Events that can be polled for, and that are reported in
+	PollEvent_t::xEvents.  ePOLL_EDGE may be added to the mask passed to
+	FreeRTOS_PollCtl(), to have a socket reported once per new event, in stead
+	of as long as the condition lasts. */
+	typedef enum ePOLL_EVENT {
+		ePOLL_READ		= 0x0001,	/* Data or a new connection is available. */
+		ePOLL_WRITE		= 0x0002,	/* Connected and there is space to send. */
+		ePOLL_EXCEPT	= 0x0004,	/* The peer has closed the connection. */
+		ePOLL_ALL		= 0x0007,
+		ePOLL_EDGE		= 0x0100,	/* Edge-triggered in stead of level-triggered. */
+	} ePollEvent_t;
+
+	/* Operations for FreeRTOS_PollCtl(). */
+	typedef enum ePOLL_CTL {
+		ePOLL_CTL_ADD,
+		ePOLL_CTL_MOD,
+		ePOLL_CTL_DEL,
+	} ePollCtl_t;
+
+	typedef struct xPOLL_EVENT
+	{
+		Socket_t xSocket;		/* The socket that has events. */
+		EventBits_t xEvents;	/* A combination of ePOLL_READ, ePOLL_WRITE and ePOLL_EXCEPT. */
+		void *pvUserData;		/* As passed to FreeRTOS_PollCtl(). */
+	} PollEvent_t;
+
+	PollSet_t FreeRTOS_CreatePollSet( void );
+	/* All sockets must have been removed from the set, or closed. */
+	void FreeRTOS_DeletePollSet( PollSet_t xPollSet );
+	/* Add a socket to a set, change its events, or remove it from the set.
+	A socket can belong to one poll set only.  Returns 0 or a negative errno. */
+	BaseType_t FreeRTOS_PollCtl( PollSet_t xPollSet, ePollCtl_t eOperation, Socket_t xSocket, EventBits_t xEvents, void *pvUserData );
+	/* Wait until at least one socket has an event, or until the block time
+	has passed.  Returns the number of entries that were written to
+	pxEvents. */
+	BaseType_t FreeRTOS_PollWait( PollSet_t xPollSet, PollEvent_t *pxEvents, BaseType_t xMaxEvents, TickType_t xBlockTimeTicks );
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION */
+
+#if( ipconfigSUPPORT_MMSG_FUNCTIONS == 1 )
+
+	/* One message for FreeRTOS_recvmmsg() or FreeRTOS_sendmmsg().  When the
+	flag FREERTOS_ZERO_COPY is used, pvBuffer points to a UDP payload buffer,
+	as with FreeRTOS_recvfrom() and FreeRTOS_sendto(). */
+	typedef struct xUDP_MESSAGE
+	{
+		void *pvBuffer;		/* The data to be sent, or the buffer to receive in. */
+		size_t xLength;		/* The number of bytes to send, or the size of pvBuffer.  Receiving sets it to the number of bytes received. */
+		struct freertos_sockaddr xAddress;	/* The destination address, or the source address of a received message. */
+	} UDPMessage_t;
+
+	/* Receive up to xMaxMessages UDP messages.  The call blocks like
+	FreeRTOS_recvfrom() until at least one message is available.  Returns the
+	number of messages received, or a negative errno. */
+	BaseType_t FreeRTOS_recvmmsg( Socket_t xSocket, UDPMessage_t *pxMessages, BaseType_t xMaxMessages, BaseType_t xFlags );
+	/* Send xMessageCount UDP messages with a single IP-task event.  Returns the
+	number of messages that were passed to the IP-task, or -pdFREERTOS_ERRNO_EINVAL
+	when the socket is not a UDP socket, or can not be bound. */
+	BaseType_t FreeRTOS_sendmmsg( Socket_t xSocket, const UDPMessage_t *pxMessages, BaseType_t xMessageCount, BaseType_t xFlags );
+
+#endif /* ipconfigSUPPORT_MMSG_FUNCTIONS */
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
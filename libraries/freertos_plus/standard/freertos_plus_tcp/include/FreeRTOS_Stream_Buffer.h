@@ -30,6 +30,8 @@
  *	An implementation of a circular buffer without a length field
  *	If LENGTH defines the size of the buffer, a maximum of (LENGT-1) bytes can be stored
  *	In order to add or read data from the buffer, memcpy() will be called at most 2 times
+ *	When ipconfigSTREAM_BUFFER_POWER_OF_TWO is defined as 1, LENGTH must be a power
+ *	of two, and indexes are wrapped around by masking them with (LENGTH-1)
  */
 
 #ifndef FREERTOS_STREAM_BUFFER_H
@@ -48,6 +50,15 @@ typedef struct xSTREAM_BUFFER {
 	uint8_t ucArray[ sizeof( size_t ) ];
 } StreamBuffer_t;
 
+/* The stored data, or the free space, of a stream buffer may wrap around the
+end of ucArray.  It is then described by two contiguous regions. */
+typedef struct xSTREAM_BUFFER_REGIONS {
+	uint8_t *pucFirst;			/* first region, starting at the requested position */
+	size_t uxFirst;				/* number of bytes in the first region */
+	uint8_t *pucSecond;			/* second region, at the start of ucArray, or NULL */
+	size_t uxSecond;			/* number of bytes in the second region */
+} StreamBufferRegions_t;
+
 static portINLINE void vStreamBufferClear( StreamBuffer_t *pxBuffer );
 static portINLINE void vStreamBufferClear( StreamBuffer_t *pxBuffer )
 {
@@ -59,19 +70,30 @@ static portINLINE void vStreamBufferClear( StreamBuffer_t *pxBuffer )
 }
 /*-----------------------------------------------------------*/
 
+static portINLINE size_t uxStreamBufferWrap( const StreamBuffer_t *pxBuffer, size_t uxIndex );
+static portINLINE size_t uxStreamBufferWrap( const StreamBuffer_t *pxBuffer, size_t uxIndex )
+{
+/* Returns uxIndex wrapped around to the range 0 .. LENGTH-1.  uxIndex may
+not be larger than ( 2 * LENGTH - 1 ) */
+#if( ipconfigSTREAM_BUFFER_POWER_OF_TWO != 0 )
+	return uxIndex & ( pxBuffer->LENGTH - 1u );
+#else
+	if( uxIndex >= pxBuffer->LENGTH )
+	{
+		uxIndex -= pxBuffer->LENGTH;
+	}
+
+	return uxIndex;
+#endif
+}
+/*-----------------------------------------------------------*/
+
 static portINLINE size_t uxStreamBufferSpace( const StreamBuffer_t *pxBuffer, const size_t uxLower, const size_t uxUpper );
 static portINLINE size_t uxStreamBufferSpace( const StreamBuffer_t *pxBuffer, const size_t uxLower, const size_t uxUpper )
 {
 /* Returns the space between uxLower and uxUpper, which equals to the distance minus 1 */
-size_t uxCount;
 
-	uxCount = pxBuffer->LENGTH + uxUpper - uxLower - 1u;
-	if( uxCount >= pxBuffer->LENGTH )
-	{
-		uxCount -= pxBuffer->LENGTH;
-	}
-
-	return uxCount;
+	return uxStreamBufferWrap( pxBuffer, pxBuffer->LENGTH + uxUpper - uxLower - 1u );
 }
 /*-----------------------------------------------------------*/
 
@@ -79,15 +101,8 @@ static portINLINE size_t uxStreamBufferDistance( const StreamBuffer_t *pxBuffer,
 static portINLINE size_t uxStreamBufferDistance( const StreamBuffer_t *pxBuffer, const size_t uxLower, const size_t uxUpper )
 {
 /* Returns the distance between uxLower and uxUpper */
-size_t uxCount;
 
-	uxCount = pxBuffer->LENGTH + uxUpper - uxLower;
-	if ( uxCount >= pxBuffer->LENGTH )
-	{
-		uxCount -= pxBuffer->LENGTH;
-	}
-
-	return uxCount;
+	return uxStreamBufferWrap( pxBuffer, pxBuffer->LENGTH + uxUpper - uxLower );
 }
 /*-----------------------------------------------------------*/
 
@@ -150,11 +165,7 @@ size_t uxSize = uxStreamBufferMidSpace( pxBuffer );
 	{
 		uxCount = uxSize;
 	}
-	pxBuffer->uxMid += uxCount;
-	if( pxBuffer->uxMid >= pxBuffer->LENGTH )
-	{
-		pxBuffer->uxMid -= pxBuffer->LENGTH;
-	}
+	pxBuffer->uxMid = uxStreamBufferWrap( pxBuffer, pxBuffer->uxMid + uxCount );
 }
 /*-----------------------------------------------------------*/
 
@@ -224,6 +235,33 @@ size_t uxStreamBufferAdd( StreamBuffer_t *pxBuffer, size_t uxOffset, const uint8
  */
 size_t uxStreamBufferGet( StreamBuffer_t *pxBuffer, size_t uxOffset, uint8_t *pucData, size_t uxMaxCount, BaseType_t xPeek );
 
+/*
+ * Look up the data stored in a stream buffer, without copying it.
+ *
+ * pxBuffer -	The buffer that holds the data.
+ * uxOffset -	The regions start at this offset from 'uxTail'.
+ * pxRegions -	Will be filled with the one or two regions that hold the data.
+ *
+ * Returns the total number of bytes in the regions.  Once the data has been
+ * used in place, it can be removed by calling:
+ * uxStreamBufferGet( pxBuffer, 0, NULL, uxCount, pdFALSE ).
+ */
+size_t uxStreamBufferGetReadRegions( StreamBuffer_t *pxBuffer, size_t uxOffset, StreamBufferRegions_t *pxRegions );
+
+/*
+ * Look up the free space of a stream buffer, so that data can be written to
+ * it in place.
+ *
+ * pxBuffer -	The buffer that will receive the data.
+ * uxOffset -	The regions start at this offset from 'uxHead'.
+ * pxRegions -	Will be filled with the one or two free regions.
+ *
+ * Returns the total number of bytes in the regions.  Once the data has been
+ * written, it can be added by calling:
+ * uxStreamBufferAdd( pxBuffer, 0, NULL, uxCount ).
+ */
+size_t uxStreamBufferGetWriteRegions( StreamBuffer_t *pxBuffer, size_t uxOffset, StreamBufferRegions_t *pxRegions );
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -32,6 +32,15 @@ extern "C" {
 
 BaseType_t xProcessReceivedTCPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer );
 
+#if( ipconfigUSE_TCP_GRO != 0 )
+	/*
+	 * Called by the IP-task while it works through a chain of received packets:
+	 * pxNextBuffer is the packet that will be processed after the current one,
+	 * or NULL.
+	 */
+	void vTCPSetNextReceivedBuffer( const NetworkBufferDescriptor_t *pxNextBuffer );
+#endif
+
 typedef enum eTCP_STATE {
 	/* Comments about the TCP states are borrowed from the very useful
 	 * Wiki page:
@@ -74,13 +74,66 @@ typedef struct xTCP_WINSIZE
 	uint32_t ulTxWindowLength;
 } TCPWinSize_t;
 
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	struct xTCP_WINDOW;
+
+	/*
+	 * A congestion control algorithm.  Slow start, the reaction to a loss and
+	 * pacing are handled by FreeRTOS_TCP_WIN.c, an algorithm only decides
+	 * how the congestion window grows during congestion avoidance and how far
+	 * it shrinks after a loss.
+	 */
+	typedef struct xTCP_CONGESTION_OPS
+	{
+		const char *pcName;
+		/* Called when the window is initialised or the algorithm is changed. */
+		void ( *pxInit )( struct xTCP_WINDOW *pxWindow );
+		/* Called for every ACK that confirms new data while ulCWnd >= ulSSThresh. */
+		void ( *pxCongestionAvoid )( struct xTCP_WINDOW *pxWindow, uint32_t ulBytesAcked );
+		/* Called when a loss is detected, returns the new slow start threshold. */
+		uint32_t ( *pxSSThresh )( struct xTCP_WINDOW *pxWindow );
+	} TCPCongestionOps_t;
+
+	typedef struct xTCP_CONGESTION
+	{
+		const TCPCongestionOps_t *pxOps;	/* The algorithm in use, selected by ucAlgorithm */
+		uint32_t ulCWnd;					/* Congestion window: the number of bytes that may be outstanding */
+		uint32_t ulSSThresh;				/* Slow start threshold */
+		uint32_t ulBytesAcked;				/* Bytes acknowledged since the last increase of ulCWnd during congestion avoidance */
+		uint32_t ulRecoverSequenceNumber;	/* Highest sequence number sent at the moment a loss was detected */
+		uint32_t ulWMax;					/* CUBIC: size of ulCWnd just before the last reduction */
+		uint32_t ulOriginPoint;				/* CUBIC: the plateau of the cubic function in the current epoch */
+		uint32_t ulEpochCWnd;				/* CUBIC: size of ulCWnd at the start of the current epoch */
+		uint32_t ulK;						/* CUBIC: number of ms needed to grow from ulEpochCWnd to ulOriginPoint */
+		TCPTimer_t xEpochTimer;				/* CUBIC: the moment the current congestion avoidance epoch started */
+		TCPTimer_t xPaceTimer;				/* The moment the last new segment was sent */
+		uint8_t ucAlgorithm;				/* One of the FREERTOS_TCP_CC_xxx values, 0 means ipconfigTCP_CONGESTION_CONTROL_DEFAULT */
+		union
+		{
+			struct
+			{
+				uint8_t
+					bInRecovery : 1,	/* A fast retransmission took place, waiting for 'ulRecoverSequenceNumber' to be ACK'd */
+					bEpochStarted : 1,	/* CUBIC: ulK and xEpochTimer are valid */
+					bPacing : 1;		/* Spread the transmission of new segments over the RTT */
+			} bits;
+			uint8_t ucFlags;
+		} u;
+	} TCPCongestion_t;
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 /*
  * If TCP time-stamps are being used, they will occupy 12 bytes in
  * each packet, and thus the message space will become smaller
  */
 /* Keep this as a multiple of 4 */
 #if( ipconfigUSE_TCP_WIN == 1 )
-	#define ipSIZE_TCP_OPTIONS	16u
+	#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		/* Room for a SACK option (12 bytes) followed by a time-stamp option. */
+		#define ipSIZE_TCP_OPTIONS	24u
+	#else
+		#define ipSIZE_TCP_OPTIONS	16u
+	#endif
 #else
 	#define ipSIZE_TCP_OPTIONS   12u
 #endif
@@ -98,8 +151,10 @@ typedef struct xTCP_WINDOW
 			uint32_t
 				bHasInit : 1,		/* The window structure has been initialised */
 				bSendFullSize : 1,	/* May only send packets with a size equal to MSS (for optimisation) */
-				bTimeStamps : 1;	/* Socket is supposed to use TCP time-stamps. This depends on the */
-		} bits;						/* party which opens the connection */
+				bTimeStamps : 1,	/* Socket is supposed to use TCP time-stamps. This depends on the */
+									/* party which opens the connection */
+				bRTTMeasured : 1;	/* At least one RTT sample has been taken, lRTTVar is valid */
+		} bits;
 		uint32_t ulFlags;
 	} u;
 	TCPWinSize_t xSize;
@@ -116,7 +171,10 @@ typedef struct xTCP_WINDOW
 	uint32_t ulOurSequenceNumber;		/* The SEQ number we're sending out */
 	uint32_t ulUserDataLength;			/* Number of bytes in Rx buffer which may be passed to the user, after having received a 'missing packet' */
 	uint32_t ulNextTxSequenceNumber;	/* The sequence number given to the next byte to be added for transmission */
-	int32_t lSRTT;						/* Smoothed Round Trip Time, it may increment quickly and it decrements slower */
+	uint32_t ulRetransmitCount;			/* Number of segments that were sent more than once */
+	int32_t lSRTT;						/* SRTT: the Smoothed Round Trip Time in ms (RFC 6298) */
+	int32_t lRTTVar;					/* RTTVAR: the variation of the Round Trip Time (RFC 6298) */
+	int32_t lRTO;						/* The Retransmission Time-Out in ms (RFC 6298) */
 	uint8_t ucOptionLength;				/* Number of valid bytes in ulOptionsData[] */
 #if( ipconfigUSE_TCP_WIN == 1 )
 	List_t xPriorityQueue;				/* Priority queue: segments which must be sent immediately */
@@ -126,6 +184,11 @@ typedef struct xTCP_WINDOW
 	uint32_t ulOptionsData[ipSIZE_TCP_OPTIONS/sizeof(uint32_t)];	/* Contains the options we send out */
 	List_t xTxSegments;					/* A linked list of all transmission segments, sorted on sequence number */
 	List_t xRxSegments;					/* A linked list of reception segments, order depends on sequence of arrival */
+	UBaseType_t uxSegmentQuota;			/* Number of segments this window may hold before it must borrow from the overflow pool, 0 = no limit */
+	UBaseType_t uxSegmentHighWater;		/* The highest number of segments this window has held at any moment */
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+		TCPCongestion_t xCongestion;	/* State of the congestion control algorithm */
+	#endif
 #else
 	/* For tiny TCP, there is only 1 outstanding TX segment */
 	TCPSegment_t xTxSegment;			/* Priority queue */
@@ -136,6 +199,21 @@ typedef struct xTCP_WINDOW
 	uint16_t usMSSInit;					/* MSS as configured by the socket owner */
 } TCPWindow_t;
 
+#if( ipconfigUSE_TCP_WIN == 1 )
+	/* Usage of the common pool of segment descriptors, see
+	vTCPWindowGetSegmentStats(). */
+	typedef struct xTCP_SEGMENT_STATS
+	{
+		UBaseType_t uxTotal;				/* Number of descriptors created so far, at most ipconfigTCP_WIN_SEG_COUNT */
+		UBaseType_t uxFree;					/* Number of descriptors available at this moment */
+		UBaseType_t uxMaximumInUse;			/* High-water mark: the highest number of descriptors in use */
+		UBaseType_t uxOverflowInUse;		/* Descriptors held by windows beyond their quota */
+		UBaseType_t uxOverflowHighWater;	/* High-water mark of uxOverflowInUse */
+		uint32_t ulPoolExhausted;			/* Number of times a descriptor was requested while none were available */
+		uint32_t ulQuotaRefused;			/* Number of times a window reached its quota while the overflow pool was in use */
+	} TCPSegmentStats_t;
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
 
 /*=============================================================================
  *
@@ -157,6 +235,12 @@ void vTCPWindowInit( TCPWindow_t *pxWindow, uint32_t ulAckNumber, uint32_t ulSeq
 /* Clean up allocated segments. Should only be called when FreeRTOS+TCP will no longer be used. */
 void vTCPSegmentCleanup( void );
 
+#if( ipconfigUSE_TCP_WIN == 1 )
+	/* Get a snapshot of the usage of the segment pool.  May be called from
+	any task. */
+	void vTCPWindowGetSegmentStats( TCPSegmentStats_t *pxStats );
+#endif
+
 /*=============================================================================
  *
  * Rx functions
@@ -205,6 +289,20 @@ uint32_t ulTCPWindowTxAck( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber );
 /* Receive a SACK option */
 uint32_t ulTCPWindowTxSack( TCPWindow_t *pxWindow, uint32_t ulFirst, uint32_t ulLast );
 
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	/* Select a congestion control algorithm (FREERTOS_TCP_CC_xxx).  Returns
+	pdFALSE if the algorithm is not known. */
+	BaseType_t xTCPWindowSetCongestionControl( TCPWindow_t *pxWindow, uint8_t ucAlgorithm );
+
+	/* Called when the connection gets established.  The initial window is
+	calculated again, now that the MSS has been negotiated. */
+	void vTCPWindowCongestionStart( TCPWindow_t *pxWindow );
+#endif
+
+/* A new Round Trip Time sample of 'ulRTT' ms is available, update SRTT,
+RTTVAR and the RTO. */
+void vTCPWindowRTTSample( TCPWindow_t *pxWindow, uint32_t ulRTT );
+
 
 #ifdef __cplusplus
 }	/* extern "C" */
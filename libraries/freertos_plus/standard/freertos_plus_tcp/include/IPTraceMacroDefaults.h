@@ -190,4 +190,10 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceSENDTO_DATA_TOO_LONG()
 #endif
 
+/* Called when the ACK for a received TCP segment is left to the segment that
+follows it in the same chain of received packets (ipconfigUSE_TCP_GRO). */
+#ifndef iptraceTCP_ACK_COALESCED
+	#define iptraceTCP_ACK_COALESCED( pxSocket )
+#endif
+
 #endif /* UDP_TRACE_MACRO_DEFAULTS_H */
@@ -36,6 +36,23 @@ BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkB
 void vNetworkInterfaceAllocateRAMToBuffers( NetworkBufferDescriptor_t pxNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ] );
 BaseType_t xGetPhyLinkStatus( void );
 
+#if( ipconfigDRIVER_SUPPORTS_TSO != 0 )
+	/* Send a TCP packet that is larger than the MTU: the driver (or the
+	hardware) splits it into frames carrying at most usSegmentSize bytes of
+	data, adapting the sequence number, the IP length and identification, and
+	the checksums of each frame.  PSH and FIN are only set in the last frame. */
+	BaseType_t xNetworkInterfaceOutputTSO( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint16_t usSegmentSize, BaseType_t xReleaseAfterSend );
+#endif
+
+#if( ipconfigDRIVER_LENDS_RX_BUFFERS != 0 )
+	/* Called by BufferAllocation_1.c for every network buffer that is
+	released, also from vNetworkBufferReleaseFromISR().  When the buffer holds
+	a frame in memory of the driver, the driver takes that memory back and
+	restores the storage that vNetworkInterfaceAllocateRAMToBuffers() gave to
+	the buffer.  Other buffers must be left alone. */
+	void vNetworkInterfaceReleaseRxBuffer( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+#endif
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
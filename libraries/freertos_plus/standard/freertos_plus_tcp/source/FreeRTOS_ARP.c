@@ -59,16 +59,46 @@ entry is still valid and can therefore be refreshed. */
 
 /*-----------------------------------------------------------*/
 
+/* The hash bucket of an IP address.  All four bytes are mixed, so the result
+does not depend on the byte order. */
+#define arpHASH_BUCKET( ulIPAddress ) \
+	( ( ( ulIPAddress ) ^ ( ( ulIPAddress ) >> 8 ) ^ ( ( ulIPAddress ) >> 16 ) ^ ( ( ulIPAddress ) >> 24 ) ) & ( ipconfigARP_CACHE_BUCKETS - 1u ) )
+
+/*-----------------------------------------------------------*/
+
 /*
  * Lookup an MAC address in the ARP cache from the IP address.
  */
 static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress_t * const pxMACAddress );
 
+/*
+ * Find the row that holds ulIPAddress, using the hash table.  Returns -1 when
+ * the address is not in the cache.
+ */
+static BaseType_t prvFindEntry( uint32_t ulIPAddress );
+
+/*
+ * Remove a row from its hash bucket.
+ */
+static void prvUnlinkEntry( BaseType_t xEntry );
+
+/*
+ * Change the IP address of a row, and move it to the right hash bucket.  An
+ * address of zero leaves the row unlinked.
+ */
+static void prvSetEntryAddress( BaseType_t xEntry, uint32_t ulIPAddress );
+
 /*-----------------------------------------------------------*/
 
 /* The ARP cache. */
 static ARPCacheRow_t xARPCache[ ipconfigARP_CACHE_ENTRIES ];
 
+/* The index plus one of the first row in each hash bucket, or zero. */
+static uint16_t usARPBuckets[ ipconfigARP_CACHE_BUCKETS ];
+
+/* The counters of the ARP cache. */
+static ARPCacheStatistics_t xARPStatistics;
+
 /* The time at which the last gratuitous ARP was sent.  Gratuitous ARPs are used
 to ensure ARP tables are up to date and to detect IP address conflicts. */
 static TickType_t xLastGratuitousARPTime = ( TickType_t ) 0;
@@ -83,6 +113,9 @@ static TickType_t xLastGratuitousARPTime = ( TickType_t ) 0;
 	BaseType_t xARPHadIPClash;
 	/* MAC-address of the other device containing the same IP-address. */
 	MACAddress_t xARPClashMacAddress;
+	/* The address that is being probed while this node has no address yet,
+	or zero. */
+	static uint32_t ulARPProbeAddress = 0UL;
 #endif /* ipconfigARP_USE_CLASH_DETECTION */
 
 /* Part of the Ethernet and ARP headers are always constant when sending an IPv4
@@ -120,6 +153,22 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 
 	traceARP_PACKET_RECEIVED();
 
+	#if( ipconfigARP_USE_CLASH_DETECTION != 0 )
+	{
+		/* Another device that uses the probed address will answer the probe,
+		or announce the address.  A device that probes for the same address
+		uses 0.0.0.0 as its sender address. */
+		if( ( ulARPProbeAddress != 0UL ) &&
+			( ( ulSenderProtocolAddress == ulARPProbeAddress ) ||
+			  ( ( ulSenderProtocolAddress == 0UL ) && ( ulTargetProtocolAddress == ulARPProbeAddress ) ) ) &&
+			( memcmp( ( void * ) pxARPHeader->xSenderHardwareAddress.ucBytes, ( void * ) ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) ) != 0 ) )
+		{
+			xARPHadIPClash = pdTRUE;
+			memcpy( xARPClashMacAddress.ucBytes, pxARPHeader->xSenderHardwareAddress.ucBytes, sizeof( xARPClashMacAddress.ucBytes ) );
+		}
+	}
+	#endif /* ipconfigARP_USE_CLASH_DETECTION */
+
 	/* Don't do anything if the local IP address is zero because
 	that means a DHCP request has not completed. */
 	if( *ipLOCAL_IP_ADDRESS_POINTER != 0UL )
@@ -198,6 +247,7 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 			if( ( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
 			{
 				lResult = xARPCache[ x ].ulIPAddress;
+				prvUnlinkEntry( x );
 				memset( &xARPCache[ x ], '\0', sizeof( xARPCache[ x ] ) );
 				break;
 			}
@@ -215,7 +265,9 @@ BaseType_t x = 0;
 BaseType_t xIpEntry = -1;
 BaseType_t xMacEntry = -1;
 BaseType_t xUseEntry = 0;
-uint8_t ucMinAgeFound = 0U;
+TickType_t xNow = xTaskGetTickCount();
+TickType_t xOldestUse = 0U;
+BaseType_t xHasEmptyEntry = pdFALSE;
 
 	#if( ipconfigARP_STORES_REMOTE_ADDRESSES == 0 )
 		/* Only process the IP address if it is on the local network.
@@ -233,8 +285,31 @@ uint8_t ucMinAgeFound = 0U;
 		if( pdTRUE )
 	#endif
 	{
-		/* Start with the maximum possible number. */
-		ucMinAgeFound--;
+		/* This function will be called for each received packet.  Most of the
+		times the IP address will be found with the same MAC address, so first
+		use the hash table.  As this is by far the most common path the coding
+		standard is relaxed in this case and a return is permitted as an
+		optimisation. */
+		x = prvFindEntry( ulIPAddress );
+
+		if( x >= 0 )
+		{
+			if( pxMACAddress == NULL )
+			{
+				/* There is an entry already, possibly an outstanding ARP
+				request. */
+				return;
+			}
+
+			if( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 )
+			{
+				xARPCache[ x ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
+				xARPCache[ x ].ucValid = ( uint8_t ) pdTRUE;
+				xARPCache[ x ].ucUsed = ( uint8_t ) pdFALSE;
+				xARPCache[ x ].xLastUsedTime = xNow;
+				return;
+			}
+		}
 
 		/* For each entry in the ARP cache table. */
 		for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
@@ -252,18 +327,6 @@ uint8_t ucMinAgeFound = 0U;
 					break;
 				}
 
-				/* See if the MAC-address also matches. */
-				if( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 )
-				{
-					/* This function will be called for each received packet
-					As this is by far the most common path the coding standard
-					is relaxed in this case and a return is permitted as an
-					optimisation. */
-					xARPCache[ x ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
-					xARPCache[ x ].ucValid = ( uint8_t ) pdTRUE;
-					return;
-				}
-
 				/* Found an entry containing ulIPAddress, but the MAC address
 				doesn't match.  Might be an entry with ucValid=pdFALSE, waiting
 				for an ARP reply.  Still want to see if there is match with the
@@ -291,16 +354,21 @@ uint8_t ucMinAgeFound = 0U;
 				xMacEntry = x;
 	#endif
 			}
-			/* _HT_
-			Shouldn't we test for xARPCache[ x ].ucValid == pdFALSE here ? */
-			else if( xARPCache[ x ].ucAge < ucMinAgeFound )
+			else if( xHasEmptyEntry == pdFALSE )
 			{
-				/* As the table is traversed, remember the table row that
-				contains the oldest entry (the lowest age count, as ages are
-				decremented to zero) so the row can be re-used if this function
-				needs to add an entry that does not already exist. */
-				ucMinAgeFound = xARPCache[ x ].ucAge;
-				xUseEntry = x;
+				/* As the table is traversed, remember a free row, or else the
+				least recently used row, so the row can be re-used if this
+				function needs to add an entry that does not already exist. */
+				if( xARPCache[ x ].ulIPAddress == 0UL )
+				{
+					xHasEmptyEntry = pdTRUE;
+					xUseEntry = x;
+				}
+				else if( ( xNow - xARPCache[ x ].xLastUsedTime ) >= xOldestUse )
+				{
+					xOldestUse = xNow - xARPCache[ x ].xLastUsedTime;
+					xUseEntry = x;
+				}
 			}
 		}
 
@@ -313,6 +381,7 @@ uint8_t ucMinAgeFound = 0U;
 				/* Both the MAC address as well as the IP address were found in
 				different locations: clear the entry which matches the
 				IP-address */
+				prvUnlinkEntry( xIpEntry );
 				memset( &xARPCache[ xIpEntry ], '\0', sizeof( xARPCache[ xIpEntry ] ) );
 			}
 		}
@@ -322,8 +391,17 @@ uint8_t ucMinAgeFound = 0U;
 			xUseEntry = xIpEntry;
 		}
 
-		/* If the entry was not found, we use the oldest entry and set the IPaddress */
-		xARPCache[ xUseEntry ].ulIPAddress = ulIPAddress;
+		else if( xARPCache[ xUseEntry ].ulIPAddress != 0UL )
+		{
+			/* A row of another address will be re-used. */
+			xARPStatistics.ulEvictions++;
+		}
+
+		/* If the entry was not found, we use the least recently used entry and
+		set the IPaddress */
+		prvSetEntryAddress( xUseEntry, ulIPAddress );
+		xARPCache[ xUseEntry ].ucUsed = ( uint8_t ) pdFALSE;
+		xARPCache[ xUseEntry ].xLastUsedTime = xNow;
 
 		if( pxMACAddress != NULL )
 		{
@@ -463,30 +541,102 @@ static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress
 BaseType_t x;
 eARPLookupResult_t eReturn = eARPCacheMiss;
 
-	/* Loop through each entry in the ARP cache. */
-	for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+	/* Does a row in the ARP cache table hold an entry for the IP address
+	being queried? */
+	x = prvFindEntry( ulAddressToLookup );
+
+	if( x >= 0 )
 	{
-		/* Does this row in the ARP cache table hold an entry for the IP address
-		being queried? */
-		if( xARPCache[ x ].ulIPAddress == ulAddressToLookup )
+		/* A matching valid entry was found. */
+		if( xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
 		{
-			/* A matching valid entry was found. */
-			if( xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
+			/* This entry is waiting an ARP reply, so is not valid. */
+			eReturn = eCantSendPacket;
+		}
+		else
+		{
+			/* A valid entry was found. */
+			memcpy( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) );
+			xARPCache[ x ].ucUsed = ( uint8_t ) pdTRUE;
+			xARPCache[ x ].xLastUsedTime = xTaskGetTickCount();
+			eReturn = eARPCacheHit;
+		}
+	}
+
+	if( eReturn == eARPCacheHit )
+	{
+		xARPStatistics.ulHits++;
+	}
+	else
+	{
+		xARPStatistics.ulMisses++;
+	}
+
+	return eReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFindEntry( uint32_t ulIPAddress )
+{
+BaseType_t xEntry = -1;
+uint16_t usIndex;
+
+	if( ulIPAddress != 0UL )
+	{
+		for( usIndex = usARPBuckets[ arpHASH_BUCKET( ulIPAddress ) ];
+			 usIndex != 0u;
+			 usIndex = xARPCache[ usIndex - 1u ].usNextInBucket )
+		{
+			if( xARPCache[ usIndex - 1u ].ulIPAddress == ulIPAddress )
 			{
-				/* This entry is waiting an ARP reply, so is not valid. */
-				eReturn = eCantSendPacket;
+				xEntry = ( BaseType_t ) usIndex - 1;
+				break;
 			}
-			else
+		}
+	}
+
+	return xEntry;
+}
+/*-----------------------------------------------------------*/
+
+static void prvUnlinkEntry( BaseType_t xEntry )
+{
+uint16_t *pusLink;
+
+	if( xARPCache[ xEntry ].ulIPAddress != 0UL )
+	{
+		/* Find the link that points to this row. */
+		pusLink = &( usARPBuckets[ arpHASH_BUCKET( xARPCache[ xEntry ].ulIPAddress ) ] );
+
+		while( *pusLink != 0u )
+		{
+			if( *pusLink == ( uint16_t ) ( xEntry + 1 ) )
 			{
-				/* A valid entry was found. */
-				memcpy( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) );
-				eReturn = eARPCacheHit;
+				*pusLink = xARPCache[ xEntry ].usNextInBucket;
+				break;
 			}
-			break;
+
+			pusLink = &( xARPCache[ *pusLink - 1u ].usNextInBucket );
 		}
 	}
 
-	return eReturn;
+	xARPCache[ xEntry ].usNextInBucket = 0u;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetEntryAddress( BaseType_t xEntry, uint32_t ulIPAddress )
+{
+	if( xARPCache[ xEntry ].ulIPAddress != ulIPAddress )
+	{
+		prvUnlinkEntry( xEntry );
+		xARPCache[ xEntry ].ulIPAddress = ulIPAddress;
+
+		if( ulIPAddress != 0UL )
+		{
+			xARPCache[ xEntry ].usNextInBucket = usARPBuckets[ arpHASH_BUCKET( ulIPAddress ) ];
+			usARPBuckets[ arpHASH_BUCKET( ulIPAddress ) ] = ( uint16_t ) ( xEntry + 1 );
+		}
+	}
 }
 /*-----------------------------------------------------------*/
 
@@ -511,12 +661,16 @@ TickType_t xTimeNow;
 			{
 				FreeRTOS_OutputARPRequest( xARPCache[ x ].ulIPAddress );
 			}
-			else if( xARPCache[ x ].ucAge <= ( uint8_t ) arpMAX_ARP_AGE_BEFORE_NEW_ARP_REQUEST )
+			else if( ( xARPCache[ x ].ucAge <= ( uint8_t ) arpMAX_ARP_AGE_BEFORE_NEW_ARP_REQUEST ) ||
+					 ( ( xARPCache[ x ].ucUsed != ( uint8_t ) pdFALSE ) && ( xARPCache[ x ].ucAge <= ( uint8_t ) ipconfigARP_REFRESH_AGE ) ) )
 			{
-				/* This entry will get removed soon.  See if the MAC address is
-				still valid to prevent this happening. */
+				/* This entry will get removed soon, or it is in use and
+				should not expire while traffic is flowing.  See if the MAC
+				address is still valid to prevent this happening.  The reply
+				will reset the age of the entry. */
 				iptraceARP_TABLE_ENTRY_WILL_EXPIRE( xARPCache[ x ].ulIPAddress );
 				FreeRTOS_OutputARPRequest( xARPCache[ x ].ulIPAddress );
+				xARPStatistics.ulRefreshes++;
 			}
 			else
 			{
@@ -527,7 +681,7 @@ TickType_t xTimeNow;
 			{
 				/* The entry is no longer valid.  Wipe it out. */
 				iptraceARP_TABLE_ENTRY_EXPIRED( xARPCache[ x ].ulIPAddress );
-				xARPCache[ x ].ulIPAddress = 0UL;
+				prvSetEntryAddress( x, 0UL );
 			}
 		}
 	}
@@ -553,6 +707,24 @@ void vARPSendGratuitous( void )
 }
 
 /*-----------------------------------------------------------*/
+
+#if( ipconfigARP_USE_CLASH_DETECTION != 0 )
+
+	void vARPProbeAddress( uint32_t ulIPAddress )
+	{
+		/* The local IP address is still zero, so the request is sent with
+		0.0.0.0 as the sender address, as a probe described in RFC 5227. */
+		ulARPProbeAddress = ulIPAddress;
+
+		if( ulIPAddress != 0UL )
+		{
+			FreeRTOS_OutputARPRequest( ulIPAddress );
+		}
+	}
+
+#endif /* ipconfigARP_USE_CLASH_DETECTION */
+/*-----------------------------------------------------------*/
+
 void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
 {
 NetworkBufferDescriptor_t *pxNetworkBuffer;
@@ -583,7 +755,7 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 		if( xIsCallingFromIPTask() != 0 )
 		{
 			/* Only the IP-task is allowed to call this function directly. */
-			xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+			ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, pdTRUE );
 		}
 		else
 		{
@@ -640,6 +812,13 @@ ARPPacket_t *pxARPPacket;
 void FreeRTOS_ClearARP( void )
 {
 	memset( xARPCache, '\0', sizeof( xARPCache ) );
+	memset( usARPBuckets, '\0', sizeof( usARPBuckets ) );
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_GetARPStatistics( ARPCacheStatistics_t *pxStatistics )
+{
+	memcpy( pxStatistics, &xARPStatistics, sizeof( *pxStatistics ) );
 }
 /*-----------------------------------------------------------*/
 
@@ -62,6 +62,15 @@
 	#define dhcpINITIAL_DHCP_TX_PERIOD			( pdMS_TO_TICKS( 5000 ) )
 #endif
 
+/* An INIT-REBOOT request for a cached lease is repeated once, after which a
+full discovery is started. */
+#define dhcpINIT_REBOOT_TX_PERIOD				( pdMS_TO_TICKS( 1000 ) )
+#define dhcpMAX_INIT_REBOOT_TX_PERIOD			( 2u * dhcpINIT_REBOOT_TX_PERIOD )
+
+/* The cached address is not used before it has been probed with ARP for this
+long without an answer, even when the ACK came earlier. */
+#define dhcpLEASE_PROBE_PERIOD					( pdMS_TO_TICKS( 500 ) )
+
 /* Codes of interest found in the DHCP options field. */
 #define dhcpZERO_PAD_OPTION_CODE				( 0u )
 #define dhcpSUBNET_MASK_OPTION_CODE				( 1u )
@@ -74,6 +83,7 @@
 #define dhcpSERVER_IP_ADDRESS_OPTION_CODE		( 54u )
 #define dhcpPARAMETER_REQUEST_OPTION_CODE		( 55u )
 #define dhcpCLIENT_IDENTIFIER_OPTION_CODE		( 61u )
+#define dhcpRAPID_COMMIT_OPTION_CODE			( 80u )
 
 /* The four DHCP message types of interest. */
 #define dhcpMESSAGE_TYPE_DISCOVER				( 1 )
@@ -150,6 +160,9 @@ typedef enum
 	eWaitingSendFirstDiscover = 0,	/* Initial state.  Send a discover the first time it is called, and reset all timers. */
 	eWaitingOffer,					/* Either resend the discover, or, if the offer is forthcoming, send a request. */
 	eWaitingAcknowledge,			/* Either resend the request. */
+	#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+		eWaitingProbe,				/* The cached lease was acknowledged, wait until the ARP probe has had no answer. */
+	#endif
 	#if( ipconfigDHCP_FALL_BACK_AUTO_IP != 0 )
 		eGetLinkLayerAddress,		/* When DHCP didn't respond, try to obtain a LinkLayer address 168.254.x.x. */
 	#endif
@@ -173,6 +186,18 @@ struct xDHCP_DATA
 	eDHCPState_t eDHCPState;
 	/* The UDP socket used for all incoming and outgoing DHCP traffic. */
 	Socket_t xDHCPSocket;
+	#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+		/* The cached lease may be tried once after a reset. */
+		BaseType_t xUseCachedLease;
+		/* An INIT-REBOOT request is outstanding. */
+		BaseType_t xInitReboot;
+		/* The time at which the cached address was probed first. */
+		TickType_t xProbeTime;
+	#endif
+	#if( ipconfigDHCP_RAPID_COMMIT != 0 )
+		/* A discover was answered with a rapid-commit ACK. */
+		BaseType_t xRapidCommit;
+	#endif
 };
 
 typedef struct xDHCP_DATA DHCPData_t;
@@ -211,6 +236,29 @@ static void prvSendDHCPRequest( void );
  */
 static void prvInitialiseDHCP( void );
 
+/*
+ * An ACK has been received: start using the leased address.
+ */
+static void prvDHCPLeaseAcquired( void );
+
+/*
+ * Once after a reset, ask for the lease that was cached by the application
+ * with an INIT-REBOOT request, and probe the address with ARP at the same
+ * time.  Returns pdTRUE when the request was sent.
+ */
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	static BaseType_t prvSendInitRebootRequest( void );
+#endif
+
+/*
+ * The cached lease has been acknowledged.  Use it when the ARP probe has had
+ * no answer during dhcpLEASE_PROBE_PERIOD, or start a discovery when another
+ * device answered.
+ */
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	static void prvCheckLeaseProbe( void );
+#endif
+
 /*
  * Creates the part of outgoing DHCP messages that are common to all outgoing
  * DHCP messages.
@@ -258,6 +306,7 @@ BaseType_t xReturn;
 void vDHCPProcess( BaseType_t xReset )
 {
 BaseType_t xGivingUp = pdFALSE;
+TickType_t xMaxTxPeriod;
 #if( ipconfigUSE_DHCP_HOOK != 0 )
 	eDHCPCallbackAnswer_t eAnswer;
 #endif	/* ipconfigUSE_DHCP_HOOK */
@@ -266,6 +315,12 @@ BaseType_t xGivingUp = pdFALSE;
 	if( xReset != pdFALSE )
 	{
 		xDHCPData.eDHCPState = eWaitingSendFirstDiscover;
+
+		#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+		{
+			xDHCPData.xUseCachedLease = pdTRUE;
+		}
+		#endif
 	}
 
 	switch( xDHCPData.eDHCPState )
@@ -294,6 +349,17 @@ BaseType_t xGivingUp = pdFALSE;
 				if( xDHCPData.xDHCPSocket != NULL )
 				{
 					xDHCPData.xDHCPTxTime = xTaskGetTickCount();
+
+					#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+					{
+						if( prvSendInitRebootRequest() != pdFALSE )
+						{
+							xDHCPData.eDHCPState = eWaitingAcknowledge;
+							break;
+						}
+					}
+					#endif
+
 					prvSendDHCPDiscover( );
 					xDHCPData.eDHCPState = eWaitingOffer;
 				}
@@ -319,6 +385,15 @@ BaseType_t xGivingUp = pdFALSE;
 			/* Look for offers coming in. */
 			if( prvProcessDHCPReplies( dhcpMESSAGE_TYPE_OFFER ) == pdPASS )
 			{
+			#if( ipconfigDHCP_RAPID_COMMIT != 0 )
+				if( xDHCPData.xRapidCommit != pdFALSE )
+				{
+					/* The server has committed the lease right away. */
+					prvDHCPLeaseAcquired();
+					break;
+				}
+			#endif	/* ipconfigDHCP_RAPID_COMMIT */
+
 			#if( ipconfigUSE_DHCP_HOOK != 0 )
 				/* Ask the user if a DHCP request is required. */
 				eAnswer = xApplicationDHCPHook( eDHCPPhasePreRequest, xDHCPData.ulOfferedIPAddress );
@@ -393,47 +468,33 @@ BaseType_t xGivingUp = pdFALSE;
 
 		case eWaitingAcknowledge :
 
-			/* Look for acks coming in. */
-			if( prvProcessDHCPReplies( dhcpMESSAGE_TYPE_ACK ) == pdPASS )
+			#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
 			{
-				FreeRTOS_debug_printf( ( "vDHCPProcess: acked %lxip\n", FreeRTOS_ntohl( xDHCPData.ulOfferedIPAddress ) ) );
-
-				/* DHCP completed.  The IP address can now be used, and the
-				timer set to the lease timeout time. */
-				*ipLOCAL_IP_ADDRESS_POINTER = xDHCPData.ulOfferedIPAddress;
-
-				/* Setting the 'local' broadcast address, something like
-				'192.168.1.255'. */
-				xNetworkAddressing.ulBroadcastAddress = ( xDHCPData.ulOfferedIPAddress & xNetworkAddressing.ulNetMask ) |  ~xNetworkAddressing.ulNetMask;
-				xDHCPData.eDHCPState = eLeasedAddress;
-
-				iptraceDHCP_SUCCEDEED( xDHCPData.ulOfferedIPAddress );
-
-				/* DHCP failed, the default configured IP-address will be used
-				Now call vIPNetworkUpCalls() to send the network-up event and
-				start the ARP timer. */
-				vIPNetworkUpCalls( );
-
-				/* Close socket to ensure packets don't queue on it. */
-				vSocketClose( xDHCPData.xDHCPSocket );
-				xDHCPData.xDHCPSocket = NULL;
-
-				if( xDHCPData.ulLeaseTime == 0UL )
+				if( ( xDHCPData.xInitReboot != pdFALSE ) && ( xARPHadIPClash != pdFALSE ) )
 				{
-					xDHCPData.ulLeaseTime = dhcpDEFAULT_LEASE_TIME;
+					/* Another device answered the ARP probe: the cached
+					address is in use.  Start again with a discover. */
+					FreeRTOS_debug_printf( ( "vDHCPProcess: cached %lxip is in use\n", FreeRTOS_ntohl( xDHCPData.ulOfferedIPAddress ) ) );
+					xDHCPData.eDHCPState = eWaitingSendFirstDiscover;
+					break;
 				}
-				else if( xDHCPData.ulLeaseTime < dhcpMINIMUM_LEASE_TIME )
+			}
+			#endif
+
+			/* Look for acks coming in. */
+			if( prvProcessDHCPReplies( dhcpMESSAGE_TYPE_ACK ) == pdPASS )
+			{
+				#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+				if( xDHCPData.xInitReboot != pdFALSE )
 				{
-					xDHCPData.ulLeaseTime = dhcpMINIMUM_LEASE_TIME;
+					xDHCPData.eDHCPState = eWaitingProbe;
+					prvCheckLeaseProbe();
 				}
 				else
+				#endif
 				{
-					/* The lease time is already valid. */
+					prvDHCPLeaseAcquired();
 				}
-
-				/* Check for clashes. */
-				vARPSendGratuitous();
-				vIPReloadDHCPTimer( xDHCPData.ulLeaseTime );
 			}
 			else
 			{
@@ -443,11 +504,32 @@ BaseType_t xGivingUp = pdFALSE;
 					/* Increase the time period, and if it has not got to the
 					point of giving up - send another request. */
 					xDHCPData.xDHCPTxPeriod <<= 1;
+					xMaxTxPeriod = ipconfigMAXIMUM_DISCOVER_TX_PERIOD;
 
-					if( xDHCPData.xDHCPTxPeriod <= ipconfigMAXIMUM_DISCOVER_TX_PERIOD )
+					#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+					{
+						if( xDHCPData.xInitReboot != pdFALSE )
+						{
+							/* Don't wait long for the cached lease. */
+							xMaxTxPeriod = dhcpMAX_INIT_REBOOT_TX_PERIOD;
+						}
+					}
+					#endif
+
+					if( xDHCPData.xDHCPTxPeriod <= xMaxTxPeriod )
 					{
 						xDHCPData.xDHCPTxTime = xTaskGetTickCount();
 						prvSendDHCPRequest( );
+
+						#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+						{
+							if( xDHCPData.xInitReboot != pdFALSE )
+							{
+								/* Probe again along with the request. */
+								vARPProbeAddress( xDHCPData.ulOfferedIPAddress );
+							}
+						}
+						#endif
 					}
 					else
 					{
@@ -458,6 +540,12 @@ BaseType_t xGivingUp = pdFALSE;
 			}
 			break;
 
+	#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+		case eWaitingProbe :
+			prvCheckLeaseProbe();
+			break;
+	#endif	/* ipconfigDHCP_USE_LEASE_CACHE */
+
 	#if( ipconfigDHCP_FALL_BACK_AUTO_IP != 0 )
 		case eGetLinkLayerAddress:
 			if( ( xTaskGetTickCount() - xDHCPData.xDHCPTxTime ) > xDHCPData.xDHCPTxPeriod )
@@ -545,6 +633,131 @@ BaseType_t xGivingUp = pdFALSE;
 }
 /*-----------------------------------------------------------*/
 
+static void prvDHCPLeaseAcquired( void )
+{
+	FreeRTOS_debug_printf( ( "vDHCPProcess: acked %lxip\n", FreeRTOS_ntohl( xDHCPData.ulOfferedIPAddress ) ) );
+
+	/* DHCP completed.  The IP address can now be used, and the
+	timer set to the lease timeout time. */
+	*ipLOCAL_IP_ADDRESS_POINTER = xDHCPData.ulOfferedIPAddress;
+
+	/* Setting the 'local' broadcast address, something like
+	'192.168.1.255'. */
+	xNetworkAddressing.ulBroadcastAddress = ( xDHCPData.ulOfferedIPAddress & xNetworkAddressing.ulNetMask ) |  ~xNetworkAddressing.ulNetMask;
+	xDHCPData.eDHCPState = eLeasedAddress;
+
+	iptraceDHCP_SUCCEDEED( xDHCPData.ulOfferedIPAddress );
+
+	#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	{
+	DHCPLease_t xLease;
+
+		/* Hand the lease to the application, so it can be asked for again
+		after the next reset. */
+		xLease.ulIPAddress = xDHCPData.ulOfferedIPAddress;
+		xLease.ulDHCPServerAddress = xDHCPData.ulDHCPServerAddress;
+		vApplicationDHCPStoreLease( &xLease );
+		xDHCPData.xInitReboot = pdFALSE;
+		vARPProbeAddress( 0UL );
+	}
+	#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+
+	/* DHCP failed, the default configured IP-address will be used
+	Now call vIPNetworkUpCalls() to send the network-up event and
+	start the ARP timer. */
+	vIPNetworkUpCalls( );
+
+	/* Close socket to ensure packets don't queue on it. */
+	vSocketClose( xDHCPData.xDHCPSocket );
+	xDHCPData.xDHCPSocket = NULL;
+
+	if( xDHCPData.ulLeaseTime == 0UL )
+	{
+		xDHCPData.ulLeaseTime = dhcpDEFAULT_LEASE_TIME;
+	}
+	else if( xDHCPData.ulLeaseTime < dhcpMINIMUM_LEASE_TIME )
+	{
+		xDHCPData.ulLeaseTime = dhcpMINIMUM_LEASE_TIME;
+	}
+	else
+	{
+		/* The lease time is already valid. */
+	}
+
+	/* Check for clashes.  The gratuitous ARP is sent while the address is
+	already in use, the network-up event is not delayed by probing. */
+	vARPSendGratuitous();
+	vIPReloadDHCPTimer( xDHCPData.ulLeaseTime );
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+
+	static BaseType_t prvSendInitRebootRequest( void )
+	{
+	DHCPLease_t xLease;
+	BaseType_t xReturn = pdFALSE;
+
+		xDHCPData.xInitReboot = pdFALSE;
+		vARPProbeAddress( 0UL );
+
+		if( xDHCPData.xUseCachedLease != pdFALSE )
+		{
+			xDHCPData.xUseCachedLease = pdFALSE;
+
+			if( ( xApplicationDHCPLoadLease( &xLease ) != pdFALSE ) && ( xLease.ulIPAddress != 0UL ) )
+			{
+				/* RFC 2131 INIT-REBOOT: broadcast a request for the cached
+				address, without a server identifier.  Any server that knows
+				the lease may answer with an ACK or a NAK. */
+				xDHCPData.ulOfferedIPAddress = xLease.ulIPAddress;
+				xDHCPData.ulDHCPServerAddress = 0UL;
+				xDHCPData.xDHCPTxPeriod = dhcpINIT_REBOOT_TX_PERIOD;
+				xDHCPData.xInitReboot = pdTRUE;
+
+				FreeRTOS_debug_printf( ( "vDHCPProcess: init-reboot %lxip\n", FreeRTOS_ntohl( xLease.ulIPAddress ) ) );
+				prvSendDHCPRequest( );
+
+				/* While the request is outstanding, probe the address to
+				see if another device is using it. */
+				xARPHadIPClash = pdFALSE;
+				xDHCPData.xProbeTime = xTaskGetTickCount();
+				vARPProbeAddress( xLease.ulIPAddress );
+				xReturn = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+
+	static void prvCheckLeaseProbe( void )
+	{
+		if( xARPHadIPClash != pdFALSE )
+		{
+			/* Another device answered the ARP probe: the cached address is
+			in use.  Start again with a discover. */
+			FreeRTOS_debug_printf( ( "vDHCPProcess: cached %lxip is in use\n", FreeRTOS_ntohl( xDHCPData.ulOfferedIPAddress ) ) );
+			xDHCPData.eDHCPState = eWaitingSendFirstDiscover;
+		}
+		else if( ( xTaskGetTickCount() - xDHCPData.xProbeTime ) >= dhcpLEASE_PROBE_PERIOD )
+		{
+			prvDHCPLeaseAcquired();
+		}
+		else
+		{
+			/* Keep on watching the ARP traffic, the DHCP timer will call
+			again. */
+		}
+	}
+
+#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+/*-----------------------------------------------------------*/
+
 static void prvCreateDHCPSocket( void )
 {
 struct freertos_sockaddr xAddress;
@@ -619,6 +832,12 @@ uint8_t *pucByte, ucOptionCode, ucLength;
 uint32_t ulProcessed, ulParameter;
 BaseType_t xReturn = pdFALSE;
 const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct DHCP message type must be present in the options. */
+#if( ipconfigDHCP_RAPID_COMMIT != 0 )
+	BaseType_t xAckInsteadOfOffer = pdFALSE;
+	BaseType_t xHasRapidCommit = pdFALSE;
+
+	xDHCPData.xRapidCommit = pdFALSE;
+#endif
 
 	lBytes = FreeRTOS_recvfrom( xDHCPData.xDHCPSocket, ( void * ) &pucUDPPayload, 0ul, FREERTOS_ZERO_COPY, &xClient, &xClientLength );
 
@@ -712,6 +931,15 @@ const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct
 									xDHCPData.eDHCPState = eWaitingSendFirstDiscover;
 								}
 							}
+						#if( ipconfigDHCP_RAPID_COMMIT != 0 )
+							else if( ( *pucByte == ( uint8_t ) dhcpMESSAGE_TYPE_ACK ) &&
+									 ( xExpectedMessageType == ( BaseType_t ) dhcpMESSAGE_TYPE_OFFER ) )
+							{
+								/* Accepted only if the rapid-commit option is
+								present as well. */
+								xAckInsteadOfOffer = pdTRUE;
+							}
+						#endif /* ipconfigDHCP_RAPID_COMMIT */
 							else
 							{
 								/* Don't process other message types. */
@@ -761,6 +989,15 @@ const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct
 									{
 										ulProcessed++;
 									}
+								#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+									else if( xDHCPData.xInitReboot != pdFALSE )
+									{
+										/* The INIT-REBOOT request was not sent
+										to a particular server. */
+										ulProcessed++;
+										xDHCPData.ulDHCPServerAddress = ulParameter;
+									}
+								#endif /* ipconfigDHCP_USE_LEASE_CACHE */
 								}
 							}
 							break;
@@ -786,6 +1023,13 @@ const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct
 							}
 							break;
 
+					#if( ipconfigDHCP_RAPID_COMMIT != 0 )
+						case dhcpRAPID_COMMIT_OPTION_CODE :
+
+							xHasRapidCommit = pdTRUE;
+							break;
+					#endif /* ipconfigDHCP_RAPID_COMMIT */
+
 						default :
 
 							/* Not interested in this field. */
@@ -793,8 +1037,9 @@ const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct
 							break;
 					}
 
-					/* Jump over the data to find the next option code. */
-					if( ucLength == 0u )
+					/* Jump over the data to find the next option code.  The
+					rapid-commit option is the only one without data. */
+					if( ( ucLength == 0u ) && ( ucOptionCode != dhcpRAPID_COMMIT_OPTION_CODE ) )
 					{
 						break;
 					}
@@ -804,6 +1049,17 @@ const uint32_t ulMandatoryOptions = 2ul; /* DHCP server address, and the correct
 					}
 				}
 
+				#if( ipconfigDHCP_RAPID_COMMIT != 0 )
+				{
+					if( ( xAckInsteadOfOffer != pdFALSE ) && ( xHasRapidCommit != pdFALSE ) )
+					{
+						/* RFC 4039: the ACK takes the place of the offer. */
+						ulProcessed++;
+						xDHCPData.xRapidCommit = pdTRUE;
+					}
+				}
+				#endif /* ipconfigDHCP_RAPID_COMMIT */
+
 				/* Were all the mandatory options received? */
 				if( ulProcessed >= ulMandatoryOptions )
 				{
@@ -910,17 +1166,41 @@ static const uint8_t ucDHCPRequestOptions[] =
 	dhcpSERVER_IP_ADDRESS_OPTION_CODE, 4, 0, 0, 0, 0,				/* The IP address of the DHCP server. */
 	dhcpOPTION_END_BYTE
 };
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	/* An INIT-REBOOT request must not contain a server identifier. */
+	static const uint8_t ucDHCPInitRebootOptions[] =
+	{
+		dhcpMESSAGE_TYPE_OPTION_CODE, 1, dhcpMESSAGE_TYPE_REQUEST,		/* Message type option. */
+		dhcpCLIENT_IDENTIFIER_OPTION_CODE, 7, 1, 0, 0, 0, 0, 0, 0,			/* Client identifier. */
+		dhcpREQUEST_IP_ADDRESS_OPTION_CODE, 4, 0, 0, 0, 0,				/* The IP address being requested. */
+		dhcpOPTION_END_BYTE
+	};
+#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+const uint8_t *pucOptionsArray = ucDHCPRequestOptions;
 size_t xOptionsLength = sizeof( ucDHCPRequestOptions );
 
-	pucUDPPayloadBuffer = prvCreatePartDHCPMessage( &xAddress, dhcpREQUEST_OPCODE, ucDHCPRequestOptions, &xOptionsLength );
+	#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	{
+		if( xDHCPData.xInitReboot != pdFALSE )
+		{
+			pucOptionsArray = ucDHCPInitRebootOptions;
+			xOptionsLength = sizeof( ucDHCPInitRebootOptions );
+		}
+	}
+	#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+
+	pucUDPPayloadBuffer = prvCreatePartDHCPMessage( &xAddress, dhcpREQUEST_OPCODE, pucOptionsArray, &xOptionsLength );
 
 	/* Copy in the IP address being requested. */
 	memcpy( ( void * ) &( pucUDPPayloadBuffer[ dhcpFIRST_OPTION_BYTE_OFFSET + dhcpREQUESTED_IP_ADDRESS_OFFSET ] ),
 		( void * ) &( xDHCPData.ulOfferedIPAddress ), sizeof( xDHCPData.ulOfferedIPAddress ) );
 
-	/* Copy in the address of the DHCP server being used. */
-	memcpy( ( void * ) &( pucUDPPayloadBuffer[ dhcpFIRST_OPTION_BYTE_OFFSET + dhcpDHCP_SERVER_IP_ADDRESS_OFFSET ] ),
-		( void * ) &( xDHCPData.ulDHCPServerAddress ), sizeof( xDHCPData.ulDHCPServerAddress ) );
+	if( pucOptionsArray == ucDHCPRequestOptions )
+	{
+		/* Copy in the address of the DHCP server being used. */
+		memcpy( ( void * ) &( pucUDPPayloadBuffer[ dhcpFIRST_OPTION_BYTE_OFFSET + dhcpDHCP_SERVER_IP_ADDRESS_OFFSET ] ),
+			( void * ) &( xDHCPData.ulDHCPServerAddress ), sizeof( xDHCPData.ulDHCPServerAddress ) );
+	}
 
 	FreeRTOS_debug_printf( ( "vDHCPProcess: reply %lxip\n", FreeRTOS_ntohl( xDHCPData.ulOfferedIPAddress ) ) );
 	iptraceSENDING_DHCP_REQUEST();
@@ -945,6 +1225,9 @@ static const uint8_t ucDHCPDiscoverOptions[] =
 	dhcpMESSAGE_TYPE_OPTION_CODE, 1, dhcpMESSAGE_TYPE_DISCOVER,					/* Message type option. */
 	dhcpCLIENT_IDENTIFIER_OPTION_CODE, 7, 1, 0, 0, 0, 0, 0, 0,						/* Client identifier. */
 	dhcpPARAMETER_REQUEST_OPTION_CODE, 3, dhcpSUBNET_MASK_OPTION_CODE, dhcpGATEWAY_OPTION_CODE, dhcpDNS_SERVER_OPTIONS_CODE,	/* Parameter request option. */
+#if( ipconfigDHCP_RAPID_COMMIT != 0 )
+	dhcpRAPID_COMMIT_OPTION_CODE, 0,											/* Rapid commit option. */
+#endif
 	dhcpOPTION_END_BYTE
 };
 size_t xOptionsLength = sizeof( ucDHCPDiscoverOptions );
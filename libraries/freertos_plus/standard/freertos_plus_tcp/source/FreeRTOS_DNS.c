@@ -52,12 +52,14 @@
 	#define dnsOUTGOING_FLAGS		0x0001u     /* Standard query. */
 	#define dnsRX_FLAGS_MASK		0x0f80u     /* The bits of interest in the flags field of incoming DNS messages. */
 	#define dnsEXPECTED_RX_FLAGS	0x0080u     /* Should be a response, without any errors. */
+	#define dnsNXDOMAIN_RX_FLAGS	0x0380u     /* A response, the name does not exist. */
 #else
 	#define dnsDNS_PORT				0x0035u
 	#define dnsONE_QUESTION			0x0001u
 	#define dnsOUTGOING_FLAGS		0x0100u     /* Standard query. */
 	#define dnsRX_FLAGS_MASK		0x800fu     /* The bits of interest in the flags field of incoming DNS messages. */
 	#define dnsEXPECTED_RX_FLAGS	0x8000u     /* Should be a response, without any errors. */
+	#define dnsNXDOMAIN_RX_FLAGS	0x8003u     /* A response, the name does not exist. */
 
 #endif /* ipconfigBYTE_ORDER */
 
@@ -100,12 +102,65 @@ the query will be responded to with these flags: */
 type. */
 #define dnsPARSE_ERROR						 0uL
 
+/* Return values of a look-up in the DNS cache. */
+#define dnsCACHE_MISS						 0
+#define dnsCACHE_HIT						 1
+#define dnsCACHE_HIT_REFRESH				 2	/* A hit, but the record should be refreshed. */
+
+/* A cached record will be refreshed when less than 1/8 of its TTL remains. */
+#define dnsCACHE_REFRESH_DIVISOR			 8u
+
+/* The states of an entry in xDNSQueries[]. */
+#define dnsQUERY_FREE						 0u
+#define dnsQUERY_PENDING					 1u
+#define dnsQUERY_ANSWERED					 2u
+
+/* All tasks that are waiting for a DNS reply read from the same socket.  A
+reply may be received by another task than the one that is waiting for it.
+Therefore the waiting tasks will block for a short time only, and check
+xDNSQueries[] for their answer. */
+#define dnsPOLL_TICKS						 ( ( pdMS_TO_TICKS( 10u ) > 0u ) ? pdMS_TO_TICKS( 10u ) : ( TickType_t ) 1u )
+
 /*
  * Create a socket and bind it to the standard DNS port number.  Return the
  * the created socket - or NULL if the socket could not be created or bound.
  */
 static Socket_t prvCreateDNSSocket( void );
 
+/*
+ * Return the socket that is shared by all DNS requests, create it when
+ * necessary.  Returns NULL if the socket could not be created.
+ */
+static Socket_t prvGetDNSSocket( void );
+
+/*
+ * Create a DNS request for 'pcHostName' and send it to the DNS server, or
+ * to the LLMNR multicast address.  Returns pdTRUE if the request was sent.
+ */
+static BaseType_t prvSendDNSRequest( Socket_t xSocket,
+									 const char *pcHostName,
+									 TickType_t uxIdentifier );
+
+/*
+ * Register a request in xDNSQueries[].  When a request for the same name is
+ * already outstanding, the caller will wait for that request, and
+ * '*pxMustSend' will be set to pdFALSE.  Returns the index of the entry, or -1
+ * when there is no free entry.
+ */
+static BaseType_t prvDNSQueryStart( const char *pcHostName,
+									TickType_t uxIdentifier,
+									BaseType_t xIsRefresh,
+									BaseType_t *pxMustSend );
+
+/*
+ * Read the replies that were received by the shared DNS socket, and store the
+ * answers in xDNSQueries[] and in the DNS cache.  With 'xFlags' equal to
+ * FREERTOS_MSG_DONTWAIT all queued replies are processed without blocking,
+ * otherwise at most one reply is read, blocking up to dnsPOLL_TICKS.
+ */
+static void prvReceiveDNSReplies( Socket_t xSocket,
+								  BaseType_t xFlags );
+
 /*
  * Create the DNS message in the zero copy buffer passed in the first parameter.
  */
@@ -159,27 +214,81 @@ static uint32_t prvGetHostByName( const char *pcHostName,
 #endif /* ipconfigUSE_DNS_CACHE || ipconfigDNS_USE_CALLBACKS */
 
 #if( ipconfigUSE_DNS_CACHE == 1 )
-	static void prvProcessDNSCache( const char *pcName,
-									uint32_t *pulIP,
-									uint32_t ulTTL,
-									BaseType_t xLookUp );
+	/*
+	 * Look-up (xLookUp = pdTRUE) or add/update (xLookUp = pdFALSE) a name in
+	 * the DNS cache.  An IP address of zero is stored as a negative entry.
+	 * Returns one of dnsCACHE_MISS, dnsCACHE_HIT, or dnsCACHE_HIT_REFRESH.
+	 */
+	static BaseType_t prvProcessDNSCache( const char *pcName,
+										  uint32_t *pulIP,
+										  uint32_t ulTTL,
+										  BaseType_t xLookUp );
+
+	/*
+	 * Look-up a name in the DNS cache, after processing the replies that are
+	 * waiting in the shared DNS socket.  Starts a refresh of a record that is
+	 * about to expire.  Returns pdTRUE for a positive or a negative hit.
+	 */
+	static BaseType_t prvLookUpDNSCache( const char *pcHostName,
+										 uint32_t *pulIP );
+
+	/*
+	 * Calculate the FNV-1a hash of a host name.
+	 */
+	static uint32_t prvDNSNameHash( const char *pcName );
+
+	/*
+	 * Remove a row from its hash bucket and mark it as unused.
+	 */
+	static void prvDNSCacheRemove( BaseType_t xIndex );
 
 	typedef struct xDNS_CACHE_TABLE_ROW
 	{
-		uint32_t ulIPAddress;                         /* The IP address of an ARP cache entry. */
+		uint32_t ulIPAddress;                         /* The IP address of the host, or zero for a negative entry. */
 		char pcName[ ipconfigDNS_CACHE_NAME_LENGTH ]; /* The name of the host */
-		uint32_t ulTTL;                               /* Time-to-Live (in seconds) from the DNS server. */
+		uint32_t ulTTL;                               /* Time-to-Live (in seconds) from the DNS server, in host-endian order. */
 		uint32_t ulTimeWhenAddedInSeconds;
+		uint32_t ulHash;                              /* The hash of pcName. */
+		uint16_t usNext;                              /* The index plus one of the next row in the same bucket, or zero. */
+		uint8_t ucRefreshing;                         /* A new request has been sent for this name. */
 	} DNSCacheRow_t;
 
 	static DNSCacheRow_t xDNSCache[ ipconfigDNS_CACHE_ENTRIES ];
 
+	/* The index plus one of the first row in each bucket, or zero. */
+	static uint16_t usDNSCacheBuckets[ ipconfigDNS_CACHE_BUCKETS ];
+
 	void FreeRTOS_dnsclear()
 	{
-		memset( xDNSCache, 0x0, sizeof( xDNSCache ) );
+		vTaskSuspendAll();
+		{
+			memset( xDNSCache, 0x0, sizeof( xDNSCache ) );
+			memset( usDNSCacheBuckets, 0x0, sizeof( usDNSCacheBuckets ) );
+		}
+		xTaskResumeAll();
 	}
 #endif /* ipconfigUSE_DNS_CACHE == 1 */
 
+/* The outstanding DNS requests. */
+typedef struct xDNS_QUERY
+{
+	TickType_t uxIdentifier;	/* The identifier of the request. */
+	TickType_t xLastSendTime;	/* The time at which the request was last sent. */
+	uint32_t ulIPAddress;		/* The answer, valid in the state dnsQUERY_ANSWERED. */
+	uint8_t ucState;			/* dnsQUERY_FREE, dnsQUERY_PENDING or dnsQUERY_ANSWERED. */
+	uint8_t ucWaiters;			/* The number of tasks waiting for the answer. */
+	uint8_t ucAttempts;			/* The number of times the request has been sent. */
+	#if( ipconfigUSE_DNS_CACHE == 1 )
+		uint32_t ulHash;		/* The hash of pcName. */
+		char pcName[ ipconfigDNS_CACHE_NAME_LENGTH ];	/* The name being looked-up, an empty string if it is too long. */
+	#endif
+} DNSQuery_t;
+
+static DNSQuery_t xDNSQueries[ ipconfigDNS_MAX_PARALLEL_QUERIES ];
+
+/* The socket that is shared by all DNS requests. */
+static Socket_t xDNSSocket = NULL;
+
 #if( ipconfigUSE_LLMNR == 1 )
 	const MACAddress_t xLLMNR_MacAdress = { { 0x01, 0x00, 0x5e, 0x00, 0x00, 0xfc } };
 #endif /* ipconfigUSE_LLMNR == 1 */
@@ -284,9 +393,50 @@ typedef struct xDNSAnswerRecord DNSAnswerRecord_t;
 	{
 	uint32_t ulIPAddress = 0uL;
 
-		prvProcessDNSCache( pcHostName, &ulIPAddress, 0, pdTRUE );
+		( void ) prvLookUpDNSCache( pcHostName, &ulIPAddress );
 		return ulIPAddress;
 	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvLookUpDNSCache( const char *pcHostName,
+										 uint32_t *pulIP )
+	{
+	BaseType_t xResult;
+	BaseType_t xMustSend;
+	BaseType_t xCanUseSocket;
+	uint32_t ulNumber;
+	TickType_t uxIdentifier;
+
+		/* The IP-task may not block on the socket. */
+		xCanUseSocket = ( ( xDNSSocket != NULL ) && ( xIsCallingFromIPTask() == pdFALSE ) ) ? pdTRUE : pdFALSE;
+
+		if( xCanUseSocket != pdFALSE )
+		{
+			/* Process the replies that came in while no task was waiting,
+			e.g. the answers to refresh requests. */
+			prvReceiveDNSReplies( xDNSSocket, FREERTOS_MSG_DONTWAIT );
+		}
+
+		xResult = prvProcessDNSCache( pcHostName, pulIP, 0, pdTRUE );
+
+		if( xResult == dnsCACHE_HIT_REFRESH )
+		{
+			/* The record is about to expire: send a new request, but do not
+			wait for the reply. */
+			if( ( xCanUseSocket != pdFALSE ) && ( xApplicationGetRandomNumber( &( ulNumber ) ) != pdFALSE ) )
+			{
+				uxIdentifier = ( TickType_t ) ( ulNumber & 0xffffu );
+
+				if( ( prvDNSQueryStart( pcHostName, uxIdentifier, pdTRUE, &xMustSend ) >= 0 ) && ( xMustSend != pdFALSE ) )
+				{
+					FreeRTOS_debug_printf( ( "prvLookUpDNSCache: refresh '%s'\n", pcHostName ) );
+					( void ) prvSendDNSRequest( xDNSSocket, pcHostName, uxIdentifier );
+				}
+			}
+		}
+
+		return ( xResult != dnsCACHE_MISS ) ? pdTRUE : pdFALSE;
+	}
 #endif /* ipconfigUSE_DNS_CACHE == 1 */
 /*-----------------------------------------------------------*/
 
@@ -472,6 +622,7 @@ uint32_t ulIPAddress = 0uL;
 TickType_t uxReadTimeOut_ticks = ipconfigDNS_RECEIVE_BLOCK_TIME_TICKS;
 TickType_t uxIdentifier = 0u;
 BaseType_t xHasRandom = pdFALSE;
+BaseType_t xCacheHit = pdFALSE;
 
 	if( pcHostName != NULL )
 	{
@@ -489,10 +640,11 @@ BaseType_t xHasRandom = pdFALSE;
 		{
 			if( ulIPAddress == 0uL )
 			{
-				ulIPAddress = FreeRTOS_dnslookup( pcHostName );
+				xCacheHit = prvLookUpDNSCache( pcHostName, &ulIPAddress );
 
-				if( ulIPAddress != 0 )
+				if( xCacheHit != pdFALSE )
 				{
+					/* A negative hit returns zero without sending a request. */
 					FreeRTOS_debug_printf( ( "FreeRTOS_gethostbyname: found '%s' in cache: %lxip\n", pcHostName, ulIPAddress ) );
 				}
 				else
@@ -504,7 +656,7 @@ BaseType_t xHasRandom = pdFALSE;
 		#endif /* ipconfigUSE_DNS_CACHE == 1 */
 
 		/* Generate a unique identifier. */
-		if( ulIPAddress == 0uL )
+		if( ( ulIPAddress == 0uL ) && ( xCacheHit == pdFALSE ) )
 		{
 		uint32_t ulNumber;
 
@@ -518,7 +670,7 @@ BaseType_t xHasRandom = pdFALSE;
 		{
 			if( pCallback != NULL )
 			{
-				if( ulIPAddress == 0uL )
+				if( ( ulIPAddress == 0uL ) && ( xCacheHit == pdFALSE ) )
 				{
 					/* The user has provided a callback function, so do not block on recvfrom() */
 					if( xHasRandom != pdFALSE )
@@ -529,14 +681,15 @@ BaseType_t xHasRandom = pdFALSE;
 				}
 				else
 				{
-					/* The IP address is known, do the call-back now. */
+					/* The IP address is known, or it is known not to exist,
+					do the call-back now. */
 					pCallback( pcHostName, pvSearchID, ulIPAddress );
 				}
 			}
 		}
 		#endif /* if ( ipconfigDNS_USE_CALLBACKS == 1 ) */
 
-		if( ( ulIPAddress == 0uL ) && ( xHasRandom != pdFALSE ) )
+		if( ( ulIPAddress == 0uL ) && ( xCacheHit == pdFALSE ) && ( xHasRandom != pdFALSE ) )
 		{
 			ulIPAddress = prvGetHostByName( pcHostName, uxIdentifier, uxReadTimeOut_ticks );
 		}
@@ -549,15 +702,123 @@ static uint32_t prvGetHostByName( const char *pcHostName,
 								  TickType_t uxIdentifier,
 								  TickType_t uxReadTimeOut_ticks )
 {
-struct freertos_sockaddr xAddress;
-Socket_t xDNSSocket;
+Socket_t xSocket;
 uint32_t ulIPAddress = 0uL;
+BaseType_t xIndex, xMustSend, xDone, xResend;
+DNSQuery_t *pxQuery;
+TickType_t uxWriteTimeOut_ticks = ipconfigDNS_SEND_BLOCK_TIME_TICKS;
+
+	if( uxReadTimeOut_ticks == 0u )
+	{
+		/* This DNS lookup is asynchronous, using a call-back: send the
+		request only once, from a private socket.  The reply will come in after
+		the socket has been closed, and it will be handled by
+		ulDNSHandlePacket(). */
+		xSocket = prvCreateDNSSocket();
+
+		if( xSocket != NULL )
+		{
+			FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, ( void * ) &uxWriteTimeOut_ticks, sizeof( TickType_t ) );
+			( void ) prvSendDNSRequest( xSocket, pcHostName, uxIdentifier );
+
+			/* Finished with the socket. */
+			FreeRTOS_closesocket( xSocket );
+		}
+	}
+	else
+	{
+		xSocket = prvGetDNSSocket();
+
+		if( xSocket != NULL )
+		{
+			xIndex = prvDNSQueryStart( pcHostName, uxIdentifier, pdFALSE, &xMustSend );
+
+			if( xIndex < 0 )
+			{
+				FreeRTOS_debug_printf( ( "prvGetHostByName: too many outstanding requests, '%s' not looked-up\n", pcHostName ) );
+			}
+			else
+			{
+				pxQuery = &( xDNSQueries[ xIndex ] );
+
+				if( xMustSend != pdFALSE )
+				{
+					( void ) prvSendDNSRequest( xSocket, pcHostName, uxIdentifier );
+				}
+
+				for( ;; )
+				{
+					xDone = pdFALSE;
+					xResend = pdFALSE;
+
+					/* Wait for a reply.  The reply may also be received by
+					another task that is waiting on the same socket. */
+					prvReceiveDNSReplies( xSocket, 0 );
+
+					vTaskSuspendAll();
+					{
+						if( pxQuery->ucState == dnsQUERY_ANSWERED )
+						{
+							ulIPAddress = pxQuery->ulIPAddress;
+							xDone = pdTRUE;
+						}
+						else if( ( xTaskGetTickCount() - pxQuery->xLastSendTime ) >= uxReadTimeOut_ticks )
+						{
+							if( ( UBaseType_t ) pxQuery->ucAttempts < ( UBaseType_t ) ipconfigDNS_REQUEST_ATTEMPTS )
+							{
+								/* Send the request again, this task takes
+								care of it. */
+								pxQuery->ucAttempts++;
+								pxQuery->xLastSendTime = xTaskGetTickCount();
+								uxIdentifier = pxQuery->uxIdentifier;
+								xResend = pdTRUE;
+							}
+							else
+							{
+								xDone = pdTRUE;
+							}
+						}
+
+						if( xDone != pdFALSE )
+						{
+							/* The last task leaving will free the entry. */
+							pxQuery->ucWaiters--;
+
+							if( pxQuery->ucWaiters == 0u )
+							{
+								pxQuery->ucState = dnsQUERY_FREE;
+							}
+						}
+					}
+					xTaskResumeAll();
+
+					if( xDone != pdFALSE )
+					{
+						break;
+					}
+
+					if( xResend != pdFALSE )
+					{
+						( void ) prvSendDNSRequest( xSocket, pcHostName, uxIdentifier );
+					}
+				}
+			}
+		}
+	}
+
+	return ulIPAddress;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendDNSRequest( Socket_t xSocket,
+									 const char *pcHostName,
+									 TickType_t uxIdentifier )
+{
+struct freertos_sockaddr xAddress;
+uint32_t ulDNSServerAddress;
 uint8_t *pucUDPPayloadBuffer;
-uint32_t ulAddressLength = sizeof( struct freertos_sockaddr );
-BaseType_t xAttempt;
-int32_t lBytes;
 size_t uxPayloadLength, uxExpectedPayloadLength;
-TickType_t uxWriteTimeOut_ticks = ipconfigDNS_SEND_BLOCK_TIME_TICKS;
+BaseType_t xReturn = pdFALSE;
 
 #if( ipconfigUSE_LLMNR == 1 )
 	BaseType_t bHasDot = pdFALSE;
@@ -584,113 +845,264 @@ TickType_t uxWriteTimeOut_ticks = ipconfigDNS_SEND_BLOCK_TIME_TICKS;
 	subdomain part and the string end byte. */
 	uxExpectedPayloadLength = sizeof( DNSMessage_t ) + strlen( pcHostName ) + sizeof( uint16_t ) + sizeof( uint16_t ) + 2u;
 
-	xDNSSocket = prvCreateDNSSocket();
+	/* Get a buffer.  This uses a maximum delay, but the delay will be
+	capped to ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS so the return value
+	still needs to be tested. */
+	pucUDPPayloadBuffer = ( uint8_t * ) FreeRTOS_GetUDPPayloadBuffer( uxExpectedPayloadLength, portMAX_DELAY );
 
-	if( xDNSSocket != NULL )
+	if( pucUDPPayloadBuffer != NULL )
 	{
-		FreeRTOS_setsockopt( xDNSSocket, 0, FREERTOS_SO_SNDTIMEO, ( void * ) &uxWriteTimeOut_ticks, sizeof( TickType_t ) );
-		FreeRTOS_setsockopt( xDNSSocket, 0, FREERTOS_SO_RCVTIMEO, ( void * ) &uxReadTimeOut_ticks,  sizeof( TickType_t ) );
+		/* Create the message in the obtained buffer. */
+		uxPayloadLength = prvCreateDNSMessage( pucUDPPayloadBuffer, pcHostName, uxIdentifier );
+
+		iptraceSENDING_DNS_REQUEST();
 
-		for( xAttempt = 0; xAttempt < ipconfigDNS_REQUEST_ATTEMPTS; xAttempt++ )
+		/* Obtain the DNS server address. */
+		FreeRTOS_GetAddressConfiguration( NULL, NULL, NULL, &ulDNSServerAddress );
+
+		/* Send the DNS message. */
+#if( ipconfigUSE_LLMNR == 1 )
+		if( bHasDot == pdFALSE )
+		{
+			/* Use LLMNR addressing. */
+			( ( DNSMessage_t * ) pucUDPPayloadBuffer )->usFlags = 0;
+			xAddress.sin_addr = ipLLMNR_IP_ADDR; /* Is in network byte order. */
+			xAddress.sin_port = FreeRTOS_ntohs( ipLLMNR_PORT );
+		}
+		else
+#endif
 		{
-			/* Get a buffer.  This uses a maximum delay, but the delay will be
-			capped to ipconfigUDP_MAX_SEND_BLOCK_TIME_TICKS so the return value
-			still needs to be tested. */
-			pucUDPPayloadBuffer = ( uint8_t * ) FreeRTOS_GetUDPPayloadBuffer( uxExpectedPayloadLength, portMAX_DELAY );
+			/* Use DNS server. */
+			xAddress.sin_addr = ulDNSServerAddress;
+			xAddress.sin_port = dnsDNS_PORT;
+		}
 
-			if( pucUDPPayloadBuffer != NULL )
-			{
-				/* Create the message in the obtained buffer. */
-				uxPayloadLength = prvCreateDNSMessage( pucUDPPayloadBuffer, pcHostName, uxIdentifier );
+		if( FreeRTOS_sendto( xSocket, pucUDPPayloadBuffer, uxPayloadLength, FREERTOS_ZERO_COPY, &xAddress, sizeof( xAddress ) ) != 0 )
+		{
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			/* The message was not sent so the stack will not be
+			releasing the zero copy - it must be released here. */
+			FreeRTOS_ReleaseUDPPayloadBuffer( ( void * ) pucUDPPayloadBuffer );
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
 
-				iptraceSENDING_DNS_REQUEST();
+static Socket_t prvGetDNSSocket( void )
+{
+Socket_t xSocket;
+TickType_t uxWriteTimeOut_ticks = ipconfigDNS_SEND_BLOCK_TIME_TICKS;
+TickType_t uxReadTimeOut_ticks = dnsPOLL_TICKS;
 
-				/* Obtain the DNS server address. */
-				FreeRTOS_GetAddressConfiguration( NULL, NULL, NULL, &ulIPAddress );
+	if( xDNSSocket == NULL )
+	{
+		xSocket = prvCreateDNSSocket();
 
-				/* Send the DNS message. */
-#if( ipconfigUSE_LLMNR == 1 )
-				if( bHasDot == pdFALSE )
+		if( xSocket != NULL )
+		{
+			FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, ( void * ) &uxWriteTimeOut_ticks, sizeof( TickType_t ) );
+			FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, ( void * ) &uxReadTimeOut_ticks,  sizeof( TickType_t ) );
+
+			vTaskSuspendAll();
+			{
+				if( xDNSSocket == NULL )
 				{
-					/* Use LLMNR addressing. */
-					( ( DNSMessage_t * ) pucUDPPayloadBuffer )->usFlags = 0;
-					xAddress.sin_addr = ipLLMNR_IP_ADDR; /* Is in network byte order. */
-					xAddress.sin_port = FreeRTOS_ntohs( ipLLMNR_PORT );
+					xDNSSocket = xSocket;
+					xSocket = NULL;
 				}
-				else
+			}
+			xTaskResumeAll();
+
+			if( xSocket != NULL )
+			{
+				/* Another task has created the shared socket in the mean
+				time. */
+				FreeRTOS_closesocket( xSocket );
+			}
+		}
+	}
+
+	return xDNSSocket;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDNSQueryStart( const char *pcHostName,
+									TickType_t uxIdentifier,
+									BaseType_t xIsRefresh,
+									BaseType_t *pxMustSend )
+{
+BaseType_t x, xIndex = -1;
+DNSQuery_t *pxQuery;
+TickType_t xNow = xTaskGetTickCount();
+#if( ipconfigUSE_DNS_CACHE == 1 )
+	uint32_t ulHash = prvDNSNameHash( pcHostName );
+	BaseType_t xNameFits = ( strlen( pcHostName ) < ipconfigDNS_CACHE_NAME_LENGTH ) ? pdTRUE : pdFALSE;
 #endif
-				{
-					/* Use DNS server. */
-					xAddress.sin_addr = ulIPAddress;
-					xAddress.sin_port = dnsDNS_PORT;
-				}
 
-				ulIPAddress = 0uL;
+	*pxMustSend = pdFALSE;
 
-				if( FreeRTOS_sendto( xDNSSocket, pucUDPPayloadBuffer, uxPayloadLength, FREERTOS_ZERO_COPY, &xAddress, sizeof( xAddress ) ) != 0 )
+	vTaskSuspendAll();
+	{
+		#if( ipconfigUSE_DNS_CACHE == 1 )
+		{
+			/* Is the same name being looked-up already? */
+			if( xNameFits != pdFALSE )
+			{
+				for( x = 0; x < ipconfigDNS_MAX_PARALLEL_QUERIES; x++ )
 				{
-					/* Wait for the reply. */
-					lBytes = FreeRTOS_recvfrom( xDNSSocket, &pucUDPPayloadBuffer, 0, FREERTOS_ZERO_COPY, &xAddress, &ulAddressLength );
+					pxQuery = &( xDNSQueries[ x ] );
 
-					if( lBytes > 0 )
+					if( ( pxQuery->ucState == dnsQUERY_PENDING ) &&
+						( pxQuery->ulHash == ulHash ) &&
+						( strcmp( pxQuery->pcName, pcHostName ) == 0 ) )
 					{
-					BaseType_t xExpected;
-					DNSMessage_t *pxDNSMessageHeader = ( DNSMessage_t * ) pucUDPPayloadBuffer;
-
-						/* See if the identifiers match. */
-						if( uxIdentifier == ( TickType_t ) pxDNSMessageHeader->usIdentifier )
-						{
-							xExpected = pdTRUE;
-						}
-						else
+						if( xIsRefresh == pdFALSE )
 						{
-							/* The reply was not expected. */
-							xExpected = pdFALSE;
+							/* Wait for the same reply. */
+							pxQuery->ucWaiters++;
 						}
 
-						/* The reply was received.  Process it. */
-					#if( ipconfigDNS_USE_CALLBACKS == 0 )
-						/* It is useless to analyse the unexpected reply
-						unless asynchronous look-ups are enabled. */
-						if( xExpected != pdFALSE )
-					#endif /* ipconfigDNS_USE_CALLBACKS == 0 */
-						{
-							ulIPAddress = prvParseDNSReply( pucUDPPayloadBuffer, ( size_t ) lBytes, xExpected );
-						}
+						xIndex = x;
+						break;
+					}
+				}
+			}
+		}
+		#endif /* ipconfigUSE_DNS_CACHE */
 
-						/* Finished with the buffer.  The zero copy interface
-						is being used, so the buffer must be freed by the
-						task. */
-						FreeRTOS_ReleaseUDPPayloadBuffer( ( void * ) pucUDPPayloadBuffer );
+		if( xIndex < 0 )
+		{
+			for( x = 0; x < ipconfigDNS_MAX_PARALLEL_QUERIES; x++ )
+			{
+				pxQuery = &( xDNSQueries[ x ] );
+
+				/* An entry without waiting tasks belongs to a refresh
+				request.  It is freed when answered, or when it is too old. */
+				if( ( pxQuery->ucState == dnsQUERY_FREE ) ||
+					( ( pxQuery->ucWaiters == 0u ) &&
+					  ( ( pxQuery->ucState == dnsQUERY_ANSWERED ) ||
+						( ( xNow - pxQuery->xLastSendTime ) >= ipconfigDNS_RECEIVE_BLOCK_TIME_TICKS ) ) ) )
+				{
+					xIndex = x;
+					break;
+				}
+			}
 
-						if( ulIPAddress != 0uL )
-						{
-							/* All done. */
-							break;
-						}
+			if( xIndex >= 0 )
+			{
+				pxQuery = &( xDNSQueries[ xIndex ] );
+				pxQuery->uxIdentifier = uxIdentifier;
+				pxQuery->xLastSendTime = xNow;
+				pxQuery->ulIPAddress = 0uL;
+				pxQuery->ucState = dnsQUERY_PENDING;
+				pxQuery->ucWaiters = ( xIsRefresh != pdFALSE ) ? 0u : 1u;
+				pxQuery->ucAttempts = 1u;
+
+				#if( ipconfigUSE_DNS_CACHE == 1 )
+				{
+					pxQuery->ulHash = ulHash;
+
+					if( xNameFits != pdFALSE )
+					{
+						strcpy( pxQuery->pcName, pcHostName );
+					}
+					else
+					{
+						pxQuery->pcName[ 0 ] = '\0';
 					}
 				}
-				else
+				#endif /* ipconfigUSE_DNS_CACHE */
+
+				*pxMustSend = pdTRUE;
+			}
+		}
+	}
+	xTaskResumeAll();
+
+	return xIndex;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReceiveDNSReplies( Socket_t xSocket,
+								  BaseType_t xFlags )
+{
+struct freertos_sockaddr xAddress;
+uint32_t ulAddressLength = sizeof( struct freertos_sockaddr );
+uint8_t *pucUDPPayloadBuffer;
+int32_t lBytes;
+BaseType_t x, xIndex;
+TickType_t uxIdentifier;
+uint32_t ulIPAddress;
+
+	for( ;; )
+	{
+		lBytes = FreeRTOS_recvfrom( xSocket, &pucUDPPayloadBuffer, 0, FREERTOS_ZERO_COPY | xFlags, &xAddress, &ulAddressLength );
+
+		if( lBytes <= 0 )
+		{
+			break;
+		}
+
+		if( ( size_t ) lBytes >= sizeof( DNSMessage_t ) )
+		{
+			uxIdentifier = ( TickType_t ) ( ( DNSMessage_t * ) pucUDPPayloadBuffer )->usIdentifier;
+			xIndex = -1;
+			ulIPAddress = 0uL;
+
+			/* See if the reply was expected. */
+			vTaskSuspendAll();
+			{
+				for( x = 0; x < ipconfigDNS_MAX_PARALLEL_QUERIES; x++ )
 				{
-					/* The message was not sent so the stack will not be
-					releasing the zero copy - it must be released here. */
-					FreeRTOS_ReleaseUDPPayloadBuffer( ( void * ) pucUDPPayloadBuffer );
+					if( ( xDNSQueries[ x ].ucState == dnsQUERY_PENDING ) && ( xDNSQueries[ x ].uxIdentifier == uxIdentifier ) )
+					{
+						xIndex = x;
+						break;
+					}
 				}
 			}
+			xTaskResumeAll();
 
-			if( uxReadTimeOut_ticks == 0u )
+		#if( ipconfigDNS_USE_CALLBACKS == 0 )
+			/* It is useless to analyse the unexpected reply
+			unless asynchronous look-ups are enabled. */
+			if( xIndex >= 0 )
+		#endif /* ipconfigDNS_USE_CALLBACKS == 0 */
 			{
-				/* This DNS lookup is asynchronous, using a call-back:
-				send the request only once. */
-				break;
+				ulIPAddress = prvParseDNSReply( pucUDPPayloadBuffer, ( size_t ) lBytes, ( xIndex >= 0 ) ? pdTRUE : pdFALSE );
+			}
+
+			if( xIndex >= 0 )
+			{
+				vTaskSuspendAll();
+				{
+					/* Pass the answer to the waiting tasks. */
+					if( ( xDNSQueries[ xIndex ].ucState == dnsQUERY_PENDING ) && ( xDNSQueries[ xIndex ].uxIdentifier == uxIdentifier ) )
+					{
+						xDNSQueries[ xIndex ].ulIPAddress = ulIPAddress;
+						xDNSQueries[ xIndex ].ucState = dnsQUERY_ANSWERED;
+					}
+				}
+				xTaskResumeAll();
 			}
 		}
 
-		/* Finished with the socket. */
-		FreeRTOS_closesocket( xDNSSocket );
-	}
+		/* Finished with the buffer.  The zero copy interface
+		is being used, so the buffer must be freed by the
+		task. */
+		FreeRTOS_ReleaseUDPPayloadBuffer( ( void * ) pucUDPPayloadBuffer );
 
-	return ulIPAddress;
+		if( ( xFlags & FREERTOS_MSG_DONTWAIT ) == 0 )
+		{
+			/* Let the caller check for its answer. */
+			break;
+		}
+	}
 }
 /*-----------------------------------------------------------*/
 
@@ -1122,7 +1534,7 @@ BaseType_t xDoStore = xExpected;
 							request was issued by this device. */
 							if( xDoStore != pdFALSE )
 							{
-								prvProcessDNSCache( pcName, &ulIPAddress, pxDNSAnswerRecord->ulTTL, pdFALSE );
+								( void ) prvProcessDNSCache( pcName, &ulIPAddress, FreeRTOS_ntohl( pxDNSAnswerRecord->ulTTL ), pdFALSE );
 							}
 
 							/* Show what has happened. */
@@ -1239,6 +1651,36 @@ BaseType_t xDoStore = xExpected;
 #endif /* ipconfigUSE_LLMNR == 1 */
 	} while( 0 );
 
+	#if( ipconfigUSE_DNS_CACHE == 1 ) || ( ipconfigDNS_USE_CALLBACKS == 1 )
+	{
+	uint16_t usRxFlags = pxDNSMessageHeader->usFlags & dnsRX_FLAGS_MASK;
+
+		if( ( ulIPAddress == 0uL ) && ( pcName[ 0 ] != '\0' ) &&
+			( ( usRxFlags == dnsEXPECTED_RX_FLAGS ) || ( usRxFlags == dnsNXDOMAIN_RX_FLAGS ) ) )
+		{
+			/* The name does not exist, or it has no IPv4 address. */
+			#if( ipconfigDNS_USE_CALLBACKS == 1 )
+			{
+				/* An asynchronous look-up does not have to wait for its
+				time-out. */
+				if( xDNSDoCallback( ( TickType_t ) pxDNSMessageHeader->usIdentifier, pcName, 0uL ) != pdFALSE )
+				{
+					xDoStore = pdTRUE;
+				}
+			}
+			#endif /* ipconfigDNS_USE_CALLBACKS == 1 */
+			#if( ipconfigUSE_DNS_CACHE == 1 ) && ( ipconfigDNS_CACHE_NEGATIVE_TTL != 0 )
+			{
+				if( xDoStore != pdFALSE )
+				{
+					( void ) prvProcessDNSCache( pcName, &ulIPAddress, ( uint32_t ) ipconfigDNS_CACHE_NEGATIVE_TTL, pdFALSE );
+				}
+			}
+			#endif /* ipconfigUSE_DNS_CACHE && ipconfigDNS_CACHE_NEGATIVE_TTL */
+		}
+	}
+	#endif /* ipconfigUSE_DNS_CACHE || ipconfigDNS_USE_CALLBACKS */
+
 	if( xExpected == pdFALSE )
 	{
 		/* Do not return a valid IP-address in case the reply was not expected. */
@@ -1312,7 +1754,7 @@ BaseType_t xDoStore = xExpected;
 				{
 					/* If this is a response from another device,
 					add the name to the DNS cache */
-					prvProcessDNSCache( ( char * ) ucNBNSName, &ulIPAddress, 0, pdFALSE );
+					( void ) prvProcessDNSCache( ( char * ) ucNBNSName, &ulIPAddress, dnsNBNS_TTL_VALUE, pdFALSE );
 				}
 			}
 			#else
@@ -1463,84 +1905,167 @@ BaseType_t xReturn;
 
 #if( ipconfigUSE_DNS_CACHE == 1 )
 
-	static void prvProcessDNSCache( const char *pcName,
-									uint32_t *pulIP,
-									uint32_t ulTTL,
-									BaseType_t xLookUp )
+	static uint32_t prvDNSNameHash( const char *pcName )
 	{
-	BaseType_t x;
-	BaseType_t xFound = pdFALSE;
-	uint32_t ulCurrentTimeSeconds = ( xTaskGetTickCount() / portTICK_PERIOD_MS ) / 1000;
-	static BaseType_t xFreeEntry = 0;
-		configASSERT(pcName);
-
-		/* For each entry in the DNS cache table. */
-		for( x = 0; x < ipconfigDNS_CACHE_ENTRIES; x++ )
+	uint32_t ulHash = 2166136261uL;
+	const uint8_t *pucPtr;
+
+		for( pucPtr = ( const uint8_t * ) pcName; *pucPtr != 0u; pucPtr++ )
 		{
-			if( xDNSCache[ x ].pcName[ 0 ] == 0 )
+			ulHash ^= ( uint32_t ) *pucPtr;
+			ulHash *= 16777619uL;
+		}
+
+		return ulHash;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvDNSCacheRemove( BaseType_t xIndex )
+	{
+	uint16_t *pusLink = &( usDNSCacheBuckets[ xDNSCache[ xIndex ].ulHash % ipconfigDNS_CACHE_BUCKETS ] );
+
+		/* Find the link that points to this row. */
+		while( *pusLink != 0u )
+		{
+			if( *pusLink == ( uint16_t ) ( xIndex + 1 ) )
 			{
-				continue;
+				*pusLink = xDNSCache[ xIndex ].usNext;
+				break;
 			}
 
-			if( 0 == strcmp( xDNSCache[ x ].pcName, pcName ) )
+			pusLink = &( xDNSCache[ *pusLink - 1u ].usNext );
+		}
+
+		xDNSCache[ xIndex ].pcName[ 0 ] = 0;
+		xDNSCache[ xIndex ].usNext = 0u;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvProcessDNSCache( const char *pcName,
+										  uint32_t *pulIP,
+										  uint32_t ulTTL,
+										  BaseType_t xLookUp )
+	{
+	BaseType_t x, xIndex = -1;
+	BaseType_t xResult = dnsCACHE_MISS;
+	uint32_t ulCurrentTimeSeconds = ( uint32_t ) ( xTaskGetTickCount() / configTICK_RATE_HZ );
+	uint32_t ulHash, ulAge, ulRemaining, ulLowest;
+	uint16_t usIndex;
+	DNSCacheRow_t *pxRow;
+
+		configASSERT( pcName );
+
+		ulHash = prvDNSNameHash( pcName );
+
+		/* The cache is accessed by the IP-task and by user tasks. */
+		vTaskSuspendAll();
+		{
+			/* Search the bucket of this name. */
+			for( usIndex = usDNSCacheBuckets[ ulHash % ipconfigDNS_CACHE_BUCKETS ];
+				 usIndex != 0u;
+				 usIndex = xDNSCache[ usIndex - 1u ].usNext )
 			{
-				/* Is this function called for a lookup or to add/update an IP address? */
-				if( xLookUp != pdFALSE )
+				pxRow = &( xDNSCache[ usIndex - 1u ] );
+
+				if( ( pxRow->ulHash == ulHash ) && ( strcmp( pxRow->pcName, pcName ) == 0 ) )
 				{
+					xIndex = ( BaseType_t ) usIndex - 1;
+					break;
+				}
+			}
+
+			/* Is this function called for a lookup or to add/update an IP address? */
+			if( xLookUp != pdFALSE )
+			{
+				*pulIP = 0uL;
+
+				if( xIndex >= 0 )
+				{
+					pxRow = &( xDNSCache[ xIndex ] );
+					ulAge = ulCurrentTimeSeconds - pxRow->ulTimeWhenAddedInSeconds;
+
 					/* Confirm that the record is still fresh. */
-					if( ulCurrentTimeSeconds < ( xDNSCache[ x ].ulTimeWhenAddedInSeconds + FreeRTOS_ntohl( xDNSCache[ x ].ulTTL ) ) )
+					if( ulAge < pxRow->ulTTL )
 					{
-						*pulIP = xDNSCache[ x ].ulIPAddress;
+						*pulIP = pxRow->ulIPAddress;
+						xResult = dnsCACHE_HIT;
+
+						#if( ipconfigDNS_CACHE_PREFETCH != 0 )
+						{
+							/* Ask for a refresh once, when the record is
+							about to expire. */
+							if( ( pxRow->ulIPAddress != 0uL ) &&
+								( pxRow->ucRefreshing == 0u ) &&
+								( ( pxRow->ulTTL - ulAge ) <= ( pxRow->ulTTL / dnsCACHE_REFRESH_DIVISOR ) ) )
+							{
+								pxRow->ucRefreshing = 1u;
+								xResult = dnsCACHE_HIT_REFRESH;
+							}
+						}
+						#endif /* ipconfigDNS_CACHE_PREFETCH */
 					}
 					else
 					{
 						/* Age out the old cached record. */
-						xDNSCache[ x ].pcName[ 0 ] = 0;
+						prvDNSCacheRemove( xIndex );
 					}
 				}
-				else
-				{
-					xDNSCache[ x ].ulIPAddress = *pulIP;
-					xDNSCache[ x ].ulTTL = ulTTL;
-					xDNSCache[ x ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
-				}
-
-				xFound = pdTRUE;
-				break;
-			}
-		}
-
-		if( xFound == pdFALSE )
-		{
-			if( xLookUp != pdFALSE )
-			{
-				*pulIP = 0;
 			}
 			else
 			{
-				/* Add or update the item. */
-				if( strlen( pcName ) < ipconfigDNS_CACHE_NAME_LENGTH )
+				if( ( xIndex < 0 ) && ( strlen( pcName ) < ipconfigDNS_CACHE_NAME_LENGTH ) )
 				{
-					strcpy( xDNSCache[ xFreeEntry ].pcName, pcName );
+					/* Take a free row, or else the row that expires first. */
+					ulLowest = 0xffffffffuL;
 
-					xDNSCache[ xFreeEntry ].ulIPAddress = *pulIP;
-					xDNSCache[ xFreeEntry ].ulTTL = ulTTL;
-					xDNSCache[ xFreeEntry ].ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
+					for( x = 0; x < ipconfigDNS_CACHE_ENTRIES; x++ )
+					{
+						if( xDNSCache[ x ].pcName[ 0 ] == 0 )
+						{
+							xIndex = x;
+							break;
+						}
 
-					xFreeEntry++;
+						ulAge = ulCurrentTimeSeconds - xDNSCache[ x ].ulTimeWhenAddedInSeconds;
+						ulRemaining = ( ulAge < xDNSCache[ x ].ulTTL ) ? ( xDNSCache[ x ].ulTTL - ulAge ) : 0uL;
+
+						if( ulRemaining < ulLowest )
+						{
+							ulLowest = ulRemaining;
+							xIndex = x;
+						}
+					}
 
-					if( xFreeEntry == ipconfigDNS_CACHE_ENTRIES )
+					if( xDNSCache[ xIndex ].pcName[ 0 ] != 0 )
 					{
-						xFreeEntry = 0;
+						prvDNSCacheRemove( xIndex );
 					}
+
+					pxRow = &( xDNSCache[ xIndex ] );
+					strcpy( pxRow->pcName, pcName );
+					pxRow->ulHash = ulHash;
+					pxRow->usNext = usDNSCacheBuckets[ ulHash % ipconfigDNS_CACHE_BUCKETS ];
+					usDNSCacheBuckets[ ulHash % ipconfigDNS_CACHE_BUCKETS ] = ( uint16_t ) ( xIndex + 1 );
+				}
+
+				if( xIndex >= 0 )
+				{
+					pxRow = &( xDNSCache[ xIndex ] );
+					pxRow->ulIPAddress = *pulIP;
+					pxRow->ulTTL = ulTTL;
+					pxRow->ulTimeWhenAddedInSeconds = ulCurrentTimeSeconds;
+					pxRow->ucRefreshing = 0u;
 				}
 			}
 		}
+		xTaskResumeAll();
 
-		if( ( xLookUp == 0 ) || ( *pulIP != 0 ) )
+		if( ( xLookUp == pdFALSE ) || ( xResult != dnsCACHE_MISS ) )
 		{
 			FreeRTOS_debug_printf( ( "prvProcessDNSCache: %s: '%s' @ %lxip\n", xLookUp ? "look-up" : "add", pcName, FreeRTOS_ntohl( *pulIP ) ) );
 		}
+
+		return xResult;
 	}
 
 #endif /* ipconfigUSE_DNS_CACHE */
@@ -89,6 +89,11 @@ shorted in the Windows simulator as simulated time is not real time. */
 	#define ipTCP_TIMER_PERIOD_MS	( 1000 )
 #endif
 
+#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+	/* The period at which incomplete datagrams are checked for a timeout. */
+	#define ipIP_REASSEMBLY_TIMER_PERIOD_MS	( 1000 )
+#endif
+
 /* If ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES is set to 1, then the Ethernet
 driver will filter incoming packets and only pass the stack those packets it
 considers need processing.  In this case ipCONSIDER_FRAME_FOR_PROCESSING() can
@@ -109,9 +114,13 @@ character expected to fill ICMP echo replies. */
 #if( ipconfigBYTE_ORDER == pdFREERTOS_LITTLE_ENDIAN )
 	/* The bits in the two byte IP header field that make up the fragment offset value. */
 	#define ipFRAGMENT_OFFSET_BIT_MASK				( ( uint16_t ) 0xff0f )
+	/* The fragment offset plus the 'more fragments' flag: non-zero for any fragment. */
+	#define ipFRAGMENTED_PACKET_BIT_MASK			( ( uint16_t ) 0xff3f )
 #else
 	/* The bits in the two byte IP header field that make up the fragment offset value. */
 	#define ipFRAGMENT_OFFSET_BIT_MASK				( ( uint16_t ) 0x0fff )
+	/* The fragment offset plus the 'more fragments' flag: non-zero for any fragment. */
+	#define ipFRAGMENTED_PACKET_BIT_MASK			( ( uint16_t ) 0x3fff )
 #endif /* ipconfigBYTE_ORDER */
 
 /* The maximum time the IP task is allowed to remain in the Blocked state if no
@@ -230,9 +239,24 @@ static TickType_t prvCalculateSleepTime( void );
 
 /*
  * The network card driver has received a packet.  In the case that it is part
- * of a linked packet chain, walk through it to handle every message.
+ * of a linked packet chain, walk through it to handle at most 'uxMaxCount'
+ * messages.  Returns the number of messages handled.
+ */
+static UBaseType_t prvHandleEthernetPacket( NetworkBufferDescriptor_t *pxBuffer, UBaseType_t uxMaxCount );
+
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	/*
+	 * Handle at most ipconfigMAX_IP_TASK_BURST messages of the chain that was
+	 * left over by prvHandleEthernetPacket().  Returns the number handled.
+	 */
+	static UBaseType_t prvHandlePendingRxChain( void );
+#endif
+
+/*
+ * Handle a single event that was received from xNetworkEventQueue.  Returns
+ * the amount of work done, counted as the number of packets received, or 1.
  */
-static void prvHandleEthernetPacket( NetworkBufferDescriptor_t *pxBuffer );
+static UBaseType_t prvHandleIPEvent( IPStackEvent_t *pxReceivedEvent, UBaseType_t uxMaxCount );
 
 /*
  * Utility functions for the light weight IP timers.
@@ -244,6 +268,66 @@ static void prvIPTimerReload( IPTimer_t *pxTimer, TickType_t xTime );
 static eFrameProcessingResult_t prvAllowIPPacket( const IPPacket_t * const pxIPPacket,
 	NetworkBufferDescriptor_t * const pxNetworkBuffer, UBaseType_t uxHeaderLength );
 
+#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+	struct xIP_REASSEMBLY;
+
+	/*
+	 * Store a received IPv4 fragment in the entry of its datagram.  When the
+	 * datagram is complete, it is sent to the IP-task as a newly received
+	 * packet.  Returns eFrameConsumed when the fragment has been stored.
+	 */
+	static eFrameProcessingResult_t prvIPReassemble( NetworkBufferDescriptor_t * const pxNetworkBuffer, UBaseType_t uxHeaderLength );
+
+	/*
+	 * Copy the fragments of a complete datagram into a new network buffer,
+	 * release the fragments and queue the new packet as an eNetworkRxEvent.
+	 */
+	static void prvIPReassemblyComplete( struct xIP_REASSEMBLY *pxEntry );
+
+	/*
+	 * Return the in-use entry that was started first, not counting
+	 * 'pxExclude', or NULL.
+	 */
+	static struct xIP_REASSEMBLY *prvIPReassemblyOldest( const struct xIP_REASSEMBLY *pxExclude );
+
+	/*
+	 * Release all fragments of a datagram, which makes its entry free.
+	 */
+	static void prvIPReassemblyRelease( struct xIP_REASSEMBLY *pxEntry );
+
+	/*
+	 * Called by the reassembly timer: drop the datagrams that were not
+	 * completed within ipconfigIP_REASSEMBLY_TIMEOUT_MS.
+	 */
+	static void prvIPReassemblyCheck( void );
+#endif /* ipconfigUSE_IP_REASSEMBLY */
+
+#if( ipconfigUSE_TX_SCHEDULER != 0 )
+	/*
+	 * Choose the band of the transmit scheduler for an outgoing packet.
+	 */
+	static UBaseType_t prvTxSchedulerBand( const NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/*
+	 * Choose the next packet of the transmit scheduler: the head of the
+	 * control band, or else the next one according to deficit round robin.
+	 * The packet stays in its band, which is returned in 'puxBand'.
+	 */
+	static NetworkBufferDescriptor_t *prvTxSchedulerNext( UBaseType_t *puxBand );
+
+	/*
+	 * Give the next packet of the transmit scheduler to the driver.  It is
+	 * only removed from its band when the driver accepts it.
+	 */
+	static BaseType_t prvTxSchedulerSendNext( void );
+
+	/*
+	 * Called by the IP-task after every event: send waiting packets until the
+	 * budget of the event has been used, and give the next event a new budget.
+	 */
+	static void prvTxSchedulerRun( void );
+#endif /* ipconfigUSE_TX_SCHEDULER */
+
 /*-----------------------------------------------------------*/
 
 /* The queue used to pass events into the IP-task for processing. */
@@ -263,6 +347,29 @@ NetworkAddressingParameters_t xNetworkAddressing = { 0, 0, 0, 0, 0 };
 does not lead to a confirmed request. */
 NetworkAddressingParameters_t xDefaultAddressing = { 0, 0, 0, 0, 0 };
 
+#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+	/* A datagram that is being reassembled.  The entry is identified by the
+	addresses, the identification and the protocol of the IP header.  With a
+	few entries, a linear search is the fastest look-up. */
+	typedef struct xIP_REASSEMBLY
+	{
+		uint32_t ulSourceIPAddress;			/* Network byte order. */
+		uint32_t ulDestinationIPAddress;	/* Network byte order. */
+		uint16_t usIdentification;			/* Network byte order. */
+		uint8_t ucProtocol;
+		size_t uxReceivedLength;			/* The number of payload bytes received. */
+		size_t uxTotalLength;				/* The payload length, known once the last fragment has arrived, or else zero. */
+		TickType_t xStartTime;				/* The time at which the first fragment arrived. */
+		List_t xFragments;					/* The network buffers, sorted by fragment offset.  The entry is free when the list is empty. */
+	} IPReassembly_t;
+
+	static IPReassembly_t xReassemblyTable[ ipconfigIP_REASSEMBLY_MAX_PACKETS ];
+
+	/* The number of network buffers held by all entries, at most
+	ipconfigIP_REASSEMBLY_MAX_BUFFERS. */
+	static UBaseType_t uxReassemblyBuffers = 0u;
+#endif /* ipconfigUSE_IP_REASSEMBLY */
+
 /* Used to ensure network down events cannot be missed when they cannot be
 posted to the network event queue because the network event queue is already
 full. */
@@ -291,6 +398,7 @@ regular basis:
 	2. DPHC, to send requests and to renew a reservation
 	3. TCP, to check for timeouts, resends
 	4. DNS, to check for timeouts when looking-up a domain.
+	5. IP reassembly, to drop incomplete datagrams.
  */
 static IPTimer_t xARPTimer;
 #if( ipconfigUSE_DHCP != 0 )
@@ -302,6 +410,9 @@ static IPTimer_t xARPTimer;
 #if( ipconfigDNS_USE_CALLBACKS != 0 )
 	static IPTimer_t xDNSTimer;
 #endif
+#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+	static IPTimer_t xReassemblyTimer;
+#endif
 
 /* Set to pdTRUE when the IP task is ready to start processing packets. */
 static BaseType_t xIPTaskInitialised = pdFALSE;
@@ -311,14 +422,55 @@ static BaseType_t xIPTaskInitialised = pdFALSE;
 	static UBaseType_t uxQueueMinimumSpace = ipconfigEVENT_QUEUE_LENGTH;
 #endif
 
+#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+	IPCounters_t xIPCounters;
+#endif
+
+#if( ipconfigUSE_TX_SCHEDULER != 0 )
+	/* The bands of the transmit scheduler, the control band has strict
+	priority, the others share the link according to their weight. */
+	#define ipTX_BAND_CONTROL		( 0u )
+	#define ipTX_BAND_INTERACTIVE	( 1u )
+	#define ipTX_BAND_BEST_EFFORT	( 2u )
+	#define ipTX_BAND_BULK			( 3u )
+	#define ipTX_BAND_COUNT			( 4u )
+
+	typedef struct xTX_BAND
+	{
+		List_t xPackets;	/* Waiting network buffers, linked through their xBufferListItem. */
+		int32_t lDeficit;	/* Deficit round robin: the number of bytes the band may still send. */
+	} TxBand_t;
+
+	static TxBand_t xTxBands[ ipTX_BAND_COUNT ];
+	static const uint8_t ucTxBandWeight[ ipTX_BAND_COUNT ] = { 0u, 4u, 2u, 1u };
+
+	/* The number of packets waiting in all bands. */
+	static UBaseType_t uxTxWaiting = 0u;
+
+	/* The number of packets that the current event may still send. */
+	static UBaseType_t uxTxBudget = ( UBaseType_t ) ipconfigTX_SCHEDULER_BURST;
+
+	/* The round-robin band that is being served. */
+	static UBaseType_t uxTxCurrentBand = ipTX_BAND_INTERACTIVE;
+
+	/* Set when the driver refused a waiting packet.  The IP-task will then
+	retry after a tick instead of not sleeping at all. */
+	static BaseType_t xTxDriverBusy = pdFALSE;
+#endif /* ipconfigUSE_TX_SCHEDULER */
+
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	/* The remainder of a chain of received packets that was too long to be
+	handled in a single round of the IP-task. */
+	static NetworkBufferDescriptor_t *pxPendingRxChain = NULL;
+#endif
+
 /*-----------------------------------------------------------*/
 
 static void prvIPTask( void *pvParameters )
 {
 IPStackEvent_t xReceivedEvent;
 TickType_t xNextIPSleep;
-FreeRTOS_Socket_t *pxSocket;
-struct freertos_sockaddr xAddress;
+UBaseType_t uxBurstCount;
 
 	/* Just to prevent compiler warnings about unused parameters. */
 	( void ) pvParameters;
@@ -339,6 +491,28 @@ struct freertos_sockaddr xAddress;
 	}
 	#endif
 
+	#if( ipconfigUSE_TX_SCHEDULER != 0 )
+	{
+	UBaseType_t uxBand;
+
+		for( uxBand = 0u; uxBand < ipTX_BAND_COUNT; uxBand++ )
+		{
+			vListInitialise( &( xTxBands[ uxBand ].xPackets ) );
+		}
+	}
+	#endif /* ipconfigUSE_TX_SCHEDULER */
+
+	#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+	{
+	BaseType_t xIndex;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIP_REASSEMBLY_MAX_PACKETS; xIndex++ )
+		{
+			vListInitialise( &( xReassemblyTable[ xIndex ].xFragments ) );
+		}
+	}
+	#endif /* ipconfigUSE_IP_REASSEMBLY */
+
 	/* Initialisation is complete and events can now be processed. */
 	xIPTaskInitialised = pdTRUE;
 
@@ -356,17 +530,67 @@ struct freertos_sockaddr xAddress;
 		/* Calculate the acceptable maximum sleep time. */
 		xNextIPSleep = prvCalculateSleepTime();
 
-		/* Wait until there is something to do. If the following call exits
-		 * due to a time out rather than a message being received, set a
-		 * 'NoEvent' value. */
-		if ( xQueueReceive( xNetworkEventQueue, ( void * ) &xReceivedEvent, xNextIPSleep ) == pdFALSE ) 
+		#if( ipconfigUSE_TX_SCHEDULER != 0 )
 		{
-			xReceivedEvent.eEventType = eNoEvent;
+			/* Do not sleep while packets are waiting to be sent. */
+			if( uxTxWaiting != 0u )
+			{
+				if( xTxDriverBusy == pdFALSE )
+				{
+					xNextIPSleep = ( TickType_t ) 0;
+				}
+				else if( xNextIPSleep > ( TickType_t ) 1 )
+				{
+					xNextIPSleep = ( TickType_t ) 1;
+				}
+				else
+				{
+					/* Retry at the next wake-up. */
+				}
+			}
 		}
+		#endif /* ipconfigUSE_TX_SCHEDULER */
 
-		#if( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
+		#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+		{
+			/* First continue with a chain of packets that was not handled
+			completely in the previous round. */
+			uxBurstCount = prvHandlePendingRxChain();
+		}
+		#else
 		{
-			if( xReceivedEvent.eEventType != eNoEvent )
+			uxBurstCount = 0u;
+		}
+		#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+		/* Handle a burst of events before checking the timers again.  Only
+		block when nothing has been done yet in this round. */
+		while( uxBurstCount < ( UBaseType_t ) ipconfigMAX_IP_TASK_BURST )
+		{
+			if( uxBurstCount != 0u )
+			{
+				xNextIPSleep = ( TickType_t ) 0;
+			}
+
+			/* Wait until there is something to do. If the following call
+			exits due to a time out rather than a message being received,
+			leave the loop and check the timers. */
+			if( xQueueReceive( xNetworkEventQueue, ( void * ) &xReceivedEvent, xNextIPSleep ) == pdFALSE )
+			{
+				if( uxBurstCount == 0u )
+				{
+					iptraceNETWORK_EVENT_RECEIVED( eNoEvent );
+				}
+
+				#if( ipconfigUSE_TX_SCHEDULER != 0 )
+				{
+					prvTxSchedulerRun();
+				}
+				#endif
+				break;
+			}
+
+			#if( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
 			{
 			UBaseType_t uxCount;
 
@@ -376,150 +600,200 @@ struct freertos_sockaddr xAddress;
 					uxQueueMinimumSpace = uxCount;
 				}
 			}
-		}
-		#endif /* ipconfigCHECK_IP_QUEUE_SPACE */
+			#endif /* ipconfigCHECK_IP_QUEUE_SPACE */
+
+			#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+			{
+			UBaseType_t uxWaiting;
+
+				/* Include the message that was just taken from the queue. */
+				uxWaiting = uxQueueMessagesWaiting( xNetworkEventQueue ) + 1u;
+				if( xIPCounters.uxEventQueueHighWater < uxWaiting )
+				{
+					xIPCounters.uxEventQueueHighWater = uxWaiting;
+				}
+			}
+			#endif /* ipconfigUSE_PERFORMANCE_COUNTERS */
+
+			iptraceNETWORK_EVENT_RECEIVED( xReceivedEvent.eEventType );
 
-		iptraceNETWORK_EVENT_RECEIVED( xReceivedEvent.eEventType );
+			uxBurstCount += prvHandleIPEvent( &xReceivedEvent, ( UBaseType_t ) ipconfigMAX_IP_TASK_BURST - uxBurstCount );
+
+			#if( ipconfigUSE_TX_SCHEDULER != 0 )
+			{
+				prvTxSchedulerRun();
+			}
+			#endif
+		}
 
-		switch( xReceivedEvent.eEventType )
+		if( xNetworkDownEventPending != pdFALSE )
 		{
-			case eNetworkDownEvent :
-				/* Attempt to establish a connection. */
-				xNetworkUp = pdFALSE;
-				prvProcessNetworkDownEvent();
-				break;
+			/* A network down event could not be posted to the network event
+			queue because the queue was full.  Try posting again. */
+			FreeRTOS_NetworkDown();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
 
-			case eNetworkRxEvent:
-				/* The network hardware driver has received a new packet.  A
-				pointer to the received buffer is located in the pvData member
-				of the received event structure. */
-				prvHandleEthernetPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
-				break;
+static UBaseType_t prvHandleIPEvent( IPStackEvent_t *pxReceivedEvent, UBaseType_t uxMaxCount )
+{
+FreeRTOS_Socket_t *pxSocket;
+struct freertos_sockaddr xAddress;
+UBaseType_t uxCount = 1u;
 
-			case eNetworkTxEvent:
-				/* Send a network packet. The ownership will  be transferred to
-				the driver, which will release it after delivery. */
-				xNetworkInterfaceOutput( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ), pdTRUE );
-				break;
+	switch( pxReceivedEvent->eEventType )
+	{
+		case eNetworkDownEvent :
+			/* Attempt to establish a connection. */
+			xNetworkUp = pdFALSE;
+			prvProcessNetworkDownEvent();
+			break;
 
-			case eARPTimerEvent :
-				/* The ARP timer has expired, process the ARP cache. */
-				vARPAgeCache();
-				break;
+		case eNetworkRxEvent:
+			/* The network hardware driver has received a new packet.  A
+			pointer to the received buffer is located in the pvData member
+			of the received event structure. */
+			uxCount = prvHandleEthernetPacket( ( NetworkBufferDescriptor_t * ) ( pxReceivedEvent->pvData ), uxMaxCount );
+			break;
 
-			case eSocketBindEvent:
-				/* FreeRTOS_bind (a user API) wants the IP-task to bind a socket
-				to a port. The port number is communicated in the socket field
-				usLocalPort. vSocketBind() will actually bind the socket and the
-				API will unblock as soon as the eSOCKET_BOUND event is
-				triggered. */
-				pxSocket = ( FreeRTOS_Socket_t * ) ( xReceivedEvent.pvData );
-				xAddress.sin_addr = 0u;	/* For the moment. */
-				xAddress.sin_port = FreeRTOS_ntohs( pxSocket->usLocalPort );
-				pxSocket->usLocalPort = 0u;
-				vSocketBind( pxSocket, &xAddress, sizeof( xAddress ), pdFALSE );
-
-				/* Before 'eSocketBindEvent' was sent it was tested that
-				( xEventGroup != NULL ) so it can be used now to wake up the
-				user. */
-				pxSocket->xEventBits |= eSOCKET_BOUND;
-				vSocketWakeUpUser( pxSocket );
-				break;
+		case eNetworkTxEvent:
+			/* Send a network packet. The ownership will  be transferred to
+			the driver, which will release it after delivery. */
+			ipNETWORK_INTERFACE_OUTPUT( ( NetworkBufferDescriptor_t * ) ( pxReceivedEvent->pvData ), pdTRUE );
+			break;
 
-			case eSocketCloseEvent :
-				/* The user API FreeRTOS_closesocket() has sent a message to the
-				IP-task to actually close a socket. This is handled in
-				vSocketClose().  As the socket gets closed, there is no way to
-				report back to the API, so the API won't wait for the result */
-				vSocketClose( ( FreeRTOS_Socket_t * ) ( xReceivedEvent.pvData ) );
-				break;
+		case eARPTimerEvent :
+			/* The ARP timer has expired, process the ARP cache. */
+			vARPAgeCache();
+			break;
 
-			case eStackTxEvent :
-				/* The network stack has generated a packet to send.  A
-				pointer to the generated buffer is located in the pvData
-				member of the received event structure. */
-				vProcessGeneratedUDPPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
-				break;
+		case eSocketBindEvent:
+			/* FreeRTOS_bind (a user API) wants the IP-task to bind a socket
+			to a port. The port number is communicated in the socket field
+			usLocalPort. vSocketBind() will actually bind the socket and the
+			API will unblock as soon as the eSOCKET_BOUND event is
+			triggered. */
+			pxSocket = ( FreeRTOS_Socket_t * ) ( pxReceivedEvent->pvData );
+			xAddress.sin_addr = 0u;	/* For the moment. */
+			xAddress.sin_port = FreeRTOS_ntohs( pxSocket->usLocalPort );
+			pxSocket->usLocalPort = 0u;
+			vSocketBind( pxSocket, &xAddress, sizeof( xAddress ), pdFALSE );
+
+			/* Before 'eSocketBindEvent' was sent it was tested that
+			( xEventGroup != NULL ) so it can be used now to wake up the
+			user. */
+			pxSocket->xEventBits |= eSOCKET_BOUND;
+			vSocketWakeUpUser( pxSocket );
+			break;
 
-			case eDHCPEvent:
-				/* The DHCP state machine needs processing. */
-				#if( ipconfigUSE_DHCP == 1 )
-				{
-					vDHCPProcess( pdFALSE );
-				}
-				#endif /* ipconfigUSE_DHCP */
-				break;
+		case eSocketCloseEvent :
+			/* The user API FreeRTOS_closesocket() has sent a message to the
+			IP-task to actually close a socket. This is handled in
+			vSocketClose().  As the socket gets closed, there is no way to
+			report back to the API, so the API won't wait for the result */
+			vSocketClose( ( FreeRTOS_Socket_t * ) ( pxReceivedEvent->pvData ) );
+			break;
 
-			case eSocketSelectEvent :
-				/* FreeRTOS_select() has got unblocked by a socket event,
-				vSocketSelect() will check which sockets actually have an event
-				and update the socket field xSocketBits. */
-				#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
-				{
-					vSocketSelect( ( SocketSelect_t * ) ( xReceivedEvent.pvData ) );
-				}
-				#endif /* ipconfigSUPPORT_SELECT_FUNCTION == 1 */
-				break;
+		case eStackTxEvent :
+			/* The network stack has generated a packet to send.  A
+			pointer to the generated buffer is located in the pvData
+			member of the received event structure. */
+			vProcessGeneratedUDPPacket( ( NetworkBufferDescriptor_t * ) ( pxReceivedEvent->pvData ) );
+			break;
 
-			case eSocketSignalEvent :
-				#if( ipconfigSUPPORT_SIGNALS != 0 )
-				{
-					/* Some task wants to signal the user of this socket in
-					order to interrupt a call to recv() or a call to select(). */
-					FreeRTOS_SignalSocket( ( Socket_t ) xReceivedEvent.pvData );
-				}
-				#endif /* ipconfigSUPPORT_SIGNALS */
-				break;
+		case eStackTxBatchEvent :
+			/* FreeRTOS_sendmmsg() has generated several packets, which are
+			chained using the pxNextBuffer member. */
+			#if( ipconfigSUPPORT_MMSG_FUNCTIONS == 1 )
+			{
+			NetworkBufferDescriptor_t *pxBuffer = ( NetworkBufferDescriptor_t * ) ( pxReceivedEvent->pvData );
+			NetworkBufferDescriptor_t *pxNextBuffer;
 
-			case eTCPTimerEvent :
-				#if( ipconfigUSE_TCP == 1 )
+				while( pxBuffer != NULL )
 				{
-					/* Simply mark the TCP timer as expired so it gets processed
-					the next time prvCheckNetworkTimers() is called. */
-					xTCPTimer.bExpired = pdTRUE_UNSIGNED;
+					pxNextBuffer = pxBuffer->pxNextBuffer;
+					pxBuffer->pxNextBuffer = NULL;
+					vProcessGeneratedUDPPacket( pxBuffer );
+					pxBuffer = pxNextBuffer;
 				}
-				#endif /* ipconfigUSE_TCP */
-				break;
+			}
+			#endif /* ipconfigSUPPORT_MMSG_FUNCTIONS */
+			break;
 
-			case eTCPAcceptEvent:
-				/* The API FreeRTOS_accept() was called, the IP-task will now
-				check if the listening socket (communicated in pvData) actually
-				received a new connection. */
-				#if( ipconfigUSE_TCP == 1 )
-				{
-					pxSocket = ( FreeRTOS_Socket_t * ) ( xReceivedEvent.pvData );
+		case eDHCPEvent:
+			/* The DHCP state machine needs processing. */
+			#if( ipconfigUSE_DHCP == 1 )
+			{
+				vDHCPProcess( pdFALSE );
+			}
+			#endif /* ipconfigUSE_DHCP */
+			break;
 
-					if( xTCPCheckNewClient( pxSocket ) != pdFALSE )
-					{
-						pxSocket->xEventBits |= eSOCKET_ACCEPT;
-						vSocketWakeUpUser( pxSocket );
-					}
-				}
-				#endif /* ipconfigUSE_TCP */
-				break;
+		case eSocketSelectEvent :
+			/* FreeRTOS_select() has got unblocked by a socket event,
+			vSocketSelect() will check which sockets actually have an event
+			and update the socket field xSocketBits. */
+			#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+			{
+				vSocketSelect( ( SocketSelect_t * ) ( pxReceivedEvent->pvData ) );
+			}
+			#endif /* ipconfigSUPPORT_SELECT_FUNCTION == 1 */
+			break;
 
-			case eTCPNetStat:
-				/* FreeRTOS_netstat() was called to have the IP-task print an
-				overview of all sockets and their connections */
-				#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigHAS_PRINTF == 1 ) )
+		case eSocketSignalEvent :
+			#if( ipconfigSUPPORT_SIGNALS != 0 )
+			{
+				/* Some task wants to signal the user of this socket in
+				order to interrupt a call to recv() or a call to select(). */
+				FreeRTOS_SignalSocket( ( Socket_t ) pxReceivedEvent->pvData );
+			}
+			#endif /* ipconfigSUPPORT_SIGNALS */
+			break;
+
+		case eTCPTimerEvent :
+			#if( ipconfigUSE_TCP == 1 )
+			{
+				/* Simply mark the TCP timer as expired so it gets processed
+				the next time prvCheckNetworkTimers() is called. */
+				xTCPTimer.bExpired = pdTRUE_UNSIGNED;
+			}
+			#endif /* ipconfigUSE_TCP */
+			break;
+
+		case eTCPAcceptEvent:
+			/* The API FreeRTOS_accept() was called, the IP-task will now
+			check if the listening socket (communicated in pvData) actually
+			received a new connection. */
+			#if( ipconfigUSE_TCP == 1 )
+			{
+				pxSocket = ( FreeRTOS_Socket_t * ) ( pxReceivedEvent->pvData );
+
+				if( xTCPCheckNewClient( pxSocket ) != pdFALSE )
 				{
-					vTCPNetStat();
+					pxSocket->xEventBits |= eSOCKET_ACCEPT;
+					vSocketWakeUpUser( pxSocket );
 				}
-				#endif /* ipconfigUSE_TCP */
-				break;
+			}
+			#endif /* ipconfigUSE_TCP */
+			break;
 
-			default :
-				/* Should not get here. */
-				break;
-		}
+		case eTCPNetStat:
+			/* FreeRTOS_netstat() was called to have the IP-task print an
+			overview of all sockets and their connections */
+			#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigHAS_PRINTF == 1 ) )
+			{
+				vTCPNetStat();
+			}
+			#endif /* ipconfigUSE_TCP */
+			break;
 
-		if( xNetworkDownEventPending != pdFALSE )
-		{
-			/* A network down event could not be posted to the network event
-			queue because the queue was full.  Try posting again. */
-			FreeRTOS_NetworkDown();
-		}
+		default :
+			/* Should not get here. */
+			break;
 	}
+
+	return uxCount;
 }
 /*-----------------------------------------------------------*/
 
@@ -540,14 +814,18 @@ BaseType_t xReturn;
 }
 /*-----------------------------------------------------------*/
 
-static void prvHandleEthernetPacket( NetworkBufferDescriptor_t *pxBuffer )
+static UBaseType_t prvHandleEthernetPacket( NetworkBufferDescriptor_t *pxBuffer, UBaseType_t uxMaxCount )
 {
+UBaseType_t uxCount = 0u;
+
 	#if( ipconfigUSE_LINKED_RX_MESSAGES == 0 )
 	{
 		/* When ipconfigUSE_LINKED_RX_MESSAGES is not set to 0 then only one
 		buffer will be sent at a time.  This is the default way for +TCP to pass
 		messages from the MAC to the TCP/IP stack. */
+		( void ) uxMaxCount;
 		prvProcessEthernetPacket( pxBuffer );
+		uxCount++;
 	}
 	#else /* ipconfigUSE_LINKED_RX_MESSAGES */
 	{
@@ -567,16 +845,58 @@ static void prvHandleEthernetPacket( NetworkBufferDescriptor_t *pxBuffer )
 			/* Make it NULL to avoid using it later on. */
 			pxBuffer->pxNextBuffer = NULL;
 
+			#if( ipconfigUSE_TCP_GRO != 0 )
+			{
+				/* Let TCP see whether the next packet continues the current
+				segment, so that it can send one ACK for both. */
+				vTCPSetNextReceivedBuffer( ( uxCount + 1u < uxMaxCount ) ? pxNextBuffer : NULL );
+			}
+			#endif /* ipconfigUSE_TCP_GRO */
+
 			prvProcessEthernetPacket( pxBuffer );
 			pxBuffer = pxNextBuffer;
+			uxCount++;
 
 		/* While there is another packet in the chain. */
-		} while( pxBuffer != NULL );
+		} while( ( pxBuffer != NULL ) && ( uxCount < uxMaxCount ) );
+
+		#if( ipconfigUSE_TCP_GRO != 0 )
+		{
+			vTCPSetNextReceivedBuffer( NULL );
+		}
+		#endif /* ipconfigUSE_TCP_GRO */
+
+		/* To give the timers and the other events a chance, the rest of a
+		long chain will be handled in the next round of the IP-task. */
+		pxPendingRxChain = pxBuffer;
 	}
 	#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+	return uxCount;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+
+	static UBaseType_t prvHandlePendingRxChain( void )
+	{
+	NetworkBufferDescriptor_t *pxBuffer = pxPendingRxChain;
+	UBaseType_t uxCount = 0u;
+
+		if( pxBuffer != NULL )
+		{
+			/* prvHandleEthernetPacket() will store what is left of the
+			chain. */
+			pxPendingRxChain = NULL;
+			uxCount = prvHandleEthernetPacket( pxBuffer, ( UBaseType_t ) ipconfigMAX_IP_TASK_BURST );
+		}
+
+		return uxCount;
+	}
+
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+/*-----------------------------------------------------------*/
+
 static TickType_t prvCalculateSleepTime( void )
 {
 TickType_t xMaximumSleepTime;
@@ -626,6 +946,18 @@ TickType_t xMaximumSleepTime;
 	}
 	#endif
 
+	#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+	{
+		if( xReassemblyTimer.bActive != pdFALSE_UNSIGNED )
+		{
+			if( xReassemblyTimer.ulRemainingTime < xMaximumSleepTime )
+			{
+				xMaximumSleepTime = xReassemblyTimer.ulRemainingTime;
+			}
+		}
+	}
+	#endif
+
 	return xMaximumSleepTime;
 }
 /*-----------------------------------------------------------*/
@@ -660,6 +992,16 @@ static void prvCheckNetworkTimers( void )
 	}
 	#endif /* ipconfigDNS_USE_CALLBACKS */
 
+	#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+	{
+		/* Is it time to look for incomplete datagrams? */
+		if( prvIPTimerCheck( &xReassemblyTimer ) != pdFALSE )
+		{
+			prvIPReassemblyCheck();
+		}
+	}
+	#endif /* ipconfigUSE_IP_REASSEMBLY */
+
 	#if( ipconfigUSE_TCP == 1 )
 	{
 	BaseType_t xWillSleep;
@@ -675,6 +1017,16 @@ static void prvCheckNetworkTimers( void )
 			xWillSleep = pdFALSE;
 		}
 
+		#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+		{
+			/* There are still received packets to be handled. */
+			if( pxPendingRxChain != NULL )
+			{
+				xWillSleep = pdFALSE;
+			}
+		}
+		#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
 		/* Sockets need to be checked if the TCP timer has expired. */
 		xCheckTCPSockets = prvIPTimerCheck( &xTCPTimer );
 
@@ -1120,6 +1472,11 @@ void FreeRTOS_SetAddressConfiguration( const uint32_t *pulIPAddress, const uint3
 				/* The message is complete, IP and checksum's are handled by
 				vProcessGeneratedUDPPacket */
 				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] = FREERTOS_SO_UDPCKSUM_OUT;
+				#if( ipconfigUSE_DSCP != 0 )
+				{
+					pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_DSCP_OFFSET ] = 0u;
+				}
+				#endif
 				pxNetworkBuffer->ulIPAddress = ulIPAddress;
 				pxNetworkBuffer->usPort = ipPACKET_CONTAINS_ICMP_DATA;
 				/* xDataLength is the size of the total packet, including the Ethernet header. */
@@ -1212,6 +1569,15 @@ BaseType_t xReturn, xSendMessage;
 				/* A message should have been sent to the IP task, but wasn't. */
 				FreeRTOS_debug_printf( ( "xSendEventStructToIPTask: CAN NOT ADD %d\n", pxEvent->eEventType ) );
 				iptraceSTACK_TX_EVENT_LOST( pxEvent->eEventType );
+				#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+				{
+					taskENTER_CRITICAL();
+					{
+						xIPCounters.ulEventsLost++;
+					}
+					taskEXIT_CRITICAL();
+				}
+				#endif
 			}
 		}
 		else
@@ -1366,13 +1732,19 @@ eFrameProcessingResult_t eReturned = eReleaseBuffer;
 
 	configASSERT( pxNetworkBuffer );
 
+	ipCOUNT_IP_EVENT( ulRxFrames );
+
 	/* Interpret the Ethernet frame. */
 	if( pxNetworkBuffer->xDataLength >= sizeof( EthernetHeader_t ) )
 	{
 		eReturned = ipCONSIDER_FRAME_FOR_PROCESSING( pxNetworkBuffer->pucEthernetBuffer );
 		pxEthernetHeader = ( EthernetHeader_t * )( pxNetworkBuffer->pucEthernetBuffer );
 
-		if( eReturned == eProcessBuffer )
+		if( eReturned != eProcessBuffer )
+		{
+			ipCOUNT_IP_EVENT( ulRxDropFiltered );
+		}
+		else
 		{
 			/* Interpret the received Ethernet packet. */
 			switch( pxEthernetHeader->usFrameType )
@@ -1385,6 +1757,7 @@ eFrameProcessingResult_t eReturned = eReleaseBuffer;
 				}
 				else
 				{
+					ipCOUNT_IP_EVENT( ulRxDropMalformed );
 					eReturned = eReleaseBuffer;
 				}
 				break;
@@ -1397,17 +1770,23 @@ eFrameProcessingResult_t eReturned = eReleaseBuffer;
 				}
 				else
 				{
+					ipCOUNT_IP_EVENT( ulRxDropMalformed );
 					eReturned = eReleaseBuffer;
 				}
 				break;
 
 			default:
 				/* No other packet types are handled.  Nothing to do. */
+				ipCOUNT_IP_EVENT( ulRxDropMalformed );
 				eReturned = eReleaseBuffer;
 				break;
 			}
 		}
 	}
+	else
+	{
+		ipCOUNT_IP_EVENT( ulRxDropMalformed );
+	}
 
 	/* Perform any actions that resulted from processing the Ethernet frame. */
 	switch( eReturned )
@@ -1456,19 +1835,24 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 		This method may decrease the usage of sparse network buffers. */
 		uint32_t ulDestinationIPAddress = pxIPHeader->ulDestinationIPAddress;
 
+		#if( ipconfigUSE_IP_REASSEMBLY == 0 )
 			/* Ensure that the incoming packet is not fragmented (only outgoing
 			packets can be fragmented) as these are the only handled IP frames
 			currently. */
 			if( ( pxIPHeader->usFragmentOffset & ipFRAGMENT_OFFSET_BIT_MASK ) != 0U )
 			{
 				/* Can not handle, fragmented packet. */
+				ipCOUNT_IP_EVENT( ulRxDropFragment );
 				eReturn = eReleaseBuffer;
 			}
+			else
+		#endif /* ipconfigUSE_IP_REASSEMBLY */
 			/* 0x45 means: IPv4 with an IP header of 5 x 4 = 20 bytes
 			 * 0x47 means: IPv4 with an IP header of 7 x 4 = 28 bytes */
-			else if( ( pxIPHeader->ucVersionHeaderLength < 0x45u ) || ( pxIPHeader->ucVersionHeaderLength > 0x4Fu ) )
+			if( ( pxIPHeader->ucVersionHeaderLength < 0x45u ) || ( pxIPHeader->ucVersionHeaderLength > 0x4Fu ) )
 			{
 				/* Can not handle, unknown or invalid header version. */
+				ipCOUNT_IP_EVENT( ulRxDropMalformed );
 				eReturn = eReleaseBuffer;
 			}
 				/* Is the packet for this IP address? */
@@ -1485,6 +1869,7 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 				( *ipLOCAL_IP_ADDRESS_POINTER != 0UL ) )
 			{
 				/* Packet is not for this node, release it */
+				ipCOUNT_IP_EVENT( ulRxDropNotForUs );
 				eReturn = eReleaseBuffer;
 			}
 	}
@@ -1501,12 +1886,20 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 				( usGenerateChecksum( 0UL, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ( size_t ) uxHeaderLength ) != ipCORRECT_CRC ) )
 			{
 				/* Check sum in IP-header not correct. */
+				ipCOUNT_IP_EVENT( ulRxDropChecksum );
 				eReturn = eReleaseBuffer;
 			}
-			/* Is the upper-layer checksum (TCP/UDP/ICMP) correct? */
-			else if( usGenerateProtocolChecksum( ( uint8_t * )( pxNetworkBuffer->pucEthernetBuffer ), pxNetworkBuffer->xDataLength, pdFALSE ) != ipCORRECT_CRC )
+			/* Is the upper-layer checksum (TCP/UDP/ICMP) correct?  A fragment
+			only holds part of the data, its checksum is checked after
+			reassembly. */
+			else if(
+			#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+				( ( pxIPHeader->usFragmentOffset & ipFRAGMENTED_PACKET_BIT_MASK ) == 0U ) &&
+			#endif
+				( usGenerateProtocolChecksum( ( uint8_t * )( pxNetworkBuffer->pucEthernetBuffer ), pxNetworkBuffer->xDataLength, pdFALSE ) != ipCORRECT_CRC ) )
 			{
 				/* Protocol checksum not accepted. */
+				ipCOUNT_IP_EVENT( ulRxDropChecksum );
 				eReturn = eReleaseBuffer;
 			}
 		}
@@ -1536,6 +1929,7 @@ uint8_t ucProtocol;
 	if( ( uxHeaderLength > ( pxNetworkBuffer->xDataLength - ipSIZE_OF_ETH_HEADER ) ) ||
 		( uxHeaderLength < ipSIZE_OF_IPv4_HEADER ) )
 	{
+		ipCOUNT_IP_EVENT( ulRxDropMalformed );
 		return eReleaseBuffer;
 	}
 
@@ -1566,6 +1960,24 @@ uint8_t ucProtocol;
 												( ( ipSIZE_OF_IPv4_HEADER >> 2 ) & 0x0F ); /* Low nibble is the header size, in bytes, divided by four. */
 		}
 
+		#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+		{
+			if( ( pxIPHeader->usFragmentOffset & ipFRAGMENTED_PACKET_BIT_MASK ) != 0U )
+			{
+				if( ucProtocol == ( uint8_t ) ipPROTOCOL_UDP )
+				{
+					/* The fragment will be stored until its datagram is
+					complete, which will then be processed separately. */
+					return prvIPReassemble( pxNetworkBuffer, uxHeaderLength );
+				}
+
+				/* Only UDP datagrams are reassembled. */
+				ipCOUNT_IP_EVENT( ulRxDropFragment );
+				return eReleaseBuffer;
+			}
+		}
+		#endif /* ipconfigUSE_IP_REASSEMBLY */
+
 		/* Add the IP and MAC addresses to the ARP table if they are not
 		already there - otherwise refresh the age of the existing
 		entry. */
@@ -1679,6 +2091,347 @@ uint8_t ucProtocol;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_IP_REASSEMBLY != 0 )
+
+	static eFrameProcessingResult_t prvIPReassemble( NetworkBufferDescriptor_t * const pxNetworkBuffer, UBaseType_t uxHeaderLength )
+	{
+	const IPHeader_t *pxIPHeader = &( ( ( const IPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer )->xIPHeader );
+	IPReassembly_t *pxEntry = NULL;
+	IPReassembly_t *pxOldest;
+	const ListItem_t *pxIterator;
+	const ListItem_t *pxEnd;
+	const NetworkBufferDescriptor_t *pxFragment;
+	uint16_t usFragmentOffset = FreeRTOS_ntohs( pxIPHeader->usFragmentOffset );
+	BaseType_t xMoreFragments = ( ( usFragmentOffset & ipFRAGMENT_FLAGS_MORE_FRAGMENTS ) != 0u ) ? pdTRUE : pdFALSE;
+	size_t uxOffset = ( ( size_t ) ( usFragmentOffset & ipFRAGMENT_OFFSET_MASK ) ) << 3;
+	size_t uxLength = ( size_t ) FreeRTOS_ntohs( pxIPHeader->usLength );
+	size_t uxFragmentOffset, uxFragmentLength;
+	BaseType_t xIndex, xValid = pdTRUE;
+
+		/* The payload length of this fragment.  The IP options, if any, have
+		been removed already, but the IP length still counts them. */
+		if( ( uxLength <= ( size_t ) uxHeaderLength ) ||
+			( ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ( uxLength - uxHeaderLength ) ) > pxNetworkBuffer->xDataLength ) )
+		{
+			ipCOUNT_IP_EVENT( ulRxDropMalformed );
+			return eReleaseBuffer;
+		}
+
+		uxLength -= uxHeaderLength;
+
+		/* All fragments but the last must carry a multiple of 8 bytes, and
+		the datagram must not become longer than allowed. */
+		if( ( ( xMoreFragments != pdFALSE ) && ( ( uxLength & 0x07u ) != 0u ) ) ||
+			( ( uxOffset + uxLength ) > ( size_t ) ipconfigIP_REASSEMBLY_MAX_SIZE ) )
+		{
+			ipCOUNT_IP_EVENT( ulRxDropFragment );
+			return eReleaseBuffer;
+		}
+
+		/* Look for the datagram that this fragment belongs to. */
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIP_REASSEMBLY_MAX_PACKETS; xIndex++ )
+		{
+		IPReassembly_t *pxCandidate = &( xReassemblyTable[ xIndex ] );
+
+			if( listLIST_IS_EMPTY( &( pxCandidate->xFragments ) ) != pdFALSE )
+			{
+				if( pxEntry == NULL )
+				{
+					/* Remember the first free entry, in case this is a new
+					datagram. */
+					pxEntry = pxCandidate;
+				}
+			}
+			else if( ( pxCandidate->usIdentification == pxIPHeader->usIdentification ) &&
+					 ( pxCandidate->ulSourceIPAddress == pxIPHeader->ulSourceIPAddress ) &&
+					 ( pxCandidate->ulDestinationIPAddress == pxIPHeader->ulDestinationIPAddress ) &&
+					 ( pxCandidate->ucProtocol == pxIPHeader->ucProtocol ) )
+			{
+				pxEntry = pxCandidate;
+				break;
+			}
+		}
+
+		if( ( pxEntry == NULL ) || ( listLIST_IS_EMPTY( &( pxEntry->xFragments ) ) != pdFALSE ) )
+		{
+			/* The first fragment of a new datagram.  If all entries are in
+			use, the oldest datagram is given up. */
+			if( pxEntry == NULL )
+			{
+				pxEntry = prvIPReassemblyOldest( NULL );
+				configASSERT( pxEntry != NULL );
+				FreeRTOS_debug_printf( ( "prvIPReassemble: no free entry, drop ID %u\n", FreeRTOS_ntohs( pxEntry->usIdentification ) ) );
+				prvIPReassemblyRelease( pxEntry );
+			}
+
+			pxEntry->ulSourceIPAddress = pxIPHeader->ulSourceIPAddress;
+			pxEntry->ulDestinationIPAddress = pxIPHeader->ulDestinationIPAddress;
+			pxEntry->usIdentification = pxIPHeader->usIdentification;
+			pxEntry->ucProtocol = pxIPHeader->ucProtocol;
+			pxEntry->uxReceivedLength = 0u;
+			pxEntry->uxTotalLength = 0u;
+			pxEntry->xStartTime = xTaskGetTickCount();
+
+			if( xReassemblyTimer.bActive == pdFALSE_UNSIGNED )
+			{
+				prvIPTimerReload( &xReassemblyTimer, pdMS_TO_TICKS( ipIP_REASSEMBLY_TIMER_PERIOD_MS ) );
+			}
+		}
+
+		/* Stay within the budget of network buffers, by giving up the oldest
+		other datagrams. */
+		while( uxReassemblyBuffers >= ( UBaseType_t ) ipconfigIP_REASSEMBLY_MAX_BUFFERS )
+		{
+			pxOldest = prvIPReassemblyOldest( pxEntry );
+
+			if( pxOldest == NULL )
+			{
+				/* This datagram alone uses all buffers. */
+				xValid = pdFALSE;
+				break;
+			}
+
+			FreeRTOS_debug_printf( ( "prvIPReassemble: out of buffers, drop ID %u\n", FreeRTOS_ntohs( pxOldest->usIdentification ) ) );
+			prvIPReassemblyRelease( pxOldest );
+		}
+
+		if( xMoreFragments == pdFALSE )
+		{
+			/* The last fragment tells the length of the datagram. */
+			if( ( pxEntry->uxTotalLength != 0u ) && ( pxEntry->uxTotalLength != ( uxOffset + uxLength ) ) )
+			{
+				xValid = pdFALSE;
+			}
+			else
+			{
+				pxEntry->uxTotalLength = uxOffset + uxLength;
+			}
+		}
+		else if( ( pxEntry->uxTotalLength != 0u ) && ( ( uxOffset + uxLength ) >= pxEntry->uxTotalLength ) )
+		{
+			xValid = pdFALSE;
+		}
+		else
+		{
+			/* Nothing to check. */
+		}
+
+		/* Overlapping fragments are not accepted, they would allow to
+		overwrite data that has been checked already.  An exact copy of a
+		fragment that was received earlier is ignored. */
+		pxEnd = listGET_END_MARKER( &( pxEntry->xFragments ) );
+
+		for( pxIterator = listGET_HEAD_ENTRY( &( pxEntry->xFragments ) ); ( xValid != pdFALSE ) && ( pxIterator != pxEnd ); pxIterator = listGET_NEXT( pxIterator ) )
+		{
+			pxFragment = ( const NetworkBufferDescriptor_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+			uxFragmentOffset = ( size_t ) listGET_LIST_ITEM_VALUE( pxIterator );
+			uxFragmentLength = pxFragment->xDataLength - ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER );
+
+			if( ( uxFragmentOffset == uxOffset ) && ( uxFragmentLength == uxLength ) )
+			{
+				/* A duplicate. */
+				return eReleaseBuffer;
+			}
+
+			if( ( ( uxOffset < ( uxFragmentOffset + uxFragmentLength ) ) && ( uxFragmentOffset < ( uxOffset + uxLength ) ) ) ||
+				( ( pxEntry->uxTotalLength != 0u ) && ( ( uxFragmentOffset + uxFragmentLength ) > pxEntry->uxTotalLength ) ) )
+			{
+				xValid = pdFALSE;
+			}
+		}
+
+		if( xValid == pdFALSE )
+		{
+			FreeRTOS_debug_printf( ( "prvIPReassemble: drop ID %u\n", FreeRTOS_ntohs( pxEntry->usIdentification ) ) );
+			ipCOUNT_IP_EVENT( ulRxReassemblyFailed );
+			prvIPReassemblyRelease( pxEntry );
+			return eReleaseBuffer;
+		}
+
+		/* Strip the padding, so that the length of a fragment can be derived
+		from xDataLength. */
+		pxNetworkBuffer->xDataLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + uxLength;
+		listSET_LIST_ITEM_VALUE( &( pxNetworkBuffer->xBufferListItem ), ( TickType_t ) uxOffset );
+		vListInsert( &( pxEntry->xFragments ), &( pxNetworkBuffer->xBufferListItem ) );
+		uxReassemblyBuffers++;
+		pxEntry->uxReceivedLength += uxLength;
+
+		/* As fragments do not overlap, the datagram is complete when all of
+		its bytes have been received. */
+		if( ( pxEntry->uxTotalLength != 0u ) && ( pxEntry->uxReceivedLength == pxEntry->uxTotalLength ) )
+		{
+			prvIPReassemblyComplete( pxEntry );
+		}
+
+		return eFrameConsumed;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvIPReassemblyComplete( IPReassembly_t *pxEntry )
+	{
+	NetworkBufferDescriptor_t *pxNewBuffer = NULL;
+	const NetworkBufferDescriptor_t *pxFragment;
+	const ListItem_t *pxIterator;
+	const ListItem_t *pxEnd;
+	IPHeader_t *pxIPHeader;
+	size_t uxDataLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + pxEntry->uxTotalLength;
+
+		/* Fixed-size network buffers can not hold more than an MTU. */
+		if( ( xBufferAllocFixedSize == pdFALSE ) ||
+			( uxDataLength <= ( size_t ) ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ) ) )
+		{
+			pxNewBuffer = pxGetNetworkBufferWithDescriptor( uxDataLength, ( TickType_t ) 0u );
+		}
+
+		if( pxNewBuffer != NULL )
+		{
+			pxNewBuffer->xDataLength = uxDataLength;
+
+			/* The Ethernet and IP headers are taken from the first fragment. */
+			pxIterator = listGET_HEAD_ENTRY( &( pxEntry->xFragments ) );
+			pxEnd = listGET_END_MARKER( &( pxEntry->xFragments ) );
+			pxFragment = ( const NetworkBufferDescriptor_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+			memcpy( pxNewBuffer->pucEthernetBuffer, pxFragment->pucEthernetBuffer, ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER );
+
+			for( ; pxIterator != pxEnd; pxIterator = listGET_NEXT( pxIterator ) )
+			{
+				pxFragment = ( const NetworkBufferDescriptor_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+				memcpy( &( pxNewBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ( size_t ) listGET_LIST_ITEM_VALUE( pxIterator ) ] ),
+						&( pxFragment->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER ] ),
+						pxFragment->xDataLength - ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER ) );
+			}
+
+			/* Turn the header into that of an unfragmented packet. */
+			pxIPHeader = &( ( ( IPPacket_t * ) pxNewBuffer->pucEthernetBuffer )->xIPHeader );
+			pxIPHeader->usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + pxEntry->uxTotalLength ) );
+			pxIPHeader->usFragmentOffset = 0u;
+			pxIPHeader->usHeaderChecksum = 0u;
+			pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+			pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+		}
+		else
+		{
+			FreeRTOS_debug_printf( ( "prvIPReassemblyComplete: no buffer for %lu bytes\n", ( uint32_t ) uxDataLength ) );
+			ipCOUNT_IP_EVENT( ulRxReassemblyFailed );
+		}
+
+		/* The fragments are not needed any more. */
+		prvIPReassemblyRelease( pxEntry );
+
+		if( pxNewBuffer != NULL )
+		{
+			ipCOUNT_IP_EVENT( ulRxReassembled );
+
+			#if( ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM != 0 )
+			{
+				/* The driver could only check the fragments, not the checksum
+				of the protocol, which covers the whole datagram. */
+				if( usGenerateProtocolChecksum( pxNewBuffer->pucEthernetBuffer, pxNewBuffer->xDataLength, pdFALSE ) != ipCORRECT_CRC )
+				{
+					ipCOUNT_IP_EVENT( ulRxDropChecksum );
+					vReleaseNetworkBufferAndDescriptor( pxNewBuffer );
+					pxNewBuffer = NULL;
+				}
+			}
+			#endif /* ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM */
+		}
+
+		if( pxNewBuffer != NULL )
+		{
+		IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+
+			/* Pass the datagram to the IP-task as if it had been received in
+			one piece.  It is not processed here, because the fragment that
+			completed it is still being handled, and a new event counts for
+			the burst of the IP-task like any other packet. */
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+			{
+				pxNewBuffer->pxNextBuffer = NULL;
+			}
+			#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+			xRxEvent.pvData = ( void * ) pxNewBuffer;
+
+			if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+			{
+				/* The lost event has been counted already. */
+				vReleaseNetworkBufferAndDescriptor( pxNewBuffer );
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static IPReassembly_t *prvIPReassemblyOldest( const IPReassembly_t *pxExclude )
+	{
+	IPReassembly_t *pxOldest = NULL;
+	TickType_t xNow = xTaskGetTickCount();
+	BaseType_t xIndex;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIP_REASSEMBLY_MAX_PACKETS; xIndex++ )
+		{
+		IPReassembly_t *pxEntry = &( xReassemblyTable[ xIndex ] );
+
+			if( ( pxEntry != pxExclude ) && ( listLIST_IS_EMPTY( &( pxEntry->xFragments ) ) == pdFALSE ) )
+			{
+				if( ( pxOldest == NULL ) || ( ( xNow - pxEntry->xStartTime ) > ( xNow - pxOldest->xStartTime ) ) )
+				{
+					pxOldest = pxEntry;
+				}
+			}
+		}
+
+		return pxOldest;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvIPReassemblyRelease( IPReassembly_t *pxEntry )
+	{
+	NetworkBufferDescriptor_t *pxFragment;
+
+		while( listLIST_IS_EMPTY( &( pxEntry->xFragments ) ) == pdFALSE )
+		{
+			pxFragment = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxEntry->xFragments ) );
+			( void ) uxListRemove( &( pxFragment->xBufferListItem ) );
+			vReleaseNetworkBufferAndDescriptor( pxFragment );
+			uxReassemblyBuffers--;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvIPReassemblyCheck( void )
+	{
+	TickType_t xNow = xTaskGetTickCount();
+	BaseType_t xIndex, xInUse = pdFALSE;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIP_REASSEMBLY_MAX_PACKETS; xIndex++ )
+		{
+		IPReassembly_t *pxEntry = &( xReassemblyTable[ xIndex ] );
+
+			if( listLIST_IS_EMPTY( &( pxEntry->xFragments ) ) == pdFALSE )
+			{
+				if( ( xNow - pxEntry->xStartTime ) >= pdMS_TO_TICKS( ipconfigIP_REASSEMBLY_TIMEOUT_MS ) )
+				{
+					FreeRTOS_debug_printf( ( "prvIPReassemblyCheck: timeout ID %u\n", FreeRTOS_ntohs( pxEntry->usIdentification ) ) );
+					ipCOUNT_IP_EVENT( ulRxReassemblyFailed );
+					prvIPReassemblyRelease( pxEntry );
+				}
+				else
+				{
+					xInUse = pdTRUE;
+				}
+			}
+		}
+
+		if( xInUse == pdFALSE )
+		{
+			/* Nothing to wait for, stop the timer until a fragment arrives. */
+			xReassemblyTimer.bActive = pdFALSE_UNSIGNED;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_IP_REASSEMBLY */
+
 #if ( ipconfigSUPPORT_OUTGOING_PINGS == 1 )
 
 	static void prvProcessICMPEchoReply( ICMPPacket_t * const pxICMPPacket )
@@ -2202,11 +2955,231 @@ EthernetHeader_t *pxEthernetHeader;
 		memcpy( ( void * ) &( pxEthernetHeader->xSourceAddress) , ( void * ) ipLOCAL_MAC_ADDRESS, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
 
 		/* Send! */
-		xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+		ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend );
 	}
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TX_SCHEDULER != 0 )
+
+	static UBaseType_t prvTxSchedulerBand( const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	const UDPPacket_t *pxUDPPacket = ( const UDPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+	UBaseType_t uxBand;
+	uint8_t ucClass;
+
+		if( pxUDPPacket->xEthernetHeader.usFrameType != ipIPv4_FRAME_TYPE )
+		{
+			/* ARP. */
+			uxBand = ipTX_BAND_CONTROL;
+		}
+		else if( ( pxUDPPacket->xIPHeader.ucProtocol == ( uint8_t ) ipPROTOCOL_UDP ) &&
+				 ( pxUDPPacket->xUDPHeader.usSourcePort == FreeRTOS_htons( 68u ) ) )
+		{
+			/* The DHCP client. */
+			uxBand = ipTX_BAND_CONTROL;
+		}
+		else
+		{
+			/* The class selector: the 3 most significant bits of the DSCP
+			code point. */
+			ucClass = ( uint8_t ) ( pxUDPPacket->xIPHeader.ucDifferentiatedServicesCode >> 5 );
+
+			if( ucClass >= 6u )
+			{
+				/* CS6 and CS7: network control. */
+				uxBand = ipTX_BAND_CONTROL;
+			}
+			else if( ucClass >= 4u )
+			{
+				/* CS4, CS5, AF4x and EF: real-time and interactive. */
+				uxBand = ipTX_BAND_INTERACTIVE;
+			}
+			else if( ucClass == 1u )
+			{
+				/* CS1 and AF1x: low-priority data. */
+				uxBand = ipTX_BAND_BULK;
+			}
+			else
+			{
+				uxBand = ipTX_BAND_BEST_EFFORT;
+			}
+		}
+
+		return uxBand;
+	}
+	/*-----------------------------------------------------------*/
+
+	static NetworkBufferDescriptor_t *prvTxSchedulerNext( UBaseType_t *puxBand )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	TxBand_t *pxBand;
+
+		if( listLIST_IS_EMPTY( &( xTxBands[ ipTX_BAND_CONTROL ].xPackets ) ) == pdFALSE )
+		{
+			pxBand = &( xTxBands[ ipTX_BAND_CONTROL ] );
+			pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxBand->xPackets ) );
+			*puxBand = ipTX_BAND_CONTROL;
+		}
+		else
+		{
+			/* Some band has a packet waiting, and its deficit grows with
+			every round, so this loop ends. */
+			for( ;; )
+			{
+				pxBand = &( xTxBands[ uxTxCurrentBand ] );
+
+				if( listLIST_IS_EMPTY( &( pxBand->xPackets ) ) == pdFALSE )
+				{
+					pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxBand->xPackets ) );
+
+					if( ( int32_t ) pxNetworkBuffer->xDataLength <= pxBand->lDeficit )
+					{
+						pxBand->lDeficit -= ( int32_t ) pxNetworkBuffer->xDataLength;
+						*puxBand = uxTxCurrentBand;
+						break;
+					}
+				}
+				else
+				{
+					/* An idle band can not save up its quantum. */
+					pxBand->lDeficit = 0;
+				}
+
+				/* Go to the next band, and give it its quantum. */
+				uxTxCurrentBand++;
+				if( uxTxCurrentBand >= ipTX_BAND_COUNT )
+				{
+					uxTxCurrentBand = ipTX_BAND_INTERACTIVE;
+				}
+
+				xTxBands[ uxTxCurrentBand ].lDeficit += ( int32_t ) ucTxBandWeight[ uxTxCurrentBand ] * ( int32_t ) ipconfigTX_SCHEDULER_QUANTUM;
+			}
+		}
+
+		return pxNetworkBuffer;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvTxSchedulerSendNext( void )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	UBaseType_t uxBand;
+	BaseType_t xReturn;
+
+		pxNetworkBuffer = prvTxSchedulerNext( &uxBand );
+
+		/* The scheduler owns the buffer until the driver has accepted it, a
+		refused packet can then be sent again. */
+		xReturn = xNetworkInterfaceOutput( pxNetworkBuffer, pdFALSE );
+
+		if( xReturn != pdFAIL )
+		{
+			( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+			uxTxWaiting--;
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+		}
+		else if( uxBand != ipTX_BAND_CONTROL )
+		{
+			/* The packet stays at the head of its band, give the band its
+			bytes back so it will be chosen again. */
+			xTxBands[ uxBand ].lDeficit += ( int32_t ) pxNetworkBuffer->xDataLength;
+		}
+		else
+		{
+			/* The control band is always served first. */
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTxSchedulerRun( void )
+	{
+		xTxDriverBusy = pdFALSE;
+
+		while( ( uxTxBudget > 0u ) && ( uxTxWaiting != 0u ) )
+		{
+			uxTxBudget--;
+
+			if( prvTxSchedulerSendNext() == pdFAIL )
+			{
+				/* The driver has no space or the link is down, the packets
+				keep waiting until the next round. */
+				xTxDriverBusy = pdTRUE;
+				break;
+			}
+		}
+
+		uxTxBudget = ( UBaseType_t ) ipconfigTX_SCHEDULER_BURST;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xTxSchedulerOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+	{
+	NetworkBufferDescriptor_t *pxQueuedBuffer;
+	UBaseType_t uxBand;
+	BaseType_t xReturn;
+
+		if( xIsCallingFromIPTask() == pdFALSE )
+		{
+			/* The scheduler belongs to the IP-task. */
+			return xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+		}
+
+		uxBand = prvTxSchedulerBand( pxNetworkBuffer );
+
+		if( ( ( uxTxWaiting == 0u ) && ( uxTxBudget > 0u ) ) ||
+			( ( uxBand == ipTX_BAND_CONTROL ) && ( listLIST_IS_EMPTY( &( xTxBands[ ipTX_BAND_CONTROL ].xPackets ) ) != pdFALSE ) ) )
+		{
+			/* Nothing to overtake: send it right away. */
+			if( uxTxBudget > 0u )
+			{
+				uxTxBudget--;
+			}
+			xReturn = xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+		}
+		else
+		{
+			if( xReleaseAfterSend != pdFALSE )
+			{
+				pxQueuedBuffer = pxNetworkBuffer;
+			}
+			else
+			{
+				/* The caller will use its buffer again, the scheduler keeps
+				a copy. */
+				pxQueuedBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+			}
+
+			if( pxQueuedBuffer == NULL )
+			{
+				/* Better late ordering than a lost packet. */
+				xReturn = xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+			}
+			else if( ( uxTxWaiting >= ( UBaseType_t ) ipconfigTX_SCHEDULER_MAX_PACKETS ) &&
+					 ( prvTxSchedulerSendNext() == pdFAIL ) )
+			{
+				/* The scheduler is full and the driver refuses to take the
+				most urgent packet: drop the new one. */
+				xTxDriverBusy = pdTRUE;
+				vReleaseNetworkBufferAndDescriptor( pxQueuedBuffer );
+				xReturn = pdFAIL;
+			}
+			else
+			{
+				vListInsertEnd( &( xTxBands[ uxBand ].xPackets ), &( pxQueuedBuffer->xBufferListItem ) );
+				uxTxWaiting++;
+				xReturn = pdPASS;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_TX_SCHEDULER */
+/*-----------------------------------------------------------*/
+
 uint32_t FreeRTOS_GetIPAddress( void )
 {
 	/* Returns the IP address of the NIC. */
@@ -2330,6 +3303,26 @@ BaseType_t FreeRTOS_IsNetworkUp( void )
 #endif
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+	void FreeRTOS_GetIPCounters( IPCounters_t *pxCounters )
+	{
+		configASSERT( pxCounters != NULL );
+
+		/* The counters are updated by the IP-task, take a consistent copy. */
+		taskENTER_CRITICAL();
+		{
+			memcpy( pxCounters, &xIPCounters, sizeof( *pxCounters ) );
+		}
+		taskEXIT_CRITICAL();
+	}
+#endif /* ipconfigUSE_PERFORMANCE_COUNTERS */
+/*-----------------------------------------------------------*/
+
+/* Provide access to private members for testing. */
+#ifdef AMAZON_FREERTOS_ENABLE_UNIT_TESTS
+	#include "iot_freertos_tcp_test_access_ip_define.h"
+#endif
+
 /* Provide access to private members for verification. */
 #ifdef FREERTOS_TCP_ENABLE_VERIFICATION
 	#include "aws_freertos_ip_verification_access_ip_define.h"
@@ -71,6 +71,15 @@ range 1024-65535" excluding those already in use (inbound or outbound). */
 /* A block time of 0 simply means "don't block". */
 #define socketDONT_BLOCK				( ( TickType_t ) 0 )
 
+/* The largest payload that can be sent in a UDP packet.  Beyond the MTU, the
+packet is sent as IP fragments, which needs network buffers of a variable
+size. */
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	#define socketMAX_UDP_PAYLOAD_LENGTH	( ( xBufferAllocFixedSize == pdFALSE ) ? ( size_t ) ipconfigIP_FRAGMENTATION_MAX_SIZE : ( size_t ) ipMAX_UDP_PAYLOAD_LENGTH )
+#else
+	#define socketMAX_UDP_PAYLOAD_LENGTH	( ( size_t ) ipMAX_UDP_PAYLOAD_LENGTH )
+#endif
+
 #if( ( ipconfigUSE_TCP == 1 ) && !defined( ipTCP_TIMER_PERIOD_MS ) )
 	#define ipTCP_TIMER_PERIOD_MS	( 1000 )
 #endif
@@ -122,6 +131,12 @@ static BaseType_t prvValidSocket( FreeRTOS_Socket_t *pxSocket, BaseType_t xProto
  */
 static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType, BaseType_t xProtocol, size_t *pxSocketSize );
 
+/*
+ * Wait until a UDP socket has received a packet, or until the block time has
+ * passed.  Returns the number of waiting packets.
+ */
+static BaseType_t prvRecvFromWaitForPacket( FreeRTOS_Socket_t *pxSocket, BaseType_t xFlags, EventBits_t *pxEventBits );
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * Create a txStream or a rxStream, depending on the parameter 'xIsInputStream'
@@ -129,6 +144,28 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	static StreamBuffer_t *prvTCPCreateStream (FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream );
 #endif /* ipconfigUSE_TCP == 1 */
 
+#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+	/*
+	 * Called from FreeRTOS_recv(): copy and/or consume (when 'xPeek' is false)
+	 * reception data from the network buffers in 'xRxBufferList'.  When
+	 * 'pucBuffer' is NULL, no data will be copied.  Returns the number of bytes
+	 * taken from the network buffers.
+	 */
+	static size_t prvTCPRxBufferGet( FreeRTOS_Socket_t *pxSocket, uint8_t *pucBuffer, size_t uxMaxLength, BaseType_t xPeek );
+
+	/*
+	 * Let '*ppucData' point to the first unread byte in 'xRxBufferList' and
+	 * return the number of contiguous bytes.  Returns -1 when the list is
+	 * empty.
+	 */
+	static BaseType_t prvTCPRxBufferGetPtr( FreeRTOS_Socket_t *pxSocket, uint8_t **ppucData );
+
+	/*
+	 * Release all network buffers in 'xRxBufferList'.
+	 */
+	static void prvTCPRxBufferFlush( FreeRTOS_Socket_t *pxSocket );
+#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * Called from FreeRTOS_send(): some checks which will be done before
@@ -158,6 +195,31 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	static FreeRTOS_Socket_t *prvFindSelectedSocket( SocketSelect_t *pxSocketSet );
 
 #endif /* ipconfigSUPPORT_SELECT_FUNCTION == 1 */
+
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+	/* Bit in xPollGroup, set when a socket was put on the ready list. */
+	#define pollEVENT_READY		( ( EventBits_t ) 0x0001u )
+
+	/*
+	 * Return the poll events of which the condition is true at this moment.
+	 * Called with the scheduler suspended.
+	 */
+	static EventBits_t prvPollCurrentEvents( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Take a socket from its poll set.  Called with the scheduler suspended.
+	 */
+	static void prvPollUnlink( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Take up to xMaxEvents sockets from the ready list and report their
+	 * events.  Level-triggered sockets that are still ready are put back at
+	 * the end of the list.
+	 */
+	static BaseType_t prvPollCollect( PollSelect_t *pxPollSet, PollEvent_t *pxEvents, BaseType_t xMaxEvents );
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION == 1 */
 /*-----------------------------------------------------------*/
 
 /* The list that contains mappings between sockets and port numbers.  Accesses
@@ -333,6 +395,11 @@ Socket_t xReturn;
 					/* StreamSize is expressed in number of bytes */
 					/* Round up buffer sizes to nearest multiple of MSS */
 					pxSocket->u.xTCP.usInitMSS	= pxSocket->u.xTCP.usCurMSS = ipconfigTCP_MSS;
+					#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+					{
+						vListInitialise( &( pxSocket->u.xTCP.xRxBufferList ) );
+					}
+					#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
 					pxSocket->u.xTCP.uxRxStreamSize = ( size_t ) ipconfigTCP_RX_BUFFER_LENGTH;
 					pxSocket->u.xTCP.uxTxStreamSize = ( size_t ) FreeRTOS_round_up( ipconfigTCP_TX_BUFFER_LENGTH, ipconfigTCP_MSS );
 					/* Use half of the buffer size of the TCP windows */
@@ -347,6 +414,17 @@ Socket_t xReturn;
 						pxSocket->u.xTCP.uxTxWinSize  = 1u;
 					}
 					#endif
+					#if( ipconfigUSE_TCP_WIN == 1 )
+					{
+						pxSocket->u.xTCP.xTCPWindow.uxSegmentQuota = ( UBaseType_t ) ipconfigTCP_WIN_SEG_QUOTA;
+					}
+					#endif
+					#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+					{
+						pxSocket->u.xTCP.xTCPWindow.xCongestion.ucAlgorithm = ( uint8_t ) ipconfigTCP_CONGESTION_CONTROL_DEFAULT;
+						pxSocket->u.xTCP.xTCPWindow.xCongestion.u.bits.bPacing = ( ipconfigTCP_PACING_DEFAULT != 0 ) ? pdTRUE_UNSIGNED : pdFALSE_UNSIGNED;
+					}
+					#endif
 					/* The above values are just defaults, and can be overridden by
 					calling FreeRTOS_setsockopt().  No buffers will be allocated until a
 					socket is connected and data is exchanged. */
@@ -589,33 +667,364 @@ Socket_t xReturn;
 #endif /* ipconfigSUPPORT_SELECT_FUNCTION == 1 */
 /*-----------------------------------------------------------*/
 
-/*
- * FreeRTOS_recvfrom: receive data from a bound socket
- * In this library, the function can only be used with connectionsless sockets
- * (UDP)
- */
-int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags, struct freertos_sockaddr *pxSourceAddress, socklen_t *pxSourceAddressLength )
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+	PollSet_t FreeRTOS_CreatePollSet( void )
+	{
+	PollSelect_t *pxPollSet;
+
+		pxPollSet = ( PollSelect_t * ) pvPortMalloc( sizeof( *pxPollSet ) );
+
+		if( pxPollSet != NULL )
+		{
+			memset( pxPollSet, '\0', sizeof( *pxPollSet ) );
+			vListInitialise( &( pxPollSet->xReadyList ) );
+			pxPollSet->xPollGroup = xEventGroupCreate();
+
+			if( pxPollSet->xPollGroup == NULL )
+			{
+				vPortFree( ( void * ) pxPollSet );
+				pxPollSet = NULL;
+			}
+		}
+
+		return ( PollSet_t ) pxPollSet;
+	}
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+	void FreeRTOS_DeletePollSet( PollSet_t xPollSet )
+	{
+	PollSelect_t *pxPollSet = ( PollSelect_t * ) xPollSet;
+
+		/* The sockets still refer to the set. */
+		configASSERT( pxPollSet->uxSocketCount == 0u );
+
+		vEventGroupDelete( pxPollSet->xPollGroup );
+		vPortFree( ( void * ) pxPollSet );
+	}
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+	BaseType_t FreeRTOS_PollCtl( PollSet_t xPollSet, ePollCtl_t eOperation, Socket_t xSocket, EventBits_t xEvents, void *pvUserData )
+	{
+	PollSelect_t *pxPollSet = ( PollSelect_t * ) xPollSet;
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	EventBits_t xReady;
+	BaseType_t xReturn = 0;
+
+		configASSERT( pxPollSet != NULL );
+
+		if( ( pxSocket == NULL ) || ( pxSocket == FREERTOS_INVALID_SOCKET ) )
+		{
+			xReturn = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else
+		{
+			/* The IP-task may signal this socket at any moment. */
+			vTaskSuspendAll();
+			{
+				if( eOperation == ePOLL_CTL_ADD )
+				{
+					if( pxSocket->pxPollSet != NULL )
+					{
+						xReturn = -pdFREERTOS_ERRNO_EEXIST;
+					}
+					else
+					{
+						vListInitialiseItem( &( pxSocket->xPollListItem ) );
+						listSET_LIST_ITEM_OWNER( &( pxSocket->xPollListItem ), ( void * ) pxSocket );
+						pxSocket->xPollPending = 0u;
+						pxSocket->pxPollSet = pxPollSet;
+						pxPollSet->uxSocketCount++;
+					}
+				}
+				else if( pxSocket->pxPollSet != pxPollSet )
+				{
+					xReturn = -pdFREERTOS_ERRNO_ENOENT;
+				}
+				else if( eOperation == ePOLL_CTL_DEL )
+				{
+					prvPollUnlink( pxSocket );
+				}
+				else
+				{
+					/* ePOLL_CTL_MOD: events that are not of interest anymore
+					won't be reported. */
+					pxSocket->xPollPending &= xEvents;
+				}
+
+				if( ( xReturn == 0 ) && ( eOperation != ePOLL_CTL_DEL ) )
+				{
+					pxSocket->xPollEvents = xEvents & ( ePOLL_ALL | ePOLL_EDGE );
+					pxSocket->pvPollUserData = pvUserData;
+
+					/* Like epoll, a socket that is ready already will be
+					reported, also in edge-triggered mode. */
+					xReady = prvPollCurrentEvents( pxSocket ) & pxSocket->xPollEvents;
+
+					if( xReady != 0u )
+					{
+						pxSocket->xPollPending |= xReady;
+
+						if( listIS_CONTAINED_WITHIN( NULL, &( pxSocket->xPollListItem ) ) != pdFALSE )
+						{
+							vListInsertEnd( &( pxPollSet->xReadyList ), &( pxSocket->xPollListItem ) );
+						}
+
+						xEventGroupSetBits( pxPollSet->xPollGroup, pollEVENT_READY );
+					}
+				}
+			}
+			( void ) xTaskResumeAll();
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+	/* Wait for events on any of the sockets in a poll set.  In contrast with
+	FreeRTOS_select(), the IP-task is not involved: it has already put the
+	sockets with events on the ready list. */
+	BaseType_t FreeRTOS_PollWait( PollSet_t xPollSet, PollEvent_t *pxEvents, BaseType_t xMaxEvents, TickType_t xBlockTimeTicks )
+	{
+	PollSelect_t *pxPollSet = ( PollSelect_t * ) xPollSet;
+	TimeOut_t xTimeOut;
+	TickType_t xRemainingTime;
+	BaseType_t xCount;
+
+		configASSERT( pxPollSet != NULL );
+		configASSERT( pxEvents != NULL );
+		configASSERT( xMaxEvents > 0 );
+
+		xRemainingTime = xBlockTimeTicks;
+		vTaskSetTimeOutState( &xTimeOut );
+
+		for( ;; )
+		{
+			xCount = prvPollCollect( pxPollSet, pxEvents, xMaxEvents );
+
+			if( xCount != 0 )
+			{
+				break;
+			}
+
+			if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) != pdFALSE )
+			{
+				break;
+			}
+
+			/* A socket that becomes ready after prvPollCollect() has left
+			the bit set, so this won't block in that case. */
+			( void ) xEventGroupWaitBits( pxPollSet->xPollGroup, pollEVENT_READY, pdTRUE, pdFALSE, xRemainingTime );
+		}
+
+		return xCount;
+	}
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+	static BaseType_t prvPollCollect( PollSelect_t *pxPollSet, PollEvent_t *pxEvents, BaseType_t xMaxEvents )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	UBaseType_t uxToVisit;
+	EventBits_t xEvents;
+	BaseType_t xCount = 0;
+
+		vTaskSuspendAll();
+		{
+			/* Sockets which are put back are not visited twice. */
+			uxToVisit = listCURRENT_LIST_LENGTH( &( pxPollSet->xReadyList ) );
+
+			while( ( uxToVisit > 0u ) && ( xCount < xMaxEvents ) )
+			{
+				uxToVisit--;
+				pxSocket = ( FreeRTOS_Socket_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxPollSet->xReadyList ) );
+				( void ) uxListRemove( &( pxSocket->xPollListItem ) );
+
+				if( ( pxSocket->xPollEvents & ePOLL_EDGE ) != 0u )
+				{
+					xEvents = pxSocket->xPollPending;
+				}
+				else
+				{
+					/* Level-triggered: only report what is still true.  A
+					closure is reported even if it has been seen already. */
+					xEvents = prvPollCurrentEvents( pxSocket ) | ( pxSocket->xPollPending & ePOLL_EXCEPT );
+				}
+
+				xEvents &= pxSocket->xPollEvents & ePOLL_ALL;
+				pxSocket->xPollPending = 0u;
+
+				if( xEvents != 0u )
+				{
+					pxEvents[ xCount ].xSocket = ( Socket_t ) pxSocket;
+					pxEvents[ xCount ].xEvents = xEvents;
+					pxEvents[ xCount ].pvUserData = pxSocket->pvPollUserData;
+					xCount++;
+
+					if( ( pxSocket->xPollEvents & ePOLL_EDGE ) == 0u )
+					{
+						vListInsertEnd( &( pxPollSet->xReadyList ), &( pxSocket->xPollListItem ) );
+					}
+				}
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		return xCount;
+	}
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+	static EventBits_t prvPollCurrentEvents( FreeRTOS_Socket_t *pxSocket )
+	{
+	EventBits_t xEvents = 0u;
+
+		#if( ipconfigUSE_TCP == 1 )
+		if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+		{
+			if( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eTCP_LISTEN )
+			{
+				if( ( pxSocket->u.xTCP.pxPeerSocket != NULL ) && ( pxSocket->u.xTCP.pxPeerSocket->u.xTCP.bits.bPassAccept != pdFALSE_UNSIGNED ) )
+				{
+					xEvents |= ePOLL_READ;
+				}
+			}
+			else if( ( pxSocket->u.xTCP.bits.bReuseSocket != pdFALSE_UNSIGNED ) && ( pxSocket->u.xTCP.bits.bPassAccept != pdFALSE_UNSIGNED ) )
+			{
+				/* A re-used listening socket got connected, accept() must
+				be called. */
+				xEvents |= ePOLL_READ;
+			}
+			else
+			{
+				if( FreeRTOS_recvcount( ( Socket_t ) pxSocket ) > 0 )
+				{
+					xEvents |= ePOLL_READ;
+				}
+
+				if( ( FreeRTOS_issocketconnected( ( Socket_t ) pxSocket ) > 0 ) && ( FreeRTOS_tx_space( ( Socket_t ) pxSocket ) > 0 ) )
+				{
+					xEvents |= ePOLL_WRITE;
+				}
+
+				if( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eCLOSE_WAIT )
+				{
+					xEvents |= ePOLL_EXCEPT;
+				}
+			}
+		}
+		else
+		#endif /* ipconfigUSE_TCP == 1 */
+		{
+			if( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) > 0U )
+			{
+				xEvents |= ePOLL_READ;
+			}
+		}
+
+		return xEvents;
+	}
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+	static void prvPollUnlink( FreeRTOS_Socket_t *pxSocket )
+	{
+	PollSelect_t *pxPollSet = pxSocket->pxPollSet;
+
+		if( pxPollSet != NULL )
+		{
+			if( listIS_CONTAINED_WITHIN( &( pxPollSet->xReadyList ), &( pxSocket->xPollListItem ) ) != pdFALSE )
+			{
+				( void ) uxListRemove( &( pxSocket->xPollListItem ) );
+			}
+
+			pxPollSet->uxSocketCount--;
+			pxSocket->pxPollSet = NULL;
+			pxSocket->xPollEvents = 0u;
+			pxSocket->xPollPending = 0u;
+		}
+	}
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+
+	void vSocketPollSignal( FreeRTOS_Socket_t *pxSocket, EventBits_t xSocketEvents )
+	{
+	PollSelect_t *pxPollSet;
+	EventBits_t xEvents = 0u;
+
+		if( ( xSocketEvents & ( eSOCKET_RECEIVE | eSOCKET_ACCEPT ) ) != 0u )
+		{
+			xEvents |= ePOLL_READ;
+		}
+
+		if( ( xSocketEvents & ( eSOCKET_SEND | eSOCKET_CONNECT ) ) != 0u )
+		{
+			xEvents |= ePOLL_WRITE;
+		}
+
+		if( ( xSocketEvents & eSOCKET_CLOSED ) != 0u )
+		{
+			xEvents |= ePOLL_EXCEPT;
+		}
+
+		/* The owner may be changing or deleting the set in the mean time. */
+		vTaskSuspendAll();
+		{
+			pxPollSet = pxSocket->pxPollSet;
+			xEvents &= pxSocket->xPollEvents;
+
+			if( ( pxPollSet != NULL ) && ( xEvents != 0u ) )
+			{
+				pxSocket->xPollPending |= xEvents;
+
+				if( listIS_CONTAINED_WITHIN( NULL, &( pxSocket->xPollListItem ) ) != pdFALSE )
+				{
+					vListInsertEnd( &( pxPollSet->xReadyList ), &( pxSocket->xPollListItem ) );
+				}
+
+				xEventGroupSetBits( pxPollSet->xPollGroup, pollEVENT_READY );
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+
+#endif /* ipconfigSUPPORT_POLL_FUNCTION == 1 */
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRecvFromWaitForPacket( FreeRTOS_Socket_t *pxSocket, BaseType_t xFlags, EventBits_t *pxEventBits )
 {
-BaseType_t lPacketCount = 0;
-NetworkBufferDescriptor_t *pxNetworkBuffer;
-FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+BaseType_t lPacketCount;
 TickType_t xRemainingTime = ( TickType_t ) 0; /* Obsolete assignment, but some compilers output a warning if its not done. */
 BaseType_t xTimed = pdFALSE;
 TimeOut_t xTimeOut;
-int32_t lReturn;
 EventBits_t xEventBits = ( EventBits_t ) 0;
 
-	if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE ) == pdFALSE )
-	{
-		return -pdFREERTOS_ERRNO_EINVAL;
-	}
-
 	lPacketCount = ( BaseType_t ) listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
 
-	/* The function prototype is designed to maintain the expected Berkeley
-	sockets standard, but this implementation does not use all the parameters. */
-	( void ) pxSourceAddressLength;
-
 	while( lPacketCount == 0 )
 	{
 		if( xTimed == pdFALSE )
@@ -686,6 +1095,36 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 		}
 	} /* while( lPacketCount == 0 ) */
 
+	*pxEventBits = xEventBits;
+
+	return lPacketCount;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * FreeRTOS_recvfrom: receive data from a bound socket
+ * In this library, the function can only be used with connectionsless sockets
+ * (UDP)
+ */
+int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags, struct freertos_sockaddr *pxSourceAddress, socklen_t *pxSourceAddressLength )
+{
+BaseType_t lPacketCount;
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+int32_t lReturn;
+EventBits_t xEventBits = ( EventBits_t ) 0;
+
+	if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE ) == pdFALSE )
+	{
+		return -pdFREERTOS_ERRNO_EINVAL;
+	}
+
+	/* The function prototype is designed to maintain the expected Berkeley
+	sockets standard, but this implementation does not use all the parameters. */
+	( void ) pxSourceAddressLength;
+
+	lPacketCount = prvRecvFromWaitForPacket( pxSocket, xFlags, &xEventBits );
+
 	if( lPacketCount != 0 )
 	{
 		taskENTER_CRITICAL();
@@ -777,7 +1216,7 @@ FreeRTOS_Socket_t *pxSocket;
 	( void ) xDestinationAddressLength;
 	configASSERT( pvBuffer );
 
-	if( xTotalDataLength <= ( size_t ) ipMAX_UDP_PAYLOAD_LENGTH )
+	if( xTotalDataLength <= socketMAX_UDP_PAYLOAD_LENGTH )
 	{
 		/* If the socket is not already bound to an address, bind it now.
 		Passing NULL as the address parameter tells FreeRTOS_bind() to select
@@ -844,6 +1283,11 @@ FreeRTOS_Socket_t *pxSocket;
 				/* The socket options are passed to the IP layer in the
 				space that will eventually get used by the Ethernet header. */
 				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] = pxSocket->ucSocketOptions;
+				#if( ipconfigUSE_DSCP != 0 )
+				{
+					pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_DSCP_OFFSET ] = pxSocket->ucDSCP;
+				}
+				#endif
 
 				/* Tell the networking task that the packet needs sending. */
 				xStackTxEvent.pvData = pxNetworkBuffer;
@@ -853,6 +1297,8 @@ FreeRTOS_Socket_t *pxSocket;
 				{
 					/* The packet was successfully sent to the IP task. */
 					lReturn = ( int32_t ) xTotalDataLength;
+					ipCOUNT_SOCKET_EVENT( pxSocket, ulTxPackets, 1 );
+					ipCOUNT_SOCKET_EVENT( pxSocket, ulTxBytes, xTotalDataLength );
 					#if( ipconfigUSE_CALLBACKS == 1 )
 					{
 						if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xUDP.pxHandleSent ) )
@@ -897,6 +1343,254 @@ FreeRTOS_Socket_t *pxSocket;
 } /* Tested */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigSUPPORT_MMSG_FUNCTIONS == 1 )
+
+	BaseType_t FreeRTOS_recvmmsg( Socket_t xSocket, UDPMessage_t *pxMessages, BaseType_t xMaxMessages, BaseType_t xFlags )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	UDPMessage_t *pxMessage;
+	List_t xReceivedList;
+	BaseType_t xCount = 0;
+	BaseType_t xReturn;
+	size_t uxPayloadLength;
+	EventBits_t xEventBits = ( EventBits_t ) 0;
+
+		if( ( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE ) == pdFALSE ) ||
+			( xMaxMessages <= 0 ) ||
+			( ( xFlags & FREERTOS_MSG_PEEK ) != 0 ) )
+		{
+			return -pdFREERTOS_ERRNO_EINVAL;
+		}
+
+		if( prvRecvFromWaitForPacket( pxSocket, xFlags, &xEventBits ) != 0 )
+		{
+			vListInitialise( &xReceivedList );
+
+			/* Take all packets that are wanted from the socket within a single
+			critical section.  They are copied once the section has been left. */
+			taskENTER_CRITICAL();
+			{
+				while( ( xCount < xMaxMessages ) &&
+					   ( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) > 0U ) )
+				{
+					pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
+					uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+					vListInsertEnd( &xReceivedList, &( pxNetworkBuffer->xBufferListItem ) );
+					xCount++;
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			for( pxMessage = pxMessages; pxMessage < pxMessages + xCount; pxMessage++ )
+			{
+				pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xReceivedList );
+				uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+
+				uxPayloadLength = pxNetworkBuffer->xDataLength - sizeof( UDPPacket_t );
+				pxMessage->xAddress.sin_port = pxNetworkBuffer->usPort;
+				pxMessage->xAddress.sin_addr = pxNetworkBuffer->ulIPAddress;
+
+				if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
+				{
+					if( uxPayloadLength > pxMessage->xLength )
+					{
+						iptraceRECVFROM_DISCARDING_BYTES( ( pxMessage->xLength - uxPayloadLength ) );
+						uxPayloadLength = pxMessage->xLength;
+					}
+
+					memcpy( pxMessage->pvBuffer, ( void * ) &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] ), uxPayloadLength );
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+				}
+				else
+				{
+					/* The user must release the payload buffer by calling
+					FreeRTOS_ReleaseUDPPayloadBuffer(). */
+					pxMessage->pvBuffer = ( void * ) ( &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] ) );
+				}
+
+				pxMessage->xLength = uxPayloadLength;
+			}
+
+			xReturn = xCount;
+		}
+	#if( ipconfigSUPPORT_SIGNALS != 0 )
+		else if( ( xEventBits & eSOCKET_INTR ) != 0 )
+		{
+			xReturn = -pdFREERTOS_ERRNO_EINTR;
+			iptraceRECVFROM_INTERRUPTED();
+		}
+	#endif /* ipconfigSUPPORT_SIGNALS */
+		else
+		{
+			xReturn = -pdFREERTOS_ERRNO_EWOULDBLOCK;
+			iptraceRECVFROM_TIMEOUT();
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigSUPPORT_MMSG_FUNCTIONS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSUPPORT_MMSG_FUNCTIONS == 1 )
+
+	BaseType_t FreeRTOS_sendmmsg( Socket_t xSocket, const UDPMessage_t *pxMessages, BaseType_t xMessageCount, BaseType_t xFlags )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	NetworkBufferDescriptor_t *pxFirstBuffer = NULL;
+	NetworkBufferDescriptor_t *pxLastBuffer = NULL;
+	IPStackEvent_t xStackTxEvent = { eStackTxBatchEvent, NULL };
+	const UDPMessage_t *pxMessage;
+	TimeOut_t xTimeOut;
+	TickType_t xTicksToWait;
+	BaseType_t xCount = 0;
+
+		if( ( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdFALSE ) == pdFALSE ) ||
+			( pxMessages == NULL ) ||
+			( xMessageCount <= 0 ) )
+		{
+			return -pdFREERTOS_ERRNO_EINVAL;
+		}
+
+		/* Like FreeRTOS_sendto(), bind the socket to a port now if that has
+		not been done yet. */
+		if( ( socketSOCKET_IS_BOUND( pxSocket ) == pdFALSE ) &&
+			( FreeRTOS_bind( xSocket, NULL, 0u ) != 0 ) )
+		{
+			iptraceSENDTO_SOCKET_NOT_BOUND();
+			return -pdFREERTOS_ERRNO_EINVAL;
+		}
+
+		xTicksToWait = pxSocket->xSendBlockTime;
+
+		#if( ipconfigUSE_CALLBACKS != 0 )
+		{
+			if( xIsCallingFromIPTask() != pdFALSE )
+			{
+				/* The IP-task may not block on itself. */
+				xTicksToWait = ( TickType_t )0;
+			}
+		}
+		#endif /* ipconfigUSE_CALLBACKS */
+
+		if( ( xFlags & FREERTOS_MSG_DONTWAIT ) != 0 )
+		{
+			xTicksToWait = ( TickType_t ) 0;
+		}
+
+		vTaskSetTimeOutState( &xTimeOut );
+
+		/* Prepare a network buffer for every message, and chain them.  Stop
+		at the first message that can not be sent. */
+		for( pxMessage = pxMessages; pxMessage < pxMessages + xMessageCount; pxMessage++ )
+		{
+			if( pxMessage->xLength > socketMAX_UDP_PAYLOAD_LENGTH )
+			{
+				iptraceSENDTO_DATA_TOO_LONG();
+				break;
+			}
+
+			if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
+			{
+				pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( pxMessage->xLength + sizeof( UDPPacket_t ), xTicksToWait );
+
+				if( pxNetworkBuffer == NULL )
+				{
+					iptraceNO_BUFFER_FOR_SENDTO();
+					break;
+				}
+
+				memcpy( ( void * ) &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] ), pxMessage->pvBuffer, pxMessage->xLength );
+
+				if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdTRUE )
+				{
+					xTicksToWait = ( TickType_t ) 0;
+				}
+			}
+			else
+			{
+				pxNetworkBuffer = pxUDPPayloadBuffer_to_NetworkBuffer( pxMessage->pvBuffer );
+			}
+
+			pxNetworkBuffer->xDataLength = pxMessage->xLength + sizeof( UDPPacket_t );
+			pxNetworkBuffer->usPort = pxMessage->xAddress.sin_port;
+			pxNetworkBuffer->usBoundPort = ( uint16_t ) socketGET_SOCKET_PORT( pxSocket );
+			pxNetworkBuffer->ulIPAddress = pxMessage->xAddress.sin_addr;
+			pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] = pxSocket->ucSocketOptions;
+			#if( ipconfigUSE_DSCP != 0 )
+			{
+				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_DSCP_OFFSET ] = pxSocket->ucDSCP;
+			}
+			#endif
+			pxNetworkBuffer->pxNextBuffer = NULL;
+
+			if( pxLastBuffer == NULL )
+			{
+				pxFirstBuffer = pxNetworkBuffer;
+			}
+			else
+			{
+				pxLastBuffer->pxNextBuffer = pxNetworkBuffer;
+			}
+			pxLastBuffer = pxNetworkBuffer;
+			xCount++;
+		}
+
+		if( pxFirstBuffer != NULL )
+		{
+			xStackTxEvent.pvData = pxFirstBuffer;
+
+			if( xSendEventStructToIPTask( &xStackTxEvent, xTicksToWait ) == pdPASS )
+			{
+				#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+				{
+					for( pxMessage = pxMessages; pxMessage < pxMessages + xCount; pxMessage++ )
+					{
+						ipCOUNT_SOCKET_EVENT( pxSocket, ulTxBytes, pxMessage->xLength );
+					}
+					ipCOUNT_SOCKET_EVENT( pxSocket, ulTxPackets, xCount );
+				}
+				#endif /* ipconfigUSE_PERFORMANCE_COUNTERS */
+				#if( ipconfigUSE_CALLBACKS == 1 )
+				{
+					if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xUDP.pxHandleSent ) )
+					{
+						for( pxMessage = pxMessages; pxMessage < pxMessages + xCount; pxMessage++ )
+						{
+							pxSocket->u.xUDP.pxHandleSent( ( Socket_t )pxSocket, pxMessage->xLength );
+						}
+					}
+				}
+				#endif /* ipconfigUSE_CALLBACKS */
+			}
+			else
+			{
+				/* Nothing was sent.  As with FreeRTOS_sendto(), zero-copy
+				buffers remain owned by the caller. */
+				while( pxFirstBuffer != NULL )
+				{
+					pxNetworkBuffer = pxFirstBuffer;
+					pxFirstBuffer = pxFirstBuffer->pxNextBuffer;
+					pxNetworkBuffer->pxNextBuffer = NULL;
+
+					if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
+					{
+						vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+					}
+				}
+				xCount = 0;
+				iptraceSTACK_TX_EVENT_LOST( ipSTACK_TX_EVENT );
+			}
+		}
+
+		return xCount;
+	}
+
+#endif /* ipconfigSUPPORT_MMSG_FUNCTIONS */
+/*-----------------------------------------------------------*/
+
 /*
  * FreeRTOS_bind() : binds a sockt to a local port number.  If port 0 is
  * provided, a system provided port number will be assigned.  This function can
@@ -1162,6 +1856,12 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 			}
 			#endif /* ipconfigUSE_TCP_WIN */
 
+			#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+			{
+				prvTCPRxBufferFlush( pxSocket );
+			}
+			#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+
 			/* Free the input and output streams */
 			if( pxSocket->u.xTCP.rxStream != NULL )
 			{
@@ -1180,6 +1880,17 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 	}
 	#endif  /* ipconfigUSE_TCP == 1 */
 
+	#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+	{
+		/* The socket may be closed while it is still in a poll set. */
+		vTaskSuspendAll();
+		{
+			prvPollUnlink( pxSocket );
+		}
+		( void ) xTaskResumeAll();
+	}
+	#endif /* ipconfigSUPPORT_POLL_FUNCTION */
+
 	/* Socket must be unbound first, to ensure no more packets are queued on
 	it. */
 	if( socketSOCKET_IS_BOUND( pxSocket ) != pdFALSE )
@@ -1350,6 +2061,21 @@ FreeRTOS_Socket_t *pxSocket;
 			xReturn = 0;
 			break;
 
+		#if( ipconfigUSE_DSCP != 0 )
+			case FREERTOS_SO_DSCP :
+				/* The DSCP code point of the packets sent by this socket. */
+				lOptionValue = *( ( BaseType_t * ) pvOptionValue );
+
+				if( ( lOptionValue < 0 ) || ( lOptionValue > 63 ) )
+				{
+					break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+				}
+
+				pxSocket->ucDSCP = ( uint8_t ) lOptionValue;
+				xReturn = 0;
+				break;
+		#endif /* ipconfigUSE_DSCP */
+
 		#if( ipconfigUSE_CALLBACKS == 1 )
 			#if( ipconfigUSE_TCP == 1 )
 				case FREERTOS_SO_TCP_CONN_HANDLER:	/* Set a callback for (dis)connection events */
@@ -1602,16 +2328,135 @@ FreeRTOS_Socket_t *pxSocket;
 						pxSocket->u.xTCP.xTCPWindow.u.bits.bSendFullSize = pdFALSE_UNSIGNED;
 					}
 
-					if( ( pxSocket->u.xTCP.xTCPWindow.u.bits.bSendFullSize == pdFALSE_UNSIGNED ) &&
-						( pxSocket->u.xTCP.ucTCPState >= eESTABLISHED ) &&
-						( FreeRTOS_outstanding( pxSocket ) != 0 ) )
-					{
-						pxSocket->u.xTCP.usTimeout = 1u; /* to set/clear bSendFullSize */
-						xSendEventToIPTask( eTCPTimerEvent );
+					if( ( pxSocket->u.xTCP.xTCPWindow.u.bits.bSendFullSize == pdFALSE_UNSIGNED ) &&
+						( pxSocket->u.xTCP.ucTCPState >= eESTABLISHED ) &&
+						( FreeRTOS_outstanding( pxSocket ) != 0 ) )
+					{
+						pxSocket->u.xTCP.usTimeout = 1u; /* to set/clear bSendFullSize */
+						xSendEventToIPTask( eTCPTimerEvent );
+					}
+				}
+				xReturn = 0;
+				break;
+
+			#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+				case FREERTOS_SO_TCP_CONGESTION:	/* Select the congestion control algorithm */
+				case FREERTOS_SO_TCP_PACING:		/* Spread the transmission of segments over the RTT */
+					{
+						if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						/* The window is owned by the IP-task as soon as the
+						socket starts connecting, so only allow a change
+						before that moment. */
+						if( ( pxSocket->u.xTCP.ucTCPState != ( uint8_t ) eCLOSED ) &&
+							( pxSocket->u.xTCP.ucTCPState != ( uint8_t ) eTCP_LISTEN ) )
+						{
+							FreeRTOS_debug_printf( ( "Set SO_TCP_%s: socket already connected\n",
+								( lOptionName == FREERTOS_SO_TCP_CONGESTION ) ? "CONGESTION" : "PACING" ) );
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						if( lOptionName == FREERTOS_SO_TCP_PACING )
+						{
+							if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
+							{
+								pxSocket->u.xTCP.xTCPWindow.xCongestion.u.bits.bPacing = pdTRUE_UNSIGNED;
+							}
+							else
+							{
+								pxSocket->u.xTCP.xTCPWindow.xCongestion.u.bits.bPacing = pdFALSE_UNSIGNED;
+							}
+						}
+						else if( xTCPWindowSetCongestionControl( &( pxSocket->u.xTCP.xTCPWindow ), ( uint8_t ) *( ( BaseType_t * ) pvOptionValue ) ) == pdFALSE )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+					}
+					xReturn = 0;
+					break;
+			#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
+			#if( ipconfigUSE_TCP_WIN == 1 )
+				case FREERTOS_SO_TCP_SEG_QUOTA:	/* Limit the number of segment descriptors */
+					{
+						if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						/* The overflow accounting depends on the quota, so it
+						can not be changed while the window holds segments. */
+						if( ( pxSocket->u.xTCP.ucTCPState != ( uint8_t ) eCLOSED ) &&
+							( pxSocket->u.xTCP.ucTCPState != ( uint8_t ) eTCP_LISTEN ) )
+						{
+							FreeRTOS_debug_printf( ( "Set SO_TCP_SEG_QUOTA: socket already connected\n" ) );
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						if( *( ( BaseType_t * ) pvOptionValue ) < 0 )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						pxSocket->u.xTCP.xTCPWindow.uxSegmentQuota = ( UBaseType_t ) *( ( BaseType_t * ) pvOptionValue );
+					}
+					xReturn = 0;
+					break;
+			#endif /* ipconfigUSE_TCP_WIN == 1 */
+
+			#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+				case FREERTOS_SO_TCP_ZERO_COPY_RX:	/* Keep in-order data in its network buffer */
+					{
+						if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						/* Data that has been queued already will be read
+						first, so the mode may be changed at any moment. */
+						if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
+						{
+							pxSocket->u.xTCP.bits.bRxZeroCopy = pdTRUE_UNSIGNED;
+						}
+						else
+						{
+							pxSocket->u.xTCP.bits.bRxZeroCopy = pdFALSE_UNSIGNED;
+						}
+					}
+					xReturn = 0;
+					break;
+			#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+
+			#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+				case FREERTOS_SO_TCP_FASTOPEN:	/* Send data along with the SYN */
+					{
+						if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						/* The option is only looked at while sending the
+						first SYN. */
+						if( pxSocket->u.xTCP.ucTCPState != ( uint8_t ) eCLOSED )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						if( *( ( BaseType_t * ) pvOptionValue ) != 0 )
+						{
+							pxSocket->u.xTCP.bits.bFastOpen = pdTRUE_UNSIGNED;
+						}
+						else
+						{
+							pxSocket->u.xTCP.bits.bFastOpen = pdFALSE_UNSIGNED;
+						}
 					}
-				}
-				xReturn = 0;
-				break;
+					xReturn = 0;
+					break;
+			#endif /* ipconfigUSE_TCP_FAST_OPEN */
 
 			case FREERTOS_SO_STOP_RX:		/* Refuse to receive more packts */
 				{
@@ -1887,6 +2732,15 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	}
 	#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
 
+	#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+	{
+		if( pxSocket->pxPollSet != NULL )
+		{
+			vSocketPollSignal( pxSocket, pxSocket->xEventBits & eSOCKET_ALL );
+		}
+	}
+	#endif /* ipconfigSUPPORT_POLL_FUNCTION */
+
 	#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
 	{
 		if( pxSocket->pxSocketSet != NULL )
@@ -2358,7 +3212,29 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			{
 				if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
 				{
-					xByteCount = ( BaseType_t ) uxStreamBufferGet( pxSocket->u.xTCP.rxStream, 0ul, ( uint8_t * ) pvBuffer, ( size_t ) xBufferLength, ( xFlags & FREERTOS_MSG_PEEK ) != 0 );
+					#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+					{
+					BaseType_t xPeek = ( ( xFlags & FREERTOS_MSG_PEEK ) != 0 );
+					size_t uxQueued;
+
+						/* Data held in network buffers comes first, the
+						remainder is read from rxStream.  If a peek is done,
+						rxStream is read after the bytes that were peeked. */
+						uxQueued = prvTCPRxBufferGet( pxSocket, ( uint8_t * ) pvBuffer, xBufferLength, xPeek );
+						xByteCount = ( BaseType_t ) uxQueued;
+						if( uxQueued < xBufferLength )
+						{
+							xByteCount += ( BaseType_t ) uxStreamBufferGet( pxSocket->u.xTCP.rxStream,
+								( xPeek != pdFALSE ) ? uxQueued : 0ul,
+								( pvBuffer != NULL ) ? ( ( uint8_t * ) pvBuffer ) + uxQueued : NULL,
+								xBufferLength - uxQueued, xPeek );
+						}
+					}
+					#else
+					{
+						xByteCount = ( BaseType_t ) uxStreamBufferGet( pxSocket->u.xTCP.rxStream, 0ul, ( uint8_t * ) pvBuffer, ( size_t ) xBufferLength, ( xFlags & FREERTOS_MSG_PEEK ) != 0 );
+					}
+					#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
 					if( pxSocket->u.xTCP.bits.bLowWater != pdFALSE_UNSIGNED )
 					{
 						/* We had reached the low-water mark, now see if the flag
@@ -2377,7 +3253,21 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				else
 				{
 					/* Zero-copy reception of data: pvBuffer is a pointer to a pointer. */
-					xByteCount = ( BaseType_t ) uxStreamBufferGetPtr( pxSocket->u.xTCP.rxStream, (uint8_t **)pvBuffer );
+					#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+					{
+						/* Network buffers in xRxBufferList are handed out
+						first, the data in rxStream follows. */
+						xByteCount = prvTCPRxBufferGetPtr( pxSocket, ( uint8_t ** ) pvBuffer );
+						if( xByteCount < 0 )
+						{
+							xByteCount = ( BaseType_t ) uxStreamBufferGetPtr( pxSocket->u.xTCP.rxStream, (uint8_t **)pvBuffer );
+						}
+					}
+					#else
+					{
+						xByteCount = ( BaseType_t ) uxStreamBufferGetPtr( pxSocket->u.xTCP.rxStream, (uint8_t **)pvBuffer );
+					}
+					#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
 				}
 			}
 		} /* prvValidSocket() */
@@ -2388,14 +3278,79 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 )
+
+	BaseType_t FreeRTOS_ReleaseTCPPayloadBuffer( Socket_t xSocket, void const *pvBuffer, BaseType_t xByteCount )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	BaseType_t xReturn = -pdFREERTOS_ERRNO_EINVAL;
+	BaseType_t xAvailable = 0, xReleased;
+	uint8_t *pucData = NULL;
+
+		/* 'pvBuffer' must be the pointer that was returned by a call to
+		FreeRTOS_recv() with the FREERTOS_ZERO_COPY flag, and the data can
+		not be released in larger chunks than it was handed out.  Only the
+		user reads from the socket, so the data can not change between this
+		check and the call to FreeRTOS_recv() below. */
+		if( ( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) != pdFALSE ) && ( pxSocket->u.xTCP.rxStream != NULL ) )
+		{
+			#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+			{
+				xAvailable = prvTCPRxBufferGetPtr( pxSocket, &( pucData ) );
+				if( xAvailable < 0 )
+				{
+					xAvailable = ( BaseType_t ) uxStreamBufferGetPtr( pxSocket->u.xTCP.rxStream, &( pucData ) );
+				}
+			}
+			#else
+			{
+				xAvailable = ( BaseType_t ) uxStreamBufferGetPtr( pxSocket->u.xTCP.rxStream, &( pucData ) );
+			}
+			#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+		}
+
+		if( ( xByteCount > 0 ) && ( xByteCount <= xAvailable ) && ( pucData == ( const uint8_t * ) pvBuffer ) )
+		{
+			/* Calling FreeRTOS_recv() without a buffer will just consume the
+			data, and update the reception window. */
+			xReleased = FreeRTOS_recv( ( Socket_t ) pxSocket, NULL, ( size_t ) xByteCount, FREERTOS_MSG_DONTWAIT );
+			configASSERT( xReleased == xByteCount );
+
+			if( xReleased == xByteCount )
+			{
+				xReturn = xReleased;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	static int32_t prvTCPSendCheck( FreeRTOS_Socket_t *pxSocket, size_t xDataLength )
 	{
 	int32_t xResult = 1;
+	BaseType_t xEarlyData = pdFALSE;
+
+		#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+		{
+			/* A Fast Open socket may queue data before FreeRTOS_connect() is
+			called, so that it can be sent along with the SYN. */
+			if( ( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) != pdFALSE ) &&
+				( pxSocket->u.xTCP.bits.bFastOpen != pdFALSE_UNSIGNED ) &&
+				( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eCLOSED ) &&
+				( pxSocket->u.xTCP.usRemotePort == 0u ) )
+			{
+				xEarlyData = pdTRUE;
+			}
+		}
+		#endif /* ipconfigUSE_TCP_FAST_OPEN */
 
 		/* Is this a socket of type TCP and is it already bound to a port number ? */
-		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
+		if( ( xEarlyData == pdFALSE ) && ( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE ) )
 		{
 			xResult = -pdFREERTOS_ERRNO_EINVAL;
 		}
@@ -2403,9 +3358,10 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		{
 			xResult = -pdFREERTOS_ERRNO_ENOMEM;
 		}
-		else if( pxSocket->u.xTCP.ucTCPState == eCLOSED ||
-                 pxSocket->u.xTCP.ucTCPState == eCLOSE_WAIT ||
-                 pxSocket->u.xTCP.ucTCPState == eCLOSING )
+		else if( ( xEarlyData == pdFALSE ) &&
+				 ( pxSocket->u.xTCP.ucTCPState == eCLOSED ||
+                   pxSocket->u.xTCP.ucTCPState == eCLOSE_WAIT ||
+                   pxSocket->u.xTCP.ucTCPState == eCLOSING ) )
 		{
 			xResult = -pdFREERTOS_ERRNO_ENOTCONN;
 		}
@@ -2485,10 +3441,13 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	BaseType_t xTimed = pdFALSE;
 	TimeOut_t xTimeOut;
 	BaseType_t xCloseAfterSend;
-
-		/* Prevent compiler warnings about unused parameters.  The parameter
-		may be used in future versions. */
-		( void ) xFlags;
+	#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+		UBaseType_t uxNextHead;
+		TCPTxReference_t *pxReference;
+		/* When FREERTOS_ZERO_COPY is used, the data will not be copied to
+		txStream, only a reference to it will be stored. */
+		BaseType_t xByReference = ( ( ( xFlags & FREERTOS_ZERO_COPY ) != 0 ) && ( pvBuffer != NULL ) ) ? pdTRUE : pdFALSE;
+	#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
 
 		xByteCount = ( BaseType_t ) prvTCPSendCheck( pxSocket, uxDataLength );
 
@@ -2503,6 +3462,19 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			/* While there are still bytes to be sent. */
 			while( xBytesLeft > 0 )
 			{
+				#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+				{
+					/* A reference needs a free slot, which will be released
+					by the IP-task once the data has been acknowledged. */
+					uxNextHead = ( ( UBaseType_t ) pxSocket->u.xTCP.ucTxRefHead + 1u ) % ( UBaseType_t ) ipTCP_TX_REFERENCE_SLOTS;
+
+					if( ( xByReference != pdFALSE ) && ( uxNextHead == ( UBaseType_t ) pxSocket->u.xTCP.ucTxRefTail ) )
+					{
+						xByteCount = 0;
+					}
+				}
+				#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
+
 				/* If txStream has space. */
 				if( xByteCount > 0 )
 				{
@@ -2539,7 +3511,33 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 						pxSocket->u.xTCP.bits.bCloseRequested = pdTRUE_UNSIGNED;
 					}
 
-					xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0ul, ( const uint8_t * ) pvBuffer, ( size_t ) xByteCount );
+					#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+					if( xByReference != pdFALSE )
+					{
+						/* The reference must be stored before the head of
+						txStream is advanced, the IP-task may read the data
+						as soon as it has been added.  The space in txStream
+						can only grow, so all 'xByteCount' bytes will be
+						added. */
+						pxReference = &( pxSocket->u.xTCP.xTxReferences[ pxSocket->u.xTCP.ucTxRefHead ] );
+						pxReference->pucData = ( const uint8_t * ) pvBuffer;
+						pxReference->ulFirst = pxSocket->u.xTCP.ulTxAdded;
+						pxReference->uxLength = ( size_t ) xByteCount;
+						pxSocket->u.xTCP.ucTxRefHead = ( uint8_t ) uxNextHead;
+
+						xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0ul, NULL, ( size_t ) xByteCount );
+					}
+					else
+					#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
+					{
+						xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0ul, ( const uint8_t * ) pvBuffer, ( size_t ) xByteCount );
+					}
+
+					#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+					{
+						pxSocket->u.xTCP.ulTxAdded += ( uint32_t ) xByteCount;
+					}
+					#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
 
 					if( xCloseAfterSend != pdFALSE )
 					{
@@ -2687,6 +3685,12 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			reused as it might have had a previous connection. */
 			if( pxSocket->u.xTCP.bits.bReuseSocket )
 			{
+			#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+				uint32_t bRxZeroCopy = pxSocket->u.xTCP.bits.bRxZeroCopy;
+
+				prvTCPRxBufferFlush( pxSocket );
+			#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+
 				if( pxSocket->u.xTCP.rxStream != NULL )
 				{
 					vStreamBufferClear( pxSocket->u.xTCP.rxStream );
@@ -2697,6 +3701,16 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 					vStreamBufferClear( pxSocket->u.xTCP.txStream );
 				}
 
+				#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+				{
+					/* All references of the previous connection are released. */
+					pxSocket->u.xTCP.ucTxRefHead = 0u;
+					pxSocket->u.xTCP.ucTxRefTail = 0u;
+					pxSocket->u.xTCP.ulTxAdded = 0ul;
+					pxSocket->u.xTCP.ulTxAcked = 0ul;
+				}
+				#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
+
 				memset( pxSocket->u.xTCP.xPacket.u.ucLastPacket, '\0', sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket ) );
 				memset( &pxSocket->u.xTCP.xTCPWindow, '\0', sizeof( pxSocket->u.xTCP.xTCPWindow ) );
 				memset( &pxSocket->u.xTCP.bits, '\0', sizeof( pxSocket->u.xTCP.bits ) );
@@ -2704,6 +3718,11 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				/* Now set the bReuseSocket flag again, because the bits have
 				just been cleared. */
 				pxSocket->u.xTCP.bits.bReuseSocket = pdTRUE_UNSIGNED;
+				#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+				{
+					pxSocket->u.xTCP.bits.bRxZeroCopy = bRxZeroCopy;
+				}
+				#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
 			}
 
 			vTCPStateChange( pxSocket, eTCP_LISTEN );
@@ -2913,6 +3932,131 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+
+	static size_t prvTCPRxBufferGet( FreeRTOS_Socket_t *pxSocket, uint8_t *pucBuffer, size_t uxMaxLength, BaseType_t xPeek )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	const ListItem_t *pxIterator = NULL;
+	size_t uxLimit, uxCount, uxDone = 0u;
+
+		/* The IP-task adds a buffer to the list before it advances the head
+		of rxStream, so never take more bytes than rxStream holds.  Only this
+		function removes buffers from the list, the IP-task only appends them:
+		once the limit is known, the buffers that are visited won't change. */
+		vTaskSuspendAll();
+		{
+			uxLimit = FreeRTOS_min_uint32( ( uint32_t ) pxSocket->u.xTCP.uxRxQueuedBytes, ( uint32_t ) uxMaxLength );
+			if( pxSocket->u.xTCP.rxStream != NULL )
+			{
+				uxLimit = FreeRTOS_min_uint32( ( uint32_t ) uxLimit, ( uint32_t ) uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream ) );
+			}
+			else
+			{
+				uxLimit = 0u;
+			}
+
+			if( uxLimit != 0u )
+			{
+				pxIterator = ( const ListItem_t * ) listGET_HEAD_ENTRY( &( pxSocket->u.xTCP.xRxBufferList ) );
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		while( uxDone < uxLimit )
+		{
+			pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+			uxCount = FreeRTOS_min_uint32( ( uint32_t ) pxNetworkBuffer->xDataLength, ( uint32_t ) ( uxLimit - uxDone ) );
+
+			if( pucBuffer != NULL )
+			{
+				memcpy( pucBuffer + uxDone, pxNetworkBuffer->pucEthernetBuffer + pxNetworkBuffer->usPayloadOffset, uxCount );
+			}
+			uxDone += uxCount;
+
+			if( ( xPeek == pdFALSE ) && ( uxCount == pxNetworkBuffer->xDataLength ) )
+			{
+				/* The buffer has been read completely. */
+				if( uxDone < uxLimit )
+				{
+					pxIterator = ( const ListItem_t * ) listGET_NEXT( pxIterator );
+				}
+
+				vTaskSuspendAll();
+				{
+					( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+				}
+				( void ) xTaskResumeAll();
+
+				vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			}
+			else if( xPeek == pdFALSE )
+			{
+				/* Part of the buffer has been read. */
+				pxNetworkBuffer->usPayloadOffset += ( uint16_t ) uxCount;
+				pxNetworkBuffer->xDataLength -= uxCount;
+			}
+			else if( uxDone < uxLimit )
+			{
+				pxIterator = ( const ListItem_t * ) listGET_NEXT( pxIterator );
+			}
+		}
+
+		if( ( xPeek == pdFALSE ) && ( uxDone != 0u ) )
+		{
+			/* The IP-task compares the size of rxStream with uxRxQueuedBytes,
+			update both in one go. */
+			vTaskSuspendAll();
+			{
+				pxSocket->u.xTCP.uxRxQueuedBytes -= uxDone;
+				( void ) uxStreamBufferGet( pxSocket->u.xTCP.rxStream, 0ul, NULL, uxDone, pdFALSE );
+			}
+			( void ) xTaskResumeAll();
+		}
+
+		return uxDone;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvTCPRxBufferGetPtr( FreeRTOS_Socket_t *pxSocket, uint8_t **ppucData )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	BaseType_t xReturn = -1;
+
+		vTaskSuspendAll();
+		{
+			if( listLIST_IS_EMPTY( &( pxSocket->u.xTCP.xRxBufferList ) ) == pdFALSE )
+			{
+				pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxSocket->u.xTCP.xRxBufferList ) );
+				*ppucData = pxNetworkBuffer->pucEthernetBuffer + pxNetworkBuffer->usPayloadOffset;
+
+				/* The head of rxStream might not have been advanced yet. */
+				xReturn = ( BaseType_t ) FreeRTOS_min_uint32( ( uint32_t ) pxNetworkBuffer->xDataLength,
+					( uint32_t ) uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream ) );
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPRxBufferFlush( FreeRTOS_Socket_t *pxSocket )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+
+		while( listCURRENT_LIST_LENGTH( &( pxSocket->u.xTCP.xRxBufferList ) ) > 0U )
+		{
+			pxNetworkBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxSocket->u.xTCP.xRxBufferList ) );
+			( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+		}
+		pxSocket->u.xTCP.uxRxQueuedBytes = 0u;
+	}
+
+#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	static StreamBuffer_t *prvTCPCreateStream ( FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream )
@@ -2948,6 +4092,19 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		/* And make the length a multiple of sizeof( size_t ). */
 		uxLength &= ~( sizeof( size_t ) - 1u );
 
+		#if( ipconfigSTREAM_BUFFER_POWER_OF_TWO != 0 )
+		{
+		size_t uxPower = sizeof( size_t );
+
+			/* Round up to a power of two, so the stream indexes can be masked. */
+			while( uxPower < uxLength )
+			{
+				uxPower <<= 1;
+			}
+			uxLength = uxPower;
+		}
+		#endif
+
 		uxSize = sizeof( *pxBuffer ) - sizeof( pxBuffer->ucArray ) + uxLength;
 
 		pxBuffer = ( StreamBuffer_t * )pvPortMallocLarge( uxSize );
@@ -2997,6 +4154,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	int32_t xResult;
 	#if( ipconfigUSE_CALLBACKS == 1 )
 		BaseType_t bHasHandler = ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xTCP.pxHandleReceive );
+		BaseType_t xDeliver = pdTRUE;
 		const uint8_t *pucBuffer = NULL;
 	#endif /* ipconfigUSE_CALLBACKS */
 
@@ -3016,7 +4174,18 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 		#if( ipconfigUSE_CALLBACKS == 1 )
 		{
-			if( ( bHasHandler != pdFALSE ) && ( uxStreamBufferGetSize( pxStream ) == 0u ) && ( uxOffset == 0ul ) && ( pcData != NULL ) )
+			#if( ipconfigUSE_TCP_GRO != 0 )
+			{
+				/* The next segment of the same burst follows.  The data is
+				stored and passed to the handler together with that segment. */
+				if( pxSocket->u.xTCP.bits.bRxDeferred != pdFALSE_UNSIGNED )
+				{
+					xDeliver = pdFALSE;
+				}
+			}
+			#endif /* ipconfigUSE_TCP_GRO */
+
+			if( ( bHasHandler != pdFALSE ) && ( xDeliver != pdFALSE ) && ( uxStreamBufferGetSize( pxStream ) == 0u ) && ( uxOffset == 0ul ) && ( pcData != NULL ) )
 			{
 				/* Data can be passed directly to the user */
 				pucBuffer = pcData;
@@ -3030,6 +4199,16 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 		xResult = ( int32_t ) uxStreamBufferAdd( pxStream, uxOffset, pcData, ( size_t ) ulByteCount );
 
+		#if( ( ipconfigUSE_TCP_ZERO_COPY_RX != 0 ) && ( ipconfigUSE_PERFORMANCE_COUNTERS != 0 ) )
+		{
+			/* Let the user see how much data did not take the zero-copy path. */
+			if( ( pcData != NULL ) && ( xResult > 0 ) && ( pxSocket->u.xTCP.bits.bRxZeroCopy != pdFALSE_UNSIGNED ) )
+			{
+				ipCOUNT_SOCKET_EVENT( pxSocket, ulRxCopiedBytes, xResult );
+			}
+		}
+		#endif
+
 		#if( ipconfigHAS_DEBUG_PRINTF != 0 )
 		{
 			if( xResult != ( int32_t ) ulByteCount )
@@ -3052,7 +4231,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				{
 					/* The socket owner has installed an OnReceive handler. Pass the
 					Rx data, without copying from the rxStream, to the user. */
-					for (;;)
+					while( xDeliver != pdFALSE )
 					{
 						uint8_t *ucReadPtr = NULL;
 						uint32_t ulCount;
@@ -3243,6 +4422,50 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_ZERO_COPY_TX != 0 ) )
+
+	BaseType_t FreeRTOS_tx_referenced( Socket_t xSocket )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	const TCPTxReference_t *pxReference;
+	UBaseType_t uxIndex;
+	uint32_t ulFirst;
+	BaseType_t xReturn = 0;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdFALSE )
+		{
+			xReturn = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else
+		{
+			/* The IP-task releases references while handling ACK's. */
+			vTaskSuspendAll();
+			{
+				for( uxIndex = ( UBaseType_t ) pxSocket->u.xTCP.ucTxRefTail;
+					 uxIndex != ( UBaseType_t ) pxSocket->u.xTCP.ucTxRefHead;
+					 uxIndex = ( uxIndex + 1u ) % ( UBaseType_t ) ipTCP_TX_REFERENCE_SLOTS )
+				{
+					pxReference = &( pxSocket->u.xTCP.xTxReferences[ uxIndex ] );
+					ulFirst = pxReference->ulFirst;
+
+					/* Only the first reference may be acknowledged partially. */
+					if( ( int32_t ) ( pxSocket->u.xTCP.ulTxAcked - ulFirst ) > 0 )
+					{
+						ulFirst = pxSocket->u.xTCP.ulTxAcked;
+					}
+
+					xReturn += ( BaseType_t ) ( ( pxReference->ulFirst + ( uint32_t ) pxReference->uxLength ) - ulFirst );
+				}
+			}
+			( void ) xTaskResumeAll();
+		}
+
+		return xReturn;
+	}
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_ZERO_COPY_TX != 0 ) */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/* Returns pdTRUE if TCP socket is connected. */
@@ -3298,6 +4521,84 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 )
+
+	/* returns the number of TCP segments that were retransmitted, either after
+	a time-out or after duplicate ACKs. */
+	BaseType_t FreeRTOS_retransmit_count( Socket_t xSocket )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	BaseType_t xReturn;
+
+		if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+		{
+			xReturn = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else
+		{
+			xReturn = ( BaseType_t ) ( pxSocket->u.xTCP.xTCPWindow.ulRetransmitCount );
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+
+	BaseType_t FreeRTOS_GetSocketCounters( Socket_t xSocket, SocketCounters_t *pxCounters )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	BaseType_t xReturn;
+
+		if( ( pxSocket == NULL ) || ( pxSocket == FREERTOS_INVALID_SOCKET ) || ( pxCounters == NULL ) )
+		{
+			xReturn = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else
+		{
+			/* The IP-task may update the counters and the TCP window at any
+			moment, take a consistent copy. */
+			vTaskSuspendAll();
+			{
+				memcpy( pxCounters, &( pxSocket->xCounters ), sizeof( *pxCounters ) );
+
+				#if( ipconfigUSE_TCP == 1 )
+				if( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP )
+				{
+				const TCPWindow_t *pxWindow = &( pxSocket->u.xTCP.xTCPWindow );
+
+					pxCounters->ulRetransmits = pxWindow->ulRetransmitCount;
+					pxCounters->lSRTT = pxWindow->lSRTT;
+					#if( ipconfigUSE_TCP_WIN == 1 )
+					{
+						pxCounters->uxOutOfOrderSegments = ( UBaseType_t ) listCURRENT_LIST_LENGTH( &( pxWindow->xRxSegments ) );
+					}
+					#endif
+					#if( ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 ) )
+					{
+						pxCounters->ulCWnd = pxWindow->xCongestion.ulCWnd;
+					}
+					#else
+					{
+						pxCounters->ulCWnd = pxWindow->xSize.ulTxWindowLength;
+					}
+					#endif
+				}
+				#endif /* ipconfigUSE_TCP */
+			}
+			( void ) xTaskResumeAll();
+
+			xReturn = pdPASS;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_PERFORMANCE_COUNTERS */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/* HT: for internal use only: return the connection status */
@@ -3438,6 +4739,23 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				uxGetMinimumFreeNetworkBuffers( ),
 				uxGetNumberOfFreeNetworkBuffers( ),
 				ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ) );
+
+			#if( ipconfigUSE_TCP_WIN == 1 )
+			{
+			TCPSegmentStats_t xStats;
+
+				vTCPWindowGetSegmentStats( &xStats );
+				FreeRTOS_printf( ( "FreeRTOS_netstat: %lu segments free, max %lu used, %lu/%lu created, overflow %lu (max %lu), failed %lu refused %lu\n",
+					( uint32_t ) xStats.uxFree,
+					( uint32_t ) xStats.uxMaximumInUse,
+					( uint32_t ) xStats.uxTotal,
+					( uint32_t ) ipconfigTCP_WIN_SEG_COUNT,
+					( uint32_t ) xStats.uxOverflowInUse,
+					( uint32_t ) xStats.uxOverflowHighWater,
+					xStats.ulPoolExhausted,
+					xStats.ulQuotaRefused ) );
+			}
+			#endif /* ipconfigUSE_TCP_WIN == 1 */
 		}
 	}
 
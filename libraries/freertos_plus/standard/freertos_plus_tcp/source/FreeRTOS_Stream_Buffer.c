@@ -37,6 +37,13 @@
 #include "FreeRTOS_Sockets.h"
 #include "FreeRTOS_IP_Private.h"
 
+/*
+ * Describe a range of ucArray as one or two contiguous regions.
+ */
+static size_t prvStreamBufferRegions( StreamBuffer_t *pxBuffer, size_t uxStart, size_t uxCount, StreamBufferRegions_t *pxRegions );
+
+/*-----------------------------------------------------------*/
+
 /*
  * uxStreamBufferAdd( )
  * Adds data to a stream buffer.  If uxOffset > 0, data will be written at
@@ -48,6 +55,12 @@ size_t uxStreamBufferAdd( StreamBuffer_t *pxBuffer, size_t uxOffset, const uint8
 {
 size_t uxSpace, uxNextHead, uxFirst;
 
+	#if( ipconfigSTREAM_BUFFER_POWER_OF_TWO != 0 )
+	{
+		configASSERT( ( pxBuffer->LENGTH & ( pxBuffer->LENGTH - 1u ) ) == 0u );
+	}
+	#endif
+
 	uxSpace = uxStreamBufferGetSpace( pxBuffer );
 
 	/* If uxOffset > 0, items can be placed in front of uxHead */
@@ -71,11 +84,7 @@ size_t uxSpace, uxNextHead, uxFirst;
 		if( uxOffset != 0u )
 		{
 			/* ( uxOffset > 0 ) means: write in front if the uxHead marker */
-			uxNextHead += uxOffset;
-			if( uxNextHead >= pxBuffer->LENGTH )
-			{
-				uxNextHead -= pxBuffer->LENGTH;
-			}
+			uxNextHead = uxStreamBufferWrap( pxBuffer, uxNextHead + uxOffset );
 		}
 
 		if( pucData != NULL )
@@ -101,11 +110,7 @@ size_t uxSpace, uxNextHead, uxFirst;
 		if( uxOffset == 0u )
 		{
 			/* ( uxOffset == 0 ) means: write at uxHead position */
-			uxNextHead += uxCount;
-			if( uxNextHead >= pxBuffer->LENGTH )
-			{
-				uxNextHead -= pxBuffer->LENGTH;
-			}
+			uxNextHead = uxStreamBufferWrap( pxBuffer, uxNextHead + uxCount );
 			pxBuffer->uxHead = uxNextHead;
 		}
 
@@ -152,11 +157,7 @@ size_t uxSize, uxCount, uxFirst, uxNextTail;
 
 		if( uxOffset != 0u )
 		{
-			uxNextTail += uxOffset;
-			if( uxNextTail >= pxBuffer->LENGTH )
-			{
-				uxNextTail -= pxBuffer->LENGTH;
-			}
+			uxNextTail = uxStreamBufferWrap( pxBuffer, uxNextTail + uxOffset );
 		}
 
 		if( pucData != NULL )
@@ -183,17 +184,90 @@ size_t uxSize, uxCount, uxFirst, uxNextTail;
 		{
 			/* Move the tail pointer to effecively remove the data read from
 			the buffer. */
-			uxNextTail += uxCount;
-
-			if( uxNextTail >= pxBuffer->LENGTH )
-			{
-				uxNextTail -= pxBuffer->LENGTH;
-			}
-
+			uxNextTail = uxStreamBufferWrap( pxBuffer, uxNextTail + uxCount );
 			pxBuffer->uxTail = uxNextTail;
 		}
 	}
 
 	return uxCount;
 }
+/*-----------------------------------------------------------*/
+
+/*
+ * prvStreamBufferRegions( )
+ * Describe the uxCount bytes that start at index uxStart as one or two
+ * contiguous regions of ucArray.
+ */
+static size_t prvStreamBufferRegions( StreamBuffer_t *pxBuffer, size_t uxStart, size_t uxCount, StreamBufferRegions_t *pxRegions )
+{
+size_t uxFirst;
+
+	uxFirst = FreeRTOS_min_uint32( pxBuffer->LENGTH - uxStart, uxCount );
+
+	pxRegions->pucFirst = pxBuffer->ucArray + uxStart;
+	pxRegions->uxFirst = uxFirst;
+
+	if( uxCount > uxFirst )
+	{
+		pxRegions->pucSecond = pxBuffer->ucArray;
+		pxRegions->uxSecond = uxCount - uxFirst;
+	}
+	else
+	{
+		pxRegions->pucSecond = NULL;
+		pxRegions->uxSecond = 0u;
+	}
+
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * uxStreamBufferGetReadRegions( )
+ * Returns the data that is available at an offset 'uxOffset' from 'uxTail',
+ * without copying it.  Neither 'uxTail' nor 'uxHead' will be moved.
+ */
+size_t uxStreamBufferGetReadRegions( StreamBuffer_t *pxBuffer, size_t uxOffset, StreamBufferRegions_t *pxRegions )
+{
+size_t uxSize;
+
+	uxSize = uxStreamBufferGetSize( pxBuffer );
+
+	if( uxSize > uxOffset )
+	{
+		uxSize -= uxOffset;
+	}
+	else
+	{
+		uxSize = 0u;
+		uxOffset = 0u;
+	}
+
+	return prvStreamBufferRegions( pxBuffer, uxStreamBufferWrap( pxBuffer, pxBuffer->uxTail + uxOffset ), uxSize, pxRegions );
+}
+/*-----------------------------------------------------------*/
 
+/*
+ * uxStreamBufferGetWriteRegions( )
+ * Returns the free space that is available at an offset 'uxOffset' from
+ * 'uxHead'.  Neither 'uxTail' nor 'uxHead' will be moved.
+ */
+size_t uxStreamBufferGetWriteRegions( StreamBuffer_t *pxBuffer, size_t uxOffset, StreamBufferRegions_t *pxRegions )
+{
+size_t uxSpace;
+
+	uxSpace = uxStreamBufferGetSpace( pxBuffer );
+
+	if( uxSpace > uxOffset )
+	{
+		uxSpace -= uxOffset;
+	}
+	else
+	{
+		uxSpace = 0u;
+		uxOffset = 0u;
+	}
+
+	return prvStreamBufferRegions( pxBuffer, uxStreamBufferWrap( pxBuffer, pxBuffer->uxHead + uxOffset ), uxSpace, pxRegions );
+}
+/*-----------------------------------------------------------*/
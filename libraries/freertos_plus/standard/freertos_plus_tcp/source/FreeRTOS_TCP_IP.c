@@ -94,16 +94,38 @@ the defined MTU size can contain at least a complete TCP packet. */
 #define TCP_OPT_SACK_P			4u   /* Advertize that SACK is permitted */
 #define TCP_OPT_SACK_A			5u   /* SACK option with first/last */
 #define TCP_OPT_TIMESTAMP		8u   /* Time-stamp option */
+#define TCP_OPT_FASTOPEN		34u  /* TCP Fast Open cookie option (RFC 7413) */
 
 #define TCP_OPT_MSS_LEN			4u   /* Length of TCP MSS option. */
 #define TCP_OPT_WSOPT_LEN		3u   /* Length of TCP WSOPT option. */
 
 #define TCP_OPT_TIMESTAMP_LEN	10	/* fixed length of the time-stamp option */
 
+/* The space taken by a time-stamp option in every outgoing packet: two NOP's
+followed by the option itself. */
+#define TCP_OPT_TIMESTAMP_SPACE	12u
+
+/* RFC 7323: the window scale factor (shift count) is at most 14. */
+#define TCP_WSOPT_MAX_SHIFT		14u
+
 #ifndef ipconfigTCP_ACK_EARLIER_PACKET
 	#define ipconfigTCP_ACK_EARLIER_PACKET		1
 #endif
 
+/* RFC 1122: when receiving a stream of full-sized segments, an ACK must be
+sent for at least every second segment. */
+#ifndef ipconfigTCP_ACK_EVERY_N_SEGMENTS
+	#define ipconfigTCP_ACK_EVERY_N_SEGMENTS	2
+#endif
+
+/* The number of data segments that will be acknowledged immediately after the
+connection has been established, and after a segment was received out of
+order.  This helps the peer to open its congestion window, and to recover from
+a loss. */
+#ifndef ipconfigTCP_QUICK_ACK_COUNT
+	#define ipconfigTCP_QUICK_ACK_COUNT			8
+#endif
+
 /*
  * The macro NOW_CONNECTED() is use to determine if the connection makes a
  * transition from connected to non-connected and vice versa.
@@ -182,6 +204,110 @@ the defined MTU size can contain at least a complete TCP packet. */
 };
 #endif /* ( ipconfigHAS_DEBUG_PRINTF != 0 ) || ( ipconfigHAS_PRINTF != 0 ) */
 
+#if( ipconfigUSE_TCP_GRO != 0 )
+	/* The packet that will be processed after the current one, when the
+	IP-task is working through a chain of received packets. */
+	static const NetworkBufferDescriptor_t *pxTCPNextRxBuffer = NULL;
+
+	/* Set while processing a data segment that is directly followed by the
+	next segment of the same connection. */
+	static BaseType_t xTCPSegmentFollows = pdFALSE;
+
+	/* The socket that holds back received data for its OnReceive handler,
+	and the packet that is expected to deliver it. */
+	static FreeRTOS_Socket_t *pxTCPDeferredSocket = NULL;
+	static const NetworkBufferDescriptor_t *pxTCPDeferredFollower = NULL;
+#endif /* ipconfigUSE_TCP_GRO */
+
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+	/* The number of bytes of a SYN that are stored: the headers plus the
+	largest possible TCP options. */
+	#define tcpSYN_PACKET_SIZE			( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + 40u )
+
+	/* A copy of a received SYN. */
+	typedef union xSYN_PACKET
+	{
+		/* Increase the alignment of this union by adding a 64-bit variable. */
+		uint64_t ullAlignmentWord;
+		struct
+		{
+			/* Give 'ucPacket' the same alignment as the Ethernet buffer in
+			a network buffer, see also 'ucLastPacket'. */
+			uint8_t ucFillPacket[ ipconfigPACKET_FILLER_SIZE ];
+			uint8_t ucPacket[ tcpSYN_PACKET_SIZE ];
+		} u;
+	} SynPacket_t;
+
+	/* A connection that has been answered with a SYN+ACK, while no socket
+	was created yet. */
+	typedef struct xSYN_CACHE_ENTRY
+	{
+		TickType_t xTimeReceived;		/* The time at which the SYN was received. */
+		uint32_t ulOurSequenceNumber;	/* The initial sequence number sent in the SYN+ACK. */
+		uint16_t usLength;				/* The number of bytes stored in xSyn, zero for a free entry. */
+		uint8_t ucMyWinScaleFactor;		/* The window scale factor sent in the SYN+ACK. */
+		SynPacket_t xSyn;				/* The SYN, it will be replayed to the new socket. */
+	} SynCacheEntry_t;
+
+	/* The options of a SYN that are needed to answer it. */
+	typedef struct xSYN_OPTIONS
+	{
+		uint16_t usMSS;					/* The MSS of the peer, or zero when not present. */
+		BaseType_t xWinScale;			/* True when the SYN has a window scale option. */
+		BaseType_t xTimeStamps;			/* True when the SYN has a time-stamp option. */
+		uint32_t ulTSValue;				/* The time-stamp of the peer. */
+	} SynOptions_t;
+
+	static SynCacheEntry_t xSynCache[ ipconfigTCP_SYN_CACHE_SIZE ];
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+	/* A SYN cookie is the initial sequence number sent in a SYN+ACK.  Bits
+	31-27 hold a time counter, bits 26-24 the index of the MSS in
+	usSynCookieMSS[], bits 23-0 a keyed hash of the connection. */
+	#define tcpSYN_COOKIE_TIME_SHIFT	27u
+	#define tcpSYN_COOKIE_TIME_MASK		0x1Fu
+	#define tcpSYN_COOKIE_MSS_SHIFT		24u
+	#define tcpSYN_COOKIE_MSS_MASK		0x07u
+	#define tcpSYN_COOKIE_HASH_MASK		0x00FFFFFFu
+
+	/* The time counter is increased every 64 seconds.  A cookie is accepted
+	during the period in which it was sent, and the next one. */
+	#define tcpSYN_COOKIE_PERIOD_MS		64000u
+
+	/* The MSS values that can be encoded in a SYN cookie. */
+	static const uint16_t usSynCookieMSS[] = { 536u, 1024u, 1200u, 1300u, 1360u, 1400u, 1440u, 1460u };
+
+	/* The key of the hash, it will be filled with a random number. */
+	static uint32_t ulSynCookieSecret = 0u;
+#endif /* ipconfigTCP_SYN_COOKIES */
+
+#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+	/* RFC 7413: a Fast Open cookie has a length of 4 to 16 bytes. */
+	#define tcpFAST_OPEN_COOKIE_MIN		4u
+	#define tcpFAST_OPEN_COOKIE_MAX		16u
+
+	/* The number of data bytes that may be sent along with a SYN when the MSS
+	of the server is not known. */
+	#define tcpFAST_OPEN_DEFAULT_MSS	536u
+
+	/* The TCP header can hold at most 40 bytes of options. */
+	#define tcpTCP_OPTIONS_MAX_LENGTH	40u
+
+	/* The Fast Open cookie of a server, and the MSS that it used. */
+	typedef struct xFAST_OPEN_ENTRY
+	{
+		uint32_t ulIPAddress;		/* The IP address of the server in host endian notation, zero for a free entry. */
+		TickType_t xLastUsed;		/* The time of the last connection, the oldest entry will be replaced. */
+		uint16_t usMSS;				/* The MSS of the last connection, or zero when not known. */
+		uint8_t ucCookieLength;		/* The length of the cookie. */
+		uint8_t ucCookie[ tcpFAST_OPEN_COOKIE_MAX ];
+	} FastOpenEntry_t;
+
+	/* Only accessed by the IP-task. */
+	static FastOpenEntry_t xFastOpenCache[ ipconfigTCP_FAST_OPEN_CACHE_ENTRIES ];
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
 /*
  * Returns true if the socket must be checked.  Non-active sockets are waiting
  * for user action, either connect() or close().
@@ -198,12 +324,35 @@ static int32_t prvTCPSendPacket( FreeRTOS_Socket_t *pxSocket );
  */
 static int32_t prvTCPSendRepeated( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t **ppxNetworkBuffer );
 
+#if( ipconfigTCP_TSO != 0 )
+	/*
+	 * Send the data segments that the sliding window releases in a single
+	 * pass.  The headers are copied from a template that is built once.  When
+	 * the driver supports TSO, contiguous segments are joined into one large
+	 * packet that is split by the driver.  Returns -1 if the socket needs the
+	 * normal path through prvTCPPrepareSend().
+	 */
+	static int32_t prvTCPSendBurst( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t **ppxNetworkBuffer );
+
+	/*
+	 * Fill in the fields that differ per packet of a burst, and hand the
+	 * packet to the driver.
+	 */
+	static void prvTCPBurstOutput( NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulSequenceNumber,
+		uint32_t ulDataLength, UBaseType_t uxOptionsLength, uint16_t usTSOSegmentSize, BaseType_t xReleaseAfterSend );
+#endif /* ipconfigTCP_TSO */
+
 /*
  * Return or send a packet to the other party.
  */
 static void prvTCPReturnPacket( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer,
 	uint32_t ulLen, BaseType_t xReleaseAfterSend );
 
+/*
+ * Set the window field of an outgoing packet, called by prvTCPReturnPacket().
+ */
+static void prvTCPSetWindowField( FreeRTOS_Socket_t *pxSocket, TCPPacket_t *pxTCPPacket );
+
 /*
  * Initialise the data structures which keep track of the TCP windowing system.
  */
@@ -286,7 +435,35 @@ static BaseType_t prvCheckRxData( NetworkBufferDescriptor_t *pxNetworkBuffer, ui
  * If so, it will be added to the socket's reception queue.
  */
 static BaseType_t prvStoreRxData( FreeRTOS_Socket_t *pxSocket, uint8_t *pucRecvData,
-	NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulReceiveLength );
+	NetworkBufferDescriptor_t **ppxNetworkBuffer, uint32_t ulReceiveLength );
+
+/*
+ * Called from prvStoreRxData() for data that arrived in-order.  If the socket
+ * is in zero-copy reception mode, the network buffer will be added to the
+ * socket's xRxBufferList, and '*ppxNetworkBuffer' will be replaced by a new
+ * buffer which only holds a copy of the headers.  Returns pdTRUE if the data
+ * has been queued.
+ */
+#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+	static BaseType_t prvTCPQueueRxBuffer( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucRecvData,
+		NetworkBufferDescriptor_t **ppxNetworkBuffer, uint32_t ulReceiveLength );
+#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+
+#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+	/*
+	 * Called from prvTCPPrepareSend() in stead of uxStreamBufferGet(): copy
+	 * outgoing data to 'pucTarget'.  Bytes that were passed to FreeRTOS_send()
+	 * by reference are read from the application's memory, the other bytes
+	 * are read from txStream.
+	 */
+	static size_t prvTCPTxCopy( FreeRTOS_Socket_t *pxSocket, size_t uxOffset, uint8_t *pucTarget, size_t uxMaxCount );
+
+	/*
+	 * The tail of txStream has been advanced by 'uxCount' bytes: release the
+	 * references that have been acknowledged completely.
+	 */
+	static void prvTCPTxReferencesAcked( FreeRTOS_Socket_t *pxSocket, size_t uxCount );
+#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
 
 /*
  * Set the TCP options (if any) for the outgoing packet.
@@ -350,6 +527,115 @@ static void prvSocketSetMSS( FreeRTOS_Socket_t *pxSocket );
  */
 static FreeRTOS_Socket_t *prvHandleListen( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
 
+/*
+ * Initialise a socket that has just been created for an incoming SYN: store
+ * the peer's address and sequence number, create the window and go to the
+ * state eSYN_FIRST.
+ */
+static void prvTCPStartPassiveOpen( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulInitialSequenceNumber );
+
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+	/*
+	 * A SYN was received by a listening socket: answer it with a SYN+ACK,
+	 * and remember the connection in the SYN cache (or in a SYN cookie),
+	 * without creating a new socket.
+	 */
+	static void prvSynCacheHandleSyn( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/*
+	 * An ACK was received by a listening socket.  If it completes a handshake
+	 * that was started from the SYN cache, create the new socket and return
+	 * it in the state eSYN_RECEIVED, otherwise return NULL.
+	 */
+	static FreeRTOS_Socket_t *prvSynCacheHandleAck( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/*
+	 * Create a socket for a completed handshake, and bring it into the state
+	 * in which it would be if it had received the SYN and sent the SYN+ACK
+	 * itself.  pxSynBuffer holds a copy of the SYN.
+	 */
+	static FreeRTOS_Socket_t *prvSynCacheCreateSocket( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxSynBuffer,
+		uint32_t ulOurSequenceNumber, uint8_t ucMyWinScaleFactor );
+
+	/*
+	 * Return pdTRUE and log a message when the listening socket has as many
+	 * children as its backlog allows.
+	 */
+	static BaseType_t prvSynCacheBacklogFull( const FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Find the entry in the SYN cache that has the same peer and local port as
+	 * pxTCPPacket.  Entries that have expired are freed, they never match.
+	 */
+	static SynCacheEntry_t *prvSynCacheLookup( const TCPPacket_t *pxTCPPacket );
+
+	/*
+	 * Return pdTRUE when the SYN cache entry has been waiting for the ACK for
+	 * longer than ipconfigTCP_SYN_CACHE_TIMEOUT_MS.
+	 */
+	static BaseType_t prvSynCacheEntryExpired( const SynCacheEntry_t *pxEntry, TickType_t xNow );
+
+	/*
+	 * Return a free or an expired entry of the SYN cache.  When there is none,
+	 * either NULL is returned (when SYN cookies are used), or the oldest entry.
+	 */
+	static SynCacheEntry_t *prvSynCacheGetEntry( void );
+
+	/*
+	 * Read the options of a SYN that are needed to answer it.
+	 */
+	static void prvSynCacheParseOptions( const NetworkBufferDescriptor_t *pxNetworkBuffer, SynOptions_t *pxOptions );
+
+	/*
+	 * Turn the SYN in pxNetworkBuffer into a SYN+ACK and send it.
+	 */
+	static void prvSynCacheSendSynAck( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer,
+		uint32_t ulOurSequenceNumber, uint16_t usMSS, uint8_t ucMyWinScaleFactor, const SynOptions_t *pxOptions );
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+
+#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+	/*
+	 * Find the Fast Open cache entry of a server.  When there is none and
+	 * xCreate is true, a free entry or the least recently used entry will be
+	 * returned, it will be cleared.
+	 */
+	static FastOpenEntry_t *prvFastOpenLookup( uint32_t ulIPAddress, BaseType_t xCreate );
+
+	/*
+	 * Send the first SYN of a Fast Open socket in a new network buffer.  It
+	 * carries either a cookie request or the cached cookie plus the first data
+	 * from txStream.  Returns the number of bytes sent, or zero when a normal
+	 * SYN must be sent.
+	 */
+	static int32_t prvTCPSendFastOpenSyn( FreeRTOS_Socket_t *pxSocket, UBaseType_t uxOptionsLength );
+
+	/*
+	 * The SYN+ACK confirms our SYN.  Remember the MSS of the server, and if the
+	 * data sent along with the SYN was accepted, remove it from txStream.
+	 */
+	static void prvTCPFastOpenSynAcked( FreeRTOS_Socket_t *pxSocket, uint32_t ulAckNumber );
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+	/*
+	 * Calculate the hash of a SYN cookie, for a given value of the time
+	 * counter.
+	 */
+	static uint32_t prvSynCookieHash( const TCPPacket_t *pxTCPPacket, uint32_t ulPeerSequenceNumber, uint32_t ulTime );
+
+	/*
+	 * Create a SYN cookie for the SYN in pxTCPPacket.  The MSS must be given
+	 * in '*pusMSS', it will be replaced by the MSS that is encoded.
+	 */
+	static uint32_t prvSynCookieCreate( const TCPPacket_t *pxTCPPacket, uint16_t *pusMSS );
+
+	/*
+	 * Check if the ACK in pxTCPPacket confirms a valid SYN cookie.  If so,
+	 * return pdTRUE and the encoded MSS in '*pusMSS'.
+	 */
+	static BaseType_t prvSynCookieCheck( const TCPPacket_t *pxTCPPacket, uint16_t *pusMSS );
+#endif /* ipconfigTCP_SYN_COOKIES */
+
 /*
  * After a listening socket receives a new connection, it may duplicate itself.
  * The copying takes place in prvTCPSocketCopy.
@@ -376,6 +662,45 @@ static NetworkBufferDescriptor_t *prvTCPBufferResize( FreeRTOS_Socket_t *pxSocke
 	static uint8_t prvWinScaleFactor( FreeRTOS_Socket_t *pxSocket );
 #endif
 
+/*
+ * Return the number of bytes that a time-stamp option occupies in every
+ * outgoing packet of this connection: either 0 or TCP_OPT_TIMESTAMP_SPACE.
+ */
+static UBaseType_t prvTCPTimestampLength( const FreeRTOS_Socket_t *pxSocket );
+
+/*
+ * If the connection uses time-stamps, write a time-stamp option at offset
+ * 'uxOptionsLength' of the option data.  Returns the new length of the
+ * options.
+ */
+static UBaseType_t prvTCPAddTimestampOption( FreeRTOS_Socket_t *pxSocket, TCPHeader_t *pxTCPHeader, UBaseType_t uxOptionsLength );
+
+/*
+ * Called for every packet received, after the options have been parsed.  In
+ * the SYN phase it decides whether time-stamps will be used, later on it
+ * keeps track of the time-stamp to be echoed (TS.Recent).
+ */
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	static void prvTCPCheckTimestamp( FreeRTOS_Socket_t *pxSocket, uint16_t usTCPFlags, uint32_t ulSequenceNumber );
+#endif
+
+/*
+ * Returns pdTRUE when pxNextBuffer carries the next data segment of the same
+ * connection as pxNetworkBuffer: no flags other than ACK and PSH, and a
+ * sequence number that follows the data of pxNetworkBuffer directly.
+ */
+#if( ipconfigUSE_TCP_GRO != 0 )
+	static BaseType_t prvTCPSegmentFollows( const NetworkBufferDescriptor_t *pxNetworkBuffer, const NetworkBufferDescriptor_t *pxNextBuffer );
+#endif
+
+/*
+ * Pass the data that was held back while a burst of segments came in to the
+ * socket's OnReceive handler, in a single call (or two when rxStream wraps).
+ */
+#if( ipconfigUSE_TCP_GRO != 0 )
+	static void prvTCPDeliverDeferred( FreeRTOS_Socket_t *pxSocket );
+#endif
+
 /*
  * Generate a randomized TCP Initial Sequence Number per RFC.
  */
@@ -512,8 +837,19 @@ BaseType_t xReady = pdFALSE;
 				/* Earlier data was received but not yet acknowledged.  This
 				function is called when the TCP timer for the socket expires, the
 				ACK may be sent now. */
-				if( pxSocket->u.xTCP.ucTCPState != eCLOSED )
+				if( ( pxSocket->u.xTCP.ucTCPState >= eESTABLISHED ) && ( prvTCPSendPacket( pxSocket ) > 0 ) )
+				{
+					/* Outgoing data was waiting, and the acknowledgement
+					has been piggybacked on it.  The delayed ACK message is not
+					needed any more. */
+				}
+				else if( pxSocket->u.xTCP.ucTCPState != eCLOSED )
 				{
+				TCPPacket_t *pxAckPacket = ( TCPPacket_t * ) pxSocket->u.xTCP.pxAckMessage->pucEthernetBuffer;
+				/* The only option that a delayed ACK may carry is a time-stamp,
+				refresh it now. */
+				UBaseType_t uxOptionsLength = prvTCPAddTimestampOption( pxSocket, &( pxAckPacket->xTCPHeader ), 0u );
+
 					if( xTCPWindowLoggingLevel > 1 && ipconfigTCP_MAY_LOG_PORT( pxSocket->usLocalPort ) )
 					{
 						FreeRTOS_debug_printf( ( "Send[%u->%u] del ACK %lu SEQ %lu (len %u)\n",
@@ -521,10 +857,10 @@ BaseType_t xReady = pdFALSE;
 							pxSocket->u.xTCP.usRemotePort,
 							pxSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber - pxSocket->u.xTCP.xTCPWindow.rx.ulFirstSequenceNumber,
 							pxSocket->u.xTCP.xTCPWindow.ulOurSequenceNumber   - pxSocket->u.xTCP.xTCPWindow.tx.ulFirstSequenceNumber,
-							ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER ) );
+							ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength ) );
 					}
 
-					prvTCPReturnPacket( pxSocket, pxSocket->u.xTCP.pxAckMessage, ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER, ipconfigZERO_COPY_TX_DRIVER );
+					prvTCPReturnPacket( pxSocket, pxSocket->u.xTCP.pxAckMessage, ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength, ipconfigZERO_COPY_TX_DRIVER );
 
 					#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
 					{
@@ -588,6 +924,7 @@ BaseType_t xReady = pdFALSE;
 static int32_t prvTCPSendPacket( FreeRTOS_Socket_t *pxSocket )
 {
 int32_t lResult = 0;
+int32_t lFastOpenLength = 0;
 UBaseType_t uxOptionsLength;
 TCPPacket_t *pxTCPPacket;
 NetworkBufferDescriptor_t *pxNetworkBuffer;
@@ -644,10 +981,28 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 			of tries. */
 			pxSocket->u.xTCP.ucRepCount++;
 
-			/* Send the SYN message to make a connection.  The messages is
-			stored in the socket field 'xPacket'.  It will be wrapped in a
-			pseudo network buffer descriptor before it will be sent. */
-			prvTCPReturnPacket( pxSocket, NULL, ( uint32_t ) lResult, pdFALSE );
+			#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+			{
+				/* Only the first SYN carries the Fast Open option, a
+				repeated SYN might have been dropped because of it. */
+				if( ( pxSocket->u.xTCP.bits.bFastOpen != pdFALSE_UNSIGNED ) && ( pxSocket->u.xTCP.ucRepCount == 1u ) )
+				{
+					lFastOpenLength = prvTCPSendFastOpenSyn( pxSocket, uxOptionsLength );
+				}
+			}
+			#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
+			if( lFastOpenLength > 0 )
+			{
+				lResult = lFastOpenLength;
+			}
+			else
+			{
+				/* Send the SYN message to make a connection.  The messages is
+				stored in the socket field 'xPacket'.  It will be wrapped in a
+				pseudo network buffer descriptor before it will be sent. */
+				prvTCPReturnPacket( pxSocket, NULL, ( uint32_t ) lResult, pdFALSE );
+			}
 		}
 	}
 
@@ -664,29 +1019,43 @@ static int32_t prvTCPSendRepeated( FreeRTOS_Socket_t *pxSocket, NetworkBufferDes
 {
 UBaseType_t uxIndex;
 int32_t lResult = 0;
-UBaseType_t uxOptionsLength = 0u;
+/* No options are sent, except for a time-stamp. */
+UBaseType_t uxOptionsLength = prvTCPTimestampLength( pxSocket );
 int32_t xSendLength;
 
-	for( uxIndex = 0u; uxIndex < ( UBaseType_t ) SEND_REPEATED_COUNT; uxIndex++ )
+	#if( ipconfigTCP_TSO != 0 )
 	{
-		/* prvTCPPrepareSend() might allocate a network buffer if there is data
-		to be sent. */
-		xSendLength = prvTCPPrepareSend( pxSocket, ppxNetworkBuffer, uxOptionsLength );
-		if( xSendLength <= 0 )
-		{
-			break;
-		}
+		/* Plain data is sent in one pass.  A window update or a keep-alive
+		message without data is left to prvTCPPrepareSend(). */
+		lResult = prvTCPSendBurst( pxSocket, ppxNetworkBuffer );
+	}
+	#endif /* ipconfigTCP_TSO */
 
-		/* And return the packet to the peer. */
-		prvTCPReturnPacket( pxSocket, *ppxNetworkBuffer, ( uint32_t ) xSendLength, ipconfigZERO_COPY_TX_DRIVER );
+	if( lResult <= 0 )
+	{
+		lResult = 0;
 
-		#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
+		for( uxIndex = 0u; uxIndex < ( UBaseType_t ) SEND_REPEATED_COUNT; uxIndex++ )
 		{
-			*ppxNetworkBuffer = NULL;
-		}
-		#endif /* ipconfigZERO_COPY_TX_DRIVER */
+			/* prvTCPPrepareSend() might allocate a network buffer if there is data
+			to be sent. */
+			xSendLength = prvTCPPrepareSend( pxSocket, ppxNetworkBuffer, uxOptionsLength );
+			if( xSendLength <= 0 )
+			{
+				break;
+			}
+
+			/* And return the packet to the peer. */
+			prvTCPReturnPacket( pxSocket, *ppxNetworkBuffer, ( uint32_t ) xSendLength, ipconfigZERO_COPY_TX_DRIVER );
 
-		lResult += xSendLength;
+			#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
+			{
+				*ppxNetworkBuffer = NULL;
+			}
+			#endif /* ipconfigZERO_COPY_TX_DRIVER */
+
+			lResult += xSendLength;
+		}
 	}
 
 	/* Return the total number of bytes sent. */
@@ -694,167 +1063,426 @@ int32_t xSendLength;
 }
 /*-----------------------------------------------------------*/
 
-/*
- * Return (or send) a packet the the peer.  The data is stored in pxBuffer,
- * which may either point to a real network buffer or to a TCP socket field
- * called 'xTCP.xPacket'.   A temporary xNetworkBuffer will be used to pass
- * the data to the NIC.
- */
-static void prvTCPReturnPacket( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulLen, BaseType_t xReleaseAfterSend )
-{
-TCPPacket_t * pxTCPPacket;
-IPHeader_t *pxIPHeader;
-EthernetHeader_t *pxEthernetHeader;
-uint32_t ulFrontSpace, ulSpace, ulSourceAddress, ulWinSize;
-TCPWindow_t *pxTCPWindow;
-NetworkBufferDescriptor_t xTempBuffer;
-/* For sending, a pseudo network buffer will be used, as explained above. */
+#if( ipconfigTCP_TSO != 0 )
 
-	if( pxNetworkBuffer == NULL )
+	static int32_t prvTCPSendBurst( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t **ppxNetworkBuffer )
 	{
-		pxNetworkBuffer = &xTempBuffer;
-
-		#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+	TCPPacket_t xTemplate, *pxTCPPacket;
+	NetworkBufferDescriptor_t *pxNetworkBuffer = NULL;
+	UBaseType_t uxOptionsLength, uxHeaderLength, uxIndex;
+	uint32_t ulSequenceNumber, ulFirstSequence = 0ul, ulBurstLength = 0ul, ulMaxLength, ulDistance;
+	int32_t lDataLen, lStreamPos, lResult = 0;
+	size_t uxOffset;
+	uint16_t usTSOSegmentSize = 0u;
+	BaseType_t xReleaseAfterSend;
+
+		if( ( pxSocket->u.xTCP.ucTCPState != ( uint8_t ) eESTABLISHED ) ||
+			( pxSocket->u.xTCP.txStream == NULL ) ||
+			( pxSocket->u.xTCP.usCurMSS <= 1u ) ||
+			( pxSocket->u.xTCP.bits.bUserShutdown != pdFALSE_UNSIGNED ) ||
+			( pxSocket->u.xTCP.bits.bSendKeepAlive != pdFALSE_UNSIGNED ) )
 		{
-			xTempBuffer.pxNextBuffer = NULL;
+			/* Leave the special cases to prvTCPPrepareSend(). */
+			return -1;
 		}
-		#endif
-		xTempBuffer.pucEthernetBuffer = pxSocket->u.xTCP.xPacket.u.ucLastPacket;
-		xTempBuffer.xDataLength = sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket );
-		xReleaseAfterSend = pdFALSE;
-	}
 
-	#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
-	{
-		if( xReleaseAfterSend == pdFALSE )
+		uxOptionsLength = prvTCPTimestampLength( pxSocket );
+		uxHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength;
+		ulMaxLength = ( uint32_t ) pxSocket->u.xTCP.usCurMSS;
+
+		#if( ipconfigDRIVER_SUPPORTS_TSO != 0 )
 		{
-			pxNetworkBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, ( BaseType_t ) pxNetworkBuffer->xDataLength );
-			if( pxNetworkBuffer == NULL )
+			/* A super-segment only fits in a network buffer of variable
+			size.  The IP length field limits it to 64 KB. */
+			if( xBufferAllocFixedSize == pdFALSE )
 			{
-				FreeRTOS_debug_printf( ( "prvTCPReturnPacket: duplicate failed\n" ) );
+				usTSOSegmentSize = pxSocket->u.xTCP.usCurMSS;
+				ulMaxLength = FreeRTOS_min_uint32( ( uint32_t ) ipconfigTCP_TSO_MAX_SEGMENTS * ulMaxLength,
+					0xffffUL - ( uint32_t ) ( uxHeaderLength - ipSIZE_OF_ETH_HEADER ) );
 			}
-			xReleaseAfterSend = pdTRUE;
 		}
-	}
-	#endif /* ipconfigZERO_COPY_TX_DRIVER */
+		#endif /* ipconfigDRIVER_SUPPORTS_TSO */
 
-	if( pxNetworkBuffer != NULL )
-	{
-		pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
-		pxIPHeader = &pxTCPPacket->xIPHeader;
-		pxEthernetHeader = &pxTCPPacket->xEthernetHeader;
+		/* Without zero-copy and TSO, the driver copies the packet and one
+		network buffer can be used for the whole burst. */
+		xReleaseAfterSend = ( ( ipconfigZERO_COPY_TX_DRIVER != 0 ) || ( usTSOSegmentSize != 0u ) ) ? pdTRUE : pdFALSE;
 
-		/* Fill the packet, using hton translations. */
-		if( pxSocket != NULL )
+		for( uxIndex = 0u; uxIndex < ( UBaseType_t ) ipconfigTCP_TSO_MAX_SEGMENTS; uxIndex++ )
 		{
-			/* Calculate the space in the RX buffer in order to advertise the
-			size of this socket's reception window. */
-			pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+			lDataLen = ( int32_t ) ulTCPWindowTxGet( pxTCPWindow, pxSocket->u.xTCP.ulWindowSize, &lStreamPos );
 
-			if( pxSocket->u.xTCP.rxStream != NULL )
-			{
-				/* An RX stream was created already, see how much space is
-				available. */
-				ulFrontSpace = ( uint32_t ) uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
-			}
-			else
+			if( lDataLen <= 0 )
 			{
-				/* No RX stream has been created, the full stream size is
-				available. */
-				ulFrontSpace = ( uint32_t ) pxSocket->u.xTCP.uxRxStreamSize;
+				break;
 			}
 
-			/* Take the minimum of the RX buffer space and the RX window size. */
-			ulSpace = FreeRTOS_min_uint32( pxTCPWindow->xSize.ulRxWindowLength, ulFrontSpace );
+			ipCOUNT_SOCKET_EVENT( pxSocket, ulTxPackets, 1 );
+			ipCOUNT_SOCKET_EVENT( pxSocket, ulTxBytes, lDataLen );
+
+			ulSequenceNumber = pxTCPWindow->ulOurSequenceNumber;
+			lResult += ( int32_t ) ( uxHeaderLength - ipSIZE_OF_ETH_HEADER ) + lDataLen;
 
-			if( ( pxSocket->u.xTCP.bits.bLowWater != pdFALSE_UNSIGNED ) || ( pxSocket->u.xTCP.bits.bRxStopped != pdFALSE_UNSIGNED ) )
+			if( uxIndex == 0u )
 			{
-				/* The low-water mark was reached, meaning there was little
-				space left.  The socket will wait until the application has read
-				or flushed the incoming data, and 'zero-window' will be
-				advertised. */
-				ulSpace = 0u;
+				/* 'xPacket' holds the header as it was received from the
+				peer.  Turn it around once, in stead of for every packet. */
+				memcpy( &xTemplate, pxSocket->u.xTCP.xPacket.u.ucLastPacket, sizeof( xTemplate ) );
+				memcpy( &( xTemplate.xEthernetHeader.xDestinationAddress ), &( xTemplate.xEthernetHeader.xSourceAddress ), sizeof( MACAddress_t ) );
+				memcpy( &( xTemplate.xEthernetHeader.xSourceAddress ), ipLOCAL_MAC_ADDRESS, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
+				xTemplate.xIPHeader.ulDestinationIPAddress = xTemplate.xIPHeader.ulSourceIPAddress;
+				xTemplate.xIPHeader.ulSourceIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+				xTemplate.xIPHeader.ucTimeToLive = ( uint8_t ) ipconfigTCP_TIME_TO_LIVE;
+				xTemplate.xIPHeader.usFragmentOffset = 0u;
+				#if( ipconfigUSE_DSCP != 0 )
+				{
+					xTemplate.xIPHeader.ucDifferentiatedServicesCode = ( uint8_t ) ( pxSocket->ucDSCP << 2 );
+				}
+				#endif
+				vFlip_16( xTemplate.xTCPHeader.usSourcePort, xTemplate.xTCPHeader.usDestinationPort );
+				xTemplate.xTCPHeader.ucTCPFlags = ( uint8_t ) ( ipTCP_FLAG_ACK | ipTCP_FLAG_PSH );
+				xTemplate.xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+				xTemplate.xTCPHeader.ulAckNr = FreeRTOS_htonl( pxTCPWindow->rx.ulCurrentSequenceNumber );
+				( void ) prvTCPAddTimestampOption( pxSocket, &( xTemplate.xTCPHeader ), 0u );
+				prvTCPSetWindowField( pxSocket, &xTemplate );
 			}
 
-			/* If possible, advertise an RX window size of at least 1 MSS, otherwise
-			the peer might start 'zero window probing', i.e. sending small packets
-			(1, 2, 4, 8... bytes). */
-			if( ( ulSpace < pxSocket->u.xTCP.usCurMSS ) && ( ulFrontSpace >= pxSocket->u.xTCP.usCurMSS ) )
+			if( ( pxNetworkBuffer != NULL ) &&
+				( ( ulSequenceNumber != ( ulFirstSequence + ulBurstLength ) ) || ( ( ulBurstLength + ( uint32_t ) lDataLen ) > ulMaxLength ) ) )
 			{
-				ulSpace = pxSocket->u.xTCP.usCurMSS;
+				/* The segment can not be joined with the pending packet. */
+				prvTCPBurstOutput( pxNetworkBuffer, ulFirstSequence, ulBurstLength, uxOptionsLength, usTSOSegmentSize, xReleaseAfterSend );
+				pxNetworkBuffer = NULL;
 			}
 
-			/* Avoid overflow of the 16-bit win field. */
-			#if( ipconfigUSE_TCP_WIN != 0 )
+			if( pxNetworkBuffer == NULL )
 			{
-				ulWinSize = ( ulSpace >> pxSocket->u.xTCP.ucMyWinScaleFactor );
+				if( xReleaseAfterSend != pdFALSE )
+				{
+					pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( uxHeaderLength + ulMaxLength, 0u );
+				}
+				else
+				{
+					/* The caller's buffer is often the packet that was just
+					received, e.g. a bare ACK.  Make sure it can hold a full
+					segment, as prvTCPPrepareSend() does.  The caller will
+					release the buffer. */
+					pxNetworkBuffer = prvTCPBufferResize( pxSocket, *ppxNetworkBuffer, ( int32_t ) ulMaxLength, uxOptionsLength );
+
+					if( pxNetworkBuffer != NULL )
+					{
+						*ppxNetworkBuffer = pxNetworkBuffer;
+					}
+				}
+
+				if( pxNetworkBuffer == NULL )
+				{
+					/* The segment will be retransmitted when its timer
+					expires, like in prvTCPPrepareSend(). */
+					break;
+				}
+
+				memcpy( pxNetworkBuffer->pucEthernetBuffer, &xTemplate, uxHeaderLength );
+				ulFirstSequence = ulSequenceNumber;
+				ulBurstLength = 0ul;
 			}
-			#else
+
+			/* Copy the data in 'peek' mode, the tail of txStream will only
+			move when the data has been acknowledged. */
+			uxOffset = uxStreamBufferDistance( pxSocket->u.xTCP.txStream, pxSocket->u.xTCP.txStream->uxTail, ( size_t ) lStreamPos );
+			#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
 			{
-				ulWinSize = ulSpace;
+				( void ) prvTCPTxCopy( pxSocket, uxOffset, pxNetworkBuffer->pucEthernetBuffer + uxHeaderLength + ulBurstLength, ( size_t ) lDataLen );
 			}
-			#endif
-			if( ulWinSize > 0xfffcUL )
+			#else
 			{
-				ulWinSize = 0xfffcUL;
+				( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, pxNetworkBuffer->pucEthernetBuffer + uxHeaderLength + ulBurstLength, ( size_t ) lDataLen, pdTRUE );
 			}
+			#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
 
-			pxTCPPacket->xTCPHeader.usWindow = FreeRTOS_htons( ( uint16_t ) ulWinSize );
+			ulBurstLength += ( uint32_t ) lDataLen;
 
-			#if( ipconfigHAS_DEBUG_PRINTF != 0 )
+			/* The owner may have asked to close the connection after the
+			last byte.  See also prvTCPPrepareSend(). */
+			if( ( pxSocket->u.xTCP.bits.bCloseRequested != pdFALSE_UNSIGNED ) && ( pxSocket->u.xTCP.bits.bFinSent == pdFALSE_UNSIGNED ) )
 			{
-				if( ipconfigTCP_MAY_LOG_PORT( pxSocket->usLocalPort ) != pdFALSE )
-				{
-					if( ( xTCPWindowLoggingLevel != 0 ) && ( pxSocket->u.xTCP.bits.bWinChange != pdFALSE_UNSIGNED ) )
-					{
-					size_t uxFrontSpace;
-
-						if(pxSocket->u.xTCP.rxStream != NULL)
-						{
-							uxFrontSpace =  uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream ) ;
-						}
-						else
-						{
-							uxFrontSpace = 0u;
-						}
+				ulDistance = ( uint32_t ) uxStreamBufferDistance( pxSocket->u.xTCP.txStream, ( size_t ) lStreamPos, pxSocket->u.xTCP.txStream->uxHead );
 
-						FreeRTOS_debug_printf( ( "%s: %lxip:%u: [%lu < %lu] winSize %ld\n",
-						pxSocket->u.xTCP.bits.bLowWater ? "STOP" : "GO ",
-							pxSocket->u.xTCP.ulRemoteIP,
-							pxSocket->u.xTCP.usRemotePort,
-							pxSocket->u.xTCP.bits.bLowWater ? pxSocket->u.xTCP.uxLittleSpace : uxFrontSpace, pxSocket->u.xTCP.uxEnoughSpace,
-							(int32_t) ( pxTCPWindow->rx.ulHighestSequenceNumber - pxTCPWindow->rx.ulCurrentSequenceNumber ) ) );
-					}
+				if( ulDistance == ( uint32_t ) lDataLen )
+				{
+					pxTCPPacket = ( TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+					pxTCPPacket->xTCPHeader.ucTCPFlags |= ( uint8_t ) ipTCP_FLAG_FIN;
+					pxTCPWindow->tx.ulFINSequenceNumber = ulSequenceNumber + ( uint32_t ) lDataLen;
+					pxSocket->u.xTCP.bits.bFinSent = pdTRUE_UNSIGNED;
 				}
 			}
-			#endif /* ipconfigHAS_DEBUG_PRINTF != 0 */
+		}
 
-			/* The new window size has been advertised, switch off the flag. */
-			pxSocket->u.xTCP.bits.bWinChange = pdFALSE_UNSIGNED;
+		if( pxNetworkBuffer != NULL )
+		{
+			prvTCPBurstOutput( pxNetworkBuffer, ulFirstSequence, ulBurstLength, uxOptionsLength, usTSOSegmentSize, xReleaseAfterSend );
+		}
 
-			/* Later on, when deciding to delay an ACK, a precise estimate is needed
-			of the free RX space.  At this moment, 'ulHighestRxAllowed' would be the
-			highest sequence number minus 1 that the socket will accept. */
-			pxSocket->u.xTCP.ulHighestRxAllowed = pxTCPWindow->rx.ulCurrentSequenceNumber + ulSpace;
+		return lResult;
+	}
 
-			#if( ipconfigTCP_KEEP_ALIVE == 1 )
-				if( pxSocket->u.xTCP.bits.bSendKeepAlive != pdFALSE_UNSIGNED )
-				{
-					/* Sending a keep-alive packet, send the current sequence number
-					minus 1, which will	be recognised as a keep-alive packet an
-					responded to by acknowledging the last byte. */
-					pxSocket->u.xTCP.bits.bSendKeepAlive = pdFALSE_UNSIGNED;
-					pxSocket->u.xTCP.bits.bWaitKeepAlive = pdTRUE_UNSIGNED;
+#endif /* ipconfigTCP_TSO */
+/*-----------------------------------------------------------*/
 
-					pxTCPPacket->xTCPHeader.ulSequenceNumber = pxSocket->u.xTCP.xTCPWindow.ulOurSequenceNumber - 1UL;
-					pxTCPPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+#if( ipconfigTCP_TSO != 0 )
+
+	static void prvTCPBurstOutput( NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulSequenceNumber,
+		uint32_t ulDataLength, UBaseType_t uxOptionsLength, uint16_t usTSOSegmentSize, BaseType_t xReleaseAfterSend )
+	{
+	TCPPacket_t *pxTCPPacket = ( TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+	IPHeader_t *pxIPHeader = &( pxTCPPacket->xIPHeader );
+	uint32_t ulLen = ( uint32_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength ) + ulDataLength;
+
+		pxTCPPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulSequenceNumber );
+		pxIPHeader->usLength = FreeRTOS_htons( ( uint16_t ) ulLen );
+		pxIPHeader->usIdentification = FreeRTOS_htons( usPacketIdentifier );
+		usPacketIdentifier++;
+		pxNetworkBuffer->xDataLength = ( size_t ) ulLen + ipSIZE_OF_ETH_HEADER;
+
+		#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+		{
+			pxNetworkBuffer->pxNextBuffer = NULL;
+		}
+		#endif
+
+		#if( ipconfigDRIVER_SUPPORTS_TSO != 0 )
+		if( ( usTSOSegmentSize != 0u ) && ( ulDataLength > ( uint32_t ) usTSOSegmentSize ) )
+		{
+			/* The driver splits the packet and calculates the checksums of
+			every frame. */
+			xNetworkInterfaceOutputTSO( pxNetworkBuffer, usTSOSegmentSize, xReleaseAfterSend );
+		}
+		else
+		#endif /* ipconfigDRIVER_SUPPORTS_TSO */
+		{
+			( void ) usTSOSegmentSize;
+
+			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+			{
+				pxIPHeader->usHeaderChecksum = 0x00u;
+				pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+				pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+
+				usGenerateProtocolChecksum( ( uint8_t * ) pxTCPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+
+				if( pxTCPPacket->xTCPHeader.usChecksum == 0x00u )
+				{
+					pxTCPPacket->xTCPHeader.usChecksum = 0xffffU;
 				}
-				else
+			}
 			#endif
-			{
-				pxTCPPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( pxSocket->u.xTCP.xTCPWindow.ulOurSequenceNumber );
 
-				if( ( pxTCPPacket->xTCPHeader.ucTCPFlags & ( uint8_t ) ipTCP_FLAG_FIN ) != 0u )
+			#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+			{
+				if( pxNetworkBuffer->xDataLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+				{
+					memset( pxNetworkBuffer->pucEthernetBuffer + pxNetworkBuffer->xDataLength, '\0', ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES - pxNetworkBuffer->xDataLength );
+					pxNetworkBuffer->xDataLength = ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES;
+				}
+			}
+			#endif
+
+			ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend );
+		}
+	}
+
+#endif /* ipconfigTCP_TSO */
+/*-----------------------------------------------------------*/
+
+/*
+ * Fill in the size of the reception window that will be advertised in an
+ * outgoing packet.  Every packet carries the latest acknowledgement.
+ */
+static void prvTCPSetWindowField( FreeRTOS_Socket_t *pxSocket, TCPPacket_t *pxTCPPacket )
+{
+uint32_t ulFrontSpace, ulSpace, ulWinSize;
+TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+
+	#if( ipconfigUSE_TCP_WIN == 1 )
+	{
+		/* Every packet carries the latest acknowledgement. */
+		pxSocket->u.xTCP.ucUnackedSegments = 0u;
+	}
+	#endif /* ipconfigUSE_TCP_WIN */
+
+	if( pxSocket->u.xTCP.rxStream != NULL )
+	{
+		/* An RX stream was created already, see how much space is
+		available. */
+		ulFrontSpace = ( uint32_t ) uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
+	}
+	else
+	{
+		/* No RX stream has been created, the full stream size is
+		available. */
+		ulFrontSpace = ( uint32_t ) pxSocket->u.xTCP.uxRxStreamSize;
+	}
+
+	/* Take the minimum of the RX buffer space and the RX window size. */
+	ulSpace = FreeRTOS_min_uint32( pxTCPWindow->xSize.ulRxWindowLength, ulFrontSpace );
+
+	if( ( pxSocket->u.xTCP.bits.bLowWater != pdFALSE_UNSIGNED ) || ( pxSocket->u.xTCP.bits.bRxStopped != pdFALSE_UNSIGNED ) )
+	{
+		/* The low-water mark was reached, meaning there was little
+		space left.  The socket will wait until the application has read
+		or flushed the incoming data, and 'zero-window' will be
+		advertised. */
+		ulSpace = 0u;
+	}
+
+	/* If possible, advertise an RX window size of at least 1 MSS, otherwise
+	the peer might start 'zero window probing', i.e. sending small packets
+	(1, 2, 4, 8... bytes). */
+	if( ( ulSpace < pxSocket->u.xTCP.usCurMSS ) && ( ulFrontSpace >= pxSocket->u.xTCP.usCurMSS ) )
+	{
+		ulSpace = pxSocket->u.xTCP.usCurMSS;
+	}
+
+	/* Avoid overflow of the 16-bit win field. */
+	#if( ipconfigUSE_TCP_WIN != 0 )
+	{
+		if( ( pxTCPPacket->xTCPHeader.ucTCPFlags & ipTCP_FLAG_SYN ) != 0u )
+		{
+			/* RFC 7323: the window field of a SYN or SYN+ACK is never
+			scaled. */
+			ulWinSize = ulSpace;
+		}
+		else
+		{
+			ulWinSize = ( ulSpace >> pxSocket->u.xTCP.ucMyWinScaleFactor );
+		}
+	}
+	#else
+	{
+		ulWinSize = ulSpace;
+	}
+	#endif
+	if( ulWinSize > 0xfffcUL )
+	{
+		ulWinSize = 0xfffcUL;
+	}
+
+	pxTCPPacket->xTCPHeader.usWindow = FreeRTOS_htons( ( uint16_t ) ulWinSize );
+
+	#if( ipconfigHAS_DEBUG_PRINTF != 0 )
+	{
+		if( ipconfigTCP_MAY_LOG_PORT( pxSocket->usLocalPort ) != pdFALSE )
+		{
+			if( ( xTCPWindowLoggingLevel != 0 ) && ( pxSocket->u.xTCP.bits.bWinChange != pdFALSE_UNSIGNED ) )
+			{
+			size_t uxFrontSpace;
+
+				if(pxSocket->u.xTCP.rxStream != NULL)
+				{
+					uxFrontSpace =  uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream ) ;
+				}
+				else
+				{
+					uxFrontSpace = 0u;
+				}
+
+				FreeRTOS_debug_printf( ( "%s: %lxip:%u: [%lu < %lu] winSize %ld\n",
+				pxSocket->u.xTCP.bits.bLowWater ? "STOP" : "GO ",
+					pxSocket->u.xTCP.ulRemoteIP,
+					pxSocket->u.xTCP.usRemotePort,
+					pxSocket->u.xTCP.bits.bLowWater ? pxSocket->u.xTCP.uxLittleSpace : uxFrontSpace, pxSocket->u.xTCP.uxEnoughSpace,
+					(int32_t) ( pxTCPWindow->rx.ulHighestSequenceNumber - pxTCPWindow->rx.ulCurrentSequenceNumber ) ) );
+			}
+		}
+	}
+	#endif /* ipconfigHAS_DEBUG_PRINTF != 0 */
+
+	/* The new window size has been advertised, switch off the flag. */
+	pxSocket->u.xTCP.bits.bWinChange = pdFALSE_UNSIGNED;
+
+	/* Later on, when deciding to delay an ACK, a precise estimate is needed
+	of the free RX space.  At this moment, 'ulHighestRxAllowed' would be the
+	highest sequence number minus 1 that the socket will accept. */
+	pxSocket->u.xTCP.ulHighestRxAllowed = pxTCPWindow->rx.ulCurrentSequenceNumber + ulSpace;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Return (or send) a packet the the peer.  The data is stored in pxBuffer,
+ * which may either point to a real network buffer or to a TCP socket field
+ * called 'xTCP.xPacket'.   A temporary xNetworkBuffer will be used to pass
+ * the data to the NIC.
+ */
+static void prvTCPReturnPacket( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulLen, BaseType_t xReleaseAfterSend )
+{
+TCPPacket_t * pxTCPPacket;
+IPHeader_t *pxIPHeader;
+EthernetHeader_t *pxEthernetHeader;
+uint32_t ulSourceAddress;
+TCPWindow_t *pxTCPWindow;
+NetworkBufferDescriptor_t xTempBuffer;
+/* For sending, a pseudo network buffer will be used, as explained above. */
+
+	if( pxNetworkBuffer == NULL )
+	{
+		pxNetworkBuffer = &xTempBuffer;
+
+		#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+		{
+			xTempBuffer.pxNextBuffer = NULL;
+		}
+		#endif
+		xTempBuffer.pucEthernetBuffer = pxSocket->u.xTCP.xPacket.u.ucLastPacket;
+		xTempBuffer.xDataLength = sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket );
+		xReleaseAfterSend = pdFALSE;
+	}
+
+	#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
+	{
+		if( xReleaseAfterSend == pdFALSE )
+		{
+			pxNetworkBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, ( BaseType_t ) pxNetworkBuffer->xDataLength );
+			if( pxNetworkBuffer == NULL )
+			{
+				FreeRTOS_debug_printf( ( "prvTCPReturnPacket: duplicate failed\n" ) );
+			}
+			xReleaseAfterSend = pdTRUE;
+		}
+	}
+	#endif /* ipconfigZERO_COPY_TX_DRIVER */
+
+	if( pxNetworkBuffer != NULL )
+	{
+		pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+		pxIPHeader = &pxTCPPacket->xIPHeader;
+		pxEthernetHeader = &pxTCPPacket->xEthernetHeader;
+
+		/* Fill the packet, using hton translations. */
+		if( pxSocket != NULL )
+		{
+			/* Calculate the space in the RX buffer in order to advertise the
+			size of this socket's reception window. */
+			pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+			prvTCPSetWindowField( pxSocket, pxTCPPacket );
+
+			#if( ipconfigTCP_KEEP_ALIVE == 1 )
+				if( pxSocket->u.xTCP.bits.bSendKeepAlive != pdFALSE_UNSIGNED )
+				{
+					/* Sending a keep-alive packet, send the current sequence number
+					minus 1, which will	be recognised as a keep-alive packet an
+					responded to by acknowledging the last byte. */
+					pxSocket->u.xTCP.bits.bSendKeepAlive = pdFALSE_UNSIGNED;
+					pxSocket->u.xTCP.bits.bWaitKeepAlive = pdTRUE_UNSIGNED;
+
+					pxTCPPacket->xTCPHeader.ulSequenceNumber = pxSocket->u.xTCP.xTCPWindow.ulOurSequenceNumber - 1UL;
+					pxTCPPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+				}
+				else
+			#endif
+			{
+				pxTCPPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( pxSocket->u.xTCP.xTCPWindow.ulOurSequenceNumber );
+
+				if( ( pxTCPPacket->xTCPHeader.ucTCPFlags & ( uint8_t ) ipTCP_FLAG_FIN ) != 0u )
 				{
 					/* Suppress FIN in case this packet carries earlier data to be
 					retransmitted. */
@@ -872,6 +1500,14 @@ NetworkBufferDescriptor_t xTempBuffer;
 
 			/* Tell which sequence number is expected next time */
 			pxTCPPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( pxTCPWindow->rx.ulCurrentSequenceNumber );
+
+			#if( ipconfigUSE_DSCP != 0 )
+			{
+				/* The header was copied from a received packet, do not
+				reflect the peer's DSCP and ECN bits. */
+				pxIPHeader->ucDifferentiatedServicesCode = ( uint8_t ) ( pxSocket->ucDSCP << 2 );
+			}
+			#endif
 		}
 		else
 		{
@@ -952,7 +1588,7 @@ NetworkBufferDescriptor_t xTempBuffer;
 		#endif
 
 		/* Send! */
-		xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+		ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend );
 
 		if( xReleaseAfterSend == pdFALSE )
 		{
@@ -1109,6 +1745,12 @@ uint32_t ulInitialSequenceNumber = 0;
 		/* Start with ISN (Initial Sequence Number). */
 		pxSocket->u.xTCP.xTCPWindow.ulOurSequenceNumber = ulInitialSequenceNumber;
 
+		#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+		{
+			pxSocket->u.xTCP.ulFastOpenSent = 0u;
+		}
+		#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
 		/* The TCP header size is 20 bytes, divided by 4 equals 5, which is put in
 		the high nibble of the TCP offset field. */
 		pxTCPPacket->xTCPHeader.ucTCPOffset = 0x50u;
@@ -1224,11 +1866,61 @@ static BaseType_t prvSingleStepTCPHeaderOptions( const unsigned char ** const pp
 			return pdFALSE;
 		}
 
-		( *ppxSocket )->u.xTCP.ucPeerWinScaleFactor = ( *ppucPtr )[ 2 ];
-		( *ppxSocket )->u.xTCP.bits.bWinScaling = pdTRUE_UNSIGNED;
+		/* RFC 7323: the option is only valid in a SYN or SYN+ACK, in other
+		segments it is ignored. */
+		if( ( ( *ppxSocket )->u.xTCP.ucTCPState == eSYN_FIRST ) || ( ( *ppxSocket )->u.xTCP.ucTCPState == eCONNECT_SYN ) )
+		{
+			ucLen = ( *ppucPtr )[ 2 ];
+			if( ucLen > TCP_WSOPT_MAX_SHIFT )
+			{
+				FreeRTOS_debug_printf( ( "WSOPT: shift count %u reduced to %u\n", ucLen, TCP_WSOPT_MAX_SHIFT ) );
+				ucLen = TCP_WSOPT_MAX_SHIFT;
+			}
+			( *ppxSocket )->u.xTCP.ucPeerWinScaleFactor = ucLen;
+			( *ppxSocket )->u.xTCP.bits.bWinScaling = pdTRUE_UNSIGNED;
+		}
 		( *ppucPtr ) += TCP_OPT_WSOPT_LEN;
 	}
 #endif	/* ipconfigUSE_TCP_WIN */
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	else if( ( *ppucPtr )[ 0 ] == TCP_OPT_TIMESTAMP )
+	{
+		/* Confirm that the option fits in the remaining buffer space. */
+		if( ( xRemainingOptionsBytes < TCP_OPT_TIMESTAMP_LEN ) || ( ( *ppucPtr )[ 1 ] != TCP_OPT_TIMESTAMP_LEN ) )
+		{
+			return pdFALSE;
+		}
+
+		/* The values will be checked by prvTCPCheckTimestamp(). */
+		( *ppxSocket )->u.xTCP.ulTSValue = ulChar2u32( ( *ppucPtr ) + 2 );
+		( *ppxSocket )->u.xTCP.ulTSEcho = ulChar2u32( ( *ppucPtr ) + 6 );
+		( *ppxSocket )->u.xTCP.bits.bTSReceived = pdTRUE_UNSIGNED;
+		( *ppucPtr ) += TCP_OPT_TIMESTAMP_LEN;
+	}
+#endif	/* ipconfigUSE_TCP_TIMESTAMPS */
+#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+	else if( ( *ppucPtr )[ 0 ] == TCP_OPT_FASTOPEN )
+	{
+		ucLen = ( *ppucPtr )[ 1 ];
+		if( ( ucLen < 2 ) || ( ucLen > xRemainingOptionsBytes ) )
+		{
+			return pdFALSE;
+		}
+
+		/* A cookie is only accepted in the SYN+ACK that answers our SYN. */
+		if( ( ( *ppxSocket )->u.xTCP.ucTCPState == eCONNECT_SYN ) &&
+			( ( *ppxSocket )->u.xTCP.bits.bFastOpen != pdFALSE_UNSIGNED ) &&
+			( ( UBaseType_t ) ucLen >= ( 2u + tcpFAST_OPEN_COOKIE_MIN ) ) &&
+			( ( UBaseType_t ) ucLen <= ( 2u + tcpFAST_OPEN_COOKIE_MAX ) ) )
+		{
+		FastOpenEntry_t *pxEntry = prvFastOpenLookup( ( *ppxSocket )->u.xTCP.ulRemoteIP, pdTRUE );
+
+			pxEntry->ucCookieLength = ( uint8_t ) ( ucLen - 2u );
+			memcpy( pxEntry->ucCookie, ( *ppucPtr ) + 2, ( size_t ) pxEntry->ucCookieLength );
+		}
+		( *ppucPtr ) += ucLen;
+	}
+#endif	/* ipconfigUSE_TCP_FAST_OPEN */
 	else if( ( *ppucPtr )[ 0 ] == TCP_OPT_MSS )
 	{
 		/* Confirm that the option fits in the remaining buffer space. */
@@ -1330,7 +2022,12 @@ uint32_t ulCount = ulTCPWindowTxSack( &( *ppxSocket )->u.xTCP.xTCPWindow, ulFirs
 	if( ( ( *ppxSocket )->u.xTCP.txStream  != NULL ) && ( ulCount > 0 ) )
 	{
 		/* Just advancing the tail index, 'ulCount' bytes have been confirmed. */
-		uxStreamBufferGet( ( *ppxSocket )->u.xTCP.txStream, 0, NULL, ( size_t ) ulCount, pdFALSE );
+		ulCount = ( uint32_t ) uxStreamBufferGet( ( *ppxSocket )->u.xTCP.txStream, 0, NULL, ( size_t ) ulCount, pdFALSE );
+		#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+		{
+			prvTCPTxReferencesAcked( *ppxSocket, ( size_t ) ulCount );
+		}
+		#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
 		( *ppxSocket )->xEventBits |= eSOCKET_SEND;
 
 		#if ipconfigSUPPORT_SELECT_FUNCTION == 1
@@ -1372,7 +2069,7 @@ uint32_t ulCount = ulTCPWindowTxSack( &( *ppxSocket )->u.xTCP.xTCPWindow, ulFirs
 		/* 'xTCP.uxRxWinSize' is the size of the reception window in units of MSS. */
 		uxWinSize = pxSocket->u.xTCP.uxRxWinSize * ( size_t ) pxSocket->u.xTCP.usInitMSS;
 		ucFactor = 0u;
-		while( uxWinSize > 0xfffful )
+		while( ( uxWinSize > 0xfffful ) && ( ucFactor < TCP_WSOPT_MAX_SHIFT ) )
 		{
 			/* Divide by two and increase the binary factor by 1. */
 			uxWinSize >>= 1;
@@ -1390,6 +2087,102 @@ uint32_t ulCount = ulTCPWindowTxSack( &( *ppxSocket )->u.xTCP.xTCPWindow, ulFirs
 #endif
 /*-----------------------------------------------------------*/
 
+static UBaseType_t prvTCPTimestampLength( const FreeRTOS_Socket_t *pxSocket )
+{
+UBaseType_t uxReturn = 0u;
+
+	#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	{
+		if( pxSocket->u.xTCP.bits.bTimeStamps != pdFALSE_UNSIGNED )
+		{
+			uxReturn = TCP_OPT_TIMESTAMP_SPACE;
+		}
+	}
+	#else
+	{
+		( void ) pxSocket;
+	}
+	#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
+	return uxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvTCPAddTimestampOption( FreeRTOS_Socket_t *pxSocket, TCPHeader_t *pxTCPHeader, UBaseType_t uxOptionsLength )
+{
+UBaseType_t uxReturn = uxOptionsLength;
+
+	#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	{
+	uint8_t *pucOption;
+	uint32_t ulValue;
+
+		if( pxSocket->u.xTCP.bits.bTimeStamps != pdFALSE_UNSIGNED )
+		{
+			pucOption = &( pxTCPHeader->ucOptdata[ uxOptionsLength ] );
+			pucOption[ 0 ] = TCP_OPT_NOOP;
+			pucOption[ 1 ] = TCP_OPT_NOOP;
+			pucOption[ 2 ] = TCP_OPT_TIMESTAMP;
+			pucOption[ 3 ] = TCP_OPT_TIMESTAMP_LEN;
+
+			/* TSval: the time-stamp clock runs at the tick rate. */
+			ulValue = FreeRTOS_htonl( ( uint32_t ) xTaskGetTickCount() );
+			memcpy( pucOption + 4, &ulValue, sizeof( ulValue ) );
+
+			/* TSecr: echo the most recent time-stamp of the peer. */
+			ulValue = FreeRTOS_htonl( pxSocket->u.xTCP.ulTSRecent );
+			memcpy( pucOption + 8, &ulValue, sizeof( ulValue ) );
+
+			uxReturn += TCP_OPT_TIMESTAMP_SPACE;
+		}
+	}
+	#else
+	{
+		( void ) pxSocket;
+		( void ) pxTCPHeader;
+	}
+	#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
+	return uxReturn;
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+
+	static void prvTCPCheckTimestamp( FreeRTOS_Socket_t *pxSocket, uint16_t usTCPFlags, uint32_t ulSequenceNumber )
+	{
+		if( ( usTCPFlags & ipTCP_FLAG_SYN ) != 0u )
+		{
+			if( ( pxSocket->u.xTCP.ucTCPState == eSYN_FIRST ) || ( pxSocket->u.xTCP.ucTCPState == eCONNECT_SYN ) )
+			{
+				/* Time-stamps are only used if both SYN's carry the option.  A
+				connecting socket has offered them already, a listening socket
+				will only offer them in its SYN+ACK if the peer did. */
+				pxSocket->u.xTCP.bits.bTimeStamps = pxSocket->u.xTCP.bits.bTSReceived;
+
+				if( pxSocket->u.xTCP.bits.bTSReceived != pdFALSE_UNSIGNED )
+				{
+					pxSocket->u.xTCP.ulTSRecent = pxSocket->u.xTCP.ulTSValue;
+				}
+			}
+		}
+		else if( ( pxSocket->u.xTCP.bits.bTimeStamps != pdFALSE_UNSIGNED ) &&
+				 ( pxSocket->u.xTCP.bits.bTSReceived != pdFALSE_UNSIGNED ) )
+		{
+			/* RFC 7323 (4.3): remember the time-stamp to be echoed, but only
+			if the segment is not beyond the last ACK sent, and if the
+			time-stamp doesn't go backward. */
+			if( ( ( int32_t ) ( pxSocket->u.xTCP.ulTSValue - pxSocket->u.xTCP.ulTSRecent ) >= 0 ) &&
+				( ( int32_t ) ( ulSequenceNumber - pxSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber ) <= 0 ) )
+			{
+				pxSocket->u.xTCP.ulTSRecent = pxSocket->u.xTCP.ulTSValue;
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+/*-----------------------------------------------------------*/
+
 /*
  * When opening a TCP connection, while SYN's are being sent, the  parties may
  * communicate what MSS (Maximum Segment Size) they intend to use.   MSS is the
@@ -1410,13 +2203,23 @@ UBaseType_t uxOptionsLength;
 
 	#if( ipconfigUSE_TCP_WIN != 0 )
 	{
-		pxSocket->u.xTCP.ucMyWinScaleFactor = prvWinScaleFactor( pxSocket );
+		if( ( pxSocket->u.xTCP.ucTCPState == eCONNECT_SYN ) || ( pxSocket->u.xTCP.bits.bWinScaling != pdFALSE_UNSIGNED ) )
+		{
+			pxSocket->u.xTCP.ucMyWinScaleFactor = prvWinScaleFactor( pxSocket );
 
-		pxTCPHeader->ucOptdata[ 4 ] = TCP_OPT_NOOP;
-		pxTCPHeader->ucOptdata[ 5 ] = ( uint8_t ) ( TCP_OPT_WSOPT );
-		pxTCPHeader->ucOptdata[ 6 ] = ( uint8_t ) ( TCP_OPT_WSOPT_LEN );
-		pxTCPHeader->ucOptdata[ 7 ] = ( uint8_t ) pxSocket->u.xTCP.ucMyWinScaleFactor;
-		uxOptionsLength = 8u;
+			pxTCPHeader->ucOptdata[ 4 ] = TCP_OPT_NOOP;
+			pxTCPHeader->ucOptdata[ 5 ] = ( uint8_t ) ( TCP_OPT_WSOPT );
+			pxTCPHeader->ucOptdata[ 6 ] = ( uint8_t ) ( TCP_OPT_WSOPT_LEN );
+			pxTCPHeader->ucOptdata[ 7 ] = ( uint8_t ) pxSocket->u.xTCP.ucMyWinScaleFactor;
+			uxOptionsLength = 8u;
+		}
+		else
+		{
+			/* RFC 7323: a SYN+ACK may only carry a window scale option if the
+			SYN did. */
+			pxSocket->u.xTCP.ucMyWinScaleFactor = 0u;
+			uxOptionsLength = 4u;
+		}
 	}
 	#else
 	{
@@ -1436,6 +2239,19 @@ UBaseType_t uxOptionsLength;
 		pxTCPHeader->ucOptdata[ uxOptionsLength + 3 ] = 2;	/* 2: length of this option. */
 		uxOptionsLength += 4u;
 
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+			if( pxSocket->u.xTCP.ucTCPState == eCONNECT_SYN )
+			{
+				/* Offer the use of time-stamps.  The SYN+ACK will tell if the
+				peer agrees. */
+				pxSocket->u.xTCP.bits.bTimeStamps = pdTRUE_UNSIGNED;
+				pxSocket->u.xTCP.ulTSRecent = 0u;
+			}
+			uxOptionsLength = prvTCPAddTimestampOption( pxSocket, pxTCPHeader, uxOptionsLength );
+		}
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
 		return uxOptionsLength; /* bytes, not words. */
 	}
 	#endif	/* ipconfigUSE_TCP_WIN == 0 */
@@ -1491,6 +2307,14 @@ BaseType_t bAfter  = ( BaseType_t ) NOW_CONNECTED( eTCPState );						/* Is it co
 		/* Is the socket connected now ? */
 		if( bAfter != pdFALSE )
 		{
+			#if( ipconfigUSE_TCP_WIN == 1 )
+			{
+				/* Start in quick-ACK mode. */
+				pxSocket->u.xTCP.ucQuickAckCount = ( uint8_t ) ipconfigTCP_QUICK_ACK_COUNT;
+				pxSocket->u.xTCP.ucUnackedSegments = 0u;
+			}
+			#endif /* ipconfigUSE_TCP_WIN */
+
 			/* if bPassQueued is true, this socket is an orphan until it gets connected. */
 			if( pxSocket->u.xTCP.bits.bPassQueued != pdFALSE_UNSIGNED )
 			{
@@ -1758,6 +2582,9 @@ int32_t lStreamPos;
 
 		if( lDataLen > 0 )
 		{
+			ipCOUNT_SOCKET_EVENT( pxSocket, ulTxPackets, 1 );
+			ipCOUNT_SOCKET_EVENT( pxSocket, ulTxBytes, lDataLen );
+
 			/* Check if the current network buffer is big enough, if not,
 			resize it. */
 			pxNewBuffer = prvTCPBufferResize( pxSocket, *ppxNetworkBuffer, lDataLen, uxOptionsLength );
@@ -1776,7 +2603,15 @@ int32_t lStreamPos;
 
 				/* Here data is copied from the txStream in 'peek' mode.  Only
 				when the packets are acked, the tail marker will be updated. */
-				ulDataGot = ( uint32_t ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, pucSendData, ( size_t ) lDataLen, pdTRUE );
+				#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+				{
+					ulDataGot = ( uint32_t ) prvTCPTxCopy( pxSocket, uxOffset, pucSendData, ( size_t ) lDataLen );
+				}
+				#else
+				{
+					ulDataGot = ( uint32_t ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, pucSendData, ( size_t ) lDataLen, pdTRUE );
+				}
+				#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
 
 				#if( ipconfigHAS_DEBUG_PRINTF != 0 )
 				{
@@ -1885,6 +2720,10 @@ int32_t lStreamPos;
 		pxTCPPacket->xTCPHeader.ucTCPFlags &= ( ( uint8_t ) ~ipTCP_FLAG_PSH );
 		pxTCPPacket->xTCPHeader.ucTCPOffset = ( uint8_t )( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
 
+		/* A time-stamp option is always the last option.  It is written here
+		because the packet may have been copied from 'xPacket'. */
+		( void ) prvTCPAddTimestampOption( pxSocket, &( pxTCPPacket->xTCPHeader ), uxOptionsLength - prvTCPTimestampLength( pxSocket ) );
+
 		pxTCPPacket->xTCPHeader.ucTCPFlags |= ( uint8_t ) ipTCP_FLAG_ACK;
 
 		if( lDataLen != 0l )
@@ -2014,6 +2853,7 @@ uint8_t ucTCPFlags = pxTCPHeader->ucTCPFlags;
 TCPWindow_t *pxTCPWindow = &pxSocket->u.xTCP.xTCPWindow;
 BaseType_t xSendLength = 0;
 uint32_t ulAckNr = FreeRTOS_ntohl( pxTCPHeader->ulAckNr );
+UBaseType_t uxOptionsLength;
 
 	if( ( ucTCPFlags & ipTCP_FLAG_FIN ) != 0u )
 	{
@@ -2074,12 +2914,15 @@ uint32_t ulAckNr = FreeRTOS_ntohl( pxTCPHeader->ulAckNr );
 
 	pxTCPWindow->ulOurSequenceNumber = pxTCPWindow->tx.ulCurrentSequenceNumber;
 
+	/* The SACK option, if any, has been copied by prvSetOptions(). */
+	uxOptionsLength = prvTCPAddTimestampOption( pxSocket, pxTCPHeader, ( UBaseType_t ) pxTCPWindow->ucOptionLength );
+
 	if( pxTCPHeader->ucTCPFlags != 0u )
 	{
-		xSendLength = ( BaseType_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + pxTCPWindow->ucOptionLength );
+		xSendLength = ( BaseType_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength );
 	}
 
-	pxTCPHeader->ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + pxTCPWindow->ucOptionLength ) << 2 );
+	pxTCPHeader->ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
 
 	if( xTCPWindowLoggingLevel != 0 )
 	{
@@ -2167,8 +3010,9 @@ int32_t lLength, lTCPHeaderLength, lReceiveLength, lUrgentLength;
  * If so, they will be added to the reception queue.
  */
 static BaseType_t prvStoreRxData( FreeRTOS_Socket_t *pxSocket, uint8_t *pucRecvData,
-	NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulReceiveLength )
+	NetworkBufferDescriptor_t **ppxNetworkBuffer, uint32_t ulReceiveLength )
 {
+NetworkBufferDescriptor_t *pxNetworkBuffer = *ppxNetworkBuffer;
 TCPPacket_t *pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
 TCPHeader_t *pxTCPHeader = &pxTCPPacket->xTCPHeader;
 TCPWindow_t *pxTCPWindow = &pxSocket->u.xTCP.xTCPWindow;
@@ -2198,24 +3042,50 @@ BaseType_t xResult = 0;
 
 		lOffset = lTCPWindowRxCheck( pxTCPWindow, ulSequenceNumber, ulReceiveLength, ulSpace );
 
+		#if( ipconfigUSE_TCP_WIN == 1 )
+		{
+			/* A segment that is out of order, or that fills a gap, must be
+			acknowledged immediately (RFC 5681).  So will the next few. */
+			if( ( lOffset != 0 ) || ( pxTCPWindow->ulUserDataLength > 0u ) )
+			{
+				pxSocket->u.xTCP.ucQuickAckCount = ( uint8_t ) ipconfigTCP_QUICK_ACK_COUNT;
+			}
+		}
+		#endif /* ipconfigUSE_TCP_WIN */
+
 		if( lOffset >= 0 )
 		{
 			/* New data has arrived and may be made available to the user.  See
 			if the head marker in rxStream may be advanced,	only if lOffset == 0.
 			In case the low-water mark is reached, bLowWater will be set
 			"low-water" here stands for "little space". */
-			lStored = lTCPAddRxdata( pxSocket, ( uint32_t ) lOffset, pucRecvData, ulReceiveLength );
-
-			if( lStored != ( int32_t ) ulReceiveLength )
+			#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+			if( ( lOffset == 0 ) && ( prvTCPQueueRxBuffer( pxSocket, pucRecvData, ppxNetworkBuffer, ulReceiveLength ) != pdFALSE ) )
 			{
-				FreeRTOS_debug_printf( ( "lTCPAddRxdata: stored %ld / %lu bytes??\n", lStored, ulReceiveLength ) );
-
+				/* The network buffer now belongs to the socket, it may not be
+				accessed any more. */
+				lStored = ( int32_t ) ulReceiveLength;
+			}
+			else
+			#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+			{
+				lStored = lTCPAddRxdata( pxSocket, ( uint32_t ) lOffset, pucRecvData, ulReceiveLength );
+			}
+
+			if( lStored != ( int32_t ) ulReceiveLength )
+			{
+				FreeRTOS_debug_printf( ( "lTCPAddRxdata: stored %ld / %lu bytes??\n", lStored, ulReceiveLength ) );
+
 				/* Received data could not be stored.  The socket's flag
 				bMallocError has been set.  The socket now has the status
 				eCLOSE_WAIT and a RST packet will be sent back. */
 				prvTCPSendReset( pxNetworkBuffer );
 				xResult = -1;
 			}
+			else
+			{
+				ipCOUNT_SOCKET_EVENT( pxSocket, ulRxBytes, ulReceiveLength );
+			}
 		}
 
 		/* After a missing packet has come in, higher packets may be passed to
@@ -2242,6 +3112,174 @@ BaseType_t xResult = 0;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+
+	static BaseType_t prvTCPQueueRxBuffer( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucRecvData,
+		NetworkBufferDescriptor_t **ppxNetworkBuffer, uint32_t ulReceiveLength )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer = *ppxNetworkBuffer;
+	NetworkBufferDescriptor_t *pxReplyBuffer;
+	size_t uxHeaderLength, uxNeeded;
+	BaseType_t xReturn = pdFALSE;
+	BaseType_t xUseList = ( pxSocket->u.xTCP.bits.bRxZeroCopy != pdFALSE_UNSIGNED ) ? pdTRUE : pdFALSE;
+
+		#if( ipconfigUSE_CALLBACKS == 1 )
+		{
+			/* An OnReceive handler gets the data straight from the network
+			buffer already, see lTCPAddRxdata(). */
+			if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xTCP.pxHandleReceive ) != pdFALSE )
+			{
+				xUseList = pdFALSE;
+			}
+		}
+		#endif /* ipconfigUSE_CALLBACKS */
+
+		if( ( xUseList != pdFALSE ) && ( pxSocket->u.xTCP.rxStream == NULL ) )
+		{
+			/* The first data of a connection: only create rxStream, its head
+			will be advanced over the queued data. */
+			( void ) lTCPAddRxdata( pxSocket, 0ul, NULL, 0ul );
+		}
+
+		/* The queued data must precede all data in rxStream, so only queue
+		when rxStream does not contain data that was copied. */
+		if( ( xUseList != pdFALSE ) &&
+			( pxSocket->u.xTCP.rxStream != NULL ) &&
+			( uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream ) == pxSocket->u.xTCP.uxRxQueuedBytes ) &&
+			( listCURRENT_LIST_LENGTH( &( pxSocket->u.xTCP.xRxBufferList ) ) < ( UBaseType_t ) ipconfigTCP_ZERO_COPY_RX_MAX_BUFFERS ) )
+		{
+			/* The reply will be built in a new buffer, which only needs a
+			copy of the headers (and a possible urgent data). */
+			uxHeaderLength = ( size_t ) ( pucRecvData - pxNetworkBuffer->pucEthernetBuffer );
+			uxNeeded = FreeRTOS_max_uint32( ( uint32_t ) sizeof( TCPPacket_t ), ( uint32_t ) uxHeaderLength );
+			pxReplyBuffer = pxGetNetworkBufferWithDescriptor( uxNeeded, 0u );
+
+			if( pxReplyBuffer != NULL )
+			{
+				memcpy( pxReplyBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, uxHeaderLength );
+				pxReplyBuffer->xDataLength = uxNeeded;
+
+				pxNetworkBuffer->usPayloadOffset = ( uint16_t ) uxHeaderLength;
+				pxNetworkBuffer->xDataLength = ( size_t ) ulReceiveLength;
+
+				/* The buffer is added to the list before the head of
+				rxStream is advanced.  FreeRTOS_recv() never reads more
+				than the size of rxStream from the list. */
+				vTaskSuspendAll();
+				{
+					vListInsertEnd( &( pxSocket->u.xTCP.xRxBufferList ), &( pxNetworkBuffer->xBufferListItem ) );
+					pxSocket->u.xTCP.uxRxQueuedBytes += ( size_t ) ulReceiveLength;
+				}
+				( void ) xTaskResumeAll();
+
+				*ppxNetworkBuffer = pxReplyBuffer;
+
+				/* Advance the head of rxStream without copying, and wake
+				up the user. */
+				( void ) lTCPAddRxdata( pxSocket, 0ul, NULL, ulReceiveLength );
+				xReturn = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+
+	static size_t prvTCPTxCopy( FreeRTOS_Socket_t *pxSocket, size_t uxOffset, uint8_t *pucTarget, size_t uxMaxCount )
+	{
+	size_t uxCount, uxDone, uxCopy;
+	uint32_t ulPosition, ulLast;
+	UBaseType_t uxIndex;
+	const UBaseType_t uxHead = ( UBaseType_t ) pxSocket->u.xTCP.ucTxRefHead;
+	const TCPTxReference_t *pxReference = NULL;
+
+		/* Find out how many bytes are available, without copying. */
+		uxCount = uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, NULL, uxMaxCount, pdTRUE );
+
+		/* The absolute position of the first byte, counted in the same way as
+		ulTxAdded. */
+		ulPosition = pxSocket->u.xTCP.ulTxAcked + ( uint32_t ) uxOffset;
+		uxIndex = ( UBaseType_t ) pxSocket->u.xTCP.ucTxRefTail;
+
+		for( uxDone = 0u; uxDone < uxCount; uxDone += uxCopy )
+		{
+			/* Skip the references that end before the current position.  The
+			references are stored in the order of their position. */
+			while( uxIndex != uxHead )
+			{
+				pxReference = &( pxSocket->u.xTCP.xTxReferences[ uxIndex ] );
+				ulLast = pxReference->ulFirst + ( uint32_t ) pxReference->uxLength;
+
+				if( ( int32_t ) ( ulLast - ulPosition ) > 0 )
+				{
+					break;
+				}
+
+				uxIndex = ( uxIndex + 1u ) % ( UBaseType_t ) ipTCP_TX_REFERENCE_SLOTS;
+			}
+
+			uxCopy = uxCount - uxDone;
+
+			if( uxIndex == uxHead )
+			{
+				/* No more references, the rest is stored in txStream. */
+				( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset + uxDone, pucTarget + uxDone, uxCopy, pdTRUE );
+			}
+			else if( ( int32_t ) ( ulPosition - pxReference->ulFirst ) >= 0 )
+			{
+				/* The current position lies within the reference. */
+				uxCopy = FreeRTOS_min_uint32( uxCopy, ( uint32_t ) ( ulLast - ulPosition ) );
+				memcpy( pucTarget + uxDone, pxReference->pucData + ( ulPosition - pxReference->ulFirst ), uxCopy );
+			}
+			else
+			{
+				/* Copy the bytes from txStream that precede the reference. */
+				uxCopy = FreeRTOS_min_uint32( uxCopy, ( uint32_t ) ( pxReference->ulFirst - ulPosition ) );
+				( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset + uxDone, pucTarget + uxDone, uxCopy, pdTRUE );
+			}
+
+			ulPosition += ( uint32_t ) uxCopy;
+		}
+
+		return uxCount;
+	}
+
+#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+
+	static void prvTCPTxReferencesAcked( FreeRTOS_Socket_t *pxSocket, size_t uxCount )
+	{
+	const TCPTxReference_t *pxReference;
+	UBaseType_t uxIndex = ( UBaseType_t ) pxSocket->u.xTCP.ucTxRefTail;
+
+		pxSocket->u.xTCP.ulTxAcked += ( uint32_t ) uxCount;
+
+		while( uxIndex != ( UBaseType_t ) pxSocket->u.xTCP.ucTxRefHead )
+		{
+			pxReference = &( pxSocket->u.xTCP.xTxReferences[ uxIndex ] );
+
+			if( ( int32_t ) ( pxSocket->u.xTCP.ulTxAcked - ( pxReference->ulFirst + ( uint32_t ) pxReference->uxLength ) ) < 0 )
+			{
+				/* This reference has not been acknowledged completely. */
+				break;
+			}
+
+			uxIndex = ( uxIndex + 1u ) % ( UBaseType_t ) ipTCP_TX_REFERENCE_SLOTS;
+		}
+
+		/* The slots before 'uxIndex' may now be used again by FreeRTOS_send(). */
+		pxSocket->u.xTCP.ucTxRefTail = ( uint8_t ) uxIndex;
+	}
+
+#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
+/*-----------------------------------------------------------*/
+
 /* Set the TCP options (if any) for the outgoing packet. */
 static UBaseType_t prvSetOptions( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
 {
@@ -2287,6 +3325,17 @@ UBaseType_t uxOptionsLength = pxTCPWindow->ucOptionLength;
 		pxTCPHeader->ucTCPOffset = ( uint8_t )( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
 	}
 
+	#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+	{
+		if( pxSocket->u.xTCP.bits.bTimeStamps != pdFALSE_UNSIGNED )
+		{
+			/* Once negotiated, the time-stamp option is sent in every packet. */
+			uxOptionsLength = prvTCPAddTimestampOption( pxSocket, pxTCPHeader, uxOptionsLength );
+			pxTCPHeader->ucTCPOffset = ( uint8_t )( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+		}
+	}
+	#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
 	return uxOptionsLength;
 }
 /*-----------------------------------------------------------*/
@@ -2355,6 +3404,15 @@ BaseType_t xSendLength = 0;
 		1. */
 		pxTCPWindow->ulOurSequenceNumber = pxTCPWindow->tx.ulFirstSequenceNumber + 1u;
 
+		#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+		{
+			if( ( pxSocket->u.xTCP.ucTCPState == eCONNECT_SYN ) && ( pxSocket->u.xTCP.bits.bFastOpen != pdFALSE_UNSIGNED ) )
+			{
+				prvTCPFastOpenSynAcked( pxSocket, FreeRTOS_ntohl( pxTCPHeader->ulAckNr ) );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
 		#if( ipconfigUSE_TCP_WIN == 1 )
 		{
 			FreeRTOS_debug_printf( ( "TCP: %s %d => %lxip:%d set ESTAB (scaling %u)\n",
@@ -2383,6 +3441,28 @@ BaseType_t xSendLength = 0;
 			}
 		}
 		#endif /* ipconfigUSE_TCP_WIN */
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+			pxTCPWindow->u.bits.bTimeStamps = pxSocket->u.xTCP.bits.bTimeStamps;
+
+			if( pxSocket->u.xTCP.bits.bTimeStamps != pdFALSE_UNSIGNED )
+			{
+				/* Every segment will carry a time-stamp option, leave room
+				for it within the MTU. */
+				pxSocket->u.xTCP.usCurMSS -= ( uint16_t ) TCP_OPT_TIMESTAMP_SPACE;
+				if( pxTCPWindow->usMSS > pxSocket->u.xTCP.usCurMSS )
+				{
+					pxTCPWindow->usMSS = pxSocket->u.xTCP.usCurMSS;
+				}
+			}
+		}
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+		#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+		{
+			/* The MSS is final now, it determines the initial window. */
+			vTCPWindowCongestionStart( pxTCPWindow );
+		}
+		#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
 		/* This was the third step of connecting: SYN, SYN+ACK, ACK	so now the
 		connection is established. */
 		vTCPStateChange( pxSocket, eESTABLISHED );
@@ -2424,6 +3504,21 @@ int32_t lDistance, lSendResult;
 	{
 		ulCount = ulTCPWindowTxAck( pxTCPWindow, FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr ) );
 
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+			/* RFC 7323 (4.1): an ACK that confirms new data gives an RTT
+			sample: the time elapsed since the echoed time-stamp was sent. */
+			if( ( ulCount > 0u ) &&
+				( pxTCPWindow->u.bits.bTimeStamps != pdFALSE_UNSIGNED ) &&
+				( pxSocket->u.xTCP.bits.bTSReceived != pdFALSE_UNSIGNED ) &&
+				( pxSocket->u.xTCP.ulTSEcho != 0u ) )
+			{
+				vTCPWindowRTTSample( pxTCPWindow,
+					( uint32_t ) ( ( TickType_t ) ( xTaskGetTickCount() - ( TickType_t ) pxSocket->u.xTCP.ulTSEcho ) ) * portTICK_PERIOD_MS );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
 		/* ulTCPWindowTxAck() returns the number of bytes which have been acked,
 		starting at 'tx.ulCurrentSequenceNumber'.  Advance the tail pointer in
 		txStream. */
@@ -2433,8 +3528,15 @@ int32_t lDistance, lSendResult;
 			confirmed, and because there is new space in the txStream, the
 			user/owner should be woken up. */
 			/* _HT_ : only in case the socket's waiting? */
-			if( uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0u, NULL, ( size_t ) ulCount, pdFALSE ) != 0u )
+			ulCount = ( uint32_t ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0u, NULL, ( size_t ) ulCount, pdFALSE );
+			if( ulCount != 0u )
 			{
+				#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+				{
+					prvTCPTxReferencesAcked( pxSocket, ( size_t ) ulCount );
+				}
+				#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
+
 				pxSocket->xEventBits |= eSOCKET_SEND;
 
 				#if ipconfigSUPPORT_SELECT_FUNCTION == 1
@@ -2538,8 +3640,8 @@ int32_t lDistance, lSendResult;
 		/* _HT_ patch: since the MTU has be fixed at 1500 in stead of 1526, TCP
 		can not	send-out both TCP options and also a full packet. Sending
 		options (SACK) is always more urgent than sending data, which can be
-		sent later. */
-		if( uxOptionsLength == 0u )
+		sent later.  A time-stamp option has been taken into account in MSS. */
+		if( uxOptionsLength == prvTCPTimestampLength( pxSocket ) )
 		{
 			/* prvTCPPrepareSend might allocate a bigger network buffer, if
 			necessary. */
@@ -2569,6 +3671,7 @@ TCPWindow_t *pxTCPWindow = &pxSocket->u.xTCP.xTCPWindow;
 /* Find out what window size we may advertised. */
 int32_t lRxSpace;
 #if( ipconfigUSE_TCP_WIN == 1 )
+	BaseType_t xAckNow = pdFALSE;
 	#if( ipconfigTCP_ACK_EARLIER_PACKET == 0 )
 		const int32_t lMinLength = 0;
 	#else
@@ -2588,12 +3691,38 @@ int32_t lRxSpace;
 		}
 		#endif /* ipconfigTCP_ACK_EARLIER_PACKET */
 
+		if( ulReceiveLength > 0u )
+		{
+			#if( ipconfigUSE_TCP_GRO != 0 )
+			if( xTCPSegmentFollows != pdFALSE )
+			{
+				/* The next packet in the chain continues this segment.  Leave
+				the ACK and the window update to that packet. */
+				iptraceTCP_ACK_COALESCED( pxSocket );
+			}
+			else
+			#endif /* ipconfigUSE_TCP_GRO */
+			if( pxSocket->u.xTCP.ucQuickAckCount > 0u )
+			{
+				/* In quick-ACK mode. */
+				pxSocket->u.xTCP.ucQuickAckCount--;
+				xAckNow = pdTRUE;
+			}
+			else if( ( ulReceiveLength >= ( uint32_t ) pxSocket->u.xTCP.usCurMSS ) &&
+				( ( ( UBaseType_t ) pxSocket->u.xTCP.ucUnackedSegments + 1u ) >= ( UBaseType_t ) ipconfigTCP_ACK_EVERY_N_SEGMENTS ) )
+			{
+				/* Acknowledge at least every second full-size segment. */
+				xAckNow = pdTRUE;
+			}
+		}
+
 		/* In case we're receiving data continuously, we might postpone sending
 		an ACK to gain performance. */
 		if( ( ulReceiveLength > 0 ) &&							/* Data was sent to this socket. */
+			( xAckNow == pdFALSE ) &&							/* No quick-ACK, not the second full-size segment. */
 			( lRxSpace >= lMinLength ) &&						/* There is Rx space for more data. */
 			( pxSocket->u.xTCP.bits.bFinSent == pdFALSE_UNSIGNED ) &&	/* Not in a closure phase. */
-			( xSendLength == ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER ) ) && /* No Tx data or options to be sent. */
+			( xSendLength == ( BaseType_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + prvTCPTimestampLength( pxSocket ) ) ) && /* No Tx data or options to be sent, except a time-stamp. */
 			( pxSocket->u.xTCP.ucTCPState == eESTABLISHED ) &&	/* Connection established. */
 			( pxTCPHeader->ucTCPFlags == ipTCP_FLAG_ACK ) )		/* There are no other flags than an ACK. */
 		{
@@ -2607,6 +3736,12 @@ int32_t lRxSpace;
 
 				pxSocket->u.xTCP.pxAckMessage = *ppxNetworkBuffer;
 			}
+
+			if( ulReceiveLength >= ( uint32_t ) pxSocket->u.xTCP.usCurMSS )
+			{
+				pxSocket->u.xTCP.ucUnackedSegments++;
+			}
+
 			if( ( ulReceiveLength < ( uint32_t ) pxSocket->u.xTCP.usCurMSS ) ||	/* Received a small message. */
 				( lRxSpace < ( int32_t ) ( 2U * pxSocket->u.xTCP.usCurMSS ) ) )	/* There are less than 2 x MSS space in the Rx buffer. */
 			{
@@ -2739,12 +3874,20 @@ TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
 	}
 
 	/* Storing data may result in a fatal error if malloc() fails. */
-	if( prvStoreRxData( pxSocket, pucRecvData, *ppxNetworkBuffer, ulReceiveLength ) < 0 )
+	if( prvStoreRxData( pxSocket, pucRecvData, ppxNetworkBuffer, ulReceiveLength ) < 0 )
 	{
 		xSendLength = -1;
 	}
 	else
 	{
+		#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+		{
+			/* prvStoreRxData() may have replaced the network buffer. */
+			pxTCPPacket = ( TCPPacket_t * ) ( ( *ppxNetworkBuffer )->pucEthernetBuffer );
+			pxTCPHeader = &( pxTCPPacket->xTCPHeader );
+		}
+		#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
+
 		uxOptionsLength = prvSetOptions( pxSocket, *ppxNetworkBuffer );
 
 		if( ( pxSocket->u.xTCP.ucTCPState == eSYN_RECEIVED ) && ( ( ucTCPFlags & ipTCP_FLAG_CTRL ) == ipTCP_FLAG_SYN ) )
@@ -2963,6 +4106,14 @@ configASSERT(pxNetworkBuffer->pucEthernetBuffer);
         ulSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
         ulAckNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr );
 
+		#if( ipconfigUSE_TCP_GRO != 0 )
+		{
+			/* See if the next packet in the chain continues this segment, so
+			that one ACK can be sent for both. */
+			xTCPSegmentFollows = prvTCPSegmentFollows( pxNetworkBuffer, pxTCPNextRxBuffer );
+		}
+		#endif /* ipconfigUSE_TCP_GRO */
+
 		/* Find the destination socket, and if not found: return a socket listing to
 		the destination PORT. */
 		pxSocket = ( FreeRTOS_Socket_t * )pxTCPSocketLookup( ulLocalIP, xLocalPort, ulRemoteIP, xRemotePort );
@@ -3006,28 +4157,63 @@ configASSERT(pxNetworkBuffer->pucEthernetBuffer);
 			has set the SYN flag. */
 			if( ( ucTCPFlags & ipTCP_FLAG_CTRL ) != ipTCP_FLAG_SYN )
 			{
-				/* What happens: maybe after a reboot, a client doesn't know the
-				connection had gone.  Send a RST in order to get a new connect
-				request. */
-				#if( ipconfigHAS_DEBUG_PRINTF == 1 )
+				#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+				{
+					/* This might be the ACK that completes a handshake that
+					was answered from the SYN cache.  If so, the new socket
+					will handle it. */
+					if( ( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED ) &&
+						( ( ucTCPFlags & ( ipTCP_FLAG_CTRL & ~ipTCP_FLAG_PSH ) ) == ipTCP_FLAG_ACK ) )
+					{
+						pxSocket = prvSynCacheHandleAck( pxSocket, pxNetworkBuffer );
+					}
+					else
+					{
+						pxSocket = NULL;
+					}
+				}
+				#else
 				{
-				FreeRTOS_debug_printf( ( "TCP: Server can't handle flags: %s from %lxip:%u to port %u\n",
-					prvTCPFlagMeaning( ( UBaseType_t ) ucTCPFlags ), ulRemoteIP, xRemotePort, xLocalPort ) );
+					pxSocket = NULL;
 				}
-				#endif /* ipconfigHAS_DEBUG_PRINTF */
+				#endif /* ipconfigTCP_SYN_CACHE_SIZE */
 
-				if( ( ucTCPFlags & ipTCP_FLAG_RST ) == 0u )
+				if( pxSocket == NULL )
 				{
-					prvTCPSendReset( pxNetworkBuffer );
+					/* What happens: maybe after a reboot, a client doesn't know the
+					connection had gone.  Send a RST in order to get a new connect
+					request. */
+					#if( ipconfigHAS_DEBUG_PRINTF == 1 )
+					{
+					FreeRTOS_debug_printf( ( "TCP: Server can't handle flags: %s from %lxip:%u to port %u\n",
+						prvTCPFlagMeaning( ( UBaseType_t ) ucTCPFlags ), ulRemoteIP, xRemotePort, xLocalPort ) );
+					}
+					#endif /* ipconfigHAS_DEBUG_PRINTF */
+
+					if( ( ucTCPFlags & ipTCP_FLAG_RST ) == 0u )
+					{
+						prvTCPSendReset( pxNetworkBuffer );
+					}
+					xResult = pdFAIL;
 				}
-				xResult = pdFAIL;
 			}
 			else
 			{
-				/* prvHandleListen() will either return a newly created socket
-				(if bReuseSocket is false), otherwise it returns the current
-				socket which will later get connected. */
-				pxSocket = prvHandleListen( pxSocket, pxNetworkBuffer );
+				#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+				if( pxSocket->u.xTCP.bits.bReuseSocket == pdFALSE_UNSIGNED )
+				{
+					/* Answer the SYN without creating a socket yet. */
+					prvSynCacheHandleSyn( pxSocket, pxNetworkBuffer );
+					pxSocket = NULL;
+				}
+				else
+				#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+				{
+					/* prvHandleListen() will either return a newly created socket
+					(if bReuseSocket is false), otherwise it returns the current
+					socket which will later get connected. */
+					pxSocket = prvHandleListen( pxSocket, pxNetworkBuffer );
+				}
 
 				if( pxSocket == NULL )
 				{
@@ -3052,6 +4238,14 @@ configASSERT(pxNetworkBuffer->pucEthernetBuffer);
                     {
                         vTCPStateChange( pxSocket, eCLOSED );
                     }
+                    #if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+                    /* The RST may also acknowledge the data sent along with the SYN. */
+                    else if( ( pxSocket->u.xTCP.ulFastOpenSent != 0u ) &&
+                             ( ulAckNumber == pxSocket->u.xTCP.xTCPWindow.ulOurSequenceNumber + 1 + pxSocket->u.xTCP.ulFastOpenSent ) )
+                    {
+                        vTCPStateChange( pxSocket, eCLOSED );
+                    }
+                    #endif /* ipconfigUSE_TCP_FAST_OPEN */
                 }
                 else
                 {
@@ -3102,6 +4296,12 @@ configASSERT(pxNetworkBuffer->pucEthernetBuffer);
 		/* _HT_ : if we're in the SYN phase, and peer does not send a MSS option,
 		then we MUST assume an MSS size of 536 bytes for backward compatibility. */
 
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+			pxSocket->u.xTCP.bits.bTSReceived = pdFALSE_UNSIGNED;
+		}
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
 		/* When there are no TCP options, the TCP offset equals 20 bytes, which is stored as
 		the number 5 (words) in the higher niblle of the TCP-offset byte. */
 		if( ( pxTCPPacket->xTCPHeader.ucTCPOffset & TCP_OFFSET_LENGTH_BITS ) > TCP_OFFSET_STANDARD_LENGTH )
@@ -3109,15 +4309,48 @@ configASSERT(pxNetworkBuffer->pucEthernetBuffer);
 			prvCheckOptions( pxSocket, pxNetworkBuffer );
 		}
 
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+			prvTCPCheckTimestamp( pxSocket, ucTCPFlags, ulSequenceNumber );
+		}
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
+		#if( ipconfigUSE_PERFORMANCE_COUNTERS != 0 )
+		{
+			ipCOUNT_SOCKET_EVENT( pxSocket, ulRxPackets, 1 );
+
+			/* Count the moments that the peer closes its window, not the
+			replies to every window probe. */
+			if( ( pxTCPPacket->xTCPHeader.usWindow == 0u ) &&
+				( pxSocket->u.xTCP.ulWindowSize != 0u ) &&
+				( ( ucTCPFlags & ( ipTCP_FLAG_SYN | ipTCP_FLAG_RST ) ) == 0u ) )
+			{
+				ipCOUNT_SOCKET_EVENT( pxSocket, ulZeroWindowEvents, 1 );
+			}
+		}
+		#endif /* ipconfigUSE_PERFORMANCE_COUNTERS */
 
 		#if( ipconfigUSE_TCP_WIN == 1 )
 		{
 			pxSocket->u.xTCP.ulWindowSize = FreeRTOS_ntohs( pxTCPPacket->xTCPHeader.usWindow );
-			pxSocket->u.xTCP.ulWindowSize =
-				( pxSocket->u.xTCP.ulWindowSize << pxSocket->u.xTCP.ucPeerWinScaleFactor );
+
+			/* RFC 7323: the window field of a SYN or SYN+ACK is not scaled. */
+			if( ( ucTCPFlags & ipTCP_FLAG_SYN ) == 0u )
+			{
+				pxSocket->u.xTCP.ulWindowSize =
+					( pxSocket->u.xTCP.ulWindowSize << pxSocket->u.xTCP.ucPeerWinScaleFactor );
+			}
 		}
 		#endif
 
+		#if( ipconfigUSE_TCP_GRO != 0 )
+		{
+			/* When the next segment of this burst follows, lTCPAddRxdata()
+			will leave the data in rxStream for that segment to deliver. */
+			pxSocket->u.xTCP.bits.bRxDeferred = ( xTCPSegmentFollows != pdFALSE ) ? pdTRUE_UNSIGNED : pdFALSE_UNSIGNED;
+		}
+		#endif /* ipconfigUSE_TCP_GRO */
+
 		/* In prvTCPHandleState() the incoming messages will be handled
 		depending on the current state of the connection. */
 		if( prvTCPHandleState( pxSocket, &pxNetworkBuffer ) > 0 )
@@ -3140,17 +4373,134 @@ configASSERT(pxNetworkBuffer->pucEthernetBuffer);
 			pxNetworkBuffer = NULL;
 		}
 
+		#if( ipconfigUSE_TCP_GRO != 0 )
+		{
+			if( xTCPSegmentFollows != pdFALSE )
+			{
+				pxTCPDeferredSocket = pxSocket;
+				pxTCPDeferredFollower = pxTCPNextRxBuffer;
+			}
+			else
+			{
+				/* The last segment of a burst, or a segment whose data could
+				not be stored. */
+				prvTCPDeliverDeferred( pxSocket );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_GRO */
+
 		/* And finally, calculate when this socket wants to be woken up. */
 		prvTCPNextTimeout ( pxSocket );
 		/* Return pdPASS to tell that the network buffer is 'consumed'. */
 		xResult = pdPASS;
 	}
 
+	#if( ipconfigUSE_TCP_GRO != 0 )
+	{
+		xTCPSegmentFollows = pdFALSE;
+	}
+	#endif /* ipconfigUSE_TCP_GRO */
+
 	/* pdPASS being returned means the buffer has been consumed. */
 	return xResult;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_GRO != 0 )
+
+	void vTCPSetNextReceivedBuffer( const NetworkBufferDescriptor_t *pxNextBuffer )
+	{
+		/* The packet that was expected to deliver the data that a socket held
+		back has been processed, or the chain has ended, without reaching the
+		socket, e.g. because the IP layer dropped it.  Sockets are only
+		deleted from the TCP timer, so the socket still exists. */
+		if( ( pxTCPDeferredSocket != NULL ) && ( pxTCPDeferredFollower != pxTCPNextRxBuffer ) )
+		{
+			prvTCPDeliverDeferred( pxTCPDeferredSocket );
+		}
+
+		pxTCPNextRxBuffer = pxNextBuffer;
+	}
+
+#endif /* ipconfigUSE_TCP_GRO */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_GRO != 0 )
+
+	static void prvTCPDeliverDeferred( FreeRTOS_Socket_t *pxSocket )
+	{
+		pxSocket->u.xTCP.bits.bRxDeferred = pdFALSE_UNSIGNED;
+
+		if( pxTCPDeferredSocket == pxSocket )
+		{
+			pxTCPDeferredSocket = NULL;
+		}
+
+		#if( ipconfigUSE_CALLBACKS == 1 )
+		{
+			/* A socket with an OnReceive handler keeps rxStream empty, except
+			for data that was held back. */
+			if( ( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xTCP.pxHandleReceive ) ) &&
+				( pxSocket->u.xTCP.rxStream != NULL ) &&
+				( uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream ) != 0u ) )
+			{
+				( void ) lTCPAddRxdata( pxSocket, 0u, NULL, 0u );
+			}
+		}
+		#endif /* ipconfigUSE_CALLBACKS */
+	}
+
+#endif /* ipconfigUSE_TCP_GRO */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_GRO != 0 )
+
+	static BaseType_t prvTCPSegmentFollows( const NetworkBufferDescriptor_t *pxNetworkBuffer, const NetworkBufferDescriptor_t *pxNextBuffer )
+	{
+	const TCPPacket_t *pxTCPPacket = ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+	const TCPPacket_t *pxNextPacket;
+	const uint8_t ucFlagMask = ( uint8_t ) ( ipTCP_FLAG_CTRL & ~ipTCP_FLAG_PSH );
+	uint32_t ulHeaderLength, ulPayloadLength;
+	BaseType_t xReturn = pdFALSE;
+
+		if( ( pxNextBuffer != NULL ) &&
+			( pxNextBuffer->xDataLength >= ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER ) ) )
+		{
+			/* The next packet has not been checked by the IP layer yet.  When
+			it gets dropped later on, the delayed ACK timer will still make
+			sure that this segment gets acknowledged.  The fields are compared
+			in network byte order. */
+			pxNextPacket = ( const TCPPacket_t * ) pxNextBuffer->pucEthernetBuffer;
+
+			if( ( pxNextPacket->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE ) &&
+				( pxNextPacket->xIPHeader.ucVersionHeaderLength == 0x45u ) &&
+				( pxNextPacket->xIPHeader.ucProtocol == ( uint8_t ) ipPROTOCOL_TCP ) &&
+				( pxNextPacket->xIPHeader.ulSourceIPAddress == pxTCPPacket->xIPHeader.ulSourceIPAddress ) &&
+				( pxNextPacket->xIPHeader.ulDestinationIPAddress == pxTCPPacket->xIPHeader.ulDestinationIPAddress ) &&
+				( pxNextPacket->xTCPHeader.usSourcePort == pxTCPPacket->xTCPHeader.usSourcePort ) &&
+				( pxNextPacket->xTCPHeader.usDestinationPort == pxTCPPacket->xTCPHeader.usDestinationPort ) &&
+				( ( pxTCPPacket->xTCPHeader.ucTCPFlags & ucFlagMask ) == ( uint8_t ) ipTCP_FLAG_ACK ) &&
+				( ( pxNextPacket->xTCPHeader.ucTCPFlags & ucFlagMask ) == ( uint8_t ) ipTCP_FLAG_ACK ) )
+			{
+				ulHeaderLength = ( uint32_t ) ipSIZE_OF_IPv4_HEADER +
+					( ( ( uint32_t ) pxTCPPacket->xTCPHeader.ucTCPOffset & TCP_OFFSET_LENGTH_BITS ) >> 2 );
+				ulPayloadLength = ( uint32_t ) FreeRTOS_ntohs( pxTCPPacket->xIPHeader.usLength );
+
+				if( ( ulPayloadLength > ulHeaderLength ) &&
+					( FreeRTOS_ntohl( pxNextPacket->xTCPHeader.ulSequenceNumber ) ==
+					  ( FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber ) + ( ulPayloadLength - ulHeaderLength ) ) ) )
+				{
+					xReturn = pdTRUE;
+				}
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_GRO */
+/*-----------------------------------------------------------*/
+
 static FreeRTOS_Socket_t *prvHandleListen( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
 {
 TCPPacket_t * pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
@@ -3215,42 +4565,933 @@ uint32_t ulInitialSequenceNumber;
 
 	if( ( 0 != ulInitialSequenceNumber ) && ( pxReturn != NULL ) )
 	{
-		pxReturn->u.xTCP.usRemotePort = FreeRTOS_htons( pxTCPPacket->xTCPHeader.usSourcePort );
-		pxReturn->u.xTCP.ulRemoteIP = FreeRTOS_htonl( pxTCPPacket->xIPHeader.ulSourceIPAddress );
-		pxReturn->u.xTCP.xTCPWindow.ulOurSequenceNumber = ulInitialSequenceNumber;
+		prvTCPStartPassiveOpen( pxReturn, pxNetworkBuffer, ulInitialSequenceNumber );
+	}
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTCPStartPassiveOpen( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, uint32_t ulInitialSequenceNumber )
+{
+TCPPacket_t * pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
 
-		/* Here is the SYN action. */
-		pxReturn->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
-		prvSocketSetMSS( pxReturn );
+	pxSocket->u.xTCP.usRemotePort = FreeRTOS_htons( pxTCPPacket->xTCPHeader.usSourcePort );
+	pxSocket->u.xTCP.ulRemoteIP = FreeRTOS_htonl( pxTCPPacket->xIPHeader.ulSourceIPAddress );
+	pxSocket->u.xTCP.xTCPWindow.ulOurSequenceNumber = ulInitialSequenceNumber;
 
-		prvTCPCreateWindow( pxReturn );
+	/* Here is the SYN action. */
+	pxSocket->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+	prvSocketSetMSS( pxSocket );
 
-		vTCPStateChange( pxReturn, eSYN_FIRST );
+	prvTCPCreateWindow( pxSocket );
 
-		/* Make a copy of the header up to the TCP header.  It is needed later
-		on, whenever data must be sent to the peer. */
-		memcpy( pxReturn->u.xTCP.xPacket.u.ucLastPacket, pxNetworkBuffer->pucEthernetBuffer, sizeof( pxReturn->u.xTCP.xPacket.u.ucLastPacket ) );
-	}
-	return pxReturn;
+	vTCPStateChange( pxSocket, eSYN_FIRST );
+
+	/* Make a copy of the header up to the TCP header.  It is needed later
+	on, whenever data must be sent to the peer. */
+	memcpy( pxSocket->u.xTCP.xPacket.u.ucLastPacket, pxNetworkBuffer->pucEthernetBuffer, sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket ) );
 }
 /*-----------------------------------------------------------*/
 
-/*
- * Duplicates a socket after a listening socket receives a connection.
- */
-static BaseType_t prvTCPSocketCopy( FreeRTOS_Socket_t *pxNewSocket, FreeRTOS_Socket_t *pxSocket )
-{
-struct freertos_sockaddr xAddress;
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
 
-	pxNewSocket->xReceiveBlockTime = pxSocket->xReceiveBlockTime;
-	pxNewSocket->xSendBlockTime = pxSocket->xSendBlockTime;
-	pxNewSocket->ucSocketOptions = pxSocket->ucSocketOptions;
-	pxNewSocket->u.xTCP.uxRxStreamSize = pxSocket->u.xTCP.uxRxStreamSize;
-	pxNewSocket->u.xTCP.uxTxStreamSize = pxSocket->u.xTCP.uxTxStreamSize;
-	pxNewSocket->u.xTCP.uxLittleSpace = pxSocket->u.xTCP.uxLittleSpace;
-	pxNewSocket->u.xTCP.uxEnoughSpace = pxSocket->u.xTCP.uxEnoughSpace;
-	pxNewSocket->u.xTCP.uxRxWinSize  = pxSocket->u.xTCP.uxRxWinSize;
-	pxNewSocket->u.xTCP.uxTxWinSize  = pxSocket->u.xTCP.uxTxWinSize;
+	static void prvSynCacheHandleSyn( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	TCPPacket_t * pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+	SynCacheEntry_t *pxEntry;
+	SynOptions_t xOptions;
+	uint32_t ulPeerSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+	uint32_t ulOurSequenceNumber = 0u;
+	uint16_t usMSS = ( uint16_t ) ipconfigTCP_MSS;
+	uint8_t ucMyWinScaleFactor = 0u;
+	size_t uxLength;
+
+		if( prvSynCacheBacklogFull( pxSocket ) != pdFALSE )
+		{
+			prvTCPSendReset( pxNetworkBuffer );
+		}
+		else
+		{
+			prvSynCacheParseOptions( pxNetworkBuffer, &xOptions );
+
+			/* Use the same MSS as prvSocketSetMSS() will give to the new
+			socket, or the MSS of the peer if that is smaller. */
+			if( ( ( pxTCPPacket->xIPHeader.ulSourceIPAddress ^ *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) != 0ul )
+			{
+				usMSS = ( uint16_t ) FreeRTOS_min_uint32( ( uint32_t ) REDUCED_MSS_THROUGH_INTERNET, ( uint32_t ) usMSS );
+			}
+
+			if( ( xOptions.usMSS != 0u ) && ( xOptions.usMSS < usMSS ) )
+			{
+				usMSS = xOptions.usMSS;
+			}
+
+			#if( ipconfigUSE_TCP_WIN != 0 )
+			{
+				if( xOptions.xWinScale != pdFALSE )
+				{
+				size_t uxWinSize = pxSocket->u.xTCP.uxRxWinSize * ( size_t ) usMSS;
+
+					/* The same calculation as in prvWinScaleFactor(). */
+					while( ( uxWinSize > 0xfffful ) && ( ucMyWinScaleFactor < TCP_WSOPT_MAX_SHIFT ) )
+					{
+						uxWinSize >>= 1;
+						ucMyWinScaleFactor++;
+					}
+				}
+			}
+			#endif /* ipconfigUSE_TCP_WIN */
+
+			pxEntry = prvSynCacheLookup( pxTCPPacket );
+
+			if( ( pxEntry != NULL ) &&
+				( ulPeerSequenceNumber == FreeRTOS_ntohl( ( ( TCPPacket_t * ) pxEntry->xSyn.u.ucPacket )->xTCPHeader.ulSequenceNumber ) ) )
+			{
+				/* The SYN was retransmitted, probably because the SYN+ACK got
+				lost.  Send the same SYN+ACK again. */
+				ulOurSequenceNumber = pxEntry->ulOurSequenceNumber;
+			}
+			else
+			{
+				if( pxEntry == NULL )
+				{
+					pxEntry = prvSynCacheGetEntry();
+				}
+
+				if( pxEntry != NULL )
+				{
+					pxEntry->usLength = 0u;
+					ulOurSequenceNumber = ulApplicationGetNextSequenceNumber( *ipLOCAL_IP_ADDRESS_POINTER,
+																			  pxSocket->usLocalPort,
+																			  pxTCPPacket->xIPHeader.ulSourceIPAddress,
+																			  pxTCPPacket->xTCPHeader.usSourcePort );
+					if( ulOurSequenceNumber != 0u )
+					{
+						/* Store the SYN up to and including the TCP options. */
+						uxLength = ( size_t ) ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER ) +
+							( ( ( size_t ) pxTCPPacket->xTCPHeader.ucTCPOffset & TCP_OFFSET_LENGTH_BITS ) >> 2 );
+						uxLength = FreeRTOS_min_uint32( ( uint32_t ) uxLength, ( uint32_t ) pxNetworkBuffer->xDataLength );
+
+						memcpy( pxEntry->xSyn.u.ucPacket, pxNetworkBuffer->pucEthernetBuffer, uxLength );
+						pxEntry->usLength = ( uint16_t ) uxLength;
+						pxEntry->xTimeReceived = xTaskGetTickCount();
+						pxEntry->ulOurSequenceNumber = ulOurSequenceNumber;
+						pxEntry->ucMyWinScaleFactor = ucMyWinScaleFactor;
+					}
+				}
+				#if( ipconfigTCP_SYN_COOKIES != 0 )
+				else
+				{
+					/* The SYN cache is full.  Encode the connection in the
+					sequence number.  A cookie can only hold the MSS, the other
+					options will not be used. */
+					ulOurSequenceNumber = prvSynCookieCreate( pxTCPPacket, &usMSS );
+					ucMyWinScaleFactor = 0u;
+					xOptions.xWinScale = pdFALSE;
+					xOptions.xTimeStamps = pdFALSE;
+				}
+				#endif /* ipconfigTCP_SYN_COOKIES */
+			}
+
+			if( ulOurSequenceNumber != 0u )
+			{
+				prvSynCacheSendSynAck( pxSocket, pxNetworkBuffer, ulOurSequenceNumber, usMSS, ucMyWinScaleFactor, &xOptions );
+			}
+		}
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+
+	static FreeRTOS_Socket_t *prvSynCacheHandleAck( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	TCPPacket_t * pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+	uint32_t ulSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+	uint32_t ulAckNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr );
+	FreeRTOS_Socket_t *pxReturn = NULL;
+	NetworkBufferDescriptor_t xSynBuffer;
+	SynCacheEntry_t *pxEntry;
+	TCPPacket_t *pxSynPacket;
+	const BaseType_t lOffset = ( BaseType_t ) ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER );
+	#if( ipconfigTCP_SYN_COOKIES != 0 )
+		SynPacket_t xCookieSyn;
+		uint16_t usMSS;
+	#endif
+
+		memset( &xSynBuffer, '\0', sizeof( xSynBuffer ) );
+		pxEntry = prvSynCacheLookup( pxTCPPacket );
+
+		if( pxEntry != NULL )
+		{
+			pxSynPacket = ( TCPPacket_t * ) pxEntry->xSyn.u.ucPacket;
+
+			if( ( ulAckNumber == pxEntry->ulOurSequenceNumber + 1u ) &&
+				( ulSequenceNumber == FreeRTOS_ntohl( pxSynPacket->xTCPHeader.ulSequenceNumber ) + 1u ) )
+			{
+				xSynBuffer.pucEthernetBuffer = pxEntry->xSyn.u.ucPacket;
+				xSynBuffer.xDataLength = ( size_t ) pxEntry->usLength;
+				pxReturn = prvSynCacheCreateSocket( pxSocket, &xSynBuffer, pxEntry->ulOurSequenceNumber, pxEntry->ucMyWinScaleFactor );
+
+				/* The entry has been used, successfully or not. */
+				pxEntry->usLength = 0u;
+			}
+		}
+		#if( ipconfigTCP_SYN_COOKIES != 0 )
+		else if( prvSynCookieCheck( pxTCPPacket, &usMSS ) != pdFALSE )
+		{
+			/* Build the SYN that was answered with this cookie, with the MSS
+			option as the only option. */
+			pxSynPacket = ( TCPPacket_t * ) xCookieSyn.u.ucPacket;
+			memcpy( pxSynPacket, pxTCPPacket, ( size_t ) ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER ) );
+			pxSynPacket->xIPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + TCP_OPT_MSS_LEN );
+			pxSynPacket->xTCPHeader.ucTCPFlags = ( uint8_t ) ipTCP_FLAG_SYN;
+			pxSynPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulSequenceNumber - 1u );
+			pxSynPacket->xTCPHeader.ulAckNr = 0u;
+			pxSynPacket->xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + TCP_OPT_MSS_LEN ) << 2 );
+			pxSynPacket->xTCPHeader.ucOptdata[ 0 ] = ( uint8_t ) TCP_OPT_MSS;
+			pxSynPacket->xTCPHeader.ucOptdata[ 1 ] = ( uint8_t ) TCP_OPT_MSS_LEN;
+			pxSynPacket->xTCPHeader.ucOptdata[ 2 ] = ( uint8_t ) ( usMSS >> 8 );
+			pxSynPacket->xTCPHeader.ucOptdata[ 3 ] = ( uint8_t ) ( usMSS & 0xffu );
+
+			xSynBuffer.pucEthernetBuffer = xCookieSyn.u.ucPacket;
+			xSynBuffer.xDataLength = ( size_t ) ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + TCP_OPT_MSS_LEN );
+			pxReturn = prvSynCacheCreateSocket( pxSocket, &xSynBuffer, ulAckNumber - 1u, 0u );
+		}
+		#endif /* ipconfigTCP_SYN_COOKIES */
+		else
+		{
+			/* Not a known connection. */
+		}
+
+		if( pxReturn != NULL )
+		{
+			/* Update the copy of the TCP header, as for any other packet
+			received by a connected socket. */
+			memcpy( pxReturn->u.xTCP.xPacket.u.ucLastPacket + lOffset, pxNetworkBuffer->pucEthernetBuffer + lOffset, ipSIZE_OF_TCP_HEADER );
+		}
+
+		return pxReturn;
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+
+	static FreeRTOS_Socket_t *prvSynCacheCreateSocket( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxSynBuffer,
+		uint32_t ulOurSequenceNumber, uint8_t ucMyWinScaleFactor )
+	{
+	TCPPacket_t *pxSynPacket = ( TCPPacket_t * ) ( pxSynBuffer->pucEthernetBuffer );
+	FreeRTOS_Socket_t *pxNewSocket = NULL;
+	TCPWindow_t *pxTCPWindow;
+
+		if( prvSynCacheBacklogFull( pxSocket ) == pdFALSE )
+		{
+			pxNewSocket = ( FreeRTOS_Socket_t * ) FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+			if( ( pxNewSocket == NULL ) || ( pxNewSocket == FREERTOS_INVALID_SOCKET ) )
+			{
+				FreeRTOS_debug_printf( ( "TCP: SYN cache: new socket failed\n" ) );
+				pxNewSocket = NULL;
+			}
+			else if( prvTCPSocketCopy( pxNewSocket, pxSocket ) == pdFALSE )
+			{
+				/* The new socket has been closed already. */
+				pxNewSocket = NULL;
+			}
+			else
+			{
+				/* Let the new socket handle the SYN as if it had received it
+				just now. */
+				prvTCPStartPassiveOpen( pxNewSocket, pxSynBuffer, ulOurSequenceNumber );
+
+				#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+				{
+					pxNewSocket->u.xTCP.bits.bTSReceived = pdFALSE_UNSIGNED;
+				}
+				#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
+				if( ( pxSynPacket->xTCPHeader.ucTCPOffset & TCP_OFFSET_LENGTH_BITS ) > TCP_OFFSET_STANDARD_LENGTH )
+				{
+					prvCheckOptions( pxNewSocket, pxSynBuffer );
+				}
+
+				#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+				{
+					prvTCPCheckTimestamp( pxNewSocket, ( uint16_t ) ipTCP_FLAG_SYN, FreeRTOS_ntohl( pxSynPacket->xTCPHeader.ulSequenceNumber ) );
+				}
+				#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
+				/* Do what the state eSYN_FIRST does in prvTCPHandleState(),
+				except for sending the SYN+ACK, which has been sent already.
+				The options are written to the copy of the SYN, which is not
+				used anymore. */
+				( void ) prvSetSynAckOptions( pxNewSocket, pxSynPacket );
+
+				#if( ipconfigUSE_TCP_WIN != 0 )
+				{
+					pxNewSocket->u.xTCP.ucMyWinScaleFactor = ucMyWinScaleFactor;
+				}
+				#else
+				{
+					( void ) ucMyWinScaleFactor;
+				}
+				#endif /* ipconfigUSE_TCP_WIN */
+
+				vTCPStateChange( pxNewSocket, eSYN_RECEIVED );
+
+				pxTCPWindow = &( pxNewSocket->u.xTCP.xTCPWindow );
+				pxTCPWindow->rx.ulCurrentSequenceNumber = pxTCPWindow->rx.ulHighestSequenceNumber = FreeRTOS_ntohl( pxSynPacket->xTCPHeader.ulSequenceNumber ) + 1u;
+				pxTCPWindow->tx.ulCurrentSequenceNumber = pxTCPWindow->ulNextTxSequenceNumber = pxTCPWindow->tx.ulFirstSequenceNumber + 1u;
+			}
+		}
+
+		return pxNewSocket;
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+
+	static BaseType_t prvSynCacheBacklogFull( const FreeRTOS_Socket_t *pxSocket )
+	{
+	BaseType_t xReturn = pdFALSE;
+
+		if( pxSocket->u.xTCP.usChildCount >= pxSocket->u.xTCP.usBacklog )
+		{
+			FreeRTOS_printf( ( "Check: Socket %u already has %u / %u child%s\n",
+				pxSocket->usLocalPort,
+				pxSocket->u.xTCP.usChildCount,
+				pxSocket->u.xTCP.usBacklog,
+				pxSocket->u.xTCP.usChildCount == 1 ? "" : "ren" ) );
+			xReturn = pdTRUE;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+
+	static SynCacheEntry_t *prvSynCacheLookup( const TCPPacket_t *pxTCPPacket )
+	{
+	SynCacheEntry_t *pxReturn = NULL;
+	const TCPPacket_t *pxSynPacket;
+	TickType_t xNow = xTaskGetTickCount();
+	BaseType_t xIndex;
+
+		/* The addresses and port numbers are compared in network byte
+		order. */
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigTCP_SYN_CACHE_SIZE; xIndex++ )
+		{
+			if( ( xSynCache[ xIndex ].usLength != 0u ) && ( prvSynCacheEntryExpired( &( xSynCache[ xIndex ] ), xNow ) != pdFALSE ) )
+			{
+				/* The peer never sent the ACK.  A late ACK must not create
+				a socket, it will get a RST. */
+				xSynCache[ xIndex ].usLength = 0u;
+			}
+
+			if( xSynCache[ xIndex ].usLength != 0u )
+			{
+				pxSynPacket = ( const TCPPacket_t * ) xSynCache[ xIndex ].xSyn.u.ucPacket;
+
+				if( ( pxSynPacket->xIPHeader.ulSourceIPAddress == pxTCPPacket->xIPHeader.ulSourceIPAddress ) &&
+					( pxSynPacket->xTCPHeader.usSourcePort == pxTCPPacket->xTCPHeader.usSourcePort ) &&
+					( pxSynPacket->xTCPHeader.usDestinationPort == pxTCPPacket->xTCPHeader.usDestinationPort ) )
+				{
+					pxReturn = &( xSynCache[ xIndex ] );
+					break;
+				}
+			}
+		}
+
+		return pxReturn;
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+
+	static SynCacheEntry_t *prvSynCacheGetEntry( void )
+	{
+	SynCacheEntry_t *pxReturn = NULL;
+	SynCacheEntry_t *pxOldest = NULL;
+	TickType_t xNow = xTaskGetTickCount();
+	TickType_t xAge, xOldestAge = 0u;
+	BaseType_t xIndex;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigTCP_SYN_CACHE_SIZE; xIndex++ )
+		{
+			xAge = xNow - xSynCache[ xIndex ].xTimeReceived;
+
+			if( ( xSynCache[ xIndex ].usLength == 0u ) || ( prvSynCacheEntryExpired( &( xSynCache[ xIndex ] ), xNow ) != pdFALSE ) )
+			{
+				pxReturn = &( xSynCache[ xIndex ] );
+				break;
+			}
+
+			if( ( pxOldest == NULL ) || ( xAge > xOldestAge ) )
+			{
+				pxOldest = &( xSynCache[ xIndex ] );
+				xOldestAge = xAge;
+			}
+		}
+
+		#if( ipconfigTCP_SYN_COOKIES == 0 )
+		{
+			if( pxReturn == NULL )
+			{
+				FreeRTOS_debug_printf( ( "TCP: SYN cache full, replace the oldest entry\n" ) );
+				pxReturn = pxOldest;
+			}
+		}
+		#else
+		{
+			( void ) pxOldest;
+		}
+		#endif /* ipconfigTCP_SYN_COOKIES */
+
+		return pxReturn;
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+
+	static BaseType_t prvSynCacheEntryExpired( const SynCacheEntry_t *pxEntry, TickType_t xNow )
+	{
+	BaseType_t xReturn = pdFALSE;
+
+		if( ( TickType_t ) ( xNow - pxEntry->xTimeReceived ) >= pdMS_TO_TICKS( ipconfigTCP_SYN_CACHE_TIMEOUT_MS ) )
+		{
+			xReturn = pdTRUE;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+
+	static void prvSynCacheParseOptions( const NetworkBufferDescriptor_t *pxNetworkBuffer, SynOptions_t *pxOptions )
+	{
+	const TCPHeader_t *pxTCPHeader = &( ( ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer )->xTCPHeader );
+	const uint8_t *pucPtr = pxTCPHeader->ucOptdata;
+	const uint8_t *pucLast = pucPtr;
+	UBaseType_t uxLength;
+
+		memset( pxOptions, '\0', sizeof( *pxOptions ) );
+
+		if( ( pxTCPHeader->ucTCPOffset & TCP_OFFSET_LENGTH_BITS ) > TCP_OFFSET_STANDARD_LENGTH )
+		{
+			pucLast = pucPtr + ( ( ( pxTCPHeader->ucTCPOffset >> 4 ) - 5 ) << 2 );
+
+			/* Validate options size calculation. */
+			if( pucLast > ( pxNetworkBuffer->pucEthernetBuffer + pxNetworkBuffer->xDataLength ) )
+			{
+				pucLast = pucPtr;
+			}
+		}
+
+		while( ( pucPtr < pucLast ) && ( pucPtr[ 0 ] != TCP_OPT_END ) )
+		{
+			if( pucPtr[ 0 ] == TCP_OPT_NOOP )
+			{
+				pucPtr++;
+			}
+			else
+			{
+				/* All other options have a length field. */
+				if( ( pucLast - pucPtr ) < 2 )
+				{
+					break;
+				}
+
+				uxLength = ( UBaseType_t ) pucPtr[ 1 ];
+				if( ( uxLength < 2u ) || ( uxLength > ( UBaseType_t ) ( pucLast - pucPtr ) ) )
+				{
+					/* The options are malformed. */
+					break;
+				}
+
+				if( ( pucPtr[ 0 ] == TCP_OPT_MSS ) && ( uxLength == TCP_OPT_MSS_LEN ) )
+				{
+					pxOptions->usMSS = usChar2u16( pucPtr + 2 );
+				}
+				else if( ( pucPtr[ 0 ] == TCP_OPT_WSOPT ) && ( uxLength == TCP_OPT_WSOPT_LEN ) )
+				{
+					pxOptions->xWinScale = pdTRUE;
+				}
+				else if( ( pucPtr[ 0 ] == TCP_OPT_TIMESTAMP ) && ( uxLength == ( UBaseType_t ) TCP_OPT_TIMESTAMP_LEN ) )
+				{
+					pxOptions->xTimeStamps = pdTRUE;
+					pxOptions->ulTSValue = ulChar2u32( pucPtr + 2 );
+				}
+				else
+				{
+					/* Not needed to answer the SYN. */
+				}
+
+				pucPtr += uxLength;
+			}
+		}
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+
+	static void prvSynCacheSendSynAck( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer,
+		uint32_t ulOurSequenceNumber, uint16_t usMSS, uint8_t ucMyWinScaleFactor, const SynOptions_t *pxOptions )
+	{
+	TCPPacket_t * pxTCPPacket = ( TCPPacket_t * ) ( pxNetworkBuffer->pucEthernetBuffer );
+	TCPHeader_t *pxTCPHeader = &( pxTCPPacket->xTCPHeader );
+	UBaseType_t uxOptionsLength;
+	uint32_t ulWinSize;
+
+		/* prvTCPReturnPacket() will swap the sequence number and the ACK
+		number, as it does for a RST. */
+		pxTCPHeader->ulAckNr = FreeRTOS_htonl( ulOurSequenceNumber );
+		pxTCPHeader->ulSequenceNumber = FreeRTOS_htonl( FreeRTOS_ntohl( pxTCPHeader->ulSequenceNumber ) + 1u );
+
+		/* The same options as prvSetSynAckOptions() would add. */
+		pxTCPHeader->ucOptdata[ 0 ] = ( uint8_t ) TCP_OPT_MSS;
+		pxTCPHeader->ucOptdata[ 1 ] = ( uint8_t ) TCP_OPT_MSS_LEN;
+		pxTCPHeader->ucOptdata[ 2 ] = ( uint8_t ) ( usMSS >> 8 );
+		pxTCPHeader->ucOptdata[ 3 ] = ( uint8_t ) ( usMSS & 0xffu );
+		uxOptionsLength = 4u;
+
+		#if( ipconfigUSE_TCP_WIN != 0 )
+		{
+			if( pxOptions->xWinScale != pdFALSE )
+			{
+				pxTCPHeader->ucOptdata[ 4 ] = TCP_OPT_NOOP;
+				pxTCPHeader->ucOptdata[ 5 ] = ( uint8_t ) ( TCP_OPT_WSOPT );
+				pxTCPHeader->ucOptdata[ 6 ] = ( uint8_t ) ( TCP_OPT_WSOPT_LEN );
+				pxTCPHeader->ucOptdata[ 7 ] = ucMyWinScaleFactor;
+				uxOptionsLength = 8u;
+			}
+
+			pxTCPHeader->ucOptdata[ uxOptionsLength + 0 ] = TCP_OPT_NOOP;
+			pxTCPHeader->ucOptdata[ uxOptionsLength + 1 ] = TCP_OPT_NOOP;
+			pxTCPHeader->ucOptdata[ uxOptionsLength + 2 ] = TCP_OPT_SACK_P;	/* 4: Sack-Permitted Option. */
+			pxTCPHeader->ucOptdata[ uxOptionsLength + 3 ] = 2;	/* 2: length of this option. */
+			uxOptionsLength += 4u;
+		}
+		#else
+		{
+			( void ) ucMyWinScaleFactor;
+		}
+		#endif /* ipconfigUSE_TCP_WIN */
+
+		#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
+		{
+		uint8_t *pucOption;
+		uint32_t ulValue;
+
+			if( pxOptions->xTimeStamps != pdFALSE )
+			{
+				pucOption = &( pxTCPHeader->ucOptdata[ uxOptionsLength ] );
+				pucOption[ 0 ] = TCP_OPT_NOOP;
+				pucOption[ 1 ] = TCP_OPT_NOOP;
+				pucOption[ 2 ] = TCP_OPT_TIMESTAMP;
+				pucOption[ 3 ] = TCP_OPT_TIMESTAMP_LEN;
+
+				ulValue = FreeRTOS_htonl( ( uint32_t ) xTaskGetTickCount() );
+				memcpy( pucOption + 4, &ulValue, sizeof( ulValue ) );
+
+				ulValue = FreeRTOS_htonl( pxOptions->ulTSValue );
+				memcpy( pucOption + 8, &ulValue, sizeof( ulValue ) );
+
+				uxOptionsLength += TCP_OPT_TIMESTAMP_SPACE;
+			}
+		}
+		#else
+		{
+			( void ) pxOptions;
+		}
+		#endif /* ipconfigUSE_TCP_TIMESTAMPS */
+
+		/* Advertise the window that the new socket will have.  The window
+		field of a SYN+ACK is never scaled. */
+		ulWinSize = FreeRTOS_min_uint32( ( uint32_t ) ( ipconfigTCP_MSS * pxSocket->u.xTCP.uxRxWinSize ), ( uint32_t ) pxSocket->u.xTCP.uxRxStreamSize );
+		if( ulWinSize > 0xfffcUL )
+		{
+			ulWinSize = 0xfffcUL;
+		}
+		pxTCPHeader->usWindow = FreeRTOS_htons( ( uint16_t ) ulWinSize );
+
+		pxTCPHeader->ucTCPFlags = ( uint8_t ) ( ipTCP_FLAG_SYN | ipTCP_FLAG_ACK );
+		pxTCPHeader->ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+
+		prvTCPReturnPacket( NULL, pxNetworkBuffer, ( uint32_t ) ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength ), pdFALSE );
+	}
+
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+
+	static uint32_t prvSynCookieHash( const TCPPacket_t *pxTCPPacket, uint32_t ulPeerSequenceNumber, uint32_t ulTime )
+	{
+	uint32_t ulValues[ 4 ];
+	uint32_t ulHash = ulSynCookieSecret;
+	BaseType_t xIndex;
+
+		ulValues[ 0 ] = pxTCPPacket->xIPHeader.ulSourceIPAddress;
+		ulValues[ 1 ] = ( ( ( uint32_t ) pxTCPPacket->xTCPHeader.usSourcePort ) << 16 ) | ( uint32_t ) pxTCPPacket->xTCPHeader.usDestinationPort;
+		ulValues[ 2 ] = ulPeerSequenceNumber;
+		ulValues[ 3 ] = ulTime;
+
+		/* Mix every word into the hash, using the finalizer of MurmurHash3.
+		This is not a cryptographic hash, but without knowing the secret a
+		valid cookie can not be guessed easily. */
+		for( xIndex = 0; xIndex < 4; xIndex++ )
+		{
+			ulHash ^= ulValues[ xIndex ];
+			ulHash ^= ulHash >> 16;
+			ulHash *= 0x85ebca6bUL;
+			ulHash ^= ulHash >> 13;
+			ulHash *= 0xc2b2ae35UL;
+			ulHash ^= ulHash >> 16;
+		}
+
+		return ulHash;
+	}
+
+#endif /* ipconfigTCP_SYN_COOKIES */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+
+	static uint32_t prvSynCookieCreate( const TCPPacket_t *pxTCPPacket, uint16_t *pusMSS )
+	{
+	uint32_t ulTime = ( uint32_t ) ( xTaskGetTickCount() / pdMS_TO_TICKS( tcpSYN_COOKIE_PERIOD_MS ) );
+	uint32_t ulIndex = ( uint32_t ) ( sizeof( usSynCookieMSS ) / sizeof( usSynCookieMSS[ 0 ] ) ) - 1u;
+	uint32_t ulCookie;
+
+		if( ulSynCookieSecret == 0u )
+		{
+			( void ) xApplicationGetRandomNumber( &( ulSynCookieSecret ) );
+		}
+
+		/* Find the largest MSS that can be encoded, and which is not larger
+		than the MSS that would be used. */
+		while( ( ulIndex > 0u ) && ( usSynCookieMSS[ ulIndex ] > *pusMSS ) )
+		{
+			ulIndex--;
+		}
+		*pusMSS = usSynCookieMSS[ ulIndex ];
+
+		ulCookie = ( ( ulTime & tcpSYN_COOKIE_TIME_MASK ) << tcpSYN_COOKIE_TIME_SHIFT ) |
+			( ulIndex << tcpSYN_COOKIE_MSS_SHIFT ) |
+			( prvSynCookieHash( pxTCPPacket, FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber ), ulTime ) & tcpSYN_COOKIE_HASH_MASK );
+
+		return ulCookie;
+	}
+
+#endif /* ipconfigTCP_SYN_COOKIES */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_SYN_COOKIES != 0 )
+
+	static BaseType_t prvSynCookieCheck( const TCPPacket_t *pxTCPPacket, uint16_t *pusMSS )
+	{
+	uint32_t ulNow = ( uint32_t ) ( xTaskGetTickCount() / pdMS_TO_TICKS( tcpSYN_COOKIE_PERIOD_MS ) );
+	uint32_t ulCookie = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr ) - 1u;
+	uint32_t ulAge;
+	BaseType_t xReturn = pdFALSE;
+
+		if( ulSynCookieSecret != 0u )
+		{
+			ulAge = ( ulNow - ( ulCookie >> tcpSYN_COOKIE_TIME_SHIFT ) ) & tcpSYN_COOKIE_TIME_MASK;
+
+			if( ( ulAge <= 1u ) &&
+				( ( prvSynCookieHash( pxTCPPacket, FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber ) - 1u, ulNow - ulAge ) & tcpSYN_COOKIE_HASH_MASK ) ==
+				  ( ulCookie & tcpSYN_COOKIE_HASH_MASK ) ) )
+			{
+				*pusMSS = usSynCookieMSS[ ( ulCookie >> tcpSYN_COOKIE_MSS_SHIFT ) & tcpSYN_COOKIE_MSS_MASK ];
+				xReturn = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigTCP_SYN_COOKIES */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+
+	static FastOpenEntry_t *prvFastOpenLookup( uint32_t ulIPAddress, BaseType_t xCreate )
+	{
+	FastOpenEntry_t *pxReturn = NULL;
+	FastOpenEntry_t *pxFree = NULL;
+	FastOpenEntry_t *pxOldest = NULL;
+	TickType_t xNow = xTaskGetTickCount();
+	TickType_t xAge, xOldestAge = 0u;
+	BaseType_t xIndex;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigTCP_FAST_OPEN_CACHE_ENTRIES; xIndex++ )
+		{
+			xAge = xNow - xFastOpenCache[ xIndex ].xLastUsed;
+
+			if( xFastOpenCache[ xIndex ].ulIPAddress == ulIPAddress )
+			{
+				pxReturn = &( xFastOpenCache[ xIndex ] );
+				break;
+			}
+			else if( xFastOpenCache[ xIndex ].ulIPAddress == 0u )
+			{
+				if( pxFree == NULL )
+				{
+					pxFree = &( xFastOpenCache[ xIndex ] );
+				}
+			}
+			else if( ( pxOldest == NULL ) || ( xAge > xOldestAge ) )
+			{
+				pxOldest = &( xFastOpenCache[ xIndex ] );
+				xOldestAge = xAge;
+			}
+		}
+
+		if( ( pxReturn == NULL ) && ( xCreate != pdFALSE ) )
+		{
+			pxReturn = ( pxFree != NULL ) ? pxFree : pxOldest;
+			memset( pxReturn, '\0', sizeof( *pxReturn ) );
+			pxReturn->ulIPAddress = ulIPAddress;
+		}
+
+		if( pxReturn != NULL )
+		{
+			pxReturn->xLastUsed = xNow;
+		}
+
+		return pxReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+
+	static int32_t prvTCPSendFastOpenSyn( FreeRTOS_Socket_t *pxSocket, UBaseType_t uxOptionsLength )
+	{
+	FastOpenEntry_t *pxEntry;
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	TCPPacket_t *pxTCPPacket;
+	uint8_t *pucOption;
+	UBaseType_t uxCookieLength = 0u, uxFastOpenLength, uxHeaderLength, uxIndex;
+	size_t uxDataLength = 0u, uxMaxLength;
+	int32_t lResult = 0;
+
+		pxEntry = prvFastOpenLookup( pxSocket->u.xTCP.ulRemoteIP, pdFALSE );
+
+		if( pxEntry != NULL )
+		{
+			uxCookieLength = ( UBaseType_t ) pxEntry->ucCookieLength;
+		}
+
+		/* The option holds either the cookie, or nothing when asking for a
+		cookie.  It is preceded by NOP's to make its length a multiple of 4. */
+		uxFastOpenLength = ( 2u + uxCookieLength + 3u ) & ~3u;
+
+		if( ( uxOptionsLength + uxFastOpenLength ) <= tcpTCP_OPTIONS_MAX_LENGTH )
+		{
+			uxHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength + uxFastOpenLength;
+
+			if( ( uxCookieLength != 0u ) && ( pxSocket->u.xTCP.txStream != NULL ) )
+			{
+				/* Without a cookie the server would drop the data.  The MSS
+				of the server is not known yet, use the MSS of the previous
+				connection. */
+				uxMaxLength = ( pxEntry->usMSS != 0u ) ? ( size_t ) pxEntry->usMSS : ( size_t ) tcpFAST_OPEN_DEFAULT_MSS;
+
+				if( uxMaxLength > ( size_t ) pxSocket->u.xTCP.usCurMSS )
+				{
+					uxMaxLength = ( size_t ) pxSocket->u.xTCP.usCurMSS;
+				}
+
+				/* The options take space from the segment. */
+				if( uxMaxLength > ( size_t ) ( uxOptionsLength + uxFastOpenLength ) )
+				{
+					uxMaxLength -= ( size_t ) ( uxOptionsLength + uxFastOpenLength );
+					uxDataLength = FreeRTOS_min_uint32( ( uint32_t ) uxStreamBufferGetSize( pxSocket->u.xTCP.txStream ), ( uint32_t ) uxMaxLength );
+				}
+			}
+
+			pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( uxHeaderLength + uxDataLength, 0u );
+
+			if( pxNetworkBuffer != NULL )
+			{
+				/* Copy the headers and the options that were written by
+				prvSetSynAckOptions(). */
+				memcpy( pxNetworkBuffer->pucEthernetBuffer, pxSocket->u.xTCP.xPacket.u.ucLastPacket, uxHeaderLength - uxFastOpenLength );
+				pxTCPPacket = ( TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+
+				pucOption = pxNetworkBuffer->pucEthernetBuffer + ( uxHeaderLength - uxFastOpenLength );
+				for( uxIndex = 2u + uxCookieLength; uxIndex < uxFastOpenLength; uxIndex++ )
+				{
+					*( pucOption++ ) = TCP_OPT_NOOP;
+				}
+				pucOption[ 0 ] = TCP_OPT_FASTOPEN;
+				pucOption[ 1 ] = ( uint8_t ) ( 2u + uxCookieLength );
+				if( uxCookieLength != 0u )
+				{
+					memcpy( pucOption + 2, pxEntry->ucCookie, ( size_t ) uxCookieLength );
+				}
+
+				if( uxDataLength != 0u )
+				{
+					/* The data is peeked, it stays in txStream until it has
+					been acknowledged. */
+					#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+					{
+						( void ) prvTCPTxCopy( pxSocket, 0u, pxNetworkBuffer->pucEthernetBuffer + uxHeaderLength, uxDataLength );
+					}
+					#else
+					{
+						( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0u, pxNetworkBuffer->pucEthernetBuffer + uxHeaderLength, uxDataLength, pdTRUE );
+					}
+					#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
+				}
+
+				pxTCPPacket->xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength + uxFastOpenLength ) << 2 );
+
+				lResult = ( int32_t ) ( ( uxHeaderLength - ipSIZE_OF_ETH_HEADER ) + uxDataLength );
+				pxNetworkBuffer->xDataLength = uxHeaderLength + uxDataLength;
+				pxSocket->u.xTCP.ulFastOpenSent = ( uint32_t ) uxDataLength;
+
+				FreeRTOS_debug_printf( ( "TFO: %lxip:%u cookie %u bytes, %u data bytes\n",
+					pxSocket->u.xTCP.ulRemoteIP,
+					pxSocket->u.xTCP.usRemotePort,
+					( unsigned ) uxCookieLength,
+					( unsigned ) uxDataLength ) );
+
+				ipCOUNT_SOCKET_EVENT( pxSocket, ulTxBytes, uxDataLength );
+
+				prvTCPReturnPacket( pxSocket, pxNetworkBuffer, ( uint32_t ) lResult, ipconfigZERO_COPY_TX_DRIVER );
+
+				#if( ipconfigZERO_COPY_TX_DRIVER == 0 )
+				{
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+				}
+				#endif /* ipconfigZERO_COPY_TX_DRIVER */
+			}
+		}
+
+		return lResult;
+	}
+
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_FAST_OPEN != 0 )
+
+	static void prvTCPFastOpenSynAcked( FreeRTOS_Socket_t *pxSocket, uint32_t ulAckNumber )
+	{
+	TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+	FastOpenEntry_t *pxEntry;
+	uint32_t ulCount = pxSocket->u.xTCP.ulFastOpenSent;
+
+		pxEntry = prvFastOpenLookup( pxSocket->u.xTCP.ulRemoteIP, pdFALSE );
+
+		if( pxEntry != NULL )
+		{
+			pxEntry->usMSS = pxSocket->u.xTCP.usCurMSS;
+		}
+
+		if( ulCount != 0u )
+		{
+			if( ulAckNumber == ( pxTCPWindow->tx.ulFirstSequenceNumber + 1u + ulCount ) )
+			{
+				/* The server accepted the cookie and the data.  The data has
+				never been passed to the sliding window, skip it. */
+				pxTCPWindow->tx.ulCurrentSequenceNumber += ulCount;
+				pxTCPWindow->tx.ulHighestSequenceNumber += ulCount;
+				pxTCPWindow->ulNextTxSequenceNumber += ulCount;
+				pxTCPWindow->ulOurSequenceNumber += ulCount;
+
+				vStreamBufferMoveMid( pxSocket->u.xTCP.txStream, ( size_t ) ulCount );
+				ulCount = ( uint32_t ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0u, NULL, ( size_t ) ulCount, pdFALSE );
+
+				#if( ipconfigUSE_TCP_ZERO_COPY_TX != 0 )
+				{
+					prvTCPTxReferencesAcked( pxSocket, ( size_t ) ulCount );
+				}
+				#endif /* ipconfigUSE_TCP_ZERO_COPY_TX */
+
+				pxSocket->xEventBits |= eSOCKET_SEND;
+			}
+			else
+			{
+				/* Only the SYN was acknowledged, the data stays in txStream
+				and it will be sent as usual. */
+				FreeRTOS_debug_printf( ( "TFO: %lxip:%u did not accept %lu bytes\n",
+					pxSocket->u.xTCP.ulRemoteIP,
+					pxSocket->u.xTCP.usRemotePort,
+					ulCount ) );
+			}
+
+			pxSocket->u.xTCP.ulFastOpenSent = 0u;
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+/*-----------------------------------------------------------*/
+
+/*
+ * Duplicates a socket after a listening socket receives a connection.
+ */
+static BaseType_t prvTCPSocketCopy( FreeRTOS_Socket_t *pxNewSocket, FreeRTOS_Socket_t *pxSocket )
+{
+struct freertos_sockaddr xAddress;
+
+	pxNewSocket->xReceiveBlockTime = pxSocket->xReceiveBlockTime;
+	pxNewSocket->xSendBlockTime = pxSocket->xSendBlockTime;
+	pxNewSocket->ucSocketOptions = pxSocket->ucSocketOptions;
+	#if( ipconfigUSE_DSCP != 0 )
+	{
+		pxNewSocket->ucDSCP = pxSocket->ucDSCP;
+	}
+	#endif
+	pxNewSocket->u.xTCP.uxRxStreamSize = pxSocket->u.xTCP.uxRxStreamSize;
+	pxNewSocket->u.xTCP.uxTxStreamSize = pxSocket->u.xTCP.uxTxStreamSize;
+	pxNewSocket->u.xTCP.uxLittleSpace = pxSocket->u.xTCP.uxLittleSpace;
+	pxNewSocket->u.xTCP.uxEnoughSpace = pxSocket->u.xTCP.uxEnoughSpace;
+	pxNewSocket->u.xTCP.uxRxWinSize  = pxSocket->u.xTCP.uxRxWinSize;
+	pxNewSocket->u.xTCP.uxTxWinSize  = pxSocket->u.xTCP.uxTxWinSize;
+
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	{
+		/* The child socket uses the same congestion control as its parent. */
+		pxNewSocket->u.xTCP.xTCPWindow.xCongestion.ucAlgorithm = pxSocket->u.xTCP.xTCPWindow.xCongestion.ucAlgorithm;
+		pxNewSocket->u.xTCP.xTCPWindow.xCongestion.u.bits.bPacing = pxSocket->u.xTCP.xTCPWindow.xCongestion.u.bits.bPacing;
+	}
+	#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
+	#if( ipconfigUSE_TCP_WIN == 1 )
+	{
+		/* The child socket gets the same segment quota as its parent. */
+		pxNewSocket->u.xTCP.xTCPWindow.uxSegmentQuota = pxSocket->u.xTCP.xTCPWindow.uxSegmentQuota;
+	}
+	#endif /* ipconfigUSE_TCP_WIN */
+
+	#if( ipconfigUSE_TCP_ZERO_COPY_RX != 0 )
+	{
+		pxNewSocket->u.xTCP.bits.bRxZeroCopy = pxSocket->u.xTCP.bits.bRxZeroCopy;
+	}
+	#endif /* ipconfigUSE_TCP_ZERO_COPY_RX */
 
 	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
 	{
@@ -50,15 +50,17 @@
 #include "NetworkBufferManagement.h"
 #include "FreeRTOS_TCP_WIN.h"
 
-/* Constants used for Smoothed Round Trip Time (SRTT). */
-#define	winSRTT_INCREMENT_NEW 		2
-#define winSRTT_INCREMENT_CURRENT 	6
-#define	winSRTT_DECREMENT_NEW 		1
-#define winSRTT_DECREMENT_CURRENT 	7
-#define winSRTT_CAP_mS				50
-
 #if( ipconfigUSE_TCP_WIN == 1 )
 
+	/* The number of segment descriptors allocated at once, and the maximum
+	number of allocations needed to create ipconfigTCP_WIN_SEG_COUNT of them. */
+	#if( ( ipconfigTCP_WIN_SEG_CHUNK > 0 ) && ( ipconfigTCP_WIN_SEG_CHUNK < ipconfigTCP_WIN_SEG_COUNT ) )
+		#define winSEGMENT_CHUNK_SIZE	( ipconfigTCP_WIN_SEG_CHUNK )
+	#else
+		#define winSEGMENT_CHUNK_SIZE	( ipconfigTCP_WIN_SEG_COUNT )
+	#endif
+	#define winSEGMENT_CHUNK_COUNT		( ( ipconfigTCP_WIN_SEG_COUNT + winSEGMENT_CHUNK_SIZE - 1 ) / winSEGMENT_CHUNK_SIZE )
+
 	#define xTCPWindowRxNew( pxWindow, ulSequenceNumber, lCount ) xTCPWindowNew( pxWindow, ulSequenceNumber, lCount, pdTRUE )
 
 	#define xTCPWindowTxNew( pxWindow, ulSequenceNumber, lCount ) xTCPWindowNew( pxWindow, ulSequenceNumber, lCount, pdFALSE )
@@ -88,6 +90,41 @@
 	#define MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW		( 4u )
 
 #endif /* configUSE_TCP_WIN */
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	/* RFC 3390: the initial congestion window is
+	 * min( 4 * MSS, max( 2 * MSS, 4380 bytes ) ). */
+	#define tcpCC_INITIAL_WINDOW_BYTES			( 4380u )
+
+	/* RFC 3465: during slow start, the congestion window grows with the number
+	 * of bytes ACK'd, but with at most 2 * MSS per ACK. */
+	#define tcpCC_SLOW_START_MAX_MSS_PER_ACK	( 2u )
+
+	/* CUBIC (RFC 8312) uses beta = 0.7 and C = 0.4.  The constants below are
+	 * the integer fractions used. */
+	#define tcpCUBIC_BETA_NUMERATOR				( 7u )
+	#define tcpCUBIC_BETA_DENOMINATOR			( 10u )
+	/* Fast convergence: ( 1 + beta ) / 2 */
+	#define tcpCUBIC_FAST_CONV_NUMERATOR		( 17u )
+	#define tcpCUBIC_FAST_CONV_DENOMINATOR		( 20u )
+	/* TCP-friendly region: 3 * ( 1 - beta ) / ( 1 + beta ) */
+	#define tcpCUBIC_FRIENDLY_NUMERATOR			( 9u )
+	#define tcpCUBIC_FRIENDLY_DENOMINATOR		( 17u )
+	/* K = cbrt( W_max * ( 1 - beta ) / C ) seconds, or in ms:
+	 * cbrt( W_max / MSS * 1e9 / C ), where 1e9 / C = 2.5e9 */
+	#define tcpCUBIC_1E9_DIV_C					( 2500000000ULL )
+	/* An increase of cwnd which is not limited by the cubic function is
+	 * kept as small as 1 MSS per 100 RTT's. */
+	#define tcpCUBIC_MIN_GROWTH_FACTOR			( 100u )
+	/* The time since the start of an epoch is limited to avoid an overflow
+	 * when the cube is calculated. */
+	#define tcpCUBIC_MAX_EPOCH_MS				( 65535u )
+
+	/* The pacing rate is a multiple of cwnd / SRTT: twice as fast during slow
+	 * start, 1.25 times as fast during congestion avoidance (as percentage). */
+	#define tcpPACING_GAIN_SLOW_START			( 200u )
+	#define tcpPACING_GAIN_CONGESTION_AVOID		( 125u )
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
 /*-----------------------------------------------------------*/
 
 extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem, MiniListItem_t * const pxWhere );
@@ -104,6 +141,15 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 	static BaseType_t prvCreateSectors( void );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Allocate a new chunk of segment descriptors and add them to 'xSegmentList'.
+ * Returns pdFAIL when ipconfigTCP_WIN_SEG_COUNT descriptors have been created
+ * already, or when the allocation fails.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static BaseType_t prvGrowSegmentPool( void );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
 /*
  * Find a segment with a given sequence number in the list of received
  * segments: 'pxWindow->xRxSegments'.
@@ -115,7 +161,8 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 /*
  * Allocate a new segment
  * The socket will borrow all segments from a common pool: 'xSegmentList',
- * which is a list of 'TCPSegment_t'
+ * which is a list of 'TCPSegment_t'.  Once the window holds 'uxSegmentQuota'
+ * segments, it may only borrow from the overflow pool.
  */
 #if( ipconfigUSE_TCP_WIN == 1 )
 	static TCPSegment_t *xTCPWindowNew( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber, int32_t lCount, BaseType_t xIsForRx );
@@ -150,7 +197,7 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
  *	The ownership will be passed back to the segment pool
  */
 #if( ipconfigUSE_TCP_WIN == 1 )
-	static void vTCPWindowFree( TCPSegment_t *pxSegment );
+	static void vTCPWindowFree( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
 /*
@@ -197,13 +244,103 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow, uint32_t ulFirst );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Return the number of ms after which an outstanding segment will be
+ * retransmitted.  The time-out doubles with every retransmission.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static uint32_t prvTCPWindowRetransmitTime( const TCPWindow_t *pxWindow, const TCPSegment_t *pxSegment );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
 /*-----------------------------------------------------------*/
 
-/* TCP segment pool. */
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	/*
+	 * Initialise the congestion window, called once the MSS is known.
+	 */
+	static void prvTCPCongestionInit( TCPWindow_t *pxWindow );
+
+	/*
+	 * New data has been acknowledged by the peer, let the congestion window
+	 * grow, either by slow start or by the algorithm in use.
+	 */
+	static void prvTCPCongestionAck( TCPWindow_t *pxWindow, uint32_t ulBytesAcked );
+
+	/*
+	 * A segment is being retransmitted: a fast retransmission when 'xIsTimeout'
+	 * is false, otherwise because of a retransmission time-out (RTO).  Shrink
+	 * the congestion window.
+	 */
+	static void prvTCPCongestionLoss( TCPWindow_t *pxWindow, BaseType_t xIsTimeout );
+
+	/*
+	 * Returns the number of ms before a new segment of 'ulLength' bytes may be
+	 * sent, in case pacing is used.
+	 */
+	static uint32_t prvTCPCongestionPaceDelay( TCPWindow_t *pxWindow, uint32_t ulLength );
+
+	/*
+	 * Let the congestion window grow by 1 MSS for every 'ulBytesPerMSS' bytes
+	 * that are ACK'd during congestion avoidance.
+	 */
+	static void prvTCPCongestionGrow( TCPWindow_t *pxWindow, uint32_t ulBytesAcked, uint32_t ulBytesPerMSS );
+
+	/*
+	 * The functions that implement NewReno (RFC 5681 / RFC 6582).
+	 */
+	static void prvNewRenoInit( TCPWindow_t *pxWindow );
+	static void prvNewRenoCongestionAvoid( TCPWindow_t *pxWindow, uint32_t ulBytesAcked );
+	static uint32_t prvNewRenoSSThresh( TCPWindow_t *pxWindow );
+
+	/*
+	 * The functions that implement CUBIC (RFC 8312).
+	 */
+	static void prvCubicInit( TCPWindow_t *pxWindow );
+	static void prvCubicCongestionAvoid( TCPWindow_t *pxWindow, uint32_t ulBytesAcked );
+	static uint32_t prvCubicSSThresh( TCPWindow_t *pxWindow );
+
+	/*
+	 * Return the implementation of a FREERTOS_TCP_CC_xxx algorithm, or NULL
+	 * if the algorithm is not known.
+	 */
+	static const TCPCongestionOps_t *prvTCPCongestionFind( uint8_t ucAlgorithm );
+
+	/*
+	 * Return the integer cube root of 'ullValue'.
+	 */
+	static uint32_t prvCubeRoot( uint64_t ullValue );
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
+/* TCP segment pool, allocated in one or more chunks. */
 #if( ipconfigUSE_TCP_WIN == 1 )
-	static TCPSegment_t *xTCPSegments = NULL;
+	static TCPSegment_t *pxTCPSegmentChunks[ winSEGMENT_CHUNK_COUNT ];
+	static UBaseType_t uxSegmentChunkCount = 0u;
+
+	/* Usage of the segment pool, 'uxFree' is not used here: it is the length
+	of 'xSegmentList'. */
+	static TCPSegmentStats_t xSegmentStats;
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	/* The congestion control algorithms that can be selected with the
+	FREERTOS_SO_TCP_CONGESTION option. */
+	static const TCPCongestionOps_t xNewRenoOps =
+	{
+		"NewReno",
+		prvNewRenoInit,
+		prvNewRenoCongestionAvoid,
+		prvNewRenoSSThresh
+	};
+
+	static const TCPCongestionOps_t xCubicOps =
+	{
+		"CUBIC",
+		prvCubicInit,
+		prvCubicCongestionAvoid,
+		prvCubicSSThresh
+	};
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 /* List of free TCP segments. */
 #if( ipconfigUSE_TCP_WIN == 1 )
 	static List_t xSegmentList;
@@ -302,37 +439,66 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 
 	static BaseType_t prvCreateSectors( void )
 	{
-	BaseType_t xIndex, xReturn;
+		/* Initialise 'xSegmentList' and store the first chunk of segment
+		descriptors in it. */
+		vListInitialise( &xSegmentList );
+		memset( &xSegmentStats, '\0', sizeof( xSegmentStats ) );
 
-		/* Allocate space for 'xTCPSegments' and store them in 'xSegmentList'. */
+		return prvGrowSegmentPool();
+	}
 
-		vListInitialise( &xSegmentList );
-		xTCPSegments = ( TCPSegment_t * ) pvPortMallocLarge( ipconfigTCP_WIN_SEG_COUNT * sizeof( xTCPSegments[ 0 ] ) );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
 
-		if( xTCPSegments == NULL )
-		{
-			FreeRTOS_debug_printf( ( "prvCreateSectors: malloc %lu failed\n",
-				ipconfigTCP_WIN_SEG_COUNT * sizeof( xTCPSegments[ 0 ] ) ) );
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static BaseType_t prvGrowSegmentPool( void )
+	{
+	TCPSegment_t *pxSegments;
+	UBaseType_t uxIndex, uxCount;
+	BaseType_t xReturn;
+
+		/* Allocate space for a chunk of segments and store them in
+		'xSegmentList'. */
+		uxCount = FreeRTOS_min_uint32( ( uint32_t ) winSEGMENT_CHUNK_SIZE, ( uint32_t ) ( ipconfigTCP_WIN_SEG_COUNT - xSegmentStats.uxTotal ) );
 
+		if( ( uxCount == 0u ) || ( uxSegmentChunkCount >= winSEGMENT_CHUNK_COUNT ) )
+		{
 			xReturn = pdFAIL;
 		}
 		else
 		{
-			/* Clear the allocated space. */
-			memset( xTCPSegments, '\0', ipconfigTCP_WIN_SEG_COUNT * sizeof( xTCPSegments[ 0 ] ) );
+			pxSegments = ( TCPSegment_t * ) pvPortMallocLarge( uxCount * sizeof( pxSegments[ 0 ] ) );
 
-			for( xIndex = 0; xIndex < ipconfigTCP_WIN_SEG_COUNT; xIndex++ )
+			if( pxSegments == NULL )
 			{
-				/* Could call vListInitialiseItem here but all data has been
-				nulled already.  Set the owner to a segment descriptor. */
-				listSET_LIST_ITEM_OWNER( &( xTCPSegments[ xIndex ].xListItem ), ( void* ) &( xTCPSegments[ xIndex ] ) );
-				listSET_LIST_ITEM_OWNER( &( xTCPSegments[ xIndex ].xQueueItem ), ( void* ) &( xTCPSegments[ xIndex ] ) );
+				FreeRTOS_debug_printf( ( "prvGrowSegmentPool: malloc %lu failed\n",
+					uxCount * sizeof( pxSegments[ 0 ] ) ) );
 
-				/* And add it to the pool of available segments */
-				vListInsertFifo( &xSegmentList, &( xTCPSegments[xIndex].xListItem ) );
+				xReturn = pdFAIL;
 			}
+			else
+			{
+				/* Clear the allocated space. */
+				memset( pxSegments, '\0', uxCount * sizeof( pxSegments[ 0 ] ) );
+
+				for( uxIndex = 0u; uxIndex < uxCount; uxIndex++ )
+				{
+					/* Could call vListInitialiseItem here but all data has been
+					nulled already.  Set the owner to a segment descriptor. */
+					listSET_LIST_ITEM_OWNER( &( pxSegments[ uxIndex ].xListItem ), ( void* ) &( pxSegments[ uxIndex ] ) );
+					listSET_LIST_ITEM_OWNER( &( pxSegments[ uxIndex ].xQueueItem ), ( void* ) &( pxSegments[ uxIndex ] ) );
+
+					/* And add it to the pool of available segments */
+					vListInsertFifo( &xSegmentList, &( pxSegments[ uxIndex ].xListItem ) );
+				}
+
+				pxTCPSegmentChunks[ uxSegmentChunkCount ] = pxSegments;
+				uxSegmentChunkCount++;
+				xSegmentStats.uxTotal += uxCount;
 
-			xReturn = pdPASS;
+				xReturn = pdPASS;
+			}
 		}
 
 		return xReturn;
@@ -379,14 +545,37 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 	{
 	TCPSegment_t *pxSegment;
 	ListItem_t * pxItem;
+	UBaseType_t uxHeld, uxInUse;
+	BaseType_t xBorrow = pdFALSE;
+
+		/* The number of segments held by this window. */
+		uxHeld = listCURRENT_LIST_LENGTH( &( pxWindow->xRxSegments ) ) + listCURRENT_LIST_LENGTH( &( pxWindow->xTxSegments ) );
+
+		if( ( pxWindow->uxSegmentQuota != 0u ) && ( uxHeld >= pxWindow->uxSegmentQuota ) )
+		{
+			xBorrow = pdTRUE;
+		}
 
 		/* Allocate a new segment.  The socket will borrow all segments from a
 		common pool: 'xSegmentList', which is a list of 'TCPSegment_t' */
-		if( listLIST_IS_EMPTY( &xSegmentList ) != pdFALSE )
+		if( ( xBorrow != pdFALSE ) && ( xSegmentStats.uxOverflowInUse >= ( UBaseType_t ) ipconfigTCP_WIN_SEG_OVERFLOW ) )
+		{
+			/* The window has used up its quota and the other sockets are
+			using the overflow pool already.  This is not an error, the
+			caller will try again later. */
+			if( ( xTCPWindowLoggingLevel != 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != pdFALSE ) )
+			{
+				FreeRTOS_debug_printf( ( "xTCPWindow%cxNew: quota %lu reached\n", xIsForRx ? 'R' : 'T', ( uint32_t ) pxWindow->uxSegmentQuota ) );
+			}
+			xSegmentStats.ulQuotaRefused++;
+			pxSegment = NULL;
+		}
+		else if( ( listLIST_IS_EMPTY( &xSegmentList ) != pdFALSE ) && ( prvGrowSegmentPool() == pdFAIL ) )
 		{
 			/* If the TCP-stack runs out of segments, you might consider
 			increasing 'ipconfigTCP_WIN_SEG_COUNT'. */
 			FreeRTOS_debug_printf( ( "xTCPWindow%cxNew: Error: all segments occupied\n", xIsForRx ? 'R' : 'T' ) );
+			xSegmentStats.ulPoolExhausted++;
 			pxSegment = NULL;
 		}
 		else
@@ -413,17 +602,27 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 			pxSegment->lMaxLength = lCount;
 			pxSegment->lDataLength = lCount;
 			pxSegment->ulSequenceNumber = ulSequenceNumber;
-			#if( ipconfigHAS_DEBUG_PRINTF != 0 )
+
+			/* Keep track of the high-water marks. */
+			if( pxWindow->uxSegmentHighWater <= uxHeld )
 			{
-			static UBaseType_t xLowestLength = ipconfigTCP_WIN_SEG_COUNT;
-			UBaseType_t xLength = listCURRENT_LIST_LENGTH( &xSegmentList );
+				pxWindow->uxSegmentHighWater = uxHeld + 1u;
+			}
+
+			uxInUse = xSegmentStats.uxTotal - listCURRENT_LIST_LENGTH( &xSegmentList );
+			if( xSegmentStats.uxMaximumInUse < uxInUse )
+			{
+				xSegmentStats.uxMaximumInUse = uxInUse;
+			}
 
-				if( xLowestLength > xLength )
+			if( xBorrow != pdFALSE )
+			{
+				xSegmentStats.uxOverflowInUse++;
+				if( xSegmentStats.uxOverflowHighWater < xSegmentStats.uxOverflowInUse )
 				{
-					xLowestLength = xLength;
+					xSegmentStats.uxOverflowHighWater = xSegmentStats.uxOverflowInUse;
 				}
 			}
-			#endif /* ipconfigHAS_DEBUG_PRINTF */
 		}
 
 		return pxSegment;
@@ -520,8 +719,10 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 
 #if( ipconfigUSE_TCP_WIN == 1 )
 
-	static void vTCPWindowFree( TCPSegment_t *pxSegment )
+	static void vTCPWindowFree( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment )
 	{
+	UBaseType_t uxHeld;
+
 		/*  Free entry pxSegment because it's not used any more.  The ownership
 		will be passed back to the segment pool.
 
@@ -541,6 +742,14 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 			uxListRemove( &( pxSegment->xListItem ) );
 		}
 
+		/* If the window still holds at least 'uxSegmentQuota' segments, this
+		one was borrowed from the overflow pool. */
+		uxHeld = listCURRENT_LIST_LENGTH( &( pxWindow->xRxSegments ) ) + listCURRENT_LIST_LENGTH( &( pxWindow->xTxSegments ) );
+		if( ( pxWindow->uxSegmentQuota != 0u ) && ( uxHeld >= pxWindow->uxSegmentQuota ) && ( xSegmentStats.uxOverflowInUse != 0u ) )
+		{
+			xSegmentStats.uxOverflowInUse--;
+		}
+
 		/* Return it to xSegmentList */
 		vListInsertFifo( &xSegmentList, &( pxSegment->xListItem ) );
 	}
@@ -576,10 +785,18 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 				while( listCURRENT_LIST_LENGTH( pxSegments ) > 0U )
 				{
 					pxSegment = ( TCPSegment_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxSegments );
-					vTCPWindowFree( pxSegment );
+					vTCPWindowFree( pxWindow, pxSegment );
 				}
 			}
 		}
+
+		if( ( xTCPWindowLoggingLevel != 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != pdFALSE ) )
+		{
+			FreeRTOS_debug_printf( ( "vTCPWindowDestroy: %u -> %u held at most %lu segments (quota %lu)\n",
+				pxWindow->usOurPortNumber, pxWindow->usPeerPortNumber,
+				( uint32_t ) pxWindow->uxSegmentHighWater,
+				( uint32_t ) pxWindow->uxSegmentQuota ) );
+		}
 	}
 
 #endif /* ipconfigUSE_TCP_WIN == 1 */
@@ -592,7 +809,7 @@ void vTCPWindowCreate( TCPWindow_t *pxWindow, uint32_t ulRxWindowLength,
 
 	#if( ipconfigUSE_TCP_WIN == 1 )
 	{
-		if( xTCPSegments == NULL )
+		if( uxSegmentChunkCount == 0u )
 		{
 			prvCreateSectors();
 		}
@@ -648,6 +865,12 @@ const int32_t l500ms = 500;
 
 	/*Start with a timeout of 2 * 500 ms (1 sec). */
 	pxWindow->lSRTT = l500ms;
+	pxWindow->ulRetransmitCount = 0ul;
+
+	/* RFC 6298 (2.1): until a RTT measurement has been made, the RTO is set
+	to 1 second. */
+	pxWindow->lRTTVar = 0;
+	pxWindow->lRTO = 2 * l500ms;
 
 	/* Just for logging, to print relative sequence numbers. */
 	pxWindow->rx.ulFirstSequenceNumber = ulAckNumber;
@@ -670,9 +893,78 @@ const int32_t l500ms = 500;
 	/* The right-hand side of the transmit window. */
 	pxWindow->tx.ulHighestSequenceNumber = ulSequenceNumber;
 	pxWindow->ulOurSequenceNumber = ulSequenceNumber;
+
+	#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+	{
+		prvTCPCongestionInit( pxWindow );
+	}
+	#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+}
+/*-----------------------------------------------------------*/
+
+void vTCPWindowRTTSample( TCPWindow_t *pxWindow, uint32_t ulRTT )
+{
+int32_t lRTT, lDelta, lRTO;
+
+	/* The clock has a granularity of one tick, a sample of 0 ms is possible
+	on a fast network. */
+	lRTT = ( int32_t ) FreeRTOS_min_uint32( ulRTT, ( uint32_t ) ipconfigTCP_RTO_MAX_MS );
+
+	if( pxWindow->u.bits.bRTTMeasured == pdFALSE_UNSIGNED )
+	{
+		/* RFC 6298 (2.2): the first measurement. */
+		pxWindow->lSRTT = lRTT;
+		pxWindow->lRTTVar = lRTT / 2;
+		pxWindow->u.bits.bRTTMeasured = pdTRUE_UNSIGNED;
+	}
+	else
+	{
+		/* RFC 6298 (2.3): RTTVAR = 3/4 * RTTVAR + 1/4 * | SRTT - R |
+		                   SRTT = 7/8 * SRTT + 1/8 * R */
+		lDelta = pxWindow->lSRTT - lRTT;
+		if( lDelta < 0 )
+		{
+			lDelta = -lDelta;
+		}
+		pxWindow->lRTTVar = ( ( 3 * pxWindow->lRTTVar ) + lDelta + 2 ) / 4;
+		pxWindow->lSRTT = ( ( 7 * pxWindow->lSRTT ) + lRTT + 4 ) / 8;
+	}
+
+	/* RTO = SRTT + max( G, 4 * RTTVAR ), where G is the clock granularity. */
+	lRTO = pxWindow->lSRTT + FreeRTOS_max_int32( ( int32_t ) portTICK_PERIOD_MS, 4 * pxWindow->lRTTVar );
+	lRTO = FreeRTOS_max_int32( lRTO, ( int32_t ) ipconfigTCP_RTO_MIN_MS );
+	pxWindow->lRTO = FreeRTOS_min_int32( lRTO, ( int32_t ) ipconfigTCP_RTO_MAX_MS );
+
+	/* lSRTT is also used to divide by, e.g. by the congestion control. */
+	if( pxWindow->lSRTT < 1 )
+	{
+		pxWindow->lSRTT = 1;
+	}
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static uint32_t prvTCPWindowRetransmitTime( const TCPWindow_t *pxWindow, const TCPSegment_t *pxSegment )
+	{
+	uint32_t ulReturn;
+	uint32_t ulShift = pxSegment->u.bits.ucTransmitCount;
+
+		/* RFC 6298 (5.5): the RTO is doubled after every retransmission.
+		'ucTransmitCount' has a minimum of 1 for an outstanding segment. */
+		if( ulShift > 0u )
+		{
+			ulShift--;
+		}
+		ulShift = FreeRTOS_min_uint32( ulShift, 16u );
+		ulReturn = FreeRTOS_min_uint32( ( ( uint32_t ) pxWindow->lRTO ) << ulShift, ( uint32_t ) ipconfigTCP_RTO_MAX_MS );
+
+		return ulReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP_WIN == 1 )
 
     void vTCPSegmentCleanup( void )
@@ -680,16 +972,42 @@ const int32_t l500ms = 500;
         /* Free and clear the TCP segments pointer. This function should only be called
          * once FreeRTOS+TCP will no longer be used. No thread-safety is provided for this
          * function. */
-        if( xTCPSegments != NULL )
+        while( uxSegmentChunkCount > 0u )
         {
-            vPortFreeLarge( xTCPSegments );
-            xTCPSegments = NULL;
+            uxSegmentChunkCount--;
+            vPortFreeLarge( pxTCPSegmentChunks[ uxSegmentChunkCount ] );
+            pxTCPSegmentChunks[ uxSegmentChunkCount ] = NULL;
         }
+        xSegmentStats.uxTotal = 0u;
     }
 
 #endif /* ipconfgiUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	void vTCPWindowGetSegmentStats( TCPSegmentStats_t *pxStats )
+	{
+		/* The statistics are updated by the IP-task, make sure that it will
+		not run while they're being copied. */
+		vTaskSuspendAll();
+		{
+			*pxStats = xSegmentStats;
+			if( uxSegmentChunkCount != 0u )
+			{
+				pxStats->uxFree = listCURRENT_LIST_LENGTH( &xSegmentList );
+			}
+			else
+			{
+				pxStats->uxFree = 0u;
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
 /*=============================================================================
  *
  *                ######        #    #
@@ -816,7 +1134,7 @@ const int32_t l500ms = 500;
                         if ( pxFound != NULL )
                         {
                             /* Remove it because it will be passed to user directly. */
-                            vTCPWindowFree( pxFound );
+                            vTCPWindowFree( pxWindow, pxFound );
                         }
                     } while ( pxFound );
 
@@ -828,7 +1146,7 @@ const int32_t l500ms = 500;
 
 						/* As all packet below this one have been passed to the
 						user it can be discarded. */
-						vTCPWindowFree( pxFound );
+						vTCPWindowFree( pxWindow, pxFound );
 					}
 
 					if( ulSavedSequenceNumber != ulCurrentSequenceNumber )
@@ -970,6 +1288,448 @@ const int32_t l500ms = 500;
 #endif /* ipconfgiUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+/*=============================================================================
+ *
+ * Congestion control
+ *
+ * The sliding window will not have more than 'ulCWnd' bytes outstanding.
+ * The window grows with slow start until 'ulSSThresh' is reached, after which
+ * the selected algorithm (NewReno or CUBIC) decides how it grows further.
+ *
+ *=============================================================================*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static const TCPCongestionOps_t *prvTCPCongestionFind( uint8_t ucAlgorithm )
+	{
+	const TCPCongestionOps_t *pxOps;
+
+		switch( ucAlgorithm )
+		{
+		case FREERTOS_TCP_CC_NEWRENO:
+			pxOps = &xNewRenoOps;
+			break;
+		case FREERTOS_TCP_CC_CUBIC:
+			pxOps = &xCubicOps;
+			break;
+		default:
+			pxOps = NULL;
+			break;
+		}
+
+		return pxOps;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	BaseType_t xTCPWindowSetCongestionControl( TCPWindow_t *pxWindow, uint8_t ucAlgorithm )
+	{
+	BaseType_t xReturn;
+
+		/* Only the choice is stored here, the algorithm will be initialised
+		by vTCPWindowInit(). */
+		if( prvTCPCongestionFind( ucAlgorithm ) != NULL )
+		{
+			pxWindow->xCongestion.ucAlgorithm = ucAlgorithm;
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			xReturn = pdFALSE;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvTCPCongestionInit( TCPWindow_t *pxWindow )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+
+		pxCongestion->pxOps = prvTCPCongestionFind( pxCongestion->ucAlgorithm );
+
+		if( pxCongestion->pxOps == NULL )
+		{
+			pxCongestion->pxOps = prvTCPCongestionFind( ( uint8_t ) ipconfigTCP_CONGESTION_CONTROL_DEFAULT );
+			configASSERT( pxCongestion->pxOps != NULL );
+		}
+
+		/* RFC 3390: the initial window. */
+		pxCongestion->ulCWnd = FreeRTOS_min_uint32( 4u * ulMSS, FreeRTOS_max_uint32( 2u * ulMSS, tcpCC_INITIAL_WINDOW_BYTES ) );
+
+		/* The slow start threshold starts arbitrarily high, it will be set
+		after the first loss. */
+		pxCongestion->ulSSThresh = 0xFFFFFFFFUL;
+		pxCongestion->ulBytesAcked = 0UL;
+		pxCongestion->ulRecoverSequenceNumber = pxWindow->tx.ulCurrentSequenceNumber;
+		pxCongestion->u.bits.bInRecovery = pdFALSE_UNSIGNED;
+		vTCPTimerSet( &( pxCongestion->xPaceTimer ) );
+
+		pxCongestion->pxOps->pxInit( pxWindow );
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	void vTCPWindowCongestionStart( TCPWindow_t *pxWindow )
+	{
+		/* vTCPWindowInit() was called before the options of the SYN or
+		SYN+ACK were known.  When the peer announced a smaller MSS, the
+		initial window would be too large. */
+		prvTCPCongestionInit( pxWindow );
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvTCPCongestionAck( TCPWindow_t *pxWindow, uint32_t ulBytesAcked )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+
+		if( pxCongestion->u.bits.bInRecovery != pdFALSE_UNSIGNED )
+		{
+			if( xSequenceGreaterThanOrEqual( pxWindow->tx.ulCurrentSequenceNumber, pxCongestion->ulRecoverSequenceNumber ) != pdFALSE )
+			{
+				/* All data that was outstanding at the moment of the loss
+				has been ACK'd: fast recovery ends (RFC 6582). */
+				pxCongestion->u.bits.bInRecovery = pdFALSE_UNSIGNED;
+				pxCongestion->ulCWnd = FreeRTOS_max_uint32( pxCongestion->ulSSThresh, ulMSS );
+			}
+			else
+			{
+				/* A partial ACK.  The retransmission of the next hole is
+				taken care of by the SACK administration, the window does not
+				grow. */
+			}
+		}
+		else if( pxCongestion->ulCWnd < pxCongestion->ulSSThresh )
+		{
+			/* Slow start. */
+			pxCongestion->ulCWnd += FreeRTOS_min_uint32( ulBytesAcked, tcpCC_SLOW_START_MAX_MSS_PER_ACK * ulMSS );
+		}
+		else
+		{
+			pxCongestion->pxOps->pxCongestionAvoid( pxWindow, ulBytesAcked );
+		}
+
+		/* The congestion window is of no use when it is larger than the self-
+		imposed transmission window. */
+		if( pxCongestion->ulCWnd > pxWindow->xSize.ulTxWindowLength )
+		{
+			pxCongestion->ulCWnd = FreeRTOS_max_uint32( pxWindow->xSize.ulTxWindowLength, ulMSS );
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvTCPCongestionLoss( TCPWindow_t *pxWindow, BaseType_t xIsTimeout )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+
+		/* The window is reduced only once for the data that was outstanding
+		at the moment a loss was detected, other losses within the same window
+		are a result of the same congestion event. */
+		if( ( pxCongestion->u.bits.bInRecovery == pdFALSE_UNSIGNED ) &&
+			( xSequenceGreaterThanOrEqual( pxWindow->tx.ulCurrentSequenceNumber, pxCongestion->ulRecoverSequenceNumber ) != pdFALSE ) )
+		{
+			pxCongestion->ulSSThresh = pxCongestion->pxOps->pxSSThresh( pxWindow );
+			pxCongestion->ulRecoverSequenceNumber = pxWindow->tx.ulHighestSequenceNumber;
+			pxCongestion->ulBytesAcked = 0UL;
+
+			if( xIsTimeout == pdFALSE )
+			{
+				/* Enter fast recovery. */
+				pxCongestion->ulCWnd = pxCongestion->ulSSThresh;
+				pxCongestion->u.bits.bInRecovery = pdTRUE_UNSIGNED;
+			}
+
+			if( ( xTCPWindowLoggingLevel != 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != pdFALSE ) )
+			{
+				FreeRTOS_debug_printf( ( "prvTCPCongestionLoss[%u,%u]: %s after %s: ssthresh %lu\n",
+					pxWindow->usPeerPortNumber,
+					pxWindow->usOurPortNumber,
+					pxCongestion->pxOps->pcName,
+					( xIsTimeout != pdFALSE ) ? "RTO" : "fast rexmit",
+					pxCongestion->ulSSThresh ) );
+			}
+		}
+
+		if( xIsTimeout != pdFALSE )
+		{
+			/* RFC 5681: after a retransmission time-out, start all over with a
+			loss window of 1 MSS, fast recovery is abandoned. */
+			pxCongestion->ulCWnd = ( uint32_t ) pxWindow->usMSS;
+			pxCongestion->u.bits.bInRecovery = pdFALSE_UNSIGNED;
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static uint32_t prvTCPCongestionPaceDelay( TCPWindow_t *pxWindow, uint32_t ulLength )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulInterval, ulAge, ulGain;
+	uint32_t ulReturn = 0UL;
+
+		if( pxCongestion->u.bits.bPacing != pdFALSE_UNSIGNED )
+		{
+			if( pxCongestion->ulCWnd < pxCongestion->ulSSThresh )
+			{
+				ulGain = tcpPACING_GAIN_SLOW_START;
+			}
+			else
+			{
+				ulGain = tcpPACING_GAIN_CONGESTION_AVOID;
+			}
+
+			/* The number of ms needed to send 'ulLength' bytes at a rate of
+			( gain * cwnd / SRTT ).  When it is less than a clock tick, the
+			segments will still be sent in small bursts. */
+			ulInterval = ( uint32_t ) ( ( ( uint64_t ) ulLength * ( uint64_t ) pxWindow->lSRTT * 100u ) /
+				( ( uint64_t ) pxCongestion->ulCWnd * ulGain ) );
+			ulAge = ulTimerGetAge( &( pxCongestion->xPaceTimer ) );
+
+			if( ulInterval > ulAge )
+			{
+				ulReturn = ulInterval - ulAge;
+			}
+		}
+
+		return ulReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvTCPCongestionGrow( TCPWindow_t *pxWindow, uint32_t ulBytesAcked, uint32_t ulBytesPerMSS )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+
+		/* Appropriate Byte Counting (RFC 3465): count the bytes that are ACK'd
+		in stead of the number of ACK's, which would favour a peer that sends
+		many small ACK's. */
+		pxCongestion->ulBytesAcked += ulBytesAcked;
+
+		if( pxCongestion->ulBytesAcked >= ulBytesPerMSS )
+		{
+			pxCongestion->ulBytesAcked -= ulBytesPerMSS;
+			pxCongestion->ulCWnd += ( uint32_t ) pxWindow->usMSS;
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvNewRenoInit( TCPWindow_t *pxWindow )
+	{
+		/* NewReno has no state of its own. */
+		( void ) pxWindow;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvNewRenoCongestionAvoid( TCPWindow_t *pxWindow, uint32_t ulBytesAcked )
+	{
+		/* RFC 5681: grow with 1 MSS per RTT, i.e. every time that a whole
+		congestion window has been ACK'd. */
+		prvTCPCongestionGrow( pxWindow, ulBytesAcked, pxWindow->xCongestion.ulCWnd );
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static uint32_t prvNewRenoSSThresh( TCPWindow_t *pxWindow )
+	{
+	uint32_t ulFlightSize = 0UL;
+
+		if( xSequenceGreaterThan( pxWindow->tx.ulHighestSequenceNumber, pxWindow->tx.ulCurrentSequenceNumber ) != pdFALSE )
+		{
+			ulFlightSize = pxWindow->tx.ulHighestSequenceNumber - pxWindow->tx.ulCurrentSequenceNumber;
+		}
+
+		/* RFC 5681: ssthresh = max( FlightSize / 2, 2 * MSS ) */
+		return FreeRTOS_max_uint32( ulFlightSize / 2u, 2u * ( uint32_t ) pxWindow->usMSS );
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvCubicInit( TCPWindow_t *pxWindow )
+	{
+		pxWindow->xCongestion.ulWMax = 0UL;
+		pxWindow->xCongestion.u.bits.bEpochStarted = pdFALSE_UNSIGNED;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static void prvCubicCongestionAvoid( TCPWindow_t *pxWindow, uint32_t ulBytesAcked )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulMSS = ( uint32_t ) pxWindow->usMSS;
+	uint32_t ulCWnd = pxCongestion->ulCWnd;
+	uint32_t ulEpochAge, ulTime, ulTarget, ulFriendly, ulBytesPerMSS;
+	int64_t llOffset, llTarget;
+
+		if( pxCongestion->u.bits.bEpochStarted == pdFALSE_UNSIGNED )
+		{
+			/* A new epoch starts after a loss, or when leaving slow start. */
+			pxCongestion->u.bits.bEpochStarted = pdTRUE_UNSIGNED;
+			vTCPTimerSet( &( pxCongestion->xEpochTimer ) );
+			pxCongestion->ulEpochCWnd = ulCWnd;
+
+			if( ulCWnd < pxCongestion->ulWMax )
+			{
+				/* K = cbrt( ( W_max - cwnd ) / C ), expressed in ms. */
+				pxCongestion->ulK = prvCubeRoot( ( ( uint64_t ) ( pxCongestion->ulWMax - ulCWnd ) * tcpCUBIC_1E9_DIV_C ) / ulMSS );
+				pxCongestion->ulK = FreeRTOS_min_uint32( pxCongestion->ulK, tcpCUBIC_MAX_EPOCH_MS );
+				pxCongestion->ulOriginPoint = pxCongestion->ulWMax;
+			}
+			else
+			{
+				pxCongestion->ulK = 0UL;
+				pxCongestion->ulOriginPoint = ulCWnd;
+			}
+		}
+
+		ulEpochAge = FreeRTOS_min_uint32( ulTimerGetAge( &( pxCongestion->xEpochTimer ) ), tcpCUBIC_MAX_EPOCH_MS );
+
+		/* The target is the size of the window one RTT from now:
+		W_cubic( t ) = C * ( t - K )^3 + W_max.
+		In bytes and ms this becomes: MSS * ( t - K )^3 / ( 1e9 / C ). */
+		ulTime = FreeRTOS_min_uint32( ulEpochAge + ( uint32_t ) pxWindow->lSRTT, tcpCUBIC_MAX_EPOCH_MS );
+		llOffset = ( int64_t ) ulTime - ( int64_t ) pxCongestion->ulK;
+		llTarget = ( ( ( llOffset * llOffset * llOffset ) / 1000 ) * ( int64_t ) ulMSS ) / ( int64_t ) ( tcpCUBIC_1E9_DIV_C / 1000u );
+		llTarget += ( int64_t ) pxCongestion->ulOriginPoint;
+
+		if( llTarget < ( int64_t ) ulCWnd )
+		{
+			ulTarget = ulCWnd;
+		}
+		else if( llTarget > ( int64_t ) ( ulCWnd + ( ulCWnd / 2u ) ) )
+		{
+			/* Do not grow more than 50% per RTT. */
+			ulTarget = ulCWnd + ( ulCWnd / 2u );
+		}
+		else
+		{
+			ulTarget = ( uint32_t ) llTarget;
+		}
+
+		/* The TCP-friendly region: make sure that CUBIC grows at least as fast
+		as standard TCP would: W_est = cwnd_epoch + 3 * ( 1 - beta ) / ( 1 + beta ) * t / RTT,
+		where 3 * 0.3 / 1.7 = 9 / 17. */
+		ulFriendly = pxCongestion->ulEpochCWnd +
+			( uint32_t ) ( ( ( uint64_t ) ulMSS * ulEpochAge * tcpCUBIC_FRIENDLY_NUMERATOR ) /
+				( ( uint64_t ) tcpCUBIC_FRIENDLY_DENOMINATOR * ( uint32_t ) pxWindow->lSRTT ) );
+
+		if( ulFriendly > ulTarget )
+		{
+			ulTarget = FreeRTOS_min_uint32( ulFriendly, ulCWnd + ( ulCWnd / 2u ) );
+		}
+
+		if( ulTarget > ulCWnd )
+		{
+			/* Reach the target within one RTT. */
+			ulBytesPerMSS = ( uint32_t ) ( ( ( uint64_t ) ulCWnd * ulMSS ) / ( ulTarget - ulCWnd ) );
+		}
+		else
+		{
+			/* Close to W_max, grow very slowly. */
+			ulBytesPerMSS = ( uint32_t ) FreeRTOS_min_uint32( ulCWnd, 0xFFFFFFFFUL / tcpCUBIC_MIN_GROWTH_FACTOR ) * tcpCUBIC_MIN_GROWTH_FACTOR;
+		}
+
+		prvTCPCongestionGrow( pxWindow, ulBytesAcked, ulBytesPerMSS );
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static uint32_t prvCubicSSThresh( TCPWindow_t *pxWindow )
+	{
+	TCPCongestion_t *pxCongestion = &( pxWindow->xCongestion );
+	uint32_t ulCWnd = pxCongestion->ulCWnd;
+
+		/* A new epoch will start as soon as the window grows again. */
+		pxCongestion->u.bits.bEpochStarted = pdFALSE_UNSIGNED;
+
+		if( ulCWnd < pxCongestion->ulWMax )
+		{
+			/* Fast convergence: the previous W_max was not reached, release
+			some bandwidth for new flows. */
+			pxCongestion->ulWMax = ( uint32_t ) ( ( ( uint64_t ) ulCWnd * tcpCUBIC_FAST_CONV_NUMERATOR ) / tcpCUBIC_FAST_CONV_DENOMINATOR );
+		}
+		else
+		{
+			pxCongestion->ulWMax = ulCWnd;
+		}
+
+		return FreeRTOS_max_uint32( ( uint32_t ) ( ( ( uint64_t ) ulCWnd * tcpCUBIC_BETA_NUMERATOR ) / tcpCUBIC_BETA_DENOMINATOR ),
+			2u * ( uint32_t ) pxWindow->usMSS );
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+
+	static uint32_t prvCubeRoot( uint64_t ullValue )
+	{
+	uint64_t ullRoot = 0u, ullCandidate;
+	BaseType_t xBit;
+
+		/* Determine the root bit by bit.  The result is limited to 21 bits, so
+		the cube of a candidate can not overflow. */
+		for( xBit = 20; xBit >= 0; xBit-- )
+		{
+			ullCandidate = ullRoot | ( ( uint64_t ) 1u << xBit );
+
+			if( ( ullCandidate * ullCandidate * ullCandidate ) <= ullValue )
+			{
+				ullRoot = ullCandidate;
+			}
+		}
+
+		return ( uint32_t ) ullRoot;
+	}
+
+#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+/*-----------------------------------------------------------*/
+
 /*=============================================================================
  *
  *                    #########   #    #
@@ -1187,6 +1947,16 @@ const int32_t l500ms = 500;
 			{
 				xHasSpace = pdFALSE;
 			}
+
+			#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+			{
+				/* The congestion window limits the number of bytes in flight. */
+				if( ( ulTxOutstanding != 0UL ) && ( pxWindow->xCongestion.ulCWnd < ulTxOutstanding + ( ( uint32_t ) pxSegment->lDataLength ) ) )
+				{
+					xHasSpace = pdFALSE;
+				}
+			}
+			#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
 		}
 
 		return xHasSpace;
@@ -1221,11 +1991,7 @@ const int32_t l500ms = 500;
 				/* There is an outstanding segment, see if it is time to resend
 				it. */
 				ulAge = ulTimerGetAge( &pxSegment->xTransmitTimer );
-
-				/* After a packet has been sent for the first time, it will wait
-				'1 * lSRTT' ms for an ACK. A second time it will wait '2 * lSRTT' ms,
-				each time doubling the time-out */
-				ulMaxAge = ( 1u << pxSegment->u.bits.ucTransmitCount ) * ( ( uint32_t ) pxWindow->lSRTT );
+				ulMaxAge = prvTCPWindowRetransmitTime( pxWindow, pxSegment );
 
 				if( ulMaxAge > ulAge )
 				{
@@ -1233,6 +1999,23 @@ const int32_t l500ms = 500;
 					*pulDelay = ulMaxAge - ulAge;
 				}
 
+				#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+				{
+				TCPSegment_t *pxNewSegment = xTCPWindowPeekHead( &( pxWindow->xTxQueue ) );
+
+					/* With pacing, new segments are not sent in a burst as soon
+					as an ACK comes in.  Make sure that the IP-task wakes up in
+					time to send the next one. */
+					if( ( pxWindow->xCongestion.u.bits.bPacing != pdFALSE_UNSIGNED ) &&
+						( pxNewSegment != NULL ) &&
+						( ( pxWindow->u.bits.bSendFullSize == pdFALSE_UNSIGNED ) || ( pxNewSegment->lDataLength >= pxNewSegment->lMaxLength ) ) &&
+						( prvTCPWindowTxHasSpace( pxWindow, ulWindowSize ) != pdFALSE ) )
+					{
+						*pulDelay = FreeRTOS_min_uint32( *pulDelay, prvTCPCongestionPaceDelay( pxWindow, ( uint32_t ) pxNewSegment->lDataLength ) );
+					}
+				}
+				#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 				xReturn = pdTRUE;
 			}
 			else
@@ -1260,6 +2043,12 @@ const int32_t l500ms = 500;
 				}
 				else
 				{
+					#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+					{
+						/* When pacing is used, the segment may have to wait. */
+						*pulDelay = prvTCPCongestionPaceDelay( pxWindow, ( uint32_t ) pxSegment->lDataLength );
+					}
+					#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
 					xReturn = pdTRUE;
 				}
 			}
@@ -1297,7 +2086,7 @@ const int32_t l500ms = 500;
 			if( pxSegment != NULL )
 			{
 				/* Do check the timing. */
-				ulMaxTime = ( 1u << pxSegment->u.bits.ucTransmitCount ) * ( ( uint32_t ) pxWindow->lSRTT );
+				ulMaxTime = prvTCPWindowRetransmitTime( pxWindow, pxSegment );
 
 				if( ulTimerGetAge( &pxSegment->xTransmitTimer ) > ulMaxTime )
 				{
@@ -1306,6 +2095,12 @@ const int32_t l500ms = 500;
 					pxSegment = xTCPWindowGetHead( &( pxWindow->xWaitQueue ) );
 					pxSegment->u.bits.ucDupAckCount = pdFALSE_UNSIGNED;
 
+					#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+					{
+						prvTCPCongestionLoss( pxWindow, pdTRUE );
+					}
+					#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 					/* Some detailed logging. */
 					if( ( xTCPWindowLoggingLevel != 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) != 0 ) )
 					{
@@ -1346,11 +2141,24 @@ const int32_t l500ms = 500;
 					/* Peer has no more space at this moment. */
 					ulReturn = 0;
 				}
+				#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+				else if( prvTCPCongestionPaceDelay( pxWindow, ( uint32_t ) pxSegment->lDataLength ) != 0UL )
+				{
+					/* Pacing: it is too early to send a new segment. */
+					ulReturn = 0;
+				}
+				#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
 				else
 				{
 					/* Move it out of the Tx queue. */
 					pxSegment = xTCPWindowGetHead( &( pxWindow->xTxQueue ) );
 
+					#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+					{
+						vTCPTimerSet( &( pxWindow->xCongestion.xPaceTimer ) );
+					}
+					#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 					/* Don't let pxHeadSegment point to this segment any more,
 					so no more data will be added. */
 					if( pxWindow->pxHeadSegment == pxSegment )
@@ -1408,8 +2216,16 @@ const int32_t l500ms = 500;
 			retransmissions. */
 			( pxSegment->u.bits.ucTransmitCount )++;
 
+			if( pxSegment->u.bits.ucTransmitCount > 1u )
+			{
+				pxWindow->ulRetransmitCount++;
+			}
+
 			/* If there have been several retransmissions (4), decrease the
-			size of the transmission window to at most 2 times MSS. */
+			size of the transmission window to at most 2 times MSS.  When
+			congestion control is used, the congestion window has already
+			been reduced and will be allowed to grow again. */
+			#if( ipconfigUSE_TCP_CONGESTION_CONTROL == 0 )
 			if( pxSegment->u.bits.ucTransmitCount == MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW )
 			{
 				if( pxWindow->xSize.ulTxWindowLength > ( 2U * pxWindow->usMSS ) )
@@ -1420,6 +2236,7 @@ const int32_t l500ms = 500;
 					pxWindow->xSize.ulTxWindowLength = ( 2UL * pxWindow->usMSS );
 				}
 			}
+			#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
 
 			/* Clear the transmit timer. */
 			vTCPTimerSet( &( pxSegment->xTransmitTimer ) );
@@ -1456,19 +2273,11 @@ const int32_t l500ms = 500;
 		contiguous block.  Note that the segments are stored in xTxSegments in a
 		strict sequential order. */
 
-		/* SRTT[i] = (1-a) * SRTT[i-1] + a * RTT
-
-		0 < a < 1; usually a = 1/8
-
-		RTO = 2 * SRTT
-
-		where:
-		  RTT is Round Trip Time
-		  SRTT is Smoothed RTT
-		  RTO is Retransmit timeout
-
-		 A Smoothed RTT will increase quickly, but it is conservative when
-		 becoming smaller. */
+		/* Every ACK that confirms a segment which was sent only once gives an
+		RTT sample, from which vTCPWindowRTTSample() calculates SRTT, RTTVAR
+		and the RTO as described in RFC 6298.  A retransmitted segment gives
+		no sample, because it is not known which transmission is ACK'd (Karn's
+		algorithm). */
 
 		for(
 				pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
@@ -1528,22 +2337,20 @@ const int32_t l500ms = 500;
 				{
 					int32_t mS = ( int32_t ) ulTimerGetAge( &( pxSegment->xTransmitTimer ) );
 
-					if( pxWindow->lSRTT >= mS )
-					{
-						/* RTT becomes smaller: adapt slowly. */
-						pxWindow->lSRTT = ( ( winSRTT_DECREMENT_NEW * mS ) + ( winSRTT_DECREMENT_CURRENT * pxWindow->lSRTT ) ) / ( winSRTT_DECREMENT_NEW + winSRTT_DECREMENT_CURRENT );
-					}
-					else
+					#if( ipconfigUSE_TCP_TIMESTAMPS != 0 )
 					{
-						/* RTT becomes larger: adapt quicker */
-						pxWindow->lSRTT = ( ( winSRTT_INCREMENT_NEW * mS ) + ( winSRTT_INCREMENT_CURRENT * pxWindow->lSRTT ) ) / ( winSRTT_INCREMENT_NEW + winSRTT_INCREMENT_CURRENT );
+						/* When time-stamps are in use, the RTT samples are
+						taken from the echoed time-stamps. */
+						if( pxWindow->u.bits.bTimeStamps == pdFALSE_UNSIGNED )
+						{
+							vTCPWindowRTTSample( pxWindow, ( uint32_t ) mS );
+						}
 					}
-
-					/* Cap to the minimum of 50ms. */
-					if( pxWindow->lSRTT < winSRTT_CAP_mS )
+					#else
 					{
-						pxWindow->lSRTT = winSRTT_CAP_mS;
+						vTCPWindowRTTSample( pxWindow, ( uint32_t ) mS );
 					}
+					#endif /* ipconfigUSE_TCP_TIMESTAMPS */
 				}
 
 				/* Unlink it from the 3 queues, but do not destroy it (yet). */
@@ -1570,7 +2377,7 @@ const int32_t l500ms = 500;
 				ulBytesConfirmed += ulDataLength;
 
 				/* All segments below tx.ulCurrentSequenceNumber may be freed. */
-				vTCPWindowFree( pxSegment );
+				vTCPWindowFree( pxWindow, pxSegment );
 
 				/* No need to unlink it any more. */
 				xDoUnlink = pdFALSE;
@@ -1585,6 +2392,15 @@ const int32_t l500ms = 500;
 			ulSequenceNumber += ulDataLength;
 		}
 
+		#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+		{
+			if( ulBytesConfirmed != 0UL )
+			{
+				prvTCPCongestionAck( pxWindow, ulBytesConfirmed );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 		return ulBytesConfirmed;
 	}
 #endif /* ipconfigUSE_TCP_WIN == 1 */
@@ -1621,7 +2437,10 @@ const int32_t l500ms = 500;
 				( xSequenceLessThan( pxSegment->ulSequenceNumber, ulFirst ) != pdFALSE ) &&
 				( ++( pxSegment->u.bits.ucDupAckCount ) == DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) )
 			{
+				/* The transmit count starts again, so the retransmission is
+				counted here. */
 				pxSegment->u.bits.ucTransmitCount = pdFALSE_UNSIGNED;
+				pxWindow->ulRetransmitCount++;
 
 				/* Not clearing 'ucDupAckCount' yet as more SACK's might come in
 				which might lead to a second fast rexmit. */
@@ -1643,6 +2462,15 @@ const int32_t l500ms = 500;
 			}
 		}
 
+		#if( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+		{
+			if( ulCount != 0UL )
+			{
+				prvTCPCongestionLoss( pxWindow, pdFALSE );
+			}
+		}
+		#endif /* ipconfigUSE_TCP_CONGESTION_CONTROL */
+
 		return ulCount;
 	}
 #endif /* ipconfigUSE_TCP_WIN == 1 */
@@ -1822,6 +2650,12 @@ const int32_t l500ms = 500;
 			{
 				pxSegment->u.bits.bOutstanding = pdTRUE_UNSIGNED;
 				pxSegment->u.bits.ucTransmitCount++;
+
+				if( pxSegment->u.bits.ucTransmitCount > 1u )
+				{
+					pxWindow->ulRetransmitCount++;
+				}
+
 				vTCPTimerSet (&pxSegment->xTransmitTimer);
 				pxWindow->ulOurSequenceNumber = pxSegment->ulSequenceNumber;
 				*plPosition = pxSegment->lStreamPos;
@@ -50,6 +50,14 @@
 /* The expected IP version and header length coded into the IP header itself. */
 #define ipIP_VERSION_AND_HEADER_LENGTH_BYTE ( ( uint8_t ) 0x45 )
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/*
+	 * Send a packet that is longer than the MTU as a series of IP fragments,
+	 * each in a network buffer of its own.  The packet is released.
+	 */
+	static void prvSendIPFragments( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+#endif
+
 /* Part of the Ethernet and IP headers are always constant when sending an IPv4
 UDP packet.  This array defines the constant parts, allowing this part of the
 packet to be filled in using a simple memcpy() instead of individual writes. */
@@ -104,6 +112,9 @@ size_t uxPayloadSize;
 			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 				uint8_t ucSocketOptions;
 			#endif
+			#if( ipconfigUSE_DSCP != 0 )
+				uint8_t ucDSCP;
+			#endif
 			iptraceSENDING_UDP_PACKET( pxNetworkBuffer->ulIPAddress );
 
 			/* Create short cuts to the data within the packet. */
@@ -144,6 +155,9 @@ size_t uxPayloadSize;
 			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 				ucSocketOptions = pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ];
 			#endif
+			#if( ipconfigUSE_DSCP != 0 )
+				ucDSCP = pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_DSCP_OFFSET ];
+			#endif
 			/*
 			 * Offset the memcpy by the size of a MAC address to start at the packet's
 			 * Ethernet header 'source' MAC address; the preceding 'destination' should not be altered.
@@ -167,6 +181,13 @@ size_t uxPayloadSize;
 			/* HT:endian: changed back to network endian */
 			pxIPHeader->ulDestinationIPAddress = pxNetworkBuffer->ulIPAddress;
 
+			#if( ipconfigUSE_DSCP != 0 )
+			{
+				/* The DSCP occupies the upper 6 bits, the ECN bits stay 0. */
+				pxIPHeader->ucDifferentiatedServicesCode = ( uint8_t ) ( ucDSCP << 2 );
+			}
+			#endif
+
 			#if( ipconfigUSE_LLMNR == 1 )
 			{
 				/* LLMNR messages are typically used on a LAN and they're
@@ -215,6 +236,15 @@ size_t uxPayloadSize;
 		}
 	}
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	if( ( eReturned != eCantSendPacket ) &&
+		( pxNetworkBuffer->xDataLength > ( size_t ) ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ) ) )
+	{
+		/* The packet does not fit in a single frame. */
+		prvSendIPFragments( pxNetworkBuffer );
+	}
+	else
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
 	if( eReturned != eCantSendPacket )
 	{
 		/* The network driver is responsible for freeing the network buffer
@@ -235,7 +265,7 @@ size_t uxPayloadSize;
 		}
 		#endif
 
-		xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+		ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, pdTRUE );
 	}
 	else
 	{
@@ -246,6 +276,85 @@ size_t uxPayloadSize;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+
+	static void prvSendIPFragments( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+	{
+	NetworkBufferDescriptor_t *pxFragment;
+	IPHeader_t *pxIPHeader = &( ( ( IPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer )->xIPHeader );
+	/* All fragments but the last carry a multiple of 8 bytes. */
+	const size_t uxMaxLength = ( ( size_t ) ( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER ) ) & ~( ( size_t ) 0x07u );
+	size_t uxTotalLength = ( size_t ) FreeRTOS_ntohs( pxIPHeader->usLength ) - ipSIZE_OF_IPv4_HEADER;
+	size_t uxOffset, uxLength;
+	uint16_t usIdentification, usFragmentOffset;
+
+		#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM != 0 )
+		{
+			/* The driver can not calculate a checksum that covers more than
+			one frame. */
+			usGenerateProtocolChecksum( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdTRUE );
+		}
+		#endif
+
+		/* All fragments carry the same identification. */
+		usIdentification = FreeRTOS_htons( usPacketIdentifier );
+		usPacketIdentifier++;
+
+		for( uxOffset = 0u; uxOffset < uxTotalLength; uxOffset += uxLength )
+		{
+			uxLength = uxTotalLength - uxOffset;
+
+			if( uxLength > uxMaxLength )
+			{
+				uxLength = uxMaxLength;
+			}
+
+			pxFragment = pxGetNetworkBufferWithDescriptor( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + uxLength, ( TickType_t ) 0u );
+
+			if( pxFragment == NULL )
+			{
+				/* The datagram can not be reassembled without this fragment,
+				so there is no point in sending the others. */
+				FreeRTOS_debug_printf( ( "prvSendIPFragments: no buffer at offset %lu\n", ( uint32_t ) uxOffset ) );
+				break;
+			}
+
+			pxFragment->xDataLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + uxLength;
+			pxFragment->ulIPAddress = pxNetworkBuffer->ulIPAddress;
+			pxFragment->usPort = pxNetworkBuffer->usPort;
+			pxFragment->usBoundPort = pxNetworkBuffer->usBoundPort;
+
+			/* The Ethernet and IP headers are copied from the packet, followed
+			by the next part of its payload. */
+			memcpy( pxFragment->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER );
+			memcpy( &( pxFragment->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER ] ),
+					&( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + uxOffset ] ),
+					uxLength );
+
+			usFragmentOffset = ( uint16_t ) ( uxOffset >> 3 );
+
+			if( ( uxOffset + uxLength ) < uxTotalLength )
+			{
+				usFragmentOffset |= ipFRAGMENT_FLAGS_MORE_FRAGMENTS;
+			}
+
+			pxIPHeader = &( ( ( IPPacket_t * ) pxFragment->pucEthernetBuffer )->xIPHeader );
+			pxIPHeader->usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + uxLength ) );
+			pxIPHeader->usIdentification = usIdentification;
+			pxIPHeader->usFragmentOffset = FreeRTOS_htons( usFragmentOffset );
+			pxIPHeader->usHeaderChecksum = 0u;
+			pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+			pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+
+			ipNETWORK_INTERFACE_OUTPUT( pxFragment, pdTRUE );
+		}
+
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 BaseType_t xProcessReceivedUDPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer, uint16_t usPort )
 {
 BaseType_t xReturn = pdPASS;
@@ -299,14 +408,39 @@ UDPPacket_t *pxUDPPacket = (UDPPacket_t *) pxNetworkBuffer->pucEthernetBuffer;
 					FreeRTOS_debug_printf( ( "xProcessReceivedUDPPacket: buffer full %ld >= %ld port %u\n",
 						listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ),
 						pxSocket->u.xUDP.uxMaxPackets, pxSocket->usLocalPort ) );
+					ipCOUNT_SOCKET_EVENT( pxSocket, ulRxDropped, 1 );
+					ipCOUNT_IP_EVENT( ulRxDropSocketFull );
 					xReturn = pdFAIL; /* we did not consume or release the buffer */
 				}
 			}
 		}
 		#endif
 
+		#if( ipconfigUDP_RX_COPYBREAK > 0 )
+		{
+			if( ( xReturn == pdPASS ) && ( xBufferAllocFixedSize == pdFALSE ) &&
+				( pxNetworkBuffer->xDataLength <= ( size_t ) ipconfigUDP_RX_COPYBREAK ) )
+			{
+			NetworkBufferDescriptor_t *pxNewBuffer;
+
+				/* The packet is consumed here, so the original buffer may be
+				released.  When no copy can be made, the original is queued. */
+				pxNewBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+
+				if( pxNewBuffer != NULL )
+				{
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+					pxNetworkBuffer = pxNewBuffer;
+				}
+			}
+		}
+		#endif /* ipconfigUDP_RX_COPYBREAK */
+
 		if( xReturn == pdPASS )
 		{
+			ipCOUNT_SOCKET_EVENT( pxSocket, ulRxPackets, 1 );
+			ipCOUNT_SOCKET_EVENT( pxSocket, ulRxBytes, pxNetworkBuffer->xDataLength - ipUDP_PAYLOAD_OFFSET_IPv4 );
+
 			vTaskSuspendAll();
 			{
 				if( xReturn == pdPASS )
@@ -337,6 +471,15 @@ UDPPacket_t *pxUDPPacket = (UDPPacket_t *) pxNetworkBuffer->pucEthernetBuffer;
 			}
 			#endif
 
+			#if( ipconfigSUPPORT_POLL_FUNCTION == 1 )
+			{
+				if( pxSocket->pxPollSet != NULL )
+				{
+					vSocketPollSignal( pxSocket, eSOCKET_RECEIVE );
+				}
+			}
+			#endif
+
 			#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
 			{
 				if( pxSocket->pxUserSemaphore != NULL )
@@ -396,6 +539,7 @@ UDPPacket_t *pxUDPPacket = (UDPPacket_t *) pxNetworkBuffer->pucEthernetBuffer;
 			else
 		#endif /* ipconfigUSE_NBNS */
 		{
+			ipCOUNT_IP_EVENT( ulRxDropNoSocket );
 			xReturn = pdFAIL;
 		}
 	}
@@ -335,6 +335,12 @@ BaseType_t vNetworkBufferReleaseFromISR( NetworkBufferDescriptor_t * const pxNet
 {
 BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
+	#if( ipconfigDRIVER_LENDS_RX_BUFFERS != 0 )
+	{
+		vNetworkInterfaceReleaseRxBuffer( pxNetworkBuffer );
+	}
+	#endif
+
 	/* Ensure the buffer is returned to the list of free buffers before the
 	counting semaphore is 'given' to say a buffer is available. */
 	ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
@@ -359,6 +365,15 @@ BaseType_t xListItemAlreadyInFreeList;
 		FreeRTOS_debug_printf( ( "vReleaseNetworkBufferAndDescriptor: Invalid buffer %p\n", pxNetworkBuffer ) );
 		return ;
 	}
+
+	#if( ipconfigDRIVER_LENDS_RX_BUFFERS != 0 )
+	{
+		/* The buffer may hold a frame in memory of the driver, which must get
+		it back before the buffer can be used again. */
+		vNetworkInterfaceReleaseRxBuffer( pxNetworkBuffer );
+	}
+	#endif
+
 	/* Ensure the buffer is returned to the list of free buffers before the
 	counting semaphore is 'given' to say a buffer is available. */
 	ipconfigBUFFER_ALLOC_LOCK();
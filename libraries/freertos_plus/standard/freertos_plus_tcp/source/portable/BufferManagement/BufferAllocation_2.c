@@ -53,6 +53,12 @@ heap_4 can be used. */
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
 
+#if( ipconfigDRIVER_LENDS_RX_BUFFERS != 0 )
+	/* A driver can only lend its memory to buffers of a fixed size, of which
+	it knows the storage. */
+	#error ipconfigDRIVER_LENDS_RX_BUFFERS requires BufferAllocation_1.c
+#endif
+
 /* The obtained network buffer must be large enough to hold a packet that might
 replace the packet that was requested to be sent. */
 #if ipconfigUSE_TCP == 1
@@ -0,0 +1,688 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/******************************************************************************
+ *
+ * See the following web page for essential buffer allocation scheme usage and
+ * configuration details:
+ * http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/Embedded_Ethernet_Buffer_Management.html
+ *
+ * BufferAllocation_3.c uses statically allocated buffers, like
+ * BufferAllocation_1.c, but the storage is declared here and the network
+ * interface does not have to provide vNetworkInterfaceAllocateRAMToBuffers().
+ * The buffers are divided in three size classes: small, medium and large.  A
+ * request is served from the smallest class that fits, so that a TCP ACK or a
+ * DNS request does not occupy a buffer of ipTOTAL_ETHERNET_FRAME_SIZE bytes.
+ * When a class has no free buffers left, a bigger class will be used.
+ *
+ * The free buffers of each class are kept on a stack which is accessed with a
+ * compare-and-swap, without a semaphore and without a critical section.  Both
+ * obtaining and releasing a buffer are O(1), from a task or from an ISR.
+ *
+ ******************************************************************************/
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+#if( ipconfigDRIVER_LENDS_RX_BUFFERS != 0 )
+	/* A driver can only lend its memory to buffers of a fixed size, of which
+	it knows the storage. */
+	#error ipconfigDRIVER_LENDS_RX_BUFFERS requires BufferAllocation_1.c
+#endif
+
+/* The size of the small buffers, not counting ipBUFFER_PADDING.  Requests for
+at most this number of bytes will be served from the small buffers, as long as
+they are available. */
+#ifndef ipconfigBUFFER_ALLOC_3_SMALL_SIZE
+	#define ipconfigBUFFER_ALLOC_3_SMALL_SIZE		( 256 )
+#endif
+
+/* The number of small buffers.  They are a part of the total number of
+ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, the descriptors that are not small or
+medium get a buffer of ipTOTAL_ETHERNET_FRAME_SIZE bytes. */
+#ifndef ipconfigBUFFER_ALLOC_3_SMALL_COUNT
+	#define ipconfigBUFFER_ALLOC_3_SMALL_COUNT		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 4 )
+#endif
+
+/* The size of the medium buffers, large enough for e.g. DHCP, or a TCP segment
+when a small MSS is used. */
+#ifndef ipconfigBUFFER_ALLOC_3_MEDIUM_SIZE
+	#define ipconfigBUFFER_ALLOC_3_MEDIUM_SIZE		( 640 )
+#endif
+
+/* The number of medium buffers, zero to disable the class. */
+#ifndef ipconfigBUFFER_ALLOC_3_MEDIUM_COUNT
+	#define ipconfigBUFFER_ALLOC_3_MEDIUM_COUNT		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 4 )
+#endif
+
+/* Every buffer, including its padding, starts at a multiple of this number of
+bytes.  Use the size of a cache line, so that cache maintenance on one buffer
+never touches its neighbours.  Must be a power of 2. */
+#ifndef ipconfigBUFFER_ALLOC_3_ALIGNMENT
+	#define ipconfigBUFFER_ALLOC_3_ALIGNMENT		( 32 )
+#endif
+
+#if( ( ipconfigBUFFER_ALLOC_3_SMALL_COUNT + ipconfigBUFFER_ALLOC_3_MEDIUM_COUNT ) >= ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS )
+	#error There must be at least one large buffer, decrease ipconfigBUFFER_ALLOC_3_SMALL_COUNT or ipconfigBUFFER_ALLOC_3_MEDIUM_COUNT
+#endif
+
+#if( ipconfigBUFFER_ALLOC_3_SMALL_SIZE >= ipconfigBUFFER_ALLOC_3_MEDIUM_SIZE )
+	#error ipconfigBUFFER_ALLOC_3_SMALL_SIZE must be less than ipconfigBUFFER_ALLOC_3_MEDIUM_SIZE
+#endif
+
+#if( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS >= 0xffff )
+	#error BufferAllocation_3.c supports less than 65535 network buffers
+#endif
+
+/* The obtained network buffer must be large enough to hold a packet that might
+replace the packet that was requested to be sent. */
+#if ipconfigUSE_TCP == 1
+	#define baMINIMAL_BUFFER_SIZE		sizeof( TCPPacket_t )
+#else
+	#define baMINIMAL_BUFFER_SIZE		sizeof( ARPPacket_t )
+#endif /* ipconfigUSE_TCP == 1 */
+
+/* For an Ethernet interrupt to be able to obtain a network buffer there must
+be at least this number of buffers available. */
+#define baINTERRUPT_BUFFER_GET_THRESHOLD	( 3 )
+
+/* Round up a number of bytes to a multiple of the alignment. */
+#define baALIGN_UP( x )		( ( ( x ) + ( ipconfigBUFFER_ALLOC_3_ALIGNMENT - 1u ) ) & ~( ( size_t ) ipconfigBUFFER_ALLOC_3_ALIGNMENT - 1u ) )
+
+/* The space occupied by each buffer, including the padding. */
+#define baSMALL_STRIDE		baALIGN_UP( ( size_t ) ipconfigBUFFER_ALLOC_3_SMALL_SIZE + ipBUFFER_PADDING )
+#define baMEDIUM_STRIDE		baALIGN_UP( ( size_t ) ipconfigBUFFER_ALLOC_3_MEDIUM_SIZE + ipBUFFER_PADDING )
+#define baLARGE_STRIDE		baALIGN_UP( ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE + ipBUFFER_PADDING )
+
+#define baLARGE_COUNT		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - ( ipconfigBUFFER_ALLOC_3_SMALL_COUNT + ipconfigBUFFER_ALLOC_3_MEDIUM_COUNT ) )
+
+/* The classes are ordered by size, baLARGE_CLASS must be the last one. */
+#define baSMALL_CLASS			( 0 )
+#define baMEDIUM_CLASS			( 1 )
+#define baLARGE_CLASS			( 2 )
+#define baNUMBER_OF_CLASSES		( 3 )
+
+/* The head of a free stack contains the index of the first free descriptor
+plus one in the lower 16 bits, zero meaning empty.  The upper 16 bits hold a
+tag which is incremented by every change, to avoid the ABA problem. */
+#define baINDEX_MASK		( 0x0000ffffUL )
+#define baTAG_INCREMENT		( 0x00010000UL )
+
+/* The values of ulInUse[]. */
+#define baFREE				( 0UL )
+#define baIN_USE			( 1UL )
+
+/* The user can provide an atomic 32-bit compare-and-swap, which returns
+non-zero when '*pulDestination' was equal to 'ulComparand' and has been replaced
+by 'ulExchange'. */
+#if !defined( ipconfigBUFFER_ALLOC_CAS_32 )
+	#if defined( __GNUC__ ) && defined( __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4 )
+		/* The platform has a native 32-bit compare-and-swap. */
+		#define ipconfigBUFFER_ALLOC_CAS_32( pulDestination, ulComparand, ulExchange ) \
+			__sync_bool_compare_and_swap( ( pulDestination ), ( ulComparand ), ( ulExchange ) )
+	#else
+		/* Fall back to a very short section with interrupts masked, which is
+		still allowed from an ISR. */
+		#define ipconfigBUFFER_ALLOC_CAS_32( pulDestination, ulComparand, ulExchange ) \
+			prvCompareAndSwap( ( pulDestination ), ( ulComparand ), ( ulExchange ) )
+		#define baUSE_INTERRUPT_MASK_CAS	1
+	#endif
+#endif /* ipconfigBUFFER_ALLOC_CAS_32 */
+
+#ifndef baUSE_INTERRUPT_MASK_CAS
+	#define baUSE_INTERRUPT_MASK_CAS	0
+#endif
+
+/* One class of buffers of equal size. */
+typedef struct xBUFFER_CLASS
+{
+	volatile uint32_t ulFreeHead;	/* Index plus tag of the first free descriptor */
+	volatile uint32_t ulFreeCount;	/* The number of buffers on the free stack */
+	UBaseType_t uxMinimumFree;		/* The lowest value of ulFreeCount since booting */
+	size_t uxBufferSize;			/* The usable size of each buffer */
+	size_t uxStride;				/* The size of each buffer including padding and alignment */
+	UBaseType_t uxFirst;			/* The index of the first descriptor of this class */
+	UBaseType_t uxCount;			/* The number of descriptors in this class */
+} BufferClass_t;
+
+/* The storage for all buffers.  Some spare bytes are added to align the first
+buffer. */
+static uint8_t ucBufferStorage[ ( ipconfigBUFFER_ALLOC_3_SMALL_COUNT * baSMALL_STRIDE ) +
+	( ipconfigBUFFER_ALLOC_3_MEDIUM_COUNT * baMEDIUM_STRIDE ) +
+	( baLARGE_COUNT * baLARGE_STRIDE ) + ipconfigBUFFER_ALLOC_3_ALIGNMENT ];
+
+/* Declares the pool of NetworkBufferDescriptor_t structures that are available
+to the system.  The descriptors of the small buffers come first. */
+static NetworkBufferDescriptor_t xNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+
+/* The links of the free stacks: the index plus one of the next free
+descriptor, zero for the last one. */
+static volatile uint16_t usNextFree[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+
+/* baIN_USE for descriptors that have been handed out.  A release changes it
+to baFREE with a compare-and-swap, so when the same descriptor is released
+twice at the same time, only one of the callers will push it. */
+static volatile uint32_t ulInUse[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+
+/* The start of each buffer is found as pucBufferStart[ class ] + index * stride. */
+static uint8_t *pucBufferStart[ baNUMBER_OF_CLASSES ];
+
+static BufferClass_t xBufferClasses[ baNUMBER_OF_CLASSES ];
+
+/* Set to pdTRUE once xNetworkBuffersInitialise() has run. */
+static BaseType_t xBuffersInitialised = pdFALSE;
+
+/* This constant is defined as false to let FreeRTOS_TCP_IP.c know that the
+network buffers have a variable size: resizing may be necessary */
+const BaseType_t xBufferAllocFixedSize = pdFALSE;
+
+/*
+ * Pop a descriptor from the free stack of a class, returns NULL when the class
+ * has no free buffers.
+ */
+static NetworkBufferDescriptor_t *prvPopBuffer( BufferClass_t *pxClass );
+
+/*
+ * Push a descriptor back on the free stack of its class.  Returns pdFALSE if
+ * the descriptor was not in use.
+ */
+static BaseType_t prvPushBuffer( NetworkBufferDescriptor_t *pxDescriptor );
+
+/*
+ * Try to obtain a buffer of at least 'xRequestedSizeBytes' bytes, searching
+ * from the smallest class that fits.  Classes with at most 'uxReserved' free
+ * buffers will not be used.
+ */
+static NetworkBufferDescriptor_t *prvGetBuffer( size_t xRequestedSizeBytes, UBaseType_t uxReserved );
+
+/*
+ * Atomically add 'lDelta' to '*pulValue', returns the new value.
+ */
+static uint32_t prvAtomicAdd( volatile uint32_t *pulValue, int32_t lDelta );
+
+/*
+ * Return the index of a descriptor, or -1 if it isn't one of xNetworkBuffers[].
+ */
+static BaseType_t prvDescriptorIndex( const NetworkBufferDescriptor_t *pxDescriptor );
+
+/*
+ * Return the size class of the descriptor with index 'xIndex'.
+ */
+static BaseType_t prvDescriptorClass( BaseType_t xIndex );
+
+#if( baUSE_INTERRUPT_MASK_CAS != 0 )
+	static BaseType_t prvCompareAndSwap( volatile uint32_t *pulDestination, uint32_t ulComparand, uint32_t ulExchange );
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if( baUSE_INTERRUPT_MASK_CAS != 0 )
+
+	static BaseType_t prvCompareAndSwap( volatile uint32_t *pulDestination, uint32_t ulComparand, uint32_t ulExchange )
+	{
+	BaseType_t xResult = pdFALSE;
+	UBaseType_t uxSavedInterruptStatus;
+
+		uxSavedInterruptStatus = ( UBaseType_t ) portSET_INTERRUPT_MASK_FROM_ISR();
+		{
+			if( *pulDestination == ulComparand )
+			{
+				*pulDestination = ulExchange;
+				xResult = pdTRUE;
+			}
+		}
+		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+		return xResult;
+	}
+
+#endif /* baUSE_INTERRUPT_MASK_CAS */
+/*-----------------------------------------------------------*/
+
+static uint32_t prvAtomicAdd( volatile uint32_t *pulValue, int32_t lDelta )
+{
+uint32_t ulOld, ulNew;
+
+	do
+	{
+		ulOld = *pulValue;
+		ulNew = ulOld + ( uint32_t ) lDelta;
+	} while( ipconfigBUFFER_ALLOC_CAS_32( pulValue, ulOld, ulNew ) == 0 );
+
+	return ulNew;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDescriptorIndex( const NetworkBufferDescriptor_t *pxDescriptor )
+{
+BaseType_t xIndex = -1;
+size_t uxOffset;
+
+	if( pxDescriptor != NULL )
+	{
+		uxOffset = ( size_t ) ( ( ( const uint8_t * ) pxDescriptor ) - ( ( const uint8_t * ) xNetworkBuffers ) );
+
+		if( ( uxOffset < sizeof( xNetworkBuffers ) ) && ( ( uxOffset % sizeof( xNetworkBuffers[ 0 ] ) ) == 0u ) )
+		{
+			xIndex = ( BaseType_t ) ( pxDescriptor - xNetworkBuffers );
+		}
+	}
+
+	return xIndex;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDescriptorClass( BaseType_t xIndex )
+{
+BaseType_t xClass;
+
+	for( xClass = 0; xClass < baNUMBER_OF_CLASSES - 1; xClass++ )
+	{
+		if( ( UBaseType_t ) xIndex < ( xBufferClasses[ xClass ].uxFirst + xBufferClasses[ xClass ].uxCount ) )
+		{
+			break;
+		}
+	}
+
+	return xClass;
+}
+/*-----------------------------------------------------------*/
+
+static NetworkBufferDescriptor_t *prvPopBuffer( BufferClass_t *pxClass )
+{
+NetworkBufferDescriptor_t *pxReturn = NULL;
+uint32_t ulOld, ulNew, ulIndex;
+
+	for( ;; )
+	{
+		ulOld = pxClass->ulFreeHead;
+		ulIndex = ulOld & baINDEX_MASK;
+
+		if( ulIndex == 0u )
+		{
+			/* The stack is empty. */
+			break;
+		}
+
+		/* usNextFree[] might have been changed by another pop/push, but in
+		that case the tag has changed as well, and the CAS will fail. */
+		ulNew = ( ( ulOld + baTAG_INCREMENT ) & ~baINDEX_MASK ) | ( uint32_t ) usNextFree[ ulIndex - 1u ];
+
+		if( ipconfigBUFFER_ALLOC_CAS_32( &( pxClass->ulFreeHead ), ulOld, ulNew ) != 0 )
+		{
+			ulInUse[ ulIndex - 1u ] = baIN_USE;
+			pxReturn = &( xNetworkBuffers[ ulIndex - 1u ] );
+			break;
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvPushBuffer( NetworkBufferDescriptor_t *pxDescriptor )
+{
+BufferClass_t *pxClass;
+BaseType_t xIndex, xClass;
+uint32_t ulOld, ulNew;
+BaseType_t xReturn = pdFALSE;
+
+	xIndex = prvDescriptorIndex( pxDescriptor );
+
+	/* Claim the descriptor before touching the free stack.  The CAS fails
+	when it is free already, or when another caller has just claimed it. */
+	if( ( xIndex >= 0 ) && ( ipconfigBUFFER_ALLOC_CAS_32( &( ulInUse[ xIndex ] ), baIN_USE, baFREE ) != 0 ) )
+	{
+		xClass = prvDescriptorClass( xIndex );
+		pxClass = &( xBufferClasses[ xClass ] );
+
+		/* The driver or the application may have replaced the buffer pointer,
+		restore it. */
+		pxDescriptor->pucEthernetBuffer = pucBufferStart[ xClass ] +
+			( ( ( UBaseType_t ) xIndex - pxClass->uxFirst ) * pxClass->uxStride ) + ipBUFFER_PADDING;
+
+		do
+		{
+			ulOld = pxClass->ulFreeHead;
+			usNextFree[ xIndex ] = ( uint16_t ) ( ulOld & baINDEX_MASK );
+			ulNew = ( ( ulOld + baTAG_INCREMENT ) & ~baINDEX_MASK ) | ( uint32_t ) ( xIndex + 1 );
+		} while( ipconfigBUFFER_ALLOC_CAS_32( &( pxClass->ulFreeHead ), ulOld, ulNew ) == 0 );
+
+		( void ) prvAtomicAdd( &( pxClass->ulFreeCount ), 1 );
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static NetworkBufferDescriptor_t *prvGetBuffer( size_t xRequestedSizeBytes, UBaseType_t uxReserved )
+{
+NetworkBufferDescriptor_t *pxReturn = NULL;
+BufferClass_t *pxClass;
+BaseType_t xClass;
+UBaseType_t uxCount;
+size_t uxNeeded = xRequestedSizeBytes;
+
+	if( uxNeeded < baMINIMAL_BUFFER_SIZE )
+	{
+		/* ARP packets can replace application packets, so the storage must be
+		at least large enough to hold an ARP. */
+		uxNeeded = baMINIMAL_BUFFER_SIZE;
+	}
+
+	/* Start with the smallest class that fits, and use a bigger class in case
+	it has no free buffers. */
+	for( xClass = 0; xClass < baNUMBER_OF_CLASSES; xClass++ )
+	{
+		pxClass = &( xBufferClasses[ xClass ] );
+
+		if( ( pxClass->uxBufferSize < uxNeeded ) || ( ( UBaseType_t ) pxClass->ulFreeCount <= uxReserved ) )
+		{
+			continue;
+		}
+
+		pxReturn = prvPopBuffer( pxClass );
+
+		if( pxReturn != NULL )
+		{
+			uxCount = ( UBaseType_t ) prvAtomicAdd( &( pxClass->ulFreeCount ), -1 );
+
+			/* For stats, latch the lowest number of network buffers since
+			booting.  This is not atomic, but it is only statistics. */
+			if( pxClass->uxMinimumFree > uxCount )
+			{
+				pxClass->uxMinimumFree = uxCount;
+			}
+
+			pxReturn->xDataLength = xRequestedSizeBytes;
+
+			#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+			{
+				/* make sure the buffer is not linked */
+				pxReturn->pxNextBuffer = NULL;
+			}
+			#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+			break;
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkBuffersInitialise( void )
+{
+BufferClass_t *pxClass;
+BaseType_t xClass;
+UBaseType_t uxIndex, x;
+uint8_t *pucBuffer;
+
+	/* Only initialise the buffers if they have not been initialised before. */
+	if( xBuffersInitialised == pdFALSE )
+	{
+		configASSERT( ( size_t ) ipconfigBUFFER_ALLOC_3_SMALL_SIZE >= baMINIMAL_BUFFER_SIZE );
+
+		memset( xBufferClasses, '\0', sizeof( xBufferClasses ) );
+		xBufferClasses[ baSMALL_CLASS ].uxBufferSize = ( size_t ) ipconfigBUFFER_ALLOC_3_SMALL_SIZE;
+		xBufferClasses[ baSMALL_CLASS ].uxStride = baSMALL_STRIDE;
+		xBufferClasses[ baSMALL_CLASS ].uxCount = ( UBaseType_t ) ipconfigBUFFER_ALLOC_3_SMALL_COUNT;
+		xBufferClasses[ baMEDIUM_CLASS ].uxBufferSize = ( size_t ) ipconfigBUFFER_ALLOC_3_MEDIUM_SIZE;
+		xBufferClasses[ baMEDIUM_CLASS ].uxStride = baMEDIUM_STRIDE;
+		xBufferClasses[ baMEDIUM_CLASS ].uxCount = ( UBaseType_t ) ipconfigBUFFER_ALLOC_3_MEDIUM_COUNT;
+		xBufferClasses[ baLARGE_CLASS ].uxBufferSize = ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE;
+		xBufferClasses[ baLARGE_CLASS ].uxStride = baLARGE_STRIDE;
+		xBufferClasses[ baLARGE_CLASS ].uxCount = ( UBaseType_t ) baLARGE_COUNT;
+
+		/* Align the first buffer. */
+		pucBuffer = ( uint8_t * ) baALIGN_UP( ( size_t ) ucBufferStorage );
+		uxIndex = 0u;
+
+		for( xClass = 0; xClass < baNUMBER_OF_CLASSES; xClass++ )
+		{
+			pxClass = &( xBufferClasses[ xClass ] );
+			pxClass->uxFirst = uxIndex;
+			pucBufferStart[ xClass ] = pucBuffer;
+
+			for( x = 0u; x < pxClass->uxCount; x++ )
+			{
+				/* Store a pointer to the descriptor in the padding, as is done
+				by BufferAllocation_2.c. */
+				*( ( NetworkBufferDescriptor_t ** ) pucBuffer ) = &( xNetworkBuffers[ uxIndex ] );
+				xNetworkBuffers[ uxIndex ].pucEthernetBuffer = pucBuffer + ipBUFFER_PADDING;
+				vListInitialiseItem( &( xNetworkBuffers[ uxIndex ].xBufferListItem ) );
+				listSET_LIST_ITEM_OWNER( &( xNetworkBuffers[ uxIndex ].xBufferListItem ), &xNetworkBuffers[ uxIndex ] );
+
+				/* Link it to the next buffer of the same class. */
+				if( ( x + 1u ) < pxClass->uxCount )
+				{
+					usNextFree[ uxIndex ] = ( uint16_t ) ( uxIndex + 2u );
+				}
+				else
+				{
+					usNextFree[ uxIndex ] = 0u;
+				}
+
+				pucBuffer += pxClass->uxStride;
+				uxIndex++;
+			}
+
+			pxClass->ulFreeHead = ( pxClass->uxCount != 0u ) ? ( uint32_t ) ( pxClass->uxFirst + 1u ) : 0ul;
+			pxClass->ulFreeCount = ( uint32_t ) pxClass->uxCount;
+			pxClass->uxMinimumFree = pxClass->uxCount;
+		}
+
+		xBuffersInitialised = pdTRUE;
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+uint8_t *pucGetNetworkBuffer( size_t *pxRequestedSizeBytes )
+{
+	/* The buffers are bound to their descriptors, there are no loose
+	buffers.  A zero-copy driver written for BufferAllocation_2.c must swap
+	descriptors obtained with pxGetNetworkBufferWithDescriptor() instead. */
+	( void ) pxRequestedSizeBytes;
+	configASSERT( pdFALSE );
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBuffer( uint8_t *pucEthernetBuffer )
+{
+	/* The buffers are bound to their descriptors and can only be released
+	with vReleaseNetworkBufferAndDescriptor(). */
+	( void ) pucEthernetBuffer;
+	configASSERT( pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes, TickType_t xBlockTimeTicks )
+{
+NetworkBufferDescriptor_t *pxReturn = NULL;
+TimeOut_t xTimeOut;
+
+	if( ( xBuffersInitialised != pdFALSE ) && ( xRequestedSizeBytes <= ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE ) )
+	{
+		pxReturn = prvGetBuffer( xRequestedSizeBytes, 0u );
+
+		if( ( pxReturn == NULL ) && ( xBlockTimeTicks != ( TickType_t ) 0 ) )
+		{
+			/* There is no semaphore to wait for.  Poll once every clock tick,
+			which only happens when the pool is exhausted. */
+			vTaskSetTimeOutState( &xTimeOut );
+
+			while( xTaskCheckForTimeOut( &xTimeOut, &xBlockTimeTicks ) == pdFALSE )
+			{
+				vTaskDelay( 1u );
+				pxReturn = prvGetBuffer( xRequestedSizeBytes, 0u );
+
+				if( pxReturn != NULL )
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	if( pxReturn == NULL )
+	{
+		iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER();
+	}
+	else
+	{
+		iptraceNETWORK_BUFFER_OBTAINED( pxReturn );
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxNetworkBufferGetFromISR( size_t xRequestedSizeBytes )
+{
+NetworkBufferDescriptor_t *pxReturn = NULL;
+
+	/* As this is called from an interrupt, only take a buffer if there are at
+	least baINTERRUPT_BUFFER_GET_THRESHOLD buffers remaining in the class.  This
+	prevents a rapidly executing interrupt from exhausting the buffers. */
+	if( ( xBuffersInitialised != pdFALSE ) && ( xRequestedSizeBytes <= ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE ) )
+	{
+		pxReturn = prvGetBuffer( xRequestedSizeBytes, ( UBaseType_t ) baINTERRUPT_BUFFER_GET_THRESHOLD );
+	}
+
+	if( pxReturn == NULL )
+	{
+		iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER_FROM_ISR();
+	}
+	else
+	{
+		iptraceNETWORK_BUFFER_OBTAINED_FROM_ISR( pxReturn );
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t vNetworkBufferReleaseFromISR( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	if( prvPushBuffer( pxNetworkBuffer ) != pdFALSE )
+	{
+		iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
+	}
+
+	/* No task is waiting on a semaphore. */
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	if( prvPushBuffer( pxNetworkBuffer ) != pdFALSE )
+	{
+		iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
+	}
+	else
+	{
+		FreeRTOS_debug_printf( ( "vReleaseNetworkBufferAndDescriptor: %p invalid or already released\n", pxNetworkBuffer ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetMinimumFreeNetworkBuffers( void )
+{
+UBaseType_t uxCount = 0u;
+BaseType_t xClass;
+
+	/* The sum of the lowest numbers of each class.  The minima may have been
+	reached at different moments. */
+	for( xClass = 0; xClass < baNUMBER_OF_CLASSES; xClass++ )
+	{
+		uxCount += xBufferClasses[ xClass ].uxMinimumFree;
+	}
+
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetNumberOfFreeNetworkBuffers( void )
+{
+UBaseType_t uxCount = 0u;
+BaseType_t xClass;
+
+	for( xClass = 0; xClass < baNUMBER_OF_CLASSES; xClass++ )
+	{
+		uxCount += ( UBaseType_t ) xBufferClasses[ xClass ].ulFreeCount;
+	}
+
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxResizeNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * pxNetworkBuffer, size_t xNewSizeBytes )
+{
+NetworkBufferDescriptor_t *pxReturn = pxNetworkBuffer;
+BaseType_t xIndex;
+BaseType_t xClass;
+
+	xIndex = prvDescriptorIndex( pxNetworkBuffer );
+
+	if( xIndex >= 0 )
+	{
+		xClass = prvDescriptorClass( xIndex );
+
+		if( xNewSizeBytes <= xBufferClasses[ xClass ].uxBufferSize )
+		{
+			/* The buffer is big enough already. */
+			pxNetworkBuffer->xDataLength = xNewSizeBytes;
+		}
+		else
+		{
+			/* The buffer can not grow, so the contents will be moved to a
+			bigger buffer, and the old one will be released.  Unlike
+			BufferAllocation_2.c, the caller gets a different descriptor. */
+			pxReturn = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, xNewSizeBytes );
+
+			if( pxReturn != NULL )
+			{
+				vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			}
+		}
+	}
+
+	return pxReturn;
+}
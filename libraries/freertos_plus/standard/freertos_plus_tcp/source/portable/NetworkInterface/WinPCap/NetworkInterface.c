@@ -47,6 +47,16 @@ WinPCAP Windows threads. */
 #define xSEND_BUFFER_SIZE  32768
 #define xRECV_BUFFER_SIZE  32768
 
+/* A stream buffer can hold one byte less than its LENGTH, which must be a
+power of two when ipconfigSTREAM_BUFFER_POWER_OF_TWO is defined. */
+#if( ipconfigSTREAM_BUFFER_POWER_OF_TWO != 0 )
+	#define xSEND_BUFFER_LENGTH  ( xSEND_BUFFER_SIZE )
+	#define xRECV_BUFFER_LENGTH  ( xRECV_BUFFER_SIZE )
+#else
+	#define xSEND_BUFFER_LENGTH  ( xSEND_BUFFER_SIZE + 1 )
+	#define xRECV_BUFFER_LENGTH  ( xRECV_BUFFER_SIZE + 1 )
+#endif
+
 /* If ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES is set to 1, then the Ethernet
 driver will filter incoming packets and only pass the stack those packets it
 considers need processing. */
@@ -170,20 +180,20 @@ static void prvCreateThreadSafeBuffers( void )
 	the Win32 thread that sends via the WinPCAP library. */
 	if( xSendBuffer == NULL)
 	{
-		xSendBuffer = ( StreamBuffer_t * ) malloc( sizeof( *xSendBuffer ) - sizeof( xSendBuffer->ucArray ) + xSEND_BUFFER_SIZE + 1 );
+		xSendBuffer = ( StreamBuffer_t * ) malloc( sizeof( *xSendBuffer ) - sizeof( xSendBuffer->ucArray ) + xSEND_BUFFER_LENGTH );
 		configASSERT( xSendBuffer );
 		memset( xSendBuffer, '\0', sizeof( *xSendBuffer ) - sizeof( xSendBuffer->ucArray ) );
-		xSendBuffer->LENGTH = xSEND_BUFFER_SIZE + 1;
+		xSendBuffer->LENGTH = xSEND_BUFFER_LENGTH;
 	}
 
 	/* The buffer used to pass received data from the Win32 thread that receives
 	via the WinPCAP library to the FreeRTOS task. */
 	if( xRecvBuffer == NULL)
 	{
-		xRecvBuffer = ( StreamBuffer_t * ) malloc( sizeof( *xRecvBuffer ) - sizeof( xRecvBuffer->ucArray ) + xRECV_BUFFER_SIZE + 1 );
+		xRecvBuffer = ( StreamBuffer_t * ) malloc( sizeof( *xRecvBuffer ) - sizeof( xRecvBuffer->ucArray ) + xRECV_BUFFER_LENGTH );
 		configASSERT( xRecvBuffer );
 		memset( xRecvBuffer, '\0', sizeof( *xRecvBuffer ) - sizeof( xRecvBuffer->ucArray ) );
-		xRecvBuffer->LENGTH = xRECV_BUFFER_SIZE + 1;
+		xRecvBuffer->LENGTH = xRECV_BUFFER_LENGTH;
 	}
 }
 /*-----------------------------------------------------------*/
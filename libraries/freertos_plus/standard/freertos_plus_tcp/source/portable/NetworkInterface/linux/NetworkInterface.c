@@ -0,0 +1,1013 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+/* Linux includes. */
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/if_tun.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+#include "NetworkInterface.h"
+
+/* The name of the host interface.  When configLINUX_USE_TAP_DEVICE is 1 this is
+the TAP device that will be attached to (and created when it does not exist yet),
+otherwise it is an existing interface such as one end of a veth pair. */
+#ifndef configLINUX_NETWORK_INTERFACE_NAME
+	#define configLINUX_NETWORK_INTERFACE_NAME	"tap0"
+#endif
+
+/* Set to 1 to exchange frames through a TAP device, or to 0 to bind a raw
+AF_PACKET socket to the interface and receive through a TPACKET_V3 ring. */
+#ifndef configLINUX_USE_TAP_DEVICE
+	#define configLINUX_USE_TAP_DEVICE	1
+#endif
+
+/* The time the receive task sleeps after finding no frames to process. */
+#ifndef configLINUX_MAC_INTERRUPT_SIMULATOR_DELAY
+	#define configLINUX_MAC_INTERRUPT_SIMULATOR_DELAY	( ( TickType_t ) 1 )
+#endif
+
+#ifndef configMAC_ISR_SIMULATOR_PRIORITY
+	#define configMAC_ISR_SIMULATOR_PRIORITY	( configMAX_PRIORITIES - 1 )
+#endif
+
+/* Default the size of the stack used by the receive task to twice the size of
+the stack used by the idle task - but allow this to be overridden in
+FreeRTOSConfig.h as configMINIMAL_STACK_SIZE is a user definable constant. */
+#ifndef configEMAC_TASK_STACK_SIZE
+	#define configEMAC_TASK_STACK_SIZE	( 2 * configMINIMAL_STACK_SIZE )
+#endif
+
+/* Geometry of the TPACKET_V3 receive ring.  The kernel fills a block with as
+many frames as fit, and hands it to user space when it is full or when
+niRING_RETIRE_MS has passed.  The block size must be a multiple of the page
+size. */
+#ifndef niRING_BLOCK_SIZE
+	#define niRING_BLOCK_SIZE		( 1u << 16 )
+#endif
+
+#ifndef niRING_BLOCK_COUNT
+	#define niRING_BLOCK_COUNT		64u
+#endif
+
+#ifndef niRING_FRAME_SIZE
+	#define niRING_FRAME_SIZE		2048u
+#endif
+
+#ifndef niRING_RETIRE_MS
+	#define niRING_RETIRE_MS		1u
+#endif
+
+/* With ipconfigDRIVER_LENDS_RX_BUFFERS, TCP segments are passed to the IP task
+in the memory of the ring, see prvRingFrameMayBeLent().  Every frame then gets
+niRING_FRAME_RESERVE bytes of headroom.  The headroom holds the pointer to the
+network buffer, and it leaves space for the stack to write a reply that is
+longer than the frame in front of it. */
+#if( ( configLINUX_USE_TAP_DEVICE == 0 ) && ( ipconfigDRIVER_LENDS_RX_BUFFERS != 0 ) )
+	#define niRING_LENDS_FRAMES		1
+#else
+	#define niRING_LENDS_FRAMES		0
+#endif
+
+#ifndef niRING_FRAME_RESERVE
+	#define niRING_FRAME_RESERVE	( ipTOTAL_ETHERNET_FRAME_SIZE + ipBUFFER_PADDING )
+#endif
+
+/* A block goes back to the kernel once all frames lent from it have been
+released.  The kernel can not pass a block that is still held, so frames are
+copied while niRING_MAX_HELD_BLOCKS blocks are held. */
+#ifndef niRING_MAX_HELD_BLOCKS
+	#define niRING_MAX_HELD_BLOCKS	( niRING_BLOCK_COUNT / 2u )
+#endif
+
+/* The maximum number of frames read from a TAP device in one go. */
+#define niMAX_TAP_FRAMES_PER_POLL	32
+
+/* The size of each buffer when BufferAllocation_1 is used:
+http://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/Embedded_Ethernet_Buffer_Management.html */
+#define niBUFFER_1_PACKET_SIZE		1536
+
+/* If ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES is set to 1, then the Ethernet
+driver will filter incoming packets and only pass the stack those packets it
+considers need processing. */
+#if( ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES == 0 )
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) eProcessBuffer
+#else
+	#define ipCONSIDER_FRAME_FOR_PROCESSING( pucEthernetBuffer ) eConsiderFrameForProcessing( ( pucEthernetBuffer ) )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Open the host interface, either as a TAP device or as a raw packet socket
+ * with a memory mapped receive ring.  Returns a non-blocking file descriptor,
+ * or -1 on failure.
+ */
+#if( configLINUX_USE_TAP_DEVICE != 0 )
+	static int prvOpenTapDevice( void );
+#else
+	static int prvOpenPacketSocket( void );
+#endif
+
+/*
+ * A task that simulates Ethernet interrupts by polling the host interface for
+ * new frames and passing them to the IP task.
+ */
+static void prvInterruptSimulatorTask( void *pvParameters );
+
+/*
+ * Pass all frames that are waiting in the host interface to the IP task.
+ * Returns the number of frames that were found.
+ */
+#if( configLINUX_USE_TAP_DEVICE != 0 )
+	static BaseType_t prvReadTapFrames( void );
+#else
+	/* The fields of a frame in the ring, they are read before the frame in
+	front of it is handed to the IP task. */
+	typedef struct xRING_FRAME
+	{
+		uint8_t *pucData;
+		size_t xLength;
+		uint8_t ucPacketType;
+		const struct tpacket3_hdr *pxNext;
+	} RingFrame_t;
+
+	static BaseType_t prvReadRingBlocks( void );
+	static void prvRingFrameGet( const struct tpacket3_hdr *pxFrame, RingFrame_t *pxRingFrame );
+	static void prvReadRingFrame( uint8_t *pucData, size_t xLength, const uint8_t *pucLimit, uint32_t ulBlock );
+#endif
+
+/*
+ * Without copying, a received TCP segment is passed to the IP task in the
+ * memory of the ring.  prvRingFrameMayBeLent() checks whether a frame can be
+ * lent, prvRingFrameLend() lets a network buffer point to it, and
+ * prvRingBlockRelease() drops a reference to a block: the last one returns
+ * the block to the kernel.
+ */
+#if( niRING_LENDS_FRAMES != 0 )
+	static BaseType_t prvRingFrameMayBeLent( const uint8_t *pucData, size_t xLength, const uint8_t *pucLimit );
+	static void prvRingFrameLend( NetworkBufferDescriptor_t *pxNetworkBuffer, uint8_t *pucData, uint32_t ulBlock );
+	static void prvRingBlockRelease( uint32_t ulBlock );
+#endif
+
+/*
+ * Hand a received frame to the IP task.  When ipconfigUSE_LINKED_RX_MESSAGES
+ * is defined, frames are chained and passed on by prvFlushReceivedFrames() so
+ * that a whole batch costs a single message to the IP task.
+ */
+static void prvQueueReceivedFrame( NetworkBufferDescriptor_t *pxNetworkBuffer );
+static void prvFlushReceivedFrames( void );
+static void prvSendToIPTask( NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+/*-----------------------------------------------------------*/
+
+/* The TAP device or the packet socket.  -1 as long as it is not open. */
+static int iNetworkFd = -1;
+
+/* The task that polls the host interface. */
+static TaskHandle_t xRxTaskHandle = NULL;
+
+#if( configLINUX_USE_TAP_DEVICE == 0 )
+	/* The memory mapped receive ring, and the block that will be handed to
+	user space next. */
+	static uint8_t *pucRxRing = NULL;
+	static uint32_t ulRxBlockIndex = 0u;
+#endif
+
+#if( niRING_LENDS_FRAMES != 0 )
+	/* The network buffers, and the storage that
+	vNetworkInterfaceAllocateRAMToBuffers() gave them. */
+	static NetworkBufferDescriptor_t *pxRxDescriptors = NULL;
+	static uint8_t *pucRxDescriptorStorage = NULL;
+
+	/* For every network buffer, the ring block whose memory it uses plus one,
+	or zero when it uses its own storage. */
+	static uint32_t ulLentFromBlock[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+
+	/* For every ring block: the number of frames lent from it, plus one while
+	the block is being read; whether frames were lent from it; and its
+	sequence number when it was read, to recognise a block that is still held
+	when the ring comes round to it again. */
+	static uint32_t ulBlockUsers[ niRING_BLOCK_COUNT ];
+	static uint8_t ucBlockLent[ niRING_BLOCK_COUNT ];
+	static uint64_t ullBlockSequence[ niRING_BLOCK_COUNT ];
+
+	/* The number of blocks from which frames are lent. */
+	static uint32_t ulHeldBlocks = 0u;
+#endif
+
+#if( configLINUX_USE_TAP_DEVICE != 0 ) && ( ipconfigZERO_COPY_RX_DRIVER != 0 )
+	/* A network buffer that the next frame will be read into directly. */
+	static NetworkBufferDescriptor_t *pxNextRxBuffer = NULL;
+#endif
+
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	/* Frames that were received but not yet passed to the IP task. */
+	static NetworkBufferDescriptor_t *pxRxChainHead = NULL;
+	static NetworkBufferDescriptor_t *pxRxChainTail = NULL;
+#endif
+
+/* Logs send failures and dropped receptions, for viewing in the debugger
+only. */
+static volatile uint32_t ulLinuxSendFailures = 0;
+static volatile uint32_t ulLinuxReceiveDrops = 0;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+BaseType_t xReturn = pdFAIL;
+
+	if( iNetworkFd < 0 )
+	{
+		#if( configLINUX_USE_TAP_DEVICE != 0 )
+		{
+			iNetworkFd = prvOpenTapDevice();
+		}
+		#else
+		{
+			iNetworkFd = prvOpenPacketSocket();
+		}
+		#endif
+	}
+
+	if( iNetworkFd >= 0 )
+	{
+		if( xRxTaskHandle == NULL )
+		{
+			/* Create a task that simulates an interrupt in a real system.  It
+			polls the host interface and sends a message to the IP task when
+			frames are available. */
+			xTaskCreate( prvInterruptSimulatorTask, "MAC_ISR", configEMAC_TASK_STACK_SIZE, NULL, configMAC_ISR_SIMULATOR_PRIORITY, &xRxTaskHandle );
+		}
+
+		if( xRxTaskHandle != NULL )
+		{
+			xReturn = pdPASS;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+{
+BaseType_t xReturn = pdFAIL;
+ssize_t xResult;
+
+	iptraceNETWORK_INTERFACE_TRANSMIT();
+
+	if( ( iNetworkFd >= 0 ) && ( pxNetworkBuffer->xDataLength <= ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE ) )
+	{
+		/* The frame is passed to the kernel straight from the network buffer,
+		the driver does not make a copy.  Both a TAP device and a bound packet
+		socket accept a plain write() of one frame. */
+		xResult = write( iNetworkFd, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+
+		if( xResult == ( ssize_t ) pxNetworkBuffer->xDataLength )
+		{
+			xReturn = pdPASS;
+		}
+	}
+
+	if( xReturn == pdFAIL )
+	{
+		ulLinuxSendFailures++;
+	}
+
+	/* When ipconfigZERO_COPY_TX_DRIVER is defined, xReleaseAfterSend is always
+	pdTRUE: the driver owns the buffer and releases it once it was sent. */
+	if( xReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vNetworkInterfaceAllocateRAMToBuffers( NetworkBufferDescriptor_t pxNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ] )
+{
+static uint8_t ucNetworkPackets[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS * niBUFFER_1_PACKET_SIZE ] __attribute__ ( ( aligned( 32 ) ) );
+uint8_t *ucRAMBuffer = ucNetworkPackets;
+uint32_t ul;
+
+	for( ul = 0; ul < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; ul++ )
+	{
+		pxNetworkBuffers[ ul ].pucEthernetBuffer = ucRAMBuffer + ipBUFFER_PADDING;
+		*( ( NetworkBufferDescriptor_t ** ) ucRAMBuffer ) = &( pxNetworkBuffers[ ul ] );
+		ucRAMBuffer += niBUFFER_1_PACKET_SIZE;
+	}
+
+	#if( niRING_LENDS_FRAMES != 0 )
+	{
+		/* Needed to give a network buffer its own storage back, see
+		vNetworkInterfaceReleaseRxBuffer(). */
+		pxRxDescriptors = pxNetworkBuffers;
+		pucRxDescriptorStorage = ucNetworkPackets;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xGetPhyLinkStatus( void )
+{
+BaseType_t xReturn;
+
+	/* There is no PHY, the link is up as long as the host interface is
+	open. */
+	if( iNetworkFd >= 0 )
+	{
+		xReturn = pdPASS;
+	}
+	else
+	{
+		xReturn = pdFAIL;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+#if( configLINUX_USE_TAP_DEVICE != 0 )
+
+	static int prvOpenTapDevice( void )
+	{
+	int iFd;
+	struct ifreq xRequest;
+
+		iFd = open( "/dev/net/tun", O_RDWR | O_NONBLOCK );
+
+		if( iFd < 0 )
+		{
+			FreeRTOS_printf( ( "prvOpenTapDevice: /dev/net/tun: %s\n", strerror( errno ) ) );
+		}
+		else
+		{
+			/* Frames are exchanged without the extra packet information
+			header. */
+			memset( &xRequest, '\0', sizeof( xRequest ) );
+			xRequest.ifr_flags = IFF_TAP | IFF_NO_PI;
+			strncpy( xRequest.ifr_name, configLINUX_NETWORK_INTERFACE_NAME, sizeof( xRequest.ifr_name ) - 1u );
+
+			if( ioctl( iFd, TUNSETIFF, &xRequest ) < 0 )
+			{
+				FreeRTOS_printf( ( "prvOpenTapDevice: %s: %s\n", configLINUX_NETWORK_INTERFACE_NAME, strerror( errno ) ) );
+				close( iFd );
+				iFd = -1;
+			}
+			else
+			{
+				FreeRTOS_printf( ( "prvOpenTapDevice: attached to %s\n", xRequest.ifr_name ) );
+			}
+		}
+
+		return iFd;
+	}
+
+#endif /* configLINUX_USE_TAP_DEVICE != 0 */
+/*-----------------------------------------------------------*/
+
+#if( configLINUX_USE_TAP_DEVICE == 0 )
+
+	static int prvOpenPacketSocket( void )
+	{
+	int iFd;
+	int iVersion = TPACKET_V3;
+	int iOne = 1;
+	unsigned int uiInterfaceIndex;
+	#if( niRING_LENDS_FRAMES != 0 )
+		unsigned int uiReserve = ( unsigned int ) niRING_FRAME_RESERVE;
+	#endif
+	const char *pcFailure = NULL;
+	struct tpacket_req3 xRing;
+	struct sockaddr_ll xAddress;
+	struct packet_mreq xMembership;
+	void *pvRing;
+
+		uiInterfaceIndex = if_nametoindex( configLINUX_NETWORK_INTERFACE_NAME );
+		iFd = socket( AF_PACKET, SOCK_RAW | SOCK_NONBLOCK, htons( ETH_P_ALL ) );
+
+		if( uiInterfaceIndex == 0u )
+		{
+			pcFailure = "if_nametoindex";
+		}
+		else if( iFd < 0 )
+		{
+			pcFailure = "socket";
+		}
+		else if( setsockopt( iFd, SOL_PACKET, PACKET_VERSION, &iVersion, sizeof( iVersion ) ) < 0 )
+		{
+			pcFailure = "PACKET_VERSION";
+		}
+		#if( niRING_LENDS_FRAMES != 0 )
+		else if( setsockopt( iFd, SOL_PACKET, PACKET_RESERVE, &uiReserve, sizeof( uiReserve ) ) < 0 )
+		{
+			pcFailure = "PACKET_RESERVE";
+		}
+		#endif
+		else
+		{
+			/* The ring consists of niRING_BLOCK_COUNT blocks.  A block is
+			returned to user space as soon as it is full, or after
+			niRING_RETIRE_MS, so that a batch of frames is handled in one go
+			while a lone frame is not delayed for long. */
+			memset( &xRing, '\0', sizeof( xRing ) );
+			xRing.tp_block_size = niRING_BLOCK_SIZE;
+			xRing.tp_block_nr = niRING_BLOCK_COUNT;
+			xRing.tp_frame_size = niRING_FRAME_SIZE;
+			xRing.tp_frame_nr = ( niRING_BLOCK_SIZE / niRING_FRAME_SIZE ) * niRING_BLOCK_COUNT;
+			xRing.tp_retire_blk_tov = niRING_RETIRE_MS;
+
+			if( setsockopt( iFd, SOL_PACKET, PACKET_RX_RING, &xRing, sizeof( xRing ) ) < 0 )
+			{
+				pcFailure = "PACKET_RX_RING";
+			}
+		}
+
+		if( pcFailure == NULL )
+		{
+			pvRing = mmap( NULL, ( size_t ) niRING_BLOCK_SIZE * niRING_BLOCK_COUNT, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0 );
+
+			if( pvRing == MAP_FAILED )
+			{
+				pcFailure = "mmap";
+			}
+			else
+			{
+				pucRxRing = ( uint8_t * ) pvRing;
+				ulRxBlockIndex = 0u;
+			}
+		}
+
+		if( pcFailure == NULL )
+		{
+			memset( &xAddress, '\0', sizeof( xAddress ) );
+			xAddress.sll_family = AF_PACKET;
+			xAddress.sll_protocol = htons( ETH_P_ALL );
+			xAddress.sll_ifindex = ( int ) uiInterfaceIndex;
+
+			/* The MAC address of the stack is not the one of the host
+			interface, so the interface must be promiscuous. */
+			memset( &xMembership, '\0', sizeof( xMembership ) );
+			xMembership.mr_ifindex = ( int ) uiInterfaceIndex;
+			xMembership.mr_type = PACKET_MR_PROMISC;
+
+			if( bind( iFd, ( struct sockaddr * ) &xAddress, sizeof( xAddress ) ) < 0 )
+			{
+				pcFailure = "bind";
+			}
+			else if( setsockopt( iFd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &xMembership, sizeof( xMembership ) ) < 0 )
+			{
+				pcFailure = "PACKET_ADD_MEMBERSHIP";
+			}
+			else
+			{
+				/* Sending is faster without the queueing discipline.  This is
+				optional, older kernels do not know the option. */
+				( void ) setsockopt( iFd, SOL_PACKET, PACKET_QDISC_BYPASS, &iOne, sizeof( iOne ) );
+			}
+		}
+
+		if( pcFailure != NULL )
+		{
+			FreeRTOS_printf( ( "prvOpenPacketSocket: %s: %s: %s\n", configLINUX_NETWORK_INTERFACE_NAME, pcFailure, strerror( errno ) ) );
+
+			if( pucRxRing != NULL )
+			{
+				munmap( pucRxRing, ( size_t ) niRING_BLOCK_SIZE * niRING_BLOCK_COUNT );
+				pucRxRing = NULL;
+			}
+
+			if( iFd >= 0 )
+			{
+				close( iFd );
+				iFd = -1;
+			}
+		}
+
+		return iFd;
+	}
+
+#endif /* configLINUX_USE_TAP_DEVICE == 0 */
+/*-----------------------------------------------------------*/
+
+static void prvInterruptSimulatorTask( void *pvParameters )
+{
+BaseType_t xCount;
+
+	/* Remove compiler warnings about unused parameters. */
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		#if( configLINUX_USE_TAP_DEVICE != 0 )
+		{
+			xCount = prvReadTapFrames();
+		}
+		#else
+		{
+			xCount = prvReadRingBlocks();
+		}
+		#endif
+
+		if( xCount == 0 )
+		{
+			/* The host interface is polled without blocking, as a blocking
+			system call would stop the scheduler of the simulator.  Make sure
+			other tasks can run. */
+			vTaskDelay( configLINUX_MAC_INTERRUPT_SIMULATOR_DELAY );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+#if( configLINUX_USE_TAP_DEVICE != 0 )
+
+	static BaseType_t prvReadTapFrames( void )
+	{
+	BaseType_t xCount;
+	ssize_t xLength;
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	#if( ipconfigZERO_COPY_RX_DRIVER == 0 )
+		static uint8_t ucRecvBuffer[ ipTOTAL_ETHERNET_FRAME_SIZE ];
+	#endif
+
+		for( xCount = 0; xCount < niMAX_TAP_FRAMES_PER_POLL; xCount++ )
+		{
+			#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
+			{
+				/* Read the frame straight into a network buffer, which is
+				passed to the IP task without being copied. */
+				if( pxNextRxBuffer == NULL )
+				{
+					pxNextRxBuffer = pxGetNetworkBufferWithDescriptor( ipTOTAL_ETHERNET_FRAME_SIZE, 0 );
+
+					if( pxNextRxBuffer == NULL )
+					{
+						/* Try again after the IP task released some buffers,
+						the frames stay in the TAP queue meanwhile. */
+						iptraceETHERNET_RX_EVENT_LOST();
+						break;
+					}
+				}
+
+				xLength = read( iNetworkFd, pxNextRxBuffer->pucEthernetBuffer, ipTOTAL_ETHERNET_FRAME_SIZE );
+			}
+			#else
+			{
+				xLength = read( iNetworkFd, ucRecvBuffer, sizeof( ucRecvBuffer ) );
+			}
+			#endif
+
+			if( xLength <= 0 )
+			{
+				/* EAGAIN: no more frames.  EINTR: the read was interrupted by
+				the tick signal of the simulator, try again later. */
+				break;
+			}
+
+			iptraceNETWORK_INTERFACE_RECEIVE();
+
+			if( ( size_t ) xLength < sizeof( EthernetHeader_t ) )
+			{
+				continue;
+			}
+
+			#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
+			{
+				if( ipCONSIDER_FRAME_FOR_PROCESSING( pxNextRxBuffer->pucEthernetBuffer ) == eProcessBuffer )
+				{
+					pxNetworkBuffer = pxNextRxBuffer;
+					pxNextRxBuffer = NULL;
+				}
+				else
+				{
+					/* The buffer will be used for the next frame. */
+					pxNetworkBuffer = NULL;
+				}
+			}
+			#else
+			{
+				pxNetworkBuffer = NULL;
+
+				if( ipCONSIDER_FRAME_FOR_PROCESSING( ucRecvBuffer ) == eProcessBuffer )
+				{
+					pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( ( size_t ) xLength, 0 );
+
+					if( pxNetworkBuffer != NULL )
+					{
+						memcpy( pxNetworkBuffer->pucEthernetBuffer, ucRecvBuffer, ( size_t ) xLength );
+					}
+					else
+					{
+						ulLinuxReceiveDrops++;
+						iptraceETHERNET_RX_EVENT_LOST();
+					}
+				}
+			}
+			#endif
+
+			if( pxNetworkBuffer != NULL )
+			{
+				pxNetworkBuffer->xDataLength = ( size_t ) xLength;
+				prvQueueReceivedFrame( pxNetworkBuffer );
+			}
+		}
+
+		prvFlushReceivedFrames();
+
+		return xCount;
+	}
+
+#endif /* configLINUX_USE_TAP_DEVICE != 0 */
+/*-----------------------------------------------------------*/
+
+#if( configLINUX_USE_TAP_DEVICE == 0 )
+
+	static BaseType_t prvReadRingBlocks( void )
+	{
+	BaseType_t xCount = 0;
+	struct tpacket_block_desc *pxBlock;
+	RingFrame_t xFrame, xNextFrame;
+	const uint8_t *pucLimit;
+	uint32_t ulIndex, ulFrameCount;
+
+		for( ;; )
+		{
+			pxBlock = ( struct tpacket_block_desc * ) ( pucRxRing + ( ( size_t ) ulRxBlockIndex * niRING_BLOCK_SIZE ) );
+
+			/* The status is written by the kernel after it has filled the
+			block.  The acquire makes sure the frames are read after it. */
+			if( ( __atomic_load_n( &( pxBlock->hdr.bh1.block_status ), __ATOMIC_ACQUIRE ) & TP_STATUS_USER ) == 0u )
+			{
+				break;
+			}
+
+			#if( niRING_LENDS_FRAMES != 0 )
+			{
+				/* A block that still has frames lent out was read before, the
+				kernel is waiting for it as well. */
+				if( pxBlock->hdr.bh1.seq_num == ullBlockSequence[ ulRxBlockIndex ] )
+				{
+					break;
+				}
+
+				ullBlockSequence[ ulRxBlockIndex ] = pxBlock->hdr.bh1.seq_num;
+
+				/* The reference of the reader, dropped below. */
+				ulBlockUsers[ ulRxBlockIndex ] = 1u;
+			}
+			#endif
+
+			ulFrameCount = pxBlock->hdr.bh1.num_pkts;
+
+			if( ulFrameCount != 0u )
+			{
+				prvRingFrameGet( ( const struct tpacket3_hdr * ) ( ( ( const uint8_t * ) pxBlock ) + pxBlock->hdr.bh1.offset_to_first_pkt ), &xNextFrame );
+			}
+
+			for( ulIndex = 0u; ulIndex < ulFrameCount; ulIndex++ )
+			{
+				xFrame = xNextFrame;
+
+				/* The next frame is looked at before this one is handed over.
+				The stack may write a longer reply into a lent frame, which
+				overwrites the header of the next frame, up to its data. */
+				if( ( ulIndex + 1u ) < ulFrameCount )
+				{
+					prvRingFrameGet( xFrame.pxNext, &xNextFrame );
+					pucLimit = xNextFrame.pucData - ipBUFFER_PADDING;
+				}
+				else
+				{
+					pucLimit = ( ( const uint8_t * ) pxBlock ) + niRING_BLOCK_SIZE;
+				}
+
+				/* Frames sent by the host itself are seen on the interface as
+				well, they are not meant for this stack. */
+				if( xFrame.ucPacketType != PACKET_OUTGOING )
+				{
+					prvReadRingFrame( xFrame.pucData, xFrame.xLength, pucLimit, ulRxBlockIndex );
+				}
+			}
+
+			/* All frames of the block are passed to the IP task as one
+			batch. */
+			prvFlushReceivedFrames();
+			xCount += ( BaseType_t ) ulFrameCount;
+
+			#if( niRING_LENDS_FRAMES != 0 )
+			{
+				/* When frames were lent, the block goes back to the kernel
+				once the last of them has been released. */
+				prvRingBlockRelease( ulRxBlockIndex );
+			}
+			#else
+			{
+				/* Return the block to the kernel. */
+				__atomic_store_n( &( pxBlock->hdr.bh1.block_status ), TP_STATUS_KERNEL, __ATOMIC_RELEASE );
+			}
+			#endif
+
+			ulRxBlockIndex = ( ulRxBlockIndex + 1u ) % niRING_BLOCK_COUNT;
+		}
+
+		return xCount;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvRingFrameGet( const struct tpacket3_hdr *pxFrame, RingFrame_t *pxRingFrame )
+	{
+	const struct sockaddr_ll *pxSource;
+
+		/* The link layer address follows the frame header. */
+		pxSource = ( const struct sockaddr_ll * ) ( ( ( const uint8_t * ) pxFrame ) + TPACKET_ALIGN( sizeof( *pxFrame ) ) );
+
+		pxRingFrame->pucData = ( ( uint8_t * ) pxFrame ) + pxFrame->tp_mac;
+		pxRingFrame->xLength = ( size_t ) pxFrame->tp_snaplen;
+		pxRingFrame->ucPacketType = pxSource->sll_pkttype;
+		pxRingFrame->pxNext = ( const struct tpacket3_hdr * ) ( ( ( const uint8_t * ) pxFrame ) + pxFrame->tp_next_offset );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvReadRingFrame( uint8_t *pucData, size_t xLength, const uint8_t *pucLimit, uint32_t ulBlock )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+
+		iptraceNETWORK_INTERFACE_RECEIVE();
+
+		#if( niRING_LENDS_FRAMES == 0 )
+		{
+			( void ) pucLimit;
+			( void ) ulBlock;
+		}
+		#endif
+
+		if( ( xLength >= sizeof( EthernetHeader_t ) ) &&
+			( xLength <= ( size_t ) ipTOTAL_ETHERNET_FRAME_SIZE ) &&
+			( ipCONSIDER_FRAME_FOR_PROCESSING( pucData ) == eProcessBuffer ) )
+		{
+			pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( xLength, 0 );
+
+			if( pxNetworkBuffer != NULL )
+			{
+				#if( niRING_LENDS_FRAMES != 0 )
+				if( prvRingFrameMayBeLent( pucData, xLength, pucLimit ) != pdFALSE )
+				{
+					prvRingFrameLend( pxNetworkBuffer, pucData, ulBlock );
+				}
+				else
+				#endif
+				{
+					memcpy( pxNetworkBuffer->pucEthernetBuffer, pucData, xLength );
+				}
+
+				pxNetworkBuffer->xDataLength = xLength;
+				prvQueueReceivedFrame( pxNetworkBuffer );
+			}
+			else
+			{
+				ulLinuxReceiveDrops++;
+				iptraceETHERNET_RX_EVENT_LOST();
+			}
+		}
+	}
+
+#endif /* configLINUX_USE_TAP_DEVICE == 0 */
+/*-----------------------------------------------------------*/
+
+#if( niRING_LENDS_FRAMES != 0 )
+
+	static BaseType_t prvRingFrameMayBeLent( const uint8_t *pucData, size_t xLength, const uint8_t *pucLimit )
+	{
+	const IPPacket_t *pxIPPacket = ( const IPPacket_t * ) pucData;
+	BaseType_t xReturn = pdFALSE;
+
+		/* Only TCP segments are lent.  The IP task releases them as soon
+		as they have been handled.  Other frames, such as UDP packets, may
+		wait in a socket for a long time, and the kernel can not pass the
+		block that holds them.  The same is true for TCP segments when
+		ipconfigUSE_TCP_ZERO_COPY_RX is defined. */
+		#if( ipconfigUSE_TCP_ZERO_COPY_RX == 0 )
+		{
+			if( ( xLength >= sizeof( IPPacket_t ) ) &&
+				( pxIPPacket->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE ) &&
+				( pxIPPacket->xIPHeader.ucProtocol == ( uint8_t ) ipPROTOCOL_TCP ) &&
+				( __atomic_load_n( &ulHeldBlocks, __ATOMIC_RELAXED ) < ( uint32_t ) niRING_MAX_HELD_BLOCKS ) &&
+				( pucLimit >= ( pucData + ipTOTAL_ETHERNET_FRAME_SIZE ) ) &&
+				( ( ( ( uintptr_t ) pucData ) - ipBUFFER_PADDING ) % sizeof( void * ) == 0u ) )
+			{
+				/* The stack may write a full frame without reaching the
+				next frame, and there is an aligned place in front of the
+				frame for the pointer to the network buffer. */
+				xReturn = pdTRUE;
+			}
+		}
+		#else
+		{
+			( void ) pxIPPacket;
+			( void ) xLength;
+			( void ) pucLimit;
+		}
+		#endif
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvRingFrameLend( NetworkBufferDescriptor_t *pxNetworkBuffer, uint8_t *pucData, uint32_t ulBlock )
+	{
+	size_t uxIndex = ( size_t ) ( pxNetworkBuffer - pxRxDescriptors );
+
+		/* The reference of the reader is still held, the block can not go
+		back to the kernel meanwhile. */
+		if( ucBlockLent[ ulBlock ] == 0u )
+		{
+			ucBlockLent[ ulBlock ] = 1u;
+			( void ) __atomic_add_fetch( &ulHeldBlocks, 1u, __ATOMIC_RELAXED );
+		}
+
+		( void ) __atomic_add_fetch( &( ulBlockUsers[ ulBlock ] ), 1u, __ATOMIC_RELAXED );
+		ulLentFromBlock[ uxIndex ] = ulBlock + 1u;
+
+		/* Just like in the storage of the network buffer, the frame is
+		preceded by a pointer to the network buffer. */
+		*( ( NetworkBufferDescriptor_t ** ) ( pucData - ipBUFFER_PADDING ) ) = pxNetworkBuffer;
+		pxNetworkBuffer->pucEthernetBuffer = pucData;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvRingBlockRelease( uint32_t ulBlock )
+	{
+	struct tpacket_block_desc *pxBlock;
+
+		if( __atomic_sub_fetch( &( ulBlockUsers[ ulBlock ] ), 1u, __ATOMIC_ACQ_REL ) == 0u )
+		{
+			if( ucBlockLent[ ulBlock ] != 0u )
+			{
+				ucBlockLent[ ulBlock ] = 0u;
+				( void ) __atomic_sub_fetch( &ulHeldBlocks, 1u, __ATOMIC_RELAXED );
+			}
+
+			/* No frame of the block is in use any more.  The release
+			makes sure that the kernel sees the status after the last
+			write of the stack into the block. */
+			pxBlock = ( struct tpacket_block_desc * ) ( pucRxRing + ( ( size_t ) ulBlock * niRING_BLOCK_SIZE ) );
+			__atomic_store_n( &( pxBlock->hdr.bh1.block_status ), TP_STATUS_KERNEL, __ATOMIC_RELEASE );
+		}
+	}
+
+#endif /* niRING_LENDS_FRAMES */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigDRIVER_LENDS_RX_BUFFERS != 0 )
+
+	void vNetworkInterfaceReleaseRxBuffer( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+	{
+		#if( niRING_LENDS_FRAMES != 0 )
+		{
+		size_t uxIndex = ( size_t ) ( pxNetworkBuffer - pxRxDescriptors );
+		uint32_t ulBlock;
+
+			/* The exchange makes sure that a buffer that is released twice
+			gives its block back once. */
+			ulBlock = __atomic_exchange_n( &( ulLentFromBlock[ uxIndex ] ), 0u, __ATOMIC_ACQ_REL );
+
+			if( ulBlock != 0u )
+			{
+				pxNetworkBuffer->pucEthernetBuffer = pucRxDescriptorStorage + ( uxIndex * niBUFFER_1_PACKET_SIZE ) + ipBUFFER_PADDING;
+				prvRingBlockRelease( ulBlock - 1u );
+			}
+		}
+		#else
+		{
+			/* A TAP device reads frames straight into network buffers, there
+			is no memory to take back. */
+			( void ) pxNetworkBuffer;
+		}
+		#endif
+	}
+
+#endif /* ipconfigDRIVER_LENDS_RX_BUFFERS */
+/*-----------------------------------------------------------*/
+
+static void prvQueueReceivedFrame( NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		pxNetworkBuffer->pxNextBuffer = NULL;
+
+		if( pxRxChainHead == NULL )
+		{
+			pxRxChainHead = pxNetworkBuffer;
+		}
+		else
+		{
+			pxRxChainTail->pxNextBuffer = pxNetworkBuffer;
+		}
+
+		pxRxChainTail = pxNetworkBuffer;
+	}
+	#else
+	{
+		prvSendToIPTask( pxNetworkBuffer );
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvFlushReceivedFrames( void )
+{
+	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	{
+		if( pxRxChainHead != NULL )
+		{
+			prvSendToIPTask( pxRxChainHead );
+			pxRxChainHead = NULL;
+			pxRxChainTail = NULL;
+		}
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendToIPTask( NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+IPStackEvent_t xRxEvent;
+#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+	NetworkBufferDescriptor_t *pxNextBuffer;
+#endif
+
+	xRxEvent.eEventType = eNetworkRxEvent;
+	xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+	if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+	{
+		/* The buffers could not be sent to the stack so must be released
+		again.  This is only an interrupt simulator, not a real interrupt, so
+		it is ok to use the task level function here. */
+		#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+		{
+			while( pxNetworkBuffer != NULL )
+			{
+				pxNextBuffer = pxNetworkBuffer->pxNextBuffer;
+				vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+				ulLinuxReceiveDrops++;
+				pxNetworkBuffer = pxNextBuffer;
+			}
+		}
+		#else
+		{
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			ulLinuxReceiveDrops++;
+		}
+		#endif
+
+		iptraceETHERNET_RX_EVENT_LOST();
+	}
+}
+/*-----------------------------------------------------------*/
@@ -30,9 +30,71 @@ uint32_t TEST_FreeRTOS_TCP_prvParseDNSReply( uint8_t * pucUDPPayloadBuffer,
                                              size_t xBufferLength,
                                              TickType_t xIdentifier );
 
+#if ( ipconfigUSE_DNS_CACHE == 1 )
+    BaseType_t TEST_FreeRTOS_TCP_prvProcessDNSCache( const char * pcName,
+                                                     uint32_t * pulIP,
+                                                     uint32_t ulTTL,
+                                                     BaseType_t xLookUp );
+
+    uint32_t TEST_FreeRTOS_TCP_prvDNSNameHash( const char * pcName );
+#endif /* ipconfigUSE_DNS_CACHE */
+
 void TEST_FreeRTOS_TCP_prvCheckOptions( FreeRTOS_Socket_t * pxSocket,
                                         NetworkBufferDescriptor_t * pxNetworkBuffer );
 
 void TEST_FreeRTOS_TCP_prvTCPCreateWindow( FreeRTOS_Socket_t * pxSocket );
 
+int32_t TEST_FreeRTOS_TCP_prvTCPSendRepeated( FreeRTOS_Socket_t * pxSocket,
+                                              NetworkBufferDescriptor_t ** ppxNetworkBuffer );
+
+#if ( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+    void TEST_FreeRTOS_TCP_vSynCacheClear( void );
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+
+#if ( ipconfigTCP_SYN_COOKIES != 0 )
+    uint32_t TEST_FreeRTOS_TCP_prvSynCookieCreate( const TCPPacket_t * pxTCPPacket,
+                                                   uint16_t * pusMSS );
+
+    BaseType_t TEST_FreeRTOS_TCP_prvSynCookieCheck( const TCPPacket_t * pxTCPPacket,
+                                                    uint16_t * pusMSS );
+#endif /* ipconfigTCP_SYN_COOKIES */
+
+#if ( ipconfigUSE_TCP_FAST_OPEN != 0 )
+    void TEST_FreeRTOS_TCP_vFastOpenCacheClear( void );
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
+void TEST_FreeRTOS_TCP_vSetIPTaskInitialised( BaseType_t xInitialised );
+
+UBaseType_t TEST_FreeRTOS_TCP_prvHandleIPEvent( IPStackEvent_t * pxReceivedEvent,
+                                               UBaseType_t uxMaxCount );
+
+#if ( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+    UBaseType_t TEST_FreeRTOS_TCP_prvHandlePendingRxChain( void );
+
+    NetworkBufferDescriptor_t * TEST_FreeRTOS_TCP_pxPendingRxChain( void );
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+#if ( ipconfigUSE_IP_REASSEMBLY != 0 )
+    void TEST_FreeRTOS_TCP_vIPReassemblyInit( void );
+
+    eFrameProcessingResult_t TEST_FreeRTOS_TCP_prvIPReassemble( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                                                UBaseType_t uxHeaderLength );
+
+    void TEST_FreeRTOS_TCP_prvIPReassemblyCheck( void );
+
+    UBaseType_t TEST_FreeRTOS_TCP_uxIPReassemblyBuffers( void );
+
+    BaseType_t TEST_FreeRTOS_TCP_xIPReassemblyTimerActive( void );
+#endif /* ipconfigUSE_IP_REASSEMBLY */
+
+#if ( ipconfigUSE_TX_SCHEDULER != 0 )
+    void TEST_FreeRTOS_TCP_vTxSchedulerInit( void );
+
+    void TEST_FreeRTOS_TCP_prvTxSchedulerRun( void );
+
+    UBaseType_t TEST_FreeRTOS_TCP_uxTxSchedulerWaiting( void );
+
+    BaseType_t TEST_FreeRTOS_TCP_xTxDriverBusy( void );
+#endif /* ipconfigUSE_TX_SCHEDULER */
+
 #endif /* ifndef _AWS_FREERTOS_TCP_TEST_ACCESS_DECLARE_H_ */
@@ -0,0 +1,145 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2019 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file iot_freertos_tcp_test_access_ip_define.h
+ * @brief Function wrappers that access private members of FreeRTOS_IP.c.
+ *
+ * Needed for testing private functions.
+ */
+
+#ifndef _AWS_FREERTOS_TCP_TEST_ACCESS_IP_DEFINE_H_
+#define _AWS_FREERTOS_TCP_TEST_ACCESS_IP_DEFINE_H_
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/*-----------------------------------------------------------*/
+
+void TEST_FreeRTOS_TCP_vSetIPTaskInitialised( BaseType_t xInitialised )
+{
+    xIPTaskInitialised = xInitialised;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t TEST_FreeRTOS_TCP_prvHandleIPEvent( IPStackEvent_t * pxReceivedEvent,
+                                               UBaseType_t uxMaxCount )
+{
+    return prvHandleIPEvent( pxReceivedEvent, uxMaxCount );
+}
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+    UBaseType_t TEST_FreeRTOS_TCP_prvHandlePendingRxChain( void )
+    {
+        return prvHandlePendingRxChain();
+    }
+    /*-----------------------------------------------------------*/
+
+    NetworkBufferDescriptor_t * TEST_FreeRTOS_TCP_pxPendingRxChain( void )
+    {
+        return pxPendingRxChain;
+    }
+    /*-----------------------------------------------------------*/
+#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+#if ( ipconfigUSE_IP_REASSEMBLY != 0 )
+    void TEST_FreeRTOS_TCP_vIPReassemblyInit( void )
+    {
+        BaseType_t xIndex;
+
+        for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigIP_REASSEMBLY_MAX_PACKETS; xIndex++ )
+        {
+            vListInitialise( &( xReassemblyTable[ xIndex ].xFragments ) );
+        }
+
+        uxReassemblyBuffers = 0u;
+        xReassemblyTimer.bActive = pdFALSE_UNSIGNED;
+    }
+    /*-----------------------------------------------------------*/
+
+    eFrameProcessingResult_t TEST_FreeRTOS_TCP_prvIPReassemble( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                                                UBaseType_t uxHeaderLength )
+    {
+        return prvIPReassemble( pxNetworkBuffer, uxHeaderLength );
+    }
+    /*-----------------------------------------------------------*/
+
+    void TEST_FreeRTOS_TCP_prvIPReassemblyCheck( void )
+    {
+        prvIPReassemblyCheck();
+    }
+    /*-----------------------------------------------------------*/
+
+    UBaseType_t TEST_FreeRTOS_TCP_uxIPReassemblyBuffers( void )
+    {
+        return uxReassemblyBuffers;
+    }
+    /*-----------------------------------------------------------*/
+
+    BaseType_t TEST_FreeRTOS_TCP_xIPReassemblyTimerActive( void )
+    {
+        return ( xReassemblyTimer.bActive != pdFALSE_UNSIGNED ) ? pdTRUE : pdFALSE;
+    }
+    /*-----------------------------------------------------------*/
+#endif /* ipconfigUSE_IP_REASSEMBLY */
+
+#if ( ipconfigUSE_TX_SCHEDULER != 0 )
+    void TEST_FreeRTOS_TCP_vTxSchedulerInit( void )
+    {
+        UBaseType_t uxBand;
+
+        for( uxBand = 0u; uxBand < ipTX_BAND_COUNT; uxBand++ )
+        {
+            vListInitialise( &( xTxBands[ uxBand ].xPackets ) );
+            xTxBands[ uxBand ].lDeficit = 0;
+        }
+
+        uxTxWaiting = 0u;
+        uxTxBudget = ( UBaseType_t ) ipconfigTX_SCHEDULER_BURST;
+        uxTxCurrentBand = ipTX_BAND_INTERACTIVE;
+        xTxDriverBusy = pdFALSE;
+    }
+    /*-----------------------------------------------------------*/
+
+    void TEST_FreeRTOS_TCP_prvTxSchedulerRun( void )
+    {
+        prvTxSchedulerRun();
+    }
+    /*-----------------------------------------------------------*/
+
+    UBaseType_t TEST_FreeRTOS_TCP_uxTxSchedulerWaiting( void )
+    {
+        return uxTxWaiting;
+    }
+    /*-----------------------------------------------------------*/
+
+    BaseType_t TEST_FreeRTOS_TCP_xTxDriverBusy( void )
+    {
+        return xTxDriverBusy;
+    }
+    /*-----------------------------------------------------------*/
+#endif /* ipconfigUSE_TX_SCHEDULER */
+
+#endif /* ifndef _AWS_FREERTOS_TCP_TEST_ACCESS_IP_DEFINE_H_ */
@@ -50,4 +50,43 @@ void TEST_FreeRTOS_TCP_prvTCPCreateWindow( FreeRTOS_Socket_t * pxSocket )
 }
 /*-----------------------------------------------------------*/
 
+int32_t TEST_FreeRTOS_TCP_prvTCPSendRepeated( FreeRTOS_Socket_t * pxSocket,
+                                              NetworkBufferDescriptor_t ** ppxNetworkBuffer )
+{
+    return prvTCPSendRepeated( pxSocket, ppxNetworkBuffer );
+}
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigTCP_SYN_CACHE_SIZE > 0 )
+    void TEST_FreeRTOS_TCP_vSynCacheClear( void )
+    {
+        memset( xSynCache, 0, sizeof( xSynCache ) );
+    }
+    /*-----------------------------------------------------------*/
+#endif /* ipconfigTCP_SYN_CACHE_SIZE */
+
+#if ( ipconfigTCP_SYN_COOKIES != 0 )
+    uint32_t TEST_FreeRTOS_TCP_prvSynCookieCreate( const TCPPacket_t * pxTCPPacket,
+                                                   uint16_t * pusMSS )
+    {
+        return prvSynCookieCreate( pxTCPPacket, pusMSS );
+    }
+    /*-----------------------------------------------------------*/
+
+    BaseType_t TEST_FreeRTOS_TCP_prvSynCookieCheck( const TCPPacket_t * pxTCPPacket,
+                                                    uint16_t * pusMSS )
+    {
+        return prvSynCookieCheck( pxTCPPacket, pusMSS );
+    }
+    /*-----------------------------------------------------------*/
+#endif /* ipconfigTCP_SYN_COOKIES */
+
+#if ( ipconfigUSE_TCP_FAST_OPEN != 0 )
+    void TEST_FreeRTOS_TCP_vFastOpenCacheClear( void )
+    {
+        memset( xFastOpenCache, 0, sizeof( xFastOpenCache ) );
+    }
+    /*-----------------------------------------------------------*/
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
 #endif /* ifndef _AWS_FREERTOS_TCP_TEST_ACCESS_TCP_DEFINE_H_ */
@@ -25,6 +25,7 @@
 
 /* Standard includes. */
 #include <stdint.h>
+#include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
 
@@ -44,6 +45,53 @@
  * @brief Configuration for this test group.
  */
 
+/* The option kinds, as they appear on the wire. */
+#define tcptestOPT_NOOP         1u
+#define tcptestOPT_MSS          2u
+#define tcptestOPT_WSOPT        3u
+#define tcptestOPT_SACK_P       4u
+#define tcptestOPT_SACK_A       5u
+#define tcptestOPT_TIMESTAMP    8u
+
+/* Room for a TCP packet with the maximum of 40 bytes of options. */
+#define tcptestOPTIONS_PACKET_SIZE \
+    ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + 40u )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Prepare a socket and a TCP packet that carries the given options,
+ * then let prvCheckOptions() parse them.
+ *
+ * @param[in] pxSocket The socket, of which only the state is set by the caller.
+ * @param[in] pucOptions The option bytes, a multiple of 4.
+ * @param[in] uxOptionsLength The length of pucOptions.
+ * @param[in] uxDataLength The length of the received packet, which may be
+ * shorter than the options claim.
+ */
+static void prvCheckTCPOptions( FreeRTOS_Socket_t * pxSocket,
+                                const uint8_t * pucOptions,
+                                size_t uxOptionsLength,
+                                size_t uxDataLength )
+{
+    uint8_t ucPacket[ tcptestOPTIONS_PACKET_SIZE ];
+    TCPPacket_t * pxTCPPacket = ( TCPPacket_t * ) ucPacket;
+    NetworkBufferDescriptor_t xNetworkBuffer;
+
+    memset( ucPacket, 0, sizeof( ucPacket ) );
+    pxTCPPacket->xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) / 4u ) << 4 );
+    memcpy( &( ucPacket[ ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER ] ), pucOptions, uxOptionsLength );
+
+    memset( &xNetworkBuffer, 0, sizeof( xNetworkBuffer ) );
+    xNetworkBuffer.pucEthernetBuffer = ucPacket;
+    xNetworkBuffer.xDataLength = uxDataLength;
+
+    pxSocket->u.xTCP.usInitMSS = ipconfigTCP_MSS;
+    pxSocket->u.xTCP.usCurMSS = ipconfigTCP_MSS;
+    TEST_FreeRTOS_TCP_prvTCPCreateWindow( pxSocket );
+    TEST_FreeRTOS_TCP_prvCheckOptions( pxSocket, &xNetworkBuffer );
+}
+
 /*
  * @brief Test group definition.
  */
@@ -63,8 +111,16 @@ TEST_GROUP_RUNNER( Full_FREERTOS_TCP )
     RUN_TEST_CASE( Full_FREERTOS_TCP, prvParseDnsResponse );
     RUN_TEST_CASE( Full_FREERTOS_TCP, ulDNSHandlePacket );
 
+    /* DNS cache tests. */
+    RUN_TEST_CASE( Full_FREERTOS_TCP, DNSCache_TTLExpiry );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, DNSCache_Negative );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, DNSCache_HashCollisions );
+
     /* prvCheckOptions test. */
     RUN_TEST_CASE( Full_FREERTOS_TCP, prvCheckOptions );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, prvCheckOptions_WindowScaling );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, prvCheckOptions_TimestampAndSACK );
+    RUN_TEST_CASE( Full_FREERTOS_TCP, prvCheckOptions_Truncated );
 
     /* xProcessReceivedUDPPacket test. */
     RUN_TEST_CASE( Full_FREERTOS_TCP, UDPPacketLength );
@@ -302,6 +358,141 @@ TEST( Full_FREERTOS_TCP, ulDNSHandlePacket )
     TEST_ASSERT_EQUAL_UINT32( 0, ulResult );
 }
 
+TEST( Full_FREERTOS_TCP, DNSCache_TTLExpiry )
+{
+    #if ( ipconfigUSE_DNS_CACHE == 1 )
+        uint32_t ulIPAddress;
+
+        FreeRTOS_dnsclear();
+
+        /* A record with a TTL of zero has expired at once. */
+        ulIPAddress = FreeRTOS_inet_addr_quick( 192, 168, 1, 10 );
+        ( void ) TEST_FreeRTOS_TCP_prvProcessDNSCache( "ttl0.example.com", &ulIPAddress, 0u, pdFALSE );
+        TEST_ASSERT_EQUAL_UINT32( 0UL, FreeRTOS_dnslookup( "ttl0.example.com" ) );
+
+        /* A record of 1 second can be found until that second has passed. */
+        ulIPAddress = FreeRTOS_inet_addr_quick( 192, 168, 1, 11 );
+        ( void ) TEST_FreeRTOS_TCP_prvProcessDNSCache( "ttl1.example.com", &ulIPAddress, 1u, pdFALSE );
+        TEST_ASSERT_EQUAL_UINT32( FreeRTOS_inet_addr_quick( 192, 168, 1, 11 ), FreeRTOS_dnslookup( "ttl1.example.com" ) );
+
+        vTaskDelay( pdMS_TO_TICKS( 2100u ) );
+        TEST_ASSERT_EQUAL_UINT32( 0UL, FreeRTOS_dnslookup( "ttl1.example.com" ) );
+
+        /* An update of an existing name takes the new address and TTL. */
+        ulIPAddress = FreeRTOS_inet_addr_quick( 192, 168, 1, 12 );
+        ( void ) TEST_FreeRTOS_TCP_prvProcessDNSCache( "ttl1.example.com", &ulIPAddress, 3600u, pdFALSE );
+        ulIPAddress = FreeRTOS_inet_addr_quick( 192, 168, 1, 13 );
+        ( void ) TEST_FreeRTOS_TCP_prvProcessDNSCache( "ttl1.example.com", &ulIPAddress, 3600u, pdFALSE );
+        TEST_ASSERT_EQUAL_UINT32( FreeRTOS_inet_addr_quick( 192, 168, 1, 13 ), FreeRTOS_dnslookup( "ttl1.example.com" ) );
+
+        FreeRTOS_dnsclear();
+    #else
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_DNS_CACHE is not enabled." );
+    #endif /* ipconfigUSE_DNS_CACHE */
+}
+
+TEST( Full_FREERTOS_TCP, DNSCache_Negative )
+{
+    #if ( ipconfigUSE_DNS_CACHE == 1 )
+        uint32_t ulIPAddress = 0UL;
+        BaseType_t xResult;
+
+        FreeRTOS_dnsclear();
+
+        /* An address of zero is stored as a negative entry: the look-up is a
+         * hit, but it finds no address. */
+        ( void ) TEST_FreeRTOS_TCP_prvProcessDNSCache( "nxdomain.example.com", &ulIPAddress, 30u, pdFALSE );
+        ulIPAddress = 0xffffffffUL;
+        xResult = TEST_FreeRTOS_TCP_prvProcessDNSCache( "nxdomain.example.com", &ulIPAddress, 0u, pdTRUE );
+        TEST_ASSERT_NOT_EQUAL( 0, xResult );
+        TEST_ASSERT_EQUAL_UINT32( 0UL, ulIPAddress );
+
+        /* A name that is not in the cache at all is a miss. */
+        xResult = TEST_FreeRTOS_TCP_prvProcessDNSCache( "unknown.example.com", &ulIPAddress, 0u, pdTRUE );
+        TEST_ASSERT_EQUAL( 0, xResult );
+
+        #if ( ipconfigDNS_USE_CALLBACKS == 0 )
+        {
+            TickType_t xStart = xTaskGetTickCount();
+
+            /* The negative hit fails at once, without sending a request and
+             * without waiting for a reply. */
+            TEST_ASSERT_EQUAL_UINT32( 0UL, FreeRTOS_gethostbyname( "nxdomain.example.com" ) );
+            TEST_ASSERT_TRUE( ( xTaskGetTickCount() - xStart ) < pdMS_TO_TICKS( 100u ) );
+        }
+        #endif /* ipconfigDNS_USE_CALLBACKS == 0 */
+
+        /* A positive answer replaces the negative entry. */
+        ulIPAddress = FreeRTOS_inet_addr_quick( 10, 0, 0, 1 );
+        ( void ) TEST_FreeRTOS_TCP_prvProcessDNSCache( "nxdomain.example.com", &ulIPAddress, 30u, pdFALSE );
+        TEST_ASSERT_EQUAL_UINT32( FreeRTOS_inet_addr_quick( 10, 0, 0, 1 ), FreeRTOS_dnslookup( "nxdomain.example.com" ) );
+
+        FreeRTOS_dnsclear();
+    #else
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_DNS_CACHE is not enabled." );
+    #endif /* ipconfigUSE_DNS_CACHE */
+}
+
+TEST( Full_FREERTOS_TCP, DNSCache_HashCollisions )
+{
+    #if ( ipconfigUSE_DNS_CACHE == 1 ) && ( ipconfigDNS_CACHE_ENTRIES >= 3 )
+        char pcNames[ 3 ][ 32 ];
+        uint32_t ulBucket, ulIPAddress, ulIndex;
+        BaseType_t xFound = 0;
+        BaseType_t x;
+
+        FreeRTOS_dnsclear();
+
+        /* Find three names that end up in the same bucket. */
+        ulBucket = TEST_FreeRTOS_TCP_prvDNSNameHash( "host0.example.com" ) % ipconfigDNS_CACHE_BUCKETS;
+
+        for( ulIndex = 0; ( ulIndex < 10000UL ) && ( xFound < 3 ); ulIndex++ )
+        {
+            snprintf( pcNames[ xFound ], sizeof( pcNames[ xFound ] ), "host%lu.example.com", ( unsigned long ) ulIndex );
+
+            if( ( TEST_FreeRTOS_TCP_prvDNSNameHash( pcNames[ xFound ] ) % ipconfigDNS_CACHE_BUCKETS ) == ulBucket )
+            {
+                xFound++;
+            }
+        }
+
+        TEST_ASSERT_EQUAL( 3, xFound );
+
+        for( x = 0; x < 3; x++ )
+        {
+            ulIPAddress = FreeRTOS_inet_addr_quick( 10, 0, 1, ( uint8_t ) ( x + 1 ) );
+            ( void ) TEST_FreeRTOS_TCP_prvProcessDNSCache( pcNames[ x ], &ulIPAddress, 3600u, pdFALSE );
+        }
+
+        /* Every name in the chain is found with its own address. */
+        for( x = 0; x < 3; x++ )
+        {
+            TEST_ASSERT_EQUAL_UINT32( FreeRTOS_inet_addr_quick( 10, 0, 1, ( uint8_t ) ( x + 1 ) ), FreeRTOS_dnslookup( pcNames[ x ] ) );
+        }
+
+        /* Let the row in the middle of the chain expire, it gets removed by
+         * the next look-up.  The other rows must stay reachable. */
+        ulIPAddress = FreeRTOS_inet_addr_quick( 10, 0, 1, 2 );
+        ( void ) TEST_FreeRTOS_TCP_prvProcessDNSCache( pcNames[ 1 ], &ulIPAddress, 0u, pdFALSE );
+        TEST_ASSERT_EQUAL_UINT32( 0UL, FreeRTOS_dnslookup( pcNames[ 1 ] ) );
+        TEST_ASSERT_EQUAL_UINT32( FreeRTOS_inet_addr_quick( 10, 0, 1, 1 ), FreeRTOS_dnslookup( pcNames[ 0 ] ) );
+        TEST_ASSERT_EQUAL_UINT32( FreeRTOS_inet_addr_quick( 10, 0, 1, 3 ), FreeRTOS_dnslookup( pcNames[ 2 ] ) );
+
+        /* The freed row can be used again, in the same bucket. */
+        ulIPAddress = FreeRTOS_inet_addr_quick( 10, 0, 1, 4 );
+        ( void ) TEST_FreeRTOS_TCP_prvProcessDNSCache( pcNames[ 1 ], &ulIPAddress, 3600u, pdFALSE );
+
+        for( x = 0; x < 3; x++ )
+        {
+            TEST_ASSERT_EQUAL_UINT32( FreeRTOS_inet_addr_quick( 10, 0, 1, ( uint8_t ) ( ( x == 1 ) ? 4 : ( x + 1 ) ) ), FreeRTOS_dnslookup( pcNames[ x ] ) );
+        }
+
+        FreeRTOS_dnsclear();
+    #else
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_DNS_CACHE is not enabled, or the cache is too small." );
+    #endif /* ipconfigUSE_DNS_CACHE && ipconfigDNS_CACHE_ENTRIES >= 3 */
+}
+
 TEST( Full_FREERTOS_TCP, prvCheckOptions )
 {
     uint8_t ucDivideByZero[] =
@@ -325,6 +516,140 @@ TEST( Full_FREERTOS_TCP, prvCheckOptions )
     TEST_FreeRTOS_TCP_prvCheckOptions( &xSocket, &xNetworkBuffer );
 }
 
+TEST( Full_FREERTOS_TCP, prvCheckOptions_WindowScaling )
+{
+    #if ( ipconfigUSE_TCP_WIN != 0 )
+        /* A shift count of 15 must be reduced to 14, RFC 7323 section 2.3. */
+        const uint8_t ucLargeShift[] =
+        {
+            tcptestOPT_NOOP, tcptestOPT_WSOPT, 3u, 15u
+        };
+        const uint8_t ucNormalShift[] =
+        {
+            tcptestOPT_NOOP, tcptestOPT_WSOPT, 3u, 7u
+        };
+        FreeRTOS_Socket_t xSocket;
+
+        memset( &xSocket, 0, sizeof( xSocket ) );
+        xSocket.u.xTCP.ucTCPState = eSYN_FIRST;
+        prvCheckTCPOptions( &xSocket, ucLargeShift, sizeof( ucLargeShift ), tcptestOPTIONS_PACKET_SIZE );
+        TEST_ASSERT_EQUAL_UINT8( 14u, xSocket.u.xTCP.ucPeerWinScaleFactor );
+        TEST_ASSERT_EQUAL( pdTRUE_UNSIGNED, xSocket.u.xTCP.bits.bWinScaling );
+
+        memset( &xSocket, 0, sizeof( xSocket ) );
+        xSocket.u.xTCP.ucTCPState = eCONNECT_SYN;
+        prvCheckTCPOptions( &xSocket, ucNormalShift, sizeof( ucNormalShift ), tcptestOPTIONS_PACKET_SIZE );
+        TEST_ASSERT_EQUAL_UINT8( 7u, xSocket.u.xTCP.ucPeerWinScaleFactor );
+
+        /* Outside the SYN phase, the option is ignored. */
+        memset( &xSocket, 0, sizeof( xSocket ) );
+        xSocket.u.xTCP.ucTCPState = eESTABLISHED;
+        prvCheckTCPOptions( &xSocket, ucNormalShift, sizeof( ucNormalShift ), tcptestOPTIONS_PACKET_SIZE );
+        TEST_ASSERT_EQUAL_UINT8( 0u, xSocket.u.xTCP.ucPeerWinScaleFactor );
+        TEST_ASSERT_EQUAL( pdFALSE_UNSIGNED, xSocket.u.xTCP.bits.bWinScaling );
+    #else
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_TCP_WIN is not enabled." );
+    #endif /* ipconfigUSE_TCP_WIN */
+}
+
+TEST( Full_FREERTOS_TCP, prvCheckOptions_TimestampAndSACK )
+{
+    #if ( ipconfigUSE_TCP_TIMESTAMPS != 0 ) && ( ipconfigUSE_TCP_WIN != 0 )
+        /* The options of a typical SYN: MSS, SACK permitted, time-stamp,
+         * NOP and window scaling. */
+        const uint8_t ucSynOptions[] =
+        {
+            tcptestOPT_MSS,       4u,   0x05u, 0xb4u,
+            tcptestOPT_SACK_P,    2u,
+            tcptestOPT_TIMESTAMP, 10u,  0x11u, 0x22u, 0x33u, 0x44u, 0x00u, 0x00u, 0x00u, 0x00u,
+            tcptestOPT_NOOP,
+            tcptestOPT_WSOPT,     3u,   6u
+        };
+        /* The options of a segment in an established connection: a
+         * time-stamp followed by a SACK block. */
+        const uint8_t ucSackOptions[] =
+        {
+            tcptestOPT_NOOP,      tcptestOPT_NOOP,
+            tcptestOPT_TIMESTAMP, 10u,  0x00u, 0x00u, 0x01u, 0x00u, 0x55u, 0x66u, 0x77u, 0x88u,
+            tcptestOPT_NOOP,      tcptestOPT_NOOP,
+            tcptestOPT_SACK_A,    10u,  0x00u, 0x00u, 0x10u, 0x00u, 0x00u, 0x00u, 0x20u, 0x00u
+        };
+        FreeRTOS_Socket_t xSocket;
+
+        memset( &xSocket, 0, sizeof( xSocket ) );
+        xSocket.u.xTCP.ucTCPState = eSYN_FIRST;
+        prvCheckTCPOptions( &xSocket, ucSynOptions, sizeof( ucSynOptions ), tcptestOPTIONS_PACKET_SIZE );
+        TEST_ASSERT_EQUAL( pdTRUE_UNSIGNED, xSocket.u.xTCP.bits.bTSReceived );
+        TEST_ASSERT_EQUAL_UINT32( 0x11223344UL, xSocket.u.xTCP.ulTSValue );
+        TEST_ASSERT_EQUAL_UINT32( 0UL, xSocket.u.xTCP.ulTSEcho );
+        /* The option after the time-stamp was parsed as well. */
+        TEST_ASSERT_EQUAL_UINT8( 6u, xSocket.u.xTCP.ucPeerWinScaleFactor );
+
+        memset( &xSocket, 0, sizeof( xSocket ) );
+        xSocket.u.xTCP.ucTCPState = eESTABLISHED;
+        prvCheckTCPOptions( &xSocket, ucSackOptions, sizeof( ucSackOptions ), tcptestOPTIONS_PACKET_SIZE );
+        TEST_ASSERT_EQUAL( pdTRUE_UNSIGNED, xSocket.u.xTCP.bits.bTSReceived );
+        TEST_ASSERT_EQUAL_UINT32( 0x00000100UL, xSocket.u.xTCP.ulTSValue );
+        TEST_ASSERT_EQUAL_UINT32( 0x55667788UL, xSocket.u.xTCP.ulTSEcho );
+    #else
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_TCP_TIMESTAMPS or ipconfigUSE_TCP_WIN is not enabled." );
+    #endif /* ipconfigUSE_TCP_TIMESTAMPS && ipconfigUSE_TCP_WIN */
+}
+
+TEST( Full_FREERTOS_TCP, prvCheckOptions_Truncated )
+{
+    #if ( ipconfigUSE_TCP_TIMESTAMPS != 0 ) && ( ipconfigUSE_TCP_WIN != 0 )
+        /* The time-stamp option needs 10 bytes, but the header ends after 6. */
+        const uint8_t ucShortTimestamp[] =
+        {
+            tcptestOPT_NOOP, tcptestOPT_NOOP,
+            tcptestOPT_TIMESTAMP, 10u, 0x11u, 0x22u, 0x33u, 0x44u
+        };
+        /* A time-stamp option with a wrong length field. */
+        const uint8_t ucBadTimestampLength[] =
+        {
+            tcptestOPT_NOOP, tcptestOPT_NOOP,
+            tcptestOPT_TIMESTAMP, 6u, 0x11u, 0x22u, 0x33u, 0x44u
+        };
+        /* The window scaling option is cut off after its length byte. */
+        const uint8_t ucShortWSOPT[] =
+        {
+            tcptestOPT_NOOP, tcptestOPT_NOOP, tcptestOPT_WSOPT, 3u
+        };
+        /* A complete option, but the packet is shorter than its header
+         * claims. */
+        const uint8_t ucTimestamp[] =
+        {
+            tcptestOPT_NOOP, tcptestOPT_NOOP,
+            tcptestOPT_TIMESTAMP, 10u, 0x11u, 0x22u, 0x33u, 0x44u, 0x00u, 0x00u, 0x00u, 0x00u
+        };
+        FreeRTOS_Socket_t xSocket;
+
+        memset( &xSocket, 0, sizeof( xSocket ) );
+        xSocket.u.xTCP.ucTCPState = eESTABLISHED;
+        prvCheckTCPOptions( &xSocket, ucShortTimestamp, sizeof( ucShortTimestamp ), tcptestOPTIONS_PACKET_SIZE );
+        TEST_ASSERT_EQUAL( pdFALSE_UNSIGNED, xSocket.u.xTCP.bits.bTSReceived );
+
+        memset( &xSocket, 0, sizeof( xSocket ) );
+        xSocket.u.xTCP.ucTCPState = eESTABLISHED;
+        prvCheckTCPOptions( &xSocket, ucBadTimestampLength, sizeof( ucBadTimestampLength ), tcptestOPTIONS_PACKET_SIZE );
+        TEST_ASSERT_EQUAL( pdFALSE_UNSIGNED, xSocket.u.xTCP.bits.bTSReceived );
+
+        memset( &xSocket, 0, sizeof( xSocket ) );
+        xSocket.u.xTCP.ucTCPState = eSYN_FIRST;
+        prvCheckTCPOptions( &xSocket, ucShortWSOPT, sizeof( ucShortWSOPT ), tcptestOPTIONS_PACKET_SIZE );
+        TEST_ASSERT_EQUAL( pdFALSE_UNSIGNED, xSocket.u.xTCP.bits.bWinScaling );
+
+        memset( &xSocket, 0, sizeof( xSocket ) );
+        xSocket.u.xTCP.ucTCPState = eESTABLISHED;
+        prvCheckTCPOptions( &xSocket, ucTimestamp, sizeof( ucTimestamp ),
+                            ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + 4u );
+        TEST_ASSERT_EQUAL( pdFALSE_UNSIGNED, xSocket.u.xTCP.bits.bTSReceived );
+    #else
+        TEST_IGNORE_MESSAGE( "ipconfigUSE_TCP_TIMESTAMPS or ipconfigUSE_TCP_WIN is not enabled." );
+    #endif /* ipconfigUSE_TCP_TIMESTAMPS && ipconfigUSE_TCP_WIN */
+}
+
 TEST( Full_FREERTOS_TCP, UDPPacketLength )
 {
     uint8_t ucBadUdpPacketA[] =
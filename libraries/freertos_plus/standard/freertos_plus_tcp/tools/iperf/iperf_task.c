@@ -0,0 +1,1464 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * An implementation of the iperf3 protocol on top of FreeRTOS+TCP sockets.
+ *
+ * A test is set up through a TCP control connection.  The client sends a
+ * cookie, the server asks for the test parameters (a JSON object), after which
+ * the client opens one or more data streams.  When the client has finished, it
+ * sends TEST_END, both sides exchange their results as JSON objects, and the
+ * client closes the connections.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "iperf_task.h"
+
+#if( ipconfigUSE_TCP != 1 ) || ( ipconfigSUPPORT_SELECT_FUNCTION != 1 )
+	#error iperf needs both ipconfigUSE_TCP and ipconfigSUPPORT_SELECT_FUNCTION
+#endif
+
+/* The port number on which the server listens, for both TCP and UDP. */
+#ifndef ipconfigIPERF_PORT
+	#define ipconfigIPERF_PORT				5201
+#endif
+
+#ifndef ipconfigIPERF_TASK_PRIORITY
+	#define ipconfigIPERF_TASK_PRIORITY		( tskIDLE_PRIORITY + 1 )
+#endif
+
+#ifndef ipconfigIPERF_STACK_SIZE
+	#define ipconfigIPERF_STACK_SIZE		( 4 * configMINIMAL_STACK_SIZE )
+#endif
+
+/* Buffer and window sizes of the TCP data streams. */
+#ifndef ipconfigIPERF_TX_BUFSIZE
+	#define ipconfigIPERF_TX_BUFSIZE		( 8 * ipconfigTCP_MSS )
+#endif
+
+#ifndef ipconfigIPERF_TX_WINSIZE
+	#define ipconfigIPERF_TX_WINSIZE		( 6 )
+#endif
+
+#ifndef ipconfigIPERF_RX_BUFSIZE
+	#define ipconfigIPERF_RX_BUFSIZE		( 8 * ipconfigTCP_MSS )
+#endif
+
+#ifndef ipconfigIPERF_RX_WINSIZE
+	#define ipconfigIPERF_RX_WINSIZE		( 6 )
+#endif
+
+/* The maximum number of parallel streams ("-P") of a test. */
+#ifndef ipconfigIPERF_MAX_STREAMS
+	#define ipconfigIPERF_MAX_STREAMS		( 4 )
+#endif
+
+/* The number of bytes passed to FreeRTOS_send() at once. */
+#ifndef ipconfigIPERF_BLOCK_SIZE
+	#define ipconfigIPERF_BLOCK_SIZE		( 4 * ipconfigTCP_MSS )
+#endif
+
+/* The time between two interval reports. */
+#ifndef ipconfigIPERF_INTERVAL_MS
+	#define ipconfigIPERF_INTERVAL_MS		( 1000 )
+#endif
+
+/* The states that are exchanged over the control connection. */
+#define iperfTEST_START					( ( int8_t ) 1 )
+#define iperfTEST_RUNNING				( ( int8_t ) 2 )
+#define iperfTEST_END					( ( int8_t ) 4 )
+#define iperfPARAM_EXCHANGE				( ( int8_t ) 9 )
+#define iperfCREATE_STREAMS				( ( int8_t ) 10 )
+#define iperfSERVER_TERMINATE			( ( int8_t ) 11 )
+#define iperfCLIENT_TERMINATE			( ( int8_t ) 12 )
+#define iperfEXCHANGE_RESULTS			( ( int8_t ) 13 )
+#define iperfDISPLAY_RESULTS			( ( int8_t ) 14 )
+#define iperfIPERF_DONE					( ( int8_t ) 16 )
+#define iperfACCESS_DENIED				( ( int8_t ) -1 )
+#define iperfSERVER_ERROR				( ( int8_t ) -2 )
+
+/* The state of the server when no test is running. */
+#define iperfIDLE						( ( int8_t ) 0 )
+
+/* A cookie is 36 printable characters and a terminating zero. */
+#define iperfCOOKIE_SIZE				37
+
+/* A UDP stream starts with a 4-byte datagram from the client, the server
+answers with a 4-byte reply.  The value of the reply is understood by old and
+new clients. */
+#define iperfUDP_CONNECT_REPLY			987654321uL
+
+/* A UDP datagram starts with the time it was sent and a packet counter of 32
+or 64 bits. */
+#define iperfUDP_HEADER_SIZE			12u
+#define iperfUDP_HEADER_SIZE_64			16u
+
+/* The time-out for the messages on the control connection. */
+#define iperfCONTROL_TIMEOUT_MS			5000u
+
+/* The maximum time FreeRTOS_select() will block, so that interval reports
+are printed on time. */
+#define iperfSELECT_TIMEOUT_MS			100u
+
+/* The size of the buffer in which JSON objects are composed or received. */
+#define iperfJSON_BUFFER_SIZE			( 192 + ( 192 * ipconfigIPERF_MAX_STREAMS ) )
+
+/* The number of characters needed to print a 64-bit number. */
+#define iperfU64_STRING_SIZE			21
+
+#if( configGENERATE_RUN_TIME_STATS == 1 ) && ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
+	/* The CPU load is derived from the run-time of the idle task. */
+	#define iperfHAS_CPU_LOAD			1
+#else
+	#define iperfHAS_CPU_LOAD			0
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Snapshot of the run-time counters, used to calculate the CPU load. */
+typedef struct xIPERF_CPU
+{
+	uint32_t ulIdleTime;
+	uint32_t ulTotalTime;
+} IPerfCPU_t;
+
+/* Counters of a single TCP or UDP data stream. */
+typedef struct xIPERF_STREAM
+{
+	Socket_t xSocket;				/* The TCP data connection, NULL for UDP. */
+	uint16_t usPeerPort;			/* The client port of a UDP stream, network order. */
+	uint64_t ullBytes;				/* Payload bytes sent or received. */
+	uint32_t ulRetransmits;			/* TCP segments retransmitted. */
+	uint32_t ulPackets;				/* UDP datagrams received. */
+	uint32_t ulErrors;				/* UDP datagrams lost. */
+	uint64_t ullNextPacket;			/* The expected UDP packet counter. */
+	int32_t lLastTransit;			/* The transit time of the last UDP datagram, in us. */
+	uint32_t ulJitter16;			/* The UDP jitter in us, multiplied by 16 (RFC 3550). */
+} IPerfStream_t;
+
+/* The state of one test, on either the server or the client side. */
+typedef struct xIPERF_TEST
+{
+	Socket_t xControlSocket;
+	char cCookie[ iperfCOOKIE_SIZE ];
+	int8_t cState;
+	BaseType_t xUseUDP;
+	BaseType_t xReverse;
+	BaseType_t xCounters64;
+	BaseType_t xIsSender;
+	BaseType_t xStreamCount;
+	BaseType_t xConnectedCount;
+	uint32_t ulSeconds;
+	IPerfStream_t xStreams[ ipconfigIPERF_MAX_STREAMS ];
+	TickType_t xStartTime;
+	TickType_t xEndTime;
+	TickType_t xIntervalTime;
+	uint64_t ullIntervalBytes;
+	uint32_t ulIntervalRetransmits;
+	IPerfCPU_t xCPUStart;
+	IPerfCPU_t xCPUInterval;
+} IPerfTest_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The task that runs the server.
+ */
+static void prvIPerfServerTask( void *pvParameters );
+
+/*
+ * Server: handle a new TCP connection, which is either the control connection
+ * of a new test or a data stream of the current test.
+ */
+static void prvAcceptConnection( void );
+
+/*
+ * Server: get the parameters of a new test from the client.
+ */
+static void prvBeginTest( Socket_t xSocket, const char *pcCookie );
+
+/*
+ * Server: all streams are connected, tell the client to start.
+ */
+static void prvStartTest( void );
+
+/*
+ * Server: handle a state change sent by the client on the control connection.
+ */
+static void prvControlEvent( void );
+
+/*
+ * Server: exchange the results after the client has sent TEST_END.
+ */
+static void prvExchangeResults( void );
+
+/*
+ * Server: close all sockets of the current test.
+ */
+static void prvEndTest( void );
+
+/*
+ * Server: handle the datagrams received on the UDP socket.
+ */
+static void prvUDPReceive( void );
+static void prvUDPDatagram( IPerfStream_t *pxStream, const uint8_t *pucPayload, size_t uxLength );
+
+/*
+ * Receive or send as much data as possible on a TCP stream without blocking.
+ * Returns pdFAIL when the connection has gone.
+ */
+static BaseType_t prvStreamReceive( IPerfStream_t *pxStream );
+static BaseType_t prvStreamSend( IPerfStream_t *pxStream );
+
+/*
+ * Log the goodput, retransmissions and CPU load since the previous report.
+ */
+static void prvReportInterval( IPerfTest_t *pxTest, TickType_t xNow );
+
+/*
+ * Log the totals of a finished test.
+ */
+static void prvReportTotals( IPerfTest_t *pxTest );
+
+/*
+ * Compose the JSON object with the results of this side of the test.
+ */
+static void prvFormatResults( IPerfTest_t *pxTest, char *pcBuffer, size_t uxSize );
+
+/*
+ * Read a number or a boolean from a flat JSON object.  Returns pdFALSE when the
+ * key is not found.
+ */
+static BaseType_t prvJSONGetValue( const char *pcJSON, const char *pcKey, uint32_t *pulValue );
+
+/*
+ * Helpers for the control connection.  They block for at most
+ * iperfCONTROL_TIMEOUT_MS and return pdFAIL on an error or a time-out.
+ */
+static BaseType_t prvSendAll( Socket_t xSocket, const void *pvData, size_t uxLength );
+static BaseType_t prvRecvAll( Socket_t xSocket, void *pvData, size_t uxLength );
+static BaseType_t prvSendState( Socket_t xSocket, int8_t cState );
+static int8_t prvRecvState( Socket_t xSocket );
+static BaseType_t prvSendJSON( Socket_t xSocket, const char *pcJSON );
+static BaseType_t prvRecvJSON( Socket_t xSocket, char *pcBuffer, size_t uxSize );
+
+/*
+ * Set the time-outs and the buffer sizes of a socket.
+ */
+static void prvConfigureSocket( Socket_t xSocket, TickType_t xTimeout );
+
+/*
+ * Close a socket and remove it from the socket set.
+ */
+static void prvCloseSocket( Socket_t xSocket );
+
+/*
+ * Helpers to measure time and CPU load.
+ */
+static uint32_t prvMilliSeconds( TickType_t xTicks );
+static void prvCPUMark( IPerfCPU_t *pxCPU );
+static uint32_t prvCPULoad( const IPerfCPU_t *pxSince );
+
+/*
+ * Print a 64-bit number, pcBuffer must hold iperfU64_STRING_SIZE characters.
+ */
+static const char *prvU64ToString( uint64_t ullValue, char *pcBuffer );
+
+/*
+ * iperf3 numbers the streams 1, 3, 4, 5, etc.
+ */
+static BaseType_t prvStreamID( BaseType_t xIndex );
+
+/*-----------------------------------------------------------*/
+
+/* The sockets of the server. */
+static SocketSet_t xSocketSet = NULL;
+static Socket_t xListenSocket = NULL;
+static Socket_t xUDPSocket = NULL;
+
+/* The test that is run by the server. */
+static IPerfTest_t xServerTest;
+
+/* Data that is sent, both by the server in reverse mode and by the client. */
+static uint8_t ucSendBuffer[ ipconfigIPERF_BLOCK_SIZE ];
+
+/* Composed and received JSON objects. */
+static char cJSONBuffer[ iperfJSON_BUFFER_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xIPerfServerStart( void )
+{
+BaseType_t xReturn;
+
+	xReturn = xTaskCreate( prvIPerfServerTask, "IPerf", ipconfigIPERF_STACK_SIZE, NULL, ipconfigIPERF_TASK_PRIORITY, NULL );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvIPerfServerTask( void *pvParameters )
+{
+struct freertos_sockaddr xAddress;
+BaseType_t xIndex;
+TickType_t xNow;
+const TickType_t xInterval = pdMS_TO_TICKS( ipconfigIPERF_INTERVAL_MS );
+
+	( void ) pvParameters;
+
+	memset( ucSendBuffer, 'x', sizeof( ucSendBuffer ) );
+	memset( &xServerTest, '\0', sizeof( xServerTest ) );
+
+	xSocketSet = FreeRTOS_CreateSocketSet();
+	configASSERT( xSocketSet != NULL );
+
+	xAddress.sin_port = FreeRTOS_htons( ipconfigIPERF_PORT );
+	xAddress.sin_addr = 0uL;
+
+	/* The listening socket will not block in FreeRTOS_accept().  Its buffer
+	and window sizes are inherited by the data streams. */
+	xListenSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xListenSocket != FREERTOS_INVALID_SOCKET );
+	prvConfigureSocket( xListenSocket, 0u );
+	FreeRTOS_bind( xListenSocket, &xAddress, sizeof( xAddress ) );
+	FreeRTOS_listen( xListenSocket, ipconfigIPERF_MAX_STREAMS + 1 );
+	FreeRTOS_FD_SET( xListenSocket, xSocketSet, eSELECT_READ );
+
+	xUDPSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+	configASSERT( xUDPSocket != FREERTOS_INVALID_SOCKET );
+	FreeRTOS_bind( xUDPSocket, &xAddress, sizeof( xAddress ) );
+	FreeRTOS_FD_SET( xUDPSocket, xSocketSet, eSELECT_READ );
+
+	FreeRTOS_printf( ( "iperf: server listening on port %u\n", ( unsigned ) ipconfigIPERF_PORT ) );
+
+	for( ;; )
+	{
+		FreeRTOS_select( xSocketSet, pdMS_TO_TICKS( iperfSELECT_TIMEOUT_MS ) );
+
+		/* The data streams first: the control connection may close them. */
+		for( xIndex = 0; xIndex < xServerTest.xConnectedCount; xIndex++ )
+		{
+		IPerfStream_t *pxStream = &( xServerTest.xStreams[ xIndex ] );
+		EventBits_t xBits;
+
+			if( pxStream->xSocket == NULL )
+			{
+				continue;
+			}
+
+			xBits = FreeRTOS_FD_ISSET( pxStream->xSocket, xSocketSet );
+
+			if( ( ( ( xBits & eSELECT_READ ) != 0u ) && ( prvStreamReceive( pxStream ) == pdFAIL ) ) ||
+				( ( ( xBits & eSELECT_WRITE ) != 0u ) && ( prvStreamSend( pxStream ) == pdFAIL ) ) )
+			{
+				prvCloseSocket( pxStream->xSocket );
+				pxStream->xSocket = NULL;
+			}
+		}
+
+		if( ( xServerTest.xControlSocket != NULL ) &&
+			( ( FreeRTOS_FD_ISSET( xServerTest.xControlSocket, xSocketSet ) & eSELECT_READ ) != 0u ) )
+		{
+			prvControlEvent();
+		}
+
+		if( ( FreeRTOS_FD_ISSET( xListenSocket, xSocketSet ) & eSELECT_READ ) != 0u )
+		{
+			prvAcceptConnection();
+		}
+
+		if( ( FreeRTOS_FD_ISSET( xUDPSocket, xSocketSet ) & eSELECT_READ ) != 0u )
+		{
+			prvUDPReceive();
+		}
+
+		if( xServerTest.cState == iperfTEST_RUNNING )
+		{
+			xNow = xTaskGetTickCount();
+
+			if( ( xNow - xServerTest.xIntervalTime ) >= xInterval )
+			{
+				prvReportInterval( &xServerTest, xNow );
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvAcceptConnection( void )
+{
+struct freertos_sockaddr xAddress;
+socklen_t xSize = sizeof( xAddress );
+Socket_t xSocket;
+char cCookie[ iperfCOOKIE_SIZE ];
+IPerfStream_t *pxStream;
+
+	xSocket = FreeRTOS_accept( xListenSocket, &xAddress, &xSize );
+
+	if( ( xSocket == NULL ) || ( xSocket == FREERTOS_INVALID_SOCKET ) )
+	{
+		return;
+	}
+
+	/* Every connection starts with the cookie of the test. */
+	prvConfigureSocket( xSocket, pdMS_TO_TICKS( iperfCONTROL_TIMEOUT_MS ) );
+
+	if( prvRecvAll( xSocket, cCookie, sizeof( cCookie ) ) == pdFAIL )
+	{
+		prvCloseSocket( xSocket );
+	}
+	else if( xServerTest.cState == iperfIDLE )
+	{
+		prvBeginTest( xSocket, cCookie );
+	}
+	else if( ( xServerTest.cState == iperfCREATE_STREAMS ) &&
+			 ( xServerTest.xUseUDP == pdFALSE ) &&
+			 ( xServerTest.xConnectedCount < xServerTest.xStreamCount ) &&
+			 ( memcmp( cCookie, xServerTest.cCookie, sizeof( cCookie ) ) == 0 ) )
+	{
+		/* A data stream of the current test.  It is only accessed when
+		FreeRTOS_select() says so, and never blocks.  An accepted socket
+		inherits the select bits of the listening socket, so these are set
+		explicitly. */
+		pxStream = &( xServerTest.xStreams[ xServerTest.xConnectedCount ] );
+		pxStream->xSocket = xSocket;
+		xServerTest.xConnectedCount++;
+		FreeRTOS_FD_CLR( xSocket, xSocketSet, eSELECT_ALL );
+
+		if( xServerTest.xReverse != pdFALSE )
+		{
+			FreeRTOS_FD_SET( xSocket, xSocketSet, eSELECT_WRITE );
+		}
+		else
+		{
+			FreeRTOS_FD_SET( xSocket, xSocketSet, eSELECT_READ );
+		}
+
+		if( xServerTest.xConnectedCount == xServerTest.xStreamCount )
+		{
+			prvStartTest();
+		}
+	}
+	else
+	{
+		/* Only one test is run at a time. */
+		( void ) prvSendState( xSocket, iperfACCESS_DENIED );
+		prvCloseSocket( xSocket );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBeginTest( Socket_t xSocket, const char *pcCookie )
+{
+uint32_t ulValue;
+uint32_t ulErrors[ 2 ];
+
+	memset( &xServerTest, '\0', sizeof( xServerTest ) );
+	xServerTest.xControlSocket = xSocket;
+	memcpy( xServerTest.cCookie, pcCookie, sizeof( xServerTest.cCookie ) );
+	xServerTest.xStreamCount = 1;
+	xServerTest.ulSeconds = 10u;
+
+	if( ( prvSendState( xSocket, iperfPARAM_EXCHANGE ) == pdFAIL ) ||
+		( prvRecvJSON( xSocket, cJSONBuffer, sizeof( cJSONBuffer ) ) == pdFAIL ) )
+	{
+		prvEndTest();
+		return;
+	}
+
+	if( ( prvJSONGetValue( cJSONBuffer, "udp", &ulValue ) != pdFALSE ) && ( ulValue != 0u ) )
+	{
+		xServerTest.xUseUDP = pdTRUE;
+	}
+
+	if( ( prvJSONGetValue( cJSONBuffer, "reverse", &ulValue ) != pdFALSE ) && ( ulValue != 0u ) )
+	{
+		xServerTest.xReverse = pdTRUE;
+		xServerTest.xIsSender = pdTRUE;
+	}
+
+	if( ( prvJSONGetValue( cJSONBuffer, "udp_counters_64bit", &ulValue ) != pdFALSE ) && ( ulValue != 0u ) )
+	{
+		xServerTest.xCounters64 = pdTRUE;
+	}
+
+	if( prvJSONGetValue( cJSONBuffer, "time", &ulValue ) != pdFALSE )
+	{
+		xServerTest.ulSeconds = ulValue;
+	}
+
+	if( prvJSONGetValue( cJSONBuffer, "parallel", &ulValue ) != pdFALSE )
+	{
+		xServerTest.xStreamCount = ( BaseType_t ) ulValue;
+	}
+
+	if( ( xServerTest.xStreamCount < 1 ) || ( xServerTest.xStreamCount > ipconfigIPERF_MAX_STREAMS ) ||
+		( ( xServerTest.xUseUDP != pdFALSE ) && ( xServerTest.xReverse != pdFALSE ) ) )
+	{
+		/* Too many streams, or sending UDP, which is not supported.  The
+		error is followed by the iperf and the system error numbers. */
+		FreeRTOS_printf( ( "iperf: test refused\n" ) );
+		ulErrors[ 0 ] = 0uL;
+		ulErrors[ 1 ] = FreeRTOS_htonl( pdFREERTOS_ERRNO_EINVAL );
+		( void ) prvSendState( xSocket, iperfSERVER_ERROR );
+		( void ) prvSendAll( xSocket, ulErrors, sizeof( ulErrors ) );
+		prvEndTest();
+		return;
+	}
+
+	if( prvSendState( xSocket, iperfCREATE_STREAMS ) == pdFAIL )
+	{
+		prvEndTest();
+		return;
+	}
+
+	xServerTest.cState = iperfCREATE_STREAMS;
+	FreeRTOS_FD_SET( xSocket, xSocketSet, eSELECT_READ );
+}
+/*-----------------------------------------------------------*/
+
+static void prvStartTest( void )
+{
+BaseType_t xIndex;
+
+	for( xIndex = 0; xIndex < xServerTest.xStreamCount; xIndex++ )
+	{
+		xServerTest.xStreams[ xIndex ].ullNextPacket = 1u;
+	}
+
+	if( ( prvSendState( xServerTest.xControlSocket, iperfTEST_START ) == pdFAIL ) ||
+		( prvSendState( xServerTest.xControlSocket, iperfTEST_RUNNING ) == pdFAIL ) )
+	{
+		prvEndTest();
+	}
+	else
+	{
+		xServerTest.cState = iperfTEST_RUNNING;
+		xServerTest.xStartTime = xTaskGetTickCount();
+		xServerTest.xIntervalTime = xServerTest.xStartTime;
+		prvCPUMark( &( xServerTest.xCPUStart ) );
+		xServerTest.xCPUInterval = xServerTest.xCPUStart;
+
+		FreeRTOS_printf( ( "iperf: %s test, %s, %d stream(s), %lu sec\n",
+			( xServerTest.xUseUDP != pdFALSE ) ? "UDP" : "TCP",
+			( xServerTest.xReverse != pdFALSE ) ? "sending" : "receiving",
+			( int ) xServerTest.xStreamCount,
+			( unsigned long ) xServerTest.ulSeconds ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvControlEvent( void )
+{
+int8_t cState;
+BaseType_t xResult;
+
+	xResult = FreeRTOS_recv( xServerTest.xControlSocket, &cState, sizeof( cState ), FREERTOS_MSG_DONTWAIT );
+
+	if( xResult < 0 )
+	{
+		/* The client has gone. */
+		prvEndTest();
+	}
+	else if( xResult > 0 )
+	{
+		if( ( cState == iperfTEST_END ) && ( xServerTest.cState == iperfTEST_RUNNING ) )
+		{
+			prvExchangeResults();
+		}
+		else if( ( cState == iperfCLIENT_TERMINATE ) || ( cState == iperfIPERF_DONE ) )
+		{
+			prvEndTest();
+		}
+		else
+		{
+			/* Other states are not expected from a client. */
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvExchangeResults( void )
+{
+BaseType_t xIndex;
+BaseType_t xResult;
+
+	/* Count what was still waiting in the reception buffers. */
+	for( xIndex = 0; xIndex < xServerTest.xConnectedCount; xIndex++ )
+	{
+		if( ( xServerTest.xStreams[ xIndex ].xSocket != NULL ) && ( xServerTest.xReverse == pdFALSE ) )
+		{
+			( void ) prvStreamReceive( &( xServerTest.xStreams[ xIndex ] ) );
+		}
+	}
+
+	xServerTest.xEndTime = xTaskGetTickCount();
+	prvReportInterval( &xServerTest, xServerTest.xEndTime );
+	xServerTest.cState = iperfEXCHANGE_RESULTS;
+
+	/* Stop sending in reverse mode. */
+	for( xIndex = 0; xIndex < xServerTest.xConnectedCount; xIndex++ )
+	{
+		if( xServerTest.xStreams[ xIndex ].xSocket != NULL )
+		{
+			FreeRTOS_FD_CLR( xServerTest.xStreams[ xIndex ].xSocket, xSocketSet, eSELECT_ALL );
+		}
+	}
+
+	prvReportTotals( &xServerTest );
+
+	/* The results of the client are read but not used. */
+	xResult = prvSendState( xServerTest.xControlSocket, iperfEXCHANGE_RESULTS );
+
+	if( xResult != pdFAIL )
+	{
+		xResult = prvRecvJSON( xServerTest.xControlSocket, cJSONBuffer, sizeof( cJSONBuffer ) );
+	}
+
+	if( xResult != pdFAIL )
+	{
+		prvFormatResults( &xServerTest, cJSONBuffer, sizeof( cJSONBuffer ) );
+		xResult = prvSendJSON( xServerTest.xControlSocket, cJSONBuffer );
+	}
+
+	if( xResult != pdFAIL )
+	{
+		xResult = prvSendState( xServerTest.xControlSocket, iperfDISPLAY_RESULTS );
+	}
+
+	if( xResult != pdFAIL )
+	{
+		/* The test ends when the client sends IPERF_DONE, or when it closes
+		the connection. */
+		xServerTest.cState = iperfDISPLAY_RESULTS;
+	}
+	else
+	{
+		prvEndTest();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvEndTest( void )
+{
+BaseType_t xIndex;
+
+	for( xIndex = 0; xIndex < ipconfigIPERF_MAX_STREAMS; xIndex++ )
+	{
+		if( xServerTest.xStreams[ xIndex ].xSocket != NULL )
+		{
+			prvCloseSocket( xServerTest.xStreams[ xIndex ].xSocket );
+		}
+	}
+
+	if( xServerTest.xControlSocket != NULL )
+	{
+		prvCloseSocket( xServerTest.xControlSocket );
+	}
+
+	memset( &xServerTest, '\0', sizeof( xServerTest ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvUDPReceive( void )
+{
+struct freertos_sockaddr xAddress;
+socklen_t xSize = sizeof( xAddress );
+uint8_t *pucPayload;
+int32_t lLength;
+uint32_t ulReply;
+BaseType_t xIndex;
+IPerfStream_t *pxStream;
+
+	for( ;; )
+	{
+		lLength = FreeRTOS_recvfrom( xUDPSocket, &pucPayload, 0u, FREERTOS_ZERO_COPY | FREERTOS_MSG_DONTWAIT, &xAddress, &xSize );
+
+		if( lLength <= 0 )
+		{
+			break;
+		}
+
+		if( ( xServerTest.xUseUDP != pdFALSE ) && ( xServerTest.cState == iperfCREATE_STREAMS ) )
+		{
+			/* A new stream announces itself with a 4-byte datagram. */
+			if( ( lLength == ( int32_t ) sizeof( ulReply ) ) && ( xServerTest.xConnectedCount < xServerTest.xStreamCount ) )
+			{
+				pxStream = &( xServerTest.xStreams[ xServerTest.xConnectedCount ] );
+				pxStream->usPeerPort = xAddress.sin_port;
+				xServerTest.xConnectedCount++;
+
+				ulReply = FreeRTOS_htonl( iperfUDP_CONNECT_REPLY );
+				FreeRTOS_sendto( xUDPSocket, &ulReply, sizeof( ulReply ), 0, &xAddress, sizeof( xAddress ) );
+
+				if( xServerTest.xConnectedCount == xServerTest.xStreamCount )
+				{
+					prvStartTest();
+				}
+			}
+		}
+		else if( ( xServerTest.xUseUDP != pdFALSE ) && ( xServerTest.cState == iperfTEST_RUNNING ) )
+		{
+			for( xIndex = 0; xIndex < xServerTest.xConnectedCount; xIndex++ )
+			{
+				pxStream = &( xServerTest.xStreams[ xIndex ] );
+
+				if( pxStream->usPeerPort == xAddress.sin_port )
+				{
+					prvUDPDatagram( pxStream, pucPayload, ( size_t ) lLength );
+					break;
+				}
+			}
+		}
+		else
+		{
+			/* Not part of a test. */
+		}
+
+		FreeRTOS_ReleaseUDPPayloadBuffer( pucPayload );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvUDPDatagram( IPerfStream_t *pxStream, const uint8_t *pucPayload, size_t uxLength )
+{
+uint32_t ulWords[ 4 ];
+uint64_t ullCount;
+uint32_t ulSentTime, ulArrivalTime, ulDelta;
+int32_t lTransit;
+size_t uxHeaderSize;
+
+	uxHeaderSize = ( xServerTest.xCounters64 != pdFALSE ) ? iperfUDP_HEADER_SIZE_64 : iperfUDP_HEADER_SIZE;
+
+	if( uxLength < uxHeaderSize )
+	{
+		return;
+	}
+
+	/* The payload may not be aligned. */
+	memcpy( ulWords, pucPayload, uxHeaderSize );
+
+	if( xServerTest.xCounters64 != pdFALSE )
+	{
+		ullCount = ( ( ( uint64_t ) FreeRTOS_ntohl( ulWords[ 2 ] ) ) << 32 ) | FreeRTOS_ntohl( ulWords[ 3 ] );
+	}
+	else
+	{
+		ullCount = FreeRTOS_ntohl( ulWords[ 2 ] );
+	}
+
+	pxStream->ullBytes += uxLength;
+	pxStream->ulPackets++;
+
+	if( ullCount >= pxStream->ullNextPacket )
+	{
+		/* Datagrams that were skipped are counted as lost. */
+		pxStream->ulErrors += ( uint32_t ) ( ullCount - pxStream->ullNextPacket );
+		pxStream->ullNextPacket = ullCount + 1u;
+	}
+	else if( pxStream->ulErrors > 0u )
+	{
+		/* A datagram that was counted as lost arrived out of order. */
+		pxStream->ulErrors--;
+	}
+
+	/* The clocks of the client and the server are not synchronised, but the
+	jitter only depends on the variation of the transit time.  All times are
+	in micro seconds and may wrap. */
+	ulSentTime = ( FreeRTOS_ntohl( ulWords[ 0 ] ) * 1000000uL ) + FreeRTOS_ntohl( ulWords[ 1 ] );
+	ulArrivalTime = ( uint32_t ) ( ( ( uint64_t ) xTaskGetTickCount() * 1000000u ) / configTICK_RATE_HZ );
+	lTransit = ( int32_t ) ( ulArrivalTime - ulSentTime );
+
+	if( pxStream->ulPackets > 1u )
+	{
+		ulDelta = ( uint32_t ) ( ( lTransit > pxStream->lLastTransit ) ? ( lTransit - pxStream->lLastTransit ) : ( pxStream->lLastTransit - lTransit ) );
+
+		/* J = J + ( |D| - J ) / 16, see RFC 3550. */
+		pxStream->ulJitter16 = pxStream->ulJitter16 + ulDelta - ( ( pxStream->ulJitter16 + 8u ) / 16u );
+	}
+
+	pxStream->lLastTransit = lTransit;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvStreamReceive( IPerfStream_t *pxStream )
+{
+BaseType_t xResult;
+BaseType_t xReturn = pdPASS;
+uint8_t *pucData;
+
+	for( ;; )
+	{
+		/* The data is not copied, it is only counted and released. */
+		xResult = FreeRTOS_recv( pxStream->xSocket, &pucData, 0u, FREERTOS_ZERO_COPY | FREERTOS_MSG_DONTWAIT );
+
+		if( xResult > 0 )
+		{
+			( void ) FreeRTOS_ReleaseTCPPayloadBuffer( pxStream->xSocket, pucData, xResult );
+			pxStream->ullBytes += ( uint64_t ) xResult;
+		}
+		else
+		{
+			if( xResult < 0 )
+			{
+				xReturn = pdFAIL;
+			}
+
+			break;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvStreamSend( IPerfStream_t *pxStream )
+{
+BaseType_t xResult;
+BaseType_t xReturn = pdPASS;
+
+	for( ;; )
+	{
+		xResult = FreeRTOS_send( pxStream->xSocket, ucSendBuffer, sizeof( ucSendBuffer ), FREERTOS_MSG_DONTWAIT );
+
+		if( xResult > 0 )
+		{
+			pxStream->ullBytes += ( uint64_t ) xResult;
+		}
+		else
+		{
+			if( ( xResult < 0 ) && ( xResult != -pdFREERTOS_ERRNO_ENOSPC ) )
+			{
+				xReturn = pdFAIL;
+			}
+
+			break;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReportInterval( IPerfTest_t *pxTest, TickType_t xNow )
+{
+BaseType_t xIndex;
+uint64_t ullBytes = 0u;
+uint32_t ulRetransmits = 0u;
+uint32_t ulBytes, ulKbps, ulFrom, ulTo, ulTime;
+BaseType_t xCount;
+char cLine[ 96 ];
+
+	for( xIndex = 0; xIndex < pxTest->xConnectedCount; xIndex++ )
+	{
+		if( pxTest->xStreams[ xIndex ].xSocket != NULL )
+		{
+			xCount = FreeRTOS_retransmit_count( pxTest->xStreams[ xIndex ].xSocket );
+
+			if( xCount >= 0 )
+			{
+				pxTest->xStreams[ xIndex ].ulRetransmits = ( uint32_t ) xCount;
+			}
+		}
+
+		ullBytes += pxTest->xStreams[ xIndex ].ullBytes;
+		ulRetransmits += pxTest->xStreams[ xIndex ].ulRetransmits;
+	}
+
+	ulFrom = prvMilliSeconds( pxTest->xIntervalTime - pxTest->xStartTime );
+	ulTo = prvMilliSeconds( xNow - pxTest->xStartTime );
+	ulTime = ulTo - ulFrom;
+
+	if( ulTime != 0u )
+	{
+		/* Bits per milli second equals kbit/s. */
+		ulBytes = ( uint32_t ) ( ullBytes - pxTest->ullIntervalBytes );
+		ulKbps = ( uint32_t ) ( ( ( uint64_t ) ulBytes * 8u ) / ulTime );
+
+		snprintf( cLine, sizeof( cLine ), "%3lu.%02lu-%3lu.%02lu sec %10lu bytes %5lu.%03lu Mbit/s retr %lu cpu %lu%%",
+			( unsigned long ) ( ulFrom / 1000u ), ( unsigned long ) ( ( ulFrom % 1000u ) / 10u ),
+			( unsigned long ) ( ulTo / 1000u ), ( unsigned long ) ( ( ulTo % 1000u ) / 10u ),
+			( unsigned long ) ulBytes,
+			( unsigned long ) ( ulKbps / 1000u ), ( unsigned long ) ( ulKbps % 1000u ),
+			( unsigned long ) ( ulRetransmits - pxTest->ulIntervalRetransmits ),
+			( unsigned long ) prvCPULoad( &( pxTest->xCPUInterval ) ) );
+		FreeRTOS_printf( ( "iperf: %s\n", cLine ) );
+
+		pxTest->xIntervalTime = xNow;
+		pxTest->ullIntervalBytes = ullBytes;
+		pxTest->ulIntervalRetransmits = ulRetransmits;
+		prvCPUMark( &( pxTest->xCPUInterval ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvReportTotals( IPerfTest_t *pxTest )
+{
+BaseType_t xIndex;
+uint64_t ullBytes = 0u;
+uint32_t ulPackets = 0u, ulErrors = 0u, ulJitter = 0u, ulKbps = 0u, ulTime;
+char cBytes[ iperfU64_STRING_SIZE ];
+char cLine[ 96 ];
+
+	for( xIndex = 0; xIndex < pxTest->xConnectedCount; xIndex++ )
+	{
+		ullBytes += pxTest->xStreams[ xIndex ].ullBytes;
+		ulPackets += pxTest->xStreams[ xIndex ].ulPackets;
+		ulErrors += pxTest->xStreams[ xIndex ].ulErrors;
+
+		if( ( pxTest->xStreams[ xIndex ].ulJitter16 / 16u ) > ulJitter )
+		{
+			ulJitter = pxTest->xStreams[ xIndex ].ulJitter16 / 16u;
+		}
+	}
+
+	ulTime = prvMilliSeconds( pxTest->xEndTime - pxTest->xStartTime );
+
+	if( ulTime != 0u )
+	{
+		ulKbps = ( uint32_t ) ( ( ullBytes * 8u ) / ulTime );
+	}
+
+	snprintf( cLine, sizeof( cLine ), "total %lu.%03lu sec %s bytes %lu.%03lu Mbit/s cpu %lu%%",
+		( unsigned long ) ( ulTime / 1000u ), ( unsigned long ) ( ulTime % 1000u ),
+		prvU64ToString( ullBytes, cBytes ),
+		( unsigned long ) ( ulKbps / 1000u ), ( unsigned long ) ( ulKbps % 1000u ),
+		( unsigned long ) prvCPULoad( &( pxTest->xCPUStart ) ) );
+	FreeRTOS_printf( ( "iperf: %s\n", cLine ) );
+
+	if( pxTest->xUseUDP != pdFALSE )
+	{
+		snprintf( cLine, sizeof( cLine ), "lost %lu/%lu datagrams, jitter %lu.%03lu ms",
+			( unsigned long ) ulErrors, ( unsigned long ) ( ulPackets + ulErrors ),
+			( unsigned long ) ( ulJitter / 1000u ), ( unsigned long ) ( ulJitter % 1000u ) );
+		FreeRTOS_printf( ( "iperf: %s\n", cLine ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvFormatResults( IPerfTest_t *pxTest, char *pcBuffer, size_t uxSize )
+{
+BaseType_t xIndex;
+size_t uxLength;
+uint32_t ulCPULoad, ulTime, ulJitter;
+long lRetransmits;
+IPerfStream_t *pxStream;
+char cBytes[ iperfU64_STRING_SIZE ];
+
+	ulCPULoad = prvCPULoad( &( pxTest->xCPUStart ) );
+	ulTime = prvMilliSeconds( pxTest->xEndTime - pxTest->xStartTime );
+
+	/* Only the sending side knows about retransmissions. */
+	uxLength = ( size_t ) snprintf( pcBuffer, uxSize,
+		"{\"cpu_util_total\":%lu,\"cpu_util_user\":%lu,\"cpu_util_system\":0,\"sender_has_retransmits\":%d,\"streams\":[",
+		( unsigned long ) ulCPULoad, ( unsigned long ) ulCPULoad,
+		( ( pxTest->xIsSender != pdFALSE ) && ( pxTest->xUseUDP == pdFALSE ) ) ? 1 : -1 );
+
+	for( xIndex = 0; ( xIndex < pxTest->xConnectedCount ) && ( uxLength < uxSize ); xIndex++ )
+	{
+		pxStream = &( pxTest->xStreams[ xIndex ] );
+		lRetransmits = ( ( pxTest->xIsSender != pdFALSE ) && ( pxTest->xUseUDP == pdFALSE ) ) ? ( long ) pxStream->ulRetransmits : -1L;
+
+		/* The jitter and the times are expressed in seconds. */
+		ulJitter = pxStream->ulJitter16 / 16u;
+
+		uxLength += ( size_t ) snprintf( pcBuffer + uxLength, uxSize - uxLength,
+			"%s{\"id\":%d,\"bytes\":%s,\"retransmits\":%ld,\"jitter\":%lu.%06lu,\"errors\":%lu,\"packets\":%lu,\"start_time\":0,\"end_time\":%lu.%03lu}",
+			( xIndex == 0 ) ? "" : ",",
+			( int ) prvStreamID( xIndex ),
+			prvU64ToString( pxStream->ullBytes, cBytes ),
+			lRetransmits,
+			( unsigned long ) ( ulJitter / 1000000u ), ( unsigned long ) ( ulJitter % 1000000u ),
+			( unsigned long ) pxStream->ulErrors,
+			( unsigned long ) pxStream->ulPackets,
+			( unsigned long ) ( ulTime / 1000u ), ( unsigned long ) ( ulTime % 1000u ) );
+	}
+
+	if( uxLength < uxSize )
+	{
+		snprintf( pcBuffer + uxLength, uxSize - uxLength, "]}" );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvJSONGetValue( const char *pcJSON, const char *pcKey, uint32_t *pulValue )
+{
+const char *pcPtr = pcJSON;
+size_t uxKeyLength = strlen( pcKey );
+BaseType_t xReturn = pdFALSE;
+
+	/* Look for the key in quotes, followed by a colon. */
+	while( ( pcPtr = strchr( pcPtr, '"' ) ) != NULL )
+	{
+		pcPtr++;
+
+		if( ( strncmp( pcPtr, pcKey, uxKeyLength ) == 0 ) && ( pcPtr[ uxKeyLength ] == '"' ) )
+		{
+			pcPtr += uxKeyLength + 1u;
+
+			while( ( *pcPtr == ' ' ) || ( *pcPtr == ':' ) )
+			{
+				pcPtr++;
+			}
+
+			if( strncmp( pcPtr, "true", 4 ) == 0 )
+			{
+				*pulValue = 1u;
+				xReturn = pdTRUE;
+			}
+			else if( strncmp( pcPtr, "false", 5 ) == 0 )
+			{
+				*pulValue = 0u;
+				xReturn = pdTRUE;
+			}
+			else if( ( *pcPtr >= '0' ) && ( *pcPtr <= '9' ) )
+			{
+				*pulValue = ( uint32_t ) strtoul( pcPtr, NULL, 10 );
+				xReturn = pdTRUE;
+			}
+
+			break;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendAll( Socket_t xSocket, const void *pvData, size_t uxLength )
+{
+const uint8_t *pucData = ( const uint8_t * ) pvData;
+BaseType_t xResult;
+
+	while( uxLength > 0u )
+	{
+		xResult = FreeRTOS_send( xSocket, pucData, uxLength, 0 );
+
+		if( xResult <= 0 )
+		{
+			break;
+		}
+
+		pucData += xResult;
+		uxLength -= ( size_t ) xResult;
+	}
+
+	return ( uxLength == 0u ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRecvAll( Socket_t xSocket, void *pvData, size_t uxLength )
+{
+uint8_t *pucData = ( uint8_t * ) pvData;
+BaseType_t xResult;
+
+	while( uxLength > 0u )
+	{
+		xResult = FreeRTOS_recv( xSocket, pucData, uxLength, 0 );
+
+		if( xResult <= 0 )
+		{
+			break;
+		}
+
+		pucData += xResult;
+		uxLength -= ( size_t ) xResult;
+	}
+
+	return ( uxLength == 0u ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendState( Socket_t xSocket, int8_t cState )
+{
+	return prvSendAll( xSocket, &cState, sizeof( cState ) );
+}
+/*-----------------------------------------------------------*/
+
+static int8_t prvRecvState( Socket_t xSocket )
+{
+int8_t cState;
+
+	if( prvRecvAll( xSocket, &cState, sizeof( cState ) ) == pdFAIL )
+	{
+		cState = iperfSERVER_ERROR;
+	}
+
+	return cState;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendJSON( Socket_t xSocket, const char *pcJSON )
+{
+uint32_t ulLength = ( uint32_t ) strlen( pcJSON );
+uint32_t ulNetLength = FreeRTOS_htonl( ulLength );
+BaseType_t xReturn;
+
+	/* A JSON object is preceded by its length. */
+	xReturn = prvSendAll( xSocket, &ulNetLength, sizeof( ulNetLength ) );
+
+	if( xReturn != pdFAIL )
+	{
+		xReturn = prvSendAll( xSocket, pcJSON, ( size_t ) ulLength );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRecvJSON( Socket_t xSocket, char *pcBuffer, size_t uxSize )
+{
+uint32_t ulLength;
+size_t uxCount;
+char cDiscard[ 32 ];
+BaseType_t xReturn;
+
+	xReturn = prvRecvAll( xSocket, &ulLength, sizeof( ulLength ) );
+
+	if( xReturn != pdFAIL )
+	{
+		ulLength = FreeRTOS_ntohl( ulLength );
+		uxCount = ( ( size_t ) ulLength < ( uxSize - 1u ) ) ? ( size_t ) ulLength : ( uxSize - 1u );
+		xReturn = prvRecvAll( xSocket, pcBuffer, uxCount );
+		pcBuffer[ ( xReturn != pdFAIL ) ? uxCount : 0u ] = '\0';
+		ulLength -= ( uint32_t ) uxCount;
+
+		/* What does not fit in the buffer is skipped. */
+		while( ( xReturn != pdFAIL ) && ( ulLength > 0u ) )
+		{
+			uxCount = ( ( size_t ) ulLength < sizeof( cDiscard ) ) ? ( size_t ) ulLength : sizeof( cDiscard );
+			xReturn = prvRecvAll( xSocket, cDiscard, uxCount );
+			ulLength -= ( uint32_t ) uxCount;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvConfigureSocket( Socket_t xSocket, TickType_t xTimeout )
+{
+WinProperties_t xWinProperties;
+
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeout, sizeof( xTimeout ) );
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeout, sizeof( xTimeout ) );
+
+	memset( &xWinProperties, '\0', sizeof( xWinProperties ) );
+	xWinProperties.lTxBufSize = ipconfigIPERF_TX_BUFSIZE;
+	xWinProperties.lTxWinSize = ipconfigIPERF_TX_WINSIZE;
+	xWinProperties.lRxBufSize = ipconfigIPERF_RX_BUFSIZE;
+	xWinProperties.lRxWinSize = ipconfigIPERF_RX_WINSIZE;
+	FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WIN_PROPERTIES, &xWinProperties, sizeof( xWinProperties ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCloseSocket( Socket_t xSocket )
+{
+	if( xSocketSet != NULL )
+	{
+		FreeRTOS_FD_CLR( xSocket, xSocketSet, eSELECT_ALL );
+	}
+
+	FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+	FreeRTOS_closesocket( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvMilliSeconds( TickType_t xTicks )
+{
+	return ( uint32_t ) ( ( ( uint64_t ) xTicks * 1000u ) / configTICK_RATE_HZ );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCPUMark( IPerfCPU_t *pxCPU )
+{
+	#if( iperfHAS_CPU_LOAD != 0 )
+	{
+		pxCPU->ulIdleTime = ulTaskGetIdleRunTimeCounter();
+
+		#ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+		{
+			portALT_GET_RUN_TIME_COUNTER_VALUE( pxCPU->ulTotalTime );
+		}
+		#else
+		{
+			pxCPU->ulTotalTime = portGET_RUN_TIME_COUNTER_VALUE();
+		}
+		#endif
+	}
+	#else
+	{
+		pxCPU->ulIdleTime = 0u;
+		pxCPU->ulTotalTime = 0u;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvCPULoad( const IPerfCPU_t *pxSince )
+{
+IPerfCPU_t xNow;
+uint32_t ulIdle, ulTotal;
+uint32_t ulReturn = 0u;
+
+	/* The load is the time not spent in the idle task, as a percentage.  It
+	is 0 when run-time statistics are not available. */
+	prvCPUMark( &xNow );
+	ulIdle = xNow.ulIdleTime - pxSince->ulIdleTime;
+	ulTotal = xNow.ulTotalTime - pxSince->ulTotalTime;
+
+	if( ( ulTotal != 0u ) && ( ulIdle <= ulTotal ) )
+	{
+		ulReturn = 100u - ( uint32_t ) ( ( ( uint64_t ) ulIdle * 100u ) / ulTotal );
+	}
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+static const char *prvU64ToString( uint64_t ullValue, char *pcBuffer )
+{
+char *pcPtr = pcBuffer + ( iperfU64_STRING_SIZE - 1 );
+
+	*pcPtr = '\0';
+
+	do
+	{
+		pcPtr--;
+		*pcPtr = ( char ) ( '0' + ( char ) ( ullValue % 10u ) );
+		ullValue /= 10u;
+	} while( ullValue != 0u );
+
+	return pcPtr;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvStreamID( BaseType_t xIndex )
+{
+	return ( xIndex == 0 ) ? 1 : ( xIndex + 2 );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIPerfClientRun( uint32_t ulServerIP, uint16_t usPort, uint32_t ulSeconds, BaseType_t xReverse )
+{
+static IPerfTest_t xTest;
+static char cClientJSON[ iperfJSON_BUFFER_SIZE ];
+struct freertos_sockaddr xAddress;
+SocketSet_t xClientSet;
+Socket_t xDataSocket = FREERTOS_INVALID_SOCKET;
+IPerfStream_t *pxStream = &( xTest.xStreams[ 0 ] );
+const TickType_t xTimeout = pdMS_TO_TICKS( iperfCONTROL_TIMEOUT_MS );
+const TickType_t xInterval = pdMS_TO_TICKS( ipconfigIPERF_INTERVAL_MS );
+TickType_t xNow, xDuration;
+EventBits_t xBits;
+BaseType_t xReturn = pdFAIL;
+BaseType_t xIndex;
+uint32_t ulRandom;
+int8_t cState;
+static const char cCookieChars[] = "abcdefghijklmnopqrstuvwxyz234567";
+
+	memset( &xTest, '\0', sizeof( xTest ) );
+	memset( ucSendBuffer, 'x', sizeof( ucSendBuffer ) );
+	xTest.ulSeconds = ( ulSeconds != 0u ) ? ulSeconds : 10u;
+	xTest.xReverse = xReverse;
+	xTest.xIsSender = ( xReverse == pdFALSE ) ? pdTRUE : pdFALSE;
+	xTest.xStreamCount = 1;
+	xDuration = pdMS_TO_TICKS( xTest.ulSeconds * 1000u );
+
+	xAddress.sin_addr = ulServerIP;
+	xAddress.sin_port = FreeRTOS_htons( usPort );
+
+	xClientSet = FreeRTOS_CreateSocketSet();
+
+	if( xClientSet == NULL )
+	{
+		return pdFAIL;
+	}
+
+	/* The cookie identifies the test, it is a random string. */
+	for( xIndex = 0; xIndex < ( iperfCOOKIE_SIZE - 1 ); xIndex++ )
+	{
+		( void ) xApplicationGetRandomNumber( &ulRandom );
+		xTest.cCookie[ xIndex ] = cCookieChars[ ulRandom % ( sizeof( cCookieChars ) - 1u ) ];
+	}
+
+	xTest.xControlSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+	if( xTest.xControlSocket == FREERTOS_INVALID_SOCKET )
+	{
+		FreeRTOS_DeleteSocketSet( xClientSet );
+		return pdFAIL;
+	}
+
+	prvConfigureSocket( xTest.xControlSocket, xTimeout );
+
+	/* Set up the test over the control connection. */
+	if( ( FreeRTOS_connect( xTest.xControlSocket, &xAddress, sizeof( xAddress ) ) == 0 ) &&
+		( prvSendAll( xTest.xControlSocket, xTest.cCookie, sizeof( xTest.cCookie ) ) != pdFAIL ) &&
+		( prvRecvState( xTest.xControlSocket ) == iperfPARAM_EXCHANGE ) )
+	{
+		snprintf( cClientJSON, sizeof( cClientJSON ),
+			"{\"tcp\":true,\"omit\":0,\"time\":%lu,\"parallel\":1,%s\"len\":%lu,\"client_version\":\"3.1.3\"}",
+			( unsigned long ) xTest.ulSeconds,
+			( xReverse != pdFALSE ) ? "\"reverse\":true," : "",
+			( unsigned long ) sizeof( ucSendBuffer ) );
+
+		if( ( prvSendJSON( xTest.xControlSocket, cClientJSON ) != pdFAIL ) &&
+			( prvRecvState( xTest.xControlSocket ) == iperfCREATE_STREAMS ) )
+		{
+			xDataSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+		}
+	}
+
+	if( xDataSocket != FREERTOS_INVALID_SOCKET )
+	{
+		prvConfigureSocket( xDataSocket, xTimeout );
+
+		if( ( FreeRTOS_connect( xDataSocket, &xAddress, sizeof( xAddress ) ) == 0 ) &&
+			( prvSendAll( xDataSocket, xTest.cCookie, sizeof( xTest.cCookie ) ) != pdFAIL ) )
+		{
+			pxStream->xSocket = xDataSocket;
+			xTest.xConnectedCount = 1;
+
+			/* Wait for TEST_START, followed by TEST_RUNNING. */
+			do
+			{
+				cState = prvRecvState( xTest.xControlSocket );
+			} while( cState == iperfTEST_START );
+
+			if( cState == iperfTEST_RUNNING )
+			{
+				xTest.cState = iperfTEST_RUNNING;
+			}
+		}
+	}
+
+	if( xTest.cState == iperfTEST_RUNNING )
+	{
+		FreeRTOS_printf( ( "iperf: client %s for %lu sec\n",
+			( xReverse != pdFALSE ) ? "receiving" : "sending", ( unsigned long ) xTest.ulSeconds ) );
+
+		FreeRTOS_FD_SET( xDataSocket, xClientSet, ( xReverse != pdFALSE ) ? eSELECT_READ : eSELECT_WRITE );
+		FreeRTOS_FD_SET( xTest.xControlSocket, xClientSet, eSELECT_READ );
+
+		xTest.xStartTime = xTaskGetTickCount();
+		xTest.xIntervalTime = xTest.xStartTime;
+		prvCPUMark( &( xTest.xCPUStart ) );
+		xTest.xCPUInterval = xTest.xCPUStart;
+
+		for( ;; )
+		{
+			FreeRTOS_select( xClientSet, pdMS_TO_TICKS( iperfSELECT_TIMEOUT_MS ) );
+
+			xBits = FreeRTOS_FD_ISSET( xDataSocket, xClientSet );
+
+			if( ( ( xBits & eSELECT_WRITE ) != 0u ) && ( prvStreamSend( pxStream ) == pdFAIL ) )
+			{
+				break;
+			}
+
+			if( ( ( xBits & eSELECT_READ ) != 0u ) && ( prvStreamReceive( pxStream ) == pdFAIL ) )
+			{
+				break;
+			}
+
+			if( ( FreeRTOS_FD_ISSET( xTest.xControlSocket, xClientSet ) & eSELECT_READ ) != 0u )
+			{
+				/* The server does not send anything during a test, unless it
+				terminates it. */
+				break;
+			}
+
+			xNow = xTaskGetTickCount();
+
+			if( ( xNow - xTest.xIntervalTime ) >= xInterval )
+			{
+				prvReportInterval( &xTest, xNow );
+			}
+
+			if( ( xNow - xTest.xStartTime ) >= xDuration )
+			{
+				xTest.cState = iperfTEST_END;
+				break;
+			}
+		}
+
+		FreeRTOS_FD_CLR( xDataSocket, xClientSet, eSELECT_ALL );
+		FreeRTOS_FD_CLR( xTest.xControlSocket, xClientSet, eSELECT_ALL );
+		xTest.xEndTime = xTaskGetTickCount();
+		prvReportInterval( &xTest, xTest.xEndTime );
+	}
+
+	if( xTest.cState == iperfTEST_END )
+	{
+		prvReportTotals( &xTest );
+
+		/* Exchange the results, those of the server are not used. */
+		if( ( prvSendState( xTest.xControlSocket, iperfTEST_END ) != pdFAIL ) &&
+			( prvRecvState( xTest.xControlSocket ) == iperfEXCHANGE_RESULTS ) )
+		{
+			prvFormatResults( &xTest, cClientJSON, sizeof( cClientJSON ) );
+
+			if( ( prvSendJSON( xTest.xControlSocket, cClientJSON ) != pdFAIL ) &&
+				( prvRecvJSON( xTest.xControlSocket, cClientJSON, sizeof( cClientJSON ) ) != pdFAIL ) &&
+				( prvRecvState( xTest.xControlSocket ) == iperfDISPLAY_RESULTS ) &&
+				( prvSendState( xTest.xControlSocket, iperfIPERF_DONE ) != pdFAIL ) )
+			{
+				xReturn = pdPASS;
+			}
+		}
+	}
+
+	if( xReturn == pdFAIL )
+	{
+		FreeRTOS_printf( ( "iperf: client test failed\n" ) );
+	}
+
+	if( xDataSocket != FREERTOS_INVALID_SOCKET )
+	{
+		FreeRTOS_shutdown( xDataSocket, FREERTOS_SHUT_RDWR );
+		FreeRTOS_closesocket( xDataSocket );
+	}
+
+	FreeRTOS_shutdown( xTest.xControlSocket, FREERTOS_SHUT_RDWR );
+	FreeRTOS_closesocket( xTest.xControlSocket );
+	FreeRTOS_DeleteSocketSet( xClientSet );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,53 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+#ifndef IPERF_TASK_H
+#define IPERF_TASK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Start a task that acts as an iperf3 server.  It listens on ipconfigIPERF_PORT
+ * and accepts TCP tests (also in reverse mode, "-R") and UDP tests, one test
+ * at a time.  Every ipconfigIPERF_INTERVAL_MS the goodput, the number of TCP
+ * retransmissions and the CPU load are logged with FreeRTOS_printf().
+ */
+BaseType_t xIPerfServerStart( void );
+
+/*
+ * Run a TCP test against an iperf3 server, from the calling task.  ulServerIP
+ * is in network byte order, as returned by FreeRTOS_inet_addr().  The test
+ * sends data for ulSeconds, or receives it when xReverse is pdTRUE.  Returns
+ * pdPASS when the test completed.
+ */
+BaseType_t xIPerfClientRun( uint32_t ulServerIP, uint16_t usPort, uint32_t ulSeconds, BaseType_t xReverse );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* IPERF_TASK_H */
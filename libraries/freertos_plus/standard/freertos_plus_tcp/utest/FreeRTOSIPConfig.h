@@ -0,0 +1,63 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/* The configuration of FreeRTOS+TCP for the unit tests that run on Linux.
+ * Options that are not set here take their value from
+ * FreeRTOSIPConfigDefaults.h. */
+
+#ifndef FREERTOS_IP_CONFIG_H
+#define FREERTOS_IP_CONFIG_H
+
+#define ipconfigBYTE_ORDER                         pdFREERTOS_LITTLE_ENDIAN
+
+#define ipconfigIP_TASK_PRIORITY                   ( configMAX_PRIORITIES - 2 )
+#define ipconfigIP_TASK_STACK_SIZE_WORDS           ( configMINIMAL_STACK_SIZE * 5 )
+
+#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS     64
+#define ipconfigNETWORK_MTU                        1500
+#define ipconfigTCP_MSS                            1460
+#define ipconfigEVENT_QUEUE_LENGTH                 ( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
+
+#define ipconfigUSE_TCP                            1
+#define ipconfigUSE_TCP_WIN                        1
+#define ipconfigUSE_DHCP                           1
+#define ipconfigUSE_DNS                            1
+#define ipconfigDHCP_USE_LEASE_CACHE               1
+#define ipconfigDHCP_RAPID_COMMIT                  1
+
+/* Send data in bursts, without driver support for TSO. */
+#define ipconfigTCP_TSO                            1
+
+/* Pass a burst of received segments to the OnReceive handler at once. */
+#define ipconfigUSE_TCP_GRO                        1
+#define ipconfigUSE_LINKED_RX_MESSAGES             1
+#define ipconfigUSE_CALLBACKS                      1
+
+#define ipconfigBUFFER_ALLOC_3_SMALL_SIZE          256
+#define ipconfigBUFFER_ALLOC_3_SMALL_COUNT         16
+#define ipconfigBUFFER_ALLOC_3_MEDIUM_SIZE         640
+#define ipconfigBUFFER_ALLOC_3_MEDIUM_COUNT        16
+
+#endif /* FREERTOS_IP_CONFIG_H */
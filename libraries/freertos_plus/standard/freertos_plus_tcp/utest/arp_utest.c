@@ -0,0 +1,376 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_list.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+/* The addresses of this node and its network, in network byte order. */
+#define LOCAL_IP          FreeRTOS_inet_addr_quick( 192, 168, 1, 1 )
+#define NET_MASK          FreeRTOS_inet_addr_quick( 255, 255, 255, 0 )
+
+/* The address of host number x on the local network. */
+#define HOST( x )                FreeRTOS_inet_addr_quick( 192, 168, 1, ( x ) )
+
+/* The hash of an address mixes its bytes with an exclusive-or, and keeps the
+ * lowest bits.  So HOST( x ) and COLLIDING_HOST( x ) end up in the same
+ * bucket. */
+#define COLLIDING_HOST( x )      HOST( ( x ) + ipconfigARP_CACHE_BUCKETS )
+#define BUCKET( ulIPAddress )    ( ( ( ulIPAddress ) ^ ( ( ulIPAddress ) >> 8 ) ^ ( ( ulIPAddress ) >> 16 ) ^ ( ( ulIPAddress ) >> 24 ) ) & ( ipconfigARP_CACHE_BUCKETS - 1u ) )
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined by other modules of the stack. */
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+const MACAddress_t xBroadcastMACAddress = { { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } };
+
+/* The time as seen by the ARP module. */
+static TickType_t xTickCount;
+
+/* The number of ARP requests sent, and the target of the last one. */
+static uint32_t ulRequestsSent;
+static uint32_t ulLastRequestTarget;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static TickType_t prvGetTickCount( int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return xTickCount;
+}
+
+NetworkBufferDescriptor_t * pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes,
+                                                              TickType_t xBlockTimeTicks )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    ( void ) xBlockTimeTicks;
+
+    pxBuffer = calloc( 1, sizeof( *pxBuffer ) );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    pxBuffer->pucEthernetBuffer = calloc( 1, xRequestedSizeBytes );
+    TEST_ASSERT_NOT_NULL( pxBuffer->pucEthernetBuffer );
+    pxBuffer->xDataLength = xRequestedSizeBytes;
+
+    return pxBuffer;
+}
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+    free( pxNetworkBuffer->pucEthernetBuffer );
+    free( pxNetworkBuffer );
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    ulRequestsSent++;
+    ulLastRequestTarget = pxNetworkBuffer->ulIPAddress;
+
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return pdPASS;
+}
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+    ( void ) eEvent;
+
+    return pdPASS;
+}
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
+                                     TickType_t uxTimeout )
+{
+    ( void ) pxEvent;
+    ( void ) uxTimeout;
+
+    return pdFAIL;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    xTaskGetTickCount_Stub( prvGetTickCount );
+
+    FreeRTOS_ClearARP();
+
+    *ipLOCAL_IP_ADDRESS_POINTER = LOCAL_IP;
+    xNetworkAddressing.ulNetMask = NET_MASK;
+    xNetworkAddressing.ulBroadcastAddress = LOCAL_IP | ~NET_MASK;
+
+    xTickCount = 1000u;
+    ulRequestsSent = 0u;
+    ulLastRequestTarget = 0u;
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* The MAC address of host number x. */
+static void prvHostMAC( uint8_t ucHost,
+                        MACAddress_t * pxMAC )
+{
+    static const uint8_t ucPrefix[ 5 ] = { 0x02u, 0x00u, 0x5eu, 0x10u, 0x00u };
+
+    memcpy( pxMAC->ucBytes, ucPrefix, sizeof( ucPrefix ) );
+    pxMAC->ucBytes[ 5 ] = ucHost;
+}
+
+/* Learn the MAC address of a host, the way a received packet does. */
+static void prvLearn( uint32_t ulIPAddress,
+                      uint8_t ucHost )
+{
+    MACAddress_t xMAC;
+
+    prvHostMAC( ucHost, &xMAC );
+    vARPRefreshCacheEntry( &xMAC, ulIPAddress );
+    xTickCount++;
+}
+
+/* Look up an address, and check that the MAC address of host ucHost is
+ * found. */
+static void prvCheckHit( uint32_t ulIPAddress,
+                         uint8_t ucHost )
+{
+    MACAddress_t xExpected, xFound;
+    uint32_t ulAddress = ulIPAddress;
+
+    prvHostMAC( ucHost, &xExpected );
+    memset( &xFound, 0, sizeof( xFound ) );
+
+    TEST_ASSERT_EQUAL( eARPCacheHit, eARPGetCacheEntry( &ulAddress, &xFound ) );
+    TEST_ASSERT_EQUAL_MEMORY( xExpected.ucBytes, xFound.ucBytes, sizeof( xFound.ucBytes ) );
+    xTickCount++;
+}
+
+static eARPLookupResult_t prvLookup( uint32_t ulIPAddress )
+{
+    MACAddress_t xFound;
+    uint32_t ulAddress = ulIPAddress;
+
+    return eARPGetCacheEntry( &ulAddress, &xFound );
+}
+
+/* ======================== Test functions ================================= */
+
+/* A learned address is found, and counted as a hit. */
+void test_lookup_hit( void )
+{
+    ARPCacheStatistics_t xBefore, xAfter;
+
+    prvLearn( HOST( 2 ), 2 );
+
+    FreeRTOS_GetARPStatistics( &xBefore );
+    prvCheckHit( HOST( 2 ), 2 );
+    FreeRTOS_GetARPStatistics( &xAfter );
+
+    TEST_ASSERT_EQUAL( xBefore.ulHits + 1u, xAfter.ulHits );
+    TEST_ASSERT_EQUAL( xBefore.ulMisses, xAfter.ulMisses );
+}
+
+/* An unknown address, and an address still waiting for a reply, are
+ * misses. */
+void test_lookup_miss( void )
+{
+    ARPCacheStatistics_t xBefore, xAfter;
+
+    prvLearn( HOST( 2 ), 2 );
+    vARPRefreshCacheEntry( NULL, HOST( 3 ) );
+
+    FreeRTOS_GetARPStatistics( &xBefore );
+    TEST_ASSERT_EQUAL( eARPCacheMiss, prvLookup( HOST( 4 ) ) );
+    TEST_ASSERT_EQUAL( eCantSendPacket, prvLookup( HOST( 3 ) ) );
+    FreeRTOS_GetARPStatistics( &xAfter );
+
+    TEST_ASSERT_EQUAL( xBefore.ulHits, xAfter.ulHits );
+    TEST_ASSERT_EQUAL( xBefore.ulMisses + 2u, xAfter.ulMisses );
+
+    /* The reply makes the entry valid. */
+    prvLearn( HOST( 3 ), 3 );
+    prvCheckHit( HOST( 3 ), 3 );
+}
+
+/* Addresses in the same hash bucket are all found, also after one of them
+ * was removed from the bucket. */
+void test_bucket_collisions( void )
+{
+    MACAddress_t xMAC;
+
+    TEST_ASSERT_EQUAL( BUCKET( HOST( 2 ) ), BUCKET( COLLIDING_HOST( 2 ) ) );
+    TEST_ASSERT_TRUE( BUCKET( HOST( 2 ) ) != BUCKET( HOST( 5 ) ) );
+
+    prvLearn( HOST( 2 ), 2 );
+    prvLearn( COLLIDING_HOST( 2 ), 12 );
+    prvLearn( HOST( 5 ), 5 );
+
+    prvCheckHit( HOST( 2 ), 2 );
+    prvCheckHit( COLLIDING_HOST( 2 ), 12 );
+    prvCheckHit( HOST( 5 ), 5 );
+
+    /* A new MAC address for the first one in the bucket. */
+    prvLearn( COLLIDING_HOST( 2 ), 13 );
+    prvCheckHit( COLLIDING_HOST( 2 ), 13 );
+    prvCheckHit( HOST( 2 ), 2 );
+
+    /* The host that moved to another address takes its MAC with it, the old
+     * row is cleared and unlinked. */
+    prvHostMAC( 2, &xMAC );
+    vARPRefreshCacheEntry( &xMAC, HOST( 6 ) );
+    prvCheckHit( HOST( 6 ), 2 );
+    TEST_ASSERT_EQUAL( eARPCacheMiss, prvLookup( HOST( 2 ) ) );
+    prvCheckHit( COLLIDING_HOST( 2 ), 13 );
+}
+
+/* When the cache is full, the least recently used entry is replaced, not the
+ * oldest one. */
+void test_least_recently_used_evicted( void )
+{
+    ARPCacheStatistics_t xBefore, xAfter;
+    uint8_t x;
+
+    for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+    {
+        prvLearn( HOST( 10 + x ), 10 + x );
+    }
+
+    /* The first two entries were learned first, but only the second one has
+     * not been used since. */
+    prvCheckHit( HOST( 10 ), 10 );
+
+    for( x = 2; x < ipconfigARP_CACHE_ENTRIES; x++ )
+    {
+        prvCheckHit( HOST( 10 + x ), 10 + x );
+    }
+
+    FreeRTOS_GetARPStatistics( &xBefore );
+    prvLearn( HOST( 100 ), 100 );
+    FreeRTOS_GetARPStatistics( &xAfter );
+
+    TEST_ASSERT_EQUAL( xBefore.ulEvictions + 1u, xAfter.ulEvictions );
+    TEST_ASSERT_EQUAL( eARPCacheMiss, prvLookup( HOST( 11 ) ) );
+    prvCheckHit( HOST( 100 ), 100 );
+    prvCheckHit( HOST( 10 ), 10 );
+
+    for( x = 2; x < ipconfigARP_CACHE_ENTRIES; x++ )
+    {
+        prvCheckHit( HOST( 10 + x ), 10 + x );
+    }
+}
+
+/* A free row is used before any entry is evicted. */
+void test_free_row_used_first( void )
+{
+    ARPCacheStatistics_t xBefore, xAfter;
+    uint8_t x;
+
+    for( x = 0; x + 1u < ipconfigARP_CACHE_ENTRIES; x++ )
+    {
+        prvLearn( HOST( 10 + x ), 10 + x );
+    }
+
+    FreeRTOS_GetARPStatistics( &xBefore );
+    prvLearn( HOST( 100 ), 100 );
+    FreeRTOS_GetARPStatistics( &xAfter );
+
+    TEST_ASSERT_EQUAL( xBefore.ulEvictions, xAfter.ulEvictions );
+
+    for( x = 0; x + 1u < ipconfigARP_CACHE_ENTRIES; x++ )
+    {
+        prvCheckHit( HOST( 10 + x ), 10 + x );
+    }
+}
+
+/* An entry that is used to send packets is refreshed early, an idle entry
+ * is not. */
+void test_entry_in_use_refreshed( void )
+{
+    ARPCacheStatistics_t xBefore, xAfter;
+    uint32_t ulAge;
+
+    prvLearn( HOST( 2 ), 2 );
+    prvLearn( HOST( 3 ), 3 );
+    prvCheckHit( HOST( 2 ), 2 );
+
+    /* Age the entries until the one in use reaches ipconfigARP_REFRESH_AGE.
+     * The first call also sends a gratuitous ARP. */
+    FreeRTOS_GetARPStatistics( &xBefore );
+
+    for( ulAge = ipconfigMAX_ARP_AGE; ulAge > ipconfigARP_REFRESH_AGE; ulAge-- )
+    {
+        vARPAgeCache();
+    }
+
+    FreeRTOS_GetARPStatistics( &xAfter );
+
+    TEST_ASSERT_EQUAL( xBefore.ulRefreshes + 1u, xAfter.ulRefreshes );
+    TEST_ASSERT_EQUAL_UINT32( HOST( 2 ), ulLastRequestTarget );
+
+    /* The reply resets the age, the entry stays valid. */
+    prvLearn( HOST( 2 ), 2 );
+    prvCheckHit( HOST( 2 ), 2 );
+    prvCheckHit( HOST( 3 ), 3 );
+}
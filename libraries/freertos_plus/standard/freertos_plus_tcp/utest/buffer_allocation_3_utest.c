@@ -0,0 +1,449 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_list.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+
+/* The number of threads that obtain and release buffers at the same time. */
+#define STRESS_THREAD_COUNT       6
+
+/* The number of get or release operations done by each thread. */
+#define STRESS_ITERATIONS         200000
+
+/* The number of buffers that each thread may hold at the same time.  All
+ * threads together ask for more buffers than the pool has. */
+#define STRESS_MAX_HELD           16
+
+/* The number of rounds in which two threads release the same descriptor. */
+#define DOUBLE_RELEASE_ROUNDS     20000
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* The number of errors seen by the threads.  Unity can only assert from the
+ * main thread. */
+static volatile uint32_t ulThreadErrors;
+
+/* The descriptor that is released twice, and a barrier to start both releases
+ * at the same time. */
+static NetworkBufferDescriptor_t * volatile pxDoubleReleased;
+static pthread_barrier_t xReleaseBarrier;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+/* BufferAllocation_3.c uses it when a buffer must grow.  FreeRTOS_IP.c, which
+ * defines it, is not part of this test. */
+NetworkBufferDescriptor_t * pxDuplicateNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                                                    size_t uxNewLength )
+{
+    NetworkBufferDescriptor_t * pxNewBuffer;
+
+    pxNewBuffer = pxGetNetworkBufferWithDescriptor( uxNewLength, 0 );
+
+    if( pxNewBuffer != NULL )
+    {
+        memcpy( pxNewBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+    }
+
+    return pxNewBuffer;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    /* Only the first call initialises the buffers. */
+    vListInitialiseItem_Ignore();
+    TEST_ASSERT_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+    ulThreadErrors = 0;
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    /* Every test returns all buffers. */
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Check that a buffer belongs to the class of uxClassSize bytes: it can grow
+ * to that size in place, but not beyond.  The latter moves the contents to a
+ * buffer of a bigger class, which is returned. */
+static NetworkBufferDescriptor_t * prvCheckClass( NetworkBufferDescriptor_t * pxBuffer,
+                                                  size_t uxClassSize )
+{
+    NetworkBufferDescriptor_t * pxMoved;
+
+    TEST_ASSERT_EQUAL_PTR( pxBuffer, pxResizeNetworkBufferWithDescriptor( pxBuffer, uxClassSize ) );
+
+    if( uxClassSize < ipTOTAL_ETHERNET_FRAME_SIZE )
+    {
+        pxMoved = pxResizeNetworkBufferWithDescriptor( pxBuffer, uxClassSize + 1 );
+        TEST_ASSERT_NOT_NULL( pxMoved );
+        TEST_ASSERT_TRUE( pxMoved != pxBuffer );
+        pxBuffer = pxMoved;
+    }
+
+    return pxBuffer;
+}
+
+static void * prvStressThread( void * pvParameter )
+{
+    NetworkBufferDescriptor_t * pxHeld[ STRESS_MAX_HELD ];
+    uint8_t ucPattern[ STRESS_MAX_HELD ];
+    size_t uxHeldCount = 0;
+    unsigned int uxSeed = ( unsigned int ) ( uintptr_t ) pvParameter;
+    uint32_t ulOwner = ( uint32_t ) ( uintptr_t ) pvParameter;
+    uint32_t ulIteration;
+    size_t uxSize, x;
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    for( ulIteration = 0; ulIteration < STRESS_ITERATIONS; ulIteration++ )
+    {
+        if( ( uxHeldCount < STRESS_MAX_HELD ) && ( ( rand_r( &uxSeed ) & 1 ) != 0 ) )
+        {
+            /* Mostly small requests, like ACKs, and some full frames. */
+            uxSize = ( rand_r( &uxSeed ) % 4 == 0 ) ? ipTOTAL_ETHERNET_FRAME_SIZE : ( size_t ) ( 60 + ( rand_r( &uxSeed ) % 600 ) );
+            pxBuffer = pxGetNetworkBufferWithDescriptor( uxSize, 0 );
+
+            if( pxBuffer != NULL )
+            {
+                /* The descriptor may not be owned by anyone else.  The
+                 * allocator does not use ulIPAddress, it is zero while the
+                 * descriptor is free. */
+                if( __sync_bool_compare_and_swap( &( pxBuffer->ulIPAddress ), 0u, ulOwner ) == 0 )
+                {
+                    __sync_add_and_fetch( &ulThreadErrors, 1u );
+                }
+
+                if( pxBuffer->xDataLength != uxSize )
+                {
+                    __sync_add_and_fetch( &ulThreadErrors, 1u );
+                }
+
+                /* Fill the whole buffer, any overlap with another buffer will
+                 * be detected when it is released. */
+                ucPattern[ uxHeldCount ] = ( uint8_t ) rand_r( &uxSeed );
+                memset( pxBuffer->pucEthernetBuffer, ucPattern[ uxHeldCount ], uxSize );
+                pxHeld[ uxHeldCount++ ] = pxBuffer;
+            }
+        }
+        else if( uxHeldCount > 0 )
+        {
+            x = ( size_t ) rand_r( &uxSeed ) % uxHeldCount;
+            pxBuffer = pxHeld[ x ];
+
+            for( uxSize = 0; uxSize < pxBuffer->xDataLength; uxSize++ )
+            {
+                if( pxBuffer->pucEthernetBuffer[ uxSize ] != ucPattern[ x ] )
+                {
+                    __sync_add_and_fetch( &ulThreadErrors, 1u );
+                    break;
+                }
+            }
+
+            pxBuffer->ulIPAddress = 0u;
+            vReleaseNetworkBufferAndDescriptor( pxBuffer );
+
+            uxHeldCount--;
+            pxHeld[ x ] = pxHeld[ uxHeldCount ];
+            ucPattern[ x ] = ucPattern[ uxHeldCount ];
+        }
+    }
+
+    while( uxHeldCount > 0 )
+    {
+        uxHeldCount--;
+        pxHeld[ uxHeldCount ]->ulIPAddress = 0u;
+        vReleaseNetworkBufferAndDescriptor( pxHeld[ uxHeldCount ] );
+    }
+
+    return NULL;
+}
+
+static void * prvDoubleReleaseThread( void * pvParameter )
+{
+    uint32_t ulRound;
+
+    ( void ) pvParameter;
+
+    for( ulRound = 0; ulRound < DOUBLE_RELEASE_ROUNDS; ulRound++ )
+    {
+        /* Wait until the main thread has obtained the descriptor. */
+        pthread_barrier_wait( &xReleaseBarrier );
+        vReleaseNetworkBufferAndDescriptor( pxDoubleReleased );
+        /* Let the main thread check the result. */
+        pthread_barrier_wait( &xReleaseBarrier );
+    }
+
+    return NULL;
+}
+
+/* ======================  TESTING BufferAllocation_3.c ===================== */
+
+/**
+ * @brief A small request is served from the small buffers, a full frame from
+ * the large buffers.
+ */
+void test_BufferAllocation3_size_classes( void )
+{
+    NetworkBufferDescriptor_t * pxSmall, * pxLarge;
+
+    pxSmall = pxGetNetworkBufferWithDescriptor( 60, 0 );
+    pxLarge = pxGetNetworkBufferWithDescriptor( ipTOTAL_ETHERNET_FRAME_SIZE, 0 );
+
+    TEST_ASSERT_NOT_NULL( pxSmall );
+    TEST_ASSERT_NOT_NULL( pxLarge );
+    TEST_ASSERT_EQUAL( 60, pxSmall->xDataLength );
+    TEST_ASSERT_EQUAL( ipTOTAL_ETHERNET_FRAME_SIZE, pxLarge->xDataLength );
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - 2, uxGetNumberOfFreeNetworkBuffers() );
+
+    /* The padding in front of the buffer points to the descriptor, as with
+     * BufferAllocation_2.c. */
+    TEST_ASSERT_EQUAL_PTR( pxSmall, *( ( NetworkBufferDescriptor_t ** ) ( pxSmall->pucEthernetBuffer - ipBUFFER_PADDING ) ) );
+    TEST_ASSERT_EQUAL_PTR( pxLarge, *( ( NetworkBufferDescriptor_t ** ) ( pxLarge->pucEthernetBuffer - ipBUFFER_PADDING ) ) );
+
+    vReleaseNetworkBufferAndDescriptor( pxSmall );
+    vReleaseNetworkBufferAndDescriptor( pxLarge );
+}
+
+/**
+ * @brief A request is served from the smallest class that fits: small, medium
+ * or large.
+ */
+void test_BufferAllocation3_smallest_fitting_class( void )
+{
+    NetworkBufferDescriptor_t * pxSmall, * pxMedium, * pxLarge;
+
+    pxSmall = pxGetNetworkBufferWithDescriptor( ipconfigBUFFER_ALLOC_3_SMALL_SIZE, 0 );
+    pxMedium = pxGetNetworkBufferWithDescriptor( ipconfigBUFFER_ALLOC_3_SMALL_SIZE + 1, 0 );
+    pxLarge = pxGetNetworkBufferWithDescriptor( ipconfigBUFFER_ALLOC_3_MEDIUM_SIZE + 1, 0 );
+
+    TEST_ASSERT_NOT_NULL( pxSmall );
+    TEST_ASSERT_NOT_NULL( pxMedium );
+    TEST_ASSERT_NOT_NULL( pxLarge );
+
+    pxSmall = prvCheckClass( pxSmall, ipconfigBUFFER_ALLOC_3_SMALL_SIZE );
+    pxMedium = prvCheckClass( pxMedium, ipconfigBUFFER_ALLOC_3_MEDIUM_SIZE );
+    pxLarge = prvCheckClass( pxLarge, ipTOTAL_ETHERNET_FRAME_SIZE );
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - 3, uxGetNumberOfFreeNetworkBuffers() );
+
+    vReleaseNetworkBufferAndDescriptor( pxSmall );
+    vReleaseNetworkBufferAndDescriptor( pxMedium );
+    vReleaseNetworkBufferAndDescriptor( pxLarge );
+}
+
+/**
+ * @brief When the small buffers are gone, small requests are served from the
+ * medium buffers, and then from the large ones.  A small buffer that is
+ * released is used again before a bigger one.
+ */
+void test_BufferAllocation3_bigger_class_when_exhausted( void )
+{
+    NetworkBufferDescriptor_t * pxBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+    size_t uxCount = 0, x;
+
+    for( x = 0; x < ipconfigBUFFER_ALLOC_3_SMALL_COUNT; x++ )
+    {
+        pxBuffers[ uxCount ] = pxGetNetworkBufferWithDescriptor( 60, 0 );
+        TEST_ASSERT_NOT_NULL( pxBuffers[ uxCount ] );
+        uxCount++;
+    }
+
+    for( x = 0; x < ipconfigBUFFER_ALLOC_3_MEDIUM_COUNT; x++ )
+    {
+        pxBuffers[ uxCount ] = pxGetNetworkBufferWithDescriptor( 60, 0 );
+        TEST_ASSERT_NOT_NULL( pxBuffers[ uxCount ] );
+        TEST_ASSERT_EQUAL_PTR( pxBuffers[ uxCount ], pxResizeNetworkBufferWithDescriptor( pxBuffers[ uxCount ], ipconfigBUFFER_ALLOC_3_MEDIUM_SIZE ) );
+        uxCount++;
+    }
+
+    pxBuffers[ uxCount ] = pxGetNetworkBufferWithDescriptor( 60, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffers[ uxCount ] );
+    pxBuffers[ uxCount ] = prvCheckClass( pxBuffers[ uxCount ], ipTOTAL_ETHERNET_FRAME_SIZE );
+    uxCount++;
+
+    vReleaseNetworkBufferAndDescriptor( pxBuffers[ 0 ] );
+    pxBuffers[ 0 ] = pxGetNetworkBufferWithDescriptor( 60, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffers[ 0 ] );
+    pxBuffers[ 0 ] = prvCheckClass( pxBuffers[ 0 ], ipconfigBUFFER_ALLOC_3_SMALL_SIZE );
+
+    for( x = 0; x < uxCount; x++ )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffers[ x ] );
+    }
+}
+
+/**
+ * @brief Too large requests fail, and an exhausted pool returns NULL when the
+ * block time is zero.
+ */
+void test_BufferAllocation3_exhausted( void )
+{
+    NetworkBufferDescriptor_t * pxBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+    size_t x;
+
+    TEST_ASSERT_NULL( pxGetNetworkBufferWithDescriptor( ipTOTAL_ETHERNET_FRAME_SIZE + 1, 0 ) );
+
+    /* Small requests use bigger classes once the small buffers are gone. */
+    for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+    {
+        pxBuffers[ x ] = pxGetNetworkBufferWithDescriptor( 60, 0 );
+        TEST_ASSERT_NOT_NULL( pxBuffers[ x ] );
+    }
+
+    TEST_ASSERT_NULL( pxGetNetworkBufferWithDescriptor( 60, 0 ) );
+    TEST_ASSERT_EQUAL( 0, uxGetNumberOfFreeNetworkBuffers() );
+    TEST_ASSERT_EQUAL( 0, uxGetMinimumFreeNetworkBuffers() );
+
+    for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffers[ x ] );
+    }
+}
+
+/**
+ * @brief Releasing a descriptor twice, or releasing something that is not a
+ * descriptor, does not change the pool.
+ */
+void test_BufferAllocation3_double_release( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+    NetworkBufferDescriptor_t xForeign;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( 100, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    vReleaseNetworkBufferAndDescriptor( &xForeign );
+    vReleaseNetworkBufferAndDescriptor( NULL );
+
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/**
+ * @brief Growing a small buffer moves the data to a bigger one.
+ */
+void test_BufferAllocation3_resize( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer, * pxResized;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( 60, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    memset( pxBuffer->pucEthernetBuffer, 0xa5, 60 );
+
+    /* Within the size of the class, the descriptor stays the same. */
+    pxResized = pxResizeNetworkBufferWithDescriptor( pxBuffer, 100 );
+    TEST_ASSERT_EQUAL_PTR( pxBuffer, pxResized );
+    TEST_ASSERT_EQUAL( 100, pxResized->xDataLength );
+    pxResized->xDataLength = 60;
+
+    pxResized = pxResizeNetworkBufferWithDescriptor( pxBuffer, ipTOTAL_ETHERNET_FRAME_SIZE );
+    TEST_ASSERT_NOT_NULL( pxResized );
+    TEST_ASSERT_EQUAL( ipTOTAL_ETHERNET_FRAME_SIZE, pxResized->xDataLength );
+    TEST_ASSERT_EQUAL_UINT8( 0xa5, pxResized->pucEthernetBuffer[ 0 ] );
+    TEST_ASSERT_EQUAL_UINT8( 0xa5, pxResized->pucEthernetBuffer[ 59 ] );
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - 1, uxGetNumberOfFreeNetworkBuffers() );
+
+    vReleaseNetworkBufferAndDescriptor( pxResized );
+}
+
+/**
+ * @brief Several threads obtain and release buffers of random sizes at the
+ * same time.  No descriptor may be handed out twice, no two buffers may
+ * overlap, and all buffers must be returned in the end.
+ */
+void test_BufferAllocation3_stress( void )
+{
+    pthread_t xThreads[ STRESS_THREAD_COUNT ];
+    size_t x;
+
+    for( x = 0; x < STRESS_THREAD_COUNT; x++ )
+    {
+        TEST_ASSERT_EQUAL( 0, pthread_create( &( xThreads[ x ] ), NULL, prvStressThread, ( void * ) ( uintptr_t ) ( x + 1 ) ) );
+    }
+
+    for( x = 0; x < STRESS_THREAD_COUNT; x++ )
+    {
+        TEST_ASSERT_EQUAL( 0, pthread_join( xThreads[ x ], NULL ) );
+    }
+
+    TEST_ASSERT_EQUAL( 0, ulThreadErrors );
+}
+
+/**
+ * @brief Two threads release the same descriptor at the same moment.  It must
+ * be put on the free stack exactly once.
+ */
+void test_BufferAllocation3_concurrent_double_release( void )
+{
+    pthread_t xThread;
+    uint32_t ulRound;
+
+    TEST_ASSERT_EQUAL( 0, pthread_barrier_init( &xReleaseBarrier, NULL, 2 ) );
+    TEST_ASSERT_EQUAL( 0, pthread_create( &xThread, NULL, prvDoubleReleaseThread, NULL ) );
+
+    for( ulRound = 0; ulRound < DOUBLE_RELEASE_ROUNDS; ulRound++ )
+    {
+        pxDoubleReleased = pxGetNetworkBufferWithDescriptor( 60, 0 );
+        TEST_ASSERT_NOT_NULL( pxDoubleReleased );
+
+        pthread_barrier_wait( &xReleaseBarrier );
+        vReleaseNetworkBufferAndDescriptor( pxDoubleReleased );
+        pthread_barrier_wait( &xReleaseBarrier );
+
+        TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+    }
+
+    TEST_ASSERT_EQUAL( 0, pthread_join( xThread, NULL ) );
+    pthread_barrier_destroy( &xReleaseBarrier );
+}
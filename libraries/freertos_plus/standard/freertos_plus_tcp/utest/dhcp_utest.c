@@ -0,0 +1,651 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_list.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_DHCP.h"
+
+/* The layout of a DHCP message, see RFC 2131. */
+#define DHCP_XID_OFFSET            4u
+#define DHCP_YIADDR_OFFSET         16u
+#define DHCP_CHADDR_OFFSET         28u
+#define DHCP_COOKIE_OFFSET         236u
+#define DHCP_OPTIONS_OFFSET        240u
+#define DHCP_MESSAGE_LENGTH        400u
+
+/* Options used by the tests. */
+#define OPTION_SUBNET_MASK         1u
+#define OPTION_LEASE_TIME          51u
+#define OPTION_MESSAGE_TYPE        53u
+#define OPTION_SERVER_ID           54u
+#define OPTION_RAPID_COMMIT        80u
+#define OPTION_END                 255u
+
+#define TYPE_DISCOVER              1u
+#define TYPE_OFFER                 2u
+#define TYPE_REQUEST               3u
+#define TYPE_ACK                   5u
+#define TYPE_NAK                   6u
+
+/* The INIT-REBOOT request is repeated after this time. */
+#define INIT_REBOOT_PERIOD         pdMS_TO_TICKS( 1000 )
+
+/* A cached address is used when the ARP probe has had no answer for this
+ * time. */
+#define LEASE_PROBE_PERIOD         pdMS_TO_TICKS( 500 )
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined by other modules of the stack. */
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+NetworkAddressingParameters_t xDefaultAddressing;
+BaseType_t xARPHadIPClash;
+
+/* Stands in for the DHCP socket. */
+static uint8_t ucSocket;
+
+/* The time as seen by the DHCP module. */
+static TickType_t xTickCount;
+
+/* The message type and the transaction ID of every message sent. */
+static uint8_t ucSentTypes[ 8 ];
+static size_t uxSentCount;
+static uint8_t ucTransactionID[ 4 ];
+
+/* The options of the last message sent. */
+static uint8_t ucSentOptions[ DHCP_MESSAGE_LENGTH - DHCP_OPTIONS_OFFSET ];
+
+/* The reply that FreeRTOS_recvfrom() will return, if any. */
+static uint8_t ucReply[ DHCP_MESSAGE_LENGTH ];
+static size_t uxReplyLength;
+
+/* The lease cached by the application. */
+static DHCPLease_t xCachedLease;
+static BaseType_t xHasCachedLease;
+static uint32_t ulLeasesStored;
+
+/* The address being probed with ARP, and the number of probes sent. */
+static uint32_t ulProbeAddress;
+static uint32_t ulProbesSent;
+
+/* The number of times the network came up. */
+static uint32_t ulNetworkUpCount;
+
+/* Addresses used in the tests. */
+static uint32_t ulCachedAddress;
+static uint32_t ulOfferedAddress;
+static uint32_t ulServerAddress;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static TickType_t prvGetTickCount( int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return xTickCount;
+}
+
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber )
+{
+    *pulNumber = 0x12345678UL;
+
+    return pdTRUE;
+}
+
+Socket_t FreeRTOS_socket( BaseType_t xDomain,
+                          BaseType_t xType,
+                          BaseType_t xProtocol )
+{
+    ( void ) xDomain;
+    ( void ) xType;
+    ( void ) xProtocol;
+
+    return ( Socket_t ) &ucSocket;
+}
+
+BaseType_t FreeRTOS_setsockopt( Socket_t xSocket,
+                                int32_t lLevel,
+                                int32_t lOptionName,
+                                const void * pvOptionValue,
+                                size_t xOptionLength )
+{
+    ( void ) xSocket;
+    ( void ) lLevel;
+    ( void ) lOptionName;
+    ( void ) pvOptionValue;
+    ( void ) xOptionLength;
+
+    return 0;
+}
+
+BaseType_t vSocketBind( FreeRTOS_Socket_t * pxSocket,
+                        struct freertos_sockaddr * pxAddress,
+                        size_t uxAddressLength,
+                        BaseType_t xInternal )
+{
+    ( void ) pxSocket;
+    ( void ) pxAddress;
+    ( void ) uxAddressLength;
+    ( void ) xInternal;
+
+    return 0;
+}
+
+void * vSocketClose( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+
+    return NULL;
+}
+
+void * FreeRTOS_GetUDPPayloadBuffer( size_t xRequestedSizeBytes,
+                                     TickType_t xBlockTimeTicks )
+{
+    ( void ) xBlockTimeTicks;
+
+    return calloc( 1, xRequestedSizeBytes );
+}
+
+void FreeRTOS_ReleaseUDPPayloadBuffer( void * pvBuffer )
+{
+    /* Received messages are owned by the test, a failed send is not
+     * expected. */
+    ( void ) pvBuffer;
+}
+
+int32_t FreeRTOS_sendto( Socket_t xSocket,
+                         const void * pvBuffer,
+                         size_t xTotalDataLength,
+                         BaseType_t xFlags,
+                         const struct freertos_sockaddr * pxDestinationAddress,
+                         socklen_t xDestinationAddressLength )
+{
+    const uint8_t * pucMessage = ( const uint8_t * ) pvBuffer;
+    size_t uxLength;
+
+    ( void ) xSocket;
+    ( void ) xFlags;
+    ( void ) pxDestinationAddress;
+    ( void ) xDestinationAddressLength;
+
+    /* The message type is always the first option. */
+    TEST_ASSERT_EQUAL( OPTION_MESSAGE_TYPE, pucMessage[ DHCP_OPTIONS_OFFSET ] );
+    TEST_ASSERT_LESS_THAN( sizeof( ucSentTypes ), uxSentCount );
+    ucSentTypes[ uxSentCount++ ] = pucMessage[ DHCP_OPTIONS_OFFSET + 2u ];
+    memcpy( ucTransactionID, &( pucMessage[ DHCP_XID_OFFSET ] ), sizeof( ucTransactionID ) );
+
+    uxLength = xTotalDataLength - DHCP_OPTIONS_OFFSET;
+
+    if( uxLength > sizeof( ucSentOptions ) )
+    {
+        uxLength = sizeof( ucSentOptions );
+    }
+
+    memset( ucSentOptions, OPTION_END, sizeof( ucSentOptions ) );
+    memcpy( ucSentOptions, &( pucMessage[ DHCP_OPTIONS_OFFSET ] ), uxLength );
+
+    /* A zero-copy send passes the buffer on. */
+    free( ( void * ) pvBuffer );
+
+    return ( int32_t ) xTotalDataLength;
+}
+
+int32_t FreeRTOS_recvfrom( Socket_t xSocket,
+                           void * pvBuffer,
+                           size_t xBufferLength,
+                           BaseType_t xFlags,
+                           struct freertos_sockaddr * pxSourceAddress,
+                           socklen_t * pxSourceAddressLength )
+{
+    int32_t lReturn = 0;
+
+    ( void ) xSocket;
+    ( void ) xBufferLength;
+    ( void ) pxSourceAddress;
+    ( void ) pxSourceAddressLength;
+
+    TEST_ASSERT_NOT_EQUAL( 0, xFlags & FREERTOS_ZERO_COPY );
+
+    if( uxReplyLength != 0u )
+    {
+        *( ( uint8_t ** ) pvBuffer ) = ucReply;
+        lReturn = ( int32_t ) uxReplyLength;
+        uxReplyLength = 0u;
+    }
+
+    return lReturn;
+}
+
+void vIPNetworkUpCalls( void )
+{
+    ulNetworkUpCount++;
+}
+
+void vIPReloadDHCPTimer( uint32_t ulLeaseTime )
+{
+    ( void ) ulLeaseTime;
+}
+
+void vIPSetDHCPTimerEnableState( BaseType_t xEnableState )
+{
+    ( void ) xEnableState;
+}
+
+void vARPSendGratuitous( void )
+{
+}
+
+void vARPProbeAddress( uint32_t ulIPAddress )
+{
+    ulProbeAddress = ulIPAddress;
+
+    if( ulIPAddress != 0UL )
+    {
+        ulProbesSent++;
+    }
+}
+
+BaseType_t xApplicationDHCPLoadLease( DHCPLease_t * pxLease )
+{
+    *pxLease = xCachedLease;
+
+    return xHasCachedLease;
+}
+
+void vApplicationDHCPStoreLease( const DHCPLease_t * pxLease )
+{
+    xCachedLease = *pxLease;
+    ulLeasesStored++;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    static const uint8_t ucMACAddress[ 6 ] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+    xTaskGetTickCount_Stub( prvGetTickCount );
+
+    memset( &xDefaultPartUDPPacketHeader, 0, sizeof( xDefaultPartUDPPacketHeader ) );
+    memcpy( ipLOCAL_MAC_ADDRESS, ucMACAddress, sizeof( ucMACAddress ) );
+    memset( &xNetworkAddressing, 0, sizeof( xNetworkAddressing ) );
+
+    ulCachedAddress = FreeRTOS_inet_addr_quick( 192, 168, 1, 50 );
+    ulOfferedAddress = FreeRTOS_inet_addr_quick( 192, 168, 1, 60 );
+    ulServerAddress = FreeRTOS_inet_addr_quick( 192, 168, 1, 1 );
+
+    xTickCount = 1000u;
+    uxSentCount = 0u;
+    uxReplyLength = 0u;
+    xARPHadIPClash = pdFALSE;
+    ulProbeAddress = 0UL;
+    ulProbesSent = 0u;
+    ulNetworkUpCount = 0u;
+    ulLeasesStored = 0u;
+    xHasCachedLease = pdFALSE;
+    memset( &xCachedLease, 0, sizeof( xCachedLease ) );
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Prepare a reply of the given type to the last message sent.  When
+ * xRapidCommit is true, the rapid-commit option is placed before the subnet
+ * mask, to see that the parser continues after this empty option. */
+static void prvSetReply( uint8_t ucType,
+                         uint32_t ulYourAddress,
+                         BaseType_t xRapidCommit )
+{
+    static const uint8_t ucCookie[ 4 ] = { 0x63, 0x82, 0x53, 0x63 };
+    static const uint8_t ucLeaseTime[ 4 ] = { 0x00, 0x00, 0x0e, 0x10 };
+    static const uint8_t ucNetMask[ 4 ] = { 255, 255, 255, 0 };
+    uint8_t * pucOption = &( ucReply[ DHCP_OPTIONS_OFFSET ] );
+
+    memset( ucReply, 0, sizeof( ucReply ) );
+    ucReply[ 0 ] = 2u; /* BOOTREPLY */
+    ucReply[ 1 ] = 1u;
+    ucReply[ 2 ] = 6u;
+    memcpy( &( ucReply[ DHCP_XID_OFFSET ] ), ucTransactionID, sizeof( ucTransactionID ) );
+    memcpy( &( ucReply[ DHCP_YIADDR_OFFSET ] ), &ulYourAddress, sizeof( ulYourAddress ) );
+    memcpy( &( ucReply[ DHCP_CHADDR_OFFSET ] ), ipLOCAL_MAC_ADDRESS, 6u );
+    memcpy( &( ucReply[ DHCP_COOKIE_OFFSET ] ), ucCookie, sizeof( ucCookie ) );
+
+    *( pucOption++ ) = OPTION_MESSAGE_TYPE;
+    *( pucOption++ ) = 1u;
+    *( pucOption++ ) = ucType;
+    *( pucOption++ ) = OPTION_SERVER_ID;
+    *( pucOption++ ) = 4u;
+    memcpy( pucOption, &ulServerAddress, 4u );
+    pucOption += 4;
+    *( pucOption++ ) = OPTION_LEASE_TIME;
+    *( pucOption++ ) = 4u;
+    memcpy( pucOption, ucLeaseTime, 4u );
+    pucOption += 4;
+
+    if( xRapidCommit != pdFALSE )
+    {
+        *( pucOption++ ) = OPTION_RAPID_COMMIT;
+        *( pucOption++ ) = 0u;
+    }
+
+    *( pucOption++ ) = OPTION_SUBNET_MASK;
+    *( pucOption++ ) = 4u;
+    memcpy( pucOption, ucNetMask, 4u );
+    pucOption += 4;
+    *( pucOption++ ) = OPTION_END;
+
+    uxReplyLength = ( size_t ) ( pucOption - ucReply );
+}
+
+/* Returns true when the options of the last message sent contain ucCode. */
+static BaseType_t prvSentOption( uint8_t ucCode )
+{
+    size_t uxIndex = 0u;
+    BaseType_t xFound = pdFALSE;
+
+    while( ( uxIndex + 1u < sizeof( ucSentOptions ) ) && ( ucSentOptions[ uxIndex ] != OPTION_END ) )
+    {
+        if( ucSentOptions[ uxIndex ] == ucCode )
+        {
+            xFound = pdTRUE;
+            break;
+        }
+
+        uxIndex += 2u + ucSentOptions[ uxIndex + 1u ];
+    }
+
+    return xFound;
+}
+
+static void prvSetCachedLease( void )
+{
+    xCachedLease.ulIPAddress = ulCachedAddress;
+    xCachedLease.ulDHCPServerAddress = ulServerAddress;
+    xHasCachedLease = pdTRUE;
+}
+
+/* ======================== Test functions ================================= */
+
+/* A cached lease is asked for with a request, without a discover, and the
+ * address is probed while the request is outstanding.  The address is in
+ * use after a single exchange, once the probe has had no answer. */
+void test_init_reboot_ack( void )
+{
+    prvSetCachedLease();
+
+    vDHCPProcess( pdTRUE );
+
+    TEST_ASSERT_EQUAL( 1, uxSentCount );
+    TEST_ASSERT_EQUAL( TYPE_REQUEST, ucSentTypes[ 0 ] );
+    TEST_ASSERT_FALSE( prvSentOption( OPTION_SERVER_ID ) );
+    TEST_ASSERT_EQUAL( ulCachedAddress, ulProbeAddress );
+    TEST_ASSERT_EQUAL( 1, ulProbesSent );
+    TEST_ASSERT_EQUAL( 0, *ipLOCAL_IP_ADDRESS_POINTER );
+
+    prvSetReply( TYPE_ACK, ulCachedAddress, pdFALSE );
+    vDHCPProcess( pdFALSE );
+
+    /* The ACK came before the probe could be answered. */
+    TEST_ASSERT_EQUAL( 0, ulNetworkUpCount );
+    TEST_ASSERT_EQUAL( 0, *ipLOCAL_IP_ADDRESS_POINTER );
+    TEST_ASSERT_EQUAL( ulCachedAddress, ulProbeAddress );
+
+    uxReplyLength = 0u;
+    xTickCount += LEASE_PROBE_PERIOD;
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 1, ulNetworkUpCount );
+    TEST_ASSERT_EQUAL( 1, uxSentCount );
+    TEST_ASSERT_EQUAL( ulCachedAddress, *ipLOCAL_IP_ADDRESS_POINTER );
+    TEST_ASSERT_EQUAL( FreeRTOS_inet_addr_quick( 255, 255, 255, 0 ), xNetworkAddressing.ulNetMask );
+    TEST_ASSERT_EQUAL( 0, ulProbeAddress );
+    TEST_ASSERT_EQUAL( 1, ulLeasesStored );
+    TEST_ASSERT_EQUAL( ulCachedAddress, xCachedLease.ulIPAddress );
+    TEST_ASSERT_EQUAL( ulServerAddress, xCachedLease.ulDHCPServerAddress );
+}
+
+/* When another device answers the probe, the cached address is not used, and
+ * a discover follows. */
+void test_init_reboot_probe_conflict( void )
+{
+    prvSetCachedLease();
+
+    vDHCPProcess( pdTRUE );
+    TEST_ASSERT_EQUAL( ulCachedAddress, ulProbeAddress );
+
+    /* The ARP module saw a reply from the cached address. */
+    xARPHadIPClash = pdTRUE;
+    prvSetReply( TYPE_ACK, ulCachedAddress, pdFALSE );
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 0, ulNetworkUpCount );
+    TEST_ASSERT_EQUAL( 0, *ipLOCAL_IP_ADDRESS_POINTER );
+
+    /* The next call starts INIT, the lease is not tried again. */
+    uxReplyLength = 0u;
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 2, uxSentCount );
+    TEST_ASSERT_EQUAL( TYPE_DISCOVER, ucSentTypes[ 1 ] );
+    TEST_ASSERT_EQUAL( 0, ulProbeAddress );
+    TEST_ASSERT_EQUAL( 1, ulProbesSent );
+}
+
+/* An answer to the probe that comes after the ACK, but within the probe
+ * period, still prevents the use of the cached address. */
+void test_init_reboot_probe_answered_after_ack( void )
+{
+    prvSetCachedLease();
+
+    vDHCPProcess( pdTRUE );
+    prvSetReply( TYPE_ACK, ulCachedAddress, pdFALSE );
+    vDHCPProcess( pdFALSE );
+    TEST_ASSERT_EQUAL( 0, ulNetworkUpCount );
+
+    uxReplyLength = 0u;
+    xTickCount += LEASE_PROBE_PERIOD - 1u;
+    xARPHadIPClash = pdTRUE;
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 0, ulNetworkUpCount );
+    TEST_ASSERT_EQUAL( 0, *ipLOCAL_IP_ADDRESS_POINTER );
+    TEST_ASSERT_EQUAL( 0, ulLeasesStored );
+
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 2, uxSentCount );
+    TEST_ASSERT_EQUAL( TYPE_DISCOVER, ucSentTypes[ 1 ] );
+}
+
+/* The time to an IP address with a cached lease, in ticks of the DHCP module:
+ * the probe period when the server answers quickly, and the time of the ACK
+ * when it answers after the probe period. */
+void test_init_reboot_time_to_ip( void )
+{
+    TickType_t xStartTime = xTickCount;
+
+    prvSetCachedLease();
+    vDHCPProcess( pdTRUE );
+
+    /* The DHCP timer calls every 250 ms, the ACK arrives after 10 ms. */
+    xTickCount += pdMS_TO_TICKS( 10 );
+    prvSetReply( TYPE_ACK, ulCachedAddress, pdFALSE );
+    vDHCPProcess( pdFALSE );
+    uxReplyLength = 0u;
+
+    while( ulNetworkUpCount == 0u )
+    {
+        xTickCount += pdMS_TO_TICKS( 250 );
+        vDHCPProcess( pdFALSE );
+    }
+
+    TEST_ASSERT_EQUAL( xStartTime + pdMS_TO_TICKS( 510 ), xTickCount );
+
+    /* A slow server: the probe period has passed when the ACK arrives. */
+    *ipLOCAL_IP_ADDRESS_POINTER = 0UL;
+    ulNetworkUpCount = 0u;
+    uxSentCount = 0u;
+    xStartTime = xTickCount;
+    vDHCPProcess( pdTRUE );
+
+    xTickCount += LEASE_PROBE_PERIOD + pdMS_TO_TICKS( 100 );
+    prvSetReply( TYPE_ACK, ulCachedAddress, pdFALSE );
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 1, ulNetworkUpCount );
+    TEST_ASSERT_EQUAL( xStartTime + LEASE_PROBE_PERIOD + pdMS_TO_TICKS( 100 ), xTickCount );
+}
+
+/* A NAK for the cached address starts a discovery. */
+void test_init_reboot_nak( void )
+{
+    prvSetCachedLease();
+
+    vDHCPProcess( pdTRUE );
+    prvSetReply( TYPE_NAK, 0UL, pdFALSE );
+    vDHCPProcess( pdFALSE );
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 0, ulNetworkUpCount );
+    TEST_ASSERT_EQUAL( 2, uxSentCount );
+    TEST_ASSERT_EQUAL( TYPE_DISCOVER, ucSentTypes[ 1 ] );
+}
+
+/* The request for the cached address is repeated once, together with a new
+ * probe.  Without an answer, a discovery starts. */
+void test_init_reboot_timeout( void )
+{
+    prvSetCachedLease();
+
+    vDHCPProcess( pdTRUE );
+
+    xTickCount += INIT_REBOOT_PERIOD + 1u;
+    vDHCPProcess( pdFALSE );
+    TEST_ASSERT_EQUAL( 2, uxSentCount );
+    TEST_ASSERT_EQUAL( TYPE_REQUEST, ucSentTypes[ 1 ] );
+    TEST_ASSERT_EQUAL( 2, ulProbesSent );
+
+    xTickCount += ( 2u * INIT_REBOOT_PERIOD ) + 1u;
+    vDHCPProcess( pdFALSE );
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 3, uxSentCount );
+    TEST_ASSERT_EQUAL( TYPE_DISCOVER, ucSentTypes[ 2 ] );
+    TEST_ASSERT_EQUAL( 0, ulProbeAddress );
+}
+
+/* Without a cached lease, the discover carries the rapid-commit option.  An
+ * ACK with that option binds the address without a request. */
+void test_rapid_commit_ack( void )
+{
+    vDHCPProcess( pdTRUE );
+
+    TEST_ASSERT_EQUAL( 1, uxSentCount );
+    TEST_ASSERT_EQUAL( TYPE_DISCOVER, ucSentTypes[ 0 ] );
+    TEST_ASSERT_TRUE( prvSentOption( OPTION_RAPID_COMMIT ) );
+    TEST_ASSERT_EQUAL( 0, ulProbesSent );
+
+    prvSetReply( TYPE_ACK, ulOfferedAddress, pdTRUE );
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 1, ulNetworkUpCount );
+    TEST_ASSERT_EQUAL( 1, uxSentCount );
+    TEST_ASSERT_EQUAL( ulOfferedAddress, *ipLOCAL_IP_ADDRESS_POINTER );
+
+    /* The options after the empty rapid-commit option were parsed too. */
+    TEST_ASSERT_EQUAL( FreeRTOS_inet_addr_quick( 255, 255, 255, 0 ), xNetworkAddressing.ulNetMask );
+    TEST_ASSERT_EQUAL( ulOfferedAddress, xCachedLease.ulIPAddress );
+}
+
+/* An ACK to a discover, without the rapid-commit option, is ignored. */
+void test_ack_without_rapid_commit( void )
+{
+    vDHCPProcess( pdTRUE );
+
+    prvSetReply( TYPE_ACK, ulOfferedAddress, pdFALSE );
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 0, ulNetworkUpCount );
+    TEST_ASSERT_EQUAL( 1, uxSentCount );
+    TEST_ASSERT_EQUAL( 0, *ipLOCAL_IP_ADDRESS_POINTER );
+}
+
+/* A server without rapid commit needs an offer and a request: two exchanges
+ * in stead of one. */
+void test_offer_request_ack( void )
+{
+    vDHCPProcess( pdTRUE );
+
+    prvSetReply( TYPE_OFFER, ulOfferedAddress, pdFALSE );
+    vDHCPProcess( pdFALSE );
+    TEST_ASSERT_EQUAL( 2, uxSentCount );
+    TEST_ASSERT_EQUAL( TYPE_REQUEST, ucSentTypes[ 1 ] );
+    TEST_ASSERT_TRUE( prvSentOption( OPTION_SERVER_ID ) );
+
+    prvSetReply( TYPE_ACK, ulOfferedAddress, pdFALSE );
+    vDHCPProcess( pdFALSE );
+
+    TEST_ASSERT_EQUAL( 1, ulNetworkUpCount );
+    TEST_ASSERT_EQUAL( ulOfferedAddress, *ipLOCAL_IP_ADDRESS_POINTER );
+}
@@ -0,0 +1,592 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_DHCP.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The number of payload bytes in a fragment that is not the last one. */
+#define FRAGMENT_LENGTH         24u
+
+/* The number of fragments of a complete test datagram. */
+#define FRAGMENT_COUNT          3u
+
+/* The length of the IP header of the fragments, without options. */
+#define IP_HEADER_LENGTH        ipSIZE_OF_IPv4_HEADER
+
+/* The addresses of the datagrams. */
+#define REMOTE_IP               0xC0A80002UL
+#define LOCAL_IP                0xC0A80001UL
+
+/* The most events that a test expects to be sent to the IP-task. */
+#define MAX_EVENTS              4u
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Defined in FreeRTOS_UDP_IP.c, which is not part of this test. */
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+
+/* Network buffers of a variable size, allocated with malloc(). */
+const BaseType_t xBufferAllocFixedSize = pdFALSE;
+
+/* The number of network buffers that have not been released. */
+static BaseType_t xBuffersInUse;
+
+/* The current tick count. */
+static TickType_t xTickCount;
+
+/* The events sent to the IP-task, and the result of sending them. */
+static IPStackEvent_t xEvents[ MAX_EVENTS ];
+static UBaseType_t uxEventCount;
+static BaseType_t xSendResult;
+
+/* The number of UDP packets passed to the protocol layer. */
+static UBaseType_t uxUDPPackets;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static TickType_t prvGetTickCount( int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return xTickCount;
+}
+
+static BaseType_t prvQueueGenericSend( QueueHandle_t xQueue,
+                                       const void * const pvItemToQueue,
+                                       TickType_t xTicksToWait,
+                                       const BaseType_t xCopyPosition,
+                                       int cmock_num_calls )
+{
+    ( void ) xQueue;
+    ( void ) xTicksToWait;
+    ( void ) xCopyPosition;
+    ( void ) cmock_num_calls;
+
+    if( xSendResult == pdPASS )
+    {
+        TEST_ASSERT_LESS_THAN( MAX_EVENTS, uxEventCount );
+        memcpy( &( xEvents[ uxEventCount ] ), pvItemToQueue, sizeof( xEvents[ 0 ] ) );
+        uxEventCount++;
+    }
+
+    return xSendResult;
+}
+
+NetworkBufferDescriptor_t * pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes,
+                                                              TickType_t xBlockTimeTicks )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    ( void ) xBlockTimeTicks;
+
+    pxBuffer = calloc( 1, sizeof( *pxBuffer ) );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    pxBuffer->pucEthernetBuffer = calloc( 1, xRequestedSizeBytes );
+    TEST_ASSERT_NOT_NULL( pxBuffer->pucEthernetBuffer );
+    pxBuffer->xDataLength = xRequestedSizeBytes;
+    vListInitialiseItem( &( pxBuffer->xBufferListItem ) );
+    listSET_LIST_ITEM_OWNER( &( pxBuffer->xBufferListItem ), ( void * ) pxBuffer );
+    xBuffersInUse++;
+
+    return pxBuffer;
+}
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+    free( pxNetworkBuffer->pucEthernetBuffer );
+    free( pxNetworkBuffer );
+    xBuffersInUse--;
+}
+
+BaseType_t xProcessReceivedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                      uint16_t usPort )
+{
+    ( void ) pxNetworkBuffer;
+    ( void ) usPort;
+
+    uxUDPPackets++;
+
+    return pdFAIL;
+}
+
+/* The other functions of the stack that are called by FreeRTOS_IP.c.  They
+ * are not used while fragments are reassembled. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+BaseType_t xNetworkBuffersInitialise( void )
+{
+    return pdPASS;
+}
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+    return pdPASS;
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return pdPASS;
+}
+
+void FreeRTOS_ClearARP( void )
+{
+}
+
+eFrameProcessingResult_t eARPProcessPacket( ARPPacket_t * const pxARPFrame )
+{
+    ( void ) pxARPFrame;
+
+    return eReleaseBuffer;
+}
+
+void vARPAgeCache( void )
+{
+}
+
+void vARPRefreshCacheEntry( const MACAddress_t * pxMACAddress,
+                            const uint32_t ulIPAddress )
+{
+    ( void ) pxMACAddress;
+    ( void ) ulIPAddress;
+}
+
+void vDHCPProcess( BaseType_t xReset )
+{
+    ( void ) xReset;
+}
+
+BaseType_t vNetworkSocketsInit( void )
+{
+    return pdPASS;
+}
+
+void vProcessGeneratedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+    vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+}
+
+BaseType_t vSocketBind( FreeRTOS_Socket_t * pxSocket,
+                        struct freertos_sockaddr * pxAddress,
+                        size_t uxAddressLength,
+                        BaseType_t xInternal )
+{
+    ( void ) pxSocket;
+    ( void ) pxAddress;
+    ( void ) uxAddressLength;
+    ( void ) xInternal;
+
+    return 0;
+}
+
+void * vSocketClose( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+
+    return NULL;
+}
+
+void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+}
+
+void vTCPSetNextReceivedBuffer( const NetworkBufferDescriptor_t * pxNextBuffer )
+{
+    ( void ) pxNextBuffer;
+}
+
+BaseType_t xProcessReceivedTCPPacket( NetworkBufferDescriptor_t * pxNetworkBuffer )
+{
+    ( void ) pxNetworkBuffer;
+
+    return pdFAIL;
+}
+
+BaseType_t xTCPCheckNewClient( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+
+    return pdFALSE;
+}
+
+TickType_t xTCPTimerCheck( BaseType_t xWillSleep )
+{
+    ( void ) xWillSleep;
+
+    return ( TickType_t ) 1000u;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    xTaskGetTickCount_Stub( prvGetTickCount );
+    xTaskGetCurrentTaskHandle_IgnoreAndReturn( NULL );
+    vTaskSetTimeOutState_Ignore();
+    xQueueGenericSend_Stub( prvQueueGenericSend );
+
+    TEST_FreeRTOS_TCP_vSetIPTaskInitialised( pdTRUE );
+    TEST_FreeRTOS_TCP_vIPReassemblyInit();
+
+    xBuffersInUse = 0;
+    xTickCount = 0u;
+    uxEventCount = 0u;
+    xSendResult = pdPASS;
+    uxUDPPackets = 0u;
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    UBaseType_t uxIndex;
+
+    for( uxIndex = 0u; uxIndex < uxEventCount; uxIndex++ )
+    {
+        vReleaseNetworkBufferAndDescriptor( ( NetworkBufferDescriptor_t * ) xEvents[ uxIndex ].pvData );
+    }
+
+    /* Drop the fragments that are still stored. */
+    xTickCount += pdMS_TO_TICKS( ipconfigIP_REASSEMBLY_TIMEOUT_MS );
+    TEST_FreeRTOS_TCP_prvIPReassemblyCheck();
+
+    /* Every test returns all network buffers. */
+    TEST_ASSERT_EQUAL( 0, xBuffersInUse );
+    TEST_ASSERT_EQUAL( 0, TEST_FreeRTOS_TCP_uxIPReassemblyBuffers() );
+
+    /* A datagram must never be processed before its event is handled. */
+    TEST_ASSERT_EQUAL( 0, uxUDPPackets );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* The value of the payload byte at uxOffset of datagram usIdentification. */
+static uint8_t prvPayloadByte( uint16_t usIdentification,
+                               size_t uxOffset )
+{
+    return ( uint8_t ) ( uxOffset * 7u + usIdentification );
+}
+
+/* A network buffer with uxLength bytes at uxOffset of the datagram with
+ * identification usIdentification. */
+static NetworkBufferDescriptor_t * prvFragment( uint16_t usIdentification,
+                                                size_t uxOffset,
+                                                size_t uxLength,
+                                                BaseType_t xMoreFragments )
+{
+    const size_t uxHeaderLength = ipSIZE_OF_ETH_HEADER + IP_HEADER_LENGTH;
+    NetworkBufferDescriptor_t * pxBuffer;
+    IPPacket_t * pxPacket;
+    uint16_t usFragmentOffset = ( uint16_t ) ( uxOffset >> 3 );
+    size_t x;
+
+    if( xMoreFragments != pdFALSE )
+    {
+        usFragmentOffset |= ipFRAGMENT_FLAGS_MORE_FRAGMENTS;
+    }
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( uxHeaderLength + uxLength, 0 );
+
+    pxPacket = ( IPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_UDP;
+    pxPacket->xIPHeader.usLength = FreeRTOS_htons( IP_HEADER_LENGTH + uxLength );
+    pxPacket->xIPHeader.usIdentification = FreeRTOS_htons( usIdentification );
+    pxPacket->xIPHeader.usFragmentOffset = FreeRTOS_htons( usFragmentOffset );
+    pxPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( REMOTE_IP );
+    pxPacket->xIPHeader.ulDestinationIPAddress = FreeRTOS_htonl( LOCAL_IP );
+
+    for( x = 0; x < uxLength; x++ )
+    {
+        pxBuffer->pucEthernetBuffer[ uxHeaderLength + x ] = prvPayloadByte( usIdentification, uxOffset + x );
+    }
+
+    return pxBuffer;
+}
+
+/* Pass a fragment to the reassembly the way prvProcessEthernetPacket()
+ * does, and return the result. */
+static eFrameProcessingResult_t prvReceiveFragment( uint16_t usIdentification,
+                                                    size_t uxIndex,
+                                                    size_t uxLength,
+                                                    BaseType_t xMoreFragments )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+    eFrameProcessingResult_t eResult;
+
+    pxBuffer = prvFragment( usIdentification, uxIndex * FRAGMENT_LENGTH, uxLength, xMoreFragments );
+    eResult = TEST_FreeRTOS_TCP_prvIPReassemble( pxBuffer, IP_HEADER_LENGTH );
+
+    if( eResult != eFrameConsumed )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    }
+
+    return eResult;
+}
+
+/* Receive fragment uxIndex of a datagram of FRAGMENT_COUNT fragments. */
+static eFrameProcessingResult_t prvReceiveDatagramPart( uint16_t usIdentification,
+                                                        size_t uxIndex )
+{
+    BaseType_t xMoreFragments = ( uxIndex + 1u < FRAGMENT_COUNT ) ? pdTRUE : pdFALSE;
+
+    return prvReceiveFragment( usIdentification, uxIndex, FRAGMENT_LENGTH, xMoreFragments );
+}
+
+/* Check that event uxIndex carries the complete datagram usIdentification. */
+static void prvCheckDatagram( UBaseType_t uxIndex,
+                              uint16_t usIdentification )
+{
+    const size_t uxHeaderLength = ipSIZE_OF_ETH_HEADER + IP_HEADER_LENGTH;
+    const size_t uxTotalLength = FRAGMENT_COUNT * FRAGMENT_LENGTH;
+    const NetworkBufferDescriptor_t * pxBuffer;
+    const IPPacket_t * pxPacket;
+    size_t x;
+
+    TEST_ASSERT_LESS_THAN( uxEventCount, uxIndex );
+    TEST_ASSERT_EQUAL( eNetworkRxEvent, xEvents[ uxIndex ].eEventType );
+
+    pxBuffer = ( const NetworkBufferDescriptor_t * ) xEvents[ uxIndex ].pvData;
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    TEST_ASSERT_EQUAL( uxHeaderLength + uxTotalLength, pxBuffer->xDataLength );
+
+    pxPacket = ( const IPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    TEST_ASSERT_EQUAL( FreeRTOS_htons( usIdentification ), pxPacket->xIPHeader.usIdentification );
+    TEST_ASSERT_EQUAL( 0u, pxPacket->xIPHeader.usFragmentOffset );
+    TEST_ASSERT_EQUAL( FreeRTOS_htons( IP_HEADER_LENGTH + uxTotalLength ), pxPacket->xIPHeader.usLength );
+
+    for( x = 0; x < uxTotalLength; x++ )
+    {
+        TEST_ASSERT_EQUAL( prvPayloadByte( usIdentification, x ), pxBuffer->pucEthernetBuffer[ uxHeaderLength + x ] );
+    }
+}
+
+/* The number of datagrams that were dropped before they were complete. */
+static uint32_t prvReassemblyFailures( void )
+{
+    IPCounters_t xCounters;
+
+    FreeRTOS_GetIPCounters( &xCounters );
+
+    return xCounters.ulRxReassemblyFailed;
+}
+
+/* The number of events that could not be sent to the IP-task. */
+static uint32_t prvEventsLost( void )
+{
+    IPCounters_t xCounters;
+
+    FreeRTOS_GetIPCounters( &xCounters );
+
+    return xCounters.ulEventsLost;
+}
+
+/* ======================== Test functions ================================= */
+
+/* A datagram whose fragments arrive out of order is passed to the IP-task
+ * as a new packet, instead of being processed while the last fragment is
+ * still being handled. */
+void test_out_of_order_fragments_queued( void )
+{
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 1u, 2u ) );
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 1u, 0u ) );
+    TEST_ASSERT_EQUAL( 0u, uxEventCount );
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 1u, 1u ) );
+
+    TEST_ASSERT_EQUAL( 1u, uxEventCount );
+    prvCheckDatagram( 0u, 1u );
+
+    /* Only the new buffer is left, the fragments have been released. */
+    TEST_ASSERT_EQUAL( 1, xBuffersInUse );
+    TEST_ASSERT_EQUAL( 0, TEST_FreeRTOS_TCP_uxIPReassemblyBuffers() );
+}
+
+/* When the event queue is full, the datagram is dropped. */
+void test_queue_full_drops_datagram( void )
+{
+    uint32_t ulEventsLost = prvEventsLost();
+    size_t x;
+
+    xSendResult = pdFAIL;
+
+    for( x = 0; x < FRAGMENT_COUNT; x++ )
+    {
+        TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 2u, x ) );
+    }
+
+    TEST_ASSERT_EQUAL( 0u, uxEventCount );
+    TEST_ASSERT_EQUAL( 0, xBuffersInUse );
+    TEST_ASSERT_EQUAL( ulEventsLost + 1u, prvEventsLost() );
+}
+
+/* An exact copy of a stored fragment is released, and the datagram can
+ * still be completed. */
+void test_duplicate_fragment_ignored( void )
+{
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 3u, 0u ) );
+    TEST_ASSERT_EQUAL( eReleaseBuffer, prvReceiveDatagramPart( 3u, 0u ) );
+    TEST_ASSERT_EQUAL( 1, TEST_FreeRTOS_TCP_uxIPReassemblyBuffers() );
+
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 3u, 1u ) );
+    TEST_ASSERT_EQUAL( eReleaseBuffer, prvReceiveDatagramPart( 3u, 1u ) );
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 3u, 2u ) );
+
+    TEST_ASSERT_EQUAL( 1u, uxEventCount );
+    prvCheckDatagram( 0u, 3u );
+}
+
+/* A fragment that overlaps a stored one drops the whole datagram. */
+void test_overlapping_fragment_drops_datagram( void )
+{
+    uint32_t ulFailures = prvReassemblyFailures();
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 4u, 0u ) );
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 4u, 2u ) );
+
+    /* Starts within fragment 0 and ends within fragment 1. */
+    pxBuffer = prvFragment( 4u, FRAGMENT_LENGTH / 2u, FRAGMENT_LENGTH, pdTRUE );
+    TEST_ASSERT_EQUAL( eReleaseBuffer, TEST_FreeRTOS_TCP_prvIPReassemble( pxBuffer, IP_HEADER_LENGTH ) );
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+
+    TEST_ASSERT_EQUAL( 0, TEST_FreeRTOS_TCP_uxIPReassemblyBuffers() );
+    TEST_ASSERT_EQUAL( ulFailures + 1u, prvReassemblyFailures() );
+
+    /* The missing fragment does not complete the datagram any more. */
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 4u, 1u ) );
+    TEST_ASSERT_EQUAL( 0u, uxEventCount );
+}
+
+/* A datagram that is not complete within ipconfigIP_REASSEMBLY_TIMEOUT_MS
+ * is dropped, after which the timer stops. */
+void test_timeout_drops_datagram( void )
+{
+    uint32_t ulFailures = prvReassemblyFailures();
+
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 5u, 0u ) );
+    TEST_ASSERT_EQUAL( pdTRUE, TEST_FreeRTOS_TCP_xIPReassemblyTimerActive() );
+
+    xTickCount = pdMS_TO_TICKS( ipconfigIP_REASSEMBLY_TIMEOUT_MS ) - 1u;
+    TEST_FreeRTOS_TCP_prvIPReassemblyCheck();
+    TEST_ASSERT_EQUAL( 1, TEST_FreeRTOS_TCP_uxIPReassemblyBuffers() );
+    TEST_ASSERT_EQUAL( pdTRUE, TEST_FreeRTOS_TCP_xIPReassemblyTimerActive() );
+
+    xTickCount++;
+    TEST_FreeRTOS_TCP_prvIPReassemblyCheck();
+    TEST_ASSERT_EQUAL( 0, TEST_FreeRTOS_TCP_uxIPReassemblyBuffers() );
+    TEST_ASSERT_EQUAL( 0, xBuffersInUse );
+    TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_xIPReassemblyTimerActive() );
+    TEST_ASSERT_EQUAL( ulFailures + 1u, prvReassemblyFailures() );
+}
+
+/* When all entries are in use, the oldest datagram gives way to a new
+ * one. */
+void test_full_table_evicts_oldest( void )
+{
+    uint16_t usIdentification;
+
+    for( usIdentification = 0u; usIdentification < ipconfigIP_REASSEMBLY_MAX_PACKETS; usIdentification++ )
+    {
+        xTickCount = ( TickType_t ) ( 10u * usIdentification );
+        TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 10u + usIdentification, 0u ) );
+    }
+
+    /* Datagram 10 was started first. */
+    xTickCount += 10u;
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 10u + usIdentification, 0u ) );
+    TEST_ASSERT_EQUAL( ipconfigIP_REASSEMBLY_MAX_PACKETS, TEST_FreeRTOS_TCP_uxIPReassemblyBuffers() );
+
+    /* Datagram 11 is still complete. */
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 11u, 1u ) );
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 11u, 2u ) );
+    TEST_ASSERT_EQUAL( 1u, uxEventCount );
+    prvCheckDatagram( 0u, 11u );
+
+    /* Datagram 10 is not. */
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 10u, 1u ) );
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 10u, 2u ) );
+    TEST_ASSERT_EQUAL( 1u, uxEventCount );
+}
+
+/* When the fragments use all reserved buffers, the oldest other datagram
+ * is dropped to store a new fragment. */
+void test_buffer_budget_evicts_oldest( void )
+{
+    size_t x;
+
+    for( x = 0; x < ipconfigIP_REASSEMBLY_MAX_BUFFERS; x++ )
+    {
+        TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveFragment( 20u, x, FRAGMENT_LENGTH, pdTRUE ) );
+    }
+
+    TEST_ASSERT_EQUAL( ipconfigIP_REASSEMBLY_MAX_BUFFERS, TEST_FreeRTOS_TCP_uxIPReassemblyBuffers() );
+
+    xTickCount += 10u;
+    TEST_ASSERT_EQUAL( eFrameConsumed, prvReceiveDatagramPart( 21u, 0u ) );
+    TEST_ASSERT_EQUAL( 1, TEST_FreeRTOS_TCP_uxIPReassemblyBuffers() );
+    TEST_ASSERT_EQUAL( 1, xBuffersInUse );
+}
@@ -0,0 +1,427 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_DHCP.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The longest chain of packets that a test passes to the IP-task. */
+#define MAX_CHAIN_LENGTH    ( 3u * ipconfigMAX_IP_TASK_BURST )
+
+/* The number of bytes in the test packets. */
+#define PACKET_LENGTH       sizeof( ARPPacket_t )
+
+/* The frame type of a packet that the IP-task does not handle. */
+#define UNKNOWN_FRAME_TYPE    0x86DDu
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Defined in FreeRTOS_UDP_IP.c, which is not part of this test. */
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+
+/* Network buffers of a variable size, allocated with malloc(). */
+const BaseType_t xBufferAllocFixedSize = pdFALSE;
+
+/* The number of network buffers that have not been released. */
+static BaseType_t xBuffersInUse;
+
+/* The packets of the chain, and the order in which the ARP layer saw
+ * them. */
+static NetworkBufferDescriptor_t * pxChain[ MAX_CHAIN_LENGTH ];
+static uint8_t ucHandled[ MAX_CHAIN_LENGTH ];
+static UBaseType_t uxHandledCount;
+
+/* The next buffer that TCP was told about before each packet, and the last
+ * value that it was given. */
+static const NetworkBufferDescriptor_t * pxNextHint[ MAX_CHAIN_LENGTH ];
+static const NetworkBufferDescriptor_t * pxLastHint;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+NetworkBufferDescriptor_t * pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes,
+                                                              TickType_t xBlockTimeTicks )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    ( void ) xBlockTimeTicks;
+
+    pxBuffer = calloc( 1, sizeof( *pxBuffer ) );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    pxBuffer->pucEthernetBuffer = calloc( 1, xRequestedSizeBytes );
+    TEST_ASSERT_NOT_NULL( pxBuffer->pucEthernetBuffer );
+    pxBuffer->xDataLength = xRequestedSizeBytes;
+    vListInitialiseItem( &( pxBuffer->xBufferListItem ) );
+    listSET_LIST_ITEM_OWNER( &( pxBuffer->xBufferListItem ), ( void * ) pxBuffer );
+    xBuffersInUse++;
+
+    return pxBuffer;
+}
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+    free( pxNetworkBuffer->pucEthernetBuffer );
+    free( pxNetworkBuffer );
+    xBuffersInUse--;
+}
+
+/* Records the order of the packets, the first payload byte is the index of
+ * the packet in the chain. */
+eFrameProcessingResult_t eARPProcessPacket( ARPPacket_t * const pxARPFrame )
+{
+    TEST_ASSERT_LESS_THAN( MAX_CHAIN_LENGTH, uxHandledCount );
+    ucHandled[ uxHandledCount ] = ( ( const uint8_t * ) pxARPFrame )[ ipSIZE_OF_ETH_HEADER ];
+    uxHandledCount++;
+
+    return eReleaseBuffer;
+}
+
+void vTCPSetNextReceivedBuffer( const NetworkBufferDescriptor_t * pxNextBuffer )
+{
+    /* Called before the packet is handled, and with NULL after the chain. */
+    if( pxNextBuffer != NULL )
+    {
+        TEST_ASSERT_LESS_THAN( MAX_CHAIN_LENGTH, uxHandledCount );
+        pxNextHint[ uxHandledCount ] = pxNextBuffer;
+    }
+
+    pxLastHint = pxNextBuffer;
+}
+
+/* The other functions of the stack that are called by FreeRTOS_IP.c.  They
+ * are not used while a chain of ARP packets is handled. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+BaseType_t xNetworkBuffersInitialise( void )
+{
+    return pdPASS;
+}
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+    return pdPASS;
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return pdPASS;
+}
+
+void FreeRTOS_ClearARP( void )
+{
+}
+
+void vARPAgeCache( void )
+{
+}
+
+void vARPRefreshCacheEntry( const MACAddress_t * pxMACAddress,
+                            const uint32_t ulIPAddress )
+{
+    ( void ) pxMACAddress;
+    ( void ) ulIPAddress;
+}
+
+void vDHCPProcess( BaseType_t xReset )
+{
+    ( void ) xReset;
+}
+
+BaseType_t vNetworkSocketsInit( void )
+{
+    return pdPASS;
+}
+
+void vProcessGeneratedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+    vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+}
+
+BaseType_t vSocketBind( FreeRTOS_Socket_t * pxSocket,
+                        struct freertos_sockaddr * pxAddress,
+                        size_t uxAddressLength,
+                        BaseType_t xInternal )
+{
+    ( void ) pxSocket;
+    ( void ) pxAddress;
+    ( void ) uxAddressLength;
+    ( void ) xInternal;
+
+    return 0;
+}
+
+void * vSocketClose( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+
+    return NULL;
+}
+
+void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+}
+
+BaseType_t xProcessReceivedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                      uint16_t usPort )
+{
+    ( void ) pxNetworkBuffer;
+    ( void ) usPort;
+
+    return pdFAIL;
+}
+
+BaseType_t xProcessReceivedTCPPacket( NetworkBufferDescriptor_t * pxNetworkBuffer )
+{
+    ( void ) pxNetworkBuffer;
+
+    return pdFAIL;
+}
+
+BaseType_t xTCPCheckNewClient( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+
+    return pdFALSE;
+}
+
+TickType_t xTCPTimerCheck( BaseType_t xWillSleep )
+{
+    ( void ) xWillSleep;
+
+    return ( TickType_t ) 1000u;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    xTaskGetTickCount_IgnoreAndReturn( 0 );
+    TEST_FreeRTOS_TCP_vSetIPTaskInitialised( pdTRUE );
+
+    xBuffersInUse = 0;
+    uxHandledCount = 0u;
+    pxLastHint = NULL;
+    memset( pxChain, 0, sizeof( pxChain ) );
+    memset( ucHandled, 0, sizeof( ucHandled ) );
+    memset( pxNextHint, 0, sizeof( pxNextHint ) );
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    /* Nothing is left for the next round, and TCP doesn't expect another
+     * packet. */
+    TEST_ASSERT_NULL( TEST_FreeRTOS_TCP_pxPendingRxChain() );
+    TEST_ASSERT_NULL( pxLastHint );
+
+    /* Every test returns all network buffers. */
+    TEST_ASSERT_EQUAL( 0, xBuffersInUse );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Create a chain of uxLength broadcast ARP packets, numbered from 0. */
+static NetworkBufferDescriptor_t * prvCreateChain( size_t uxLength )
+{
+    EthernetHeader_t * pxHeader;
+    size_t x;
+
+    TEST_ASSERT_TRUE( uxLength <= MAX_CHAIN_LENGTH );
+
+    for( x = 0; x < uxLength; x++ )
+    {
+        pxChain[ x ] = pxGetNetworkBufferWithDescriptor( PACKET_LENGTH, 0 );
+        pxHeader = ( EthernetHeader_t * ) pxChain[ x ]->pucEthernetBuffer;
+        memset( pxHeader->xDestinationAddress.ucBytes, 0xff, sizeof( pxHeader->xDestinationAddress ) );
+        pxHeader->usFrameType = ipARP_FRAME_TYPE;
+        pxChain[ x ]->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER ] = ( uint8_t ) x;
+
+        if( x > 0u )
+        {
+            pxChain[ x - 1u ]->pxNextBuffer = pxChain[ x ];
+        }
+    }
+
+    return pxChain[ 0 ];
+}
+
+/* Pass a chain to the IP-task as a single event, of which it may handle
+ * uxMaxCount packets. */
+static UBaseType_t prvReceiveChain( NetworkBufferDescriptor_t * pxFirst,
+                                    UBaseType_t uxMaxCount )
+{
+    IPStackEvent_t xEvent;
+
+    xEvent.eEventType = eNetworkRxEvent;
+    xEvent.pvData = ( void * ) pxFirst;
+
+    return TEST_FreeRTOS_TCP_prvHandleIPEvent( &xEvent, uxMaxCount );
+}
+
+/* Check that packets uxFirst up to uxLast were handled, in order. */
+static void prvCheckHandled( size_t uxFirst,
+                             size_t uxLast )
+{
+    size_t x;
+
+    TEST_ASSERT_EQUAL( uxLast - uxFirst, uxHandledCount );
+
+    for( x = uxFirst; x < uxLast; x++ )
+    {
+        TEST_ASSERT_EQUAL( x, ucHandled[ x - uxFirst ] );
+    }
+}
+
+/* ======================== Test functions ================================= */
+
+/* A chain that fits in the burst is handled in order and completely.  TCP
+ * is told about the next packet, except after the last one. */
+void test_short_chain_handled_in_order( void )
+{
+    const size_t uxLength = ipconfigMAX_IP_TASK_BURST - 1u;
+    size_t x;
+
+    TEST_ASSERT_EQUAL( uxLength, prvReceiveChain( prvCreateChain( uxLength ), ipconfigMAX_IP_TASK_BURST ) );
+
+    prvCheckHandled( 0u, uxLength );
+
+    for( x = 0; x + 1u < uxLength; x++ )
+    {
+        TEST_ASSERT_EQUAL_PTR( pxChain[ x + 1u ], pxNextHint[ x ] );
+    }
+
+    TEST_ASSERT_NULL( pxNextHint[ uxLength - 1u ] );
+}
+
+/* A chain exactly as long as the burst leaves nothing for the next round. */
+void test_chain_of_burst_length( void )
+{
+    TEST_ASSERT_EQUAL( ipconfigMAX_IP_TASK_BURST, prvReceiveChain( prvCreateChain( ipconfigMAX_IP_TASK_BURST ), ipconfigMAX_IP_TASK_BURST ) );
+
+    prvCheckHandled( 0u, ipconfigMAX_IP_TASK_BURST );
+    TEST_ASSERT_EQUAL( 0, TEST_FreeRTOS_TCP_prvHandlePendingRxChain() );
+}
+
+/* The rest of a long chain is kept, and handled in order in the next rounds
+ * of the IP-task, a burst at a time. */
+void test_long_chain_continued( void )
+{
+    const size_t uxLength = 2u * ipconfigMAX_IP_TASK_BURST + 1u;
+
+    TEST_ASSERT_EQUAL( ipconfigMAX_IP_TASK_BURST, prvReceiveChain( prvCreateChain( uxLength ), ipconfigMAX_IP_TASK_BURST ) );
+    prvCheckHandled( 0u, ipconfigMAX_IP_TASK_BURST );
+    TEST_ASSERT_EQUAL_PTR( pxChain[ ipconfigMAX_IP_TASK_BURST ], TEST_FreeRTOS_TCP_pxPendingRxChain() );
+    TEST_ASSERT_EQUAL( uxLength - ipconfigMAX_IP_TASK_BURST, xBuffersInUse );
+
+    /* The packet that ends a round is not announced to TCP, it belongs to
+     * the next round. */
+    TEST_ASSERT_NULL( pxNextHint[ ipconfigMAX_IP_TASK_BURST - 1u ] );
+    TEST_ASSERT_NULL( pxLastHint );
+
+    uxHandledCount = 0u;
+    TEST_ASSERT_EQUAL( ipconfigMAX_IP_TASK_BURST, TEST_FreeRTOS_TCP_prvHandlePendingRxChain() );
+    prvCheckHandled( ipconfigMAX_IP_TASK_BURST, 2u * ipconfigMAX_IP_TASK_BURST );
+    TEST_ASSERT_EQUAL_PTR( pxChain[ 2u * ipconfigMAX_IP_TASK_BURST ], TEST_FreeRTOS_TCP_pxPendingRxChain() );
+
+    uxHandledCount = 0u;
+    TEST_ASSERT_EQUAL( 1, TEST_FreeRTOS_TCP_prvHandlePendingRxChain() );
+    prvCheckHandled( 2u * ipconfigMAX_IP_TASK_BURST, uxLength );
+
+    TEST_ASSERT_EQUAL( 0, TEST_FreeRTOS_TCP_prvHandlePendingRxChain() );
+}
+
+/* A chain that arrives late in a burst only gets what is left of it. */
+void test_chain_limited_by_remaining_burst( void )
+{
+    const size_t uxLength = 3u;
+
+    TEST_ASSERT_EQUAL( 1, prvReceiveChain( prvCreateChain( uxLength ), 1u ) );
+    prvCheckHandled( 0u, 1u );
+    TEST_ASSERT_EQUAL_PTR( pxChain[ 1 ], TEST_FreeRTOS_TCP_pxPendingRxChain() );
+
+    uxHandledCount = 0u;
+    TEST_ASSERT_EQUAL( uxLength - 1u, TEST_FreeRTOS_TCP_prvHandlePendingRxChain() );
+    prvCheckHandled( 1u, uxLength );
+}
+
+/* Packets that are dropped, because they are too short or of an unknown
+ * type, are released without breaking the chain. */
+void test_dropped_packets_released( void )
+{
+    const size_t uxLength = 4u;
+    EthernetHeader_t * pxHeader;
+
+    ( void ) prvCreateChain( uxLength );
+
+    pxHeader = ( EthernetHeader_t * ) pxChain[ 1 ]->pucEthernetBuffer;
+    pxHeader->usFrameType = UNKNOWN_FRAME_TYPE;
+    pxChain[ 2 ]->xDataLength = sizeof( EthernetHeader_t ) - 1u;
+
+    TEST_ASSERT_EQUAL( uxLength, prvReceiveChain( pxChain[ 0 ], ipconfigMAX_IP_TASK_BURST ) );
+
+    TEST_ASSERT_EQUAL( 2, uxHandledCount );
+    TEST_ASSERT_EQUAL( 0, ucHandled[ 0 ] );
+    TEST_ASSERT_EQUAL( 3, ucHandled[ 1 ] );
+}
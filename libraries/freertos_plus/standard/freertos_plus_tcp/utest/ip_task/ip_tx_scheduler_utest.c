@@ -0,0 +1,618 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_DHCP.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The size of the packets in the fairness test: two of them fit in the
+ * quantum of the bulk band. */
+#define HALF_QUANTUM            ( ipconfigTX_SCHEDULER_QUANTUM / 2u )
+
+/* The size of the other test packets. */
+#define PACKET_LENGTH           ( sizeof( UDPPacket_t ) + 1u )
+
+/* The offset of the byte that numbers a test packet. */
+#define TAG_OFFSET              sizeof( UDPPacket_t )
+
+/* The most packets that a test sends. */
+#define MAX_OUTPUT              64u
+
+/* DSCP class selectors, the band is chosen by the 3 most significant bits. */
+#define DSCP_BEST_EFFORT        0x00u
+#define DSCP_BULK               0x20u    /* CS1 */
+#define DSCP_INTERACTIVE        0xB8u    /* EF */
+#define DSCP_NETWORK_CONTROL    0xC0u    /* CS6 */
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Defined in FreeRTOS_UDP_IP.c, which is not part of this test. */
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+
+/* Network buffers of a variable size, allocated with malloc(). */
+const BaseType_t xBufferAllocFixedSize = pdFALSE;
+
+/* The number of network buffers that have not been released. */
+static BaseType_t xBuffersInUse;
+
+/* The value returned by xNetworkInterfaceOutput(). */
+static BaseType_t xOutputResult;
+
+/* The packets that the driver accepted, in order: their tag and their DSCP
+ * field. */
+static uint8_t ucSentTag[ MAX_OUTPUT ];
+static uint8_t ucSentDSCP[ MAX_OUTPUT ];
+static UBaseType_t uxSentCount;
+
+/* The number of times that the driver was called. */
+static UBaseType_t uxOutputCalls;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+NetworkBufferDescriptor_t * pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes,
+                                                              TickType_t xBlockTimeTicks )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    ( void ) xBlockTimeTicks;
+
+    pxBuffer = calloc( 1, sizeof( *pxBuffer ) );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    pxBuffer->pucEthernetBuffer = calloc( 1, xRequestedSizeBytes );
+    TEST_ASSERT_NOT_NULL( pxBuffer->pucEthernetBuffer );
+    pxBuffer->xDataLength = xRequestedSizeBytes;
+    vListInitialiseItem( &( pxBuffer->xBufferListItem ) );
+    listSET_LIST_ITEM_OWNER( &( pxBuffer->xBufferListItem ), ( void * ) pxBuffer );
+    xBuffersInUse++;
+
+    return pxBuffer;
+}
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+    free( pxNetworkBuffer->pucEthernetBuffer );
+    free( pxNetworkBuffer );
+    xBuffersInUse--;
+}
+
+/* The driver records the packets that it accepts.  Like the real drivers, it
+ * takes ownership of the buffer when xReleaseAfterSend is true, even when it
+ * refuses the packet. */
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    const UDPPacket_t * pxPacket = ( const UDPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+
+    uxOutputCalls++;
+
+    if( xOutputResult != pdFAIL )
+    {
+        TEST_ASSERT_LESS_THAN( MAX_OUTPUT, uxSentCount );
+        ucSentTag[ uxSentCount ] = pxNetworkBuffer->pucEthernetBuffer[ TAG_OFFSET ];
+        ucSentDSCP[ uxSentCount ] = pxPacket->xIPHeader.ucDifferentiatedServicesCode;
+        uxSentCount++;
+    }
+
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return xOutputResult;
+}
+
+/* The other functions of the stack that are called by FreeRTOS_IP.c.  They
+ * are not used by the transmit scheduler. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+BaseType_t xNetworkBuffersInitialise( void )
+{
+    return pdPASS;
+}
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+    return pdPASS;
+}
+
+eFrameProcessingResult_t eARPProcessPacket( ARPPacket_t * const pxARPFrame )
+{
+    ( void ) pxARPFrame;
+
+    return eReleaseBuffer;
+}
+
+void vTCPSetNextReceivedBuffer( const NetworkBufferDescriptor_t * pxNextBuffer )
+{
+    ( void ) pxNextBuffer;
+}
+
+void FreeRTOS_ClearARP( void )
+{
+}
+
+void vARPAgeCache( void )
+{
+}
+
+void vARPRefreshCacheEntry( const MACAddress_t * pxMACAddress,
+                            const uint32_t ulIPAddress )
+{
+    ( void ) pxMACAddress;
+    ( void ) ulIPAddress;
+}
+
+void vDHCPProcess( BaseType_t xReset )
+{
+    ( void ) xReset;
+}
+
+BaseType_t vNetworkSocketsInit( void )
+{
+    return pdPASS;
+}
+
+void vProcessGeneratedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+    vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+}
+
+BaseType_t vSocketBind( FreeRTOS_Socket_t * pxSocket,
+                        struct freertos_sockaddr * pxAddress,
+                        size_t uxAddressLength,
+                        BaseType_t xInternal )
+{
+    ( void ) pxSocket;
+    ( void ) pxAddress;
+    ( void ) uxAddressLength;
+    ( void ) xInternal;
+
+    return 0;
+}
+
+void * vSocketClose( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+
+    return NULL;
+}
+
+void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+}
+
+BaseType_t xProcessReceivedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                      uint16_t usPort )
+{
+    ( void ) pxNetworkBuffer;
+    ( void ) usPort;
+
+    return pdFAIL;
+}
+
+BaseType_t xProcessReceivedTCPPacket( NetworkBufferDescriptor_t * pxNetworkBuffer )
+{
+    ( void ) pxNetworkBuffer;
+
+    return pdFAIL;
+}
+
+BaseType_t xTCPCheckNewClient( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+
+    return pdFALSE;
+}
+
+TickType_t xTCPTimerCheck( BaseType_t xWillSleep )
+{
+    ( void ) xWillSleep;
+
+    return ( TickType_t ) 1000u;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    xTaskGetTickCount_IgnoreAndReturn( 0 );
+
+    /* The IP-task handle is NULL in this test, the calls are made from the
+     * IP-task. */
+    xTaskGetCurrentTaskHandle_IgnoreAndReturn( NULL );
+
+    TEST_FreeRTOS_TCP_vTxSchedulerInit();
+
+    xBuffersInUse = 0;
+    xOutputResult = pdPASS;
+    uxSentCount = 0u;
+    uxOutputCalls = 0u;
+    memset( ucSentTag, 0, sizeof( ucSentTag ) );
+    memset( ucSentDSCP, 0, sizeof( ucSentDSCP ) );
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    /* Send what is left, so that every test returns all network buffers. */
+    xOutputResult = pdPASS;
+
+    while( TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() != 0u )
+    {
+        uxSentCount = 0u;
+        TEST_FreeRTOS_TCP_prvTxSchedulerRun();
+    }
+
+    TEST_ASSERT_EQUAL( 0, xBuffersInUse );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Create a UDP packet of 'uxLength' bytes with the DSCP field 'ucDSCP', and
+ * number it with 'ucTag'. */
+static NetworkBufferDescriptor_t * prvCreatePacket( size_t uxLength,
+                                                    uint8_t ucDSCP,
+                                                    uint8_t ucTag )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+    UDPPacket_t * pxPacket;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( uxLength, 0 );
+    pxPacket = ( UDPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_UDP;
+    pxPacket->xIPHeader.ucDifferentiatedServicesCode = ucDSCP;
+    pxPacket->xUDPHeader.usSourcePort = FreeRTOS_htons( 5000u );
+    pxBuffer->pucEthernetBuffer[ TAG_OFFSET ] = ucTag;
+
+    return pxBuffer;
+}
+
+/* Pass a packet to the scheduler, which will release it. */
+static BaseType_t prvOutput( size_t uxLength,
+                             uint8_t ucDSCP,
+                             uint8_t ucTag )
+{
+    return xTxSchedulerOutput( prvCreatePacket( uxLength, ucDSCP, ucTag ), pdTRUE );
+}
+
+/* Use the budget of the current event, so that the next packets have to
+ * wait in the scheduler. */
+static void prvUseBudget( void )
+{
+    UBaseType_t uxIndex;
+
+    for( uxIndex = 0u; uxIndex < ( UBaseType_t ) ipconfigTX_SCHEDULER_BURST; uxIndex++ )
+    {
+        TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_BEST_EFFORT, 0xFFu ) );
+    }
+
+    TEST_ASSERT_EQUAL( 0u, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+    uxSentCount = 0u;
+    uxOutputCalls = 0u;
+}
+
+/* The IP-task has handled the event that used the budget: what is left of
+ * the budget, nothing, is used and the next event gets a new budget. */
+static void prvEndEvent( void )
+{
+    TEST_FreeRTOS_TCP_prvTxSchedulerRun();
+    TEST_ASSERT_EQUAL( 0u, uxOutputCalls );
+}
+
+/* Run the scheduler for new events until all packets have been sent. */
+static void prvRunUntilEmpty( void )
+{
+    while( TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() != 0u )
+    {
+        TEST_FreeRTOS_TCP_prvTxSchedulerRun();
+    }
+}
+
+/* Count the packets with DSCP field 'ucDSCP' among the first 'uxCount'
+ * packets sent. */
+static UBaseType_t prvCountSent( uint8_t ucDSCP,
+                                 UBaseType_t uxCount )
+{
+    UBaseType_t uxIndex;
+    UBaseType_t uxFound = 0u;
+
+    for( uxIndex = 0u; uxIndex < uxCount; uxIndex++ )
+    {
+        if( ucSentDSCP[ uxIndex ] == ucDSCP )
+        {
+            uxFound++;
+        }
+    }
+
+    return uxFound;
+}
+
+/* ======================== Test functions ================================= */
+
+/* With nothing waiting, a packet is sent right away. */
+void test_sent_when_idle( void )
+{
+    TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_BULK, 1u ) );
+
+    TEST_ASSERT_EQUAL( 1u, uxSentCount );
+    TEST_ASSERT_EQUAL( 1u, ucSentTag[ 0 ] );
+    TEST_ASSERT_EQUAL( 0u, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+}
+
+/* An event may send ipconfigTX_SCHEDULER_BURST packets, the others wait for
+ * the next round of the IP-task. */
+void test_burst_budget( void )
+{
+    prvUseBudget();
+
+    TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_BEST_EFFORT, 1u ) );
+    TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_BEST_EFFORT, 2u ) );
+    TEST_ASSERT_EQUAL( 0u, uxSentCount );
+    TEST_ASSERT_EQUAL( 2u, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+
+    prvEndEvent();
+    TEST_ASSERT_EQUAL( 2u, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+
+    TEST_FreeRTOS_TCP_prvTxSchedulerRun();
+    TEST_ASSERT_EQUAL( 2u, uxSentCount );
+    TEST_ASSERT_EQUAL( 1u, ucSentTag[ 0 ] );
+    TEST_ASSERT_EQUAL( 2u, ucSentTag[ 1 ] );
+    TEST_ASSERT_EQUAL( 0u, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+}
+
+/* ARP, DHCP and network control packets overtake the waiting packets, even
+ * when the budget has been used. */
+void test_control_band_priority( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+    UDPPacket_t * pxPacket;
+
+    prvUseBudget();
+
+    TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_INTERACTIVE, 1u ) );
+    TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_BULK, 2u ) );
+    TEST_ASSERT_EQUAL( 0u, uxSentCount );
+
+    /* Network control. */
+    TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_NETWORK_CONTROL, 3u ) );
+
+    /* The DHCP client, whatever its DSCP field. */
+    pxBuffer = prvCreatePacket( PACKET_LENGTH, DSCP_BULK, 4u );
+    pxPacket = ( UDPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    pxPacket->xUDPHeader.usSourcePort = FreeRTOS_htons( 68u );
+    TEST_ASSERT_EQUAL( pdPASS, xTxSchedulerOutput( pxBuffer, pdTRUE ) );
+
+    /* ARP. */
+    pxBuffer = prvCreatePacket( PACKET_LENGTH, DSCP_BULK, 5u );
+    pxPacket = ( UDPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    pxPacket->xEthernetHeader.usFrameType = ipARP_FRAME_TYPE;
+    TEST_ASSERT_EQUAL( pdPASS, xTxSchedulerOutput( pxBuffer, pdTRUE ) );
+
+    TEST_ASSERT_EQUAL( 3u, uxSentCount );
+    TEST_ASSERT_EQUAL( 3u, ucSentTag[ 0 ] );
+    TEST_ASSERT_EQUAL( 4u, ucSentTag[ 1 ] );
+    TEST_ASSERT_EQUAL( 5u, ucSentTag[ 2 ] );
+    TEST_ASSERT_EQUAL( 2u, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+
+    /* The others follow in the next event. */
+    uxOutputCalls = 0u;
+    prvEndEvent();
+    TEST_FreeRTOS_TCP_prvTxSchedulerRun();
+    TEST_ASSERT_EQUAL( 5u, uxSentCount );
+    TEST_ASSERT_TRUE( ( ( ucSentTag[ 3 ] == 1u ) && ( ucSentTag[ 4 ] == 2u ) ) ||
+                      ( ( ucSentTag[ 3 ] == 2u ) && ( ucSentTag[ 4 ] == 1u ) ) );
+    TEST_ASSERT_EQUAL( 0u, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+}
+
+/* The interactive, best-effort and bulk bands share the link in a ratio of
+ * 4:2:1 of their quantum, and the packets of a band keep their order. */
+void test_drr_quantum_fairness( void )
+{
+    /* Two rounds of deficit round robin: per round the interactive band may
+     * send 4 quanta, the best-effort band 2 and the bulk band 1. */
+    const UBaseType_t uxInteractive = 16u, uxBestEffort = 8u, uxBulk = 4u;
+    const UBaseType_t uxRound = ( uxInteractive + uxBestEffort + uxBulk ) / 2u;
+    UBaseType_t uxIndex;
+    uint8_t ucNextTag[ 3 ] = { 0u, 0u, 0u };
+
+    prvUseBudget();
+
+    /* The bulk band is filled first, it gets its share nevertheless. */
+    for( uxIndex = 0u; uxIndex < uxBulk; uxIndex++ )
+    {
+        TEST_ASSERT_EQUAL( pdPASS, prvOutput( HALF_QUANTUM, DSCP_BULK, ( uint8_t ) uxIndex ) );
+    }
+
+    for( uxIndex = 0u; uxIndex < uxBestEffort; uxIndex++ )
+    {
+        TEST_ASSERT_EQUAL( pdPASS, prvOutput( HALF_QUANTUM, DSCP_BEST_EFFORT, ( uint8_t ) uxIndex ) );
+    }
+
+    for( uxIndex = 0u; uxIndex < uxInteractive; uxIndex++ )
+    {
+        TEST_ASSERT_EQUAL( pdPASS, prvOutput( HALF_QUANTUM, DSCP_INTERACTIVE, ( uint8_t ) uxIndex ) );
+    }
+
+    TEST_ASSERT_EQUAL( uxInteractive + uxBestEffort + uxBulk, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+
+    prvRunUntilEmpty();
+    TEST_ASSERT_EQUAL( 2u * uxRound, uxSentCount );
+
+    /* Every round, and so every half of the packets, has the same mix. */
+    TEST_ASSERT_EQUAL( uxInteractive / 2u, prvCountSent( DSCP_INTERACTIVE, uxRound ) );
+    TEST_ASSERT_EQUAL( uxBestEffort / 2u, prvCountSent( DSCP_BEST_EFFORT, uxRound ) );
+    TEST_ASSERT_EQUAL( uxBulk / 2u, prvCountSent( DSCP_BULK, uxRound ) );
+
+    for( uxIndex = 0u; uxIndex < uxSentCount; uxIndex++ )
+    {
+        switch( ucSentDSCP[ uxIndex ] )
+        {
+            case DSCP_INTERACTIVE:
+                TEST_ASSERT_EQUAL( ucNextTag[ 0 ], ucSentTag[ uxIndex ] );
+                ucNextTag[ 0 ]++;
+                break;
+
+            case DSCP_BEST_EFFORT:
+                TEST_ASSERT_EQUAL( ucNextTag[ 1 ], ucSentTag[ uxIndex ] );
+                ucNextTag[ 1 ]++;
+                break;
+
+            default:
+                TEST_ASSERT_EQUAL( DSCP_BULK, ucSentDSCP[ uxIndex ] );
+                TEST_ASSERT_EQUAL( ucNextTag[ 2 ], ucSentTag[ uxIndex ] );
+                ucNextTag[ 2 ]++;
+                break;
+        }
+    }
+}
+
+/* A packet that the driver refuses stays at the head of its band, and is
+ * the first one sent when the driver accepts packets again. */
+void test_refused_packet_kept( void )
+{
+    prvUseBudget();
+
+    TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_BEST_EFFORT, 1u ) );
+    TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_BEST_EFFORT, 2u ) );
+    prvEndEvent();
+
+    xOutputResult = pdFAIL;
+    TEST_FreeRTOS_TCP_prvTxSchedulerRun();
+
+    /* The driver was tried once, nothing was lost. */
+    TEST_ASSERT_EQUAL( 1u, uxOutputCalls );
+    TEST_ASSERT_EQUAL( 2u, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+    TEST_ASSERT_EQUAL( 2, xBuffersInUse );
+    TEST_ASSERT_EQUAL( pdTRUE, TEST_FreeRTOS_TCP_xTxDriverBusy() );
+
+    xOutputResult = pdPASS;
+    TEST_FreeRTOS_TCP_prvTxSchedulerRun();
+
+    TEST_ASSERT_EQUAL( 2u, uxSentCount );
+    TEST_ASSERT_EQUAL( 1u, ucSentTag[ 0 ] );
+    TEST_ASSERT_EQUAL( 2u, ucSentTag[ 1 ] );
+    TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_xTxDriverBusy() );
+    TEST_ASSERT_EQUAL( 0, xBuffersInUse );
+}
+
+/* When the scheduler is full, the most urgent packet is sent to make space
+ * for a new one. */
+void test_full_scheduler_makes_space( void )
+{
+    UBaseType_t uxIndex;
+
+    prvUseBudget();
+
+    for( uxIndex = 0u; uxIndex < ( UBaseType_t ) ipconfigTX_SCHEDULER_MAX_PACKETS; uxIndex++ )
+    {
+        TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_BEST_EFFORT, ( uint8_t ) uxIndex ) );
+    }
+
+    TEST_ASSERT_EQUAL( 0u, uxSentCount );
+
+    TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_BEST_EFFORT, 0xEEu ) );
+    TEST_ASSERT_EQUAL( 1u, uxSentCount );
+    TEST_ASSERT_EQUAL( 0u, ucSentTag[ 0 ] );
+    TEST_ASSERT_EQUAL( ipconfigTX_SCHEDULER_MAX_PACKETS, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+}
+
+/* When the scheduler is full and the driver refuses packets, the new packet
+ * is dropped and the caller is told so. */
+void test_full_scheduler_driver_refuses( void )
+{
+    UBaseType_t uxIndex;
+
+    prvUseBudget();
+
+    for( uxIndex = 0u; uxIndex < ( UBaseType_t ) ipconfigTX_SCHEDULER_MAX_PACKETS; uxIndex++ )
+    {
+        TEST_ASSERT_EQUAL( pdPASS, prvOutput( PACKET_LENGTH, DSCP_BEST_EFFORT, ( uint8_t ) uxIndex ) );
+    }
+
+    xOutputResult = pdFAIL;
+    TEST_ASSERT_EQUAL( pdFAIL, prvOutput( PACKET_LENGTH, DSCP_BEST_EFFORT, 0xEEu ) );
+
+    TEST_ASSERT_EQUAL( ipconfigTX_SCHEDULER_MAX_PACKETS, TEST_FreeRTOS_TCP_uxTxSchedulerWaiting() );
+    TEST_ASSERT_EQUAL( ipconfigTX_SCHEDULER_MAX_PACKETS, xBuffersInUse );
+    TEST_ASSERT_EQUAL( pdTRUE, TEST_FreeRTOS_TCP_xTxDriverBusy() );
+}
+
+/* A caller that keeps its buffer gets it back at once, the scheduler sends a
+ * copy later. */
+void test_caller_keeps_buffer( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    prvUseBudget();
+
+    pxBuffer = prvCreatePacket( PACKET_LENGTH, DSCP_BEST_EFFORT, 1u );
+    TEST_ASSERT_EQUAL( pdPASS, xTxSchedulerOutput( pxBuffer, pdFALSE ) );
+    TEST_ASSERT_EQUAL( 2, xBuffersInUse );
+
+    /* The caller may use its buffer again. */
+    pxBuffer->pucEthernetBuffer[ TAG_OFFSET ] = 2u;
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+
+    prvEndEvent();
+    TEST_FreeRTOS_TCP_prvTxSchedulerRun();
+    TEST_ASSERT_EQUAL( 1u, uxSentCount );
+    TEST_ASSERT_EQUAL( 1u, ucSentTag[ 0 ] );
+}
@@ -0,0 +1,401 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+#include "mock_event_groups.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_TCP_WIN.h"
+#include "NetworkBufferManagement.h"
+
+/* The MSS used by the connection. */
+#define TEST_MSS                 1460u
+
+/* The RX and TX window lengths. */
+#define WINDOW_LENGTH            ( 8u * TEST_MSS )
+
+/* The sequence number of the first byte that the peer sends. */
+#define PEER_SEQUENCE_NUMBER     5000UL
+
+/* Our sequence number before the first byte of TX data. */
+#define OUR_SEQUENCE_NUMBER      1000UL
+
+/* The length of the circular TX stream, only used to calculate positions. */
+#define TX_STREAM_LENGTH         65536
+
+/* The round-trip time of the first measurement in the SRTT test. */
+#define MEASURED_RTT_MS          40u
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined in FreeRTOS_IP.c, which is not part of
+ * this test. */
+uint16_t usPacketIdentifier;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+
+/* The sockets whose counters are read. */
+static FreeRTOS_Socket_t xUDPSocket;
+static FreeRTOS_Socket_t xTCPSocket;
+
+/* A short name for the window of xTCPSocket. */
+static TCPWindow_t * const pxWindow = &( xTCPSocket.u.xTCP.xTCPWindow );
+
+/* The counters as read by FreeRTOS_GetSocketCounters(). */
+static SocketCounters_t xCounters;
+
+/* The time as returned by xTaskGetTickCount(). */
+static TickType_t xTickCount;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+static TickType_t prvGetTickCount( int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return xTickCount;
+}
+
+/* Nothing is sent in these tests. */
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    ( void ) pxNetworkBuffer;
+    ( void ) xReleaseAfterSend;
+
+    TEST_FAIL();
+
+    return pdFAIL;
+}
+
+/* The other functions of the stack that are called by the sources under
+ * test. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+eARPLookupResult_t eARPGetCacheEntry( uint32_t * pulIPAddress,
+                                      MACAddress_t * const pxMACAddress )
+{
+    ( void ) pulIPAddress;
+    ( void ) pxMACAddress;
+
+    return eARPCacheMiss;
+}
+
+void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
+{
+    ( void ) ulIPAddress;
+}
+
+uint16_t usGenerateChecksum( uint32_t ulSum,
+                             const uint8_t * pucNextData,
+                             size_t uxDataLengthBytes )
+{
+    ( void ) ulSum;
+    ( void ) pucNextData;
+    ( void ) uxDataLengthBytes;
+
+    return 0u;
+}
+
+uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer,
+                                     size_t uxBufferLength,
+                                     BaseType_t xOutgoingPacket )
+{
+    ( void ) pucEthernetBuffer;
+    ( void ) uxBufferLength;
+    ( void ) xOutgoingPacket;
+
+    return 0u;
+}
+
+uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+                                             uint16_t usSourcePort,
+                                             uint32_t ulDestinationAddress,
+                                             uint16_t usDestinationPort )
+{
+    ( void ) ulSourceAddress;
+    ( void ) usSourcePort;
+    ( void ) ulDestinationAddress;
+    ( void ) usDestinationPort;
+
+    return OUR_SEQUENCE_NUMBER;
+}
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+    ( void ) eEvent;
+
+    return pdPASS;
+}
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
+                                     TickType_t uxTimeout )
+{
+    ( void ) pxEvent;
+    ( void ) uxTimeout;
+
+    return pdPASS;
+}
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t FreeRTOS_IsNetworkUp( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t xIPIsNetworkTaskReady( void )
+{
+    return pdTRUE;
+}
+
+NetworkBufferDescriptor_t * pxUDPPayloadBuffer_to_NetworkBuffer( void * pvBuffer )
+{
+    ( void ) pvBuffer;
+
+    return NULL;
+}
+
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber )
+{
+    *pulNumber = 0UL;
+
+    return pdPASS;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_Stub( prvGetTickCount );
+
+    xTickCount = 0u;
+    memset( &xCounters, 0xA5, sizeof( xCounters ) );
+
+    memset( &xUDPSocket, 0, sizeof( xUDPSocket ) );
+    xUDPSocket.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_UDP;
+
+    /* The window of an established connection, as the IP-task has created
+     * it. */
+    memset( &xTCPSocket, 0, sizeof( xTCPSocket ) );
+    xTCPSocket.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_TCP;
+    vTCPWindowCreate( pxWindow, WINDOW_LENGTH, WINDOW_LENGTH, PEER_SEQUENCE_NUMBER, OUR_SEQUENCE_NUMBER, TEST_MSS );
+    #if ( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+        vTCPWindowCongestionStart( pxWindow );
+    #endif
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    vTCPWindowDestroy( pxWindow );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Read the counters of xTCPSocket and check that the TCP members are the ones
+ * reported by its window. */
+static void prvCheckTCPCounters( void )
+{
+    TEST_ASSERT_EQUAL( pdPASS, FreeRTOS_GetSocketCounters( &xTCPSocket, &xCounters ) );
+
+    TEST_ASSERT_EQUAL_UINT32( pxWindow->ulRetransmitCount, xCounters.ulRetransmits );
+    TEST_ASSERT_EQUAL_INT32( pxWindow->lSRTT, xCounters.lSRTT );
+    TEST_ASSERT_EQUAL( listCURRENT_LIST_LENGTH( &( pxWindow->xRxSegments ) ), xCounters.uxOutOfOrderSegments );
+    #if ( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+        TEST_ASSERT_EQUAL_UINT32( pxWindow->xCongestion.ulCWnd, xCounters.ulCWnd );
+    #else
+        TEST_ASSERT_EQUAL_UINT32( pxWindow->xSize.ulTxWindowLength, xCounters.ulCWnd );
+    #endif
+}
+
+/* Queue one segment of 'ulLength' bytes and send it. */
+static void prvSendSegment( uint32_t ulLength )
+{
+    int32_t lPosition;
+
+    TEST_ASSERT_EQUAL( ( int32_t ) ulLength, lTCPWindowTxAdd( pxWindow, ulLength, 0, TX_STREAM_LENGTH ) );
+    TEST_ASSERT_EQUAL_UINT32( ulLength, ulTCPWindowTxGet( pxWindow, WINDOW_LENGTH, &lPosition ) );
+}
+
+/* ======================== Test functions ================================= */
+
+/* Invalid arguments are refused. */
+void test_invalid_arguments( void )
+{
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EINVAL, FreeRTOS_GetSocketCounters( NULL, &xCounters ) );
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EINVAL, FreeRTOS_GetSocketCounters( FREERTOS_INVALID_SOCKET, &xCounters ) );
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EINVAL, FreeRTOS_GetSocketCounters( &xUDPSocket, NULL ) );
+}
+
+/* The counters that the stack keeps in a UDP socket are copied as they are. */
+void test_udp_counters_copied( void )
+{
+    xUDPSocket.xCounters.ulRxBytes = 1000u;
+    xUDPSocket.xCounters.ulTxBytes = 2000u;
+    xUDPSocket.xCounters.ulRxPackets = 10u;
+    xUDPSocket.xCounters.ulTxPackets = 20u;
+    xUDPSocket.xCounters.ulRxDropped = 3u;
+
+    TEST_ASSERT_EQUAL( pdPASS, FreeRTOS_GetSocketCounters( &xUDPSocket, &xCounters ) );
+    TEST_ASSERT_EQUAL_MEMORY( &( xUDPSocket.xCounters ), &xCounters, sizeof( xCounters ) );
+}
+
+/* The counters of a TCP socket are copied too, the TCP members are sampled
+ * from the window. */
+void test_tcp_counters_copied( void )
+{
+    xTCPSocket.xCounters.ulRxBytes = 1000u;
+    xTCPSocket.xCounters.ulTxBytes = 2000u;
+    xTCPSocket.xCounters.ulZeroWindowEvents = 2u;
+
+    prvCheckTCPCounters();
+    TEST_ASSERT_EQUAL_UINT32( 1000u, xCounters.ulRxBytes );
+    TEST_ASSERT_EQUAL_UINT32( 2000u, xCounters.ulTxBytes );
+    TEST_ASSERT_EQUAL_UINT32( 2u, xCounters.ulZeroWindowEvents );
+}
+
+/* A new connection: no retransmissions, the initial SRTT and window. */
+void test_tcp_new_connection( void )
+{
+    prvCheckTCPCounters();
+    TEST_ASSERT_EQUAL_UINT32( 0u, xCounters.ulRetransmits );
+    TEST_ASSERT_EQUAL_INT32( 500, xCounters.lSRTT );
+    TEST_ASSERT_EQUAL( 0u, xCounters.uxOutOfOrderSegments );
+    TEST_ASSERT_TRUE( xCounters.ulCWnd > 0u );
+}
+
+/* A segment that is not acknowledged in time is sent again and counted. */
+void test_tcp_retransmission( void )
+{
+    int32_t lPosition;
+    uint32_t ulCWndBefore;
+
+    prvSendSegment( TEST_MSS );
+    prvCheckTCPCounters();
+    TEST_ASSERT_EQUAL_UINT32( 0u, xCounters.ulRetransmits );
+    ulCWndBefore = xCounters.ulCWnd;
+
+    /* The initial RTO is 1 second. */
+    xTickCount += pdMS_TO_TICKS( 1001u );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxGet( pxWindow, WINDOW_LENGTH, &lPosition ) );
+
+    prvCheckTCPCounters();
+    TEST_ASSERT_EQUAL_UINT32( 1u, xCounters.ulRetransmits );
+
+    #if ( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+        /* The loss collapses the congestion window. */
+        TEST_ASSERT_TRUE( xCounters.ulCWnd < ulCWndBefore );
+    #else
+        TEST_ASSERT_EQUAL_UINT32( ulCWndBefore, xCounters.ulCWnd );
+    #endif
+}
+
+/* The first RTT measurement replaces the initial SRTT. */
+void test_tcp_srtt( void )
+{
+    prvSendSegment( TEST_MSS );
+
+    xTickCount += pdMS_TO_TICKS( MEASURED_RTT_MS );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxAck( pxWindow, OUR_SEQUENCE_NUMBER + TEST_MSS ) );
+
+    prvCheckTCPCounters();
+    TEST_ASSERT_EQUAL_INT32( ( int32_t ) MEASURED_RTT_MS, xCounters.lSRTT );
+    TEST_ASSERT_EQUAL_UINT32( 0u, xCounters.ulRetransmits );
+}
+
+/* Data received after a gap waits in the reception queue, and leaves it when
+ * the gap is filled. */
+void test_tcp_out_of_order_segments( void )
+{
+    /* The first segment is missing, the second and third arrive and are
+     * stored. */
+    TEST_ASSERT_EQUAL( TEST_MSS, lTCPWindowRxCheck( pxWindow, PEER_SEQUENCE_NUMBER + TEST_MSS, TEST_MSS, WINDOW_LENGTH ) );
+    prvCheckTCPCounters();
+    TEST_ASSERT_EQUAL( 1u, xCounters.uxOutOfOrderSegments );
+
+    TEST_ASSERT_EQUAL( 2u * TEST_MSS, lTCPWindowRxCheck( pxWindow, PEER_SEQUENCE_NUMBER + ( 2u * TEST_MSS ), TEST_MSS, WINDOW_LENGTH ) );
+    prvCheckTCPCounters();
+    TEST_ASSERT_EQUAL( 2u, xCounters.uxOutOfOrderSegments );
+
+    /* The missing segment arrives: the stored segments are delivered. */
+    TEST_ASSERT_EQUAL( 0, lTCPWindowRxCheck( pxWindow, PEER_SEQUENCE_NUMBER, TEST_MSS, WINDOW_LENGTH ) );
+    prvCheckTCPCounters();
+    TEST_ASSERT_EQUAL( 0u, xCounters.uxOutOfOrderSegments );
+}
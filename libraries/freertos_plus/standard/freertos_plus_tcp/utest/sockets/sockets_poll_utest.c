@@ -0,0 +1,731 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+#include "mock_event_groups.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Stream_Buffer.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The length of the RX and TX streams. */
+#define STREAM_LENGTH            ( 4u * ipconfigTCP_MSS )
+
+/* The number of bytes in a segment from the peer. */
+#define SEGMENT_LENGTH           100u
+
+/* The sequence number of the first byte that the peer sends. */
+#define PEER_SEQUENCE_NUMBER     5000UL
+
+/* Our sequence number before the first byte of TX data. */
+#define OUR_SEQUENCE_NUMBER      1000UL
+
+/* The addresses of the connection. */
+#define LOCAL_PORT               80u
+#define REMOTE_PORT              49152u
+#define REMOTE_IP                0xC0A80002UL
+
+/* The ACK flag, private to FreeRTOS_TCP_IP.c. */
+#define TCP_FLAG_ACK             0x10u
+
+/* The bit that FreeRTOS_PollWait() waits for, private to FreeRTOS_Sockets.c. */
+#define pollEVENT_READY          0x0001u
+
+/* The user data passed along with the sockets. */
+#define UDP_USER_DATA            ( ( void * ) 0x1234 )
+#define TCP_USER_DATA            ( ( void * ) 0x5678 )
+
+/* The block time passed to FreeRTOS_PollWait() in the blocking tests. */
+#define BLOCK_TIME               100u
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined in FreeRTOS_IP.c, which is not part of
+ * this test. */
+uint16_t usPacketIdentifier;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+
+/* The sockets in the poll set. */
+static FreeRTOS_Socket_t xUDPSocket;
+static FreeRTOS_Socket_t xTCPSocket;
+
+/* The poll set under test. */
+static PollSet_t xPollSet;
+
+/* The events reported by FreeRTOS_PollWait(). */
+static PollEvent_t xEvents[ 2 ];
+
+/* The number of times that FreeRTOS_PollWait() waited for its event group,
+ * and the block time and the bits of the last wait. */
+static UBaseType_t uxWaitCount;
+static TickType_t xLastBlockTime;
+static EventBits_t xLastWaitBits;
+
+/* The number of checks for a time-out that still find time left. */
+static UBaseType_t uxChecksBeforeTimeOut;
+
+/* When not NULL, a UDP packet for this socket arrives while
+ * FreeRTOS_PollWait() is blocked. */
+static FreeRTOS_Socket_t * pxSocketToSignal;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+static BaseType_t prvCheckForTimeOut( TimeOut_t * const pxTimeOut,
+                                      TickType_t * const pxTicksToWait,
+                                      int cmock_num_calls )
+{
+    BaseType_t xReturn = pdTRUE;
+
+    ( void ) pxTimeOut;
+    ( void ) pxTicksToWait;
+    ( void ) cmock_num_calls;
+
+    if( uxChecksBeforeTimeOut > 0u )
+    {
+        uxChecksBeforeTimeOut--;
+        xReturn = pdFALSE;
+    }
+
+    return xReturn;
+}
+
+static void prvUDPPacketArrives( FreeRTOS_Socket_t * pxSocket );
+
+static EventBits_t prvWaitBits( EventGroupHandle_t xEventGroup,
+                                const EventBits_t uxBitsToWaitFor,
+                                const BaseType_t xClearOnExit,
+                                const BaseType_t xWaitForAllBits,
+                                TickType_t xTicksToWait,
+                                int cmock_num_calls )
+{
+    ( void ) xEventGroup;
+    ( void ) xClearOnExit;
+    ( void ) xWaitForAllBits;
+    ( void ) cmock_num_calls;
+
+    uxWaitCount++;
+    xLastBlockTime = xTicksToWait;
+    xLastWaitBits = uxBitsToWaitFor;
+
+    if( pxSocketToSignal != NULL )
+    {
+        prvUDPPacketArrives( pxSocketToSignal );
+        pxSocketToSignal = NULL;
+    }
+
+    return 0;
+}
+
+/* Nothing is sent in these tests. */
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    ( void ) pxNetworkBuffer;
+    ( void ) xReleaseAfterSend;
+
+    TEST_FAIL();
+
+    return pdFAIL;
+}
+
+/* The other functions of the stack that are called by the sources under
+ * test. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+eARPLookupResult_t eARPGetCacheEntry( uint32_t * pulIPAddress,
+                                      MACAddress_t * const pxMACAddress )
+{
+    ( void ) pulIPAddress;
+    ( void ) pxMACAddress;
+
+    return eARPCacheMiss;
+}
+
+void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
+{
+    ( void ) ulIPAddress;
+}
+
+uint16_t usGenerateChecksum( uint32_t ulSum,
+                             const uint8_t * pucNextData,
+                             size_t uxDataLengthBytes )
+{
+    ( void ) ulSum;
+    ( void ) pucNextData;
+    ( void ) uxDataLengthBytes;
+
+    return 0u;
+}
+
+uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer,
+                                     size_t uxBufferLength,
+                                     BaseType_t xOutgoingPacket )
+{
+    ( void ) pucEthernetBuffer;
+    ( void ) uxBufferLength;
+    ( void ) xOutgoingPacket;
+
+    return 0u;
+}
+
+uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+                                             uint16_t usSourcePort,
+                                             uint32_t ulDestinationAddress,
+                                             uint16_t usDestinationPort )
+{
+    ( void ) ulSourceAddress;
+    ( void ) usSourcePort;
+    ( void ) ulDestinationAddress;
+    ( void ) usDestinationPort;
+
+    return OUR_SEQUENCE_NUMBER;
+}
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+    ( void ) eEvent;
+
+    return pdPASS;
+}
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
+                                     TickType_t uxTimeout )
+{
+    ( void ) pxEvent;
+    ( void ) uxTimeout;
+
+    return pdPASS;
+}
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t FreeRTOS_IsNetworkUp( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t xIPIsNetworkTaskReady( void )
+{
+    return pdTRUE;
+}
+
+NetworkBufferDescriptor_t * pxUDPPayloadBuffer_to_NetworkBuffer( void * pvBuffer )
+{
+    ( void ) pvBuffer;
+
+    return NULL;
+}
+
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber )
+{
+    *pulNumber = 0UL;
+
+    return pdPASS;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    xEventGroupCreate_IgnoreAndReturn( ( EventGroupHandle_t ) &xPollSet );
+    vEventGroupDelete_Ignore();
+    xEventGroupSetBits_IgnoreAndReturn( 0 );
+    xEventGroupWaitBits_Stub( prvWaitBits );
+    xQueueCreateCountingSemaphore_IgnoreAndReturn( ( QueueHandle_t ) &xTCPSocket );
+    xQueueSemaphoreTake_IgnoreAndReturn( pdPASS );
+    xQueueGenericSend_IgnoreAndReturn( pdPASS );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_IgnoreAndReturn( 0 );
+    vTaskSetTimeOutState_Ignore();
+    xTaskCheckForTimeOut_Stub( prvCheckForTimeOut );
+
+    /* Only the first call initialises the buffers. */
+    TEST_ASSERT_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+    vNetworkSocketsInit();
+
+    uxWaitCount = 0u;
+    xLastBlockTime = 0u;
+    xLastWaitBits = 0u;
+    uxChecksBeforeTimeOut = 0u;
+    pxSocketToSignal = NULL;
+    memset( xEvents, 0, sizeof( xEvents ) );
+
+    memset( &xUDPSocket, 0, sizeof( xUDPSocket ) );
+    xUDPSocket.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_UDP;
+    vListInitialise( &( xUDPSocket.u.xUDP.xWaitingPacketsList ) );
+
+    memset( &xTCPSocket, 0, sizeof( xTCPSocket ) );
+
+    xPollSet = FreeRTOS_CreatePollSet();
+    TEST_ASSERT_NOT_NULL( xPollSet );
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    while( listCURRENT_LIST_LENGTH( &( xUDPSocket.u.xUDP.xWaitingPacketsList ) ) > 0u )
+    {
+        pxBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( xUDPSocket.u.xUDP.xWaitingPacketsList ) );
+        ( void ) uxListRemove( &( pxBuffer->xBufferListItem ) );
+        vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    }
+
+    if( xUDPSocket.pxPollSet != NULL )
+    {
+        TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_DEL, &xUDPSocket, 0u, NULL ) );
+    }
+
+    if( xTCPSocket.pxPollSet != NULL )
+    {
+        TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_DEL, &xTCPSocket, 0u, NULL ) );
+    }
+
+    /* FreeRTOS_DeletePollSet() asserts that the set is empty. */
+    FreeRTOS_DeletePollSet( xPollSet );
+    xPollSet = NULL;
+
+    if( xTCPSocket.u.xTCP.pxAckMessage != NULL )
+    {
+        vReleaseNetworkBufferAndDescriptor( xTCPSocket.u.xTCP.pxAckMessage );
+        xTCPSocket.u.xTCP.pxAckMessage = NULL;
+    }
+
+    if( xTCPSocket.u.xTCP.rxStream != NULL )
+    {
+        free( xTCPSocket.u.xTCP.rxStream );
+        xTCPSocket.u.xTCP.rxStream = NULL;
+    }
+
+    if( xTCPSocket.u.xTCP.txStream != NULL )
+    {
+        free( xTCPSocket.u.xTCP.txStream );
+        xTCPSocket.u.xTCP.txStream = NULL;
+    }
+
+    vTCPWindowDestroy( &( xTCPSocket.u.xTCP.xTCPWindow ) );
+
+    /* Every test returns all network buffers. */
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Do what FreeRTOS_UDP_IP.c does when a packet for pxSocket arrives: queue it
+ * and signal the socket. */
+static void prvUDPPacketArrives( FreeRTOS_Socket_t * pxSocket )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( ipconfigTCP_MSS, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    vListInsertEnd( &( pxSocket->u.xUDP.xWaitingPacketsList ), &( pxBuffer->xBufferListItem ) );
+    vSocketPollSignal( pxSocket, eSOCKET_RECEIVE );
+}
+
+/* Do what FreeRTOS_recvfrom() does: take the oldest packet from the socket. */
+static void prvUDPPacketRead( FreeRTOS_Socket_t * pxSocket )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    TEST_ASSERT_TRUE( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) > 0u );
+    pxBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
+    ( void ) uxListRemove( &( pxBuffer->xBufferListItem ) );
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+}
+
+/* Bind xTCPSocket and bring it into the state eESTABLISHED. */
+static void prvCreateConnection( void )
+{
+    struct freertos_sockaddr xAddress;
+    TCPPacket_t * pxTemplate;
+
+    xTCPSocket.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_TCP;
+    xTCPSocket.xEventGroup = ( EventGroupHandle_t ) &xTCPSocket;
+    vListInitialiseItem( &( xTCPSocket.xBoundSocketListItem ) );
+    listSET_LIST_ITEM_OWNER( &( xTCPSocket.xBoundSocketListItem ), ( void * ) &xTCPSocket );
+    xAddress.sin_port = FreeRTOS_htons( LOCAL_PORT );
+    TEST_ASSERT_EQUAL( 0, vSocketBind( &xTCPSocket, &xAddress, sizeof( xAddress ), pdTRUE ) );
+
+    xTCPSocket.u.xTCP.usRemotePort = REMOTE_PORT;
+    xTCPSocket.u.xTCP.ulRemoteIP = REMOTE_IP;
+    xTCPSocket.u.xTCP.ucTCPState = ( uint8_t ) eESTABLISHED;
+    xTCPSocket.u.xTCP.usInitMSS = ipconfigTCP_MSS;
+    xTCPSocket.u.xTCP.usCurMSS = ipconfigTCP_MSS;
+    xTCPSocket.u.xTCP.uxRxWinSize = 4u;
+    xTCPSocket.u.xTCP.uxTxWinSize = 4u;
+    xTCPSocket.u.xTCP.uxRxStreamSize = STREAM_LENGTH;
+    xTCPSocket.u.xTCP.uxTxStreamSize = STREAM_LENGTH;
+    xTCPSocket.u.xTCP.uxLittleSpace = ipconfigTCP_MSS;
+    xTCPSocket.u.xTCP.uxEnoughSpace = 2u * ipconfigTCP_MSS;
+    xTCPSocket.u.xTCP.ulWindowSize = 0xFFFFUL;
+    xTCPSocket.u.xTCP.ulHighestRxAllowed = PEER_SEQUENCE_NUMBER + STREAM_LENGTH;
+    xTCPSocket.u.xTCP.xTCPWindow.ulOurSequenceNumber = OUR_SEQUENCE_NUMBER;
+    xTCPSocket.u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = PEER_SEQUENCE_NUMBER;
+    TEST_FreeRTOS_TCP_prvTCPCreateWindow( &xTCPSocket );
+
+    /* The header of the last packet received from the peer. */
+    pxTemplate = ( TCPPacket_t * ) xTCPSocket.u.xTCP.xPacket.u.ucLastPacket;
+    pxTemplate->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxTemplate->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxTemplate->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxTemplate->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( REMOTE_IP );
+    pxTemplate->xTCPHeader.usSourcePort = FreeRTOS_htons( REMOTE_PORT );
+    pxTemplate->xTCPHeader.usDestinationPort = FreeRTOS_htons( LOCAL_PORT );
+}
+
+/* Let TCP handle a data segment from the peer, and wake up the owner of the
+ * socket like the IP-task does. */
+static void prvTCPDataArrives( void )
+{
+    const size_t uxHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER;
+    NetworkBufferDescriptor_t * pxBuffer;
+    TCPPacket_t * pxPacket;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( uxHeaderLength + SEGMENT_LENGTH, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    memset( pxBuffer->pucEthernetBuffer, 0, uxHeaderLength + SEGMENT_LENGTH );
+
+    pxPacket = ( TCPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxPacket->xIPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + SEGMENT_LENGTH );
+    pxPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( REMOTE_IP );
+    pxPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( REMOTE_PORT );
+    pxPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( LOCAL_PORT );
+    pxPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( PEER_SEQUENCE_NUMBER );
+    pxPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( OUR_SEQUENCE_NUMBER );
+    pxPacket->xTCPHeader.ucTCPOffset = 0x50u;
+    pxPacket->xTCPHeader.ucTCPFlags = TCP_FLAG_ACK;
+    pxPacket->xTCPHeader.usWindow = FreeRTOS_htons( 0x8000u );
+    pxBuffer->xDataLength = uxHeaderLength + SEGMENT_LENGTH;
+
+    if( xProcessReceivedTCPPacket( pxBuffer ) != pdPASS )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    }
+
+    vSocketWakeUpUser( &xTCPSocket );
+}
+
+/* ======================== Test functions ================================= */
+
+/* A UDP socket is readable as long as packets are queued. */
+void test_udp_read_readiness( void )
+{
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ, UDP_USER_DATA ) );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+
+    prvUDPPacketArrives( &xUDPSocket );
+
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL_PTR( &xUDPSocket, xEvents[ 0 ].xSocket );
+    TEST_ASSERT_EQUAL( ePOLL_READ, xEvents[ 0 ].xEvents );
+    TEST_ASSERT_EQUAL_PTR( UDP_USER_DATA, xEvents[ 0 ].pvUserData );
+
+    /* Level-triggered: reported again while the packet is not read. */
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL( ePOLL_READ, xEvents[ 0 ].xEvents );
+
+    prvUDPPacketRead( &xUDPSocket );
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+}
+
+/* An edge-triggered socket is reported once per new packet. */
+void test_udp_read_edge_triggered( void )
+{
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ | ePOLL_EDGE, UDP_USER_DATA ) );
+
+    prvUDPPacketArrives( &xUDPSocket );
+
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL( ePOLL_READ, xEvents[ 0 ].xEvents );
+
+    /* The packet is still there, but it has been reported. */
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+
+    prvUDPPacketArrives( &xUDPSocket );
+
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL( ePOLL_READ, xEvents[ 0 ].xEvents );
+}
+
+/* A socket that is ready already when it is added is reported at once. */
+void test_ready_when_added( void )
+{
+    prvUDPPacketArrives( &xUDPSocket );
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ, UDP_USER_DATA ) );
+
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL( ePOLL_READ, xEvents[ 0 ].xEvents );
+}
+
+/* A TCP socket becomes readable when the IP-task has stored data in its RX
+ * stream, and stops being readable when all data is read. */
+void test_tcp_read_readiness( void )
+{
+    uint8_t ucBuffer[ SEGMENT_LENGTH ];
+
+    prvCreateConnection();
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xTCPSocket, ePOLL_READ, TCP_USER_DATA ) );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+
+    prvTCPDataArrives();
+
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL_PTR( &xTCPSocket, xEvents[ 0 ].xSocket );
+    TEST_ASSERT_EQUAL( ePOLL_READ, xEvents[ 0 ].xEvents );
+    TEST_ASSERT_EQUAL_PTR( TCP_USER_DATA, xEvents[ 0 ].pvUserData );
+
+    TEST_ASSERT_EQUAL( SEGMENT_LENGTH, FreeRTOS_recv( &xTCPSocket, ucBuffer, sizeof( ucBuffer ), 0 ) );
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+}
+
+/* A connected TCP socket is writable while there is space in its TX stream. */
+void test_tcp_write_readiness( void )
+{
+    uint8_t ucBuffer[ SEGMENT_LENGTH ];
+    size_t uxSpace;
+
+    memset( ucBuffer, 0xA5, sizeof( ucBuffer ) );
+    prvCreateConnection();
+
+    /* The stream is empty, the socket is writable at once. */
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xTCPSocket, ePOLL_WRITE, TCP_USER_DATA ) );
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL( ePOLL_WRITE, xEvents[ 0 ].xEvents );
+
+    /* Fill the TX stream. */
+    while( FreeRTOS_tx_space( &xTCPSocket ) > 0 )
+    {
+        TEST_ASSERT_TRUE( FreeRTOS_send( &xTCPSocket, ucBuffer, sizeof( ucBuffer ), 0 ) > 0 );
+    }
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+
+    /* The peer acknowledges some data: the IP-task removes it from the stream
+     * and signals the owner. */
+    uxSpace = uxStreamBufferGet( xTCPSocket.u.xTCP.txStream, 0u, NULL, SEGMENT_LENGTH, pdFALSE );
+    TEST_ASSERT_EQUAL( SEGMENT_LENGTH, uxSpace );
+    xTCPSocket.xEventBits |= eSOCKET_SEND;
+    vSocketWakeUpUser( &xTCPSocket );
+
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL( ePOLL_WRITE, xEvents[ 0 ].xEvents );
+}
+
+/* When the peer closes the connection, the socket reports an error, and it
+ * is not writable anymore. */
+void test_tcp_error_readiness( void )
+{
+    prvCreateConnection();
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xTCPSocket, ePOLL_READ | ePOLL_WRITE | ePOLL_EXCEPT, TCP_USER_DATA ) );
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL( ePOLL_WRITE, xEvents[ 0 ].xEvents );
+
+    vTCPStateChange( &xTCPSocket, eCLOSE_WAIT );
+    vSocketWakeUpUser( &xTCPSocket );
+
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL( ePOLL_EXCEPT, xEvents[ 0 ].xEvents );
+
+    /* Level-triggered: the closure is reported again. */
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL( ePOLL_EXCEPT, xEvents[ 0 ].xEvents );
+}
+
+/* Only the events of interest are reported. */
+void test_events_not_of_interest_ignored( void )
+{
+    prvCreateConnection();
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xTCPSocket, ePOLL_READ, TCP_USER_DATA ) );
+
+    vTCPStateChange( &xTCPSocket, eCLOSE_WAIT );
+    vSocketWakeUpUser( &xTCPSocket );
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+
+    /* After a modification, the closure is of interest. */
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_MOD, &xTCPSocket, ePOLL_EXCEPT, TCP_USER_DATA ) );
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL( ePOLL_EXCEPT, xEvents[ 0 ].xEvents );
+}
+
+/* Both sockets are reported by a single call. */
+void test_two_sockets_ready( void )
+{
+    prvCreateConnection();
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xTCPSocket, ePOLL_WRITE, TCP_USER_DATA ) );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ, UDP_USER_DATA ) );
+    prvUDPPacketArrives( &xUDPSocket );
+
+    TEST_ASSERT_EQUAL( 2, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+    TEST_ASSERT_EQUAL_PTR( TCP_USER_DATA, xEvents[ 0 ].pvUserData );
+    TEST_ASSERT_EQUAL_PTR( UDP_USER_DATA, xEvents[ 1 ].pvUserData );
+
+    /* With room for one event, the sockets take turns. */
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 1, 0u ) );
+    TEST_ASSERT_EQUAL_PTR( TCP_USER_DATA, xEvents[ 0 ].pvUserData );
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 1, 0u ) );
+    TEST_ASSERT_EQUAL_PTR( UDP_USER_DATA, xEvents[ 0 ].pvUserData );
+}
+
+/* Without events, FreeRTOS_PollWait() blocks on the event group of the set
+ * until the time-out expires, and returns zero. */
+void test_wait_times_out( void )
+{
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ, UDP_USER_DATA ) );
+    uxChecksBeforeTimeOut = 1u;
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, BLOCK_TIME ) );
+
+    TEST_ASSERT_EQUAL( 1, uxWaitCount );
+    TEST_ASSERT_EQUAL( BLOCK_TIME, xLastBlockTime );
+    TEST_ASSERT_EQUAL( pollEVENT_READY, xLastWaitBits );
+}
+
+/* A zero block time does not block at all. */
+void test_wait_without_block_time( void )
+{
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ, UDP_USER_DATA ) );
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+
+    TEST_ASSERT_EQUAL( 0, uxWaitCount );
+}
+
+/* A packet that arrives while blocked ends the wait before the time-out. */
+void test_wait_ends_on_event( void )
+{
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ, UDP_USER_DATA ) );
+    uxChecksBeforeTimeOut = 1u;
+    pxSocketToSignal = &xUDPSocket;
+
+    TEST_ASSERT_EQUAL( 1, FreeRTOS_PollWait( xPollSet, xEvents, 2, BLOCK_TIME ) );
+    TEST_ASSERT_EQUAL( ePOLL_READ, xEvents[ 0 ].xEvents );
+
+    TEST_ASSERT_EQUAL( 1, uxWaitCount );
+    TEST_ASSERT_EQUAL( 0u, uxChecksBeforeTimeOut );
+}
+
+/* The errors of FreeRTOS_PollCtl(). */
+void test_poll_ctl_errors( void )
+{
+    PollSet_t xOtherSet;
+
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EINVAL, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, NULL, ePOLL_READ, NULL ) );
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EINVAL, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, FREERTOS_INVALID_SOCKET, ePOLL_READ, NULL ) );
+
+    /* Not a member yet. */
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_ENOENT, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_MOD, &xUDPSocket, ePOLL_READ, NULL ) );
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_ENOENT, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_DEL, &xUDPSocket, 0u, NULL ) );
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ, NULL ) );
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EEXIST, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ, NULL ) );
+
+    /* A socket belongs to one set only. */
+    xOtherSet = FreeRTOS_CreatePollSet();
+    TEST_ASSERT_NOT_NULL( xOtherSet );
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EEXIST, FreeRTOS_PollCtl( xOtherSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ, NULL ) );
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_ENOENT, FreeRTOS_PollCtl( xOtherSet, ePOLL_CTL_MOD, &xUDPSocket, ePOLL_READ, NULL ) );
+    FreeRTOS_DeletePollSet( xOtherSet );
+}
+
+/* A socket that is removed from the set is not reported anymore. */
+void test_deleted_socket_not_reported( void )
+{
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_ADD, &xUDPSocket, ePOLL_READ, UDP_USER_DATA ) );
+    prvUDPPacketArrives( &xUDPSocket );
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollCtl( xPollSet, ePOLL_CTL_DEL, &xUDPSocket, 0u, NULL ) );
+    TEST_ASSERT_NULL( xUDPSocket.pxPollSet );
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+
+    /* A new packet doesn't put it back either. */
+    prvUDPPacketArrives( &xUDPSocket );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_PollWait( xPollSet, xEvents, 2, 0u ) );
+}
@@ -0,0 +1,334 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/* This file is built twice: with ipconfigSTREAM_BUFFER_POWER_OF_TWO set to 0
+ * (compare and subtract) and set to 1 (masking). */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+#include "list.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Stream_Buffer.h"
+
+/* The length of the stream buffer.  A power of two, so that both variants of
+ * the wrapping can use it. */
+#define STREAM_LENGTH            1024u
+
+/* The number of bytes that pass through the buffer in the round-trip test. */
+#define ROUND_TRIP_BYTES         ( 1024u * 1024u )
+
+/* The number of bytes that pass through the buffer in the benchmark. */
+#define BENCHMARK_BYTES          ( 64u * 1024u * 1024u )
+
+/* The benchmark uses small reads and writes, so that the time spent on the
+ * indexes is not hidden by memcpy(). */
+#define BENCHMARK_CHUNK          64u
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* The buffer under test. */
+static StreamBuffer_t * pxStream;
+
+/* State of the pseudo random generator, so that every run is the same. */
+static uint32_t ulRandomState;
+
+/* ==========================  Helper functions  ============================ */
+
+static uint32_t prvRandom( void )
+{
+    ulRandomState = ( ulRandomState * 1103515245UL ) + 12345UL;
+
+    return ulRandomState >> 16;
+}
+
+/* The value of the byte at position uxPosition in the stream of bytes. */
+static uint8_t prvPattern( size_t uxPosition )
+{
+    return ( uint8_t ) ( ( uxPosition * 7u ) + ( uxPosition >> 8 ) );
+}
+
+/* Let the buffer start at index uxIndex, so that tests can make it wrap. */
+static void prvMoveTo( size_t uxIndex )
+{
+    pxStream->uxHead = uxIndex;
+    pxStream->uxTail = uxIndex;
+    pxStream->uxMid = uxIndex;
+    pxStream->uxFront = uxIndex;
+}
+
+/* Pass uxTotal bytes through the buffer, with writes and reads of random
+ * sizes below uxMaxChunk.  Returns the number of bytes that did not match. */
+static size_t prvRoundTrip( size_t uxTotal,
+                            size_t uxMaxChunk )
+{
+    uint8_t ucData[ STREAM_LENGTH ];
+    size_t uxWritten = 0u, uxRead = 0u, uxErrors = 0u;
+    size_t uxCount, x;
+
+    while( uxRead < uxTotal )
+    {
+        uxCount = FreeRTOS_min_uint32( prvRandom() % uxMaxChunk, uxTotal - uxWritten );
+
+        for( x = 0u; x < uxCount; x++ )
+        {
+            ucData[ x ] = prvPattern( uxWritten + x );
+        }
+
+        uxWritten += uxStreamBufferAdd( pxStream, 0u, ucData, uxCount );
+
+        uxCount = uxStreamBufferGet( pxStream, 0u, ucData, prvRandom() % uxMaxChunk, pdFALSE );
+
+        for( x = 0u; x < uxCount; x++ )
+        {
+            if( ucData[ x ] != prvPattern( uxRead + x ) )
+            {
+                uxErrors++;
+            }
+        }
+
+        uxRead += uxCount;
+    }
+
+    return uxErrors;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    size_t uxSize = sizeof( *pxStream ) - sizeof( pxStream->ucArray ) + STREAM_LENGTH;
+
+    pxStream = ( StreamBuffer_t * ) malloc( uxSize );
+    TEST_ASSERT_NOT_NULL( pxStream );
+    memset( pxStream, 0, uxSize );
+    pxStream->LENGTH = STREAM_LENGTH;
+    ulRandomState = 1UL;
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    free( pxStream );
+    pxStream = NULL;
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ======================== Test functions ================================= */
+
+/* Data read from the buffer equals the data written to it, at every
+ * position of the indexes. */
+void test_round_trip( void )
+{
+    TEST_ASSERT_EQUAL( 0, prvRoundTrip( ROUND_TRIP_BYTES, STREAM_LENGTH ) );
+    TEST_ASSERT_EQUAL( 0, uxStreamBufferGetSize( pxStream ) );
+    TEST_ASSERT_EQUAL( STREAM_LENGTH - 1u, uxStreamBufferGetSpace( pxStream ) );
+}
+
+/* At most LENGTH - 1 bytes can be stored. */
+void test_add_full( void )
+{
+    uint8_t ucData[ STREAM_LENGTH ];
+
+    memset( ucData, 0x5A, sizeof( ucData ) );
+    prvMoveTo( STREAM_LENGTH - 10u );
+
+    TEST_ASSERT_EQUAL( STREAM_LENGTH - 1u, uxStreamBufferAdd( pxStream, 0u, ucData, sizeof( ucData ) ) );
+    TEST_ASSERT_EQUAL( STREAM_LENGTH - 11u, pxStream->uxHead );
+    TEST_ASSERT_EQUAL( 0, uxStreamBufferGetSpace( pxStream ) );
+    TEST_ASSERT_EQUAL( 0, uxStreamBufferAdd( pxStream, 0u, ucData, 1u ) );
+}
+
+/* Stored data that does not wrap is a single region. */
+void test_read_regions_single( void )
+{
+    StreamBufferRegions_t xRegions;
+    uint8_t ucData[ 100 ];
+
+    memset( ucData, 0x11, sizeof( ucData ) );
+    prvMoveTo( 200u );
+    ( void ) uxStreamBufferAdd( pxStream, 0u, ucData, sizeof( ucData ) );
+
+    TEST_ASSERT_EQUAL( 100, uxStreamBufferGetReadRegions( pxStream, 0u, &xRegions ) );
+    TEST_ASSERT_EQUAL_PTR( pxStream->ucArray + 200u, xRegions.pucFirst );
+    TEST_ASSERT_EQUAL( 100, xRegions.uxFirst );
+    TEST_ASSERT_NULL( xRegions.pucSecond );
+    TEST_ASSERT_EQUAL( 0, xRegions.uxSecond );
+}
+
+/* Stored data that wraps around the end of ucArray is two regions, and can
+ * be removed after it was used in place. */
+void test_read_regions_wrap( void )
+{
+    StreamBufferRegions_t xRegions;
+    uint8_t ucData[ 100 ];
+    size_t x;
+
+    for( x = 0u; x < sizeof( ucData ); x++ )
+    {
+        ucData[ x ] = prvPattern( x );
+    }
+
+    prvMoveTo( STREAM_LENGTH - 30u );
+    ( void ) uxStreamBufferAdd( pxStream, 0u, ucData, sizeof( ucData ) );
+
+    TEST_ASSERT_EQUAL( 100, uxStreamBufferGetReadRegions( pxStream, 0u, &xRegions ) );
+    TEST_ASSERT_EQUAL_PTR( pxStream->ucArray + STREAM_LENGTH - 30u, xRegions.pucFirst );
+    TEST_ASSERT_EQUAL( 30, xRegions.uxFirst );
+    TEST_ASSERT_EQUAL_PTR( pxStream->ucArray, xRegions.pucSecond );
+    TEST_ASSERT_EQUAL( 70, xRegions.uxSecond );
+    TEST_ASSERT_EQUAL_MEMORY( ucData, xRegions.pucFirst, 30 );
+    TEST_ASSERT_EQUAL_MEMORY( ucData + 30, xRegions.pucSecond, 70 );
+
+    /* With an offset, the data that is left does not wrap. */
+    TEST_ASSERT_EQUAL( 60, uxStreamBufferGetReadRegions( pxStream, 40u, &xRegions ) );
+    TEST_ASSERT_EQUAL_PTR( pxStream->ucArray + 10u, xRegions.pucFirst );
+    TEST_ASSERT_EQUAL( 60, xRegions.uxFirst );
+    TEST_ASSERT_NULL( xRegions.pucSecond );
+
+    /* The data was used in place, remove it. */
+    TEST_ASSERT_EQUAL( 100, uxStreamBufferGet( pxStream, 0u, NULL, 100u, pdFALSE ) );
+    TEST_ASSERT_EQUAL( 70, pxStream->uxTail );
+    TEST_ASSERT_EQUAL( 0, uxStreamBufferGetSize( pxStream ) );
+}
+
+/* An offset beyond the stored data gives no regions. */
+void test_read_regions_beyond_data( void )
+{
+    StreamBufferRegions_t xRegions;
+    uint8_t ucData[ 10 ];
+
+    memset( ucData, 0, sizeof( ucData ) );
+    ( void ) uxStreamBufferAdd( pxStream, 0u, ucData, sizeof( ucData ) );
+
+    TEST_ASSERT_EQUAL( 0, uxStreamBufferGetReadRegions( pxStream, 10u, &xRegions ) );
+    TEST_ASSERT_EQUAL( 0, xRegions.uxFirst );
+    TEST_ASSERT_NULL( xRegions.pucSecond );
+}
+
+/* Free space that wraps around the end of ucArray is two regions.  Data
+ * written in place is added by uxStreamBufferAdd() without data pointer. */
+void test_write_regions_wrap( void )
+{
+    StreamBufferRegions_t xRegions;
+    uint8_t ucData[ STREAM_LENGTH ];
+    size_t x;
+
+    prvMoveTo( STREAM_LENGTH - 30u );
+
+    TEST_ASSERT_EQUAL( STREAM_LENGTH - 1u, uxStreamBufferGetWriteRegions( pxStream, 0u, &xRegions ) );
+    TEST_ASSERT_EQUAL_PTR( pxStream->ucArray + STREAM_LENGTH - 30u, xRegions.pucFirst );
+    TEST_ASSERT_EQUAL( 30, xRegions.uxFirst );
+    TEST_ASSERT_EQUAL_PTR( pxStream->ucArray, xRegions.pucSecond );
+    TEST_ASSERT_EQUAL( STREAM_LENGTH - 31u, xRegions.uxSecond );
+
+    for( x = 0u; x < xRegions.uxFirst; x++ )
+    {
+        xRegions.pucFirst[ x ] = prvPattern( x );
+    }
+
+    for( x = 0u; x < 70u; x++ )
+    {
+        xRegions.pucSecond[ x ] = prvPattern( xRegions.uxFirst + x );
+    }
+
+    TEST_ASSERT_EQUAL( 100, uxStreamBufferAdd( pxStream, 0u, NULL, 100u ) );
+    TEST_ASSERT_EQUAL( 70, pxStream->uxHead );
+    TEST_ASSERT_EQUAL( 100, uxStreamBufferGet( pxStream, 0u, ucData, sizeof( ucData ), pdFALSE ) );
+
+    for( x = 0u; x < 100u; x++ )
+    {
+        TEST_ASSERT_EQUAL_HEX8( prvPattern( x ), ucData[ x ] );
+    }
+}
+
+/* The free space in front of uxHead, at an offset, ends one byte before
+ * uxTail. */
+void test_write_regions_offset( void )
+{
+    StreamBufferRegions_t xRegions;
+    uint8_t ucData[ 100 ];
+
+    memset( ucData, 0, sizeof( ucData ) );
+    prvMoveTo( 500u );
+    ( void ) uxStreamBufferAdd( pxStream, 0u, ucData, sizeof( ucData ) );
+
+    TEST_ASSERT_EQUAL( STREAM_LENGTH - 101u - 20u, uxStreamBufferGetWriteRegions( pxStream, 20u, &xRegions ) );
+    TEST_ASSERT_EQUAL_PTR( pxStream->ucArray + 620u, xRegions.pucFirst );
+    TEST_ASSERT_EQUAL( STREAM_LENGTH - 620u, xRegions.uxFirst );
+    TEST_ASSERT_EQUAL_PTR( pxStream->ucArray, xRegions.pucSecond );
+    TEST_ASSERT_EQUAL( 499, xRegions.uxSecond );
+}
+
+/* A full buffer has no free regions. */
+void test_write_regions_full( void )
+{
+    StreamBufferRegions_t xRegions;
+    uint8_t ucData[ STREAM_LENGTH ];
+
+    memset( ucData, 0, sizeof( ucData ) );
+    prvMoveTo( 300u );
+    ( void ) uxStreamBufferAdd( pxStream, 0u, ucData, sizeof( ucData ) );
+
+    TEST_ASSERT_EQUAL( 0, uxStreamBufferGetWriteRegions( pxStream, 0u, &xRegions ) );
+    TEST_ASSERT_EQUAL( 0, xRegions.uxFirst );
+    TEST_ASSERT_NULL( xRegions.pucSecond );
+}
+
+/* Measure the time needed to pass data through the buffer.  Compare the
+ * output of both builds of this test to see the cost of the wrapping. */
+void test_round_trip_benchmark( void )
+{
+    struct timespec xStart, xEnd;
+    double dSeconds;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &xStart );
+    TEST_ASSERT_EQUAL( 0, prvRoundTrip( BENCHMARK_BYTES, BENCHMARK_CHUNK ) );
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &xEnd );
+
+    dSeconds = ( double ) ( xEnd.tv_sec - xStart.tv_sec ) + ( ( double ) ( xEnd.tv_nsec - xStart.tv_nsec ) / 1e9 );
+    printf( "Stream buffer round trip (%s): %u MB in %.3f sec\n",
+            ( ipconfigSTREAM_BUFFER_POWER_OF_TWO != 0 ) ? "mask" : "compare",
+            ( unsigned ) ( BENCHMARK_BYTES / ( 1024u * 1024u ) ),
+            dSeconds );
+}
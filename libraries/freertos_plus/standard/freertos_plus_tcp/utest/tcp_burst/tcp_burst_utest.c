@@ -0,0 +1,471 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_Stream_Buffer.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The size of the heap blocks header that records the size of a block. */
+#define HEAP_HEADER_SIZE      16u
+
+/* The number of bytes queued for transmission, more than a single burst. */
+#define TX_DATA_LENGTH        ( 6u * ipconfigTCP_MSS )
+
+/* The length of txStream, a power of two. */
+#define TX_STREAM_LENGTH      16384u
+
+/* A bare ACK as it is received: Ethernet, IP and TCP headers only. */
+#define BARE_ACK_LENGTH       ( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER )
+
+/* Our sequence number before the first byte of TX data. */
+#define OUR_SEQUENCE_NUMBER   1000UL
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined in FreeRTOS_IP.c and FreeRTOS_Sockets.c,
+ * which are not part of this test. */
+uint16_t usPacketIdentifier;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+List_t xBoundTCPSocketsList;
+
+/* The connection that sends the data. */
+static FreeRTOS_Socket_t xSocket;
+
+/* The data in txStream. */
+static uint8_t ucTxData[ TX_DATA_LENGTH ];
+
+/* The number of frames passed to the driver, and the number of them that
+ * were longer than the memory of their network buffer. */
+static uint32_t ulFramesSent;
+static uint32_t ulFramesTooLong;
+
+/* The payload bytes that the driver received, in order. */
+static uint32_t ulBytesSent;
+
+/* When true, pvPortMalloc() fails. */
+static BaseType_t xMallocFails;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+/* Records the size of each block in front of it, so that the driver can see
+ * how much memory a network buffer really has. */
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    uint8_t * pucBlock;
+
+    ( void ) cmock_num_calls;
+
+    if( xMallocFails != pdFALSE )
+    {
+        return NULL;
+    }
+
+    pucBlock = malloc( xSize + HEAP_HEADER_SIZE );
+    TEST_ASSERT_NOT_NULL( pucBlock );
+    memcpy( pucBlock, &xSize, sizeof( xSize ) );
+
+    return pucBlock + HEAP_HEADER_SIZE;
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    if( pv != NULL )
+    {
+        free( ( uint8_t * ) pv - HEAP_HEADER_SIZE );
+    }
+}
+
+static size_t prvBlockSize( const void * pv )
+{
+    size_t xSize;
+
+    memcpy( &xSize, ( const uint8_t * ) pv - HEAP_HEADER_SIZE, sizeof( xSize ) );
+
+    return xSize;
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    const TCPPacket_t * pxTCPPacket = ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+    size_t uxHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER +
+                            ( ( pxTCPPacket->xTCPHeader.ucTCPOffset >> 4 ) * 4u );
+    size_t uxPayload = pxNetworkBuffer->xDataLength - uxHeaderLength;
+    uint32_t ulOffset = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber ) - OUR_SEQUENCE_NUMBER;
+
+    ulFramesSent++;
+
+    /* With BufferAllocation_2.c, the Ethernet buffer starts ipBUFFER_PADDING
+     * bytes into the block. */
+    if( pxNetworkBuffer->xDataLength + ipBUFFER_PADDING > prvBlockSize( pxNetworkBuffer->pucEthernetBuffer - ipBUFFER_PADDING ) )
+    {
+        ulFramesTooLong++;
+    }
+    else
+    {
+        TEST_ASSERT_EQUAL_MEMORY( &( ucTxData[ ulOffset ] ), pxNetworkBuffer->pucEthernetBuffer + uxHeaderLength, uxPayload );
+        ulBytesSent += ( uint32_t ) uxPayload;
+    }
+
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return pdPASS;
+}
+
+/* The other functions of the stack that FreeRTOS_TCP_IP.c calls.  They are
+ * not used while data is sent in the state eESTABLISHED. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+eARPLookupResult_t eARPGetCacheEntry( uint32_t * pulIPAddress,
+                                      MACAddress_t * const pxMACAddress )
+{
+    ( void ) pulIPAddress;
+    ( void ) pxMACAddress;
+
+    return eARPCacheMiss;
+}
+
+void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
+{
+    ( void ) ulIPAddress;
+}
+
+FreeRTOS_Socket_t * pxTCPSocketLookup( uint32_t ulLocalIP,
+                                       UBaseType_t uxLocalPort,
+                                       uint32_t ulRemoteIP,
+                                       UBaseType_t uxRemotePort )
+{
+    ( void ) ulLocalIP;
+    ( void ) uxLocalPort;
+    ( void ) ulRemoteIP;
+    ( void ) uxRemotePort;
+
+    return &xSocket;
+}
+
+uint16_t usGenerateChecksum( uint32_t ulSum,
+                             const uint8_t * pucNextData,
+                             size_t uxDataLengthBytes )
+{
+    ( void ) ulSum;
+    ( void ) pucNextData;
+    ( void ) uxDataLengthBytes;
+
+    return 0u;
+}
+
+uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer,
+                                     size_t uxBufferLength,
+                                     BaseType_t xOutgoingPacket )
+{
+    ( void ) pucEthernetBuffer;
+    ( void ) uxBufferLength;
+    ( void ) xOutgoingPacket;
+
+    return 0u;
+}
+
+uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+                                             uint16_t usSourcePort,
+                                             uint32_t ulDestinationAddress,
+                                             uint16_t usDestinationPort )
+{
+    ( void ) ulSourceAddress;
+    ( void ) usSourcePort;
+    ( void ) ulDestinationAddress;
+    ( void ) usDestinationPort;
+
+    return OUR_SEQUENCE_NUMBER;
+}
+
+int32_t lTCPAddRxdata( FreeRTOS_Socket_t * pxSocket,
+                       size_t uxOffset,
+                       const uint8_t * pcData,
+                       uint32_t ulByteCount )
+{
+    ( void ) pxSocket;
+    ( void ) uxOffset;
+    ( void ) pcData;
+
+    return ( int32_t ) ulByteCount;
+}
+
+BaseType_t vSocketBind( FreeRTOS_Socket_t * pxSocket,
+                        struct freertos_sockaddr * pxAddress,
+                        size_t uxAddressLength,
+                        BaseType_t xInternal )
+{
+    ( void ) pxSocket;
+    ( void ) pxAddress;
+    ( void ) uxAddressLength;
+    ( void ) xInternal;
+
+    return 0;
+}
+
+void * vSocketClose( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+
+    return NULL;
+}
+
+void vSocketWakeUpUser( FreeRTOS_Socket_t * pxSocket )
+{
+    ( void ) pxSocket;
+}
+
+Socket_t FreeRTOS_socket( BaseType_t xDomain,
+                          BaseType_t xType,
+                          BaseType_t xProtocol )
+{
+    ( void ) xDomain;
+    ( void ) xType;
+    ( void ) xProtocol;
+
+    return FREERTOS_INVALID_SOCKET;
+}
+
+BaseType_t FreeRTOS_closesocket( Socket_t xSocket )
+{
+    ( void ) xSocket;
+
+    return 0;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    size_t x;
+
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    xQueueCreateCountingSemaphore_IgnoreAndReturn( ( QueueHandle_t ) &xSocket );
+    xQueueSemaphoreTake_IgnoreAndReturn( pdPASS );
+    xQueueGenericSend_IgnoreAndReturn( pdPASS );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_IgnoreAndReturn( 0 );
+
+    /* Only the first call initialises the buffers. */
+    TEST_ASSERT_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+
+    /* BufferAllocation_2.c allocates network buffers of variable size. */
+    TEST_ASSERT_FALSE( xBufferAllocFixedSize );
+
+    xMallocFails = pdFALSE;
+    ulFramesSent = 0u;
+    ulFramesTooLong = 0u;
+    ulBytesSent = 0u;
+
+    for( x = 0; x < sizeof( ucTxData ); x++ )
+    {
+        ucTxData[ x ] = ( uint8_t ) ( x * 7u + ( x >> 8 ) );
+    }
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    if( xSocket.u.xTCP.txStream != NULL )
+    {
+        free( xSocket.u.xTCP.txStream );
+        xSocket.u.xTCP.txStream = NULL;
+    }
+
+    vTCPWindowDestroy( &( xSocket.u.xTCP.xTCPWindow ) );
+
+    /* Every test returns all network buffers. */
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Bring xSocket into the state eESTABLISHED, with TX_DATA_LENGTH bytes in
+ * txStream that have been passed to the sliding window. */
+static void prvCreateConnection( void )
+{
+    StreamBuffer_t * pxStream;
+    TCPPacket_t * pxTemplate;
+    int32_t lCount;
+
+    memset( &xSocket, 0, sizeof( xSocket ) );
+    xSocket.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_TCP;
+    xSocket.usLocalPort = 80u;
+    xSocket.u.xTCP.usRemotePort = 49152u;
+    xSocket.u.xTCP.ulRemoteIP = 0xC0A80002UL;
+    xSocket.u.xTCP.ucTCPState = ( uint8_t ) eESTABLISHED;
+    xSocket.u.xTCP.usInitMSS = ipconfigTCP_MSS;
+    xSocket.u.xTCP.usCurMSS = ipconfigTCP_MSS;
+    xSocket.u.xTCP.uxRxWinSize = 8u;
+    xSocket.u.xTCP.uxTxWinSize = 8u;
+    xSocket.u.xTCP.uxRxStreamSize = TX_STREAM_LENGTH;
+    xSocket.u.xTCP.ulWindowSize = 0xFFFFUL;
+    xSocket.u.xTCP.xTCPWindow.ulOurSequenceNumber = OUR_SEQUENCE_NUMBER;
+    xSocket.u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = 5000UL;
+    TEST_FreeRTOS_TCP_prvTCPCreateWindow( &xSocket );
+    #if ( ipconfigUSE_TCP_CONGESTION_CONTROL != 0 )
+        vTCPWindowCongestionStart( &( xSocket.u.xTCP.xTCPWindow ) );
+    #endif
+
+    /* The header of the last packet received from the peer. */
+    pxTemplate = ( TCPPacket_t * ) xSocket.u.xTCP.xPacket.u.ucLastPacket;
+    pxTemplate->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxTemplate->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxTemplate->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxTemplate->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( xSocket.u.xTCP.ulRemoteIP );
+    pxTemplate->xTCPHeader.usSourcePort = FreeRTOS_htons( xSocket.u.xTCP.usRemotePort );
+    pxTemplate->xTCPHeader.usDestinationPort = FreeRTOS_htons( xSocket.usLocalPort );
+
+    pxStream = calloc( 1, sizeof( *pxStream ) - sizeof( pxStream->ucArray ) + TX_STREAM_LENGTH );
+    TEST_ASSERT_NOT_NULL( pxStream );
+    pxStream->LENGTH = TX_STREAM_LENGTH;
+    xSocket.u.xTCP.txStream = pxStream;
+
+    /* What FreeRTOS_send() and prvTCPAddTxData() do. */
+    TEST_ASSERT_EQUAL( TX_DATA_LENGTH, uxStreamBufferAdd( pxStream, 0u, ucTxData, TX_DATA_LENGTH ) );
+    lCount = lTCPWindowTxAdd( &( xSocket.u.xTCP.xTCPWindow ), TX_DATA_LENGTH, ( int32_t ) pxStream->uxMid, ( int32_t ) pxStream->LENGTH );
+    TEST_ASSERT_EQUAL( TX_DATA_LENGTH, lCount );
+    vStreamBufferMoveMid( pxStream, ( size_t ) lCount );
+}
+
+/* A network buffer that holds a bare ACK from the peer, as small as
+ * BufferAllocation_2.c makes it. */
+static NetworkBufferDescriptor_t * prvReceiveBareACK( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( BARE_ACK_LENGTH, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    TEST_ASSERT_LESS_THAN( ipconfigTCP_MSS, prvBlockSize( pxBuffer->pucEthernetBuffer - ipBUFFER_PADDING ) );
+
+    memcpy( pxBuffer->pucEthernetBuffer, xSocket.u.xTCP.xPacket.u.ucLastPacket, BARE_ACK_LENGTH );
+    pxBuffer->xDataLength = BARE_ACK_LENGTH;
+
+    return pxBuffer;
+}
+
+/* ======================== Test functions ================================= */
+
+/* A burst that is sent in reply to a bare ACK may not write beyond the memory
+ * of the received network buffer. */
+void test_burst_from_minimum_size_ack( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+    int32_t lResult;
+
+    prvCreateConnection();
+    pxBuffer = prvReceiveBareACK();
+
+    lResult = TEST_FreeRTOS_TCP_prvTCPSendRepeated( &xSocket, &pxBuffer );
+
+    TEST_ASSERT_GREATER_THAN( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL( 0, ulFramesTooLong );
+    TEST_ASSERT_EQUAL( ulBytesSent + ulFramesSent * ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER ), lResult );
+
+    /* The received buffer has been replaced by a bigger one, which is still
+     * owned by the caller. */
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    TEST_ASSERT_TRUE( prvBlockSize( pxBuffer->pucEthernetBuffer - ipBUFFER_PADDING ) >= ( ipBUFFER_PADDING + BARE_ACK_LENGTH + ipconfigTCP_MSS ) );
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+}
+
+/* When a TCP timer expires, there is no received buffer and the burst
+ * obtains one. */
+void test_burst_without_buffer( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer = NULL;
+
+    prvCreateConnection();
+
+    ( void ) TEST_FreeRTOS_TCP_prvTCPSendRepeated( &xSocket, &pxBuffer );
+
+    TEST_ASSERT_GREATER_THAN( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL( 0, ulFramesTooLong );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+}
+
+/* When a bigger buffer can not be obtained, nothing is sent and the caller
+ * keeps its own buffer.  The data will be retransmitted later. */
+void test_burst_resize_fails( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer, * pxReceived;
+
+    prvCreateConnection();
+    pxReceived = prvReceiveBareACK();
+    pxBuffer = pxReceived;
+
+    /* No bigger buffer can be allocated. */
+    xMallocFails = pdTRUE;
+    ( void ) TEST_FreeRTOS_TCP_prvTCPSendRepeated( &xSocket, &pxBuffer );
+
+    TEST_ASSERT_EQUAL( 0, ulFramesSent );
+    TEST_ASSERT_EQUAL_PTR( pxReceived, pxBuffer );
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+}
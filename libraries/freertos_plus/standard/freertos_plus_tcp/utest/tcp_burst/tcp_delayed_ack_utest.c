@@ -0,0 +1,475 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+#include "mock_event_groups.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Stream_Buffer.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The length of the RX and TX streams. */
+#define STREAM_LENGTH            ( 8u * ipconfigTCP_MSS )
+
+/* The number of bytes in a small segment. */
+#define SMALL_SEGMENT            100u
+
+/* The sequence number of the first byte that the peer sends. */
+#define PEER_SEQUENCE_NUMBER     5000UL
+
+/* Our sequence number before the first byte of TX data. */
+#define OUR_SEQUENCE_NUMBER      1000UL
+
+/* The addresses of the connection. */
+#define LOCAL_PORT               80u
+#define REMOTE_PORT              49152u
+#define REMOTE_IP                0xC0A80002UL
+
+/* The ACK flag, private to FreeRTOS_TCP_IP.c. */
+#define TCP_FLAG_ACK             0x10u
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined in FreeRTOS_IP.c, which is not part of
+ * this test. */
+uint16_t usPacketIdentifier;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+
+/* The end of the connection that receives data and sends the ACKs. */
+static FreeRTOS_Socket_t xSocket;
+
+/* The data sent by both ends. */
+static uint8_t ucData[ STREAM_LENGTH ];
+
+/* The number of frames sent to the peer, and the payload length and the
+ * acknowledgement number of the last one. */
+static uint32_t ulFramesSent;
+static size_t uxLastPayload;
+static uint32_t ulLastAckNr;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    const TCPPacket_t * pxTCPPacket = ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+    size_t uxHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER +
+                            ( ( pxTCPPacket->xTCPHeader.ucTCPOffset >> 4 ) * 4u );
+
+    TEST_ASSERT_TRUE( ( pxTCPPacket->xTCPHeader.ucTCPFlags & TCP_FLAG_ACK ) != 0u );
+
+    ulFramesSent++;
+    uxLastPayload = pxNetworkBuffer->xDataLength - uxHeaderLength;
+    ulLastAckNr = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr );
+
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return pdPASS;
+}
+
+/* The other functions of the stack that are called by the sources under
+ * test.  They are not used in the state eESTABLISHED. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+eARPLookupResult_t eARPGetCacheEntry( uint32_t * pulIPAddress,
+                                      MACAddress_t * const pxMACAddress )
+{
+    ( void ) pulIPAddress;
+    ( void ) pxMACAddress;
+
+    return eARPCacheMiss;
+}
+
+void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
+{
+    ( void ) ulIPAddress;
+}
+
+uint16_t usGenerateChecksum( uint32_t ulSum,
+                             const uint8_t * pucNextData,
+                             size_t uxDataLengthBytes )
+{
+    ( void ) ulSum;
+    ( void ) pucNextData;
+    ( void ) uxDataLengthBytes;
+
+    return 0u;
+}
+
+uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer,
+                                     size_t uxBufferLength,
+                                     BaseType_t xOutgoingPacket )
+{
+    ( void ) pucEthernetBuffer;
+    ( void ) uxBufferLength;
+    ( void ) xOutgoingPacket;
+
+    return 0u;
+}
+
+uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+                                             uint16_t usSourcePort,
+                                             uint32_t ulDestinationAddress,
+                                             uint16_t usDestinationPort )
+{
+    ( void ) ulSourceAddress;
+    ( void ) usSourcePort;
+    ( void ) ulDestinationAddress;
+    ( void ) usDestinationPort;
+
+    return 1000UL;
+}
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+    ( void ) eEvent;
+
+    return pdPASS;
+}
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
+                                     TickType_t uxTimeout )
+{
+    ( void ) pxEvent;
+    ( void ) uxTimeout;
+
+    return pdPASS;
+}
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t FreeRTOS_IsNetworkUp( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t xIPIsNetworkTaskReady( void )
+{
+    return pdTRUE;
+}
+
+NetworkBufferDescriptor_t * pxUDPPayloadBuffer_to_NetworkBuffer( void * pvBuffer )
+{
+    ( void ) pvBuffer;
+
+    return NULL;
+}
+
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber )
+{
+    *pulNumber = 0UL;
+
+    return pdPASS;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    size_t x;
+
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    xEventGroupSetBits_IgnoreAndReturn( 0 );
+    xQueueCreateCountingSemaphore_IgnoreAndReturn( ( QueueHandle_t ) &xSocket );
+    xQueueSemaphoreTake_IgnoreAndReturn( pdPASS );
+    xQueueGenericSend_IgnoreAndReturn( pdPASS );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_IgnoreAndReturn( 0 );
+
+    /* Only the first call initialises the buffers. */
+    TEST_ASSERT_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+    vNetworkSocketsInit();
+
+    ulFramesSent = 0u;
+    uxLastPayload = 0u;
+    ulLastAckNr = 0u;
+
+    for( x = 0; x < sizeof( ucData ); x++ )
+    {
+        ucData[ x ] = ( uint8_t ) ( x * 7u + ( x >> 8 ) );
+    }
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    if( xSocket.u.xTCP.pxAckMessage != NULL )
+    {
+        vReleaseNetworkBufferAndDescriptor( xSocket.u.xTCP.pxAckMessage );
+        xSocket.u.xTCP.pxAckMessage = NULL;
+    }
+
+    if( xSocket.u.xTCP.rxStream != NULL )
+    {
+        free( xSocket.u.xTCP.rxStream );
+        xSocket.u.xTCP.rxStream = NULL;
+    }
+
+    if( xSocket.u.xTCP.txStream != NULL )
+    {
+        free( xSocket.u.xTCP.txStream );
+        xSocket.u.xTCP.txStream = NULL;
+    }
+
+    vTCPWindowDestroy( &( xSocket.u.xTCP.xTCPWindow ) );
+
+    /* Every test returns all network buffers. */
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Bind xSocket and bring it into the state eESTABLISHED, after the segments
+ * that are acknowledged in quick-ACK mode. */
+static void prvCreateConnection( void )
+{
+    struct freertos_sockaddr xAddress;
+    TCPPacket_t * pxTemplate;
+
+    memset( &xSocket, 0, sizeof( xSocket ) );
+    xSocket.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_TCP;
+    xSocket.xEventGroup = ( EventGroupHandle_t ) &xSocket;
+    vListInitialiseItem( &( xSocket.xBoundSocketListItem ) );
+    listSET_LIST_ITEM_OWNER( &( xSocket.xBoundSocketListItem ), ( void * ) &xSocket );
+    xAddress.sin_port = FreeRTOS_htons( LOCAL_PORT );
+    TEST_ASSERT_EQUAL( 0, vSocketBind( &xSocket, &xAddress, sizeof( xAddress ), pdTRUE ) );
+
+    xSocket.u.xTCP.usRemotePort = REMOTE_PORT;
+    xSocket.u.xTCP.ulRemoteIP = REMOTE_IP;
+    xSocket.u.xTCP.ucTCPState = ( uint8_t ) eESTABLISHED;
+    xSocket.u.xTCP.usInitMSS = ipconfigTCP_MSS;
+    xSocket.u.xTCP.usCurMSS = ipconfigTCP_MSS;
+    xSocket.u.xTCP.uxRxWinSize = 8u;
+    xSocket.u.xTCP.uxTxWinSize = 8u;
+    xSocket.u.xTCP.uxRxStreamSize = STREAM_LENGTH;
+    xSocket.u.xTCP.uxTxStreamSize = STREAM_LENGTH;
+    xSocket.u.xTCP.uxLittleSpace = ipconfigTCP_MSS;
+    xSocket.u.xTCP.uxEnoughSpace = 4u * ipconfigTCP_MSS;
+    xSocket.u.xTCP.ulWindowSize = 0xFFFFUL;
+    xSocket.u.xTCP.ulHighestRxAllowed = PEER_SEQUENCE_NUMBER + STREAM_LENGTH;
+    xSocket.u.xTCP.xTCPWindow.ulOurSequenceNumber = OUR_SEQUENCE_NUMBER;
+    xSocket.u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = PEER_SEQUENCE_NUMBER;
+    TEST_FreeRTOS_TCP_prvTCPCreateWindow( &xSocket );
+
+    /* The header of the last packet received from the peer. */
+    pxTemplate = ( TCPPacket_t * ) xSocket.u.xTCP.xPacket.u.ucLastPacket;
+    pxTemplate->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxTemplate->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxTemplate->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxTemplate->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( REMOTE_IP );
+    pxTemplate->xTCPHeader.usSourcePort = FreeRTOS_htons( REMOTE_PORT );
+    pxTemplate->xTCPHeader.usDestinationPort = FreeRTOS_htons( LOCAL_PORT );
+}
+
+/* Let TCP handle a data segment of uxLength bytes from the peer, which
+ * starts uxOffset bytes into the stream. */
+static void prvReceiveData( size_t uxOffset,
+                            size_t uxLength )
+{
+    const size_t uxHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER;
+    NetworkBufferDescriptor_t * pxBuffer;
+    TCPPacket_t * pxPacket;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( uxHeaderLength + uxLength, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    memset( pxBuffer->pucEthernetBuffer, 0, uxHeaderLength );
+
+    pxPacket = ( TCPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxPacket->xIPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxLength );
+    pxPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( REMOTE_IP );
+    pxPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( REMOTE_PORT );
+    pxPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( LOCAL_PORT );
+    pxPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( PEER_SEQUENCE_NUMBER + uxOffset );
+    pxPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( OUR_SEQUENCE_NUMBER );
+    pxPacket->xTCPHeader.ucTCPOffset = 0x50u;
+    pxPacket->xTCPHeader.ucTCPFlags = TCP_FLAG_ACK;
+    pxPacket->xTCPHeader.usWindow = FreeRTOS_htons( 0x8000u );
+    memcpy( pxBuffer->pucEthernetBuffer + uxHeaderLength, &( ucData[ uxOffset ] ), uxLength );
+    pxBuffer->xDataLength = uxHeaderLength + uxLength;
+
+    if( xProcessReceivedTCPPacket( pxBuffer ) != pdPASS )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    }
+}
+
+/* ======================== Test functions ================================= */
+
+/* A small segment is not acknowledged at once, the ACK message is kept. */
+void test_small_segment_ack_delayed( void )
+{
+    prvCreateConnection();
+
+    prvReceiveData( 0u, SMALL_SEGMENT );
+
+    TEST_ASSERT_EQUAL( 0, ulFramesSent );
+    TEST_ASSERT_NOT_NULL( xSocket.u.xTCP.pxAckMessage );
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - 1, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* When the delayed-ACK timer expires while TX data is waiting, the ACK is
+ * carried by the data, and the ACK message is released. */
+void test_delayed_ack_piggybacked_on_data( void )
+{
+    prvCreateConnection();
+
+    prvReceiveData( 0u, SMALL_SEGMENT );
+    TEST_ASSERT_NOT_NULL( xSocket.u.xTCP.pxAckMessage );
+
+    TEST_ASSERT_EQUAL( 2u * SMALL_SEGMENT, FreeRTOS_send( &xSocket, ucData, 2u * SMALL_SEGMENT, 0 ) );
+    ( void ) xTCPSocketCheck( &xSocket );
+
+    /* A single frame, with both the data and the acknowledgement. */
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL( 2u * SMALL_SEGMENT, uxLastPayload );
+    TEST_ASSERT_EQUAL( PEER_SEQUENCE_NUMBER + SMALL_SEGMENT, ulLastAckNr );
+
+    TEST_ASSERT_NULL( xSocket.u.xTCP.pxAckMessage );
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* Without TX data, the delayed ACK is sent on its own. */
+void test_delayed_ack_sent_alone( void )
+{
+    prvCreateConnection();
+
+    prvReceiveData( 0u, SMALL_SEGMENT );
+    ( void ) xTCPSocketCheck( &xSocket );
+
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL( 0, uxLastPayload );
+    TEST_ASSERT_EQUAL( PEER_SEQUENCE_NUMBER + SMALL_SEGMENT, ulLastAckNr );
+
+    TEST_ASSERT_NULL( xSocket.u.xTCP.pxAckMessage );
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* In quick-ACK mode, segments are acknowledged at once. */
+void test_quick_ack_mode( void )
+{
+    prvCreateConnection();
+    xSocket.u.xTCP.ucQuickAckCount = 1u;
+
+    prvReceiveData( 0u, SMALL_SEGMENT );
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL( PEER_SEQUENCE_NUMBER + SMALL_SEGMENT, ulLastAckNr );
+    TEST_ASSERT_NULL( xSocket.u.xTCP.pxAckMessage );
+    TEST_ASSERT_EQUAL( 0, xSocket.u.xTCP.ucQuickAckCount );
+
+    /* The mode has ended, the next ACK is delayed. */
+    prvReceiveData( SMALL_SEGMENT, SMALL_SEGMENT );
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_NOT_NULL( xSocket.u.xTCP.pxAckMessage );
+}
+
+/* A segment that arrives out of order is acknowledged at once, and starts
+ * quick-ACK mode. */
+void test_out_of_order_starts_quick_ack( void )
+{
+    prvCreateConnection();
+
+    prvReceiveData( SMALL_SEGMENT, SMALL_SEGMENT );
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL( PEER_SEQUENCE_NUMBER, ulLastAckNr );
+    TEST_ASSERT_TRUE( xSocket.u.xTCP.ucQuickAckCount > 0u );
+}
+
+/* At least every second full-size segment is acknowledged. */
+void test_every_second_full_segment_acked( void )
+{
+    prvCreateConnection();
+
+    prvReceiveData( 0u, ipconfigTCP_MSS );
+    TEST_ASSERT_EQUAL( 0, ulFramesSent );
+    TEST_ASSERT_NOT_NULL( xSocket.u.xTCP.pxAckMessage );
+    TEST_ASSERT_EQUAL( 1, xSocket.u.xTCP.ucUnackedSegments );
+
+    prvReceiveData( ipconfigTCP_MSS, ipconfigTCP_MSS );
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL( PEER_SEQUENCE_NUMBER + 2u * ipconfigTCP_MSS, ulLastAckNr );
+    TEST_ASSERT_NULL( xSocket.u.xTCP.pxAckMessage );
+    TEST_ASSERT_EQUAL( 0, xSocket.u.xTCP.ucUnackedSegments );
+}
@@ -0,0 +1,469 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+#include "mock_event_groups.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_Stream_Buffer.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The number of segments in a burst. */
+#define BURST_SEGMENTS           4u
+
+/* The length of rxStream. */
+#define RX_STREAM_LENGTH         16384u
+
+/* The sequence number of the first byte that the peer sends. */
+#define PEER_SEQUENCE_NUMBER     5000UL
+
+/* The addresses of the connection. */
+#define LOCAL_PORT               80u
+#define REMOTE_PORT              49152u
+#define REMOTE_IP                0xC0A80002UL
+
+/* The ACK flag, private to FreeRTOS_TCP_IP.c. */
+#define TCP_FLAG_ACK             0x10u
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined in FreeRTOS_IP.c, which is not part of
+ * this test. */
+uint16_t usPacketIdentifier;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+
+/* The receiving end of the connection. */
+static FreeRTOS_Socket_t xSocket;
+
+/* The data sent by the peer. */
+static uint8_t ucRxData[ BURST_SEGMENTS * ipconfigTCP_MSS ];
+
+/* The number of calls to the OnReceive handler, and the bytes passed. */
+static uint32_t ulDeliveries;
+static uint32_t ulBytesDelivered;
+
+/* The number of times that the owner of the socket was woken up. */
+static uint32_t ulWakeUps;
+
+/* The number of ACKs sent to the peer. */
+static uint32_t ulFramesSent;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+static EventBits_t prvEventGroupSetBits( EventGroupHandle_t xEventGroup,
+                                         const EventBits_t uxBitsToSet,
+                                         int cmock_num_calls )
+{
+    ( void ) xEventGroup;
+    ( void ) cmock_num_calls;
+
+    if( ( uxBitsToSet & ( EventBits_t ) eSOCKET_RECEIVE ) != 0u )
+    {
+        ulWakeUps++;
+    }
+
+    return uxBitsToSet;
+}
+
+static BaseType_t prvOnReceive( Socket_t xSocket,
+                                void * pvData,
+                                size_t xLength )
+{
+    ( void ) xSocket;
+
+    TEST_ASSERT_EQUAL_MEMORY( &( ucRxData[ ulBytesDelivered ] ), pvData, xLength );
+    ulDeliveries++;
+    ulBytesDelivered += ( uint32_t ) xLength;
+
+    return 0;
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    ulFramesSent++;
+
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return pdPASS;
+}
+
+/* The other functions of the stack that are called by the sources under
+ * test.  They are not used while data is received in the state
+ * eESTABLISHED. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+eARPLookupResult_t eARPGetCacheEntry( uint32_t * pulIPAddress,
+                                      MACAddress_t * const pxMACAddress )
+{
+    ( void ) pulIPAddress;
+    ( void ) pxMACAddress;
+
+    return eARPCacheMiss;
+}
+
+void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
+{
+    ( void ) ulIPAddress;
+}
+
+uint16_t usGenerateChecksum( uint32_t ulSum,
+                             const uint8_t * pucNextData,
+                             size_t uxDataLengthBytes )
+{
+    ( void ) ulSum;
+    ( void ) pucNextData;
+    ( void ) uxDataLengthBytes;
+
+    return 0u;
+}
+
+uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer,
+                                     size_t uxBufferLength,
+                                     BaseType_t xOutgoingPacket )
+{
+    ( void ) pucEthernetBuffer;
+    ( void ) uxBufferLength;
+    ( void ) xOutgoingPacket;
+
+    return 0u;
+}
+
+uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+                                             uint16_t usSourcePort,
+                                             uint32_t ulDestinationAddress,
+                                             uint16_t usDestinationPort )
+{
+    ( void ) ulSourceAddress;
+    ( void ) usSourcePort;
+    ( void ) ulDestinationAddress;
+    ( void ) usDestinationPort;
+
+    return 1000UL;
+}
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+    ( void ) eEvent;
+
+    return pdPASS;
+}
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
+                                     TickType_t uxTimeout )
+{
+    ( void ) pxEvent;
+    ( void ) uxTimeout;
+
+    return pdPASS;
+}
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t FreeRTOS_IsNetworkUp( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t xIPIsNetworkTaskReady( void )
+{
+    return pdTRUE;
+}
+
+NetworkBufferDescriptor_t * pxUDPPayloadBuffer_to_NetworkBuffer( void * pvBuffer )
+{
+    ( void ) pvBuffer;
+
+    return NULL;
+}
+
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber )
+{
+    *pulNumber = 0UL;
+
+    return pdPASS;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    size_t x;
+
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    xEventGroupSetBits_Stub( prvEventGroupSetBits );
+    xQueueCreateCountingSemaphore_IgnoreAndReturn( ( QueueHandle_t ) &xSocket );
+    xQueueSemaphoreTake_IgnoreAndReturn( pdPASS );
+    xQueueGenericSend_IgnoreAndReturn( pdPASS );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_IgnoreAndReturn( 0 );
+
+    /* Only the first call initialises the buffers. */
+    TEST_ASSERT_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+    vNetworkSocketsInit();
+
+    ulDeliveries = 0u;
+    ulBytesDelivered = 0u;
+    ulWakeUps = 0u;
+    ulFramesSent = 0u;
+
+    for( x = 0; x < sizeof( ucRxData ); x++ )
+    {
+        ucRxData[ x ] = ( uint8_t ) ( x * 13u + ( x >> 8 ) );
+    }
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    if( xSocket.u.xTCP.pxAckMessage != NULL )
+    {
+        vReleaseNetworkBufferAndDescriptor( xSocket.u.xTCP.pxAckMessage );
+        xSocket.u.xTCP.pxAckMessage = NULL;
+    }
+
+    if( xSocket.u.xTCP.rxStream != NULL )
+    {
+        free( xSocket.u.xTCP.rxStream );
+        xSocket.u.xTCP.rxStream = NULL;
+    }
+
+    vTCPWindowDestroy( &( xSocket.u.xTCP.xTCPWindow ) );
+
+    /* Every test returns all network buffers. */
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Bind xSocket and bring it into the state eESTABLISHED.  When
+ * xUseHandler is true, it gets an OnReceive handler. */
+static void prvCreateConnection( BaseType_t xUseHandler )
+{
+    struct freertos_sockaddr xAddress;
+
+    memset( &xSocket, 0, sizeof( xSocket ) );
+    xSocket.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_TCP;
+    xSocket.xEventGroup = ( EventGroupHandle_t ) &xSocket;
+    vListInitialiseItem( &( xSocket.xBoundSocketListItem ) );
+    listSET_LIST_ITEM_OWNER( &( xSocket.xBoundSocketListItem ), ( void * ) &xSocket );
+    xAddress.sin_port = FreeRTOS_htons( LOCAL_PORT );
+    TEST_ASSERT_EQUAL( 0, vSocketBind( &xSocket, &xAddress, sizeof( xAddress ), pdTRUE ) );
+
+    xSocket.u.xTCP.usRemotePort = REMOTE_PORT;
+    xSocket.u.xTCP.ulRemoteIP = REMOTE_IP;
+    xSocket.u.xTCP.ucTCPState = ( uint8_t ) eESTABLISHED;
+    xSocket.u.xTCP.usInitMSS = ipconfigTCP_MSS;
+    xSocket.u.xTCP.usCurMSS = ipconfigTCP_MSS;
+    xSocket.u.xTCP.uxRxWinSize = 8u;
+    xSocket.u.xTCP.uxTxWinSize = 8u;
+    xSocket.u.xTCP.uxRxStreamSize = RX_STREAM_LENGTH;
+    xSocket.u.xTCP.uxLittleSpace = ipconfigTCP_MSS;
+    xSocket.u.xTCP.uxEnoughSpace = 4u * ipconfigTCP_MSS;
+    xSocket.u.xTCP.ulHighestRxAllowed = PEER_SEQUENCE_NUMBER + RX_STREAM_LENGTH;
+    xSocket.u.xTCP.xTCPWindow.ulOurSequenceNumber = 1000UL;
+    xSocket.u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = PEER_SEQUENCE_NUMBER;
+    TEST_FreeRTOS_TCP_prvTCPCreateWindow( &xSocket );
+
+    if( xUseHandler != pdFALSE )
+    {
+        xSocket.u.xTCP.pxHandleReceive = prvOnReceive;
+    }
+}
+
+/* A network buffer with the data segment number uxIndex from the peer. */
+static NetworkBufferDescriptor_t * prvDataSegment( size_t uxIndex )
+{
+    const size_t uxHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER;
+    NetworkBufferDescriptor_t * pxBuffer;
+    TCPPacket_t * pxPacket;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( uxHeaderLength + ipconfigTCP_MSS, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    memset( pxBuffer->pucEthernetBuffer, 0, uxHeaderLength );
+
+    pxPacket = ( TCPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxPacket->xIPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + ipconfigTCP_MSS );
+    pxPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( REMOTE_IP );
+    pxPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( REMOTE_PORT );
+    pxPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( LOCAL_PORT );
+    pxPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( PEER_SEQUENCE_NUMBER + uxIndex * ipconfigTCP_MSS );
+    pxPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( 1000UL );
+    pxPacket->xTCPHeader.ucTCPOffset = 0x50u;
+    pxPacket->xTCPHeader.ucTCPFlags = TCP_FLAG_ACK;
+    pxPacket->xTCPHeader.usWindow = FreeRTOS_htons( 0x8000u );
+    memcpy( pxBuffer->pucEthernetBuffer + uxHeaderLength, &( ucRxData[ uxIndex * ipconfigTCP_MSS ] ), ipconfigTCP_MSS );
+    pxBuffer->xDataLength = uxHeaderLength + ipconfigTCP_MSS;
+
+    return pxBuffer;
+}
+
+/* Let TCP handle a chain of segments, starting at uxFirst, the way
+ * prvHandleEthernetPacket() does.  The segment with index uxDropped is
+ * dropped by the IP layer. */
+static void prvReceiveChain( size_t uxFirst,
+                             size_t uxCount,
+                             size_t uxDropped )
+{
+    NetworkBufferDescriptor_t * pxBuffers[ BURST_SEGMENTS ];
+    size_t x;
+
+    for( x = 0; x < uxCount; x++ )
+    {
+        pxBuffers[ x ] = prvDataSegment( uxFirst + x );
+    }
+
+    for( x = 0; x < uxCount; x++ )
+    {
+        vTCPSetNextReceivedBuffer( ( x + 1u < uxCount ) ? pxBuffers[ x + 1u ] : NULL );
+
+        if( ( x == uxDropped ) || ( xProcessReceivedTCPPacket( pxBuffers[ x ] ) != pdPASS ) )
+        {
+            vReleaseNetworkBufferAndDescriptor( pxBuffers[ x ] );
+        }
+    }
+
+    vTCPSetNextReceivedBuffer( NULL );
+}
+
+/* ======================== Test functions ================================= */
+
+/* Segments that arrive one by one are passed to the handler one by one. */
+void test_separate_segments_delivered_each( void )
+{
+    size_t x;
+
+    prvCreateConnection( pdTRUE );
+
+    for( x = 0; x < BURST_SEGMENTS; x++ )
+    {
+        prvReceiveChain( x, 1u, BURST_SEGMENTS );
+    }
+
+    TEST_ASSERT_EQUAL( BURST_SEGMENTS, ulDeliveries );
+    TEST_ASSERT_EQUAL( BURST_SEGMENTS * ipconfigTCP_MSS, ulBytesDelivered );
+}
+
+/* A burst of in-order segments in one chain is passed to the handler in a
+ * single call, and acknowledged once. */
+void test_burst_single_delivery( void )
+{
+    prvCreateConnection( pdTRUE );
+
+    prvReceiveChain( 0u, BURST_SEGMENTS, BURST_SEGMENTS );
+
+    TEST_ASSERT_EQUAL( 1, ulDeliveries );
+    TEST_ASSERT_EQUAL( BURST_SEGMENTS * ipconfigTCP_MSS, ulBytesDelivered );
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL( 0, uxStreamBufferGetSize( xSocket.u.xTCP.rxStream ) );
+}
+
+/* When the segment that should deliver the held back data is dropped, the
+ * data is delivered at the end of the chain. */
+void test_burst_follower_dropped( void )
+{
+    prvCreateConnection( pdTRUE );
+
+    prvReceiveChain( 0u, BURST_SEGMENTS, BURST_SEGMENTS - 1u );
+
+    TEST_ASSERT_EQUAL( 1, ulDeliveries );
+    TEST_ASSERT_EQUAL( ( BURST_SEGMENTS - 1u ) * ipconfigTCP_MSS, ulBytesDelivered );
+    TEST_ASSERT_FALSE( xSocket.u.xTCP.bits.bRxDeferred );
+}
+
+/* A socket without a handler is woken up once for the whole burst. */
+void test_burst_single_wakeup( void )
+{
+    prvCreateConnection( pdFALSE );
+
+    prvReceiveChain( 0u, BURST_SEGMENTS, BURST_SEGMENTS );
+    TEST_ASSERT_EQUAL( 0, ulWakeUps );
+
+    /* The IP-task is about to sleep. */
+    ( void ) xTCPTimerCheck( pdTRUE );
+
+    TEST_ASSERT_EQUAL( 1, ulWakeUps );
+    TEST_ASSERT_EQUAL( BURST_SEGMENTS * ipconfigTCP_MSS, uxStreamBufferGetSize( xSocket.u.xTCP.rxStream ) );
+}
@@ -0,0 +1,713 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+#include "mock_event_groups.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Stream_Buffer.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The initial sequence number of the client. */
+#define OUR_SEQUENCE_NUMBER      1000UL
+
+/* The initial sequence number of the server. */
+#define PEER_SEQUENCE_NUMBER     5000UL
+
+/* The addresses of the connections.  Every server has its own cookie. */
+#define LOCAL_PORT               50000u
+#define SERVER_PORT              80u
+#define SERVER_IP                0xC0A80002UL
+
+/* The MSS that the server announces. */
+#define SERVER_MSS               1000u
+
+/* The TCP flags and options, private to FreeRTOS_TCP_IP.c. */
+#define TCP_FLAG_SYN             0x02u
+#define TCP_FLAG_ACK             0x10u
+#define TCP_OPT_NOOP             1u
+#define TCP_OPT_MSS              2u
+#define TCP_OPT_FASTOPEN         34u
+
+/* The number of frames that are remembered. */
+#define MAX_FRAMES               8u
+
+/* A frame sent by the client. */
+typedef struct xSENT_FRAME
+{
+    uint8_t ucFlags;
+    uint32_t ulSequenceNumber;
+    uint32_t ulAckNr;
+    size_t uxOptionsLength;
+    uint8_t ucOptions[ 40 ];
+    size_t uxDataLength;
+    uint8_t ucData[ 32 ];
+} SentFrame_t;
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined in FreeRTOS_IP.c, which is not part of
+ * this test. */
+uint16_t usPacketIdentifier;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+
+/* The data that is sent along with the SYN. */
+static const uint8_t ucEarlyData[] = "hello";
+#define EARLY_DATA_LENGTH    ( sizeof( ucEarlyData ) - 1u )
+
+/* The cookie that the server hands out is the first COOKIE_LENGTH bytes,
+ * the rest is used to send a cookie that is too long. */
+#define COOKIE_LENGTH    8u
+static const uint8_t ucCookie[ 17 ] =
+{
+    0xc0, 0x0c, 0x1e, 0x5a, 0x11, 0x22, 0x33, 0x44,
+    0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd
+};
+
+/* The client socket of the test, closed in tearDown(). */
+static FreeRTOS_Socket_t * pxClient;
+
+/* Used as the handle of the event groups and semaphores. */
+static uint32_t ulDummyHandle;
+
+/* The time returned by xTaskGetTickCount(). */
+static TickType_t xTickCount;
+
+/* The frames that were sent. */
+static SentFrame_t xFrames[ MAX_FRAMES ];
+static uint32_t ulFramesSent;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+static TickType_t prvGetTickCount( int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return xTickCount;
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    const TCPPacket_t * pxTCPPacket = ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+    size_t uxHeaderLength = ( size_t ) ( pxTCPPacket->xTCPHeader.ucTCPOffset >> 4 ) * 4u;
+    SentFrame_t * pxFrame;
+
+    if( ulFramesSent < MAX_FRAMES )
+    {
+        pxFrame = &( xFrames[ ulFramesSent ] );
+        pxFrame->ucFlags = pxTCPPacket->xTCPHeader.ucTCPFlags;
+        pxFrame->ulSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+        pxFrame->ulAckNr = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr );
+        pxFrame->uxOptionsLength = uxHeaderLength - ipSIZE_OF_TCP_HEADER;
+        memcpy( pxFrame->ucOptions, pxTCPPacket->xTCPHeader.ucOptdata, pxFrame->uxOptionsLength );
+        pxFrame->uxDataLength = FreeRTOS_ntohs( pxTCPPacket->xIPHeader.usLength ) - ipSIZE_OF_IPv4_HEADER - uxHeaderLength;
+
+        if( pxFrame->uxDataLength <= sizeof( pxFrame->ucData ) )
+        {
+            memcpy( pxFrame->ucData,
+                    pxNetworkBuffer->pucEthernetBuffer + ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + uxHeaderLength,
+                    pxFrame->uxDataLength );
+        }
+    }
+
+    ulFramesSent++;
+
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return pdPASS;
+}
+
+/* The other functions of the stack that are called by the sources under
+ * test. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+/* Every server is known, so that the SYN can be sent at once. */
+eARPLookupResult_t eARPGetCacheEntry( uint32_t * pulIPAddress,
+                                      MACAddress_t * const pxMACAddress )
+{
+    ( void ) pulIPAddress;
+
+    memset( pxMACAddress, 0x22, sizeof( *pxMACAddress ) );
+
+    return eARPCacheHit;
+}
+
+void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
+{
+    ( void ) ulIPAddress;
+}
+
+uint16_t usGenerateChecksum( uint32_t ulSum,
+                             const uint8_t * pucNextData,
+                             size_t uxDataLengthBytes )
+{
+    ( void ) ulSum;
+    ( void ) pucNextData;
+    ( void ) uxDataLengthBytes;
+
+    return 0u;
+}
+
+uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer,
+                                     size_t uxBufferLength,
+                                     BaseType_t xOutgoingPacket )
+{
+    ( void ) pucEthernetBuffer;
+    ( void ) uxBufferLength;
+    ( void ) xOutgoingPacket;
+
+    return 0u;
+}
+
+uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+                                             uint16_t usSourcePort,
+                                             uint32_t ulDestinationAddress,
+                                             uint16_t usDestinationPort )
+{
+    ( void ) ulSourceAddress;
+    ( void ) usSourcePort;
+    ( void ) ulDestinationAddress;
+    ( void ) usDestinationPort;
+
+    return OUR_SEQUENCE_NUMBER;
+}
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+    ( void ) eEvent;
+
+    return pdPASS;
+}
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
+                                     TickType_t uxTimeout )
+{
+    ( void ) pxEvent;
+    ( void ) uxTimeout;
+
+    return pdPASS;
+}
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+    return pdFALSE;
+}
+
+BaseType_t FreeRTOS_IsNetworkUp( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t xIPIsNetworkTaskReady( void )
+{
+    return pdTRUE;
+}
+
+NetworkBufferDescriptor_t * pxUDPPayloadBuffer_to_NetworkBuffer( void * pvBuffer )
+{
+    ( void ) pvBuffer;
+
+    return NULL;
+}
+
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber )
+{
+    *pulNumber = 0UL;
+
+    return pdPASS;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    xEventGroupCreate_IgnoreAndReturn( ( EventGroupHandle_t ) &ulDummyHandle );
+    vEventGroupDelete_Ignore();
+    xEventGroupSetBits_IgnoreAndReturn( 0 );
+    xQueueCreateCountingSemaphore_IgnoreAndReturn( ( QueueHandle_t ) &ulDummyHandle );
+    xQueueSemaphoreTake_IgnoreAndReturn( pdPASS );
+    xQueueGenericSend_IgnoreAndReturn( pdPASS );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_Stub( prvGetTickCount );
+
+    /* Only the first call initialises the buffers. */
+    TEST_ASSERT_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+    vNetworkSocketsInit();
+    TEST_FreeRTOS_TCP_vFastOpenCacheClear();
+
+    pxClient = NULL;
+    xTickCount = 1000u;
+    ulFramesSent = 0u;
+    memset( xFrames, 0, sizeof( xFrames ) );
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    if( pxClient != NULL )
+    {
+        ( void ) vSocketClose( pxClient );
+        pxClient = NULL;
+    }
+
+    /* Every test returns all network buffers. */
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Create the non-blocking client socket of the test, and queue the early data
+ * when xEarlyData is true. */
+static void prvClientOpen( BaseType_t xFastOpen,
+                           BaseType_t xEarlyData )
+{
+    struct freertos_sockaddr xAddress;
+    TickType_t xNoTimeout = 0u;
+
+    if( pxClient != NULL )
+    {
+        ( void ) vSocketClose( pxClient );
+    }
+
+    pxClient = ( FreeRTOS_Socket_t * ) FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+    TEST_ASSERT_NOT_NULL( pxClient );
+    TEST_ASSERT_TRUE( pxClient != FREERTOS_INVALID_SOCKET );
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_setsockopt( pxClient, 0, FREERTOS_SO_RCVTIMEO, &xNoTimeout, sizeof( xNoTimeout ) ) );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_setsockopt( pxClient, 0, FREERTOS_SO_SNDTIMEO, &xNoTimeout, sizeof( xNoTimeout ) ) );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_setsockopt( pxClient, 0, FREERTOS_SO_TCP_FASTOPEN, &xFastOpen, sizeof( xFastOpen ) ) );
+
+    xAddress.sin_port = FreeRTOS_htons( LOCAL_PORT );
+    TEST_ASSERT_EQUAL( 0, vSocketBind( pxClient, &xAddress, sizeof( xAddress ), pdTRUE ) );
+
+    if( xEarlyData != pdFALSE )
+    {
+        TEST_ASSERT_EQUAL( EARLY_DATA_LENGTH, FreeRTOS_send( pxClient, ucEarlyData, EARLY_DATA_LENGTH, 0 ) );
+    }
+}
+
+/* Connect to the server and let the IP-task send the SYN. */
+static void prvClientConnect( uint32_t ulServerIP )
+{
+    struct freertos_sockaddr xAddress;
+
+    xAddress.sin_addr = FreeRTOS_htonl( ulServerIP );
+    xAddress.sin_port = FreeRTOS_htons( SERVER_PORT );
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EWOULDBLOCK, FreeRTOS_connect( pxClient, &xAddress, sizeof( xAddress ) ) );
+
+    ulFramesSent = 0u;
+    ( void ) xTCPSocketCheck( pxClient );
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL_HEX8( TCP_FLAG_SYN, xFrames[ 0 ].ucFlags );
+    TEST_ASSERT_EQUAL( OUR_SEQUENCE_NUMBER, xFrames[ 0 ].ulSequenceNumber );
+}
+
+/* Return the Fast Open option of a sent frame, or NULL when it has none. */
+static const uint8_t * prvFindFastOpenOption( const SentFrame_t * pxFrame )
+{
+    const uint8_t * pucReturn = NULL;
+    size_t uxIndex = 0u;
+
+    while( uxIndex < pxFrame->uxOptionsLength )
+    {
+        if( pxFrame->ucOptions[ uxIndex ] == TCP_OPT_NOOP )
+        {
+            uxIndex++;
+        }
+        else if( pxFrame->ucOptions[ uxIndex ] == TCP_OPT_FASTOPEN )
+        {
+            pucReturn = &( pxFrame->ucOptions[ uxIndex ] );
+            break;
+        }
+        else if( pxFrame->ucOptions[ uxIndex ] == 0u )
+        {
+            break;
+        }
+        else
+        {
+            uxIndex += pxFrame->ucOptions[ uxIndex + 1u ];
+        }
+    }
+
+    return pucReturn;
+}
+
+/* Let the server answer the SYN with a SYN+ACK that acknowledges ulAckNr.
+ * When ucOptionLength is not zero, a Fast Open option of that length is
+ * added, holding the first bytes of ucCookie. */
+static void prvServerSynAck( uint32_t ulServerIP,
+                             uint32_t ulAckNr,
+                             uint8_t ucOptionLength )
+{
+    const size_t uxLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + 40u;
+    NetworkBufferDescriptor_t * pxBuffer;
+    TCPPacket_t * pxPacket;
+    size_t uxOptionsLength = 0u;
+    uint8_t * pucOptions;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( uxLength, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+
+    pxPacket = ( TCPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    memset( pxPacket, 0, uxLength );
+    pucOptions = pxPacket->xTCPHeader.ucOptdata;
+
+    pucOptions[ uxOptionsLength++ ] = TCP_OPT_MSS;
+    pucOptions[ uxOptionsLength++ ] = 4u;
+    pucOptions[ uxOptionsLength++ ] = ( uint8_t ) ( SERVER_MSS >> 8 );
+    pucOptions[ uxOptionsLength++ ] = ( uint8_t ) ( SERVER_MSS & 0xffu );
+
+    if( ucOptionLength != 0u )
+    {
+        /* Align the option with NOP's. */
+        while( ( ( uxOptionsLength + ucOptionLength ) % 4u ) != 0u )
+        {
+            pucOptions[ uxOptionsLength++ ] = TCP_OPT_NOOP;
+        }
+
+        pucOptions[ uxOptionsLength ] = TCP_OPT_FASTOPEN;
+        pucOptions[ uxOptionsLength + 1u ] = ucOptionLength;
+        memcpy( &( pucOptions[ uxOptionsLength + 2u ] ), ucCookie, ( size_t ) ( ucOptionLength - 2u ) );
+        uxOptionsLength += ucOptionLength;
+    }
+
+    pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxPacket->xIPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength );
+    pxPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( ulServerIP );
+    pxPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( SERVER_PORT );
+    pxPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( LOCAL_PORT );
+    pxPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( PEER_SEQUENCE_NUMBER );
+    pxPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( ulAckNr );
+    pxPacket->xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+    pxPacket->xTCPHeader.ucTCPFlags = TCP_FLAG_SYN | TCP_FLAG_ACK;
+    pxPacket->xTCPHeader.usWindow = FreeRTOS_htons( 0x8000u );
+    pxBuffer->xDataLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength;
+
+    ulFramesSent = 0u;
+
+    if( xProcessReceivedTCPPacket( pxBuffer ) != pdPASS )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    }
+}
+
+/* Let a first connection to ulServerIP obtain the cookie. */
+static void prvLearnCookie( uint32_t ulServerIP )
+{
+    prvClientOpen( pdTRUE, pdFALSE );
+    prvClientConnect( ulServerIP );
+    prvServerSynAck( ulServerIP, OUR_SEQUENCE_NUMBER + 1UL, ( uint8_t ) ( 2u + COOKIE_LENGTH ) );
+    TEST_ASSERT_EQUAL( eESTABLISHED, pxClient->u.xTCP.ucTCPState );
+}
+
+/* Open a new connection with early data to ulServerIP, and return the Fast
+ * Open option of its SYN. */
+static const uint8_t * prvEarlyDataSyn( uint32_t ulServerIP )
+{
+    prvClientOpen( pdTRUE, pdTRUE );
+    prvClientConnect( ulServerIP );
+
+    return prvFindFastOpenOption( &( xFrames[ 0 ] ) );
+}
+
+/* ======================== Test functions ================================= */
+
+/* Without a cookie, the SYN asks for one and the data waits for the
+ * handshake. */
+void test_first_syn_requests_cookie( void )
+{
+    const uint8_t * pucOption;
+
+    pucOption = prvEarlyDataSyn( SERVER_IP );
+
+    TEST_ASSERT_NOT_NULL( pucOption );
+    TEST_ASSERT_EQUAL( 2, pucOption[ 1 ] );
+    TEST_ASSERT_EQUAL( 0, ( pucOption - xFrames[ 0 ].ucOptions + 2 ) % 4 );
+    TEST_ASSERT_EQUAL( 0, xFrames[ 0 ].uxDataLength );
+    TEST_ASSERT_EQUAL( 0, pxClient->u.xTCP.ulFastOpenSent );
+    TEST_ASSERT_EQUAL( EARLY_DATA_LENGTH, uxStreamBufferGetSize( pxClient->u.xTCP.txStream ) );
+}
+
+/* A socket without the option sends a plain SYN. */
+void test_no_fast_open_plain_syn( void )
+{
+    prvClientOpen( pdFALSE, pdFALSE );
+
+    /* Data can not be queued before connecting. */
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_ENOTCONN, FreeRTOS_send( pxClient, ucEarlyData, EARLY_DATA_LENGTH, 0 ) );
+
+    prvClientConnect( SERVER_IP );
+    TEST_ASSERT_NULL( prvFindFastOpenOption( &( xFrames[ 0 ] ) ) );
+    TEST_ASSERT_EQUAL( 0, xFrames[ 0 ].uxDataLength );
+}
+
+/* The option can only be set on a closed TCP socket. */
+void test_option_only_before_connect( void )
+{
+    BaseType_t xFastOpen = pdTRUE;
+
+    prvClientOpen( pdFALSE, pdFALSE );
+    prvClientConnect( SERVER_IP );
+
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EINVAL, FreeRTOS_setsockopt( pxClient, 0, FREERTOS_SO_TCP_FASTOPEN, &xFastOpen, sizeof( xFastOpen ) ) );
+    TEST_ASSERT_EQUAL( pdFALSE_UNSIGNED, pxClient->u.xTCP.bits.bFastOpen );
+}
+
+/* The cookie from the SYN+ACK is sent along with the early data in the SYN
+ * of the next connection. */
+void test_cookie_sent_with_early_data( void )
+{
+    const uint8_t * pucOption;
+
+    prvLearnCookie( SERVER_IP );
+    pucOption = prvEarlyDataSyn( SERVER_IP );
+
+    TEST_ASSERT_NOT_NULL( pucOption );
+    TEST_ASSERT_EQUAL( 2u + COOKIE_LENGTH, pucOption[ 1 ] );
+    TEST_ASSERT_EQUAL_MEMORY( ucCookie, pucOption + 2, COOKIE_LENGTH );
+    TEST_ASSERT_EQUAL( EARLY_DATA_LENGTH, xFrames[ 0 ].uxDataLength );
+    TEST_ASSERT_EQUAL_MEMORY( ucEarlyData, xFrames[ 0 ].ucData, EARLY_DATA_LENGTH );
+    TEST_ASSERT_EQUAL( EARLY_DATA_LENGTH, pxClient->u.xTCP.ulFastOpenSent );
+
+    /* The data stays until it has been acknowledged. */
+    TEST_ASSERT_EQUAL( EARLY_DATA_LENGTH, uxStreamBufferGetSize( pxClient->u.xTCP.txStream ) );
+}
+
+/* The cookie belongs to one server. */
+void test_cookie_not_sent_to_other_server( void )
+{
+    const uint8_t * pucOption;
+
+    prvLearnCookie( SERVER_IP );
+    pucOption = prvEarlyDataSyn( SERVER_IP + 1UL );
+
+    TEST_ASSERT_NOT_NULL( pucOption );
+    TEST_ASSERT_EQUAL( 2, pucOption[ 1 ] );
+    TEST_ASSERT_EQUAL( 0, xFrames[ 0 ].uxDataLength );
+}
+
+/* Cookies shorter than 4 or longer than 16 bytes are not stored. */
+void test_invalid_cookie_length_ignored( void )
+{
+    uint8_t ucLength;
+
+    for( ucLength = 2u + 3u; ucLength <= 2u + 17u; ucLength += 14u )
+    {
+        prvClientOpen( pdTRUE, pdFALSE );
+        prvClientConnect( SERVER_IP );
+        prvServerSynAck( SERVER_IP, OUR_SEQUENCE_NUMBER + 1UL, ucLength );
+        TEST_ASSERT_EQUAL( eESTABLISHED, pxClient->u.xTCP.ucTCPState );
+
+        TEST_ASSERT_EQUAL( 2, prvEarlyDataSyn( SERVER_IP )[ 1 ] );
+        TEST_ASSERT_EQUAL( 0, xFrames[ 0 ].uxDataLength );
+    }
+}
+
+/* A cookie is only stored for a socket that asked for it. */
+void test_unsolicited_cookie_ignored( void )
+{
+    prvClientOpen( pdFALSE, pdFALSE );
+    prvClientConnect( SERVER_IP );
+    prvServerSynAck( SERVER_IP, OUR_SEQUENCE_NUMBER + 1UL, ( uint8_t ) ( 2u + COOKIE_LENGTH ) );
+    TEST_ASSERT_EQUAL( eESTABLISHED, pxClient->u.xTCP.ucTCPState );
+
+    TEST_ASSERT_EQUAL( 2, prvEarlyDataSyn( SERVER_IP )[ 1 ] );
+}
+
+/* The early data is limited by the MSS of the previous connection. */
+void test_early_data_limited_by_mss( void )
+{
+    uint8_t ucData[ SERVER_MSS + 100u ];
+    const uint8_t * pucOption;
+    size_t uxOptionsLength;
+
+    memset( ucData, 'x', sizeof( ucData ) );
+    prvLearnCookie( SERVER_IP );
+
+    prvClientOpen( pdTRUE, pdFALSE );
+    TEST_ASSERT_EQUAL( sizeof( ucData ), FreeRTOS_send( pxClient, ucData, sizeof( ucData ), 0 ) );
+    prvClientConnect( SERVER_IP );
+
+    pucOption = prvFindFastOpenOption( &( xFrames[ 0 ] ) );
+    TEST_ASSERT_NOT_NULL( pucOption );
+    uxOptionsLength = xFrames[ 0 ].uxOptionsLength;
+    TEST_ASSERT_EQUAL( SERVER_MSS - uxOptionsLength, pxClient->u.xTCP.ulFastOpenSent );
+}
+
+/* When the server acknowledges the early data, it is removed from txStream
+ * and the sequence numbers skip it. */
+void test_early_data_acknowledged( void )
+{
+    prvLearnCookie( SERVER_IP );
+    ( void ) prvEarlyDataSyn( SERVER_IP );
+
+    prvServerSynAck( SERVER_IP, OUR_SEQUENCE_NUMBER + 1UL + EARLY_DATA_LENGTH, 0u );
+
+    TEST_ASSERT_EQUAL( eESTABLISHED, pxClient->u.xTCP.ucTCPState );
+    TEST_ASSERT_EQUAL( 0, uxStreamBufferGetSize( pxClient->u.xTCP.txStream ) );
+    TEST_ASSERT_EQUAL( 0, pxClient->u.xTCP.ulFastOpenSent );
+    TEST_ASSERT_EQUAL( OUR_SEQUENCE_NUMBER + 1UL + EARLY_DATA_LENGTH, pxClient->u.xTCP.xTCPWindow.tx.ulCurrentSequenceNumber );
+
+    /* The ACK of the SYN+ACK comes after the data. */
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL_HEX8( TCP_FLAG_ACK, xFrames[ 0 ].ucFlags );
+    TEST_ASSERT_EQUAL( OUR_SEQUENCE_NUMBER + 1UL + EARLY_DATA_LENGTH, xFrames[ 0 ].ulSequenceNumber );
+    TEST_ASSERT_EQUAL( PEER_SEQUENCE_NUMBER + 1UL, xFrames[ 0 ].ulAckNr );
+
+    /* The data is not sent again. */
+    ulFramesSent = 0u;
+    ( void ) xTCPSocketCheck( pxClient );
+    TEST_ASSERT_TRUE( ( ulFramesSent == 0u ) || ( xFrames[ 0 ].uxDataLength == 0u ) );
+}
+
+/* When the server only acknowledges the SYN, the data is sent as usual after
+ * the handshake. */
+void test_early_data_not_acknowledged( void )
+{
+    uint32_t ulFrame;
+    BaseType_t xFound = pdFALSE;
+
+    prvLearnCookie( SERVER_IP );
+    ( void ) prvEarlyDataSyn( SERVER_IP );
+
+    prvServerSynAck( SERVER_IP, OUR_SEQUENCE_NUMBER + 1UL, 0u );
+
+    TEST_ASSERT_EQUAL( eESTABLISHED, pxClient->u.xTCP.ucTCPState );
+    TEST_ASSERT_EQUAL( EARLY_DATA_LENGTH, uxStreamBufferGetSize( pxClient->u.xTCP.txStream ) );
+    TEST_ASSERT_EQUAL( 0, pxClient->u.xTCP.ulFastOpenSent );
+
+    ulFramesSent = 0u;
+    ( void ) xTCPSocketCheck( pxClient );
+
+    for( ulFrame = 0u; ( ulFrame < ulFramesSent ) && ( ulFrame < MAX_FRAMES ); ulFrame++ )
+    {
+        if( xFrames[ ulFrame ].uxDataLength != 0u )
+        {
+            TEST_ASSERT_EQUAL( EARLY_DATA_LENGTH, xFrames[ ulFrame ].uxDataLength );
+            TEST_ASSERT_EQUAL( OUR_SEQUENCE_NUMBER + 1UL, xFrames[ ulFrame ].ulSequenceNumber );
+            TEST_ASSERT_EQUAL_MEMORY( ucEarlyData, xFrames[ ulFrame ].ucData, EARLY_DATA_LENGTH );
+            xFound = pdTRUE;
+        }
+    }
+
+    TEST_ASSERT_TRUE( xFound );
+}
+
+/* A repeated SYN is a plain SYN without data. */
+void test_repeated_syn_plain( void )
+{
+    prvLearnCookie( SERVER_IP );
+    ( void ) prvEarlyDataSyn( SERVER_IP );
+
+    ulFramesSent = 0u;
+    ( void ) xTCPSocketCheck( pxClient );
+
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL_HEX8( TCP_FLAG_SYN, xFrames[ 0 ].ucFlags );
+    TEST_ASSERT_NULL( prvFindFastOpenOption( &( xFrames[ 0 ] ) ) );
+    TEST_ASSERT_EQUAL( 0, xFrames[ 0 ].uxDataLength );
+
+    /* The SYN+ACK may still answer the first SYN and acknowledge its data. */
+    TEST_ASSERT_EQUAL( EARLY_DATA_LENGTH, pxClient->u.xTCP.ulFastOpenSent );
+}
+
+/* When the cache is full, the server that was used least recently loses its
+ * cookie. */
+void test_cache_full_replaces_oldest( void )
+{
+    prvLearnCookie( SERVER_IP );
+    xTickCount += 10u;
+    prvLearnCookie( SERVER_IP + 1UL );
+    xTickCount += 10u;
+
+    /* Using the first cookie makes the second one the oldest. */
+    TEST_ASSERT_EQUAL( 2u + COOKIE_LENGTH, prvEarlyDataSyn( SERVER_IP )[ 1 ] );
+    xTickCount += 10u;
+
+    prvLearnCookie( SERVER_IP + 2UL );
+
+    TEST_ASSERT_EQUAL( 2u + COOKIE_LENGTH, prvEarlyDataSyn( SERVER_IP )[ 1 ] );
+    TEST_ASSERT_EQUAL( 2u + COOKIE_LENGTH, prvEarlyDataSyn( SERVER_IP + 2UL )[ 1 ] );
+    TEST_ASSERT_EQUAL( 2, prvEarlyDataSyn( SERVER_IP + 1UL )[ 1 ] );
+}
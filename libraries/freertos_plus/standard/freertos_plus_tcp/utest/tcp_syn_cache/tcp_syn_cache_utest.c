@@ -0,0 +1,622 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+#include "mock_event_groups.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Stream_Buffer.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The sequence number of the SYN of the peer. */
+#define PEER_SEQUENCE_NUMBER     5000UL
+
+/* The initial sequence number of the listening end. */
+#define OUR_SEQUENCE_NUMBER      1000UL
+
+/* The addresses of the connection.  A second connection uses the next port
+ * of the peer. */
+#define LOCAL_PORT               80u
+#define REMOTE_PORT              49152u
+#define REMOTE_IP                0xC0A80002UL
+
+/* The TCP flags, private to FreeRTOS_TCP_IP.c. */
+#define TCP_FLAG_RST             0x04u
+#define TCP_FLAG_SYN             0x02u
+#define TCP_FLAG_ACK             0x10u
+
+/* The period of the time counter of a SYN cookie, private to
+ * FreeRTOS_TCP_IP.c. */
+#define SYN_COOKIE_PERIOD_MS     64000u
+
+/* The number of connections that the listening socket accepts. */
+#define BACKLOG                  2u
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined in FreeRTOS_IP.c, which is not part of
+ * this test. */
+uint16_t usPacketIdentifier;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+
+/* The listening socket. */
+static FreeRTOS_Socket_t xListenSocket;
+
+/* The time returned by xTaskGetTickCount(). */
+static TickType_t xTickCount;
+
+/* The number of frames sent, and the flags, the sequence number and the
+ * acknowledgement number of the last one. */
+static uint32_t ulFramesSent;
+static uint8_t ucLastFlags;
+static uint32_t ulLastSequenceNumber;
+static uint32_t ulLastAckNr;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+static TickType_t prvGetTickCount( int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return xTickCount;
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    const TCPPacket_t * pxTCPPacket = ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+
+    ulFramesSent++;
+    ucLastFlags = pxTCPPacket->xTCPHeader.ucTCPFlags;
+    ulLastSequenceNumber = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber );
+    ulLastAckNr = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulAckNr );
+
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return pdPASS;
+}
+
+/* The other functions of the stack that are called by the sources under
+ * test. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+eARPLookupResult_t eARPGetCacheEntry( uint32_t * pulIPAddress,
+                                      MACAddress_t * const pxMACAddress )
+{
+    ( void ) pulIPAddress;
+    ( void ) pxMACAddress;
+
+    return eARPCacheMiss;
+}
+
+void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
+{
+    ( void ) ulIPAddress;
+}
+
+uint16_t usGenerateChecksum( uint32_t ulSum,
+                             const uint8_t * pucNextData,
+                             size_t uxDataLengthBytes )
+{
+    ( void ) ulSum;
+    ( void ) pucNextData;
+    ( void ) uxDataLengthBytes;
+
+    return 0u;
+}
+
+uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer,
+                                     size_t uxBufferLength,
+                                     BaseType_t xOutgoingPacket )
+{
+    ( void ) pucEthernetBuffer;
+    ( void ) uxBufferLength;
+    ( void ) xOutgoingPacket;
+
+    return 0u;
+}
+
+uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+                                             uint16_t usSourcePort,
+                                             uint32_t ulDestinationAddress,
+                                             uint16_t usDestinationPort )
+{
+    ( void ) ulSourceAddress;
+    ( void ) usSourcePort;
+    ( void ) ulDestinationAddress;
+    ( void ) usDestinationPort;
+
+    return OUR_SEQUENCE_NUMBER;
+}
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+    ( void ) eEvent;
+
+    return pdPASS;
+}
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
+                                     TickType_t uxTimeout )
+{
+    ( void ) pxEvent;
+    ( void ) uxTimeout;
+
+    return pdPASS;
+}
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t FreeRTOS_IsNetworkUp( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t xIPIsNetworkTaskReady( void )
+{
+    return pdTRUE;
+}
+
+NetworkBufferDescriptor_t * pxUDPPayloadBuffer_to_NetworkBuffer( void * pvBuffer )
+{
+    ( void ) pvBuffer;
+
+    return NULL;
+}
+
+/* The key of the SYN cookies. */
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber )
+{
+    *pulNumber = 0x5EC2E7UL;
+
+    return pdPASS;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    struct freertos_sockaddr xAddress;
+
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    xEventGroupCreate_IgnoreAndReturn( ( EventGroupHandle_t ) &xListenSocket );
+    vEventGroupDelete_Ignore();
+    xEventGroupSetBits_IgnoreAndReturn( 0 );
+    xQueueCreateCountingSemaphore_IgnoreAndReturn( ( QueueHandle_t ) &xListenSocket );
+    xQueueSemaphoreTake_IgnoreAndReturn( pdPASS );
+    xQueueGenericSend_IgnoreAndReturn( pdPASS );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_Stub( prvGetTickCount );
+
+    /* Only the first call initialises the buffers. */
+    TEST_ASSERT_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+    vNetworkSocketsInit();
+    TEST_FreeRTOS_TCP_vSynCacheClear();
+
+    xTickCount = 0u;
+    ulFramesSent = 0u;
+    ucLastFlags = 0u;
+    ulLastSequenceNumber = 0u;
+    ulLastAckNr = 0u;
+
+    memset( &xListenSocket, 0, sizeof( xListenSocket ) );
+    xListenSocket.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_TCP;
+    xListenSocket.xEventGroup = ( EventGroupHandle_t ) &xListenSocket;
+    vListInitialiseItem( &( xListenSocket.xBoundSocketListItem ) );
+    listSET_LIST_ITEM_OWNER( &( xListenSocket.xBoundSocketListItem ), ( void * ) &xListenSocket );
+    xAddress.sin_port = FreeRTOS_htons( LOCAL_PORT );
+    TEST_ASSERT_EQUAL( 0, vSocketBind( &xListenSocket, &xAddress, sizeof( xAddress ), pdTRUE ) );
+
+    xListenSocket.u.xTCP.ucTCPState = ( uint8_t ) eTCP_LISTEN;
+    xListenSocket.u.xTCP.usBacklog = BACKLOG;
+    xListenSocket.u.xTCP.uxRxWinSize = 4u;
+    xListenSocket.u.xTCP.uxTxWinSize = 4u;
+    xListenSocket.u.xTCP.uxRxStreamSize = 4u * ipconfigTCP_MSS;
+    xListenSocket.u.xTCP.uxTxStreamSize = 4u * ipconfigTCP_MSS;
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    FreeRTOS_Socket_t * pxChild;
+
+    /* Close the sockets that were created for the handshakes. */
+    while( xListenSocket.u.xTCP.usChildCount > 0u )
+    {
+        pxChild = NULL;
+
+        if( listCURRENT_LIST_LENGTH( &xBoundTCPSocketsList ) > 1u )
+        {
+            pxChild = ( FreeRTOS_Socket_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xBoundTCPSocketsList );
+
+            if( pxChild == &xListenSocket )
+            {
+                pxChild = ( FreeRTOS_Socket_t * ) listGET_LIST_ITEM_OWNER( listGET_NEXT( listGET_HEAD_ENTRY( &xBoundTCPSocketsList ) ) );
+            }
+        }
+
+        TEST_ASSERT_NOT_NULL( pxChild );
+        ( void ) vSocketClose( pxChild );
+    }
+
+    /* Every test returns all network buffers. */
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Fill in the headers of a segment from the peer, with an MSS option when it
+ * is a SYN. */
+static void prvFillSegment( TCPPacket_t * pxPacket,
+                            uint16_t usRemotePort,
+                            uint8_t ucFlags,
+                            uint32_t ulSequenceNumber,
+                            uint32_t ulAckNr )
+{
+    size_t uxOptionsLength = ( ( ucFlags & TCP_FLAG_SYN ) != 0u ) ? 4u : 0u;
+
+    memset( pxPacket, 0, sizeof( *pxPacket ) );
+    pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxPacket->xIPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + uxOptionsLength );
+    pxPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( REMOTE_IP );
+    pxPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( usRemotePort );
+    pxPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( LOCAL_PORT );
+    pxPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( ulSequenceNumber );
+    pxPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( ulAckNr );
+    pxPacket->xTCPHeader.ucTCPOffset = ( uint8_t ) ( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+    pxPacket->xTCPHeader.ucTCPFlags = ucFlags;
+    pxPacket->xTCPHeader.usWindow = FreeRTOS_htons( 0x8000u );
+
+    if( uxOptionsLength != 0u )
+    {
+        pxPacket->xTCPHeader.ucOptdata[ 0 ] = 2u; /* MSS */
+        pxPacket->xTCPHeader.ucOptdata[ 1 ] = 4u;
+        pxPacket->xTCPHeader.ucOptdata[ 2 ] = ( uint8_t ) ( ipconfigTCP_MSS >> 8 );
+        pxPacket->xTCPHeader.ucOptdata[ 3 ] = ( uint8_t ) ( ipconfigTCP_MSS & 0xffu );
+    }
+}
+
+/* Let TCP handle a segment from the peer. */
+static void prvReceiveSegment( uint16_t usRemotePort,
+                               uint8_t ucFlags,
+                               uint32_t ulSequenceNumber,
+                               uint32_t ulAckNr )
+{
+    const size_t uxLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + 4u;
+    NetworkBufferDescriptor_t * pxBuffer;
+    TCPPacket_t * pxPacket;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( uxLength, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+
+    pxPacket = ( TCPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    prvFillSegment( pxPacket, usRemotePort, ucFlags, ulSequenceNumber, ulAckNr );
+    pxBuffer->xDataLength = ipSIZE_OF_ETH_HEADER + FreeRTOS_ntohs( pxPacket->xIPHeader.usLength );
+
+    if( xProcessReceivedTCPPacket( pxBuffer ) != pdPASS )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    }
+}
+
+/* Send a SYN and check that it is answered with a SYN+ACK.  Returns the
+ * initial sequence number of the listening end. */
+static uint32_t prvHandshakeStart( uint16_t usRemotePort )
+{
+    ulFramesSent = 0u;
+    prvReceiveSegment( usRemotePort, TCP_FLAG_SYN, PEER_SEQUENCE_NUMBER, 0UL );
+
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL_HEX8( TCP_FLAG_SYN | TCP_FLAG_ACK, ucLastFlags );
+    TEST_ASSERT_EQUAL( PEER_SEQUENCE_NUMBER + 1UL, ulLastAckNr );
+
+    return ulLastSequenceNumber;
+}
+
+/* Send the ACK that completes the handshake. */
+static void prvHandshakeComplete( uint16_t usRemotePort,
+                                  uint32_t ulOurSequenceNumber )
+{
+    ulFramesSent = 0u;
+    ucLastFlags = 0u;
+    prvReceiveSegment( usRemotePort, TCP_FLAG_ACK, PEER_SEQUENCE_NUMBER + 1UL, ulOurSequenceNumber + 1UL );
+}
+
+/* Return the socket that handles the connection from usRemotePort, or NULL
+ * when there is none. */
+static FreeRTOS_Socket_t * prvFindConnection( uint16_t usRemotePort )
+{
+    FreeRTOS_Socket_t * pxSocket;
+
+    pxSocket = pxTCPSocketLookup( 0UL, LOCAL_PORT, REMOTE_IP, usRemotePort );
+
+    if( pxSocket == &xListenSocket )
+    {
+        pxSocket = NULL;
+    }
+
+    return pxSocket;
+}
+
+/* ======================== Test functions ================================= */
+
+/* A SYN is answered without creating a socket. */
+void test_syn_answered_from_cache( void )
+{
+    TEST_ASSERT_EQUAL( OUR_SEQUENCE_NUMBER, prvHandshakeStart( REMOTE_PORT ) );
+
+    TEST_ASSERT_EQUAL( 0, xListenSocket.u.xTCP.usChildCount );
+    TEST_ASSERT_NULL( prvFindConnection( REMOTE_PORT ) );
+}
+
+/* The ACK that completes the handshake creates the socket. */
+void test_ack_creates_socket( void )
+{
+    FreeRTOS_Socket_t * pxChild;
+    uint32_t ulOurSequenceNumber;
+
+    ulOurSequenceNumber = prvHandshakeStart( REMOTE_PORT );
+    prvHandshakeComplete( REMOTE_PORT, ulOurSequenceNumber );
+
+    pxChild = prvFindConnection( REMOTE_PORT );
+    TEST_ASSERT_NOT_NULL( pxChild );
+    TEST_ASSERT_EQUAL( eESTABLISHED, pxChild->u.xTCP.ucTCPState );
+    TEST_ASSERT_EQUAL( 1, xListenSocket.u.xTCP.usChildCount );
+    TEST_ASSERT_EQUAL( PEER_SEQUENCE_NUMBER + 1UL, pxChild->u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber );
+    TEST_ASSERT_EQUAL( 0, ulFramesSent );
+}
+
+/* A retransmitted SYN gets the same SYN+ACK. */
+void test_retransmitted_syn_same_answer( void )
+{
+    uint32_t ulOurSequenceNumber;
+
+    ulOurSequenceNumber = prvHandshakeStart( REMOTE_PORT );
+    xTickCount += pdMS_TO_TICKS( 1000u );
+
+    TEST_ASSERT_EQUAL( ulOurSequenceNumber, prvHandshakeStart( REMOTE_PORT ) );
+    TEST_ASSERT_EQUAL( 0, xListenSocket.u.xTCP.usChildCount );
+}
+
+/* An ACK that comes after the entry has expired doesn't match it: it gets a
+ * RST and no socket is created. */
+void test_expired_entry_not_matched( void )
+{
+    uint32_t ulOurSequenceNumber;
+
+    ulOurSequenceNumber = prvHandshakeStart( REMOTE_PORT );
+
+    /* Just in time. */
+    xTickCount += pdMS_TO_TICKS( ipconfigTCP_SYN_CACHE_TIMEOUT_MS ) - 1u;
+    TEST_ASSERT_EQUAL( ulOurSequenceNumber, prvHandshakeStart( REMOTE_PORT ) );
+
+    /* The retransmission did not refresh the entry. */
+    xTickCount += 1u;
+    prvHandshakeComplete( REMOTE_PORT, ulOurSequenceNumber );
+
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL_HEX8( TCP_FLAG_RST, ucLastFlags & TCP_FLAG_RST );
+    TEST_ASSERT_NULL( prvFindConnection( REMOTE_PORT ) );
+    TEST_ASSERT_EQUAL( 0, xListenSocket.u.xTCP.usChildCount );
+}
+
+/* An expired entry is free for a new SYN. */
+void test_expired_entry_reused( void )
+{
+    FreeRTOS_Socket_t * pxChild;
+    uint32_t ulOurSequenceNumber;
+
+    ( void ) prvHandshakeStart( REMOTE_PORT );
+    ( void ) prvHandshakeStart( REMOTE_PORT + 1u );
+    xTickCount += pdMS_TO_TICKS( ipconfigTCP_SYN_CACHE_TIMEOUT_MS );
+
+    /* The cache is full of expired entries, the third SYN gets an entry and
+     * not a cookie: the sequence number is not a cookie. */
+    ulOurSequenceNumber = prvHandshakeStart( REMOTE_PORT + 2u );
+    TEST_ASSERT_EQUAL( OUR_SEQUENCE_NUMBER, ulOurSequenceNumber );
+
+    prvHandshakeComplete( REMOTE_PORT + 2u, ulOurSequenceNumber );
+    pxChild = prvFindConnection( REMOTE_PORT + 2u );
+    TEST_ASSERT_NOT_NULL( pxChild );
+}
+
+/* When the backlog is full, a SYN gets a RST. */
+void test_backlog_full_syn_reset( void )
+{
+    xListenSocket.u.xTCP.usChildCount = BACKLOG;
+
+    prvReceiveSegment( REMOTE_PORT, TCP_FLAG_SYN, PEER_SEQUENCE_NUMBER, 0UL );
+
+    TEST_ASSERT_EQUAL( 1, ulFramesSent );
+    TEST_ASSERT_EQUAL_HEX8( TCP_FLAG_RST, ucLastFlags & TCP_FLAG_RST );
+
+    xListenSocket.u.xTCP.usChildCount = 0u;
+}
+
+/* When the backlog has become full after the SYN was answered, the ACK does
+ * not create a socket. */
+void test_backlog_full_ack_no_socket( void )
+{
+    uint32_t ulOurSequenceNumber[ BACKLOG + 1u ];
+    UBaseType_t uxIndex;
+
+    /* The cache holds two entries, the third connection uses a cookie. */
+    for( uxIndex = 0u; uxIndex <= BACKLOG; uxIndex++ )
+    {
+        ulOurSequenceNumber[ uxIndex ] = prvHandshakeStart( REMOTE_PORT + uxIndex );
+    }
+
+    for( uxIndex = 0u; uxIndex < BACKLOG; uxIndex++ )
+    {
+        prvHandshakeComplete( REMOTE_PORT + uxIndex, ulOurSequenceNumber[ uxIndex ] );
+        TEST_ASSERT_NOT_NULL( prvFindConnection( REMOTE_PORT + uxIndex ) );
+    }
+
+    TEST_ASSERT_EQUAL( BACKLOG, xListenSocket.u.xTCP.usChildCount );
+
+    prvHandshakeComplete( REMOTE_PORT + BACKLOG, ulOurSequenceNumber[ BACKLOG ] );
+
+    TEST_ASSERT_NULL( prvFindConnection( REMOTE_PORT + BACKLOG ) );
+    TEST_ASSERT_EQUAL( BACKLOG, xListenSocket.u.xTCP.usChildCount );
+    TEST_ASSERT_EQUAL_HEX8( TCP_FLAG_RST, ucLastFlags & TCP_FLAG_RST );
+}
+
+/* When the cache is full, the connection is encoded in a SYN cookie, and the
+ * ACK that returns it creates the socket. */
+void test_cookie_when_cache_full( void )
+{
+    FreeRTOS_Socket_t * pxChild;
+    uint32_t ulCookie;
+
+    ( void ) prvHandshakeStart( REMOTE_PORT );
+    ( void ) prvHandshakeStart( REMOTE_PORT + 1u );
+
+    ulCookie = prvHandshakeStart( REMOTE_PORT + 2u );
+    TEST_ASSERT_NOT_EQUAL( OUR_SEQUENCE_NUMBER, ulCookie );
+
+    /* A wrong cookie is refused. */
+    prvHandshakeComplete( REMOTE_PORT + 2u, ulCookie + 1u );
+    TEST_ASSERT_EQUAL_HEX8( TCP_FLAG_RST, ucLastFlags & TCP_FLAG_RST );
+    TEST_ASSERT_NULL( prvFindConnection( REMOTE_PORT + 2u ) );
+
+    prvHandshakeComplete( REMOTE_PORT + 2u, ulCookie );
+    pxChild = prvFindConnection( REMOTE_PORT + 2u );
+    TEST_ASSERT_NOT_NULL( pxChild );
+    TEST_ASSERT_EQUAL( eESTABLISHED, pxChild->u.xTCP.ucTCPState );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, pxChild->u.xTCP.usCurMSS );
+}
+
+/* A cookie encodes the largest MSS that is not larger than the given MSS, and
+ * it is verified by the ACK of the same connection only. */
+void test_cookie_encode_verify( void )
+{
+    TCPPacket_t xPacket;
+    uint32_t ulCookie;
+    uint16_t usMSS;
+
+    prvFillSegment( &xPacket, REMOTE_PORT, TCP_FLAG_SYN, PEER_SEQUENCE_NUMBER, 0UL );
+    usMSS = 1000u;
+    ulCookie = TEST_FreeRTOS_TCP_prvSynCookieCreate( &xPacket, &usMSS );
+    TEST_ASSERT_EQUAL( 536u, usMSS );
+
+    /* The ACK of the connection. */
+    prvFillSegment( &xPacket, REMOTE_PORT, TCP_FLAG_ACK, PEER_SEQUENCE_NUMBER + 1UL, ulCookie + 1UL );
+    usMSS = 0u;
+    TEST_ASSERT_EQUAL( pdTRUE, TEST_FreeRTOS_TCP_prvSynCookieCheck( &xPacket, &usMSS ) );
+    TEST_ASSERT_EQUAL( 536u, usMSS );
+
+    /* An ACK from another port, or for another SYN, is refused. */
+    prvFillSegment( &xPacket, REMOTE_PORT + 1u, TCP_FLAG_ACK, PEER_SEQUENCE_NUMBER + 1UL, ulCookie + 1UL );
+    TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvSynCookieCheck( &xPacket, &usMSS ) );
+    prvFillSegment( &xPacket, REMOTE_PORT, TCP_FLAG_ACK, PEER_SEQUENCE_NUMBER + 2UL, ulCookie + 1UL );
+    TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvSynCookieCheck( &xPacket, &usMSS ) );
+
+    /* A MSS of the table is kept. */
+    prvFillSegment( &xPacket, REMOTE_PORT, TCP_FLAG_SYN, PEER_SEQUENCE_NUMBER, 0UL );
+    usMSS = 1400u;
+    ( void ) TEST_FreeRTOS_TCP_prvSynCookieCreate( &xPacket, &usMSS );
+    TEST_ASSERT_EQUAL( 1400u, usMSS );
+}
+
+/* A cookie is accepted in the period in which it was created and the next
+ * one. */
+void test_cookie_expires( void )
+{
+    TCPPacket_t xPacket;
+    uint32_t ulCookie;
+    uint16_t usMSS = ipconfigTCP_MSS;
+
+    xTickCount = pdMS_TO_TICKS( SYN_COOKIE_PERIOD_MS ) - 1u;
+    prvFillSegment( &xPacket, REMOTE_PORT, TCP_FLAG_SYN, PEER_SEQUENCE_NUMBER, 0UL );
+    ulCookie = TEST_FreeRTOS_TCP_prvSynCookieCreate( &xPacket, &usMSS );
+
+    prvFillSegment( &xPacket, REMOTE_PORT, TCP_FLAG_ACK, PEER_SEQUENCE_NUMBER + 1UL, ulCookie + 1UL );
+
+    xTickCount += pdMS_TO_TICKS( SYN_COOKIE_PERIOD_MS );
+    TEST_ASSERT_EQUAL( pdTRUE, TEST_FreeRTOS_TCP_prvSynCookieCheck( &xPacket, &usMSS ) );
+
+    xTickCount += 1u;
+    TEST_ASSERT_EQUAL( pdFALSE, TEST_FreeRTOS_TCP_prvSynCookieCheck( &xPacket, &usMSS ) );
+}
@@ -0,0 +1,415 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_TCP_WIN.h"
+
+/* The MSS used by the connection. */
+#define TEST_MSS                 1460u
+
+/* The self-imposed transmission window, large enough to never limit the
+ * congestion window in these tests. */
+#define TX_WINDOW_LENGTH         ( 32u * TEST_MSS )
+
+/* Our sequence number before the first byte of TX data. */
+#define OUR_SEQUENCE_NUMBER      1000UL
+
+/* The sequence number of the n-th segment of size TEST_MSS. */
+#define SEGMENT_SEQUENCE( n )    ( OUR_SEQUENCE_NUMBER + ( ( uint32_t ) ( n ) * TEST_MSS ) )
+
+/* The length of the circular TX stream, only used to calculate positions. */
+#define TX_STREAM_LENGTH         65536
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* The window under test. */
+static TCPWindow_t xWindow;
+
+/* The time as returned by xTaskGetTickCount(). */
+static TickType_t xTickCount;
+
+/* The position in the TX stream where the next data will be added. */
+static int32_t lTxPosition;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+static TickType_t prvGetTickCount( int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return xTickCount;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_Stub( prvGetTickCount );
+
+    xTickCount = 0u;
+    lTxPosition = 0;
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    vTCPWindowDestroy( &xWindow );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Create the window of a connection that has just been established, using
+ * the algorithm 'ucAlgorithm'. */
+static void prvCreateWindow( uint32_t ulMSS,
+                             uint8_t ucAlgorithm )
+{
+    memset( &xWindow, 0, sizeof( xWindow ) );
+
+    if( ucAlgorithm != 0u )
+    {
+        TEST_ASSERT_EQUAL( pdTRUE, xTCPWindowSetCongestionControl( &xWindow, ucAlgorithm ) );
+    }
+
+    vTCPWindowCreate( &xWindow, TX_WINDOW_LENGTH, TX_WINDOW_LENGTH, 5000UL, OUR_SEQUENCE_NUMBER, ulMSS );
+    vTCPWindowCongestionStart( &xWindow );
+}
+
+/* Add 'uxCount' full-size segments to the window. */
+static void prvAddSegments( size_t uxCount )
+{
+    int32_t lLength = ( int32_t ) ( uxCount * xWindow.usMSS );
+
+    TEST_ASSERT_EQUAL( lLength, lTCPWindowTxAdd( &xWindow, ( uint32_t ) lLength, lTxPosition, TX_STREAM_LENGTH ) );
+    lTxPosition = ( lTxPosition + lLength ) % TX_STREAM_LENGTH;
+}
+
+/* Send as many segments as the windows allow, return the number sent. */
+static size_t prvSendSegments( void )
+{
+    int32_t lPosition;
+    size_t uxCount = 0u;
+
+    while( ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) != 0UL )
+    {
+        uxCount++;
+    }
+
+    return uxCount;
+}
+
+/* The peer received segment 0, but not segments 1 to 'uxLast'.  It sends
+ * three duplicate ACKs with a growing SACK block. */
+static void prvReceiveDuplicateAcks( size_t uxLast )
+{
+    size_t uxIndex;
+
+    for( uxIndex = 0u; uxIndex < 3u; uxIndex++ )
+    {
+        ( void ) ulTCPWindowTxSack( &xWindow,
+                                    SEGMENT_SEQUENCE( 1 ),
+                                    SEGMENT_SEQUENCE( FreeRTOS_min_uint32( 2u + uxIndex, uxLast ) ) );
+    }
+}
+
+/* ======================== Test functions ================================= */
+
+/* The initial window follows RFC 3390: min( 4 * MSS, max( 2 * MSS, 4380 ) ). */
+void test_initial_window( void )
+{
+    prvCreateWindow( TEST_MSS, 0u );
+    TEST_ASSERT_EQUAL_UINT32( 3u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+    TEST_ASSERT_EQUAL_UINT32( 0xFFFFFFFFUL, xWindow.xCongestion.ulSSThresh );
+    vTCPWindowDestroy( &xWindow );
+
+    prvCreateWindow( 536u, 0u );
+    TEST_ASSERT_EQUAL_UINT32( 4u * 536u, xWindow.xCongestion.ulCWnd );
+    vTCPWindowDestroy( &xWindow );
+
+    prvCreateWindow( 4000u, 0u );
+    TEST_ASSERT_EQUAL_UINT32( 2u * 4000u, xWindow.xCongestion.ulCWnd );
+}
+
+/* An unknown algorithm is refused, the current choice is kept. */
+void test_unknown_algorithm_refused( void )
+{
+    prvCreateWindow( TEST_MSS, FREERTOS_TCP_CC_CUBIC );
+
+    TEST_ASSERT_EQUAL( pdFALSE, xTCPWindowSetCongestionControl( &xWindow, 99u ) );
+    TEST_ASSERT_EQUAL( FREERTOS_TCP_CC_CUBIC, xWindow.xCongestion.ucAlgorithm );
+    TEST_ASSERT_EQUAL_STRING( "CUBIC", xWindow.xCongestion.pxOps->pcName );
+}
+
+/* No more than cwnd bytes may be outstanding. */
+void test_cwnd_limits_flight( void )
+{
+    prvCreateWindow( TEST_MSS, 0u );
+    prvAddSegments( 10u );
+
+    TEST_ASSERT_EQUAL( 3u, prvSendSegments() );
+}
+
+/* During slow start, cwnd grows with the number of bytes ACK'd, but with at
+ * most 2 * MSS per ACK. */
+void test_slow_start_growth( void )
+{
+    prvCreateWindow( TEST_MSS, 0u );
+    prvAddSegments( 10u );
+    TEST_ASSERT_EQUAL( 3u, prvSendSegments() );
+
+    /* One ACK for a single segment. */
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 1 ) ) );
+    TEST_ASSERT_EQUAL_UINT32( 4u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+
+    /* One ACK for two segments. */
+    TEST_ASSERT_EQUAL_UINT32( 2u * TEST_MSS, ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 3 ) ) );
+    TEST_ASSERT_EQUAL_UINT32( 6u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+
+    /* The window allows 6 segments now. */
+    TEST_ASSERT_EQUAL( 6u, prvSendSegments() );
+
+    /* An ACK for 6 segments adds no more than 2 * MSS. */
+    TEST_ASSERT_EQUAL_UINT32( 6u * TEST_MSS, ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 9 ) ) );
+    TEST_ASSERT_EQUAL_UINT32( 8u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+}
+
+/* Above ssthresh, NewReno grows with 1 MSS per window that is ACK'd. */
+void test_newreno_congestion_avoidance( void )
+{
+    prvCreateWindow( TEST_MSS, FREERTOS_TCP_CC_NEWRENO );
+    xWindow.xCongestion.ulSSThresh = xWindow.xCongestion.ulCWnd;
+    prvAddSegments( 10u );
+    TEST_ASSERT_EQUAL( 3u, prvSendSegments() );
+
+    /* Two thirds of the window: no growth yet. */
+    ( void ) ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 2 ) );
+    TEST_ASSERT_EQUAL_UINT32( 3u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+
+    /* The whole window has been ACK'd. */
+    ( void ) ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 3 ) );
+    TEST_ASSERT_EQUAL_UINT32( 4u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+}
+
+/* The cwnd never grows beyond the self-imposed transmission window. */
+void test_cwnd_capped_by_tx_window( void )
+{
+    prvCreateWindow( TEST_MSS, 0u );
+    xWindow.xSize.ulTxWindowLength = 4u * TEST_MSS;
+    prvAddSegments( 10u );
+    TEST_ASSERT_EQUAL( 3u, prvSendSegments() );
+
+    ( void ) ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 3 ) );
+    TEST_ASSERT_EQUAL_UINT32( 4u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+}
+
+/* After three duplicate ACKs, NewReno halves the flight size and enters
+ * fast recovery, which ends when all data outstanding at the time of the
+ * loss has been ACK'd. */
+void test_newreno_fast_retransmit( void )
+{
+    int32_t lPosition;
+
+    prvCreateWindow( TEST_MSS, FREERTOS_TCP_CC_NEWRENO );
+    xWindow.xCongestion.ulCWnd = 8u * TEST_MSS;
+    prvAddSegments( 8u );
+    TEST_ASSERT_EQUAL( 8u, prvSendSegments() );
+
+    prvReceiveDuplicateAcks( 8u );
+
+    /* ssthresh = max( FlightSize / 2, 2 * MSS ) */
+    TEST_ASSERT_EQUAL_UINT32( 4u * TEST_MSS, xWindow.xCongestion.ulSSThresh );
+    TEST_ASSERT_EQUAL_UINT32( 4u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+    TEST_ASSERT_EQUAL( pdTRUE_UNSIGNED, xWindow.xCongestion.u.bits.bInRecovery );
+    TEST_ASSERT_EQUAL_UINT32( SEGMENT_SEQUENCE( 8 ), xWindow.xCongestion.ulRecoverSequenceNumber );
+
+    /* The missing segment is sent at once, no matter cwnd. */
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+    TEST_ASSERT_EQUAL_UINT32( 1UL, xWindow.ulRetransmitCount );
+
+    /* More duplicate ACKs for the same window do not reduce it again. */
+    prvReceiveDuplicateAcks( 8u );
+    TEST_ASSERT_EQUAL_UINT32( 4u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+
+    /* A partial ACK does not end the recovery. */
+    ( void ) ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 1 ) );
+    TEST_ASSERT_EQUAL( pdTRUE_UNSIGNED, xWindow.xCongestion.u.bits.bInRecovery );
+    TEST_ASSERT_EQUAL_UINT32( 4u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+
+    /* The full ACK does. */
+    ( void ) ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 8 ) );
+    TEST_ASSERT_EQUAL( pdFALSE_UNSIGNED, xWindow.xCongestion.u.bits.bInRecovery );
+    TEST_ASSERT_EQUAL_UINT32( 4u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+}
+
+/* CUBIC reduces cwnd to 0.7 times its size and remembers W_max. */
+void test_cubic_fast_retransmit( void )
+{
+    prvCreateWindow( TEST_MSS, FREERTOS_TCP_CC_CUBIC );
+    xWindow.xCongestion.ulCWnd = 20u * TEST_MSS;
+    prvAddSegments( 8u );
+    TEST_ASSERT_EQUAL( 8u, prvSendSegments() );
+
+    prvReceiveDuplicateAcks( 8u );
+
+    TEST_ASSERT_EQUAL_UINT32( 14u * TEST_MSS, xWindow.xCongestion.ulSSThresh );
+    TEST_ASSERT_EQUAL_UINT32( 14u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+    TEST_ASSERT_EQUAL_UINT32( 20u * TEST_MSS, xWindow.xCongestion.ulWMax );
+    TEST_ASSERT_EQUAL( pdTRUE_UNSIGNED, xWindow.xCongestion.u.bits.bInRecovery );
+}
+
+/* When CUBIC loses again before W_max was reached, fast convergence lowers
+ * W_max to ( 1 + beta ) / 2 times cwnd. */
+void test_cubic_fast_convergence( void )
+{
+    prvCreateWindow( TEST_MSS, FREERTOS_TCP_CC_CUBIC );
+    xWindow.xCongestion.ulCWnd = 20u * TEST_MSS;
+    xWindow.xCongestion.ulWMax = 40u * TEST_MSS;
+    prvAddSegments( 8u );
+    TEST_ASSERT_EQUAL( 8u, prvSendSegments() );
+
+    prvReceiveDuplicateAcks( 8u );
+
+    TEST_ASSERT_EQUAL_UINT32( 17u * TEST_MSS, xWindow.xCongestion.ulWMax );
+    TEST_ASSERT_EQUAL_UINT32( 14u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+}
+
+/* A retransmission time-out brings cwnd back to 1 MSS and ends a fast
+ * recovery. */
+void test_rto_collapses_window( void )
+{
+    int32_t lPosition;
+
+    prvCreateWindow( TEST_MSS, FREERTOS_TCP_CC_NEWRENO );
+    xWindow.xCongestion.ulCWnd = 8u * TEST_MSS;
+    prvAddSegments( 8u );
+    TEST_ASSERT_EQUAL( 8u, prvSendSegments() );
+
+    /* Nothing happens before the RTO expires. */
+    xTickCount = pdMS_TO_TICKS( 500u );
+    TEST_ASSERT_EQUAL_UINT32( 0UL, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+    TEST_ASSERT_EQUAL_UINT32( 8u * TEST_MSS, xWindow.xCongestion.ulCWnd );
+
+    xTickCount = pdMS_TO_TICKS( 5000u );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+    TEST_ASSERT_EQUAL_UINT32( SEGMENT_SEQUENCE( 0 ), xWindow.ulOurSequenceNumber );
+
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, xWindow.xCongestion.ulCWnd );
+    TEST_ASSERT_EQUAL_UINT32( 4u * TEST_MSS, xWindow.xCongestion.ulSSThresh );
+    TEST_ASSERT_EQUAL( pdFALSE_UNSIGNED, xWindow.xCongestion.u.bits.bInRecovery );
+
+    /* The next expired segment does not reduce the window again. */
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+    TEST_ASSERT_EQUAL_UINT32( 4u * TEST_MSS, xWindow.xCongestion.ulSSThresh );
+}
+
+/* With pacing, new segments are spread over the RTT: at twice the rate of
+ * cwnd / SRTT during slow start. */
+void test_pacing_delay( void )
+{
+    TickType_t xDelay;
+    int32_t lPosition;
+    uint32_t ulInterval;
+
+    prvCreateWindow( TEST_MSS, 0u );
+    xWindow.xCongestion.u.bits.bPacing = pdTRUE_UNSIGNED;
+    prvAddSegments( 3u );
+
+    ulInterval = ( TEST_MSS * ( uint32_t ) xWindow.lSRTT * 100u ) / ( xWindow.xCongestion.ulCWnd * 200u );
+    TEST_ASSERT_GREATER_THAN( 0u, ulInterval );
+
+    /* The pace timer was started when the window was created. */
+    TEST_ASSERT_EQUAL( pdTRUE, xTCPWindowTxHasData( &xWindow, 0xFFFFFFFFUL, &xDelay ) );
+    TEST_ASSERT_EQUAL( ulInterval, xDelay );
+    TEST_ASSERT_EQUAL_UINT32( 0UL, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+
+    xTickCount = pdMS_TO_TICKS( ulInterval );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+
+    /* The next segment has to wait again, the IP-task is asked to wake up in
+     * time. */
+    TEST_ASSERT_EQUAL_UINT32( 0UL, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+    TEST_ASSERT_EQUAL( pdTRUE, xTCPWindowTxHasData( &xWindow, 0xFFFFFFFFUL, &xDelay ) );
+    TEST_ASSERT_EQUAL( ulInterval, xDelay );
+
+    xTickCount += pdMS_TO_TICKS( ulInterval );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+}
+
+/* Without pacing, the whole window is sent at once. */
+void test_no_pacing_sends_burst( void )
+{
+    TickType_t xDelay;
+
+    prvCreateWindow( TEST_MSS, 0u );
+    prvAddSegments( 3u );
+
+    TEST_ASSERT_EQUAL( pdTRUE, xTCPWindowTxHasData( &xWindow, 0xFFFFFFFFUL, &xDelay ) );
+    TEST_ASSERT_EQUAL( 0u, xDelay );
+    TEST_ASSERT_EQUAL( 3u, prvSendSegments() );
+}
@@ -0,0 +1,283 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_TCP_WIN.h"
+
+/* The MSS used by the connection. */
+#define TEST_MSS                 1460u
+
+/* The self-imposed transmission window. */
+#define TX_WINDOW_LENGTH         ( 32u * TEST_MSS )
+
+/* Our sequence number before the first byte of TX data. */
+#define OUR_SEQUENCE_NUMBER      1000UL
+
+/* The sequence number of the n-th segment of size TEST_MSS. */
+#define SEGMENT_SEQUENCE( n )    ( OUR_SEQUENCE_NUMBER + ( ( uint32_t ) ( n ) * TEST_MSS ) )
+
+/* The length of the circular TX stream, only used to calculate positions. */
+#define TX_STREAM_LENGTH         65536
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* The window under test. */
+static TCPWindow_t xWindow;
+
+/* The time as returned by xTaskGetTickCount(). */
+static TickType_t xTickCount;
+
+/* The position in the TX stream where the next data will be added. */
+static int32_t lTxPosition;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+static TickType_t prvGetTickCount( int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return xTickCount;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_Stub( prvGetTickCount );
+
+    xTickCount = 0u;
+    lTxPosition = 0;
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    vTCPWindowDestroy( &xWindow );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Create the window of a connection that has just been established. */
+static void prvCreateWindow( void )
+{
+    memset( &xWindow, 0, sizeof( xWindow ) );
+    vTCPWindowCreate( &xWindow, TX_WINDOW_LENGTH, TX_WINDOW_LENGTH, 5000UL, OUR_SEQUENCE_NUMBER, TEST_MSS );
+}
+
+/* Add 'uxCount' full-size segments to the window. */
+static void prvAddSegments( size_t uxCount )
+{
+    int32_t lLength = ( int32_t ) ( uxCount * xWindow.usMSS );
+
+    TEST_ASSERT_EQUAL( lLength, lTCPWindowTxAdd( &xWindow, ( uint32_t ) lLength, lTxPosition, TX_STREAM_LENGTH ) );
+    lTxPosition = ( lTxPosition + lLength ) % TX_STREAM_LENGTH;
+}
+
+/* Send as many segments as the windows allow, return the number sent. */
+static size_t prvSendSegments( void )
+{
+    int32_t lPosition;
+    size_t uxCount = 0u;
+
+    while( ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) != 0UL )
+    {
+        uxCount++;
+    }
+
+    return uxCount;
+}
+
+/* ======================== Test functions ================================= */
+
+/* Until the first RTT sample, a segment is retransmitted after 1 second. */
+void test_initial_rto( void )
+{
+    int32_t lPosition;
+
+    prvCreateWindow();
+    prvAddSegments( 1u );
+    TEST_ASSERT_EQUAL( 1u, prvSendSegments() );
+    TEST_ASSERT_EQUAL( 1000, xWindow.lRTO );
+
+    xTickCount = pdMS_TO_TICKS( 1000u );
+    TEST_ASSERT_EQUAL_UINT32( 0UL, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+
+    xTickCount = pdMS_TO_TICKS( 1001u );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+}
+
+/* The first sample sets SRTT = R and RTTVAR = R / 2, RTO = SRTT + 4 * RTTVAR. */
+void test_first_rtt_sample( void )
+{
+    prvCreateWindow();
+    prvAddSegments( 1u );
+    TEST_ASSERT_EQUAL( 1u, prvSendSegments() );
+
+    xTickCount = pdMS_TO_TICKS( 100u );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 1 ) ) );
+
+    TEST_ASSERT_EQUAL( pdTRUE_UNSIGNED, xWindow.u.bits.bRTTMeasured );
+    TEST_ASSERT_EQUAL( 100, xWindow.lSRTT );
+    TEST_ASSERT_EQUAL( 50, xWindow.lRTTVar );
+    TEST_ASSERT_EQUAL( 300, xWindow.lRTO );
+}
+
+/* Later samples update RTTVAR with 1/4 and SRTT with 1/8 of the difference. */
+void test_next_rtt_sample( void )
+{
+    prvCreateWindow();
+    prvAddSegments( 1u );
+    TEST_ASSERT_EQUAL( 1u, prvSendSegments() );
+
+    xTickCount = pdMS_TO_TICKS( 100u );
+    ( void ) ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 1 ) );
+    prvAddSegments( 1u );
+    TEST_ASSERT_EQUAL( 1u, prvSendSegments() );
+
+    xTickCount = pdMS_TO_TICKS( 300u );
+    ( void ) ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 2 ) );
+
+    /* RTTVAR = ( 3 * 50 + | 100 - 200 | ) / 4, SRTT = ( 7 * 100 + 200 ) / 8 */
+    TEST_ASSERT_EQUAL( 63, xWindow.lRTTVar );
+    TEST_ASSERT_EQUAL( 113, xWindow.lSRTT );
+    TEST_ASSERT_EQUAL( 113 + ( 4 * 63 ), xWindow.lRTO );
+}
+
+/* The RTO is kept between ipconfigTCP_RTO_MIN_MS and ipconfigTCP_RTO_MAX_MS. */
+void test_rto_limits( void )
+{
+    prvCreateWindow();
+    prvAddSegments( 1u );
+    TEST_ASSERT_EQUAL( 1u, prvSendSegments() );
+
+    xTickCount = pdMS_TO_TICKS( 10u );
+    ( void ) ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 1 ) );
+    TEST_ASSERT_EQUAL( 10, xWindow.lSRTT );
+    TEST_ASSERT_EQUAL( ipconfigTCP_RTO_MIN_MS, xWindow.lRTO );
+
+    vTCPWindowRTTSample( &xWindow, 10u * ipconfigTCP_RTO_MAX_MS );
+    TEST_ASSERT_EQUAL( ipconfigTCP_RTO_MAX_MS, xWindow.lRTO );
+}
+
+/* Karn's algorithm: a segment that was retransmitted gives no sample. */
+void test_no_sample_from_retransmission( void )
+{
+    int32_t lPosition;
+
+    prvCreateWindow();
+    prvAddSegments( 1u );
+    TEST_ASSERT_EQUAL( 1u, prvSendSegments() );
+
+    xTickCount = pdMS_TO_TICKS( 1001u );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+
+    xTickCount = pdMS_TO_TICKS( 1050u );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 1 ) ) );
+
+    TEST_ASSERT_EQUAL( pdFALSE_UNSIGNED, xWindow.u.bits.bRTTMeasured );
+    TEST_ASSERT_EQUAL( 1000, xWindow.lRTO );
+}
+
+/* Only the last segment of an ACK'd range gives a sample: the ACK for the
+ * earlier ones may have been delayed. */
+void test_sample_from_last_segment_only( void )
+{
+    prvCreateWindow();
+    prvAddSegments( 1u );
+    TEST_ASSERT_EQUAL( 1u, prvSendSegments() );
+
+    xTickCount = pdMS_TO_TICKS( 80u );
+    prvAddSegments( 1u );
+    TEST_ASSERT_EQUAL( 1u, prvSendSegments() );
+
+    xTickCount = pdMS_TO_TICKS( 100u );
+    ( void ) ulTCPWindowTxAck( &xWindow, SEGMENT_SEQUENCE( 2 ) );
+
+    TEST_ASSERT_EQUAL( 20, xWindow.lSRTT );
+}
+
+/* The time-out doubles with every retransmission of a segment. */
+void test_rto_backoff( void )
+{
+    int32_t lPosition;
+
+    prvCreateWindow();
+    prvAddSegments( 1u );
+    TEST_ASSERT_EQUAL( 1u, prvSendSegments() );
+
+    xTickCount = pdMS_TO_TICKS( 1001u );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+
+    xTickCount += pdMS_TO_TICKS( 2000u );
+    TEST_ASSERT_EQUAL_UINT32( 0UL, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+
+    xTickCount += pdMS_TO_TICKS( 1u );
+    TEST_ASSERT_EQUAL_UINT32( TEST_MSS, ulTCPWindowTxGet( &xWindow, 0xFFFFFFFFUL, &lPosition ) );
+    TEST_ASSERT_EQUAL_UINT32( 2UL, xWindow.ulRetransmitCount );
+}
@@ -0,0 +1,309 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_TCP_WIN.h"
+
+/* The MSS used by the connections. */
+#define TEST_MSS                 1460u
+
+/* The self-imposed transmission window, it does not limit these tests. */
+#define TX_WINDOW_LENGTH         ( 32u * TEST_MSS )
+
+/* Our sequence number before the first byte of TX data. */
+#define OUR_SEQUENCE_NUMBER      1000UL
+
+/* The sequence number of the n-th segment of size TEST_MSS. */
+#define SEGMENT_SEQUENCE( n )    ( OUR_SEQUENCE_NUMBER + ( ( uint32_t ) ( n ) * TEST_MSS ) )
+
+/* The length of the circular TX stream, only used to calculate positions. */
+#define TX_STREAM_LENGTH         65536
+
+/* The number of windows used by the tests. */
+#define WINDOW_COUNT             2
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* The windows under test. */
+static TCPWindow_t xWindows[ WINDOW_COUNT ];
+
+/* The number of successful allocations. */
+static size_t uxMallocCount;
+
+/* When true, pvPortMalloc() fails. */
+static BaseType_t xMallocFails;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    if( xMallocFails != pdFALSE )
+    {
+        return NULL;
+    }
+
+    uxMallocCount++;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    size_t x;
+
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_IgnoreAndReturn( 0 );
+
+    uxMallocCount = 0u;
+    xMallocFails = pdFALSE;
+
+    /* The first window creates a new pool. */
+    for( x = 0; x < WINDOW_COUNT; x++ )
+    {
+        memset( &( xWindows[ x ] ), 0, sizeof( xWindows[ x ] ) );
+        vTCPWindowCreate( &( xWindows[ x ] ), TX_WINDOW_LENGTH, TX_WINDOW_LENGTH, 5000UL, OUR_SEQUENCE_NUMBER, TEST_MSS );
+    }
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    TCPSegmentStats_t xStats;
+    size_t x;
+
+    for( x = 0; x < WINDOW_COUNT; x++ )
+    {
+        vTCPWindowDestroy( &( xWindows[ x ] ) );
+    }
+
+    /* All segments and all borrowed segments have been returned. */
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( xStats.uxTotal, xStats.uxFree );
+    TEST_ASSERT_EQUAL( 0u, xStats.uxOverflowInUse );
+
+    vTCPSegmentCleanup();
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Try to add 'uxCount' full-size segments to a window, return the number of
+ * segments that were added. */
+static size_t prvAddSegments( TCPWindow_t * pxWindow,
+                              size_t uxCount )
+{
+    int32_t lLength = ( int32_t ) ( uxCount * TEST_MSS );
+    int32_t lPosition = ( int32_t ) ( ( pxWindow->ulNextTxSequenceNumber - OUR_SEQUENCE_NUMBER ) % TX_STREAM_LENGTH );
+
+    return ( size_t ) lTCPWindowTxAdd( pxWindow, ( uint32_t ) lLength, lPosition, TX_STREAM_LENGTH ) / TEST_MSS;
+}
+
+/* Send all segments of a window and let the peer ACK the first 'uxCount'. */
+static void prvAckSegments( TCPWindow_t * pxWindow,
+                            size_t uxCount )
+{
+    int32_t lPosition;
+
+    while( ulTCPWindowTxGet( pxWindow, 0xFFFFFFFFUL, &lPosition ) != 0UL )
+    {
+    }
+
+    TEST_ASSERT_EQUAL_UINT32( uxCount * TEST_MSS, ulTCPWindowTxAck( pxWindow, SEGMENT_SEQUENCE( uxCount ) ) );
+}
+
+/* ======================== Test functions ================================= */
+
+/* The pool is created with one chunk and grows a chunk at a time. */
+void test_pool_grows_in_chunks( void )
+{
+    TCPSegmentStats_t xStats;
+
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( 4u, xStats.uxTotal );
+    TEST_ASSERT_EQUAL( 4u, xStats.uxFree );
+    TEST_ASSERT_EQUAL( 1u, uxMallocCount );
+
+    TEST_ASSERT_EQUAL( 5u, prvAddSegments( &( xWindows[ 0 ] ), 5u ) );
+
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( 8u, xStats.uxTotal );
+    TEST_ASSERT_EQUAL( 3u, xStats.uxFree );
+    TEST_ASSERT_EQUAL( 5u, xStats.uxMaximumInUse );
+    TEST_ASSERT_EQUAL( 2u, uxMallocCount );
+    TEST_ASSERT_EQUAL( 5u, xWindows[ 0 ].uxSegmentHighWater );
+}
+
+/* The pool never holds more than ipconfigTCP_WIN_SEG_COUNT descriptors. */
+void test_pool_exhausted( void )
+{
+    TCPSegmentStats_t xStats;
+
+    TEST_ASSERT_EQUAL( 10u, prvAddSegments( &( xWindows[ 0 ] ), 10u ) );
+    TEST_ASSERT_EQUAL( 6u, prvAddSegments( &( xWindows[ 1 ] ), 10u ) );
+
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( ipconfigTCP_WIN_SEG_COUNT, xStats.uxTotal );
+    TEST_ASSERT_EQUAL( 0u, xStats.uxFree );
+    TEST_ASSERT_EQUAL( ipconfigTCP_WIN_SEG_COUNT, xStats.uxMaximumInUse );
+    TEST_ASSERT_EQUAL_UINT32( 1UL, xStats.ulPoolExhausted );
+    TEST_ASSERT_EQUAL( 4u, uxMallocCount );
+
+    /* Once segments are ACK'd, they can be used by another window. */
+    prvAckSegments( &( xWindows[ 0 ] ), 3u );
+    TEST_ASSERT_EQUAL( 3u, prvAddSegments( &( xWindows[ 1 ] ), 3u ) );
+    TEST_ASSERT_EQUAL( 4u, uxMallocCount );
+}
+
+/* A failing allocation is counted as an exhausted pool. */
+void test_pool_allocation_fails( void )
+{
+    TCPSegmentStats_t xStats;
+
+    xMallocFails = pdTRUE;
+    TEST_ASSERT_EQUAL( 4u, prvAddSegments( &( xWindows[ 0 ] ), 6u ) );
+
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( 4u, xStats.uxTotal );
+    TEST_ASSERT_EQUAL_UINT32( 1UL, xStats.ulPoolExhausted );
+
+    /* The pool grows as soon as memory is available again. */
+    xMallocFails = pdFALSE;
+    TEST_ASSERT_EQUAL( 2u, prvAddSegments( &( xWindows[ 0 ] ), 2u ) );
+}
+
+/* A window that reaches its quota borrows from the overflow pool, until it
+ * is used up. */
+void test_quota_borrows_from_overflow( void )
+{
+    TCPSegmentStats_t xStats;
+
+    xWindows[ 0 ].uxSegmentQuota = 2u;
+    xWindows[ 1 ].uxSegmentQuota = 2u;
+
+    /* Window 0 takes its quota and the whole overflow pool. */
+    TEST_ASSERT_EQUAL( 6u, prvAddSegments( &( xWindows[ 0 ] ), 8u ) );
+
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( ipconfigTCP_WIN_SEG_OVERFLOW, xStats.uxOverflowInUse );
+    TEST_ASSERT_EQUAL( ipconfigTCP_WIN_SEG_OVERFLOW, xStats.uxOverflowHighWater );
+    TEST_ASSERT_EQUAL_UINT32( 1UL, xStats.ulQuotaRefused );
+    TEST_ASSERT_EQUAL_UINT32( 0UL, xStats.ulPoolExhausted );
+    TEST_ASSERT_EQUAL( 6u, xWindows[ 0 ].uxSegmentHighWater );
+
+    /* Window 1 still gets its quota, but can not borrow. */
+    TEST_ASSERT_EQUAL( 2u, prvAddSegments( &( xWindows[ 1 ] ), 3u ) );
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL_UINT32( 2UL, xStats.ulQuotaRefused );
+
+    /* When window 0 returns a borrowed segment, window 1 may borrow it. */
+    prvAckSegments( &( xWindows[ 0 ] ), 1u );
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( ipconfigTCP_WIN_SEG_OVERFLOW - 1u, xStats.uxOverflowInUse );
+
+    TEST_ASSERT_EQUAL( 1u, prvAddSegments( &( xWindows[ 1 ] ), 1u ) );
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( ipconfigTCP_WIN_SEG_OVERFLOW, xStats.uxOverflowInUse );
+}
+
+/* Segments within the quota are not counted as borrowed when they are
+ * returned. */
+void test_quota_return_order( void )
+{
+    TCPSegmentStats_t xStats;
+
+    xWindows[ 0 ].uxSegmentQuota = 3u;
+
+    TEST_ASSERT_EQUAL( 5u, prvAddSegments( &( xWindows[ 0 ] ), 5u ) );
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( 2u, xStats.uxOverflowInUse );
+
+    /* Every segment that brings the window back to its quota was borrowed. */
+    prvAckSegments( &( xWindows[ 0 ] ), 2u );
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( 0u, xStats.uxOverflowInUse );
+
+    /* The last ones were not. */
+    TEST_ASSERT_EQUAL_UINT32( 3u * TEST_MSS, ulTCPWindowTxAck( &( xWindows[ 0 ] ), SEGMENT_SEQUENCE( 5 ) ) );
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( 0u, xStats.uxOverflowInUse );
+    TEST_ASSERT_EQUAL( 2u, xStats.uxOverflowHighWater );
+}
+
+/* Segments that are received out of order count towards the quota too. */
+void test_quota_includes_rx_segments( void )
+{
+    TCPSegmentStats_t xStats;
+    TCPWindow_t * pxWindow = &( xWindows[ 0 ] );
+    uint32_t ulSequence = pxWindow->rx.ulCurrentSequenceNumber;
+
+    pxWindow->uxSegmentQuota = 1u;
+    TEST_ASSERT_EQUAL( 1u, prvAddSegments( pxWindow, 1u ) );
+
+    /* The segment after a missing one is stored with a borrowed segment. */
+    TEST_ASSERT_GREATER_THAN( 0, lTCPWindowRxCheck( pxWindow, ulSequence + TEST_MSS, TEST_MSS, TX_WINDOW_LENGTH ) );
+
+    vTCPWindowGetSegmentStats( &xStats );
+    TEST_ASSERT_EQUAL( 1u, xStats.uxOverflowInUse );
+    TEST_ASSERT_EQUAL( 1u, listCURRENT_LIST_LENGTH( &( pxWindow->xRxSegments ) ) );
+}
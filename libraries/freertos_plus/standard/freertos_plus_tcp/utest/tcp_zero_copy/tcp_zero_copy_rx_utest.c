@@ -0,0 +1,583 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+#include "mock_event_groups.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Stream_Buffer.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The number of segments sent by the peer. */
+#define PEER_SEGMENTS            4u
+
+/* The length of rxStream. */
+#define RX_STREAM_LENGTH         16384u
+
+/* The sequence number of the first byte that the peer sends. */
+#define PEER_SEQUENCE_NUMBER     5000UL
+
+/* The addresses of the connection. */
+#define LOCAL_PORT               80u
+#define REMOTE_PORT              49152u
+#define REMOTE_IP                0xC0A80002UL
+
+/* The ACK flag, private to FreeRTOS_TCP_IP.c. */
+#define TCP_FLAG_ACK             0x10u
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined in FreeRTOS_IP.c, which is not part of
+ * this test. */
+uint16_t usPacketIdentifier;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+
+/* The receiving end of the connection. */
+static FreeRTOS_Socket_t xSocket;
+
+/* The data sent by the peer. */
+static uint8_t ucRxData[ PEER_SEGMENTS * ipconfigTCP_MSS ];
+
+/* The number of bytes passed to the OnReceive handler. */
+static uint32_t ulBytesDelivered;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+static BaseType_t prvOnReceive( Socket_t xSocket,
+                                void * pvData,
+                                size_t xLength )
+{
+    ( void ) xSocket;
+
+    TEST_ASSERT_EQUAL_MEMORY( &( ucRxData[ ulBytesDelivered ] ), pvData, xLength );
+    ulBytesDelivered += ( uint32_t ) xLength;
+
+    return 0;
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return pdPASS;
+}
+
+/* The other functions of the stack that are called by the sources under
+ * test.  They are not used while data is received in the state
+ * eESTABLISHED. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+eARPLookupResult_t eARPGetCacheEntry( uint32_t * pulIPAddress,
+                                      MACAddress_t * const pxMACAddress )
+{
+    ( void ) pulIPAddress;
+    ( void ) pxMACAddress;
+
+    return eARPCacheMiss;
+}
+
+void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
+{
+    ( void ) ulIPAddress;
+}
+
+uint16_t usGenerateChecksum( uint32_t ulSum,
+                             const uint8_t * pucNextData,
+                             size_t uxDataLengthBytes )
+{
+    ( void ) ulSum;
+    ( void ) pucNextData;
+    ( void ) uxDataLengthBytes;
+
+    return 0u;
+}
+
+uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer,
+                                     size_t uxBufferLength,
+                                     BaseType_t xOutgoingPacket )
+{
+    ( void ) pucEthernetBuffer;
+    ( void ) uxBufferLength;
+    ( void ) xOutgoingPacket;
+
+    return 0u;
+}
+
+uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+                                             uint16_t usSourcePort,
+                                             uint32_t ulDestinationAddress,
+                                             uint16_t usDestinationPort )
+{
+    ( void ) ulSourceAddress;
+    ( void ) usSourcePort;
+    ( void ) ulDestinationAddress;
+    ( void ) usDestinationPort;
+
+    return 1000UL;
+}
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+    ( void ) eEvent;
+
+    return pdPASS;
+}
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
+                                     TickType_t uxTimeout )
+{
+    ( void ) pxEvent;
+    ( void ) uxTimeout;
+
+    return pdPASS;
+}
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t FreeRTOS_IsNetworkUp( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t xIPIsNetworkTaskReady( void )
+{
+    return pdTRUE;
+}
+
+NetworkBufferDescriptor_t * pxUDPPayloadBuffer_to_NetworkBuffer( void * pvBuffer )
+{
+    ( void ) pvBuffer;
+
+    return NULL;
+}
+
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber )
+{
+    *pulNumber = 0UL;
+
+    return pdPASS;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    size_t x;
+
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    xEventGroupSetBits_IgnoreAndReturn( 0 );
+    xQueueCreateCountingSemaphore_IgnoreAndReturn( ( QueueHandle_t ) &xSocket );
+    xQueueSemaphoreTake_IgnoreAndReturn( pdPASS );
+    xQueueGenericSend_IgnoreAndReturn( pdPASS );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_IgnoreAndReturn( 0 );
+
+    /* Only the first call initialises the buffers. */
+    TEST_ASSERT_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+    vNetworkSocketsInit();
+
+    ulBytesDelivered = 0u;
+
+    for( x = 0; x < sizeof( ucRxData ); x++ )
+    {
+        ucRxData[ x ] = ( uint8_t ) ( x * 7u + ( x >> 8 ) );
+    }
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    while( listCURRENT_LIST_LENGTH( &( xSocket.u.xTCP.xRxBufferList ) ) > 0u )
+    {
+        pxBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( xSocket.u.xTCP.xRxBufferList ) );
+        ( void ) uxListRemove( &( pxBuffer->xBufferListItem ) );
+        vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    }
+
+    if( xSocket.u.xTCP.pxAckMessage != NULL )
+    {
+        vReleaseNetworkBufferAndDescriptor( xSocket.u.xTCP.pxAckMessage );
+        xSocket.u.xTCP.pxAckMessage = NULL;
+    }
+
+    if( xSocket.u.xTCP.rxStream != NULL )
+    {
+        free( xSocket.u.xTCP.rxStream );
+        xSocket.u.xTCP.rxStream = NULL;
+    }
+
+    vTCPWindowDestroy( &( xSocket.u.xTCP.xTCPWindow ) );
+
+    /* Every test returns all network buffers. */
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Bind xSocket, bring it into the state eESTABLISHED, and switch on
+ * zero-copy reception.  When xUseHandler is true, it gets an OnReceive
+ * handler. */
+static void prvCreateConnection( BaseType_t xUseHandler )
+{
+    struct freertos_sockaddr xAddress;
+    BaseType_t xTrue = pdTRUE;
+
+    memset( &xSocket, 0, sizeof( xSocket ) );
+    xSocket.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_TCP;
+    xSocket.xEventGroup = ( EventGroupHandle_t ) &xSocket;
+    vListInitialiseItem( &( xSocket.xBoundSocketListItem ) );
+    listSET_LIST_ITEM_OWNER( &( xSocket.xBoundSocketListItem ), ( void * ) &xSocket );
+    vListInitialise( &( xSocket.u.xTCP.xRxBufferList ) );
+    xAddress.sin_port = FreeRTOS_htons( LOCAL_PORT );
+    TEST_ASSERT_EQUAL( 0, vSocketBind( &xSocket, &xAddress, sizeof( xAddress ), pdTRUE ) );
+
+    xSocket.u.xTCP.usRemotePort = REMOTE_PORT;
+    xSocket.u.xTCP.ulRemoteIP = REMOTE_IP;
+    xSocket.u.xTCP.ucTCPState = ( uint8_t ) eESTABLISHED;
+    xSocket.u.xTCP.usInitMSS = ipconfigTCP_MSS;
+    xSocket.u.xTCP.usCurMSS = ipconfigTCP_MSS;
+    xSocket.u.xTCP.uxRxWinSize = 8u;
+    xSocket.u.xTCP.uxTxWinSize = 8u;
+    xSocket.u.xTCP.uxRxStreamSize = RX_STREAM_LENGTH;
+    xSocket.u.xTCP.uxLittleSpace = ipconfigTCP_MSS;
+    xSocket.u.xTCP.uxEnoughSpace = 4u * ipconfigTCP_MSS;
+    xSocket.u.xTCP.ulHighestRxAllowed = PEER_SEQUENCE_NUMBER + RX_STREAM_LENGTH;
+    xSocket.u.xTCP.xTCPWindow.ulOurSequenceNumber = 1000UL;
+    xSocket.u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = PEER_SEQUENCE_NUMBER;
+    TEST_FreeRTOS_TCP_prvTCPCreateWindow( &xSocket );
+
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_setsockopt( &xSocket, 0, FREERTOS_SO_TCP_ZERO_COPY_RX, &xTrue, sizeof( xTrue ) ) );
+
+    if( xUseHandler != pdFALSE )
+    {
+        xSocket.u.xTCP.pxHandleReceive = prvOnReceive;
+    }
+}
+
+/* Let TCP handle the data segment number uxIndex from the peer.  Returns the
+ * network buffer, so the test can see whether it was kept by the socket. */
+static NetworkBufferDescriptor_t * prvReceiveSegment( size_t uxIndex )
+{
+    const size_t uxHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER;
+    NetworkBufferDescriptor_t * pxBuffer;
+    TCPPacket_t * pxPacket;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( uxHeaderLength + ipconfigTCP_MSS, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    memset( pxBuffer->pucEthernetBuffer, 0, uxHeaderLength );
+
+    pxPacket = ( TCPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxPacket->xIPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER + ipconfigTCP_MSS );
+    pxPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( REMOTE_IP );
+    pxPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( REMOTE_PORT );
+    pxPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( LOCAL_PORT );
+    pxPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( PEER_SEQUENCE_NUMBER + uxIndex * ipconfigTCP_MSS );
+    pxPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( 1000UL );
+    pxPacket->xTCPHeader.ucTCPOffset = 0x50u;
+    pxPacket->xTCPHeader.ucTCPFlags = TCP_FLAG_ACK;
+    pxPacket->xTCPHeader.usWindow = FreeRTOS_htons( 0x8000u );
+    memcpy( pxBuffer->pucEthernetBuffer + uxHeaderLength, &( ucRxData[ uxIndex * ipconfigTCP_MSS ] ), ipconfigTCP_MSS );
+    pxBuffer->xDataLength = uxHeaderLength + ipconfigTCP_MSS;
+
+    if( xProcessReceivedTCPPacket( pxBuffer ) != pdPASS )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    }
+
+    return pxBuffer;
+}
+
+/* Returns true when pxBuffer is queued in the socket's xRxBufferList. */
+static BaseType_t prvIsQueued( const NetworkBufferDescriptor_t * pxBuffer )
+{
+    return( listIS_CONTAINED_WITHIN( &( xSocket.u.xTCP.xRxBufferList ), &( pxBuffer->xBufferListItem ) ) );
+}
+
+/* The number of bytes that were not received without copying. */
+static uint32_t prvCopiedBytes( void )
+{
+    SocketCounters_t xCounters;
+
+    TEST_ASSERT_EQUAL( pdPASS, FreeRTOS_GetSocketCounters( &xSocket, &xCounters ) );
+
+    return xCounters.ulRxCopiedBytes;
+}
+
+/* ======================== Test functions ================================= */
+
+/* Even the first segment of a connection is kept in its network buffer,
+ * and the zero-copy pointer points into that buffer. */
+void test_first_segment_queued( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+    uint8_t * pucData = NULL;
+    BaseType_t xCount;
+
+    prvCreateConnection( pdFALSE );
+
+    pxBuffer = prvReceiveSegment( 0u );
+
+    TEST_ASSERT_NOT_NULL( xSocket.u.xTCP.rxStream );
+    TEST_ASSERT_TRUE( prvIsQueued( pxBuffer ) );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, xSocket.u.xTCP.uxRxQueuedBytes );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, FreeRTOS_rx_size( &xSocket ) );
+    TEST_ASSERT_EQUAL( 0, prvCopiedBytes() );
+
+    xCount = FreeRTOS_recv( &xSocket, &pucData, 0u, FREERTOS_ZERO_COPY | FREERTOS_MSG_DONTWAIT );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, xCount );
+    TEST_ASSERT_EQUAL_PTR( pxBuffer->pucEthernetBuffer + pxBuffer->usPayloadOffset, pucData );
+    TEST_ASSERT_EQUAL_MEMORY( ucRxData, pucData, ipconfigTCP_MSS );
+
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, FreeRTOS_ReleaseTCPPayloadBuffer( &xSocket, pucData, xCount ) );
+    TEST_ASSERT_EQUAL( 0, listCURRENT_LIST_LENGTH( &( xSocket.u.xTCP.xRxBufferList ) ) );
+    TEST_ASSERT_EQUAL( 0, xSocket.u.xTCP.uxRxQueuedBytes );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_rx_size( &xSocket ) );
+}
+
+/* A copying FreeRTOS_recv() reads across the queued buffers, and a
+ * partially read buffer keeps its unread bytes. */
+void test_recv_copies_from_buffers( void )
+{
+    uint8_t ucBuffer[ 2u * ipconfigTCP_MSS ];
+    const size_t uxFirst = ipconfigTCP_MSS + ipconfigTCP_MSS / 2u;
+
+    prvCreateConnection( pdFALSE );
+
+    ( void ) prvReceiveSegment( 0u );
+    ( void ) prvReceiveSegment( 1u );
+    TEST_ASSERT_EQUAL( 2, listCURRENT_LIST_LENGTH( &( xSocket.u.xTCP.xRxBufferList ) ) );
+
+    TEST_ASSERT_EQUAL( uxFirst, FreeRTOS_recv( &xSocket, ucBuffer, uxFirst, FREERTOS_MSG_DONTWAIT ) );
+    TEST_ASSERT_EQUAL_MEMORY( ucRxData, ucBuffer, uxFirst );
+    TEST_ASSERT_EQUAL( 1, listCURRENT_LIST_LENGTH( &( xSocket.u.xTCP.xRxBufferList ) ) );
+
+    TEST_ASSERT_EQUAL( 2u * ipconfigTCP_MSS - uxFirst, FreeRTOS_recv( &xSocket, ucBuffer, sizeof( ucBuffer ), FREERTOS_MSG_DONTWAIT ) );
+    TEST_ASSERT_EQUAL_MEMORY( &( ucRxData[ uxFirst ] ), ucBuffer, 2u * ipconfigTCP_MSS - uxFirst );
+    TEST_ASSERT_EQUAL( 0, listCURRENT_LIST_LENGTH( &( xSocket.u.xTCP.xRxBufferList ) ) );
+    TEST_ASSERT_EQUAL( 0, prvCopiedBytes() );
+}
+
+/* Data may be released in smaller chunks than it was handed out. */
+void test_partial_release( void )
+{
+    uint8_t * pucData = NULL;
+    uint8_t * pucNext = NULL;
+    const BaseType_t xHalf = ipconfigTCP_MSS / 2;
+
+    prvCreateConnection( pdFALSE );
+
+    ( void ) prvReceiveSegment( 0u );
+
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, FreeRTOS_recv( &xSocket, &pucData, 0u, FREERTOS_ZERO_COPY | FREERTOS_MSG_DONTWAIT ) );
+    TEST_ASSERT_EQUAL( xHalf, FreeRTOS_ReleaseTCPPayloadBuffer( &xSocket, pucData, xHalf ) );
+
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS - xHalf, FreeRTOS_recv( &xSocket, &pucNext, 0u, FREERTOS_ZERO_COPY | FREERTOS_MSG_DONTWAIT ) );
+    TEST_ASSERT_EQUAL_PTR( pucData + xHalf, pucNext );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS - xHalf, FreeRTOS_ReleaseTCPPayloadBuffer( &xSocket, pucNext, ipconfigTCP_MSS - xHalf ) );
+    TEST_ASSERT_EQUAL( 0, listCURRENT_LIST_LENGTH( &( xSocket.u.xTCP.xRxBufferList ) ) );
+}
+
+/* A wrong pointer, or releasing more than was handed out, is refused and
+ * does not consume any data. */
+void test_release_refused( void )
+{
+    uint8_t * pucData = NULL;
+
+    prvCreateConnection( pdFALSE );
+
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EINVAL, FreeRTOS_ReleaseTCPPayloadBuffer( &xSocket, ucRxData, 1 ) );
+
+    ( void ) prvReceiveSegment( 0u );
+    ( void ) prvReceiveSegment( 1u );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, FreeRTOS_recv( &xSocket, &pucData, 0u, FREERTOS_ZERO_COPY | FREERTOS_MSG_DONTWAIT ) );
+
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EINVAL, FreeRTOS_ReleaseTCPPayloadBuffer( &xSocket, pucData + 1, 1 ) );
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EINVAL, FreeRTOS_ReleaseTCPPayloadBuffer( &xSocket, pucData, ipconfigTCP_MSS + 1 ) );
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_EINVAL, FreeRTOS_ReleaseTCPPayloadBuffer( &xSocket, pucData, 0 ) );
+    TEST_ASSERT_EQUAL( 2u * ipconfigTCP_MSS, FreeRTOS_rx_size( &xSocket ) );
+}
+
+/* When the socket holds the maximum number of buffers, data is copied to
+ * rxStream and counted.  Reading returns all data in order. */
+void test_copy_when_list_full( void )
+{
+    uint8_t ucBuffer[ PEER_SEGMENTS * ipconfigTCP_MSS ];
+    NetworkBufferDescriptor_t * pxBuffers[ PEER_SEGMENTS ];
+    size_t x;
+
+    prvCreateConnection( pdFALSE );
+
+    for( x = 0; x < PEER_SEGMENTS; x++ )
+    {
+        pxBuffers[ x ] = prvReceiveSegment( x );
+        TEST_ASSERT_EQUAL( x < ipconfigTCP_ZERO_COPY_RX_MAX_BUFFERS, prvIsQueued( pxBuffers[ x ] ) );
+    }
+
+    TEST_ASSERT_EQUAL( ( PEER_SEGMENTS - ipconfigTCP_ZERO_COPY_RX_MAX_BUFFERS ) * ipconfigTCP_MSS, prvCopiedBytes() );
+
+    TEST_ASSERT_EQUAL( sizeof( ucBuffer ), FreeRTOS_recv( &xSocket, ucBuffer, sizeof( ucBuffer ), FREERTOS_MSG_DONTWAIT ) );
+    TEST_ASSERT_EQUAL_MEMORY( ucRxData, ucBuffer, sizeof( ucBuffer ) );
+}
+
+/* As long as rxStream holds copied data, new data is copied as well, so it
+ * stays behind the copied data. */
+void test_copy_behind_copied_data( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+    uint8_t ucBuffer[ ipconfigTCP_MSS ];
+    size_t x;
+
+    prvCreateConnection( pdFALSE );
+
+    for( x = 0; x <= ipconfigTCP_ZERO_COPY_RX_MAX_BUFFERS; x++ )
+    {
+        ( void ) prvReceiveSegment( x );
+    }
+
+    /* Reading one buffer makes room in the list, but the copied data is
+     * still waiting in rxStream. */
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, FreeRTOS_recv( &xSocket, ucBuffer, sizeof( ucBuffer ), FREERTOS_MSG_DONTWAIT ) );
+    pxBuffer = prvReceiveSegment( x );
+
+    TEST_ASSERT_FALSE( prvIsQueued( pxBuffer ) );
+    TEST_ASSERT_EQUAL( 2u * ipconfigTCP_MSS, prvCopiedBytes() );
+}
+
+/* Out-of-order data is copied, the segment that fills the gap is queued.
+ * The data is read in the right order. */
+void test_out_of_order_copied( void )
+{
+    uint8_t ucBuffer[ 2u * ipconfigTCP_MSS ];
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    prvCreateConnection( pdFALSE );
+
+    pxBuffer = prvReceiveSegment( 1u );
+    TEST_ASSERT_FALSE( prvIsQueued( pxBuffer ) );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_rx_size( &xSocket ) );
+
+    pxBuffer = prvReceiveSegment( 0u );
+    TEST_ASSERT_TRUE( prvIsQueued( pxBuffer ) );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, prvCopiedBytes() );
+
+    TEST_ASSERT_EQUAL( sizeof( ucBuffer ), FreeRTOS_recv( &xSocket, ucBuffer, sizeof( ucBuffer ), FREERTOS_MSG_DONTWAIT ) );
+    TEST_ASSERT_EQUAL_MEMORY( ucRxData, ucBuffer, sizeof( ucBuffer ) );
+}
+
+/* A socket with an OnReceive handler passes the data straight from the
+ * network buffer to the handler, nothing is queued or copied. */
+void test_handler_not_queued( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    prvCreateConnection( pdTRUE );
+
+    pxBuffer = prvReceiveSegment( 0u );
+
+    TEST_ASSERT_FALSE( prvIsQueued( pxBuffer ) );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, ulBytesDelivered );
+    TEST_ASSERT_EQUAL( 0, prvCopiedBytes() );
+}
+
+/* When zero-copy reception is switched off, the data is copied but not
+ * counted. */
+void test_option_off_not_counted( void )
+{
+    BaseType_t xFalse = pdFALSE;
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    prvCreateConnection( pdFALSE );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_setsockopt( &xSocket, 0, FREERTOS_SO_TCP_ZERO_COPY_RX, &xFalse, sizeof( xFalse ) ) );
+
+    pxBuffer = prvReceiveSegment( 0u );
+
+    TEST_ASSERT_FALSE( prvIsQueued( pxBuffer ) );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, FreeRTOS_rx_size( &xSocket ) );
+    TEST_ASSERT_EQUAL( 0, prvCopiedBytes() );
+}
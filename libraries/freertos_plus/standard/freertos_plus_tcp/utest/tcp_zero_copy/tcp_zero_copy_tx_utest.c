@@ -0,0 +1,472 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+#include "mock_event_groups.h"
+#include "mock_portable.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Stream_Buffer.h"
+#include "NetworkBufferManagement.h"
+
+#include "iot_freertos_tcp_test_access_declare.h"
+
+/* The length of txStream. */
+#define TX_STREAM_LENGTH         ( 4u * ipconfigTCP_MSS )
+
+/* The sequence number of the first byte that the peer sends. */
+#define PEER_SEQUENCE_NUMBER     5000UL
+
+/* Our sequence number before the first byte of TX data. */
+#define OUR_SEQUENCE_NUMBER      1000UL
+
+/* The addresses of the connection. */
+#define LOCAL_PORT               80u
+#define REMOTE_PORT              49152u
+#define REMOTE_IP                0xC0A80002UL
+
+/* The ACK flag, private to FreeRTOS_TCP_IP.c. */
+#define TCP_FLAG_ACK             0x10u
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* Globals that are normally defined in FreeRTOS_IP.c, which is not part of
+ * this test. */
+uint16_t usPacketIdentifier;
+UDPPacketHeader_t xDefaultPartUDPPacketHeader;
+NetworkAddressingParameters_t xNetworkAddressing;
+
+/* The sending end of the connection. */
+static FreeRTOS_Socket_t xSocket;
+
+/* The memory of the application, passed by reference or by value. */
+static uint8_t ucUserData[ TX_STREAM_LENGTH ];
+
+/* The payload bytes that the driver received, at their position in the
+ * stream. */
+static uint8_t ucSent[ TX_STREAM_LENGTH ];
+static uint32_t ulBytesSent;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+static void * prvMalloc( size_t xSize,
+                         int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    return malloc( xSize );
+}
+
+static void prvFree( void * pv,
+                     int cmock_num_calls )
+{
+    ( void ) cmock_num_calls;
+
+    free( pv );
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    const TCPPacket_t * pxTCPPacket = ( const TCPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+    size_t uxHeaderLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER +
+                            ( ( pxTCPPacket->xTCPHeader.ucTCPOffset >> 4 ) * 4u );
+    size_t uxPayload = pxNetworkBuffer->xDataLength - uxHeaderLength;
+    uint32_t ulOffset = FreeRTOS_ntohl( pxTCPPacket->xTCPHeader.ulSequenceNumber ) - OUR_SEQUENCE_NUMBER;
+
+    if( uxPayload != 0u )
+    {
+        TEST_ASSERT_TRUE( ulOffset + uxPayload <= sizeof( ucSent ) );
+        memcpy( &( ucSent[ ulOffset ] ), pxNetworkBuffer->pucEthernetBuffer + uxHeaderLength, uxPayload );
+        ulBytesSent += ( uint32_t ) uxPayload;
+    }
+
+    if( xReleaseAfterSend != pdFALSE )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+    }
+
+    return pdPASS;
+}
+
+/* The other functions of the stack that are called by the sources under
+ * test.  They are not used while data is sent in the state eESTABLISHED. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+eARPLookupResult_t eARPGetCacheEntry( uint32_t * pulIPAddress,
+                                      MACAddress_t * const pxMACAddress )
+{
+    ( void ) pulIPAddress;
+    ( void ) pxMACAddress;
+
+    return eARPCacheMiss;
+}
+
+void FreeRTOS_OutputARPRequest( uint32_t ulIPAddress )
+{
+    ( void ) ulIPAddress;
+}
+
+uint16_t usGenerateChecksum( uint32_t ulSum,
+                             const uint8_t * pucNextData,
+                             size_t uxDataLengthBytes )
+{
+    ( void ) ulSum;
+    ( void ) pucNextData;
+    ( void ) uxDataLengthBytes;
+
+    return 0u;
+}
+
+uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer,
+                                     size_t uxBufferLength,
+                                     BaseType_t xOutgoingPacket )
+{
+    ( void ) pucEthernetBuffer;
+    ( void ) uxBufferLength;
+    ( void ) xOutgoingPacket;
+
+    return 0u;
+}
+
+uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
+                                             uint16_t usSourcePort,
+                                             uint32_t ulDestinationAddress,
+                                             uint16_t usDestinationPort )
+{
+    ( void ) ulSourceAddress;
+    ( void ) usSourcePort;
+    ( void ) ulDestinationAddress;
+    ( void ) usDestinationPort;
+
+    return 1000UL;
+}
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+    ( void ) eEvent;
+
+    return pdPASS;
+}
+
+BaseType_t xSendEventStructToIPTask( const IPStackEvent_t * pxEvent,
+                                     TickType_t uxTimeout )
+{
+    ( void ) pxEvent;
+    ( void ) uxTimeout;
+
+    return pdPASS;
+}
+
+BaseType_t xIsCallingFromIPTask( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t FreeRTOS_IsNetworkUp( void )
+{
+    return pdTRUE;
+}
+
+BaseType_t xIPIsNetworkTaskReady( void )
+{
+    return pdTRUE;
+}
+
+NetworkBufferDescriptor_t * pxUDPPayloadBuffer_to_NetworkBuffer( void * pvBuffer )
+{
+    ( void ) pvBuffer;
+
+    return NULL;
+}
+
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber )
+{
+    *pulNumber = 0UL;
+
+    return pdPASS;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    size_t x;
+
+    pvPortMalloc_Stub( prvMalloc );
+    vPortFree_Stub( prvFree );
+    xEventGroupSetBits_IgnoreAndReturn( 0 );
+    xQueueCreateCountingSemaphore_IgnoreAndReturn( ( QueueHandle_t ) &xSocket );
+    xQueueSemaphoreTake_IgnoreAndReturn( pdPASS );
+    xQueueGenericSend_IgnoreAndReturn( pdPASS );
+    vTaskSuspendAll_Ignore();
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    xTaskGetTickCount_IgnoreAndReturn( 0 );
+
+    /* Only the first call initialises the buffers. */
+    TEST_ASSERT_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+    vNetworkSocketsInit();
+
+    memset( ucSent, 0, sizeof( ucSent ) );
+    ulBytesSent = 0u;
+
+    for( x = 0; x < sizeof( ucUserData ); x++ )
+    {
+        ucUserData[ x ] = ( uint8_t ) ( x * 11u + ( x >> 8 ) );
+    }
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    if( xSocket.u.xTCP.pxAckMessage != NULL )
+    {
+        vReleaseNetworkBufferAndDescriptor( xSocket.u.xTCP.pxAckMessage );
+        xSocket.u.xTCP.pxAckMessage = NULL;
+    }
+
+    if( xSocket.u.xTCP.txStream != NULL )
+    {
+        free( xSocket.u.xTCP.txStream );
+        xSocket.u.xTCP.txStream = NULL;
+    }
+
+    vTCPWindowDestroy( &( xSocket.u.xTCP.xTCPWindow ) );
+
+    /* Every test returns all network buffers. */
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Bind xSocket and bring it into the state eESTABLISHED. */
+static void prvCreateConnection( void )
+{
+    struct freertos_sockaddr xAddress;
+    TCPPacket_t * pxTemplate;
+
+    memset( &xSocket, 0, sizeof( xSocket ) );
+    xSocket.ucProtocol = ( uint8_t ) FREERTOS_IPPROTO_TCP;
+    xSocket.xEventGroup = ( EventGroupHandle_t ) &xSocket;
+    vListInitialiseItem( &( xSocket.xBoundSocketListItem ) );
+    listSET_LIST_ITEM_OWNER( &( xSocket.xBoundSocketListItem ), ( void * ) &xSocket );
+    xAddress.sin_port = FreeRTOS_htons( LOCAL_PORT );
+    TEST_ASSERT_EQUAL( 0, vSocketBind( &xSocket, &xAddress, sizeof( xAddress ), pdTRUE ) );
+
+    xSocket.u.xTCP.usRemotePort = REMOTE_PORT;
+    xSocket.u.xTCP.ulRemoteIP = REMOTE_IP;
+    xSocket.u.xTCP.ucTCPState = ( uint8_t ) eESTABLISHED;
+    xSocket.u.xTCP.usInitMSS = ipconfigTCP_MSS;
+    xSocket.u.xTCP.usCurMSS = ipconfigTCP_MSS;
+    xSocket.u.xTCP.uxRxWinSize = 8u;
+    xSocket.u.xTCP.uxTxWinSize = 8u;
+    xSocket.u.xTCP.uxRxStreamSize = TX_STREAM_LENGTH;
+    xSocket.u.xTCP.uxTxStreamSize = TX_STREAM_LENGTH;
+    xSocket.u.xTCP.ulWindowSize = 0xFFFFUL;
+    xSocket.u.xTCP.ulHighestRxAllowed = PEER_SEQUENCE_NUMBER + TX_STREAM_LENGTH;
+    xSocket.u.xTCP.xTCPWindow.ulOurSequenceNumber = OUR_SEQUENCE_NUMBER;
+    xSocket.u.xTCP.xTCPWindow.rx.ulCurrentSequenceNumber = PEER_SEQUENCE_NUMBER;
+    TEST_FreeRTOS_TCP_prvTCPCreateWindow( &xSocket );
+
+    /* The header of the last packet received from the peer. */
+    pxTemplate = ( TCPPacket_t * ) xSocket.u.xTCP.xPacket.u.ucLastPacket;
+    pxTemplate->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxTemplate->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxTemplate->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxTemplate->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( REMOTE_IP );
+    pxTemplate->xTCPHeader.usSourcePort = FreeRTOS_htons( REMOTE_PORT );
+    pxTemplate->xTCPHeader.usDestinationPort = FreeRTOS_htons( LOCAL_PORT );
+}
+
+/* Let the IP-task send the data that was passed to FreeRTOS_send(). */
+static void prvSendData( void )
+{
+    ( void ) xTCPSocketCheck( &xSocket );
+}
+
+/* Let TCP handle an ACK from the peer for the first ulCount bytes. */
+static void prvReceiveACK( uint32_t ulCount )
+{
+    const size_t uxLength = ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER;
+    NetworkBufferDescriptor_t * pxBuffer;
+    TCPPacket_t * pxPacket;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( uxLength, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+    memset( pxBuffer->pucEthernetBuffer, 0, uxLength );
+
+    pxPacket = ( TCPPacket_t * ) pxBuffer->pucEthernetBuffer;
+    pxPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
+    pxPacket->xIPHeader.ucVersionHeaderLength = 0x45u;
+    pxPacket->xIPHeader.ucProtocol = ( uint8_t ) ipPROTOCOL_TCP;
+    pxPacket->xIPHeader.usLength = FreeRTOS_htons( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER );
+    pxPacket->xIPHeader.ulSourceIPAddress = FreeRTOS_htonl( REMOTE_IP );
+    pxPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( REMOTE_PORT );
+    pxPacket->xTCPHeader.usDestinationPort = FreeRTOS_htons( LOCAL_PORT );
+    pxPacket->xTCPHeader.ulSequenceNumber = FreeRTOS_htonl( PEER_SEQUENCE_NUMBER );
+    pxPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( OUR_SEQUENCE_NUMBER + ulCount );
+    pxPacket->xTCPHeader.ucTCPOffset = 0x50u;
+    pxPacket->xTCPHeader.ucTCPFlags = TCP_FLAG_ACK;
+    pxPacket->xTCPHeader.usWindow = FreeRTOS_htons( 0x8000u );
+    pxBuffer->xDataLength = uxLength;
+
+    if( xProcessReceivedTCPPacket( pxBuffer ) != pdPASS )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    }
+}
+
+/* ======================== Test functions ================================= */
+
+/* Data passed by reference is read from the application's memory when it is
+ * sent, not when FreeRTOS_send() is called. */
+void test_reference_sent_from_user_memory( void )
+{
+    const size_t uxLength = 2u * ipconfigTCP_MSS;
+
+    prvCreateConnection();
+
+    TEST_ASSERT_EQUAL( uxLength, FreeRTOS_send( &xSocket, ucUserData, uxLength, FREERTOS_ZERO_COPY ) );
+    TEST_ASSERT_EQUAL( uxLength, FreeRTOS_tx_referenced( &xSocket ) );
+    TEST_ASSERT_EQUAL( uxLength, FreeRTOS_tx_size( &xSocket ) );
+
+    /* Not copied: a change made now will be sent. */
+    ucUserData[ 0 ] ^= 0xFFu;
+    ucUserData[ uxLength - 1u ] ^= 0xFFu;
+
+    prvSendData();
+
+    TEST_ASSERT_EQUAL( uxLength, ulBytesSent );
+    TEST_ASSERT_EQUAL_MEMORY( ucUserData, ucSent, uxLength );
+}
+
+/* Data sent by value and by reference goes out in the order in which it was
+ * passed to FreeRTOS_send(), also within a single segment. */
+void test_copied_and_referenced_data_in_order( void )
+{
+    const size_t uxSmall = 100u;
+    uint8_t ucCopied[ 2u * 100u ];
+
+    prvCreateConnection();
+
+    memcpy( ucCopied, ucUserData, uxSmall );
+    memcpy( &( ucCopied[ uxSmall ] ), &( ucUserData[ uxSmall + ipconfigTCP_MSS ] ), uxSmall );
+
+    TEST_ASSERT_EQUAL( uxSmall, FreeRTOS_send( &xSocket, ucCopied, uxSmall, 0 ) );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, FreeRTOS_send( &xSocket, &( ucUserData[ uxSmall ] ), ipconfigTCP_MSS, FREERTOS_ZERO_COPY ) );
+    TEST_ASSERT_EQUAL( uxSmall, FreeRTOS_send( &xSocket, &( ucCopied[ uxSmall ] ), uxSmall, 0 ) );
+    TEST_ASSERT_EQUAL( ipconfigTCP_MSS, FreeRTOS_tx_referenced( &xSocket ) );
+
+    /* The copies are not used any more. */
+    memset( ucCopied, 0, sizeof( ucCopied ) );
+
+    prvSendData();
+
+    TEST_ASSERT_EQUAL( 2u * uxSmall + ipconfigTCP_MSS, ulBytesSent );
+    TEST_ASSERT_EQUAL_MEMORY( ucUserData, ucSent, 2u * uxSmall + ipconfigTCP_MSS );
+}
+
+/* A reference is held until all of its bytes have been acknowledged. */
+void test_reference_released_when_acked( void )
+{
+    const size_t uxLength = 2u * ipconfigTCP_MSS;
+
+    prvCreateConnection();
+
+    TEST_ASSERT_EQUAL( uxLength, FreeRTOS_send( &xSocket, ucUserData, uxLength, FREERTOS_ZERO_COPY ) );
+    prvSendData();
+
+    prvReceiveACK( ipconfigTCP_MSS );
+    TEST_ASSERT_EQUAL( uxLength - ipconfigTCP_MSS, FreeRTOS_tx_referenced( &xSocket ) );
+    TEST_ASSERT_NOT_EQUAL( xSocket.u.xTCP.ucTxRefHead, xSocket.u.xTCP.ucTxRefTail );
+
+    prvReceiveACK( uxLength );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_tx_referenced( &xSocket ) );
+    TEST_ASSERT_EQUAL( xSocket.u.xTCP.ucTxRefHead, xSocket.u.xTCP.ucTxRefTail );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_tx_size( &xSocket ) );
+}
+
+/* When all references are in use, FreeRTOS_send() by reference fails until
+ * one is acknowledged.  Sending by value is still possible. */
+void test_references_exhausted( void )
+{
+    const size_t uxSmall = 100u;
+    size_t x;
+
+    prvCreateConnection();
+
+    for( x = 0; x < ipconfigTCP_ZERO_COPY_TX_REFERENCES; x++ )
+    {
+        TEST_ASSERT_EQUAL( uxSmall, FreeRTOS_send( &xSocket, &( ucUserData[ x * uxSmall ] ), uxSmall, FREERTOS_ZERO_COPY ) );
+    }
+
+    TEST_ASSERT_EQUAL( -pdFREERTOS_ERRNO_ENOSPC, FreeRTOS_send( &xSocket, &( ucUserData[ x * uxSmall ] ), uxSmall, FREERTOS_ZERO_COPY ) );
+    TEST_ASSERT_EQUAL( uxSmall, FreeRTOS_send( &xSocket, &( ucUserData[ x * uxSmall ] ), uxSmall, 0 ) );
+    x++;
+
+    /* The data was sent in a single segment, which is acknowledged as a
+     * whole. */
+    prvSendData();
+    prvReceiveACK( x * uxSmall );
+    TEST_ASSERT_EQUAL( 0, FreeRTOS_tx_referenced( &xSocket ) );
+
+    TEST_ASSERT_EQUAL( uxSmall, FreeRTOS_send( &xSocket, &( ucUserData[ x * uxSmall ] ), uxSmall, FREERTOS_ZERO_COPY ) );
+    x++;
+
+    prvSendData();
+    TEST_ASSERT_EQUAL( uxSmall, FreeRTOS_tx_referenced( &xSocket ) );
+    TEST_ASSERT_EQUAL( x * uxSmall, ulBytesSent );
+    TEST_ASSERT_EQUAL_MEMORY( ucUserData, ucSent, x * uxSmall );
+}
@@ -0,0 +1,328 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "portableDefs.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+
+#include "mock_task.h"
+#include "mock_queue.h"
+#include "mock_event_groups.h"
+
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "FreeRTOS_DHCP.h"
+#include "FreeRTOS_Sockets.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+/* The port of the socket that receives the packets. */
+#define TEST_PORT           5001u
+
+/* The number of payload bytes in a packet that is copied, and in one that
+ * is not. */
+#define SHORT_PAYLOAD       ( ipconfigUDP_RX_COPYBREAK - ipUDP_PAYLOAD_OFFSET_IPv4 )
+#define LONG_PAYLOAD        ( SHORT_PAYLOAD + 1u )
+
+/* ============================  GLOBAL VARIABLES =========================== */
+
+/* The socket that is found by pxUDPSocketLookup(). */
+static FreeRTOS_Socket_t xSocket;
+
+/* ==========================  CALLBACK FUNCTIONS =========================== */
+
+/* Defined in FreeRTOS_IP.c, which is not part of this test. */
+NetworkBufferDescriptor_t * pxDuplicateNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                                                    size_t uxNewLength )
+{
+    NetworkBufferDescriptor_t * pxNewBuffer;
+
+    pxNewBuffer = pxGetNetworkBufferWithDescriptor( uxNewLength, 0 );
+
+    if( pxNewBuffer != NULL )
+    {
+        pxNewBuffer->xDataLength = uxNewLength;
+        pxNewBuffer->ulIPAddress = pxNetworkBuffer->ulIPAddress;
+        pxNewBuffer->usPort = pxNetworkBuffer->usPort;
+        pxNewBuffer->usBoundPort = pxNetworkBuffer->usBoundPort;
+        memcpy( pxNewBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+    }
+
+    return pxNewBuffer;
+}
+
+FreeRTOS_Socket_t * pxUDPSocketLookup( UBaseType_t uxLocalPort )
+{
+    return ( uxLocalPort == FreeRTOS_htons( TEST_PORT ) ) ? &xSocket : NULL;
+}
+
+/* The other functions of the stack that are called by FreeRTOS_UDP_IP.c.
+ * They are not used while a packet is received. */
+void vPortEnterCritical( void )
+{
+}
+
+void vPortExitCritical( void )
+{
+}
+
+void vARPRefreshCacheEntry( const MACAddress_t * pxMACAddress,
+                            const uint32_t ulIPAddress )
+{
+    ( void ) pxMACAddress;
+    ( void ) ulIPAddress;
+}
+
+eARPLookupResult_t eARPGetCacheEntry( uint32_t * pulIPAddress,
+                                      MACAddress_t * const pxMACAddress )
+{
+    ( void ) pulIPAddress;
+    ( void ) pxMACAddress;
+
+    return eCantSendPacket;
+}
+
+void vARPGenerateRequestPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+    ( void ) pxNetworkBuffer;
+}
+
+BaseType_t xIsDHCPSocket( Socket_t xSocket )
+{
+    ( void ) xSocket;
+
+    return pdFALSE;
+}
+
+uint16_t usGenerateChecksum( uint32_t ulSum,
+                             const uint8_t * pucNextData,
+                             size_t uxDataLengthBytes )
+{
+    ( void ) ulSum;
+    ( void ) pucNextData;
+    ( void ) uxDataLengthBytes;
+
+    return 0u;
+}
+
+uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer,
+                                     size_t uxBufferLength,
+                                     BaseType_t xOutgoingPacket )
+{
+    ( void ) pucEthernetBuffer;
+    ( void ) uxBufferLength;
+    ( void ) xOutgoingPacket;
+
+    return 0u;
+}
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                    BaseType_t xReleaseAfterSend )
+{
+    ( void ) pxNetworkBuffer;
+    ( void ) xReleaseAfterSend;
+
+    TEST_FAIL();
+
+    return pdFAIL;
+}
+
+BaseType_t xSendEventToIPTask( eIPEvent_t eEvent )
+{
+    ( void ) eEvent;
+
+    return pdPASS;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+void setUp( void )
+{
+    /* Only the first call initialises the buffers. */
+    TEST_ASSERT_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+
+    xTaskResumeAll_IgnoreAndReturn( pdFALSE );
+    vTaskSuspendAll_Ignore();
+
+    memset( &xSocket, 0, sizeof( xSocket ) );
+    vListInitialise( &( xSocket.u.xUDP.xWaitingPacketsList ) );
+    xSocket.u.xUDP.uxMaxPackets = 2u;
+    xSocket.usLocalPort = TEST_PORT;
+}
+
+/* called after each testcase */
+void tearDown( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    /* Release the packets that were queued, every test returns all
+     * buffers. */
+    while( listCURRENT_LIST_LENGTH( &( xSocket.u.xUDP.xWaitingPacketsList ) ) > 0u )
+    {
+        pxBuffer = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( xSocket.u.xUDP.xWaitingPacketsList ) );
+        ( void ) uxListRemove( &( pxBuffer->xBufferListItem ) );
+        vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    }
+
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* called at the beginning of the whole suite */
+void suiteSetUp()
+{
+}
+
+/* called at the end of the whole suite */
+int suiteTearDown( int numFailures )
+{
+    return( numFailures > 0 );
+}
+
+/* ==========================  Helper functions  ============================ */
+
+/* Create a received UDP packet with uxPayload bytes, in a full-size buffer
+ * as a network interface would pass it. */
+static NetworkBufferDescriptor_t * prvCreatePacket( size_t uxPayload )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+    size_t x;
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( ipTOTAL_ETHERNET_FRAME_SIZE, 0 );
+    TEST_ASSERT_NOT_NULL( pxBuffer );
+
+    pxBuffer->xDataLength = ipUDP_PAYLOAD_OFFSET_IPv4 + uxPayload;
+    pxBuffer->ulIPAddress = FreeRTOS_inet_addr_quick( 192, 168, 1, 20 );
+    pxBuffer->usPort = FreeRTOS_htons( 7u );
+
+    for( x = 0; x < uxPayload; x++ )
+    {
+        pxBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 + x ] = ( uint8_t ) x;
+    }
+
+    return pxBuffer;
+}
+
+/* Return the packet that was queued last in the socket. */
+static NetworkBufferDescriptor_t * prvQueuedPacket( void )
+{
+    const ListItem_t * pxItem;
+
+    TEST_ASSERT_TRUE( listCURRENT_LIST_LENGTH( &( xSocket.u.xUDP.xWaitingPacketsList ) ) > 0u );
+    pxItem = xSocket.u.xUDP.xWaitingPacketsList.xListEnd.pxPrevious;
+
+    return ( NetworkBufferDescriptor_t * ) listGET_LIST_ITEM_OWNER( pxItem );
+}
+
+/* ======================== Test functions ================================= */
+
+/* A short packet is copied to a small buffer, the full-size buffer is
+ * released at once. */
+void test_short_packet_copied( void )
+{
+    NetworkBufferDescriptor_t * pxPacket, * pxQueued;
+    size_t x;
+
+    pxPacket = prvCreatePacket( SHORT_PAYLOAD );
+
+    TEST_ASSERT_EQUAL( pdPASS, xProcessReceivedUDPPacket( pxPacket, FreeRTOS_htons( TEST_PORT ) ) );
+
+    pxQueued = prvQueuedPacket();
+    TEST_ASSERT_TRUE( pxQueued != pxPacket );
+    TEST_ASSERT_EQUAL( ipconfigUDP_RX_COPYBREAK, pxQueued->xDataLength );
+    TEST_ASSERT_EQUAL( FreeRTOS_inet_addr_quick( 192, 168, 1, 20 ), pxQueued->ulIPAddress );
+    TEST_ASSERT_EQUAL( FreeRTOS_htons( 7u ), pxQueued->usPort );
+
+    for( x = 0; x < SHORT_PAYLOAD; x++ )
+    {
+        TEST_ASSERT_EQUAL_UINT8( ( uint8_t ) x, pxQueued->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 + x ] );
+    }
+
+    /* Only the small copy is in use. */
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - 1, uxGetNumberOfFreeNetworkBuffers() );
+    TEST_ASSERT_EQUAL_PTR( pxQueued, pxResizeNetworkBufferWithDescriptor( pxQueued, ipconfigBUFFER_ALLOC_3_SMALL_SIZE ) );
+}
+
+/* A packet longer than the copy-break is queued in its own buffer. */
+void test_long_packet_not_copied( void )
+{
+    NetworkBufferDescriptor_t * pxPacket;
+
+    pxPacket = prvCreatePacket( LONG_PAYLOAD );
+
+    TEST_ASSERT_EQUAL( pdPASS, xProcessReceivedUDPPacket( pxPacket, FreeRTOS_htons( TEST_PORT ) ) );
+
+    TEST_ASSERT_EQUAL_PTR( pxPacket, prvQueuedPacket() );
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - 1, uxGetNumberOfFreeNetworkBuffers() );
+}
+
+/* When there is no buffer for a copy, the original is queued. */
+void test_original_queued_when_no_buffer( void )
+{
+    NetworkBufferDescriptor_t * pxBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+    NetworkBufferDescriptor_t * pxPacket;
+    size_t uxCount = 0, x;
+
+    pxPacket = prvCreatePacket( SHORT_PAYLOAD );
+
+    while( uxGetNumberOfFreeNetworkBuffers() > 0u )
+    {
+        pxBuffers[ uxCount ] = pxGetNetworkBufferWithDescriptor( 60, 0 );
+        TEST_ASSERT_NOT_NULL( pxBuffers[ uxCount ] );
+        uxCount++;
+    }
+
+    TEST_ASSERT_EQUAL( pdPASS, xProcessReceivedUDPPacket( pxPacket, FreeRTOS_htons( TEST_PORT ) ) );
+    TEST_ASSERT_EQUAL_PTR( pxPacket, prvQueuedPacket() );
+
+    for( x = 0; x < uxCount; x++ )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffers[ x ] );
+    }
+}
+
+/* A packet that the socket can not take is not copied, the caller keeps
+ * ownership of the buffer. */
+void test_refused_packet_not_copied( void )
+{
+    NetworkBufferDescriptor_t * pxPacket;
+    UBaseType_t x;
+
+    for( x = 0; x < xSocket.u.xUDP.uxMaxPackets; x++ )
+    {
+        TEST_ASSERT_EQUAL( pdPASS, xProcessReceivedUDPPacket( prvCreatePacket( SHORT_PAYLOAD ), FreeRTOS_htons( TEST_PORT ) ) );
+    }
+
+    pxPacket = prvCreatePacket( SHORT_PAYLOAD );
+    TEST_ASSERT_EQUAL( pdFAIL, xProcessReceivedUDPPacket( pxPacket, FreeRTOS_htons( TEST_PORT ) ) );
+    TEST_ASSERT_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - xSocket.u.xUDP.uxMaxPackets - 1, uxGetNumberOfFreeNetworkBuffers() );
+
+    vReleaseNetworkBufferAndDescriptor( pxPacket );
+}